@@ -43,6 +43,12 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+// Write log_line/log_..._and_alarm entries to files from a background thread
+#define LOG_USE_ASYNC_WRITER 1
 
 static int s_bootCount = -1;
 static long long sStartTimeStamp_ms;
@@ -68,53 +74,6 @@ static int s_logAddTime = 1;
 static char s_szTimeLog[64];
 static char s_szAdditionalLogFile[128];
 
-const u32 crc32_table[] = {
-	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-	0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-	0xf3b97148, 0x84be41de,	0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-	0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,	0x14015c4f, 0x63066cd9,
-	0xfa0f3d63, 0x8d080df5,	0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-	0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,	0x35b5a8fa, 0x42b2986c,
-	0xdbbbc9d6, 0xacbcf940,	0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-	0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-	0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-	0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,	0x76dc4190, 0x01db7106,
-	0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-	0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-	0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-	0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-	0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-	0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-	0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-	0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-	0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-	0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-	0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-	0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-	0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-	0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-	0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-	0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-	0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-	0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-	0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-	0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-	0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-	0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-	0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-	0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-	0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-	0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-	0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-	0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-	0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-	0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-	0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-};
-
-
 const u8 s_crc_i2c_table[256] = {
 0x00,0x31,0x62,0x53,0xC4,0xF5,0xA6,0x97,0xB9,0x88,0xDB,0xEA,0x7D,0x4C,0x1F,0x2E,
 0x43,0x72,0x21,0x10,0x87,0xB6,0xE5,0xD4,0xFA,0xCB,0x98,0xA9,0x3E,0x0F,0x5C,0x6D,
@@ -158,19 +117,6 @@ void reset_counters(type_u32_couters* pCounters)
    pCounters->uValueNow = 0;
 }
 
-u32 base_compute_crc32(u8 *buf, int length)
-{
-   u8* p = buf;
-   u32 crc;
-   crc = ~0U;
-
-   while (length--)
-   {
-      crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-   }
-   return crc ^ ~0U;
-} 
-
 u8 base_compute_crc8(u8* pBuffer, int iLength)
 {
    u8 uCrc = 0xFF;
@@ -596,6 +542,311 @@ void log_format_time(u32 miliseconds, char* szOutTime)
    sprintf(szOutTime,"%d-%d:%02d:%02d.%03d", s_bootCount, (int)(miliseconds/1000/60/60), (int)(miliseconds/1000/60)%60, (int)((miliseconds/1000)%60), (int)(miliseconds%1000));
 }
 
+// Asynchronous log writer: log_line, log_softerror_and_alarm and log_error_and_alarm format
+// the log entry on the caller thread into a lock-free ring (multiple producers, one consumer),
+// and a background thread writes it to the log files, that it keeps opened.
+// This keeps slow storage (SD cards) writes off the radio/video threads.
+// If the ring is full, log entries are dropped and counted.
+
+#ifdef LOG_USE_ASYNC_WRITER
+
+#define LOG_ASYNC_RING_SIZE 1024
+#define LOG_ASYNC_ENTRY_LENGTH 384
+
+#define LOG_ASYNC_TYPE_LINE 1
+#define LOG_ASYNC_TYPE_SOFTERROR 2
+#define LOG_ASYNC_TYPE_ERROR 3
+
+typedef struct
+{
+   u32 uSequence;
+   int iType;
+   char szText[LOG_ASYNC_ENTRY_LENGTH];
+} type_log_async_entry;
+
+static type_log_async_entry s_LogAsyncRing[LOG_ASYNC_RING_SIZE];
+static u32 s_uLogAsyncEnqueuePos = 0;
+static u32 s_uLogAsyncDequeuePos = 0;
+static u32 s_uLogAsyncDroppedEntries = 0;
+static u32 s_uLogAsyncTotalDroppedEntries = 0;
+static int s_iLogAsyncWriterIsWaiting = 0;
+static int s_iLogAsyncState = 0; // 0: not started, 1: running, -1: failed/stopped, use sync log
+static int s_iLogAsyncQuit = 0;
+static sem_t s_semLogAsync;
+static pthread_t s_pThreadLogAsync;
+static pthread_once_t s_LogAsyncOnce = PTHREAD_ONCE_INIT;
+
+typedef struct
+{
+   FILE* fd;
+   char szFileName[MAX_FILE_PATH_SIZE];
+} type_log_async_file;
+
+static type_log_async_file s_LogAsyncFiles[4]; // system, soft errors, errors, additional
+static u32 s_uLogAsyncLastFilesCheckTime = 0;
+
+static FILE* _log_async_get_file(int iIndex, const char* szFileName)
+{
+   type_log_async_file* pFile = &s_LogAsyncFiles[iIndex];
+   if ( (NULL == szFileName) || (0 == szFileName[0]) )
+   {
+      if ( NULL != pFile->fd )
+         fclose(pFile->fd);
+      pFile->fd = NULL;
+      pFile->szFileName[0] = 0;
+      return NULL;
+   }
+   if ( (NULL != pFile->fd) && (0 != strcmp(pFile->szFileName, szFileName)) )
+   {
+      fclose(pFile->fd);
+      pFile->fd = NULL;
+   }
+   if ( NULL == pFile->fd )
+   {
+      strncpy(pFile->szFileName, szFileName, MAX_FILE_PATH_SIZE-1);
+      pFile->szFileName[MAX_FILE_PATH_SIZE-1] = 0;
+      pFile->fd = fopen(szFileName, "a+");
+   }
+   return pFile->fd;
+}
+
+// Log files can be deleted while the process runs (i.e. when logs are cleared from the controller),
+// so reopen any file that got unlinked.
+
+static void _log_async_check_files()
+{
+   for( int i=0; i<(int)(sizeof(s_LogAsyncFiles)/sizeof(s_LogAsyncFiles[0])); i++ )
+   {
+      if ( NULL == s_LogAsyncFiles[i].fd )
+         continue;
+      struct stat statFile;
+      if ( (0 == fstat(fileno(s_LogAsyncFiles[i].fd), &statFile)) && (statFile.st_nlink > 0) )
+         continue;
+      fclose(s_LogAsyncFiles[i].fd);
+      s_LogAsyncFiles[i].fd = NULL;
+   }
+}
+
+static void _log_async_write_entry(type_log_async_entry* pEntry)
+{
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_LOGS);
+   strcat(szFile, LOG_FILE_SYSTEM);
+   FILE* fd = _log_async_get_file(0, szFile);
+   if ( NULL != fd )
+      fprintf(fd, "%s\n", pEntry->szText);
+
+   if ( (LOG_ASYNC_TYPE_SOFTERROR == pEntry->iType) || (LOG_ASYNC_TYPE_ERROR == pEntry->iType) )
+   {
+      int iIndex = (LOG_ASYNC_TYPE_ERROR == pEntry->iType)?2:1;
+      strcpy(szFile, FOLDER_LOGS);
+      strcat(szFile, (LOG_ASYNC_TYPE_ERROR == pEntry->iType)?LOG_FILE_ERRORS:LOG_FILE_ERRORS_SOFT);
+      fd = _log_async_get_file(iIndex, szFile);
+      if ( NULL != fd )
+         fprintf(fd, "%s\n", pEntry->szText);
+   }
+
+   fd = _log_async_get_file(3, s_szAdditionalLogFile);
+   if ( NULL != fd )
+      fprintf(fd, "%s\n", pEntry->szText);
+
+   if ( ! s_logDisabledStdout )
+      printf("%s\n", pEntry->szText);
+}
+
+static int _log_async_has_entry()
+{
+   u32 uPos = s_uLogAsyncDequeuePos;
+   u32 uSeq = __atomic_load_n(&s_LogAsyncRing[uPos % LOG_ASYNC_RING_SIZE].uSequence, __ATOMIC_ACQUIRE);
+   return ((int)(uSeq - (uPos+1)) >= 0)?1:0;
+}
+
+// Writes all the available log entries. Returns the number of entries written.
+
+static int _log_async_drain()
+{
+   int iCount = 0;
+   while ( _log_async_has_entry() )
+   {
+      u32 uPos = s_uLogAsyncDequeuePos;
+      type_log_async_entry* pEntry = &s_LogAsyncRing[uPos % LOG_ASYNC_RING_SIZE];
+      _log_async_write_entry(pEntry);
+      __atomic_store_n(&pEntry->uSequence, uPos + LOG_ASYNC_RING_SIZE, __ATOMIC_RELEASE);
+      __atomic_store_n(&s_uLogAsyncDequeuePos, uPos+1, __ATOMIC_RELEASE);
+      iCount++;
+   }
+
+   u32 uDropped = __atomic_exchange_n(&s_uLogAsyncDroppedEntries, 0, __ATOMIC_RELAXED);
+   if ( uDropped > 0 )
+   {
+      type_log_async_entry entry;
+      char szTime[64];
+      log_format_time(get_current_timestamp_ms(), szTime);
+      entry.iType = LOG_ASYNC_TYPE_SOFTERROR;
+      snprintf(entry.szText, LOG_ASYNC_ENTRY_LENGTH, "%s %s: SOFT_ERROR: Log ring full, dropped %u log entries (%u total).", szTime, sszComponentName, uDropped, __atomic_load_n(&s_uLogAsyncTotalDroppedEntries, __ATOMIC_RELAXED));
+      _log_async_write_entry(&entry);
+      iCount++;
+   }
+
+   if ( iCount > 0 )
+   {
+      for( int i=0; i<(int)(sizeof(s_LogAsyncFiles)/sizeof(s_LogAsyncFiles[0])); i++ )
+         if ( NULL != s_LogAsyncFiles[i].fd )
+            fflush(s_LogAsyncFiles[i].fd);
+      if ( ! s_logDisabledStdout )
+         fflush(stdout);
+   }
+
+   u32 uTime = get_current_timestamp_ms();
+   if ( uTime > s_uLogAsyncLastFilesCheckTime + 1000 )
+   {
+      s_uLogAsyncLastFilesCheckTime = uTime;
+      _log_async_check_files();
+   }
+   return iCount;
+}
+
+static void* _thread_log_async_writer(void *argument)
+{
+   while ( ! __atomic_load_n(&s_iLogAsyncQuit, __ATOMIC_ACQUIRE) )
+   {
+      if ( _log_async_drain() > 0 )
+         continue;
+
+      __atomic_store_n(&s_iLogAsyncWriterIsWaiting, 1, __ATOMIC_SEQ_CST);
+      if ( _log_async_has_entry() || __atomic_load_n(&s_iLogAsyncQuit, __ATOMIC_ACQUIRE) )
+      {
+         __atomic_store_n(&s_iLogAsyncWriterIsWaiting, 0, __ATOMIC_SEQ_CST);
+         continue;
+      }
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_nsec += 200*1000*1000;
+      if ( ts.tv_nsec >= 1000*1000*1000 )
+      {
+         ts.tv_sec++;
+         ts.tv_nsec -= 1000*1000*1000;
+      }
+      sem_timedwait(&s_semLogAsync, &ts);
+      __atomic_store_n(&s_iLogAsyncWriterIsWaiting, 0, __ATOMIC_SEQ_CST);
+   }
+   _log_async_drain();
+   return NULL;
+}
+
+static void _log_async_stop()
+{
+   if ( 1 != s_iLogAsyncState )
+      return;
+   __atomic_store_n(&s_iLogAsyncQuit, 1, __ATOMIC_RELEASE);
+   sem_post(&s_semLogAsync);
+   pthread_join(s_pThreadLogAsync, NULL);
+   s_iLogAsyncState = -1;
+   for( int i=0; i<(int)(sizeof(s_LogAsyncFiles)/sizeof(s_LogAsyncFiles[0])); i++ )
+      _log_async_get_file(i, NULL);
+}
+
+static void _log_async_start()
+{
+   s_iLogAsyncState = -1;
+   for( u32 i=0; i<LOG_ASYNC_RING_SIZE; i++ )
+      s_LogAsyncRing[i].uSequence = i;
+   memset(s_LogAsyncFiles, 0, sizeof(s_LogAsyncFiles));
+   if ( 0 != sem_init(&s_semLogAsync, 0, 0) )
+      return;
+
+   pthread_attr_t attr;
+   pthread_attr_init(&attr);
+   pthread_attr_setstacksize(&attr, 32*1024);
+   if ( 0 != pthread_create(&s_pThreadLogAsync, &attr, &_thread_log_async_writer, NULL) )
+   {
+      pthread_attr_destroy(&attr);
+      sem_destroy(&s_semLogAsync);
+      return;
+   }
+   pthread_attr_destroy(&attr);
+   s_iLogAsyncState = 1;
+   atexit(_log_async_stop);
+}
+
+// Returns 1 if the log entry was handled (queued or dropped), 0 if the regular synchronous log must be used
+
+static int _log_async_entry(int iType, const char* szPrefix, const char* format, va_list args)
+{
+   pthread_once(&s_LogAsyncOnce, _log_async_start);
+   if ( 1 != s_iLogAsyncState )
+      return 0;
+
+   u32 uPos = __atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_RELAXED);
+   type_log_async_entry* pEntry = NULL;
+   while ( 1 )
+   {
+      pEntry = &s_LogAsyncRing[uPos % LOG_ASYNC_RING_SIZE];
+      u32 uSeq = __atomic_load_n(&pEntry->uSequence, __ATOMIC_ACQUIRE);
+      int iDiff = (int)(uSeq - uPos);
+      if ( 0 == iDiff )
+      {
+         if ( __atomic_compare_exchange_n(&s_uLogAsyncEnqueuePos, &uPos, uPos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            break;
+      }
+      else if ( iDiff < 0 )
+      {
+         __atomic_add_fetch(&s_uLogAsyncDroppedEntries, 1, __ATOMIC_RELAXED);
+         __atomic_add_fetch(&s_uLogAsyncTotalDroppedEntries, 1, __ATOMIC_RELAXED);
+         return 1;
+      }
+      else
+         uPos = __atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_RELAXED);
+   }
+
+   char szTime[64];
+   szTime[0] = 0;
+   if ( s_logAddTime )
+      log_format_time(get_current_timestamp_ms(), szTime);
+
+   pEntry->iType = iType;
+   int iLen = snprintf(pEntry->szText, LOG_ASYNC_ENTRY_LENGTH, "%s %s: %s", szTime, sszComponentName, szPrefix);
+   if ( (iLen >= 0) && (iLen < LOG_ASYNC_ENTRY_LENGTH-1) )
+      vsnprintf(&(pEntry->szText[iLen]), LOG_ASYNC_ENTRY_LENGTH - iLen, format, args);
+   pEntry->szText[LOG_ASYNC_ENTRY_LENGTH-1] = 0;
+
+   __atomic_store_n(&pEntry->uSequence, uPos+1, __ATOMIC_SEQ_CST);
+
+   int iWaiting = 1;
+   if ( __atomic_load_n(&s_iLogAsyncWriterIsWaiting, __ATOMIC_SEQ_CST) )
+   if ( __atomic_compare_exchange_n(&s_iLogAsyncWriterIsWaiting, &iWaiting, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) )
+      sem_post(&s_semLogAsync);
+   return 1;
+}
+
+#endif
+
+u32 log_get_dropped_entries_count()
+{
+   #ifdef LOG_USE_ASYNC_WRITER
+   return __atomic_load_n(&s_uLogAsyncTotalDroppedEntries, __ATOMIC_RELAXED);
+   #else
+   return 0;
+   #endif
+}
+
+// Waits for the pending log entries to be written to the log files
+
+void log_flush()
+{
+   #ifdef LOG_USE_ASYNC_WRITER
+   if ( 1 != s_iLogAsyncState )
+      return;
+   for( int i=0; i<200; i++ )
+   {
+      if ( __atomic_load_n(&s_uLogAsyncEnqueuePos, __ATOMIC_ACQUIRE) == __atomic_load_n(&s_uLogAsyncDequeuePos, __ATOMIC_ACQUIRE) )
+         break;
+      sem_post(&s_semLogAsync);
+      hardware_sleep_ms(1);
+   }
+   #endif
+}
+
 void log_line(const char* format, ...)
 {
    if ( s_logDisabled || s_logOnlyErrors )
@@ -618,6 +869,14 @@ void log_line(const char* format, ...)
       return;
    }
 
+   #ifdef LOG_USE_ASYNC_WRITER
+   if ( _log_async_entry(LOG_ASYNC_TYPE_LINE, "", format, args) )
+   {
+      va_end(args);
+      return;
+   }
+   #endif
+
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_LOGS);
    strcat(szFile, LOG_FILE_SYSTEM);
@@ -1177,6 +1436,14 @@ void log_error_and_alarm(const char* format, ...)
       return;
    }
 
+   #ifdef LOG_USE_ASYNC_WRITER
+   if ( _log_async_entry(LOG_ASYNC_TYPE_ERROR, "ERROR: ", format, args) )
+   {
+      va_end(args);
+      return;
+   }
+   #endif
+
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_LOGS);
    strcat(szFile, LOG_FILE_SYSTEM);
@@ -1277,6 +1544,14 @@ void log_softerror_and_alarm(const char* format, ...)
       return;
    }
 
+   #ifdef LOG_USE_ASYNC_WRITER
+   if ( _log_async_entry(LOG_ASYNC_TYPE_SOFTERROR, "SOFT_ERROR: ", format, args) )
+   {
+      va_end(args);
+      return;
+   }
+   #endif
+
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_LOGS);
    strcat(szFile, LOG_FILE_SYSTEM);
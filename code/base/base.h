@@ -119,6 +119,8 @@ void log_softerror_and_alarm(const char* format, ...);
 void log_error_and_alarm(const char* format, ...);
 void log_line_watchdog(const char* format, ...);
 void log_line_commands(const char* format, ...);
+void log_flush();
+u32 log_get_dropped_entries_count();
 
 int check_licences();
 
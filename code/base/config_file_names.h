@@ -13,6 +13,7 @@
 #define LOG_FILE_VIDEO "log_video.txt"
 #define LOG_FILE_CAPTURE_VEYE "log_capture_veye.txt"
 #define LOG_FILE_VEHICLE "log_vehicle_%s.txt"
+#define LOG_FILE_FLIGHT_RECORDER "flight_recorder.rec"
 
 #define FILE_FORMAT_SCREENSHOT "picture-%s-%d-%d-%d.png"
 #define FILE_FORMAT_VIDEO_INFO "video-%s-%d-%d-%d.info"
@@ -40,6 +41,7 @@
 #define FILE_CONFIG_CURRENT_VEHICLE_COUNT "current_vehicle_count.cfg"
 #define FILE_CONFIG_CURRENT_SEARCH_BAND "current_search_band.cfg"
 #define FILE_CONFIG_CURRENT_RADIO_HW_CONFIG "current_radios.cfg"
+#define FILE_CONFIG_CURRENT_RADIO_HW_TOPOLOGY "current_radios_topology.cfg"
 #define FILE_CONFIG_HARDWARE_I2C_DEVICES "i2c_devices_settings.cfg"
 #define FILE_CONFIG_ENCRYPTION_PASS "current_pph.cfg"
 #define FILE_CONFIG_HW_SERIAL_PORTS "hw_serial.cfg"
@@ -60,6 +62,9 @@
 #define FILE_TEMP_USB_TETHERING_DEVICE "usb_tethering"
 #define FILE_TEMP_VIDEO_MEM_FILE "tmpVideo.h26x"
 #define FILE_TEMP_VIDEO_FILE "tmpVideo.h26x"
+#define FILE_TEMP_VIDEO_MP4_FILE "tmpVideo.mp4"
+#define FILE_TEMP_VIDEO_PLAYBACK_H264_FILE "tmpPlayback.h264"
+#define FILE_TEMP_VIDEO_PLAYBACK_H265_FILE "tmpPlayback.h265"
 #define FILE_TEMP_VIDEO_FILE_INFO "tmpVideo.info"
 #define FILE_TEMP_VIDEO_FILE_PROCESS_ERROR "tmpErrorVideo.stat"
 #define FILE_TEMP_UPDATE_IN_PROGRESS "updateinprogress"
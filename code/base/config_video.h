@@ -35,6 +35,9 @@
 #define DEFAULT_VIDEO_RETRANS_MINIMUM_RETRY_INTERVAL 10 //milisec
 #define DEFAULT_VIDEO_RETRANS_REQUEST_ON_VIDEO_SILENCE_MS 70 // milisec
 #define DEFAULT_VIDEO_RETRANS_MAX_PCOUNT 10
+#define DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT 40
+#define DEFAULT_VIDEO_RETRANS_AIRTIME_PERCENT 50 // max share of a video send slice used by retransmissions when new video is waiting too
+#define DEFAULT_VIDEO_RETRANS_DEADLINE_MARGIN_MS 5 // stop retransmitting a block this long before the controller drops it
 
 #define DEFAULT_VIDEO_WIDTH 1280
 #define DEFAULT_VIDEO_HEIGHT 720
@@ -41,13 +41,13 @@
 
 controller_runtime_info* controller_rt_info_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_CONTROLLER_RUNTIME_INFO, sizeof(controller_runtime_info));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_CONTROLLER_RUNTIME_INFO, sizeof(controller_runtime_info));
    return (controller_runtime_info*)retVal;
 }
 
 controller_runtime_info* controller_rt_info_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_CONTROLLER_RUNTIME_INFO, sizeof(controller_runtime_info));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_CONTROLLER_RUNTIME_INFO, sizeof(controller_runtime_info));
    controller_runtime_info* pRTInfo = (controller_runtime_info*)retVal;
    controller_rt_info_init(pRTInfo);
    return pRTInfo;
@@ -55,8 +55,7 @@ controller_runtime_info* controller_rt_info_open_for_write()
 
 void controller_rt_info_close(controller_runtime_info* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(controller_runtime_info));
+   close_shared_mem_versioned(pAddress, sizeof(controller_runtime_info));
    //shm_unlink(szName);
 }
 
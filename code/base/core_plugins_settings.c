@@ -34,6 +34,8 @@
 #include "config.h"
 #include "core_plugins_settings.h"
 #include "../public/ruby_core_plugin.h"
+#include "../public/utils/core_plugins_ring.h"
+#include "../radio/radiopackets2.h"
 #include "hardware.h"
 #include "hw_procs.h"
 #include "flags.h"
@@ -43,6 +45,8 @@
 #include <dirent.h>
 #include <string.h>
 
+#define CORE_PLUGINS_RX_RING_SLOTS 64
+
 int s_CorePluginsSettingsLoaded = 0;
 
 CorePluginRuntimeInfo s_CorePluginsRuntimeInfo[MAX_CORE_PLUGINS_COUNT];
@@ -184,6 +188,65 @@ CorePluginSettings* get_CorePluginSettings(char* szPluginGUID)
    return NULL;
 }
 
+static void _load_CorePluginDataFunctions(CorePluginRuntimeInfo* pInfo)
+{
+   pInfo->pFunctionCoreOnRxData = (void (*)(u8*, int, int, u32)) dlsym(pInfo->pLibrary, "core_plugin_on_rx_data");
+   pInfo->pFunctionCoreHasPendingTxData = (u32 (*)(void)) dlsym(pInfo->pLibrary, "core_plugin_has_pending_tx_data");
+   pInfo->pFunctionCoreGetSegmentData = (u8* (*)(u32)) dlsym(pInfo->pLibrary, "core_plugin_on_get_segment_data");
+   pInfo->pFunctionCoreGetSegmentLength = (int (*)(u32)) dlsym(pInfo->pLibrary, "core_plugin_on_get_segment_length");
+   pInfo->pFunctionCoreGetSegmentType = (int (*)(u32)) dlsym(pInfo->pLibrary, "core_plugin_on_get_segment_type");
+
+   pInfo->iAPIVersion = CORE_PLUGIN_API_VERSION_1;
+   pInfo->pTxRing = NULL;
+   pInfo->pRxRing = NULL;
+   int (*pFunctionCoreGetAPIVersion)(void) = (int (*)(void)) dlsym(pInfo->pLibrary, "core_plugin_get_api_version");
+   pInfo->pFunctionCoreV2GetTxRing = (t_core_plugin_ring* (*)(void)) dlsym(pInfo->pLibrary, "core_plugin_v2_get_tx_ring");
+   pInfo->pFunctionCoreV2SetRxRing = (void (*)(t_core_plugin_ring*)) dlsym(pInfo->pLibrary, "core_plugin_v2_set_rx_ring");
+   pInfo->pFunctionCoreV2OnRxBatch = (void (*)(u32, int)) dlsym(pInfo->pLibrary, "core_plugin_v2_on_rx_batch");
+
+   if ( (NULL == pFunctionCoreGetAPIVersion) || ((*pFunctionCoreGetAPIVersion)() < CORE_PLUGIN_API_VERSION_2) )
+      return;
+
+   if ( (NULL != pInfo->pFunctionCoreV2GetTxRing) )
+   {
+      pInfo->pTxRing = (*(pInfo->pFunctionCoreV2GetTxRing))();
+      if ( (NULL != pInfo->pTxRing) && (! core_plugin_ring_is_valid(pInfo->pTxRing)) )
+      {
+         log_softerror_and_alarm("[CorePlugins] Plugin [%s] returned an invalid tx ring. Using API version 1 for it.", pInfo->szName);
+         pInfo->pTxRing = NULL;
+         return;
+      }
+   }
+   if ( (NULL != pInfo->pFunctionCoreV2SetRxRing) && (NULL != pInfo->pFunctionCoreV2OnRxBatch) )
+   {
+      int iSize = core_plugin_ring_get_memory_size(CORE_PLUGINS_RX_RING_SLOTS, MAX_PACKET_PAYLOAD);
+      void* pMemory = malloc(iSize);
+      pInfo->pRxRing = core_plugin_ring_init(pMemory, iSize, CORE_PLUGINS_RX_RING_SLOTS, MAX_PACKET_PAYLOAD);
+      if ( NULL != pInfo->pRxRing )
+         (*(pInfo->pFunctionCoreV2SetRxRing))(pInfo->pRxRing);
+      else if ( NULL != pMemory )
+         free(pMemory);
+   }
+   pInfo->iAPIVersion = CORE_PLUGIN_API_VERSION_2;
+   log_line("[CorePlugins] Plugin [%s] uses API version 2, tx ring: %s (%d slots), rx ring: %s",
+      pInfo->szName, (NULL != pInfo->pTxRing)?"yes":"no", (NULL != pInfo->pTxRing)?(int)pInfo->pTxRing->uSlotsCount:0, (NULL != pInfo->pRxRing)?"yes":"no");
+}
+
+static void _unload_CorePlugin(CorePluginRuntimeInfo* pInfo)
+{
+   if ( NULL == pInfo->pLibrary )
+      return;
+   if ( NULL != pInfo->pFunctionCoreUninit )
+      (*(pInfo->pFunctionCoreUninit))();
+
+   dlclose(pInfo->pLibrary);
+   pInfo->pLibrary = NULL;
+   pInfo->pTxRing = NULL;
+   if ( NULL != pInfo->pRxRing )
+      free(pInfo->pRxRing);
+   pInfo->pRxRing = NULL;
+}
+
 int _load_CorePlugin(char* szFileName, int iEnumerateOnly)
 {
    char szFile[256];
@@ -298,7 +361,10 @@ int _load_CorePlugin(char* szFileName, int iEnumerateOnly)
    }
 
    if ( ! iEnumerateOnly )
+   {
       (*(s_CorePluginsRuntimeInfo[s_iCorePluginsRuntimeCount].pFunctionCoreInit))(CORE_PLUGIN_RUNTIME_LOCATION_CONTROLLER, uRequestedCapabilities);
+      _load_CorePluginDataFunctions(&(s_CorePluginsRuntimeInfo[s_iCorePluginsRuntimeCount]));
+   }
    else
    {
       dlclose(s_CorePluginsRuntimeInfo[s_iCorePluginsRuntimeCount].pLibrary);
@@ -353,11 +419,7 @@ void unload_CorePlugins()
    {
       if ( NULL == s_CorePluginsRuntimeInfo[i].pLibrary )
          continue;
-      if ( NULL != s_CorePluginsRuntimeInfo[i].pFunctionCoreUninit )
-         (*(s_CorePluginsRuntimeInfo[i].pFunctionCoreUninit))();
-   
-      dlclose(s_CorePluginsRuntimeInfo[i].pLibrary);
-      s_CorePluginsRuntimeInfo[i].pLibrary = NULL;
+      _unload_CorePlugin(&(s_CorePluginsRuntimeInfo[i]));
       log_line("[CorePlugins] Unloaded plugin [%s]", s_CorePluginsRuntimeInfo[i].szName);
    }
 
@@ -388,14 +450,7 @@ void delete_CorePlugin(char* szGUID)
    if ( -1 == iIndex )
       return;
 
-   if ( NULL != s_CorePluginsRuntimeInfo[iIndex].pLibrary )
-   {
-      if ( NULL != s_CorePluginsRuntimeInfo[iIndex].pFunctionCoreUninit )
-         (*(s_CorePluginsRuntimeInfo[iIndex].pFunctionCoreUninit))();
-   
-      dlclose(s_CorePluginsRuntimeInfo[iIndex].pLibrary);
-      s_CorePluginsRuntimeInfo[iIndex].pLibrary = NULL;
-   }
+   _unload_CorePlugin(&(s_CorePluginsRuntimeInfo[iIndex]));
       
    log_line("[CorePlugins] Deleted plugin [%s]", s_CorePluginsRuntimeInfo[iIndex].szName);
 
@@ -440,3 +495,126 @@ char* get_CorePluginGUID(int iPluginIndex)
    return s_CorePluginsRuntimeInfo[iPluginIndex].szGUID;
 }
 
+int get_CorePluginAPIVersion(int iPluginIndex)
+{
+   if ( iPluginIndex < 0 || iPluginIndex >= s_iCorePluginsRuntimeCount )
+      return 0;
+   return s_CorePluginsRuntimeInfo[iPluginIndex].iAPIVersion;
+}
+
+int core_plugins_get_tx_segments(int iPluginIndex, t_core_plugin_segment* pSegments, int iMaxCount)
+{
+   if ( (iPluginIndex < 0) || (iPluginIndex >= s_iCorePluginsRuntimeCount) || (NULL == pSegments) )
+      return 0;
+   CorePluginRuntimeInfo* pInfo = &(s_CorePluginsRuntimeInfo[iPluginIndex]);
+   if ( NULL == pInfo->pLibrary )
+      return 0;
+
+   int iCount = 0;
+   if ( NULL != pInfo->pTxRing )
+   {
+      while ( (iCount < iMaxCount) && core_plugin_ring_peek(pInfo->pTxRing, iCount, &(pSegments[iCount].pData), &(pSegments[iCount].iLength), &(pSegments[iCount].iType), &(pSegments[iCount].uSegmentIndex)) )
+         iCount++;
+      return iCount;
+   }
+
+   if ( (NULL == pInfo->pFunctionCoreHasPendingTxData) || (NULL == pInfo->pFunctionCoreGetSegmentData) || (NULL == pInfo->pFunctionCoreGetSegmentLength) )
+      return 0;
+
+   while ( iCount < iMaxCount )
+   {
+      u32 uSegmentIndex = (*(pInfo->pFunctionCoreHasPendingTxData))();
+      if ( 0 == uSegmentIndex )
+         break;
+      pSegments[iCount].uSegmentIndex = uSegmentIndex;
+      pSegments[iCount].pData = (*(pInfo->pFunctionCoreGetSegmentData))(uSegmentIndex);
+      pSegments[iCount].iLength = (*(pInfo->pFunctionCoreGetSegmentLength))(uSegmentIndex);
+      pSegments[iCount].iType = CORE_PLUGIN_TYPE_DATA_SEGMENT;
+      if ( NULL != pInfo->pFunctionCoreGetSegmentType )
+         pSegments[iCount].iType = (*(pInfo->pFunctionCoreGetSegmentType))(uSegmentIndex);
+      if ( (NULL == pSegments[iCount].pData) || (pSegments[iCount].iLength <= 0) )
+         break;
+      iCount++;
+   }
+   return iCount;
+}
+
+void core_plugins_release_tx_segments(int iPluginIndex, int iCount)
+{
+   if ( (iPluginIndex < 0) || (iPluginIndex >= s_iCorePluginsRuntimeCount) )
+      return;
+   if ( NULL != s_CorePluginsRuntimeInfo[iPluginIndex].pTxRing )
+      core_plugin_ring_release(s_CorePluginsRuntimeInfo[iPluginIndex].pTxRing, iCount);
+}
+
+int core_plugins_get_tx_segment_for_retransmission(int iPluginIndex, u32 uSegmentIndex, u8* pOutput, int iMaxLength, int* piType)
+{
+   if ( (iPluginIndex < 0) || (iPluginIndex >= s_iCorePluginsRuntimeCount) || (NULL == pOutput) )
+      return -1;
+   CorePluginRuntimeInfo* pInfo = &(s_CorePluginsRuntimeInfo[iPluginIndex]);
+   if ( NULL == pInfo->pLibrary )
+      return -1;
+
+   u8* pData = NULL;
+   int iLength = 0;
+   int iType = CORE_PLUGIN_TYPE_DATA_SEGMENT;
+   if ( NULL != pInfo->pTxRing )
+   {
+      if ( ! core_plugin_ring_find_segment(pInfo->pTxRing, uSegmentIndex, &pData, &iLength, &iType) )
+         return -1;
+   }
+   else
+   {
+      if ( (NULL == pInfo->pFunctionCoreGetSegmentData) || (NULL == pInfo->pFunctionCoreGetSegmentLength) )
+         return -1;
+      pData = (*(pInfo->pFunctionCoreGetSegmentData))(uSegmentIndex);
+      iLength = (*(pInfo->pFunctionCoreGetSegmentLength))(uSegmentIndex);
+      if ( NULL != pInfo->pFunctionCoreGetSegmentType )
+         iType = (*(pInfo->pFunctionCoreGetSegmentType))(uSegmentIndex);
+   }
+   if ( (NULL == pData) || (iLength <= 0) || (iLength > iMaxLength) )
+      return -1;
+   memcpy(pOutput, pData, iLength);
+
+   // The plugin could have reused the ring slot while we copied it
+   if ( (NULL != pInfo->pTxRing) && (! core_plugin_ring_is_segment_present(pInfo->pTxRing, uSegmentIndex)) )
+      return -1;
+   if ( NULL != piType )
+      *piType = iType;
+   return iLength;
+}
+
+int core_plugins_on_rx_segments(int iPluginIndex, t_core_plugin_segment* pSegments, int iCount)
+{
+   if ( (iPluginIndex < 0) || (iPluginIndex >= s_iCorePluginsRuntimeCount) || (NULL == pSegments) || (iCount <= 0) )
+      return 0;
+   CorePluginRuntimeInfo* pInfo = &(s_CorePluginsRuntimeInfo[iPluginIndex]);
+   if ( NULL == pInfo->pLibrary )
+      return 0;
+
+   int iAccepted = 0;
+   if ( NULL != pInfo->pRxRing )
+   {
+      for( int i=0; i<iCount; i++ )
+      {
+         u8* pBuffer = core_plugin_ring_get_write_buffer(pInfo->pRxRing);
+         if ( NULL == pBuffer )
+            break;
+         int iLength = pSegments[i].iLength;
+         if ( iLength > (int)pInfo->pRxRing->uSlotDataSize )
+            iLength = pInfo->pRxRing->uSlotDataSize;
+         memcpy(pBuffer, pSegments[i].pData, iLength);
+         core_plugin_ring_commit_write(pInfo->pRxRing, iLength, pSegments[i].iType, pSegments[i].uSegmentIndex);
+         iAccepted++;
+      }
+      if ( iAccepted > 0 )
+         (*(pInfo->pFunctionCoreV2OnRxBatch))(pSegments[0].uSegmentIndex, iAccepted);
+      return iAccepted;
+   }
+
+   if ( NULL == pInfo->pFunctionCoreOnRxData )
+      return 0;
+   for( int i=0; i<iCount; i++ )
+      (*(pInfo->pFunctionCoreOnRxData))(pSegments[i].pData, pSegments[i].iLength, pSegments[i].iType, pSegments[i].uSegmentIndex);
+   return iCount;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../base/hardware.h"
+#include "../public/ruby_core_plugin.h"
 
 #define CORE_PLUGINS_SETTINGS_STAMP_ID "vVII.0"
 
@@ -19,6 +20,21 @@ typedef struct
    u32 (*pFunctionCoreRequestCapab)(void);
    const char* (*pFunctionCoreGetName)(void);
    const char* (*pFunctionCoreGetUID)(void);
+
+   // Data segments methods, API version 1
+   void (*pFunctionCoreOnRxData)(u8*, int, int, u32);
+   u32 (*pFunctionCoreHasPendingTxData)(void);
+   u8* (*pFunctionCoreGetSegmentData)(u32);
+   int (*pFunctionCoreGetSegmentLength)(u32);
+   int (*pFunctionCoreGetSegmentType)(u32);
+
+   // Data segments rings, API version 2
+   int iAPIVersion;
+   t_core_plugin_ring* (*pFunctionCoreV2GetTxRing)(void);
+   void (*pFunctionCoreV2SetRxRing)(t_core_plugin_ring*);
+   void (*pFunctionCoreV2OnRxBatch)(u32, int);
+   t_core_plugin_ring* pTxRing;
+   t_core_plugin_ring* pRxRing;
    
    char szFile[256];
    char szName[128];
@@ -36,6 +52,15 @@ typedef struct
    u32 uAllocatedCapabilities;
 } CorePluginSettings;
 
+// A data segment exchanged with a core plugin. For API version 2 plugins pData points directly inside the plugin's ring.
+typedef struct
+{
+   u8* pData;
+   int iLength;
+   int iType;
+   u32 uSegmentIndex;
+} t_core_plugin_segment;
+
 int save_CorePluginsSettings();
 int load_CorePluginsSettings();
 void reset_CorePluginsSettings();
@@ -50,6 +75,16 @@ void delete_CorePlugin(char* szGUID);
 int get_CorePluginsCount();
 char* get_CorePluginName(int iPluginIndex);
 char* get_CorePluginGUID(int iPluginIndex);
+int get_CorePluginAPIVersion(int iPluginIndex);
+
+// Gets up to iMaxCount pending tx segments from a plugin. The segments must be released after they are sent.
+// API version 2 plugins: a single batch read from the plugin's tx ring, no copy and no call into the plugin.
+int core_plugins_get_tx_segments(int iPluginIndex, t_core_plugin_segment* pSegments, int iMaxCount);
+void core_plugins_release_tx_segments(int iPluginIndex, int iCount);
+// Looks up a previously sent segment, for retransmissions. Copies it to pOutput. Returns the segment length or -1 if not available.
+int core_plugins_get_tx_segment_for_retransmission(int iPluginIndex, u32 uSegmentIndex, u8* pOutput, int iMaxLength, int* piType);
+// Gives a batch of received segments to a plugin. Returns the number of segments the plugin accepted.
+int core_plugins_on_rx_segments(int iPluginIndex, t_core_plugin_segment* pSegments, int iCount);
 
 #ifdef __cplusplus
 }  
@@ -0,0 +1,66 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+#include "base.h"
+
+// CRC32 kernels used by base_compute_crc32 (IEEE 802.3 polynomial, reflected).
+// All kernels give the exact same result as the byte-wise table reference and are selected at runtime:
+// PCLMUL folding on x86, CRC32 instructions on ARMv8 CPUs (also in 32 bits mode), slicing-by-8 otherwise.
+
+#define CRC32_KERNEL_TABLE 0
+#define CRC32_KERNEL_SLICE8 1
+#define CRC32_KERNEL_PCLMUL 2
+#define CRC32_KERNEL_ARMV8 3
+#define CRC32_KERNELS_COUNT 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int crc32_kernel_is_supported(int iKernel);
+// Returns 0 if the kernel is not supported on this CPU. The fastest supported kernel is used by default.
+int crc32_set_kernel(int iKernel);
+int crc32_get_kernel();
+const char* crc32_get_kernel_name(int iKernel);
+
+// Updates a running CRC register (not inverted) using the given kernel
+u32 crc32_update_with_kernel(int iKernel, u32 uCRC, const u8* pBuffer, int iLength);
+
+// Implemented in crc32_armv8.c, built with the ARMv8 CRC extension enabled. Returns 0 if not built for ARM.
+int crc32_armv8_is_built();
+u32 crc32_armv8_update(u32 uCRC, const u8* pBuffer, int iLength);
+
+#ifdef __cplusplus
+}
+#endif
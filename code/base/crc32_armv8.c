@@ -0,0 +1,87 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "crc32.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+
+int crc32_armv8_is_built()
+{
+   return 1;
+}
+
+u32 crc32_armv8_update(u32 uCRC, const u8* pBuffer, int iLength)
+{
+   while ( (iLength > 0) && (((unsigned long)pBuffer) & 7) )
+   {
+      uCRC = __crc32b(uCRC, *pBuffer++);
+      iLength--;
+   }
+   while ( iLength >= 8 )
+   {
+      unsigned long long uValue;
+      memcpy(&uValue, pBuffer, 8);
+      uCRC = __crc32d(uCRC, uValue);
+      pBuffer += 8;
+      iLength -= 8;
+   }
+   if ( iLength >= 4 )
+   {
+      u32 uValue;
+      memcpy(&uValue, pBuffer, 4);
+      uCRC = __crc32w(uCRC, uValue);
+      pBuffer += 4;
+      iLength -= 4;
+   }
+   while ( iLength > 0 )
+   {
+      uCRC = __crc32b(uCRC, *pBuffer++);
+      iLength--;
+   }
+   return uCRC;
+}
+
+#else
+
+int crc32_armv8_is_built()
+{
+   return 0;
+}
+
+u32 crc32_armv8_update(u32 uCRC, const u8* pBuffer, int iLength)
+{
+   return uCRC;
+}
+
+#endif
@@ -33,14 +33,50 @@
 #include "base.h"
 #include "config.h"
 #include "encr.h"
+#include "encr_aead.h"
 #include "../radio/radiopackets2.h"
 
 #define ENC_BLOCK_SIZE 8
 #define ENC_KEY_INIT_SEED 23
+#define ENC_KEY_DERIVATION_ROUNDS 1024
 
 u8 s_epp[MAX_PASS_LENGTH+1];
 u8 s_eppl = 0;
 
+static u8 s_uEncKey[AEAD_KEY_SIZE];
+static int s_iEncKeyReady = 0;
+
+// The key is derived from the pass phrase with chained HChaCha20 calls: the pass phrase (and its length) is absorbed
+// 16 bytes at a time, then the result is iterated ENC_KEY_DERIVATION_ROUNDS times.
+static void _epp_derive_key()
+{
+   static const char* s_szKeyDerivationLabel = "ruby-radio-key-1";
+   u8 uBlock[16];
+   int iLength = (int)s_eppl;
+
+   memset(s_uEncKey, 0, sizeof(s_uEncKey));
+   memcpy(s_uEncKey, s_szKeyDerivationLabel, 16);
+   s_uEncKey[16] = (u8)iLength;
+
+   for( int iPos=0; iPos<iLength; iPos += 16 )
+   {
+      memset(uBlock, 0, sizeof(uBlock));
+      for( int i=0; (i<16) && (iPos+i < iLength); i++ )
+         uBlock[i] = s_epp[iPos+i];
+      aead_hchacha20(s_uEncKey, uBlock, s_uEncKey);
+   }
+
+   for( int i=0; i<ENC_KEY_DERIVATION_ROUNDS; i++ )
+   {
+      memset(uBlock, 0, sizeof(uBlock));
+      uBlock[0] = i & 0xFF;
+      uBlock[1] = (i >> 8) & 0xFF;
+      uBlock[15] = 0x80;
+      aead_hchacha20(s_uEncKey, uBlock, s_uEncKey);
+   }
+   s_iEncKeyReady = 1;
+}
+
 int lpp(char* szOutputBuffer, int maxLength)
 {
    char szFile[128];
@@ -91,6 +127,7 @@ int lpp(char* szOutputBuffer, int maxLength)
    s_eppl = pos;
    strncpy((char*)s_epp, szBuffer, MAX_PASS_LENGTH);
    s_epp[MAX_PASS_LENGTH] = 0;
+   s_iEncKeyReady = 0;
 
    if ( NULL != szOutputBuffer )
       strncpy(szOutputBuffer, szBuffer, maxLength);
@@ -113,6 +150,7 @@ int spp(char* szBuffer)
    s_eppl = strlen(szBuffer);
    strncpy((char*)s_epp, szBuffer, MAX_PASS_LENGTH);
    s_epp[MAX_PASS_LENGTH] = 0;
+   s_iEncKeyReady = 0;
 
    u8 sBlockSeed[ENC_BLOCK_SIZE];
    u8 sBlockInput[ENC_BLOCK_SIZE];
@@ -165,6 +203,8 @@ void rpp()
 {
    s_eppl = 0;
    s_epp[0] = 0;
+   s_iEncKeyReady = 0;
+   memset(s_uEncKey, 0, sizeof(s_uEncKey));
 }
 
 u8* gpp(int* pLen)
@@ -181,23 +221,32 @@ int hpp()
    return 0;
 }
 
-int epp(u8* pData, int len)
+int epp(u8* pHeader, int iHeaderLength, u8* pData, int iLength, u8* pNonce, u8* pTag)
 {
-   if ( NULL == pData || len <= 0 )
+   if ( (NULL == pData) || (iLength < 0) || (NULL == pNonce) || (NULL == pTag) )
       return 0;
    if ( 0 == s_eppl )
-      return 1;
+      return 0;
+   if ( ! s_iEncKeyReady )
+      _epp_derive_key();
 
-   for(int pos=0; pos < len; pos++ )
-   {
-      //*pData = (*pData)+1;
-      *pData = (*pData) ^ s_epp[pos%s_eppl];
-      pData++;
-   }
+   aead_seal(s_uEncKey, pNonce, pHeader, iHeaderLength, pData, iLength, pTag);
    return 1;
 }
 
-int dpp(u8* pData, int len)
+int dpp(u8* pHeader, int iHeaderLength, u8* pData, int iLength, u8* pNonce, u8* pTag)
+{
+   if ( (NULL == pData) || (iLength < 0) || (NULL == pNonce) || (NULL == pTag) )
+      return 0;
+   if ( 0 == s_eppl )
+      return 0;
+   if ( ! s_iEncKeyReady )
+      _epp_derive_key();
+
+   return aead_open(s_uEncKey, pNonce, pHeader, iHeaderLength, pData, iLength, pTag);
+}
+
+int epp_legacy(u8* pData, int len)
 {
    if ( NULL == pData || len <= 0 )
       return 0;
@@ -206,9 +255,13 @@ int dpp(u8* pData, int len)
 
    for(int pos=0; pos < len; pos++ )
    {
-      //*pData = (*pData)-1;
       *pData = (*pData) ^ s_epp[pos%s_eppl];
       pData++;
    }
    return 1;
 }
+
+int dpp_legacy(u8* pData, int len)
+{
+   return epp_legacy(pData, len);
+}
@@ -2,10 +2,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "base.h"
+#include "encr_aead.h"
 
 
 #define MAX_PASS_LENGTH 64
 
+// Encrypted radio packets end with the nonce salt and the authentication tag (included in the packet total length)
+#define ENCR_NONCE_SALT_SIZE 4
+#define ENCR_PACKET_OVERHEAD (ENCR_NONCE_SALT_SIZE + AEAD_TAG_SIZE)
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,8 +24,14 @@ void rpp();
 u8* gpp(int* pLen);
 int hpp();
 
-int epp(u8* pData, int len);
-int dpp(u8* pData, int len);
+// ChaCha20-Poly1305 with the key derived from the pass phrase. The header is authenticated, the data is encrypted in place.
+// dpp returns 0 (and leaves the data unchanged) if the tag is not valid. Both return 0 if there is no pass phrase.
+int epp(u8* pHeader, int iHeaderLength, u8* pData, int iLength, u8* pNonce, u8* pTag);
+int dpp(u8* pHeader, int iHeaderLength, u8* pData, int iLength, u8* pNonce, u8* pTag);
+
+// Previous pass phrase XOR, kept for radio packets to and from older peers
+int epp_legacy(u8* pData, int len);
+int dpp_legacy(u8* pData, int len);
 
 #ifdef __cplusplus
 }  
@@ -0,0 +1,746 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "encr_aead.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AEAD_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AEAD_HAS_NEON 1
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#endif
+
+#define AEAD_ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define AEAD_QUARTER_ROUND(a, b, c, d) \
+   a += b; d ^= a; d = AEAD_ROTL32(d, 16); \
+   c += d; b ^= c; b = AEAD_ROTL32(b, 12); \
+   a += b; d ^= a; d = AEAD_ROTL32(d, 8); \
+   c += d; b ^= c; b = AEAD_ROTL32(b, 7);
+
+static int s_iAEADKernel = -1;
+static void (*s_pAEADChaCha20XorFunction)(u32*, u8*, int) = NULL;
+
+static u32 _aead_load32(const u8* pData)
+{
+   return ((u32)pData[0]) | (((u32)pData[1]) << 8) | (((u32)pData[2]) << 16) | (((u32)pData[3]) << 24);
+}
+
+static void _aead_store32(u8* pData, u32 uValue)
+{
+   pData[0] = uValue & 0xFF;
+   pData[1] = (uValue >> 8) & 0xFF;
+   pData[2] = (uValue >> 16) & 0xFF;
+   pData[3] = (uValue >> 24) & 0xFF;
+}
+
+static void _aead_chacha20_init_state(u32* pState, const u8* pKey, const u8* pNonce, u32 uCounter)
+{
+   pState[0] = 0x61707865;
+   pState[1] = 0x3320646e;
+   pState[2] = 0x79622d32;
+   pState[3] = 0x6b206574;
+   for( int i=0; i<8; i++ )
+      pState[4+i] = _aead_load32(pKey + 4*i);
+   pState[12] = uCounter;
+   for( int i=0; i<3; i++ )
+      pState[13+i] = _aead_load32(pNonce + 4*i);
+}
+
+static void _aead_chacha20_rounds(u32* x)
+{
+   for( int i=0; i<10; i++ )
+   {
+      AEAD_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+      AEAD_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+      AEAD_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+      AEAD_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+      AEAD_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+      AEAD_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+      AEAD_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+      AEAD_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+   }
+}
+
+static void _aead_chacha20_xor_scalar(u32* pState, u8* pData, int iLength)
+{
+   u32 x[16];
+   u8 uBlock[64];
+   while ( iLength > 0 )
+   {
+      memcpy(x, pState, sizeof(x));
+      _aead_chacha20_rounds(x);
+      for( int i=0; i<16; i++ )
+         _aead_store32(uBlock + 4*i, x[i] + pState[i]);
+
+      int iCount = (iLength < 64) ? iLength : 64;
+      for( int i=0; i<iCount; i++ )
+         pData[i] ^= uBlock[i];
+      pState[12]++;
+      pData += iCount;
+      iLength -= iCount;
+   }
+}
+
+// The SIMD kernels compute 4 consecutive blocks at once: each vector holds the same state word of the 4 blocks.
+// Full 256 bytes chunks are processed in place, the last partial chunk goes through a temporary buffer.
+
+#ifdef AEAD_HAS_X86_SIMD
+
+#define AEAD_SSE2_ROTL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define AEAD_SSE2_ROTL16(v) _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1)
+
+#define AEAD_SSE2_QUARTER_ROUND(a, b, c, d) \
+   a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = AEAD_SSE2_ROTL16(d); \
+   c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = AEAD_SSE2_ROTL(b, 12); \
+   a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = AEAD_SSE2_ROTL(d, 8); \
+   c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = AEAD_SSE2_ROTL(b, 7);
+
+__attribute__((target("sse2")))
+static void _aead_chacha20_4blocks_sse2(const u32* pState, u8* pData)
+{
+   const __m128i uCounters = _mm_add_epi32(_mm_set1_epi32((int)pState[12]), _mm_setr_epi32(0, 1, 2, 3));
+   __m128i x0 = _mm_set1_epi32((int)pState[0]), x1 = _mm_set1_epi32((int)pState[1]), x2 = _mm_set1_epi32((int)pState[2]), x3 = _mm_set1_epi32((int)pState[3]);
+   __m128i x4 = _mm_set1_epi32((int)pState[4]), x5 = _mm_set1_epi32((int)pState[5]), x6 = _mm_set1_epi32((int)pState[6]), x7 = _mm_set1_epi32((int)pState[7]);
+   __m128i x8 = _mm_set1_epi32((int)pState[8]), x9 = _mm_set1_epi32((int)pState[9]), x10 = _mm_set1_epi32((int)pState[10]), x11 = _mm_set1_epi32((int)pState[11]);
+   __m128i x12 = uCounters, x13 = _mm_set1_epi32((int)pState[13]), x14 = _mm_set1_epi32((int)pState[14]), x15 = _mm_set1_epi32((int)pState[15]);
+
+   for( int i=0; i<10; i++ )
+   {
+      AEAD_SSE2_QUARTER_ROUND(x0, x4, x8, x12);
+      AEAD_SSE2_QUARTER_ROUND(x1, x5, x9, x13);
+      AEAD_SSE2_QUARTER_ROUND(x2, x6, x10, x14);
+      AEAD_SSE2_QUARTER_ROUND(x3, x7, x11, x15);
+      AEAD_SSE2_QUARTER_ROUND(x0, x5, x10, x15);
+      AEAD_SSE2_QUARTER_ROUND(x1, x6, x11, x12);
+      AEAD_SSE2_QUARTER_ROUND(x2, x7, x8, x13);
+      AEAD_SSE2_QUARTER_ROUND(x3, x4, x9, x14);
+   }
+
+   __m128i x[16] = { x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15 };
+   for( int g=0; g<4; g++ )
+   {
+      __m128i a = _mm_add_epi32(x[4*g], (g == 3) ? uCounters : _mm_set1_epi32((int)pState[4*g]));
+      __m128i b = _mm_add_epi32(x[4*g+1], _mm_set1_epi32((int)pState[4*g+1]));
+      __m128i c = _mm_add_epi32(x[4*g+2], _mm_set1_epi32((int)pState[4*g+2]));
+      __m128i d = _mm_add_epi32(x[4*g+3], _mm_set1_epi32((int)pState[4*g+3]));
+      __m128i t0 = _mm_unpacklo_epi32(a, b);
+      __m128i t1 = _mm_unpacklo_epi32(c, d);
+      __m128i t2 = _mm_unpackhi_epi32(a, b);
+      __m128i t3 = _mm_unpackhi_epi32(c, d);
+      __m128i r[4];
+      r[0] = _mm_unpacklo_epi64(t0, t1);
+      r[1] = _mm_unpackhi_epi64(t0, t1);
+      r[2] = _mm_unpacklo_epi64(t2, t3);
+      r[3] = _mm_unpackhi_epi64(t2, t3);
+      for( int k=0; k<4; k++ )
+      {
+         __m128i* pOut = (__m128i*)(pData + 64*k + 16*g);
+         _mm_storeu_si128(pOut, _mm_xor_si128(_mm_loadu_si128(pOut), r[k]));
+      }
+   }
+}
+
+static void _aead_chacha20_xor_sse2(u32* pState, u8* pData, int iLength)
+{
+   while ( iLength >= 256 )
+   {
+      _aead_chacha20_4blocks_sse2(pState, pData);
+      pState[12] += 4;
+      pData += 256;
+      iLength -= 256;
+   }
+   if ( iLength > 0 )
+   {
+      u8 uBuffer[256];
+      memcpy(uBuffer, pData, iLength);
+      _aead_chacha20_4blocks_sse2(pState, uBuffer);
+      memcpy(pData, uBuffer, iLength);
+      pState[12] += (iLength + 63)/64;
+   }
+}
+
+
+#define AEAD_AVX2_ROTL(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+#define AEAD_AVX2_QUARTER_ROUND(a, b, c, d) \
+   a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, uRot16); \
+   c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AEAD_AVX2_ROTL(b, 12); \
+   a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, uRot8); \
+   c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AEAD_AVX2_ROTL(b, 7);
+
+// Same as the SSE2 kernel, with 8 blocks at once: the low 128 bits hold blocks 0..3, the high 128 bits blocks 4..7
+__attribute__((target("avx2")))
+static void _aead_chacha20_8blocks_avx2(const u32* pState, u8* pData)
+{
+   const __m256i uRot16 = _mm256_setr_epi8(2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13, 2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13);
+   const __m256i uRot8 = _mm256_setr_epi8(3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14, 3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14);
+   const __m256i uCounters = _mm256_add_epi32(_mm256_set1_epi32((int)pState[12]), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+   __m256i x0 = _mm256_set1_epi32((int)pState[0]), x1 = _mm256_set1_epi32((int)pState[1]), x2 = _mm256_set1_epi32((int)pState[2]), x3 = _mm256_set1_epi32((int)pState[3]);
+   __m256i x4 = _mm256_set1_epi32((int)pState[4]), x5 = _mm256_set1_epi32((int)pState[5]), x6 = _mm256_set1_epi32((int)pState[6]), x7 = _mm256_set1_epi32((int)pState[7]);
+   __m256i x8 = _mm256_set1_epi32((int)pState[8]), x9 = _mm256_set1_epi32((int)pState[9]), x10 = _mm256_set1_epi32((int)pState[10]), x11 = _mm256_set1_epi32((int)pState[11]);
+   __m256i x12 = uCounters, x13 = _mm256_set1_epi32((int)pState[13]), x14 = _mm256_set1_epi32((int)pState[14]), x15 = _mm256_set1_epi32((int)pState[15]);
+
+   for( int i=0; i<10; i++ )
+   {
+      AEAD_AVX2_QUARTER_ROUND(x0, x4, x8, x12);
+      AEAD_AVX2_QUARTER_ROUND(x1, x5, x9, x13);
+      AEAD_AVX2_QUARTER_ROUND(x2, x6, x10, x14);
+      AEAD_AVX2_QUARTER_ROUND(x3, x7, x11, x15);
+      AEAD_AVX2_QUARTER_ROUND(x0, x5, x10, x15);
+      AEAD_AVX2_QUARTER_ROUND(x1, x6, x11, x12);
+      AEAD_AVX2_QUARTER_ROUND(x2, x7, x8, x13);
+      AEAD_AVX2_QUARTER_ROUND(x3, x4, x9, x14);
+   }
+
+   __m256i x[16] = { x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15 };
+   for( int g=0; g<4; g++ )
+   {
+      __m256i a = _mm256_add_epi32(x[4*g], (g == 3) ? uCounters : _mm256_set1_epi32((int)pState[4*g]));
+      __m256i b = _mm256_add_epi32(x[4*g+1], _mm256_set1_epi32((int)pState[4*g+1]));
+      __m256i c = _mm256_add_epi32(x[4*g+2], _mm256_set1_epi32((int)pState[4*g+2]));
+      __m256i d = _mm256_add_epi32(x[4*g+3], _mm256_set1_epi32((int)pState[4*g+3]));
+      __m256i t0 = _mm256_unpacklo_epi32(a, b);
+      __m256i t1 = _mm256_unpacklo_epi32(c, d);
+      __m256i t2 = _mm256_unpackhi_epi32(a, b);
+      __m256i t3 = _mm256_unpackhi_epi32(c, d);
+      __m256i r[4];
+      r[0] = _mm256_unpacklo_epi64(t0, t1);
+      r[1] = _mm256_unpackhi_epi64(t0, t1);
+      r[2] = _mm256_unpacklo_epi64(t2, t3);
+      r[3] = _mm256_unpackhi_epi64(t2, t3);
+      for( int k=0; k<4; k++ )
+      {
+         __m128i* pOutLow = (__m128i*)(pData + 64*k + 16*g);
+         __m128i* pOutHigh = (__m128i*)(pData + 64*(k+4) + 16*g);
+         _mm_storeu_si128(pOutLow, _mm_xor_si128(_mm_loadu_si128(pOutLow), _mm256_castsi256_si128(r[k])));
+         _mm_storeu_si128(pOutHigh, _mm_xor_si128(_mm_loadu_si128(pOutHigh), _mm256_extracti128_si256(r[k], 1)));
+      }
+   }
+}
+
+static void _aead_chacha20_xor_avx2(u32* pState, u8* pData, int iLength)
+{
+   while ( iLength >= 512 )
+   {
+      _aead_chacha20_8blocks_avx2(pState, pData);
+      pState[12] += 8;
+      pData += 512;
+      iLength -= 512;
+   }
+   // A last 8 blocks pass costs about the same as a 4 blocks one
+   if ( iLength > 256 )
+   {
+      u8 uBuffer[512];
+      memcpy(uBuffer, pData, iLength);
+      _aead_chacha20_8blocks_avx2(pState, uBuffer);
+      memcpy(pData, uBuffer, iLength);
+      pState[12] += (iLength + 63)/64;
+   }
+   else if ( iLength > 0 )
+      _aead_chacha20_xor_sse2(pState, pData, iLength);
+}
+
+#endif
+
+#ifdef AEAD_HAS_NEON
+
+#define AEAD_NEON_ROTL(v, n) vsriq_n_u32(vshlq_n_u32(v, n), v, 32 - (n))
+#define AEAD_NEON_ROTL16(v) vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(v)))
+
+#define AEAD_NEON_QUARTER_ROUND(a, b, c, d) \
+   a = vaddq_u32(a, b); d = veorq_u32(d, a); d = AEAD_NEON_ROTL16(d); \
+   c = vaddq_u32(c, d); b = veorq_u32(b, c); b = AEAD_NEON_ROTL(b, 12); \
+   a = vaddq_u32(a, b); d = veorq_u32(d, a); d = AEAD_NEON_ROTL(d, 8); \
+   c = vaddq_u32(c, d); b = veorq_u32(b, c); b = AEAD_NEON_ROTL(b, 7);
+
+static void _aead_chacha20_4blocks_neon(const u32* pState, u8* pData)
+{
+   static const u32 s_uCounterOffsets[4] = { 0, 1, 2, 3 };
+   uint32x4_t x[16];
+   uint32x4_t s[16];
+   for( int i=0; i<16; i++ )
+      s[i] = vdupq_n_u32(pState[i]);
+   s[12] = vaddq_u32(s[12], vld1q_u32(s_uCounterOffsets));
+   for( int i=0; i<16; i++ )
+      x[i] = s[i];
+
+   for( int i=0; i<10; i++ )
+   {
+      AEAD_NEON_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+      AEAD_NEON_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+      AEAD_NEON_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+      AEAD_NEON_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+      AEAD_NEON_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+      AEAD_NEON_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+      AEAD_NEON_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+      AEAD_NEON_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+   }
+
+   for( int g=0; g<4; g++ )
+   {
+      uint32x4x2_t ab = vtrnq_u32(vaddq_u32(x[4*g], s[4*g]), vaddq_u32(x[4*g+1], s[4*g+1]));
+      uint32x4x2_t cd = vtrnq_u32(vaddq_u32(x[4*g+2], s[4*g+2]), vaddq_u32(x[4*g+3], s[4*g+3]));
+      uint32x4_t r[4];
+      r[0] = vcombine_u32(vget_low_u32(ab.val[0]), vget_low_u32(cd.val[0]));
+      r[1] = vcombine_u32(vget_low_u32(ab.val[1]), vget_low_u32(cd.val[1]));
+      r[2] = vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0]));
+      r[3] = vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1]));
+      for( int k=0; k<4; k++ )
+      {
+         u8* pOut = pData + 64*k + 16*g;
+         vst1q_u8(pOut, veorq_u8(vld1q_u8(pOut), vreinterpretq_u8_u32(r[k])));
+      }
+   }
+}
+
+static void _aead_chacha20_xor_neon(u32* pState, u8* pData, int iLength)
+{
+   while ( iLength >= 256 )
+   {
+      _aead_chacha20_4blocks_neon(pState, pData);
+      pState[12] += 4;
+      pData += 256;
+      iLength -= 256;
+   }
+   if ( iLength > 0 )
+   {
+      u8 uBuffer[256];
+      memcpy(uBuffer, pData, iLength);
+      _aead_chacha20_4blocks_neon(pState, uBuffer);
+      memcpy(pData, uBuffer, iLength);
+      pState[12] += (iLength + 63)/64;
+   }
+}
+
+#endif
+
+int aead_kernel_is_supported(int iKernel)
+{
+   if ( iKernel == AEAD_KERNEL_SCALAR )
+      return 1;
+   #ifdef AEAD_HAS_X86_SIMD
+   __builtin_cpu_init();
+   if ( iKernel == AEAD_KERNEL_SSE2 )
+      return __builtin_cpu_supports("sse2") ? 1 : 0;
+   if ( iKernel == AEAD_KERNEL_AVX2 )
+      return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse2")) ? 1 : 0;
+   #endif
+   #ifdef AEAD_HAS_NEON
+   if ( iKernel == AEAD_KERNEL_NEON )
+   {
+      #if defined(__aarch64__)
+      return 1;
+      #else
+      return (getauxval(AT_HWCAP) & HWCAP_NEON) ? 1 : 0;
+      #endif
+   }
+   #endif
+   return 0;
+}
+
+int aead_set_kernel(int iKernel)
+{
+   if ( ! aead_kernel_is_supported(iKernel) )
+      return 0;
+   s_pAEADChaCha20XorFunction = _aead_chacha20_xor_scalar;
+   #ifdef AEAD_HAS_X86_SIMD
+   if ( iKernel == AEAD_KERNEL_SSE2 )
+      s_pAEADChaCha20XorFunction = _aead_chacha20_xor_sse2;
+   if ( iKernel == AEAD_KERNEL_AVX2 )
+      s_pAEADChaCha20XorFunction = _aead_chacha20_xor_avx2;
+   #endif
+   #ifdef AEAD_HAS_NEON
+   if ( iKernel == AEAD_KERNEL_NEON )
+      s_pAEADChaCha20XorFunction = _aead_chacha20_xor_neon;
+   #endif
+   s_iAEADKernel = iKernel;
+   return 1;
+}
+
+static void _aead_select_default_kernel()
+{
+   if ( aead_set_kernel(AEAD_KERNEL_NEON) )
+      return;
+   if ( aead_set_kernel(AEAD_KERNEL_AVX2) )
+      return;
+   if ( aead_set_kernel(AEAD_KERNEL_SSE2) )
+      return;
+   aead_set_kernel(AEAD_KERNEL_SCALAR);
+}
+
+int aead_get_kernel()
+{
+   if ( s_iAEADKernel < 0 )
+      _aead_select_default_kernel();
+   return s_iAEADKernel;
+}
+
+const char* aead_get_kernel_name(int iKernel)
+{
+   switch ( iKernel )
+   {
+      case AEAD_KERNEL_SCALAR: return "scalar";
+      case AEAD_KERNEL_SSE2: return "sse2";
+      case AEAD_KERNEL_NEON: return "neon";
+      case AEAD_KERNEL_AVX2: return "avx2";
+   }
+   return "unknown";
+}
+
+static void _aead_chacha20_xor(u32* pState, u8* pData, int iLength)
+{
+   if ( NULL == s_pAEADChaCha20XorFunction )
+      _aead_select_default_kernel();
+   (*s_pAEADChaCha20XorFunction)(pState, pData, iLength);
+}
+
+void aead_chacha20_xor(const u8* pKey, const u8* pNonce, u32 uCounter, u8* pData, int iLength)
+{
+   if ( (NULL == pData) || (iLength <= 0) )
+      return;
+   u32 uState[16];
+   _aead_chacha20_init_state(uState, pKey, pNonce, uCounter);
+   _aead_chacha20_xor(uState, pData, iLength);
+}
+
+void aead_hchacha20(const u8* pKey, const u8* pInput, u8* pOutput)
+{
+   u32 x[16];
+   _aead_chacha20_init_state(x, pKey, pInput + 4, _aead_load32(pInput));
+   _aead_chacha20_rounds(x);
+   for( int i=0; i<4; i++ )
+   {
+      _aead_store32(pOutput + 4*i, x[i]);
+      _aead_store32(pOutput + 16 + 4*i, x[12+i]);
+   }
+}
+
+// Poly1305 with two 64 bits limbs on 64 bits CPUs (64x64 bits multiplications), 26 bits limbs otherwise
+
+#if defined(__SIZEOF_INT128__)
+
+typedef unsigned __int128 t_aead_u128;
+
+typedef struct
+{
+   unsigned long long r[2];
+   unsigned long long h[3];
+   unsigned long long pad[2];
+} t_aead_poly1305_state;
+
+// Carry out of a + b, where uSum = a + b, without branches
+#define AEAD_CARRY64(uSum, b) (((uSum) < (b)) ? 1ULL : 0ULL)
+
+static unsigned long long _aead_load64(const u8* pData)
+{
+   return ((unsigned long long)_aead_load32(pData)) | (((unsigned long long)_aead_load32(pData + 4)) << 32);
+}
+
+static void _aead_poly1305_init(t_aead_poly1305_state* pState, const u8* pKey)
+{
+   pState->r[0] = _aead_load64(pKey) & 0x0ffffffc0fffffffULL;
+   pState->r[1] = _aead_load64(pKey + 8) & 0x0ffffffc0ffffffcULL;
+   pState->h[0] = pState->h[1] = pState->h[2] = 0;
+   pState->pad[0] = _aead_load64(pKey + 16);
+   pState->pad[1] = _aead_load64(pKey + 24);
+}
+
+// iLength must be a multiple of 16. uHiBit is 0 only for the last, padded, block of a message.
+// h is kept partially reduced (h2 is a few bits) between blocks; r1 is a multiple of 4, so h1*r1*2^128 folds as h1*(r1 + r1/4).
+static void _aead_poly1305_blocks(t_aead_poly1305_state* pState, const u8* pData, int iLength, u32 uHiBit)
+{
+   const unsigned long long uHiBit64 = uHiBit ? 1 : 0;
+   const unsigned long long r0 = pState->r[0], r1 = pState->r[1];
+   const unsigned long long s1 = r1 + (r1 >> 2);
+   unsigned long long h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2];
+
+   while ( iLength >= 16 )
+   {
+      t_aead_u128 d0 = (t_aead_u128)h0 + _aead_load64(pData);
+      h0 = (unsigned long long)d0;
+      t_aead_u128 d1 = (t_aead_u128)h1 + (unsigned long long)(d0 >> 64) + _aead_load64(pData + 8);
+      h1 = (unsigned long long)d1;
+      h2 += (unsigned long long)(d1 >> 64) + uHiBit64;
+
+      d0 = ((t_aead_u128)h0 * r0) + ((t_aead_u128)h1 * s1);
+      d1 = ((t_aead_u128)h0 * r1) + ((t_aead_u128)h1 * r0) + ((t_aead_u128)h2 * s1);
+      h2 = h2 * r0;
+
+      h0 = (unsigned long long)d0;
+      d1 += (unsigned long long)(d0 >> 64);
+      h1 = (unsigned long long)d1;
+      h2 += (unsigned long long)(d1 >> 64);
+
+      // Fold the bits above 2^130 back in: 2^130 = 5 mod p
+      unsigned long long c = (h2 >> 2) + (h2 & ~3ULL);
+      h2 &= 3;
+      h0 += c;
+      c = AEAD_CARRY64(h0, c);
+      h1 += c;
+      h2 += AEAD_CARRY64(h1, c);
+
+      pData += 16;
+      iLength -= 16;
+   }
+   pState->h[0] = h0; pState->h[1] = h1; pState->h[2] = h2;
+}
+
+static void _aead_poly1305_finish(t_aead_poly1305_state* pState, u8* pTag)
+{
+   unsigned long long h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2];
+
+   // g = h + 5, used if h >= p (g has bit 130 set)
+   t_aead_u128 t = (t_aead_u128)h0 + 5;
+   unsigned long long g0 = (unsigned long long)t;
+   t = (t_aead_u128)h1 + (unsigned long long)(t >> 64);
+   unsigned long long g1 = (unsigned long long)t;
+   unsigned long long g2 = h2 + (unsigned long long)(t >> 64);
+
+   unsigned long long uMask = 0 - (g2 >> 2);
+   g0 &= uMask; g1 &= uMask;
+   uMask = ~uMask;
+   h0 = (h0 & uMask) | g0;
+   h1 = (h1 & uMask) | g1;
+
+   t = (t_aead_u128)h0 + pState->pad[0];
+   h0 = (unsigned long long)t;
+   h1 = h1 + pState->pad[1] + (unsigned long long)(t >> 64);
+
+   _aead_store32(pTag + 0, (u32)h0);
+   _aead_store32(pTag + 4, (u32)(h0 >> 32));
+   _aead_store32(pTag + 8, (u32)h1);
+   _aead_store32(pTag + 12, (u32)(h1 >> 32));
+}
+
+#else
+
+typedef struct
+{
+   u32 r[5];
+   u32 h[5];
+   u32 pad[4];
+} t_aead_poly1305_state;
+
+static void _aead_poly1305_init(t_aead_poly1305_state* pState, const u8* pKey)
+{
+   pState->r[0] = (_aead_load32(pKey + 0)) & 0x3ffffff;
+   pState->r[1] = (_aead_load32(pKey + 3) >> 2) & 0x3ffff03;
+   pState->r[2] = (_aead_load32(pKey + 6) >> 4) & 0x3ffc0ff;
+   pState->r[3] = (_aead_load32(pKey + 9) >> 6) & 0x3f03fff;
+   pState->r[4] = (_aead_load32(pKey + 12) >> 8) & 0x00fffff;
+   for( int i=0; i<5; i++ )
+      pState->h[i] = 0;
+   for( int i=0; i<4; i++ )
+      pState->pad[i] = _aead_load32(pKey + 16 + 4*i);
+}
+
+// iLength must be a multiple of 16. uHiBit is 0 only for the last, padded, block of a message.
+static void _aead_poly1305_blocks(t_aead_poly1305_state* pState, const u8* pData, int iLength, u32 uHiBit)
+{
+   const u32 r0 = pState->r[0], r1 = pState->r[1], r2 = pState->r[2], r3 = pState->r[3], r4 = pState->r[4];
+   const u32 s1 = r1*5, s2 = r2*5, s3 = r3*5, s4 = r4*5;
+   u32 h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2], h3 = pState->h[3], h4 = pState->h[4];
+
+   while ( iLength >= 16 )
+   {
+      h0 += (_aead_load32(pData + 0)) & 0x3ffffff;
+      h1 += (_aead_load32(pData + 3) >> 2) & 0x3ffffff;
+      h2 += (_aead_load32(pData + 6) >> 4) & 0x3ffffff;
+      h3 += (_aead_load32(pData + 9) >> 6) & 0x3ffffff;
+      h4 += (_aead_load32(pData + 12) >> 8) | uHiBit;
+
+      unsigned long long d0 = ((unsigned long long)h0 * r0) + ((unsigned long long)h1 * s4) + ((unsigned long long)h2 * s3) + ((unsigned long long)h3 * s2) + ((unsigned long long)h4 * s1);
+      unsigned long long d1 = ((unsigned long long)h0 * r1) + ((unsigned long long)h1 * r0) + ((unsigned long long)h2 * s4) + ((unsigned long long)h3 * s3) + ((unsigned long long)h4 * s2);
+      unsigned long long d2 = ((unsigned long long)h0 * r2) + ((unsigned long long)h1 * r1) + ((unsigned long long)h2 * r0) + ((unsigned long long)h3 * s4) + ((unsigned long long)h4 * s3);
+      unsigned long long d3 = ((unsigned long long)h0 * r3) + ((unsigned long long)h1 * r2) + ((unsigned long long)h2 * r1) + ((unsigned long long)h3 * r0) + ((unsigned long long)h4 * s4);
+      unsigned long long d4 = ((unsigned long long)h0 * r4) + ((unsigned long long)h1 * r3) + ((unsigned long long)h2 * r2) + ((unsigned long long)h3 * r1) + ((unsigned long long)h4 * r0);
+
+      u32 c = (u32)(d0 >> 26); h0 = (u32)d0 & 0x3ffffff;
+      d1 += c; c = (u32)(d1 >> 26); h1 = (u32)d1 & 0x3ffffff;
+      d2 += c; c = (u32)(d2 >> 26); h2 = (u32)d2 & 0x3ffffff;
+      d3 += c; c = (u32)(d3 >> 26); h3 = (u32)d3 & 0x3ffffff;
+      d4 += c; c = (u32)(d4 >> 26); h4 = (u32)d4 & 0x3ffffff;
+      h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+      h1 += c;
+
+      pData += 16;
+      iLength -= 16;
+   }
+   pState->h[0] = h0; pState->h[1] = h1; pState->h[2] = h2; pState->h[3] = h3; pState->h[4] = h4;
+}
+
+static void _aead_poly1305_finish(t_aead_poly1305_state* pState, u8* pTag)
+{
+   u32 h0 = pState->h[0], h1 = pState->h[1], h2 = pState->h[2], h3 = pState->h[3], h4 = pState->h[4];
+   u32 c;
+
+   c = h1 >> 26; h1 &= 0x3ffffff;
+   h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+   h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+   h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+   h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+   h1 += c;
+
+   // g = h + -p, used if h >= p
+   u32 g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+   u32 g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+   u32 g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+   u32 g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+   u32 g4 = h4 + c - (1 << 26);
+
+   u32 uMask = (g4 >> 31) - 1;
+   g0 &= uMask; g1 &= uMask; g2 &= uMask; g3 &= uMask; g4 &= uMask;
+   uMask = ~uMask;
+   h0 = (h0 & uMask) | g0;
+   h1 = (h1 & uMask) | g1;
+   h2 = (h2 & uMask) | g2;
+   h3 = (h3 & uMask) | g3;
+   h4 = (h4 & uMask) | g4;
+
+   h0 = h0 | (h1 << 26);
+   h1 = (h1 >> 6) | (h2 << 20);
+   h2 = (h2 >> 12) | (h3 << 14);
+   h3 = (h3 >> 18) | (h4 << 8);
+
+   unsigned long long f;
+   f = (unsigned long long)h0 + pState->pad[0]; h0 = (u32)f;
+   f = (unsigned long long)h1 + pState->pad[1] + (f >> 32); h1 = (u32)f;
+   f = (unsigned long long)h2 + pState->pad[2] + (f >> 32); h2 = (u32)f;
+   f = (unsigned long long)h3 + pState->pad[3] + (f >> 32); h3 = (u32)f;
+
+   _aead_store32(pTag + 0, h0);
+   _aead_store32(pTag + 4, h1);
+   _aead_store32(pTag + 8, h2);
+   _aead_store32(pTag + 12, h3);
+}
+
+#endif
+
+// Full blocks, then the remaining bytes zero padded to a full block (as used by the AEAD construction)
+static void _aead_poly1305_update_padded(t_aead_poly1305_state* pState, const u8* pData, int iLength)
+{
+   int iFullLength = iLength & (~15);
+   _aead_poly1305_blocks(pState, pData, iFullLength, 1 << 24);
+   if ( iLength > iFullLength )
+   {
+      u8 uBlock[16];
+      memset(uBlock, 0, sizeof(uBlock));
+      memcpy(uBlock, pData + iFullLength, iLength - iFullLength);
+      _aead_poly1305_blocks(pState, uBlock, 16, 1 << 24);
+   }
+}
+
+void aead_poly1305(const u8* pKey, const u8* pData, int iLength, u8* pTag)
+{
+   t_aead_poly1305_state state;
+   _aead_poly1305_init(&state, pKey);
+   int iFullLength = iLength & (~15);
+   _aead_poly1305_blocks(&state, pData, iFullLength, 1 << 24);
+   if ( iLength > iFullLength )
+   {
+      u8 uBlock[16];
+      memset(uBlock, 0, sizeof(uBlock));
+      memcpy(uBlock, pData + iFullLength, iLength - iFullLength);
+      uBlock[iLength - iFullLength] = 1;
+      _aead_poly1305_blocks(&state, uBlock, 16, 0);
+   }
+   _aead_poly1305_finish(&state, pTag);
+}
+
+// Computes the one time Poly1305 key (block 0) and leaves the state at block 1, for the data
+static void _aead_init(u32* pState, u8* pPolyKey, const u8* pKey, const u8* pNonce)
+{
+   _aead_chacha20_init_state(pState, pKey, pNonce, 0);
+   memset(pPolyKey, 0, 64);
+   _aead_chacha20_xor_scalar(pState, pPolyKey, 64);
+}
+
+static void _aead_compute_tag(const u8* pPolyKey, const u8* pAAD, int iAADLength, const u8* pData, int iLength, u8* pTag)
+{
+   t_aead_poly1305_state state;
+   u8 uLengths[16];
+   _aead_poly1305_init(&state, pPolyKey);
+   _aead_poly1305_update_padded(&state, pAAD, iAADLength);
+   _aead_poly1305_update_padded(&state, pData, iLength);
+   _aead_store32(uLengths, (u32)iAADLength);
+   _aead_store32(uLengths + 4, 0);
+   _aead_store32(uLengths + 8, (u32)iLength);
+   _aead_store32(uLengths + 12, 0);
+   _aead_poly1305_blocks(&state, uLengths, 16, 1 << 24);
+   _aead_poly1305_finish(&state, pTag);
+}
+
+void aead_seal(const u8* pKey, const u8* pNonce, const u8* pAAD, int iAADLength, u8* pData, int iLength, u8* pTag)
+{
+   u32 uState[16];
+   u8 uPolyKey[64];
+   if ( iAADLength < 0 )
+      iAADLength = 0;
+   if ( iLength < 0 )
+      iLength = 0;
+   _aead_init(uState, uPolyKey, pKey, pNonce);
+   if ( iLength > 0 )
+      _aead_chacha20_xor(uState, pData, iLength);
+   _aead_compute_tag(uPolyKey, pAAD, iAADLength, pData, iLength, pTag);
+}
+
+int aead_open(const u8* pKey, const u8* pNonce, const u8* pAAD, int iAADLength, u8* pData, int iLength, const u8* pTag)
+{
+   u32 uState[16];
+   u8 uPolyKey[64];
+   u8 uTag[AEAD_TAG_SIZE];
+   if ( (iAADLength < 0) || (iLength < 0) )
+      return 0;
+   _aead_init(uState, uPolyKey, pKey, pNonce);
+   _aead_compute_tag(uPolyKey, pAAD, iAADLength, pData, iLength, uTag);
+
+   u8 uDiff = 0;
+   for( int i=0; i<AEAD_TAG_SIZE; i++ )
+      uDiff |= uTag[i] ^ pTag[i];
+   if ( 0 != uDiff )
+      return 0;
+
+   if ( iLength > 0 )
+      _aead_chacha20_xor(uState, pData, iLength);
+   return 1;
+}
@@ -0,0 +1,74 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+#include "base.h"
+
+// ChaCha20-Poly1305 authenticated encryption (RFC 8439).
+// The ChaCha20 keystream is computed 4 blocks at a time with SSE2 or NEON (8 with AVX2) when the CPU supports it,
+// the scalar version is always available as a fallback and as the reference.
+
+#define AEAD_KEY_SIZE 32
+#define AEAD_NONCE_SIZE 12
+#define AEAD_TAG_SIZE 16
+
+#define AEAD_KERNEL_SCALAR 0
+#define AEAD_KERNEL_SSE2 1
+#define AEAD_KERNEL_NEON 2
+#define AEAD_KERNEL_AVX2 3
+#define AEAD_KERNELS_COUNT 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int aead_kernel_is_supported(int iKernel);
+// Returns 0 if the kernel is not supported on this CPU. The fastest supported kernel is used by default.
+int aead_set_kernel(int iKernel);
+int aead_get_kernel();
+const char* aead_get_kernel_name(int iKernel);
+
+// XORs the data with the ChaCha20 keystream, starting at block uCounter
+void aead_chacha20_xor(const u8* pKey, const u8* pNonce, u32 uCounter, u8* pData, int iLength);
+// HChaCha20: derives a 32 bytes output from a key and a 16 bytes input
+void aead_hchacha20(const u8* pKey, const u8* pInput, u8* pOutput);
+void aead_poly1305(const u8* pKey, const u8* pData, int iLength, u8* pTag);
+
+// Encrypts the data in place and computes the tag over the additional data and the encrypted data
+void aead_seal(const u8* pKey, const u8* pNonce, const u8* pAAD, int iAADLength, u8* pData, int iLength, u8* pTag);
+// Checks the tag and decrypts the data in place. Returns 0 (and leaves the data unchanged) if the tag is not valid.
+int aead_open(const u8* pKey, const u8* pNonce, const u8* pAAD, int iAADLength, u8* pData, int iLength, const u8* pTag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -45,6 +45,7 @@
 
 #define VIDEO_STATUS_FLAGS2_HAS_DEBUG_TIMESTAMPS ((u32)(((u32)0x01)<<8))
 #define VIDEO_STATUS_FLAGS2_IS_ON_LOWER_BITRATE ((u32)(((u32)0x01)<<10))
+#define VIDEO_STATUS_FLAGS2_SUPPORTS_COMPACT_RETR_REQUESTS ((u32)(((u32)0x01)<<16))
 
 #define VIDEO_PACKET_FLAGS_IS_END_OF_TRANSMISSION_FRAME ((u32)(((u32)0x01)<<2))
 #define VIDEO_PACKET_FLAGS_CONTAINS_I_NAL ((u32)(((u32)0x01)<<3))
@@ -450,6 +450,7 @@ int init_hardware_only_status_led()
 
 void hardware_reboot()
 {
+   log_flush();
    hardware_sleep_ms(200);
    hw_execute_bash_command("sync", NULL);
    hardware_sleep_sec(1);
@@ -32,6 +32,7 @@
 
 #include "base.h"
 #include "hardware_cam_maj.h"
+#include "hardware_cam_maj_http.h"
 #include "hw_procs.h"
 #include "../common/string_utils.h"
 #include <math.h>
@@ -62,15 +63,6 @@ static u32 s_uTempMajesticContrast = MAX_U32;
 static u32 s_uTempMajesticHue = MAX_U32;
 static u32 s_uTempMajesticSaturation = MAX_U32;
 
-pthread_t s_ThreadMajSetBrightness;
-pthread_t s_ThreadMajSetContrast;
-pthread_t s_ThreadMajSetHue;
-pthread_t s_ThreadMajSetStaturation;
-volatile bool s_bMajThreadSetBrightnessRunning = false;
-volatile bool s_bMajThreadSetContrastRunning = false;
-volatile bool s_bMajThreadSetHueRunning = false;
-volatile bool s_bMajThreadSetSaturationRunning = false;
-
 pthread_t s_ThreadMajSetImageParams;
 volatile bool s_bMajThreadSetImageParamsRunning = false;
 static u32 s_uMajesticHasPendingCachedImageChangesTime = 0;
@@ -84,21 +76,12 @@ volatile bool s_bMajThreadSetAllParamsRunning = false;
 
 static float s_fCurrentMajesticGOP = -1.0;
 static float s_fTemporaryMajesticGOP = -1.0;
-pthread_t s_ThreadMajSetGOP;
-volatile bool s_bMajThreadSetGOPRunning = false;
 
 static u32 s_uCurrentMajesticBitrate = 0;
 static u32 s_uTemporaryMajesticBitrate = 0;
-pthread_t s_ThreadMajSetBitrate;
-volatile bool s_bMajThreadSetBitrateRunning = false;
 
 static int s_iCurrentMajesticQPDelta = -1000;
 static int s_iTemporaryMajesticQPDelta = -1000;
-pthread_t s_ThreadMajSetQPDelta;
-volatile bool s_bMajThreadSetQPDeltaRunning = false;
-
-pthread_t s_ThreadMajSetBitrateQPDelta;
-volatile bool s_bMajThreadSetBitrateQPDeltaRunning = false;
 
 static int s_iCurrentMajAudioVolume = 0;
 static int s_iCurrentMajAudioBitrate = 0;
@@ -762,17 +745,8 @@ void hardware_camera_maj_set_daylight_off(int iDLOff)
    pthread_attr_destroy(&attr);
 }
 
-void* _thread_majestic_set_brightness(void *argument)
-{
-   s_bMajThreadSetBrightnessRunning = true;
-   log_line("[HwCamMajestic] Started thread to set brightness...");
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?image.luminance=%u", s_uTempMajesticBrightness);
-   hw_execute_bash_command_raw(szComm, NULL);
-   s_bMajThreadSetBrightnessRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set brightness.");
-   return NULL; 
-}
+// Runtime changes go through the keep-alive HTTP client (hardware_cam_maj_http), which sends
+// them from a single worker and coalesces changes queued while a request is in flight.
 
 void hardware_camera_maj_set_brightness(u32 uValue)
 {
@@ -780,40 +754,9 @@ void hardware_camera_maj_set_brightness(u32 uValue)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetBrightnessRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set brightness is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetBrightness);
-   }
-
    s_uTempMajesticBrightness = uValue;
    s_uMajesticHasPendingCachedImageChangesTime = get_current_timestamp_ms();
-
-   s_bMajThreadSetBrightnessRunning = true;
-   pthread_attr_t attr;
-   _adjust_thread_priority_attrs(&attr);
-   if ( 0 != pthread_create(&s_ThreadMajSetBrightness, &attr, &_thread_majestic_set_brightness, NULL) )
-   {
-      s_bMajThreadSetBrightnessRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set brightness manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?image.luminance=%u", s_uTempMajesticBrightness);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_contrast(void *argument)
-{
-   s_bMajThreadSetContrastRunning = true;
-   log_line("[HwCamMajestic] Started thread to set contrast...");
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?image.contrast=%u", s_uTempMajesticContrast);
-   hw_execute_bash_command_raw(szComm, NULL);
-   s_bMajThreadSetContrastRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set contrast.");
-   return NULL; 
+   hardware_camera_maj_http_set_param_u32("image.luminance", s_uTempMajesticBrightness);
 }
 
 void hardware_camera_maj_set_contrast(u32 uValue)
@@ -822,40 +765,9 @@ void hardware_camera_maj_set_contrast(u32 uValue)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetContrastRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set contrast is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetContrast);
-   }
-
    s_uTempMajesticContrast = uValue;
    s_uMajesticHasPendingCachedImageChangesTime = get_current_timestamp_ms();
-
-   s_bMajThreadSetContrastRunning = true;
-   pthread_attr_t attr;
-   _adjust_thread_priority_attrs(&attr);
-   if ( 0 != pthread_create(&s_ThreadMajSetContrast, &attr, &_thread_majestic_set_contrast, NULL) )
-   {
-      s_bMajThreadSetContrastRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set contrast manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?image.contrast=%u", s_uTempMajesticContrast);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_hue(void *argument)
-{
-   s_bMajThreadSetHueRunning = true;
-   log_line("[HwCamMajestic] Started thread to set hue...");
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?image.hue=%u", s_uTempMajesticHue);
-   hw_execute_bash_command_raw(szComm, NULL);
-   s_bMajThreadSetHueRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set hue.");
-   return NULL; 
+   hardware_camera_maj_http_set_param_u32("image.contrast", s_uTempMajesticContrast);
 }
 
 void hardware_camera_maj_set_hue(u32 uValue)
@@ -864,40 +776,9 @@ void hardware_camera_maj_set_hue(u32 uValue)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetHueRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set hue is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetHue);
-   }
-
    s_uTempMajesticHue = uValue;
    s_uMajesticHasPendingCachedImageChangesTime = get_current_timestamp_ms();
-
-   s_bMajThreadSetHueRunning = true;
-   pthread_attr_t attr;
-   _adjust_thread_priority_attrs(&attr);
-   if ( 0 != pthread_create(&s_ThreadMajSetHue, &attr, &_thread_majestic_set_hue, NULL) )
-   {
-      s_bMajThreadSetHueRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set hue manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?image.hue=%u", s_uTempMajesticHue);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_saturation(void *argument)
-{
-   s_bMajThreadSetSaturationRunning = true;
-   log_line("[HwCamMajestic] Started thread to set saturation...");
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?image.saturation=%u", s_uTempMajesticSaturation/2);
-   hw_execute_bash_command_raw(szComm, NULL);
-   s_bMajThreadSetSaturationRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set saturation.");
-   return NULL; 
+   hardware_camera_maj_http_set_param_u32("image.hue", s_uTempMajesticHue);
 }
 
 void hardware_camera_maj_set_saturation(u32 uValue)
@@ -906,28 +787,9 @@ void hardware_camera_maj_set_saturation(u32 uValue)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetSaturationRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set saturation is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetStaturation);
-   }
-
    s_uTempMajesticSaturation = uValue;
    s_uMajesticHasPendingCachedImageChangesTime = get_current_timestamp_ms();
-
-   s_bMajThreadSetSaturationRunning = true;
-   pthread_attr_t attr;
-   _adjust_thread_priority_attrs(&attr);
-   if ( 0 != pthread_create(&s_ThreadMajSetStaturation, &attr, &_thread_majestic_set_saturation, NULL) )
-   {
-      s_bMajThreadSetSaturationRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set hue manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?image.saturation=%u", s_uTempMajesticSaturation/2);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   pthread_attr_destroy(&attr);
+   hardware_camera_maj_http_set_param_u32("image.saturation", s_uTempMajesticSaturation/2);
 }
 
 void hardware_camera_maj_clear_temp_values()
@@ -938,18 +800,6 @@ void hardware_camera_maj_clear_temp_values()
    log_line("[HwCamMajestic] Cleared temp runtime values.");
 }
 
-void* _thread_majestic_set_temp_gop(void *argument)
-{
-   s_bMajThreadSetGOPRunning = true;
-   log_line("[HwCamMajestic] Started thread to set GOP to %.1f ...", s_fTemporaryMajesticGOP);
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?video0.gopSize=%.1f", s_fTemporaryMajesticGOP);
-   hw_execute_bash_command_raw(szComm, NULL);
-   s_bMajThreadSetGOPRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set GOP.");
-   return NULL; 
-}
-
 void hardware_camera_maj_set_keyframe(float fGOP)
 {
    if ( (fabs(fGOP-s_fCurrentMajesticGOP)<0.0001) && (fabs(fGOP-s_fTemporaryMajesticGOP)<0.0001) )
@@ -960,45 +810,11 @@ void hardware_camera_maj_set_keyframe(float fGOP)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetGOPRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set GOP is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetGOP);
-   }
-
    s_fTemporaryMajesticGOP = fGOP;
 
-   s_bMajThreadSetGOPRunning = true;
-   //pthread_attr_t attr;
-   //_adjust_thread_priority_attrs(&attr);
-   //pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-   if ( 0 != pthread_create(&s_ThreadMajSetGOP, NULL, &_thread_majestic_set_temp_gop, NULL) )
-   {
-      s_bMajThreadSetGOPRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set GOP manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?video0.gopSize=%.1f", s_fTemporaryMajesticGOP);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   //pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_bitrate(void *argument)
-{
-   s_bMajThreadSetBitrateRunning = true;
-   u32 uBitrate = s_uCurrentMajesticBitrate;
-   if ( s_uTemporaryMajesticBitrate != 0 )
-      uBitrate = s_uTemporaryMajesticBitrate;
-   log_line("[HwCamMajestic] Started thread to set bitrate to %u bps ...", uBitrate);
-   
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?video0.bitrate=%u", uBitrate/1000);
-   hw_execute_bash_command_raw(szComm, NULL);
-
-   s_bMajThreadSetBitrateRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set bitrate.");
-   return NULL; 
+   char szValue[32];
+   sprintf(szValue, "%.1f", s_fTemporaryMajesticGOP);
+   hardware_camera_maj_http_set_param("video0.gopSize", szValue);
 }
 
 u32 hardware_camera_maj_get_current_bitrate()
@@ -1017,45 +833,8 @@ void hardware_camera_maj_set_bitrate(u32 uBitrate)
    if ( 0 == uBitrate )
       return;
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetBitrateRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set bitrate is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetBitrate);
-   }
-
    s_uTemporaryMajesticBitrate = uBitrate;
-   
-   s_bMajThreadSetBitrateRunning = true;
-   //pthread_attr_t attr;
-   //_adjust_thread_priority_attrs(&attr);
-   //pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-   if ( 0 != pthread_create(&s_ThreadMajSetBitrate, NULL, &_thread_majestic_set_bitrate, NULL) )
-   {
-      s_bMajThreadSetBitrateRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set bitrate manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?video0.bitrate=%u", s_uTemporaryMajesticBitrate/1000);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   //pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_qpdelta(void *argument)
-{
-   s_bMajThreadSetQPDeltaRunning = true;
-   int iQPDelta = s_iCurrentMajesticQPDelta;
-   if ( s_iTemporaryMajesticQPDelta > -100 )
-      iQPDelta = s_iTemporaryMajesticQPDelta;
-   log_line("[HwCamMajestic] Started thread to set QP delta to %d ...", iQPDelta);
-   
-   char szComm[128];
-   sprintf(szComm, "curl -s localhost/api/v1/set?video0.qpDelta=%d", iQPDelta);
-   hw_execute_bash_command_raw(szComm, NULL);
-
-   s_bMajThreadSetQPDeltaRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set QP delta.");
-   return NULL; 
+   hardware_camera_maj_http_set_param_u32("video0.bitrate", s_uTemporaryMajesticBitrate/1000);
 }
 
 int hardware_camera_maj_get_current_qpdelta()
@@ -1073,53 +852,8 @@ void hardware_camera_maj_set_qpdelta(int iQPDelta)
       return;
 
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
-
-   if ( s_bMajThreadSetQPDeltaRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set qp delta is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetQPDelta);
-   }
-
    s_iTemporaryMajesticQPDelta = iQPDelta;
-   
-   s_bMajThreadSetQPDeltaRunning = true;
-   //pthread_attr_t attr;
-   //_adjust_thread_priority_attrs(&attr);
-   //pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-   if ( 0 != pthread_create(&s_ThreadMajSetQPDelta, NULL, &_thread_majestic_set_qpdelta, NULL) )
-   {
-      s_bMajThreadSetQPDeltaRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set qp delta manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?video0.qpDelta=%d", iQPDelta);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   //pthread_attr_destroy(&attr);
-}
-
-void* _thread_majestic_set_bitrate_qpdelta(void *argument)
-{
-   s_bMajThreadSetBitrateQPDeltaRunning = true;
-   u32 uBitrate = s_uCurrentMajesticBitrate;
-   if ( s_uTemporaryMajesticBitrate != 0 )
-      uBitrate = s_uTemporaryMajesticBitrate;
-   int iQPDelta = s_iCurrentMajesticQPDelta;
-   if ( s_iTemporaryMajesticQPDelta > -100 )
-      iQPDelta = s_iTemporaryMajesticQPDelta;
-
-   log_line("[HwCamMajestic] Started thread to set bitrate to %u bps and QP delta to %d ...", uBitrate, iQPDelta);
-   
-   char szComm[128];
-   
-   sprintf(szComm, "curl -s localhost/api/v1/set?video0.bitrate=%u", uBitrate/1000);
-   hw_execute_bash_command_raw(szComm, NULL);
-
-   sprintf(szComm, "curl -s localhost/api/v1/set?video0.qpDelta=%d", iQPDelta);
-   hw_execute_bash_command_raw(szComm, NULL);
-
-   s_bMajThreadSetBitrateQPDeltaRunning = false;
-   log_line("[HwCamMajestic] Finished thread to set bitrate and QP delta.");
-   return NULL; 
+   hardware_camera_maj_http_set_param_int("video0.qpDelta", s_iTemporaryMajesticQPDelta);
 }
 
 void hardware_camera_maj_set_bitrate_and_qpdelta(u32 uBitrate, int iQPDelta)
@@ -1155,30 +889,12 @@ void hardware_camera_maj_set_bitrate_and_qpdelta(u32 uBitrate, int iQPDelta)
    }
    s_uMajesticLastChangeTime = get_current_timestamp_ms();
 
-   if ( s_bMajThreadSetBitrateQPDeltaRunning )
-   {
-      log_softerror_and_alarm("[HwCamMajestic] Another thread to set bitrate and qp delta is running. Stop it.");
-      pthread_cancel(s_ThreadMajSetBitrateQPDelta);
-   }
-
    s_uTemporaryMajesticBitrate = uBitrate;
    s_iTemporaryMajesticQPDelta = iQPDelta;
-   
-   s_bMajThreadSetBitrateQPDeltaRunning = true;
-   //pthread_attr_t attr;
-   //_adjust_thread_priority_attrs(&attr);
-   //pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-   if ( 0 != pthread_create(&s_ThreadMajSetBitrateQPDelta, NULL, &_thread_majestic_set_bitrate_qpdelta, NULL) )
-   {
-      s_bMajThreadSetBitrateQPDeltaRunning = false;
-      log_softerror_and_alarm("[HwCamMajestic] Can't create thread. Set bitrate and qp delta manualy.");
-      char szComm[128];
-      sprintf(szComm, "curl -s localhost/api/v1/set?video0.bitrate=%u", s_uTemporaryMajesticBitrate/1000);
-      hw_execute_bash_command_raw(szComm, NULL);
-      sprintf(szComm, "curl -s localhost/api/v1/set?video0.qpDelta=%d", s_iTemporaryMajesticQPDelta);
-      hw_execute_bash_command_raw(szComm, NULL);
-   }
-   //pthread_attr_destroy(&attr);
+
+   // Both go out in the same request
+   hardware_camera_maj_http_set_param_u32("video0.bitrate", s_uTemporaryMajesticBitrate/1000);
+   hardware_camera_maj_http_set_param_int("video0.qpDelta", s_iTemporaryMajesticQPDelta);
 }
 
 
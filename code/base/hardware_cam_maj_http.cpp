@@ -0,0 +1,499 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "base.h"
+#include "hardware_cam_maj_http.h"
+#include <pthread.h>
+#include <time.h>
+#include <poll.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+typedef struct
+{
+   char szParam[48];
+   char szValue[32];
+   int iRetries;
+} t_maj_http_param;
+
+static pthread_mutex_t s_MajHttpMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_MajHttpCondition = PTHREAD_COND_INITIALIZER;
+static pthread_t s_MajHttpThread;
+static bool s_bMajHttpThreadStarted = false;
+static bool s_bMajHttpStop = false;
+static bool s_bMajHttpRequestInFlight = false;
+
+static char s_szMajHttpHost[64] = MAJ_HTTP_DEFAULT_HOST;
+static int s_iMajHttpPort = MAJ_HTTP_DEFAULT_PORT;
+static int s_iMajHttpSocket = -1;
+
+static t_maj_http_param s_MajHttpPendingParams[MAJ_HTTP_MAX_PENDING_PARAMS];
+static int s_iMajHttpPendingParamsCount = 0;
+static long long s_llMajHttpPendingSinceMicros = 0;
+
+static t_maj_http_stats s_MajHttpStats;
+static long long s_llMajHttpTotalLatencyMicros = 0;
+
+static long long _maj_http_now_micros()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return ((long long)t.tv_sec) * 1000000LL + (long long)(t.tv_nsec/1000);
+}
+
+static void _maj_http_close_connection()
+{
+   if ( s_iMajHttpSocket >= 0 )
+      close(s_iMajHttpSocket);
+   s_iMajHttpSocket = -1;
+}
+
+static bool _maj_http_open_connection()
+{
+   if ( s_iMajHttpSocket >= 0 )
+      return true;
+
+   struct sockaddr_in addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(s_iMajHttpPort);
+   if ( 1 != inet_pton(AF_INET, s_szMajHttpHost, &addr.sin_addr) )
+   {
+      log_softerror_and_alarm("[HwCamMajHttp] Invalid host address: %s", s_szMajHttpHost);
+      return false;
+   }
+
+   int iSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if ( iSocket < 0 )
+      return false;
+   int iFlag = 1;
+   setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iFlag, sizeof(iFlag));
+   struct timeval tv;
+   tv.tv_sec = MAJ_HTTP_TIMEOUT_MS/1000;
+   tv.tv_usec = (MAJ_HTTP_TIMEOUT_MS%1000)*1000;
+   setsockopt(iSocket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+   if ( 0 != connect(iSocket, (struct sockaddr*)&addr, sizeof(addr)) )
+   {
+      log_softerror_and_alarm("[HwCamMajHttp] Failed to connect to %s:%d, error: %s", s_szMajHttpHost, s_iMajHttpPort, strerror(errno));
+      close(iSocket);
+      return false;
+   }
+   s_iMajHttpSocket = iSocket;
+   s_MajHttpStats.uConnectionsOpened++;
+   log_line("[HwCamMajHttp] Connected to %s:%d", s_szMajHttpHost, s_iMajHttpPort);
+   return true;
+}
+
+// Returns number of bytes read, 0 on connection closed, -1 on error/timeout
+
+static int _maj_http_recv(char* pBuffer, int iMaxLength)
+{
+   struct pollfd fdPoll;
+   fdPoll.fd = s_iMajHttpSocket;
+   fdPoll.events = POLLIN;
+   fdPoll.revents = 0;
+   int iRes = poll(&fdPoll, 1, MAJ_HTTP_TIMEOUT_MS);
+   if ( iRes <= 0 )
+      return -1;
+   return recv(s_iMajHttpSocket, pBuffer, iMaxLength, 0);
+}
+
+// Reads the full response (headers and body) so the connection can be reused.
+// Returns the HTTP status code or -1 on failure.
+
+static int _maj_http_read_response()
+{
+   char szBuffer[2048];
+   int iLength = 0;
+   char* pBodyStart = NULL;
+   while ( NULL == pBodyStart )
+   {
+      if ( iLength >= (int)sizeof(szBuffer) - 1 )
+         return -1;
+      int iRead = _maj_http_recv(szBuffer + iLength, sizeof(szBuffer) - 1 - iLength);
+      if ( iRead <= 0 )
+         return -1;
+      iLength += iRead;
+      szBuffer[iLength] = 0;
+      pBodyStart = strstr(szBuffer, "\r\n\r\n");
+   }
+   pBodyStart += 4;
+   int iBodyBytes = iLength - (int)(pBodyStart - szBuffer);
+
+   int iStatus = -1;
+   if ( 0 == strncmp(szBuffer, "HTTP/1.", 7) )
+      iStatus = atoi(szBuffer + 9);
+
+   // Headers are matched case insensitive
+   for( char* p = szBuffer; p < pBodyStart; p++ )
+      *p = tolower(*p);
+
+   bool bKeepAlive = (NULL == strstr(szBuffer, "connection: close"));
+   if ( 0 == strncmp(szBuffer, "http/1.0", 8) )
+      bKeepAlive = (NULL != strstr(szBuffer, "connection: keep-alive"));
+
+   char* pContentLength = strstr(szBuffer, "content-length:");
+   if ( NULL != pContentLength )
+   {
+      int iContentLength = atoi(pContentLength + 15);
+      while ( iBodyBytes < iContentLength )
+      {
+         int iRead = _maj_http_recv(szBuffer, sizeof(szBuffer));
+         if ( iRead <= 0 )
+            return -1;
+         iBodyBytes += iRead;
+      }
+   }
+   else if ( NULL != strstr(szBuffer, "transfer-encoding: chunked") )
+   {
+      // Responses are small, just look for the last chunk
+      char szTail[8];
+      memset(szTail, 0, sizeof(szTail));
+      int iTailLength = (iBodyBytes < 5)?iBodyBytes:5;
+      memcpy(szTail, pBodyStart + iBodyBytes - iTailLength, iTailLength);
+      while ( (iTailLength < 5) || (0 != strcmp(szTail, "0\r\n\r\n")) )
+      {
+         int iRead = _maj_http_recv(szBuffer, sizeof(szBuffer));
+         if ( iRead <= 0 )
+            return -1;
+         for( int i=0; i<iRead; i++ )
+         {
+            if ( iTailLength == 5 )
+            {
+               memmove(szTail, szTail+1, 4);
+               iTailLength--;
+            }
+            szTail[iTailLength++] = szBuffer[i];
+            szTail[iTailLength] = 0;
+         }
+      }
+   }
+   else
+   {
+      // Body ends when the server closes the connection
+      while ( _maj_http_recv(szBuffer, sizeof(szBuffer)) > 0 );
+      bKeepAlive = false;
+   }
+
+   if ( ! bKeepAlive )
+      _maj_http_close_connection();
+   return iStatus;
+}
+
+static int _maj_http_send_request(const char* szRequest, int iLength)
+{
+   // A kept alive connection may have been closed by the server (i.e. majestic restarted), so retry once on a new connection
+   for( int iTry=0; iTry<2; iTry++ )
+   {
+      if ( ! _maj_http_open_connection() )
+         return -1;
+      if ( send(s_iMajHttpSocket, szRequest, iLength, MSG_NOSIGNAL) != iLength )
+      {
+         _maj_http_close_connection();
+         continue;
+      }
+      int iStatus = _maj_http_read_response();
+      if ( iStatus > 0 )
+         return iStatus;
+      _maj_http_close_connection();
+   }
+   return -1;
+}
+
+// Called with the mutex locked, after a failed request
+
+static void _maj_http_requeue_failed_params(t_maj_http_param* pParams, int iCountParams)
+{
+   for( int i=0; i<iCountParams; i++ )
+   {
+      bool bReplaced = false;
+      for( int k=0; k<s_iMajHttpPendingParamsCount; k++ )
+      {
+         if ( 0 == strcmp(s_MajHttpPendingParams[k].szParam, pParams[i].szParam) )
+         {
+            bReplaced = true;
+            break;
+         }
+      }
+      if ( bReplaced )
+         continue;
+
+      if ( (pParams[i].iRetries >= MAJ_HTTP_MAX_RETRIES) || (s_iMajHttpPendingParamsCount >= MAJ_HTTP_MAX_PENDING_PARAMS) )
+      {
+         s_MajHttpStats.uParamsFailed++;
+         log_softerror_and_alarm("[HwCamMajHttp] Dropping %s=%s after %d retries.", pParams[i].szParam, pParams[i].szValue, pParams[i].iRetries);
+         continue;
+      }
+      if ( 0 == s_iMajHttpPendingParamsCount )
+         s_llMajHttpPendingSinceMicros = _maj_http_now_micros();
+      memcpy(&s_MajHttpPendingParams[s_iMajHttpPendingParamsCount], &pParams[i], sizeof(t_maj_http_param));
+      s_MajHttpPendingParams[s_iMajHttpPendingParamsCount].iRetries++;
+      s_iMajHttpPendingParamsCount++;
+      s_MajHttpStats.uParamsRequeued++;
+   }
+}
+
+// Called with the mutex locked. Returns early if the worker must stop.
+
+static void _maj_http_wait_retry_delay()
+{
+   struct timespec tDeadline;
+   clock_gettime(CLOCK_REALTIME, &tDeadline);
+   tDeadline.tv_nsec += (long)MAJ_HTTP_RETRY_DELAY_MS * 1000000L;
+   while ( tDeadline.tv_nsec >= 1000000000L )
+   {
+      tDeadline.tv_sec++;
+      tDeadline.tv_nsec -= 1000000000L;
+   }
+   while ( ! s_bMajHttpStop )
+   {
+      if ( 0 != pthread_cond_timedwait(&s_MajHttpCondition, &s_MajHttpMutex, &tDeadline) )
+         break;
+   }
+}
+
+static void* _thread_maj_http_worker(void *argument)
+{
+   log_line("[HwCamMajHttp] Started worker thread.");
+   t_maj_http_param params[MAJ_HTTP_MAX_PENDING_PARAMS];
+   char szRequest[2048];
+
+   while ( 1 )
+   {
+      pthread_mutex_lock(&s_MajHttpMutex);
+      while ( (! s_bMajHttpStop) && (0 == s_iMajHttpPendingParamsCount) )
+         pthread_cond_wait(&s_MajHttpCondition, &s_MajHttpMutex);
+      if ( s_bMajHttpStop )
+      {
+         pthread_mutex_unlock(&s_MajHttpMutex);
+         break;
+      }
+      int iCountParams = s_iMajHttpPendingParamsCount;
+      memcpy(params, s_MajHttpPendingParams, iCountParams * sizeof(t_maj_http_param));
+      long long llPendingSince = s_llMajHttpPendingSinceMicros;
+      s_iMajHttpPendingParamsCount = 0;
+      s_bMajHttpRequestInFlight = true;
+      pthread_mutex_unlock(&s_MajHttpMutex);
+
+      int iLength = snprintf(szRequest, sizeof(szRequest), "GET /api/v1/set?");
+      for( int i=0; i<iCountParams; i++ )
+         iLength += snprintf(szRequest + iLength, sizeof(szRequest) - iLength, "%s%s=%s", (i>0)?"&":"", params[i].szParam, params[i].szValue);
+      iLength += snprintf(szRequest + iLength, sizeof(szRequest) - iLength, " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n");
+
+      int iStatus = _maj_http_send_request(szRequest, iLength);
+      long long llLatency = _maj_http_now_micros() - llPendingSince;
+
+      pthread_mutex_lock(&s_MajHttpMutex);
+      if ( (iStatus >= 200) && (iStatus < 300) )
+      {
+         s_MajHttpStats.uRequestsSent++;
+         s_MajHttpStats.uLastLatencyMicros = (u32)llLatency;
+         if ( (0 == s_MajHttpStats.uMinLatencyMicros) || (s_MajHttpStats.uLastLatencyMicros < s_MajHttpStats.uMinLatencyMicros) )
+            s_MajHttpStats.uMinLatencyMicros = s_MajHttpStats.uLastLatencyMicros;
+         if ( s_MajHttpStats.uLastLatencyMicros > s_MajHttpStats.uMaxLatencyMicros )
+            s_MajHttpStats.uMaxLatencyMicros = s_MajHttpStats.uLastLatencyMicros;
+         s_llMajHttpTotalLatencyMicros += llLatency;
+         s_MajHttpStats.uAvgLatencyMicros = (u32)(s_llMajHttpTotalLatencyMicros / s_MajHttpStats.uRequestsSent);
+      }
+      else
+      {
+         s_MajHttpStats.uRequestsFailed++;
+         _maj_http_requeue_failed_params(params, iCountParams);
+      }
+      s_bMajHttpRequestInFlight = false;
+      pthread_cond_broadcast(&s_MajHttpCondition);
+
+      if ( (iStatus < 200) || (iStatus >= 300) )
+      {
+         log_softerror_and_alarm("[HwCamMajHttp] Request failed (status: %d): %s", iStatus, szRequest);
+         _maj_http_wait_retry_delay();
+      }
+      pthread_mutex_unlock(&s_MajHttpMutex);
+   }
+
+   _maj_http_close_connection();
+   log_line("[HwCamMajHttp] Stopped worker thread.");
+   return NULL;
+}
+
+int hardware_camera_maj_http_init(const char* szHost, int iPort)
+{
+   pthread_mutex_lock(&s_MajHttpMutex);
+   if ( s_bMajHttpThreadStarted )
+   {
+      pthread_mutex_unlock(&s_MajHttpMutex);
+      return 1;
+   }
+   if ( (NULL != szHost) && (0 != szHost[0]) )
+   {
+      strncpy(s_szMajHttpHost, szHost, sizeof(s_szMajHttpHost)-1);
+      s_szMajHttpHost[sizeof(s_szMajHttpHost)-1] = 0;
+   }
+   if ( iPort > 0 )
+      s_iMajHttpPort = iPort;
+   s_bMajHttpStop = false;
+   if ( 0 != pthread_create(&s_MajHttpThread, NULL, &_thread_maj_http_worker, NULL) )
+   {
+      pthread_mutex_unlock(&s_MajHttpMutex);
+      log_softerror_and_alarm("[HwCamMajHttp] Failed to create worker thread.");
+      return 0;
+   }
+   s_bMajHttpThreadStarted = true;
+   pthread_mutex_unlock(&s_MajHttpMutex);
+   log_line("[HwCamMajHttp] Init for %s:%d", s_szMajHttpHost, s_iMajHttpPort);
+   return 1;
+}
+
+void hardware_camera_maj_http_uninit()
+{
+   pthread_mutex_lock(&s_MajHttpMutex);
+   if ( ! s_bMajHttpThreadStarted )
+   {
+      pthread_mutex_unlock(&s_MajHttpMutex);
+      return;
+   }
+   s_bMajHttpStop = true;
+   pthread_cond_broadcast(&s_MajHttpCondition);
+   pthread_mutex_unlock(&s_MajHttpMutex);
+   pthread_join(s_MajHttpThread, NULL);
+
+   pthread_mutex_lock(&s_MajHttpMutex);
+   s_bMajHttpThreadStarted = false;
+   s_iMajHttpPendingParamsCount = 0;
+   pthread_mutex_unlock(&s_MajHttpMutex);
+   log_line("[HwCamMajHttp] Uninit. Requests sent: %u, failed: %u, params queued: %u, coalesced: %u, requeued: %u, dropped: %u, connections: %u, latency min/avg/max: %u/%u/%u us",
+      s_MajHttpStats.uRequestsSent, s_MajHttpStats.uRequestsFailed, s_MajHttpStats.uParamsQueued, s_MajHttpStats.uParamsCoalesced,
+      s_MajHttpStats.uParamsRequeued, s_MajHttpStats.uParamsFailed,
+      s_MajHttpStats.uConnectionsOpened, s_MajHttpStats.uMinLatencyMicros, s_MajHttpStats.uAvgLatencyMicros, s_MajHttpStats.uMaxLatencyMicros);
+}
+
+void hardware_camera_maj_http_set_param(const char* szParam, const char* szValue)
+{
+   if ( (NULL == szParam) || (NULL == szValue) || (0 == szParam[0]) )
+      return;
+   if ( ! s_bMajHttpThreadStarted )
+      hardware_camera_maj_http_init(NULL, 0);
+
+   pthread_mutex_lock(&s_MajHttpMutex);
+   s_MajHttpStats.uParamsQueued++;
+   int iIndex = -1;
+   for( int i=0; i<s_iMajHttpPendingParamsCount; i++ )
+   {
+      if ( 0 == strcmp(s_MajHttpPendingParams[i].szParam, szParam) )
+      {
+         iIndex = i;
+         s_MajHttpStats.uParamsCoalesced++;
+         break;
+      }
+   }
+   if ( -1 == iIndex )
+   {
+      if ( s_iMajHttpPendingParamsCount >= MAJ_HTTP_MAX_PENDING_PARAMS )
+      {
+         s_MajHttpStats.uParamsFailed++;
+         pthread_mutex_unlock(&s_MajHttpMutex);
+         log_softerror_and_alarm("[HwCamMajHttp] Too many pending params. Dropping %s=%s", szParam, szValue);
+         return;
+      }
+      if ( 0 == s_iMajHttpPendingParamsCount )
+         s_llMajHttpPendingSinceMicros = _maj_http_now_micros();
+      iIndex = s_iMajHttpPendingParamsCount;
+      s_iMajHttpPendingParamsCount++;
+      strncpy(s_MajHttpPendingParams[iIndex].szParam, szParam, sizeof(s_MajHttpPendingParams[iIndex].szParam)-1);
+      s_MajHttpPendingParams[iIndex].szParam[sizeof(s_MajHttpPendingParams[iIndex].szParam)-1] = 0;
+   }
+   strncpy(s_MajHttpPendingParams[iIndex].szValue, szValue, sizeof(s_MajHttpPendingParams[iIndex].szValue)-1);
+   s_MajHttpPendingParams[iIndex].szValue[sizeof(s_MajHttpPendingParams[iIndex].szValue)-1] = 0;
+   s_MajHttpPendingParams[iIndex].iRetries = 0;
+   pthread_cond_broadcast(&s_MajHttpCondition);
+   pthread_mutex_unlock(&s_MajHttpMutex);
+}
+
+void hardware_camera_maj_http_set_param_u32(const char* szParam, u32 uValue)
+{
+   char szValue[32];
+   sprintf(szValue, "%u", uValue);
+   hardware_camera_maj_http_set_param(szParam, szValue);
+}
+
+void hardware_camera_maj_http_set_param_int(const char* szParam, int iValue)
+{
+   char szValue[32];
+   sprintf(szValue, "%d", iValue);
+   hardware_camera_maj_http_set_param(szParam, szValue);
+}
+
+bool hardware_camera_maj_http_wait_idle(u32 uTimeoutMs)
+{
+   struct timespec tDeadline;
+   clock_gettime(CLOCK_REALTIME, &tDeadline);
+   tDeadline.tv_sec += uTimeoutMs/1000;
+   tDeadline.tv_nsec += (long)(uTimeoutMs%1000) * 1000000L;
+   if ( tDeadline.tv_nsec >= 1000000000L )
+   {
+      tDeadline.tv_sec++;
+      tDeadline.tv_nsec -= 1000000000L;
+   }
+
+   pthread_mutex_lock(&s_MajHttpMutex);
+   while ( s_bMajHttpThreadStarted && ((s_iMajHttpPendingParamsCount > 0) || s_bMajHttpRequestInFlight) )
+   {
+      if ( 0 != pthread_cond_timedwait(&s_MajHttpCondition, &s_MajHttpMutex, &tDeadline) )
+         break;
+   }
+   bool bIdle = (0 == s_iMajHttpPendingParamsCount) && (! s_bMajHttpRequestInFlight);
+   pthread_mutex_unlock(&s_MajHttpMutex);
+   return bIdle;
+}
+
+void hardware_camera_maj_http_get_stats(t_maj_http_stats* pStats)
+{
+   if ( NULL == pStats )
+      return;
+   pthread_mutex_lock(&s_MajHttpMutex);
+   memcpy(pStats, &s_MajHttpStats, sizeof(t_maj_http_stats));
+   pthread_mutex_unlock(&s_MajHttpMutex);
+}
+
+void hardware_camera_maj_http_reset_stats()
+{
+   pthread_mutex_lock(&s_MajHttpMutex);
+   memset(&s_MajHttpStats, 0, sizeof(t_maj_http_stats));
+   s_llMajHttpTotalLatencyMicros = 0;
+   pthread_mutex_unlock(&s_MajHttpMutex);
+}
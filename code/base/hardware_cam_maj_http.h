@@ -0,0 +1,45 @@
+#pragma once
+#include "../base/base.h"
+
+// Keep-alive HTTP client for the majestic API (/api/v1/set?...).
+// Parameter changes are queued and sent by a single worker thread; changes queued while a request
+// is in flight are coalesced (latest value per parameter) into the next request.
+
+#define MAJ_HTTP_DEFAULT_HOST "127.0.0.1"
+#define MAJ_HTTP_DEFAULT_PORT 80
+#define MAJ_HTTP_MAX_PENDING_PARAMS 16
+#define MAJ_HTTP_TIMEOUT_MS 1000
+// A failed request puts its params back in the queue (unless a newer value was queued meanwhile)
+// and is retried after MAJ_HTTP_RETRY_DELAY_MS, up to MAJ_HTTP_MAX_RETRIES times
+#define MAJ_HTTP_RETRY_DELAY_MS 200
+#define MAJ_HTTP_MAX_RETRIES 5
+
+typedef struct
+{
+   u32 uParamsQueued;
+   u32 uParamsCoalesced;   // Queued values replaced by a newer value before being sent
+   u32 uRequestsSent;
+   u32 uRequestsFailed;
+   u32 uParamsRequeued;    // Params of failed requests queued again for a retry
+   u32 uParamsFailed;      // Params dropped after MAJ_HTTP_MAX_RETRIES failed requests or on a full queue
+   u32 uConnectionsOpened;
+   // Time from the first queued change of a request to the response, in microseconds
+   u32 uLastLatencyMicros;
+   u32 uMinLatencyMicros;
+   u32 uMaxLatencyMicros;
+   u32 uAvgLatencyMicros;
+} t_maj_http_stats;
+
+// Called automatically (with the default host/port) on the first queued change
+int hardware_camera_maj_http_init(const char* szHost, int iPort);
+void hardware_camera_maj_http_uninit();
+
+void hardware_camera_maj_http_set_param(const char* szParam, const char* szValue);
+void hardware_camera_maj_http_set_param_u32(const char* szParam, u32 uValue);
+void hardware_camera_maj_http_set_param_int(const char* szParam, int iValue);
+
+// Returns true if all queued changes were sent (or failed) before the timeout
+bool hardware_camera_maj_http_wait_idle(u32 uTimeoutMs);
+
+void hardware_camera_maj_http_get_stats(t_maj_http_stats* pStats);
+void hardware_camera_maj_http_reset_stats();
@@ -48,6 +48,8 @@
 #include "config.h"
 #include "hardware.h"
 #include "hardware_radio.h"
+#include "hardware_radio_nl80211.h"
+#include "hardware_radio_sysfs.h"
 #include "hardware_serial.h"
 #include "hardware_radio_sik.h"
 #include "hw_procs.h"
@@ -64,6 +66,7 @@ static radio_hw_info_t sRadioInfo[MAX_RADIO_INTERFACES];
 static int s_iHwRadiosCount = 0;
 static int s_iHwRadiosSupportedCount = 0;
 static int s_HardwareRadiosEnumeratedOnce = 0;
+static int s_iHardwareRadiosLoadedFromStoredConfig = 0;
 
 void reset_runtime_radio_rx_info(type_runtime_radio_rx_info* pRuntimeRadioRxInfo)
 {
@@ -136,9 +139,51 @@ void hardware_log_radio_info(radio_hw_info_t* pRadioInfoArray, int iCount)
 
 void hardware_radio_remove_stored_config()
 {
-   char szComm[MAX_FILE_PATH_SIZE];
-   snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "rm -rf %s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_CONFIG);
-   hw_execute_bash_command(szComm, NULL);
+   char szFile[MAX_FILE_PATH_SIZE];
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "%s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_CONFIG);
+   unlink(szFile);
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "%s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_TOPOLOGY);
+   unlink(szFile);
+}
+
+// Returns 1 if there is a stored radio config and it was saved for the same radio hardware (USB devices, wifi interfaces, USB serial ports) as the current one
+
+int hardware_radio_stored_config_matches_hardware()
+{
+   char szFile[MAX_FILE_PATH_SIZE];
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "%s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_CONFIG);
+   if ( access(szFile, R_OK) == -1 )
+      return 0;
+
+   snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "%s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_TOPOLOGY);
+   FILE* fd = fopen(szFile, "r");
+   if ( NULL == fd )
+   {
+      log_line("[HardwareRadio] No stored radio hardware topology.");
+      return 0;
+   }
+   u32 uStoredSignature = 0;
+   int iRes = fscanf(fd, "%u", &uStoredSignature);
+   fclose(fd);
+   if ( 1 != iRes )
+   {
+      log_softerror_and_alarm("[HardwareRadio] Invalid stored radio hardware topology file.");
+      return 0;
+   }
+
+   u32 uSignature = hardware_radio_sysfs_get_topology_signature();
+   if ( HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN == uSignature )
+   {
+      log_line("[HardwareRadio] Radio hardware topology can't be computed, do a full enumeration.");
+      return 0;
+   }
+   if ( uSignature != uStoredSignature )
+   {
+      log_line("[HardwareRadio] Radio hardware topology changed (stored: %u, current: %u).", uStoredSignature, uSignature);
+      return 0;
+   }
+   log_line("[HardwareRadio] Radio hardware topology did not change (%u).", uSignature);
+   return 1;
 }
 
 void hardware_save_radio_info()
@@ -171,6 +216,17 @@ void hardware_save_radio_info()
    fwrite( buffer, 1, pos, fp );
    fclose(fp);
    log_line("[HardwareRadio] Saved hardware radio config to file (%s).", szFile);
+
+   strcpy(szFile, FOLDER_CONFIG);
+   strcat(szFile, FILE_CONFIG_CURRENT_RADIO_HW_TOPOLOGY);
+   fp = fopen(szFile, "w");
+   if ( NULL == fp )
+   {
+      log_softerror_and_alarm("Failed to save radio HW topology file.");
+      return;
+   }
+   fprintf(fp, "%u\n", hardware_radio_sysfs_get_topology_signature());
+   fclose(fp);
 }
 
 int hardware_load_radio_info()
@@ -397,109 +453,72 @@ void _hardware_assign_usb_from_physical_ports()
       sRadioInfo[i].szUSBPort[2] = 0;
    }
 
-   DIR *d;
-   struct dirent *dir;
    char szComm[256];
    char szOutput[1024];
+   char szUSBDevices[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
 
-   d = opendir("/sys/bus/usb/devices/");
-   if ( NULL == d )
+   int iCountUSBDevices = hardware_radio_sysfs_list_folder("bus/usb/devices", NULL, szUSBDevices, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountUSBDevices > HW_SYSFS_MAX_FOLDER_ENTRIES )
+   {
+      log_softerror_and_alarm("[HardwareRadio] Too many USB devices entries (%d), only the first %d are checked.", iCountUSBDevices, HW_SYSFS_MAX_FOLDER_ENTRIES);
+      iCountUSBDevices = HW_SYSFS_MAX_FOLDER_ENTRIES;
+   }
+   if ( iCountUSBDevices <= 0 )
    {
       log_line("[HardwareRadio] Can't find USB ports for radio interfaces (can't open /sys/bus/usb/devices).");
       return;
    }
 
-   while ((dir = readdir(d)) != NULL)
+   for( int iUSBDevice=0; iUSBDevice<iCountUSBDevices; iUSBDevice++ )
    {
-      int iLen = strlen(dir->d_name);
+      const char* szUSBDevice = szUSBDevices[iUSBDevice];
+      int iLen = strlen(szUSBDevice);
       if ( iLen < 3 )
          continue;
 
-      log_line("[HardwareRadio] Quering USB device path: [%s]...", dir->d_name);
+      log_line("[HardwareRadio] Quering USB device path: [%s]...", szUSBDevice);
 
-      snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/uevent 2>/dev/null | grep DRIVER", dir->d_name);
-      szOutput[0] = 0;
-      hw_execute_bash_command_silent(szComm, szOutput);
-      if ( 0 == szOutput[0] )
+      snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "bus/usb/devices/%s/uevent", szUSBDevice);
+      if ( ! hardware_radio_sysfs_read_uevent_value(szComm, "DRIVER", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
       {
-         log_line("[HardwareRadio] No info for USB device: [%s]. Skipping it.", dir->d_name);
+         log_line("[HardwareRadio] No info for USB device: [%s]. Skipping it.", szUSBDevice);
          continue;
       }
       for( int i=0; i<s_iHwRadiosCount; i++ )
       {
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/net/%s/uevent 2>/dev/null | grep DEVTYPE=wlan", dir->d_name, sRadioInfo[i].szName);
-         hw_execute_bash_command_silent(szComm, szOutput);
-         if ( 0 == szOutput[0] )
+         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "bus/usb/devices/%s/net/%s/uevent", szUSBDevice, sRadioInfo[i].szName);
+         if ( ! hardware_radio_sysfs_read_uevent_value(szComm, "DEVTYPE", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
             continue;
-
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/net/%s/uevent 2>/dev/null | grep INTERFACE", dir->d_name, sRadioInfo[i].szName);
-         hw_execute_bash_command_silent(szComm, szOutput);
-         if ( 0 == szOutput[0] )
+         if ( 0 != strcmp(szOutput, "wlan") )
             continue;
-
-         int iPos = 0;
-         iLen = strlen(szOutput);
-         while ( iPos < iLen )
-         {
-            if ( szOutput[iPos] == '=' )
-            {
-               iPos++;
-               break;
-            }
-            iPos++;
-         }
-
-         if ( iPos >= iLen )
+         if ( ! hardware_radio_sysfs_read_uevent_value(szComm, "INTERFACE", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
             continue;
-
-         int bMathcingInterfaceName = 1;
-         for( int k=0; k<strlen(sRadioInfo[i].szName); k++ )
-            if ( szOutput[iPos+k] != sRadioInfo[i].szName[k] )
-               bMathcingInterfaceName = 0;
-
-         if ( ! bMathcingInterfaceName )
+         if ( 0 != strcmp(szOutput, sRadioInfo[i].szName) )
             continue;
 
          // Found the USB port for radio interface i
 
-         log_line("[HardwareRadio] Found USB port tree position for radio interface %d: [%s]", i+1, dir->d_name);
+         log_line("[HardwareRadio] Found USB port tree position for radio interface %d: [%s]", i+1, szUSBDevice);
 
          // Find the product id / vendor id
 
-         szOutput[0] = 0;
-         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "cat /sys/bus/usb/devices/%s/uevent 2>/dev/null | grep PRODUCT", dir->d_name);
-         hw_execute_bash_command_silent(szComm, szOutput);
+         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "bus/usb/devices/%s/uevent", szUSBDevice);
+         if ( hardware_radio_sysfs_read_uevent_value(szComm, "PRODUCT", szOutput, sizeof(szOutput)/sizeof(szOutput[0])) )
          if ( 0 != szOutput[0] )
          {
             iLen = strlen(szOutput);
-            int iPosOut = 0;
-            while ( iPosOut < iLen )
-            {
-               if ( szOutput[iPosOut] == '=' )
-               {
-                  iPosOut++;
-                  break;
-               }
-               szOutput[iPosOut] = tolower(szOutput[iPosOut]);
-               iPosOut++;
-            }
-            if ( iPosOut < iLen )
+            for( int kk=0; kk<iLen; kk++ )
+               szOutput[kk] = tolower(szOutput[kk]);
+
+            strncpy( sRadioInfo[i].szProductId, szOutput, sizeof(sRadioInfo[i].szProductId)/sizeof(sRadioInfo[i].szProductId[0]) );
+            sRadioInfo[i].szProductId[(sizeof(sRadioInfo[i].szProductId)/sizeof(sRadioInfo[i].szProductId[0]))-1] = 0;
+            for( int kk=0; kk<strlen(sRadioInfo[i].szProductId); kk++ )
             {
-               for( int kk=iPosOut; kk<iLen; kk++ )
-                  szOutput[kk] = tolower(szOutput[kk]);
-
-               strncpy( sRadioInfo[i].szProductId, &(szOutput[iPosOut]), sizeof(sRadioInfo[i].szProductId)/sizeof(sRadioInfo[i].szProductId[0]) );
-               sRadioInfo[i].szProductId[(sizeof(sRadioInfo[i].szProductId)/sizeof(sRadioInfo[i].szProductId[0]))-1] = 0;
-               for( int kk=0; kk<strlen(sRadioInfo[i].szProductId); kk++ )
-               {
-                  if ( sRadioInfo[i].szProductId[kk] == '/' )
-                     sRadioInfo[i].szProductId[kk] = ':';
-               }
-               sRadioInfo[i].iCardModel = _hardware_detect_card_model(sRadioInfo[i].szProductId);
-               log_line("[HardwareRadio] Found product/vendor id for radio interface %d: [%s], card model: %d: [%s]", i+1, sRadioInfo[i].szProductId, sRadioInfo[i].iCardModel, str_get_radio_card_model_string(sRadioInfo[i].iCardModel) );
+               if ( sRadioInfo[i].szProductId[kk] == '/' )
+                  sRadioInfo[i].szProductId[kk] = ':';
             }
+            sRadioInfo[i].iCardModel = _hardware_detect_card_model(sRadioInfo[i].szProductId);
+            log_line("[HardwareRadio] Found product/vendor id for radio interface %d: [%s], card model: %d: [%s]", i+1, sRadioInfo[i].szProductId, sRadioInfo[i].iCardModel, str_get_radio_card_model_string(sRadioInfo[i].iCardModel) );
          }
 
          // Done finding the product id / vendor id
@@ -507,7 +526,7 @@ void _hardware_assign_usb_from_physical_ports()
          // Parse the USB port path info
 
          char szPort[128];
-         strncpy(szPort, dir->d_name, 127);
+         strncpy(szPort, szUSBDevice, 127);
          szPort[127] = 0;
 
          // Find first : in string
@@ -591,7 +610,6 @@ void _hardware_assign_usb_from_physical_ports()
          log_line("[HardwareRadio] Assigned USB port to radio interface %d: [%s]", i+1, sRadioInfo[i].szUSBPort);
       }
    }
-   closedir(d);
 
    // Assign some USB port to the ones that did not have a match
 
@@ -658,9 +676,15 @@ int _hardware_find_usb_radio_interfaces_info()
    char szBuff[4096];
    szBuff[0] = 0;
    memset(szBuff, 0, sizeof(szBuff)/sizeof(szBuff[0]));
-   hw_execute_bash_command_raw_timeout("lsusb", szBuff, 4000);
-
-   log_line("[HardwareRadio] Output of lsusb: <<<%s>>>", szBuff);
+   if ( hardware_radio_sysfs_get_usb_devices_description(szBuff, sizeof(szBuff)/sizeof(szBuff[0])) > 0 )
+      log_line("[HardwareRadio] USB devices from sysfs: <<<%s>>>", szBuff);
+   else
+   {
+      log_line("[HardwareRadio] No USB devices info in sysfs. Using lsusb.");
+      memset(szBuff, 0, sizeof(szBuff)/sizeof(szBuff[0]));
+      hw_execute_bash_command_raw_timeout("lsusb", szBuff, 4000);
+      log_line("[HardwareRadio] Output of lsusb: <<<%s>>>", szBuff);
+   }
 
    int iLen = strlen(szBuff);
    if ( iLen >= (int)(sizeof(szBuff)/sizeof(szBuff[0])) )
@@ -765,6 +789,42 @@ int _hardware_find_usb_radio_interfaces_info()
    return iCountKnownRadioCards;
 }
 
+// Returns the supported bands for a phy, based on the channels it reports (using nl80211, or iw as a fallback)
+
+u32 _hardware_get_phy_supported_bands(int iPhyIndex)
+{
+   u32 uBandsFrequencies[] = { 2377, 2427, 2512, 5745 };
+   u32 uBands[] = { RADIO_HW_SUPPORTED_BAND_23, RADIO_HW_SUPPORTED_BAND_24, RADIO_HW_SUPPORTED_BAND_25, RADIO_HW_SUPPORTED_BAND_58 };
+   u32 uSupportedBands = 0;
+
+   u32 uFrequencies[256];
+   int iCountFrequencies = hardware_radio_nl80211_get_phy_frequencies(iPhyIndex, uFrequencies, sizeof(uFrequencies)/sizeof(uFrequencies[0]));
+   if ( iCountFrequencies > 0 )
+   {
+      for( int i=0; i<iCountFrequencies; i++ )
+      for( int k=0; k<(int)(sizeof(uBands)/sizeof(uBands[0])); k++ )
+      {
+         if ( uFrequencies[i] == uBandsFrequencies[k] )
+            uSupportedBands |= uBands[k];
+      }
+      log_line("[HardwareRadio] Got %d channels for phy%d from nl80211.", iCountFrequencies, iPhyIndex);
+      return uSupportedBands;
+   }
+
+   log_line("[HardwareRadio] Failed to get channels for phy%d from nl80211 (error: %d). Using iw.", iPhyIndex, iCountFrequencies);
+   char szComm[128];
+   char szBuff[1024];
+   for( int k=0; k<(int)(sizeof(uBands)/sizeof(uBands[0])); k++ )
+   {
+      szBuff[0] = 0;
+      sprintf(szComm, "iw phy%d info | grep %u", iPhyIndex, uBandsFrequencies[k]);
+      hw_execute_bash_command_raw(szComm, szBuff);
+      if ( 5 < strlen(szBuff) )
+         uSupportedBands |= uBands[k];
+   }
+   return uSupportedBands;
+}
+
 int _hardware_enumerate_wifi_radios()
 {
    #ifdef HW_PLATFORM_OPENIPC_CAMERA
@@ -775,37 +835,21 @@ int _hardware_enumerate_wifi_radios()
 
    char szDriver[128];
    char szComm[256];
-   char szBuff[1024];
 
    _hardware_find_usb_radio_interfaces_info();
 
    log_line("[HardwareRadio] Finding wireless radio cards...");
-   FILE* fp = popen("ls /sys/class/net/ | nice grep -v eth0 | nice grep -v lo | nice grep -v usb | nice grep -v intwifi | nice grep -v relay | nice grep -v wifihotspot", "r" );
-   if ( NULL == fp )
-   {
-      log_error_and_alarm("Failed to enumerate 2.4/5.8 radios.");
-      return 0;
-   }
+   char szInterfaces[MAX_RADIO_INTERFACES][HW_SYSFS_MAX_NAME_LENGTH];
+   int iCountInterfaces = hardware_radio_sysfs_get_wifi_interfaces(szInterfaces, MAX_RADIO_INTERFACES);
    
    int iStartIndex = s_iHwRadiosCount;
 
-   while (fgets(szBuff, 255, fp) != NULL)
+   for( int iInterface=0; iInterface<iCountInterfaces; iInterface++ )
    {
-      sscanf(szBuff, "%s", sRadioInfo[s_iHwRadiosCount].szName);
-      
-      if ( 0 == sRadioInfo[s_iHwRadiosCount].szName[0] )
-         continue;
-      if ( 0 != strstr(sRadioInfo[s_iHwRadiosCount].szName, "wlx") )
-         continue;
-        
+      strncpy(sRadioInfo[s_iHwRadiosCount].szName, szInterfaces[iInterface], sizeof(sRadioInfo[s_iHwRadiosCount].szName)-1);
+      sRadioInfo[s_iHwRadiosCount].szName[sizeof(sRadioInfo[s_iHwRadiosCount].szName)-1] = 0;
       log_line("[HardwareRadio] Parsing found wireless radio: [%s]", sRadioInfo[s_iHwRadiosCount].szName);
-      if ( 0 == strstr(sRadioInfo[s_iHwRadiosCount].szName, "wlan" ) )
-      if ( 0 == strstr(sRadioInfo[s_iHwRadiosCount].szName, "wlx" ) )
-      {
-         log_line("[HardwareRadio] Skipping wireless radio [%s]", sRadioInfo[s_iHwRadiosCount].szName);
-         continue;
-      }
-      
+
       sRadioInfo[s_iHwRadiosCount].iCardModel = 0;
       sRadioInfo[s_iHwRadiosCount].isSupported = 0;
       sRadioInfo[s_iHwRadiosCount].isSerialRadio = 0;
@@ -846,7 +890,6 @@ int _hardware_enumerate_wifi_radios()
       if ( s_iHwRadiosCount >= MAX_RADIO_INTERFACES )
          break;
    }
-   pclose(fp);
 
    log_line("[HardwareRadio] Found a total of %d wifi cards. Get info about them...", s_iHwRadiosCount);
    s_iHwRadiosSupportedCount = 0;
@@ -855,16 +898,7 @@ int _hardware_enumerate_wifi_radios()
    {
       szDriver[0] = 0;
 
-      #ifdef HW_PLATFORM_OPENIPC_CAMERA
-      sprintf(szComm, "ls -Al /sys/class/net/%s/device/ | grep driver", sRadioInfo[i].szName);
-      hw_execute_bash_command_raw(szComm, szDriver);
-      #else
-      sprintf(szComm, "cat /sys/class/net/%s/device/uevent | nice grep DRIVER | sed 's/DRIVER=//'", sRadioInfo[i].szName);
-      hw_execute_bash_command(szComm, szDriver);
-      #endif
-      removeTrailingNewLines(szDriver);
-
-      if ( NULL != strstr(szDriver, "such device") )
+      if ( ! hardware_radio_sysfs_get_interface_driver(sRadioInfo[i].szName, szDriver, sizeof(szDriver)/sizeof(szDriver[0])) )
       {
          log_softerror_and_alarm("[HardwareRadio] This device (%s) is no longer valid. Removing it.", sRadioInfo[i].szName);
          for( int k=i; k<s_iHwRadiosCount-1; k++ )
@@ -993,82 +1027,28 @@ int _hardware_enumerate_wifi_radios()
          sRadioInfo[i].szProductId[kk] = 0;
 
       // Find the MAC address
-      sprintf(szComm, "iw dev %s info | grep addr", sRadioInfo[i].szName );
-      if ( 1 != hw_execute_bash_command_raw(szComm, szBuff) )
-      {
+      if ( ! hardware_radio_sysfs_get_interface_mac(sRadioInfo[i].szName, szComm, MAX_MAC_LENGTH) )
          log_softerror_and_alarm("Failed to find MAC address for %s", sRadioInfo[i].szName);
-      }
-      else if ( 1 != sscanf(szBuff, "%*s %s", szComm) )
-      {
-         log_softerror_and_alarm("Failed to find MAC address for %s", sRadioInfo[i].szName);
-      }
       else
       {
          log_line("Found MAC address %s for %s", szComm, sRadioInfo[i].szName);
-         szComm[MAX_MAC_LENGTH-1] = 0;
-         int iSt = 0;
-         int iEnd = 0;
-         while ( iEnd < strlen(szComm) )
-         {
-            if ( szComm[iEnd] == ':' )
-               iEnd++;
-            else
-            {
-               szComm[iSt] = toupper(szComm[iEnd]);
-               iSt++;
-               iEnd++;
-            }
-         }
-         szComm[iSt] = 0;
          strcpy(sRadioInfo[i].szMAC, szComm);
       }
 
-      // Find physical interface number, in form phy#0
+      // Find physical interface number (phy#)
 
-      sprintf(szComm, "iw dev | grep -B 1 %s", sRadioInfo[i].szName );
-      if ( 1 != hw_execute_bash_command_raw(szComm, szBuff) )
-      {
-         sRadioInfo[i].phy_index = i;
-         log_softerror_and_alarm("Failed to find physical interface index for %s", sRadioInfo[i].szName);
-      }
-      else if ( 1 != sscanf(szBuff, "%s", szComm) )
+      sRadioInfo[i].phy_index = hardware_radio_sysfs_get_interface_phy_index(sRadioInfo[i].szName);
+      if ( sRadioInfo[i].phy_index < 0 )
       {
          sRadioInfo[i].phy_index = i;
          log_softerror_and_alarm("Failed to find physical interface index for %s", sRadioInfo[i].szName);
       }
       else
-      {
-         int iPhyStrLen = strlen(szComm);
-         log_line("phy string: [%s], length: %d", szComm, iPhyStrLen);
-         sRadioInfo[i].phy_index = szComm[iPhyStrLen-1] - '0';
-         if ( (iPhyStrLen > 2) && isdigit(szComm[iPhyStrLen-2]) )
-         {
-            sRadioInfo[i].phy_index = 10 * (szComm[iPhyStrLen-2] - '0') + sRadioInfo[i].phy_index;
-         }
-      }
+         log_line("[HardwareRadio] Physical interface index for %s: phy%d", sRadioInfo[i].szName, sRadioInfo[i].phy_index);
 
       // Check supported bands
 
-      sRadioInfo[i].supportedBands = 0;
-      sprintf(szComm, "iw phy%d info | grep 2377", sRadioInfo[i].phy_index);
-      hw_execute_bash_command_raw(szComm, szBuff);
-      if ( 5 < strlen(szBuff) )
-        sRadioInfo[i].supportedBands |= RADIO_HW_SUPPORTED_BAND_23;
-
-      sprintf(szComm, "iw phy%d info | grep 2427", sRadioInfo[i].phy_index);
-      hw_execute_bash_command_raw(szComm, szBuff);
-      if ( 5 < strlen(szBuff) )
-        sRadioInfo[i].supportedBands |= RADIO_HW_SUPPORTED_BAND_24;
-
-      sprintf(szComm, "iw phy%d info | grep 2512", sRadioInfo[i].phy_index);
-      hw_execute_bash_command_raw(szComm, szBuff);
-      if ( 5 < strlen(szBuff) )
-        sRadioInfo[i].supportedBands |= RADIO_HW_SUPPORTED_BAND_25;
-
-      sprintf(szComm, "iw phy%d info | grep 5745", sRadioInfo[i].phy_index);
-      hw_execute_bash_command_raw(szComm, szBuff);
-      if ( 5 < strlen(szBuff) )
-        sRadioInfo[i].supportedBands |= RADIO_HW_SUPPORTED_BAND_58;
+      sRadioInfo[i].supportedBands = _hardware_get_phy_supported_bands(sRadioInfo[i].phy_index);
 
       if ( sRadioInfo[i].iRadioDriver == RADIO_HW_DRIVER_REALTEK_8812EU )
          sRadioInfo[i].supportedBands &= ~RADIO_HW_SUPPORTED_BAND_24;
@@ -1085,6 +1065,7 @@ int _hardware_enumerate_wifi_radios()
 void hardware_reset_radio_enumerated_flag()
 {
    s_HardwareRadiosEnumeratedOnce = 0;
+   s_iHardwareRadiosLoadedFromStoredConfig = 0;
 }
 
 int hardware_enumerate_radio_interfaces()
@@ -1111,6 +1092,7 @@ int hardware_enumerate_radio_interfaces_step(int iStep)
          if ( hardware_load_radio_info() )
          {
             s_HardwareRadiosEnumeratedOnce = 1;
+            s_iHardwareRadiosLoadedFromStoredConfig = 1;
             hardware_radio_sik_load_configuration();
             return 1;
          }
@@ -1119,6 +1101,7 @@ int hardware_enumerate_radio_interfaces_step(int iStep)
          log_line("[HardwareRadio] HW Enumerate: no existing radio HW info file. Enumerating HW radios from scratch.");
 
       s_iHwRadiosCount = 0;
+      s_iHardwareRadiosLoadedFromStoredConfig = 0;
    
       _hardware_enumerate_wifi_radios();
       
@@ -1130,6 +1113,13 @@ int hardware_enumerate_radio_interfaces_step(int iStep)
       s_HardwareRadiosEnumeratedOnce = 1;
    }
 
+   // SiK radios are already in the stored config
+   if ( (iStep == 1) && s_iHardwareRadiosLoadedFromStoredConfig )
+   {
+      log_line("[HardwareRadio] Radios loaded from stored config. Skipping SiK radios detection.");
+      return (s_iHwRadiosCount > 0)?1:0;
+   }
+
    if( iStep == -1 || iStep == 1 )
       hardware_radio_sik_detect_interfaces();
 
@@ -1150,18 +1140,16 @@ int hardware_enumerate_radio_interfaces_step(int iStep)
 
 int hardware_radio_get_class_net_adapters_count()
 {
-   char szOutput[1024];
-   szOutput[0] = 0;
-   hw_execute_bash_command_raw_silent("ls /sys/class/net/", szOutput);
-   removeNewLines(szOutput);
-      
+   char szEntries[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
+   int iCountEntries = hardware_radio_sysfs_list_folder("class/net", NULL, szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries > HW_SYSFS_MAX_FOLDER_ENTRIES )
+      iCountEntries = HW_SYSFS_MAX_FOLDER_ENTRIES;
+
    int iCount =0;
-   char* szToken = strtok(szOutput, "*");
-   while ( NULL != szToken )
+   for( int i=0; i<iCountEntries; i++ )
    {
-      if ( NULL != strstr(szToken, "wlan") )
+      if ( NULL != strstr(szEntries[i], "wlan") )
          iCount++;
-      szToken = strtok(NULL, "*");
    }
    return iCount;
 }
@@ -1714,39 +1702,107 @@ void hardware_install_drivers(int iEchoToConsole)
 }
 
 
+// Radio interfaces configuration helpers: use the in process nl80211/rtnetlink backend
+// and fall back to the iw/ip commands if the netlink request fails. Return 1 on success.
+
+int hardware_radio_set_link_up(const char* szInterfaceName, int iUp)
+{
+   int iRes = hardware_radio_nl80211_set_link_up(szInterfaceName, iUp);
+   if ( 0 == iRes )
+      return 1;
+   // No such interface: the ip command would fail too
+   if ( -ENODEV == iRes )
+      return 0;
+
+   log_softerror_and_alarm("[HardwareRadio] Failed to set link %s on %s using netlink (%s). Using ip command.", iUp?"up":"down", szInterfaceName, strerror(-iRes));
+   char szComm[128];
+   char szOutput[1024];
+   szOutput[0] = 0;
+   sprintf(szComm, "ip link set dev %s %s", szInterfaceName, iUp?"up":"down");
+   hw_execute_bash_command(szComm, szOutput);
+   if ( 0 != szOutput[0] )
+   {
+      log_softerror_and_alarm("[HardwareRadio] Unexpected result: [%s]", szOutput);
+      return 0;
+   }
+   return 1;
+}
+
+int hardware_radio_set_type_monitor(const char* szInterfaceName)
+{
+   int iRes = hardware_radio_nl80211_set_type_monitor(szInterfaceName);
+   if ( 0 == iRes )
+      return 1;
+   if ( -ENODEV == iRes )
+      return 0;
+
+   log_softerror_and_alarm("[HardwareRadio] Failed to set type monitor on %s using netlink (%s). Using iw command.", szInterfaceName, strerror(-iRes));
+   char szComm[128];
+   sprintf(szComm, "iw dev %s set type monitor", szInterfaceName);
+   hw_execute_bash_command(szComm, NULL);
+   return 1;
+}
+
+int hardware_radio_set_monitor_flags(const char* szInterfaceName, u32 uMonitorFlags)
+{
+   int iRes = hardware_radio_nl80211_set_monitor_flags(szInterfaceName, uMonitorFlags);
+   if ( 0 == iRes )
+      return 1;
+   if ( -ENODEV == iRes )
+      return 0;
+
+   log_softerror_and_alarm("[HardwareRadio] Failed to set monitor flags 0x%X on %s using netlink (%s). Using iw command.", uMonitorFlags, szInterfaceName, strerror(-iRes));
+   char szComm[256];
+   char szOutput[1024];
+   szOutput[0] = 0;
+   sprintf(szComm, "iw dev %s set monitor", szInterfaceName);
+   if ( uMonitorFlags == HW_RADIO_NL80211_MONITOR_FLAGS_NONE )
+      strcat(szComm, " none");
+   if ( uMonitorFlags & HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL )
+      strcat(szComm, " fcsfail");
+   if ( uMonitorFlags & HW_RADIO_NL80211_MONITOR_FLAG_PLCPFAIL )
+      strcat(szComm, " plcpfail");
+   if ( uMonitorFlags & HW_RADIO_NL80211_MONITOR_FLAG_CONTROL )
+      strcat(szComm, " control");
+   if ( uMonitorFlags & HW_RADIO_NL80211_MONITOR_FLAG_OTHER_BSS )
+      strcat(szComm, " otherbss");
+   strcat(szComm, " 2>&1");
+   hw_execute_bash_command(szComm, szOutput);
+   if ( 0 != szOutput[0] )
+   {
+      log_softerror_and_alarm("[HardwareRadio] Unexpected result: [%s]", szOutput);
+      return 0;
+   }
+   return 1;
+}
+
 int _configure_radio_interface_atheros(int iInterfaceIndex, radio_hw_info_t* pRadioHWInfo, u32 uDelayMS)
 {
    if ( (NULL == pRadioHWInfo) || (iInterfaceIndex < 0) || (iInterfaceIndex >= hardware_get_radio_interfaces_count()) )
       return 0;
 
    char szComm[128];
-   char szOutput[2048];
 
    #ifdef HW_PLATFORM_OPENIPC_CAMERA
 
    //sprintf(szComm, "iwconfig %s mode monitor", pRadioHWInfo->szName);
-   sprintf(szComm, "iw dev %s set type monitor", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, NULL);
+   hardware_radio_set_type_monitor(pRadioHWInfo->szName);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "iw dev %s set monitor fcsfail", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
    hardware_sleep_ms(uDelayMS);
 
    //sprintf(szComm, "ifconfig %s up", pRadioHWInfo->szName );
-   sprintf(szComm, "ip link set dev %s up", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, NULL);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 1);
    hardware_sleep_ms(uDelayMS);
 
    return 1;
    #endif
 
-   sprintf(szComm, "iw dev %s set monitor fcsfail", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "ip link set dev %s up", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, NULL);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 1);
    hardware_sleep_ms(uDelayMS);
    int dataRateMb = DEFAULT_RADIO_DATARATE_VIDEO_ATHEROS/1000/1000;
    // To fix
@@ -1763,22 +1819,16 @@ int _configure_radio_interface_atheros(int iInterfaceIndex, radio_hw_info_t* pRa
    hw_execute_bash_command(szComm, NULL);
    hardware_sleep_ms(uDelayMS);
    //sprintf(szComm, "ifconfig %s down 2>&1", pRadioHWInfo->szName );
-   sprintf(szComm, "ip link set dev %s down", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, NULL);
-   if ( 0 != szOutput[0] )
-      log_softerror_and_alarm("Unexpected result: [%s]", szOutput);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 0);
    hardware_sleep_ms(uDelayMS);
    
-   sprintf(szComm, "iw dev %s set monitor none", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, NULL);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAGS_NONE);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "iw dev %s set monitor fcsfail", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "ip link set dev %s up", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, NULL);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 1);
    hardware_sleep_ms(uDelayMS);
    
    pRadioHWInfo->iCurrentDataRateBPS = dataRateMb*1000*1000;
@@ -1791,47 +1841,33 @@ int _configure_radio_interface_realtek(int iInterfaceIndex, radio_hw_info_t* pRa
    if ( (NULL == pRadioHWInfo) || (iInterfaceIndex < 0) || (iInterfaceIndex >= hardware_get_radio_interfaces_count()) )
       return 0;
 
-   char szComm[128];
-   char szOutput[2048];
-
    #ifdef HW_PLATFORM_OPENIPC_CAMERA
-   
-   sprintf(szComm, "ip link set dev %s up", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, NULL);
+
+   char szComm[128];
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 1);
    hardware_sleep_ms(uDelayMS);
 
    sprintf(szComm, "iwconfig %s mode monitor", pRadioHWInfo->szName );
    hw_execute_bash_command(szComm, NULL);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "iw dev %s set monitor fcsfail", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
    hardware_sleep_ms(uDelayMS);
    
    return 1;
 
    #endif
 
-   sprintf(szComm, "ip link set dev %s down", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, szOutput);
-   if ( 0 != szOutput[0] )
-      log_softerror_and_alarm("[HardwareRadio] Unexpected result: [%s]", szOutput);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 0);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "iw dev %s set monitor none 2>&1", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
-   if ( 0 != szOutput[0] )
-      log_softerror_and_alarm("Unexpected result: [%s]", szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAGS_NONE);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "iw dev %s set monitor fcsfail", pRadioHWInfo->szName);
-   hw_execute_bash_command(szComm, szOutput);
+   hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
    hardware_sleep_ms(uDelayMS);
 
-   sprintf(szComm, "ip link set dev %s up", pRadioHWInfo->szName );
-   hw_execute_bash_command(szComm, szOutput);
-   if ( 0 != szOutput[0] )
-      log_softerror_and_alarm("Unexpected result: [%s]", szOutput);
+   hardware_radio_set_link_up(pRadioHWInfo->szName, 1);
    hardware_sleep_ms(uDelayMS);
 
    return 1;
@@ -1,6 +1,7 @@
 #pragma once
 #include "config.h"
 #include "hardware_radio_txpower.h"
+#include "hardware_radio_nl80211.h"
 #include "../radio/radiotap.h"
 #include "../radio/radiopackets2.h"
 
@@ -177,6 +178,7 @@ int hardware_load_radio_info();
 int hardware_load_radio_info_into_buffers(int* piOutputTotalCount, int* piOutputSupportedCount, radio_hw_info_t* pRadioInfoArray);
 void hardware_log_radio_info(radio_hw_info_t* pRadioInfo, int iCount);
 void hardware_radio_remove_stored_config();
+int hardware_radio_stored_config_matches_hardware();
 
 void hardware_reset_radio_enumerated_flag();
 int hardware_enumerate_radio_interfaces();
@@ -192,6 +194,9 @@ int hardware_install_driver_rtl8812eu(int iEchoToConsole);
 int hardware_install_driver_rtl8733bu(int iEchoToConsole);
 void hardware_install_drivers(int iEchoToConsole);
 int hardware_initialize_radio_interface(int iInterfaceIndex, u32 uDelayMS);
+int hardware_radio_set_link_up(const char* szInterfaceName, int iUp);
+int hardware_radio_set_type_monitor(const char* szInterfaceName);
+int hardware_radio_set_monitor_flags(const char* szInterfaceName, u32 uMonitorFlags);
 
 int hardware_radio_get_driver_id_card_model(int iCardModel);
 int hardware_radio_get_driver_id_for_product_id(const char* szProdId);
@@ -0,0 +1,492 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <errno.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#include "base.h"
+#include "hardware_radio_nl80211.h"
+
+#define NL80211_MSG_BUFFER_SIZE 1024
+
+static int s_iNl80211GenericFd = -1;
+static int s_iNl80211RouteFd = -1;
+static int s_iNl80211UsesExternalSockets = 0;
+static int s_iNl80211FamilyId = -1;
+static u32 s_uNl80211Sequence = 1;
+
+typedef int (*nl80211_msg_callback)(struct nlmsghdr* pMsg, void* pContext);
+
+static int _nl80211_open_socket(int iProtocol)
+{
+   int iFd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, iProtocol);
+   if ( iFd < 0 )
+      return -1;
+
+   struct sockaddr_nl addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.nl_family = AF_NETLINK;
+   if ( 0 != bind(iFd, (struct sockaddr*)&addr, sizeof(addr)) )
+   {
+      close(iFd);
+      return -1;
+   }
+   return iFd;
+}
+
+static struct nlmsghdr* _nl80211_msg_init(u8* pBuffer, u16 uType, u16 uFlags)
+{
+   memset(pBuffer, 0, NL80211_MSG_BUFFER_SIZE);
+   struct nlmsghdr* pMsg = (struct nlmsghdr*)pBuffer;
+   pMsg->nlmsg_len = NLMSG_LENGTH(0);
+   pMsg->nlmsg_type = uType;
+   pMsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | uFlags;
+   return pMsg;
+}
+
+static void* _nl80211_msg_put(struct nlmsghdr* pMsg, int iLength)
+{
+   if ( NLMSG_ALIGN(pMsg->nlmsg_len) + NLMSG_ALIGN(iLength) > NL80211_MSG_BUFFER_SIZE )
+      return NULL;
+   void* pData = ((u8*)pMsg) + NLMSG_ALIGN(pMsg->nlmsg_len);
+   pMsg->nlmsg_len = NLMSG_ALIGN(pMsg->nlmsg_len) + NLMSG_ALIGN(iLength);
+   return pData;
+}
+
+static void _nl80211_msg_put_genl_header(struct nlmsghdr* pMsg, u8 uCommand)
+{
+   struct genlmsghdr* pGenl = (struct genlmsghdr*)_nl80211_msg_put(pMsg, GENL_HDRLEN);
+   pGenl->cmd = uCommand;
+   pGenl->version = 1;
+}
+
+static struct nlattr* _nl80211_msg_put_attr(struct nlmsghdr* pMsg, u16 uType, const void* pData, int iLength)
+{
+   struct nlattr* pAttr = (struct nlattr*)_nl80211_msg_put(pMsg, NLA_HDRLEN + iLength);
+   if ( NULL == pAttr )
+      return NULL;
+   pAttr->nla_type = uType;
+   pAttr->nla_len = NLA_HDRLEN + iLength;
+   if ( (NULL != pData) && (iLength > 0) )
+      memcpy(((u8*)pAttr) + NLA_HDRLEN, pData, iLength);
+   return pAttr;
+}
+
+static void _nl80211_msg_put_u32(struct nlmsghdr* pMsg, u16 uType, u32 uValue)
+{
+   _nl80211_msg_put_attr(pMsg, uType, &uValue, sizeof(u32));
+}
+
+static int _nl80211_resolve_interface(const char* szInterfaceName)
+{
+   if ( (NULL == szInterfaceName) || (0 == szInterfaceName[0]) )
+      return -ENODEV;
+   unsigned int uIndex = if_nametoindex(szInterfaceName);
+   if ( 0 == uIndex )
+      return -ENODEV;
+   return (int)uIndex;
+}
+
+// Sends the request and waits for the kernel ack (or error).
+// Other replies to the request are passed to the callback, if any.
+
+static int _nl80211_transact(int iFd, struct nlmsghdr* pMsg, nl80211_msg_callback pCallback, void* pContext)
+{
+   if ( iFd < 0 )
+      return -ENOTCONN;
+
+   u32 uSequence = s_uNl80211Sequence++;
+   pMsg->nlmsg_seq = uSequence;
+
+   if ( send(iFd, pMsg, pMsg->nlmsg_len, 0) != (ssize_t)pMsg->nlmsg_len )
+      return (errno != 0)?-errno:-EIO;
+
+   // Big enough for the wiphy dumps
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE*16];
+   while ( 1 )
+   {
+      struct pollfd fdPoll;
+      fdPoll.fd = iFd;
+      fdPoll.events = POLLIN;
+      fdPoll.revents = 0;
+      int iRes = poll(&fdPoll, 1, HW_RADIO_NL80211_TIMEOUT_MS);
+      if ( iRes < 0 )
+      {
+         if ( errno == EINTR )
+            continue;
+         return -errno;
+      }
+      if ( 0 == iRes )
+         return -ETIMEDOUT;
+
+      int iLength = recv(iFd, uBuffer, sizeof(uBuffer), 0);
+      if ( iLength < 0 )
+      {
+         if ( errno == EINTR )
+            continue;
+         return -errno;
+      }
+      if ( 0 == iLength )
+         return -ECONNRESET;
+
+      struct nlmsghdr* pReply = (struct nlmsghdr*)uBuffer;
+      for( ; NLMSG_OK(pReply, (unsigned int)iLength); pReply = NLMSG_NEXT(pReply, iLength) )
+      {
+         if ( pReply->nlmsg_seq != uSequence )
+            continue;
+         if ( pReply->nlmsg_type == NLMSG_DONE )
+            return 0;
+         if ( pReply->nlmsg_type == NLMSG_ERROR )
+         {
+            if ( pReply->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr)) )
+               return -EIO;
+            struct nlmsgerr* pError = (struct nlmsgerr*)NLMSG_DATA(pReply);
+            return pError->error;
+         }
+         if ( NULL != pCallback )
+            pCallback(pReply, pContext);
+      }
+   }
+   return -EIO;
+}
+
+static int _nl80211_family_id_callback(struct nlmsghdr* pMsg, void* pContext)
+{
+   int* piFamilyId = (int*)pContext;
+   int iLength = (int)pMsg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+   struct nlattr* pAttr = (struct nlattr*)(((u8*)NLMSG_DATA(pMsg)) + GENL_HDRLEN);
+   while ( (iLength >= NLA_HDRLEN) && (pAttr->nla_len >= NLA_HDRLEN) && (pAttr->nla_len <= iLength) )
+   {
+      if ( ((pAttr->nla_type & NLA_TYPE_MASK) == CTRL_ATTR_FAMILY_ID) && (pAttr->nla_len >= NLA_HDRLEN + sizeof(u16)) )
+      {
+         u16 uFamilyId = 0;
+         memcpy(&uFamilyId, ((u8*)pAttr) + NLA_HDRLEN, sizeof(u16));
+         *piFamilyId = uFamilyId;
+         return 0;
+      }
+      iLength -= NLA_ALIGN(pAttr->nla_len);
+      pAttr = (struct nlattr*)(((u8*)pAttr) + NLA_ALIGN(pAttr->nla_len));
+   }
+   return 0;
+}
+
+static int _nl80211_resolve_family()
+{
+   if ( s_iNl80211FamilyId > 0 )
+      return s_iNl80211FamilyId;
+
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_msg_init(uBuffer, GENL_ID_CTRL, 0);
+   _nl80211_msg_put_genl_header(pMsg, CTRL_CMD_GETFAMILY);
+   _nl80211_msg_put_attr(pMsg, CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME, strlen(NL80211_GENL_NAME)+1);
+
+   int iFamilyId = -1;
+   int iRes = _nl80211_transact(s_iNl80211GenericFd, pMsg, _nl80211_family_id_callback, &iFamilyId);
+   if ( iFamilyId <= 0 )
+   {
+      log_softerror_and_alarm("[HardwareRadioNL80211] Failed to resolve nl80211 family id (error: %d).", iRes);
+      return (iRes < 0)?iRes:-ENOENT;
+   }
+   s_iNl80211FamilyId = iFamilyId;
+   log_line("[HardwareRadioNL80211] Resolved nl80211 family id: %d", s_iNl80211FamilyId);
+   return s_iNl80211FamilyId;
+}
+
+int hardware_radio_nl80211_init()
+{
+   if ( s_iNl80211UsesExternalSockets )
+      return 0;
+   if ( (s_iNl80211GenericFd >= 0) && (s_iNl80211RouteFd >= 0) )
+      return 0;
+
+   if ( s_iNl80211GenericFd < 0 )
+      s_iNl80211GenericFd = _nl80211_open_socket(NETLINK_GENERIC);
+   if ( s_iNl80211RouteFd < 0 )
+      s_iNl80211RouteFd = _nl80211_open_socket(NETLINK_ROUTE);
+
+   if ( (s_iNl80211GenericFd < 0) || (s_iNl80211RouteFd < 0) )
+   {
+      log_softerror_and_alarm("[HardwareRadioNL80211] Failed to open netlink sockets (generic: %d, route: %d), error: %s", s_iNl80211GenericFd, s_iNl80211RouteFd, strerror(errno));
+      return -ENOTCONN;
+   }
+   log_line("[HardwareRadioNL80211] Opened netlink sockets.");
+   return 0;
+}
+
+void hardware_radio_nl80211_uninit()
+{
+   if ( ! s_iNl80211UsesExternalSockets )
+   {
+      if ( s_iNl80211GenericFd >= 0 )
+         close(s_iNl80211GenericFd);
+      if ( s_iNl80211RouteFd >= 0 )
+         close(s_iNl80211RouteFd);
+   }
+   s_iNl80211GenericFd = -1;
+   s_iNl80211RouteFd = -1;
+   s_iNl80211UsesExternalSockets = 0;
+   s_iNl80211FamilyId = -1;
+}
+
+void hardware_radio_nl80211_use_sockets(int iGenericNetlinkFd, int iRouteNetlinkFd)
+{
+   hardware_radio_nl80211_uninit();
+   if ( (iGenericNetlinkFd < 0) && (iRouteNetlinkFd < 0) )
+      return;
+   s_iNl80211GenericFd = iGenericNetlinkFd;
+   s_iNl80211RouteFd = iRouteNetlinkFd;
+   s_iNl80211UsesExternalSockets = 1;
+}
+
+static struct nlmsghdr* _nl80211_prepare_command(u8* pBuffer, u8 uCommand, int iInterfaceIndex, int* piError)
+{
+   *piError = hardware_radio_nl80211_init();
+   if ( 0 != *piError )
+      return NULL;
+   int iFamilyId = _nl80211_resolve_family();
+   if ( iFamilyId < 0 )
+   {
+      *piError = iFamilyId;
+      return NULL;
+   }
+   struct nlmsghdr* pMsg = _nl80211_msg_init(pBuffer, (u16)iFamilyId, 0);
+   _nl80211_msg_put_genl_header(pMsg, uCommand);
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_IFINDEX, (u32)iInterfaceIndex);
+   return pMsg;
+}
+
+int hardware_radio_nl80211_set_frequency(const char* szInterfaceName, u32 uFrequencyKhz, int iHT40)
+{
+   int iIndex = _nl80211_resolve_interface(szInterfaceName);
+   if ( iIndex < 0 )
+      return iIndex;
+
+   int iError = 0;
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_prepare_command(uBuffer, NL80211_CMD_SET_WIPHY, iIndex, &iError);
+   if ( NULL == pMsg )
+      return iError;
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_WIPHY_FREQ, uFrequencyKhz/1000);
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_WIPHY_CHANNEL_TYPE, iHT40?NL80211_CHAN_HT40PLUS:NL80211_CHAN_NO_HT);
+   return _nl80211_transact(s_iNl80211GenericFd, pMsg, NULL, NULL);
+}
+
+int hardware_radio_nl80211_set_type_monitor(const char* szInterfaceName)
+{
+   int iIndex = _nl80211_resolve_interface(szInterfaceName);
+   if ( iIndex < 0 )
+      return iIndex;
+
+   int iError = 0;
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_prepare_command(uBuffer, NL80211_CMD_SET_INTERFACE, iIndex, &iError);
+   if ( NULL == pMsg )
+      return iError;
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_IFTYPE, NL80211_IFTYPE_MONITOR);
+   return _nl80211_transact(s_iNl80211GenericFd, pMsg, NULL, NULL);
+}
+
+int hardware_radio_nl80211_set_monitor_flags(const char* szInterfaceName, u32 uMonitorFlags)
+{
+   int iIndex = _nl80211_resolve_interface(szInterfaceName);
+   if ( iIndex < 0 )
+      return iIndex;
+
+   int iError = 0;
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_prepare_command(uBuffer, NL80211_CMD_SET_INTERFACE, iIndex, &iError);
+   if ( NULL == pMsg )
+      return iError;
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_IFTYPE, NL80211_IFTYPE_MONITOR);
+
+   // Nested flag attributes, an empty nest means no flags ("none")
+   struct nlattr* pNest = _nl80211_msg_put_attr(pMsg, NL80211_ATTR_MNTR_FLAGS | NLA_F_NESTED, NULL, 0);
+   for( int i=1; i<=NL80211_MNTR_FLAG_MAX; i++ )
+   {
+      if ( uMonitorFlags & (((u32)1)<<i) )
+      {
+         _nl80211_msg_put_attr(pMsg, (u16)i, NULL, 0);
+         pNest->nla_len += NLA_HDRLEN;
+      }
+   }
+   return _nl80211_transact(s_iNl80211GenericFd, pMsg, NULL, NULL);
+}
+
+int hardware_radio_nl80211_set_link_up(const char* szInterfaceName, int iUp)
+{
+   int iIndex = _nl80211_resolve_interface(szInterfaceName);
+   if ( iIndex < 0 )
+      return iIndex;
+
+   int iError = hardware_radio_nl80211_init();
+   if ( 0 != iError )
+      return iError;
+
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_msg_init(uBuffer, RTM_NEWLINK, 0);
+   struct ifinfomsg* pInfo = (struct ifinfomsg*)_nl80211_msg_put(pMsg, sizeof(struct ifinfomsg));
+   pInfo->ifi_family = AF_UNSPEC;
+   pInfo->ifi_index = iIndex;
+   pInfo->ifi_flags = iUp?IFF_UP:0;
+   pInfo->ifi_change = IFF_UP;
+   return _nl80211_transact(s_iNl80211RouteFd, pMsg, NULL, NULL);
+}
+
+// Iterates the attributes of a message payload or of a nested attribute
+
+static struct nlattr* _nl80211_attr_next(struct nlattr* pAttr, int* piRemaining)
+{
+   if ( (*piRemaining < NLA_HDRLEN) || (pAttr->nla_len < NLA_HDRLEN) || (pAttr->nla_len > *piRemaining) )
+      return NULL;
+   *piRemaining -= NLA_ALIGN(pAttr->nla_len);
+   if ( *piRemaining < NLA_HDRLEN )
+      return NULL;
+   pAttr = (struct nlattr*)(((u8*)pAttr) + NLA_ALIGN(pAttr->nla_len));
+   if ( (pAttr->nla_len < NLA_HDRLEN) || (pAttr->nla_len > *piRemaining) )
+      return NULL;
+   return pAttr;
+}
+
+static struct nlattr* _nl80211_attr_first(void* pData, int iLength, int* piRemaining)
+{
+   *piRemaining = iLength;
+   struct nlattr* pAttr = (struct nlattr*)pData;
+   if ( (iLength < NLA_HDRLEN) || (pAttr->nla_len < NLA_HDRLEN) || (pAttr->nla_len > iLength) )
+      return NULL;
+   return pAttr;
+}
+
+typedef struct
+{
+   int iPhyIndex;
+   u32* puFrequencies;
+   int iMaxFrequencies;
+   int iCountFrequencies;
+} t_nl80211_phy_frequencies;
+
+static void _nl80211_add_frequency(t_nl80211_phy_frequencies* pContext, u32 uFrequency)
+{
+   // Split dumps can repeat bands/channels
+   for( int i=0; i<pContext->iCountFrequencies; i++ )
+      if ( pContext->puFrequencies[i] == uFrequency )
+         return;
+   if ( pContext->iCountFrequencies < pContext->iMaxFrequencies )
+   {
+      pContext->puFrequencies[pContext->iCountFrequencies] = uFrequency;
+      pContext->iCountFrequencies++;
+   }
+}
+
+static int _nl80211_phy_frequencies_callback(struct nlmsghdr* pMsg, void* pContext)
+{
+   t_nl80211_phy_frequencies* pFreqs = (t_nl80211_phy_frequencies*)pContext;
+   int iRemaining = 0;
+   struct nlattr* pBands = NULL;
+   int iPhyIndex = -1;
+
+   struct nlattr* pAttr = _nl80211_attr_first(((u8*)NLMSG_DATA(pMsg)) + GENL_HDRLEN, (int)pMsg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), &iRemaining);
+   for( ; NULL != pAttr; pAttr = _nl80211_attr_next(pAttr, &iRemaining) )
+   {
+      if ( ((pAttr->nla_type & NLA_TYPE_MASK) == NL80211_ATTR_WIPHY) && (pAttr->nla_len >= NLA_HDRLEN + sizeof(u32)) )
+         memcpy(&iPhyIndex, ((u8*)pAttr) + NLA_HDRLEN, sizeof(u32));
+      if ( (pAttr->nla_type & NLA_TYPE_MASK) == NL80211_ATTR_WIPHY_BANDS )
+         pBands = pAttr;
+   }
+   if ( (iPhyIndex != pFreqs->iPhyIndex) || (NULL == pBands) )
+      return 0;
+
+   int iRemainingBands = 0;
+   struct nlattr* pBand = _nl80211_attr_first(((u8*)pBands) + NLA_HDRLEN, pBands->nla_len - NLA_HDRLEN, &iRemainingBands);
+   for( ; NULL != pBand; pBand = _nl80211_attr_next(pBand, &iRemainingBands) )
+   {
+      int iRemainingBandAttrs = 0;
+      struct nlattr* pBandAttr = _nl80211_attr_first(((u8*)pBand) + NLA_HDRLEN, pBand->nla_len - NLA_HDRLEN, &iRemainingBandAttrs);
+      for( ; NULL != pBandAttr; pBandAttr = _nl80211_attr_next(pBandAttr, &iRemainingBandAttrs) )
+      {
+         if ( (pBandAttr->nla_type & NLA_TYPE_MASK) != NL80211_BAND_ATTR_FREQS )
+            continue;
+         int iRemainingFreqs = 0;
+         struct nlattr* pFreq = _nl80211_attr_first(((u8*)pBandAttr) + NLA_HDRLEN, pBandAttr->nla_len - NLA_HDRLEN, &iRemainingFreqs);
+         for( ; NULL != pFreq; pFreq = _nl80211_attr_next(pFreq, &iRemainingFreqs) )
+         {
+            int iRemainingFreqAttrs = 0;
+            struct nlattr* pFreqAttr = _nl80211_attr_first(((u8*)pFreq) + NLA_HDRLEN, pFreq->nla_len - NLA_HDRLEN, &iRemainingFreqAttrs);
+            for( ; NULL != pFreqAttr; pFreqAttr = _nl80211_attr_next(pFreqAttr, &iRemainingFreqAttrs) )
+            {
+               if ( ((pFreqAttr->nla_type & NLA_TYPE_MASK) == NL80211_FREQUENCY_ATTR_FREQ) && (pFreqAttr->nla_len >= NLA_HDRLEN + sizeof(u32)) )
+               {
+                  u32 uFrequency = 0;
+                  memcpy(&uFrequency, ((u8*)pFreqAttr) + NLA_HDRLEN, sizeof(u32));
+                  _nl80211_add_frequency(pFreqs, uFrequency);
+               }
+            }
+         }
+      }
+   }
+   return 0;
+}
+
+int hardware_radio_nl80211_get_phy_frequencies(int iPhyIndex, u32* puFrequenciesMhz, int iMaxFrequencies)
+{
+   if ( (iPhyIndex < 0) || (NULL == puFrequenciesMhz) || (iMaxFrequencies <= 0) )
+      return -EINVAL;
+
+   int iError = hardware_radio_nl80211_init();
+   if ( 0 != iError )
+      return iError;
+   int iFamilyId = _nl80211_resolve_family();
+   if ( iFamilyId < 0 )
+      return iFamilyId;
+
+   u8 uBuffer[NL80211_MSG_BUFFER_SIZE];
+   struct nlmsghdr* pMsg = _nl80211_msg_init(uBuffer, (u16)iFamilyId, NLM_F_DUMP);
+   _nl80211_msg_put_genl_header(pMsg, NL80211_CMD_GET_WIPHY);
+   _nl80211_msg_put_u32(pMsg, NL80211_ATTR_WIPHY, (u32)iPhyIndex);
+   _nl80211_msg_put_attr(pMsg, NL80211_ATTR_SPLIT_WIPHY_DUMP, NULL, 0);
+
+   t_nl80211_phy_frequencies freqs;
+   freqs.iPhyIndex = iPhyIndex;
+   freqs.puFrequencies = puFrequenciesMhz;
+   freqs.iMaxFrequencies = iMaxFrequencies;
+   freqs.iCountFrequencies = 0;
+   iError = _nl80211_transact(s_iNl80211GenericFd, pMsg, _nl80211_phy_frequencies_callback, &freqs);
+   if ( iError < 0 )
+      return iError;
+   return freqs.iCountFrequencies;
+}
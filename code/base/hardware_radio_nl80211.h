@@ -0,0 +1,41 @@
+#pragma once
+#include "base.h"
+
+// In process nl80211 (generic netlink) and rtnetlink client used for the radio interfaces
+// configuration changes that used to fork iw/ip: set frequency, set type monitor, set monitor flags,
+// set link up/down; and for the supported channels query used by the radio interfaces enumeration.
+// All functions return 0 on success or a negative errno value (as returned by the kernel) on failure.
+
+#define HW_RADIO_NL80211_MONITOR_FLAGS_NONE 0
+#define HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL (((u32)1)<<1)    // 1 << NL80211_MNTR_FLAG_FCSFAIL
+#define HW_RADIO_NL80211_MONITOR_FLAG_PLCPFAIL (((u32)1)<<2)   // 1 << NL80211_MNTR_FLAG_PLCPFAIL
+#define HW_RADIO_NL80211_MONITOR_FLAG_CONTROL (((u32)1)<<3)    // 1 << NL80211_MNTR_FLAG_CONTROL
+#define HW_RADIO_NL80211_MONITOR_FLAG_OTHER_BSS (((u32)1)<<4)  // 1 << NL80211_MNTR_FLAG_OTHER_BSS
+
+#define HW_RADIO_NL80211_TIMEOUT_MS 500
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+// Opens the netlink sockets. Called automatically on first use.
+int hardware_radio_nl80211_init();
+void hardware_radio_nl80211_uninit();
+
+// For tests: use the provided (already connected) sockets instead of the kernel netlink sockets.
+// The sockets must preserve message boundaries (i.e. SOCK_SEQPACKET socketpair).
+// Pass -1, -1 to go back to the kernel sockets.
+void hardware_radio_nl80211_use_sockets(int iGenericNetlinkFd, int iRouteNetlinkFd);
+
+int hardware_radio_nl80211_set_frequency(const char* szInterfaceName, u32 uFrequencyKhz, int iHT40);
+int hardware_radio_nl80211_set_type_monitor(const char* szInterfaceName);
+int hardware_radio_nl80211_set_monitor_flags(const char* szInterfaceName, u32 uMonitorFlags);
+int hardware_radio_nl80211_set_link_up(const char* szInterfaceName, int iUp);
+
+// Gets the list of channels frequencies (in Mhz) supported by a phy (same list as "iw phyX info").
+// Returns the number of frequencies or a negative errno value on failure.
+int hardware_radio_nl80211_get_phy_frequencies(int iPhyIndex, u32* puFrequenciesMhz, int iMaxFrequencies);
+
+#ifdef __cplusplus
+}  
+#endif 
@@ -483,14 +483,10 @@ int _hardware_radio_sik_get_all_params(radio_hw_info_t* pRadioInfo, int iSerialP
       bufferResponse[62] = 0;
       strcpy(pRadioInfo->szDescription, (char*)bufferResponse);
 
-      s_iSiKFirmwareIsOld = 0;
+      // Only the radio info is updated here, it can run on the probe threads; callers update s_iSiKFirmwareIsOld
       pRadioInfo->uExtraFlags &= ~RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD;
-
       if ( NULL == strstr((char*)bufferResponse, "SiK 2.2") )
-      {
-         s_iSiKFirmwareIsOld = 1;
          pRadioInfo->uExtraFlags |= RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD;
-      }
    }
    if ( NULL != pProcessStats )
       pProcessStats->lastActiveTime = get_current_timestamp_ms();
@@ -591,6 +587,28 @@ int _hardware_radio_sik_get_all_params(radio_hw_info_t* pRadioInfo, int iSerialP
    return 1;
 }
 
+#define SIK_PROBE_MAX_PORTS 3
+
+typedef struct
+{
+   char szSerialPort[32];
+   pthread_t pThread;
+   int iThreadStarted;
+   int iFound;
+   int iSpeed;
+   radio_hw_info_t radioInfo;
+} t_sik_probe_context;
+
+static int _hardware_radio_sik_probe_port(const char* szSerialPort, radio_hw_info_t* pRadioInfo, int* piOutputSpeed);
+static void _hardware_radio_sik_mark_serial_port_used(const char* szDevName, int iSpeed);
+
+static void* _thread_sik_probe_port(void *argument)
+{
+   t_sik_probe_context* pContext = (t_sik_probe_context*)argument;
+   pContext->iFound = _hardware_radio_sik_probe_port(pContext->szSerialPort, &pContext->radioInfo, &pContext->iSpeed);
+   return NULL;
+}
+
 int hardware_radio_sik_detect_interfaces()
 {
    log_line("[HardwareRadio]: Enumerating Sik radios...");
@@ -602,25 +620,49 @@ int hardware_radio_sik_detect_interfaces()
 
    s_iSiKRadioCount = 0;
 
-   radio_hw_info_t* pRadioInfo = hardware_radio_sik_try_detect_on_port("ttyUSB0");
-   if ( (NULL != pRadioInfo) && ( hardware_get_radio_interfaces_count() < MAX_RADIO_INTERFACES ) )
+   // Each port probe takes up to a few seconds (AT command mode guard times, baud rates
+   // scan), so probe all the serial ports in parallel and add the found radios in ports order.
+
+   // Make sure the serial ports are initialized before the probing threads use them
+   hardware_get_serial_ports_count();
+
+   t_sik_probe_context probes[SIK_PROBE_MAX_PORTS];
+   for( int i=0; i<SIK_PROBE_MAX_PORTS; i++ )
    {
-      pRadioInfo->phy_index = 0;
-      strcpy(pRadioInfo->szUSBPort, "TU-0");
-      hardware_add_radio_interface_info(pRadioInfo);
+      memset(&probes[i], 0, sizeof(t_sik_probe_context));
+      sprintf(probes[i].szSerialPort, "ttyUSB%d", i);
+      char szDevName[64];
+      snprintf(szDevName, sizeof(szDevName)/sizeof(szDevName[0]), "/dev/%s", probes[i].szSerialPort);
+      if ( access(szDevName, R_OK) == -1 )
+      {
+         log_line("[HardwareRadio]: Device [%s] is not present.", szDevName);
+         continue;
+      }
+      if ( 0 == pthread_create(&probes[i].pThread, NULL, &_thread_sik_probe_port, (void*)&probes[i]) )
+         probes[i].iThreadStarted = 1;
+      else
+      {
+         log_softerror_and_alarm("[HardwareRadio]: Failed to create thread to probe [%s]. Probe it now.", szDevName);
+         _thread_sik_probe_port((void*)&probes[i]);
+      }
    }
 
-   pRadioInfo = hardware_radio_sik_try_detect_on_port("ttyUSB1");
-   if ( (NULL != pRadioInfo) && ( hardware_get_radio_interfaces_count() < MAX_RADIO_INTERFACES ) )
+   for( int i=0; i<SIK_PROBE_MAX_PORTS; i++ )
    {
-      pRadioInfo->phy_index = 0;
-      strcpy(pRadioInfo->szUSBPort, "TU-0");
-      hardware_add_radio_interface_info(pRadioInfo);
+      if ( probes[i].iThreadStarted )
+         pthread_join(probes[i].pThread, NULL);
    }
 
-   pRadioInfo = hardware_radio_sik_try_detect_on_port("ttyUSB2");
-   if ( (NULL != pRadioInfo) && ( hardware_get_radio_interfaces_count() < MAX_RADIO_INTERFACES ) )
+   radio_hw_info_t* pRadioInfo = NULL;
+   for( int i=0; i<SIK_PROBE_MAX_PORTS; i++ )
    {
+      if ( ! probes[i].iFound )
+         continue;
+      pRadioInfo = &probes[i].radioInfo;
+      s_iSiKFirmwareIsOld = (pRadioInfo->uExtraFlags & RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD)?1:0;
+      _hardware_radio_sik_mark_serial_port_used(pRadioInfo->szDriver, probes[i].iSpeed);
+      if ( hardware_get_radio_interfaces_count() >= MAX_RADIO_INTERFACES )
+         continue;
       pRadioInfo->phy_index = 0;
       strcpy(pRadioInfo->szUSBPort, "TU-0");
       hardware_add_radio_interface_info(pRadioInfo);
@@ -782,10 +824,13 @@ int hardware_radio_sik_load_configuration()
 }
 
 
-radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
+// Probes a serial port for a SiK radio. Does not change any global state, so it can run
+// concurrently for different serial ports. Returns 1 if a SiK radio was found.
+
+static int _hardware_radio_sik_probe_port(const char* szSerialPort, radio_hw_info_t* pRadioInfo, int* piOutputSpeed)
 {
    if ( NULL == szSerialPort || 0 == szSerialPort[0] )
-      return NULL;
+      return 0;
 
    char szDevName[128];
    strcpy(szDevName, szSerialPort);
@@ -796,7 +841,7 @@ radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
    if ( access( szDevName, R_OK ) == -1 )
    {
       log_line("[HardwareRadio]: Device [%s] is not present.", szDevName);
-      return NULL;
+      return 0;
    }
    
    int iBaudRatesList[64];
@@ -828,21 +873,20 @@ radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
       if ( iSerialPort <= 0 )
          continue;
 
-      static radio_hw_info_t s_radioHWInfoSikTemp;
-      memset((u8*)&s_radioHWInfoSikTemp, 0, sizeof(radio_hw_info_t));
+      memset((u8*)pRadioInfo, 0, sizeof(radio_hw_info_t));
       
-      if ( ! _hardware_radio_sik_get_all_params(&s_radioHWInfoSikTemp, iSerialPort, iSpeed, NULL, 1) )
+      if ( ! _hardware_radio_sik_get_all_params(pRadioInfo, iSerialPort, iSpeed, NULL, 1) )
       {
          log_line("[HardwareRadio] Closed serial port fd %d", iSerialPort);
          close(iSerialPort);
          continue;
       }
 
-      strcat(s_radioHWInfoSikTemp.szMAC, "-");
-      strcat(s_radioHWInfoSikTemp.szMAC, szSerialPort + (strlen(szSerialPort)-1));
+      strcat(pRadioInfo->szMAC, "-");
+      strcat(pRadioInfo->szMAC, szSerialPort + (strlen(szSerialPort)-1));
       log_line("[HardwareRadio]: Found SiK Radio on port %s, baud: %d, MAC: [%s], firmware is up to date: %s",
-         szDevName, iSpeed, s_radioHWInfoSikTemp.szMAC,
-         (s_radioHWInfoSikTemp.uExtraFlags & RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD)?"no":"yes");
+         szDevName, iSpeed, pRadioInfo->szMAC,
+         (pRadioInfo->uExtraFlags & RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD)?"no":"yes");
 
       char szTmp[256];
       szTmp[0] = 0;
@@ -852,16 +896,16 @@ radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
             strcat(szTmp, ", ");
 
          char szB[32];
-         sprintf(szB, "[%d]=%u", k, s_radioHWInfoSikTemp.uHardwareParamsList[k]);
+         sprintf(szB, "[%d]=%u", k, pRadioInfo->uHardwareParamsList[k]);
          strcat(szTmp, szB);
       }
       log_line("[HardwareRadio]: SiK current parameters: %s", szTmp);
 
       log_line("[HardwareRadio] SiK current read params: Air Speed: %u, ECC/LBT/MCSTR: %u/%u/%u",
-         s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_AIRSPEED],
-         s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_ECC],
-         s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_LBT],
-         s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_MCSTR]);
+         pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_AIRSPEED],
+         pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_ECC],
+         pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_LBT],
+         pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_MCSTR]);
 
       // Found SiK device that answered to AT commands mode.
       // Populate info about device
@@ -869,57 +913,70 @@ radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
       log_line("[HardwareRadio] Closed serial port fd %d", iSerialPort);
       close(iSerialPort);
 
-      s_radioHWInfoSikTemp.iRadioType = RADIO_TYPE_SIK;
-      s_radioHWInfoSikTemp.iRadioDriver = RADIO_HW_DRIVER_SERIAL_SIK;
-      s_radioHWInfoSikTemp.iCardModel = CARD_MODEL_SIK_RADIO;
-      s_radioHWInfoSikTemp.isSerialRadio = 1;
-      s_radioHWInfoSikTemp.isConfigurable = 1;
-      s_radioHWInfoSikTemp.isSupported = 1;
-      s_radioHWInfoSikTemp.isHighCapacityInterface = 0;
-      s_radioHWInfoSikTemp.isEnabled = 1;
-      s_radioHWInfoSikTemp.isTxCapable = 1;
+      pRadioInfo->iRadioType = RADIO_TYPE_SIK;
+      pRadioInfo->iRadioDriver = RADIO_HW_DRIVER_SERIAL_SIK;
+      pRadioInfo->iCardModel = CARD_MODEL_SIK_RADIO;
+      pRadioInfo->isSerialRadio = 1;
+      pRadioInfo->isConfigurable = 1;
+      pRadioInfo->isSupported = 1;
+      pRadioInfo->isHighCapacityInterface = 0;
+      pRadioInfo->isEnabled = 1;
+      pRadioInfo->isTxCapable = 1;
       
-      strcpy(s_radioHWInfoSikTemp.szName, "SiK Radio");
-      strcpy(s_radioHWInfoSikTemp.szUSBPort, "T");
-      strcpy(s_radioHWInfoSikTemp.szDriver, szDevName);
-      sprintf(s_radioHWInfoSikTemp.szProductId, "%u", s_radioHWInfoSikTemp.uHardwareParamsList[0]);
+      strcpy(pRadioInfo->szName, "SiK Radio");
+      strcpy(pRadioInfo->szUSBPort, "T");
+      strcpy(pRadioInfo->szDriver, szDevName);
+      sprintf(pRadioInfo->szProductId, "%u", pRadioInfo->uHardwareParamsList[0]);
       
-      s_radioHWInfoSikTemp.uCurrentFrequencyKhz = s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN];
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 400000 )
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 460000 )
-         s_radioHWInfoSikTemp.supportedBands = RADIO_HW_SUPPORTED_BAND_433;
-
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 800000 )
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 890000 )
-         s_radioHWInfoSikTemp.supportedBands = RADIO_HW_SUPPORTED_BAND_868;
-
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 891000 )
-      if ( s_radioHWInfoSikTemp.uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 950000 )
-         s_radioHWInfoSikTemp.supportedBands = RADIO_HW_SUPPORTED_BAND_915;
-
+      pRadioInfo->uCurrentFrequencyKhz = pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN];
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 400000 )
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 460000 )
+         pRadioInfo->supportedBands = RADIO_HW_SUPPORTED_BAND_433;
+
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 800000 )
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 890000 )
+         pRadioInfo->supportedBands = RADIO_HW_SUPPORTED_BAND_868;
+
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MIN] >= 891000 )
+      if ( pRadioInfo->uHardwareParamsList[SIK_PARAM_INDEX_FREQ_MAX] <= 950000 )
+         pRadioInfo->supportedBands = RADIO_HW_SUPPORTED_BAND_915;
+      *piOutputSpeed = iSpeed;
+      return 1;
+   }
 
-      // Mark the serial port as used for a hardware radio interface
+   return 0;
+}
 
-      log_line("[HardwareRadio]: Mark serial device [%s] as used for a radio interface.", szDevName);
-      
-      for( int k=0; k<hardware_get_serial_ports_count(); k++ )
+static void _hardware_radio_sik_mark_serial_port_used(const char* szDevName, int iSpeed)
+{
+   log_line("[HardwareRadio]: Mark serial device [%s] as used for a radio interface.", szDevName);
+   
+   for( int k=0; k<hardware_get_serial_ports_count(); k++ )
+   {
+      hw_serial_port_info_t* pSerial = hardware_get_serial_port_info(k);
+      if ( NULL == pSerial )
+         continue;
+      if ( 0 == strcmp(pSerial->szPortDeviceName, szDevName) )
       {
-         hw_serial_port_info_t* pSerial = hardware_get_serial_port_info(k);
-         if ( NULL == pSerial )
-            continue;
-         if ( 0 == strcmp(pSerial->szPortDeviceName, szDevName) )
-         {
-            pSerial->iPortUsage = SERIAL_PORT_USAGE_SIK_RADIO;
-            pSerial->lPortSpeed = iSpeed;
-            pSerial->iSupported = 1;
-            hardware_serial_save_configuration();
-            break;
-         }
+         pSerial->iPortUsage = SERIAL_PORT_USAGE_SIK_RADIO;
+         pSerial->lPortSpeed = iSpeed;
+         pSerial->iSupported = 1;
+         hardware_serial_save_configuration();
+         break;
       }
-      return &s_radioHWInfoSikTemp;
    }
+}
+
+radio_hw_info_t* hardware_radio_sik_try_detect_on_port(const char* szSerialPort)
+{
+   static radio_hw_info_t s_radioHWInfoSikTemp;
+   int iSpeed = 0;
+   if ( ! _hardware_radio_sik_probe_port(szSerialPort, &s_radioHWInfoSikTemp, &iSpeed) )
+      return NULL;
 
-   return NULL; 
+   // Mark the serial port as used for a hardware radio interface
+   _hardware_radio_sik_mark_serial_port_used(s_radioHWInfoSikTemp.szDriver, iSpeed);
+   return &s_radioHWInfoSikTemp;
 }
 
 // Returns number of bytes in response
@@ -1193,6 +1250,7 @@ int hardware_radio_sik_get_all_params(radio_hw_info_t* pRadioInfo, shared_mem_pr
       close(iSerialPort);
       return 0;
    }
+   s_iSiKFirmwareIsOld = (pRadioInfo->uExtraFlags & RADIO_HW_EXTRA_FLAG_FIRMWARE_OLD)?1:0;
 
    char szTmp[256];
    szTmp[0] = 0;
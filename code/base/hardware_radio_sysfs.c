@@ -0,0 +1,370 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <dirent.h>
+#include <unistd.h>
+#include <ctype.h>
+
+#include "base.h"
+#include "config_file_names.h"
+#include "hardware_radio_sysfs.h"
+
+static char s_szHardwareSysfsRoot[MAX_FILE_PATH_SIZE] = "/sys/";
+
+void hardware_radio_sysfs_set_root(const char* szRootFolder)
+{
+   if ( (NULL == szRootFolder) || (0 == szRootFolder[0]) )
+   {
+      strcpy(s_szHardwareSysfsRoot, "/sys/");
+      return;
+   }
+   strncpy(s_szHardwareSysfsRoot, szRootFolder, MAX_FILE_PATH_SIZE-2);
+   s_szHardwareSysfsRoot[MAX_FILE_PATH_SIZE-2] = 0;
+   if ( s_szHardwareSysfsRoot[strlen(s_szHardwareSysfsRoot)-1] != '/' )
+      strcat(s_szHardwareSysfsRoot, "/");
+}
+
+const char* hardware_radio_sysfs_get_root()
+{
+   return s_szHardwareSysfsRoot;
+}
+
+static void _hardware_sysfs_build_path(const char* szRelativePath, char* szOutput)
+{
+   snprintf(szOutput, MAX_FILE_PATH_SIZE, "%s%s", s_szHardwareSysfsRoot, szRelativePath);
+}
+
+int hardware_radio_sysfs_read_file(const char* szRelativePath, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return -1;
+   szOutput[0] = 0;
+
+   char szPath[MAX_FILE_PATH_SIZE];
+   _hardware_sysfs_build_path(szRelativePath, szPath);
+   int iFd = open(szPath, O_RDONLY);
+   if ( iFd < 0 )
+      return -1;
+
+   int iLength = 0;
+   while ( iLength < iMaxLength-1 )
+   {
+      int iRead = read(iFd, szOutput + iLength, iMaxLength - 1 - iLength);
+      if ( iRead <= 0 )
+         break;
+      iLength += iRead;
+   }
+   close(iFd);
+   szOutput[iLength] = 0;
+   while ( (iLength > 0) && ((szOutput[iLength-1] == 10) || (szOutput[iLength-1] == 13)) )
+   {
+      iLength--;
+      szOutput[iLength] = 0;
+   }
+   return iLength;
+}
+
+int hardware_radio_sysfs_read_uevent_value(const char* szRelativePath, const char* szKey, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szKey) || (NULL == szOutput) || (iMaxLength < 1) )
+      return 0;
+   szOutput[0] = 0;
+
+   char szBuff[2048];
+   if ( hardware_radio_sysfs_read_file(szRelativePath, szBuff, sizeof(szBuff)) <= 0 )
+      return 0;
+
+   int iKeyLength = strlen(szKey);
+   char* pLine = szBuff;
+   while ( (NULL != pLine) && (0 != *pLine) )
+   {
+      char* pLineEnd = strchr(pLine, '\n');
+      if ( NULL != pLineEnd )
+         *pLineEnd = 0;
+      if ( (0 == strncmp(pLine, szKey, iKeyLength)) && (pLine[iKeyLength] == '=') )
+      {
+         strncpy(szOutput, pLine + iKeyLength + 1, iMaxLength-1);
+         szOutput[iMaxLength-1] = 0;
+         return 1;
+      }
+      pLine = (NULL != pLineEnd)?(pLineEnd+1):NULL;
+   }
+   return 0;
+}
+
+int hardware_radio_sysfs_read_link_name(const char* szRelativePath, char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return -1;
+   szOutput[0] = 0;
+
+   char szPath[MAX_FILE_PATH_SIZE];
+   char szTarget[MAX_FILE_PATH_SIZE];
+   _hardware_sysfs_build_path(szRelativePath, szPath);
+   int iLength = readlink(szPath, szTarget, sizeof(szTarget)-1);
+   if ( iLength <= 0 )
+      return -1;
+   szTarget[iLength] = 0;
+   char* pName = strrchr(szTarget, '/');
+   pName = (NULL != pName)?(pName+1):szTarget;
+   strncpy(szOutput, pName, iMaxLength-1);
+   szOutput[iMaxLength-1] = 0;
+   return strlen(szOutput);
+}
+
+int hardware_radio_sysfs_list_folder(const char* szRelativeFolder, const char* szPrefix, char szEntries[][HW_SYSFS_MAX_NAME_LENGTH], int iMaxEntries)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   _hardware_sysfs_build_path(szRelativeFolder, szPath);
+   DIR* pDir = opendir(szPath);
+   if ( NULL == pDir )
+      return 0;
+
+   int iPrefixLength = (NULL != szPrefix)?strlen(szPrefix):0;
+   int iCountFound = 0;
+   int iCount = 0;
+   struct dirent* pEntry = NULL;
+   while ( NULL != (pEntry = readdir(pDir)) )
+   {
+      if ( pEntry->d_name[0] == '.' )
+         continue;
+      if ( (iPrefixLength > 0) && (0 != strncmp(pEntry->d_name, szPrefix, iPrefixLength)) )
+         continue;
+      iCountFound++;
+
+      // Keep the first iMaxEntries names in ls order, whatever the directory order is
+      int iInsert = iCount;
+      while ( (iInsert > 0) && (strcmp(szEntries[iInsert-1], pEntry->d_name) > 0) )
+         iInsert--;
+      if ( iInsert >= iMaxEntries )
+         continue;
+      if ( iCount == iMaxEntries )
+         iCount--;
+      for( int i=iCount; i>iInsert; i-- )
+         strcpy(szEntries[i], szEntries[i-1]);
+      strncpy(szEntries[iInsert], pEntry->d_name, HW_SYSFS_MAX_NAME_LENGTH-1);
+      szEntries[iInsert][HW_SYSFS_MAX_NAME_LENGTH-1] = 0;
+      iCount++;
+   }
+   closedir(pDir);
+   return iCountFound;
+}
+
+int hardware_radio_sysfs_get_wifi_interfaces(char szInterfaces[][HW_SYSFS_MAX_NAME_LENGTH], int iMaxInterfaces)
+{
+   char szEntries[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
+   int iCountEntries = hardware_radio_sysfs_list_folder("class/net", NULL, szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries > HW_SYSFS_MAX_FOLDER_ENTRIES )
+      iCountEntries = HW_SYSFS_MAX_FOLDER_ENTRIES;
+   const char* szExcluded[] = { "eth0", "lo", "usb", "intwifi", "relay", "wifihotspot", "wlx" };
+
+   int iCount = 0;
+   for( int i=0; (i<iCountEntries) && (iCount < iMaxInterfaces); i++ )
+   {
+      if ( NULL == strstr(szEntries[i], "wlan") )
+         continue;
+      int bExcluded = 0;
+      for( int k=0; k<(int)(sizeof(szExcluded)/sizeof(szExcluded[0])); k++ )
+         if ( NULL != strstr(szEntries[i], szExcluded[k]) )
+            bExcluded = 1;
+      if ( bExcluded )
+         continue;
+      strcpy(szInterfaces[iCount], szEntries[i]);
+      iCount++;
+   }
+   return iCount;
+}
+
+int hardware_radio_sysfs_get_interface_driver(const char* szInterfaceName, char* szDriver, int iMaxLength)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   snprintf(szPath, sizeof(szPath), "class/net/%s/device/uevent", szInterfaceName);
+   if ( hardware_radio_sysfs_read_uevent_value(szPath, "DRIVER", szDriver, iMaxLength) )
+      return 1;
+   snprintf(szPath, sizeof(szPath), "class/net/%s/device/driver", szInterfaceName);
+   if ( hardware_radio_sysfs_read_link_name(szPath, szDriver, iMaxLength) > 0 )
+      return 1;
+   return 0;
+}
+
+int hardware_radio_sysfs_get_interface_mac(const char* szInterfaceName, char* szMAC, int iMaxLength)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   char szAddress[64];
+   snprintf(szPath, sizeof(szPath), "class/net/%s/address", szInterfaceName);
+   if ( hardware_radio_sysfs_read_file(szPath, szAddress, sizeof(szAddress)) <= 0 )
+      return 0;
+
+   // Same format as the stored MACs: upper case, no separators
+   int iPos = 0;
+   for( int i=0; (0 != szAddress[i]) && (iPos < iMaxLength-1); i++ )
+   {
+      if ( (szAddress[i] == ':') || isspace(szAddress[i]) )
+         continue;
+      szMAC[iPos++] = toupper(szAddress[i]);
+   }
+   szMAC[iPos] = 0;
+   return (iPos > 0)?1:0;
+}
+
+int hardware_radio_sysfs_get_interface_phy_index(const char* szInterfaceName)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   char szBuff[64];
+   snprintf(szPath, sizeof(szPath), "class/net/%s/phy80211/index", szInterfaceName);
+   if ( hardware_radio_sysfs_read_file(szPath, szBuff, sizeof(szBuff)) > 0 )
+   if ( isdigit(szBuff[0]) )
+      return atoi(szBuff);
+
+   snprintf(szPath, sizeof(szPath), "class/net/%s/phy80211", szInterfaceName);
+   if ( hardware_radio_sysfs_read_link_name(szPath, szBuff, sizeof(szBuff)) > 3 )
+   if ( (0 == strncmp(szBuff, "phy", 3)) && isdigit(szBuff[3]) )
+      return atoi(szBuff+3);
+   return -1;
+}
+
+int hardware_radio_sysfs_get_usb_devices_description(char* szOutput, int iMaxLength)
+{
+   if ( (NULL == szOutput) || (iMaxLength < 1) )
+      return 0;
+   szOutput[0] = 0;
+
+   char szEntries[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
+   int iCountEntries = hardware_radio_sysfs_list_folder("bus/usb/devices", NULL, szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries > HW_SYSFS_MAX_FOLDER_ENTRIES )
+      iCountEntries = HW_SYSFS_MAX_FOLDER_ENTRIES;
+   int iCount = 0;
+   int iPos = 0;
+   for( int i=0; i<iCountEntries; i++ )
+   {
+      // Skip USB interfaces (x-y:a.b), keep only devices
+      if ( NULL != strchr(szEntries[i], ':') )
+         continue;
+
+      char szPath[MAX_FILE_PATH_SIZE];
+      char szVendor[16];
+      char szProduct[16];
+      char szBus[16];
+      char szDevice[16];
+      char szManufacturer[64];
+      char szProductName[64];
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/idVendor", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szVendor, sizeof(szVendor)) <= 0 )
+         continue;
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/idProduct", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szProduct, sizeof(szProduct)) <= 0 )
+         continue;
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/busnum", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szBus, sizeof(szBus)) <= 0 )
+         strcpy(szBus, "0");
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/devnum", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szDevice, sizeof(szDevice)) <= 0 )
+         strcpy(szDevice, "0");
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/manufacturer", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szManufacturer, sizeof(szManufacturer)) < 0 )
+         szManufacturer[0] = 0;
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/product", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szProductName, sizeof(szProductName)) < 0 )
+         szProductName[0] = 0;
+
+      int iLen = snprintf(szOutput + iPos, iMaxLength - iPos, "Bus %03d Device %03d: ID %s:%s %s %s\n",
+         atoi(szBus), atoi(szDevice), szVendor, szProduct, szManufacturer, szProductName);
+      if ( (iLen < 0) || (iPos + iLen >= iMaxLength) )
+      {
+         szOutput[iPos] = 0;
+         break;
+      }
+      iPos += iLen;
+      iCount++;
+   }
+   return iCount;
+}
+
+u32 hardware_radio_sysfs_get_topology_signature()
+{
+   char szBuff[4096];
+   int iPos = 0;
+   char szEntries[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
+   char szPath[MAX_FILE_PATH_SIZE];
+   char szValue[64];
+
+   // A truncated list could hide a change, the caller must then do a full enumeration
+   int iCountEntries = hardware_radio_sysfs_list_folder("bus/usb/devices", NULL, szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries > HW_SYSFS_MAX_FOLDER_ENTRIES )
+      return HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN;
+   for( int i=0; i<iCountEntries; i++ )
+   {
+      if ( NULL != strchr(szEntries[i], ':') )
+         continue;
+      iPos += snprintf(szBuff + iPos, sizeof(szBuff) - iPos, "%s=", szEntries[i]);
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/idVendor", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szValue, sizeof(szValue)) > 0 )
+         iPos += snprintf(szBuff + iPos, sizeof(szBuff) - iPos, "%s:", szValue);
+      snprintf(szPath, sizeof(szPath), "bus/usb/devices/%s/idProduct", szEntries[i]);
+      if ( hardware_radio_sysfs_read_file(szPath, szValue, sizeof(szValue)) > 0 )
+         iPos += snprintf(szBuff + iPos, sizeof(szBuff) - iPos, "%s;", szValue);
+      if ( iPos >= (int)sizeof(szBuff) - 128 )
+         break;
+   }
+
+   // Only the radio interfaces, other network interfaces (hotspot, usb tethering) come and go
+   iCountEntries = hardware_radio_sysfs_get_wifi_interfaces(szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries >= HW_SYSFS_MAX_FOLDER_ENTRIES )
+      return HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN;
+   for( int i=0; i<iCountEntries; i++ )
+   {
+      if ( iPos >= (int)sizeof(szBuff) - 128 )
+         break;
+      if ( ! hardware_radio_sysfs_get_interface_driver(szEntries[i], szValue, sizeof(szValue)) )
+         szValue[0] = 0;
+      iPos += snprintf(szBuff + iPos, sizeof(szBuff) - iPos, "%s=%s;", szEntries[i], szValue);
+   }
+
+   // Serial ports that can have SiK radios
+   iCountEntries = hardware_radio_sysfs_list_folder("class/tty", "ttyUSB", szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   if ( iCountEntries > HW_SYSFS_MAX_FOLDER_ENTRIES )
+      return HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN;
+   for( int i=0; i<iCountEntries; i++ )
+   {
+      if ( iPos >= (int)sizeof(szBuff) - 128 )
+         return HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN;
+      iPos += snprintf(szBuff + iPos, sizeof(szBuff) - iPos, "%s;", szEntries[i]);
+   }
+
+   if ( iPos > (int)sizeof(szBuff) )
+      return HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN;
+   u32 uSignature = base_compute_crc32((u8*)szBuff, iPos);
+   if ( HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN == uSignature )
+      uSignature++;
+   return uSignature;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "base.h"
+
+// Fork free access to the sysfs info used by the radio interfaces enumeration.
+// All paths are relative to the sysfs root folder ("/sys/" by default),
+// which can be changed to point to a fake sysfs tree (for tests).
+
+#define HW_SYSFS_MAX_NAME_LENGTH 64
+#define HW_SYSFS_MAX_FOLDER_ENTRIES 64
+#define HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN 0
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+void hardware_radio_sysfs_set_root(const char* szRootFolder);
+const char* hardware_radio_sysfs_get_root();
+
+// Returns the number of bytes read (trailing new lines removed) or -1 on failure
+int hardware_radio_sysfs_read_file(const char* szRelativePath, char* szOutput, int iMaxLength);
+// Returns 1 if the key was found in the uevent file and copies it's value to szOutput
+int hardware_radio_sysfs_read_uevent_value(const char* szRelativePath, const char* szKey, char* szOutput, int iMaxLength);
+// Returns the last part of the target of a symbolic link, or -1 on failure
+int hardware_radio_sysfs_read_link_name(const char* szRelativePath, char* szOutput, int iMaxLength);
+// Lists the entries of the folder that start with szPrefix (all if NULL), excluding the hidden ones.
+// Stores the first iMaxEntries of them, sorted alphabetically. Returns the total number of matching entries, can be more than iMaxEntries.
+int hardware_radio_sysfs_list_folder(const char* szRelativeFolder, const char* szPrefix, char szEntries[][HW_SYSFS_MAX_NAME_LENGTH], int iMaxEntries);
+
+// Network interfaces that can be radio interfaces (wlanX), sorted by name
+int hardware_radio_sysfs_get_wifi_interfaces(char szInterfaces[][HW_SYSFS_MAX_NAME_LENGTH], int iMaxInterfaces);
+int hardware_radio_sysfs_get_interface_driver(const char* szInterfaceName, char* szDriver, int iMaxLength);
+int hardware_radio_sysfs_get_interface_mac(const char* szInterfaceName, char* szMAC, int iMaxLength);
+int hardware_radio_sysfs_get_interface_phy_index(const char* szInterfaceName);
+
+// Builds lsusb like lines (Bus xxx Device xxx: ID vvvv:pppp Manufacturer Product) for all USB devices.
+// Returns the number of USB devices found
+int hardware_radio_sysfs_get_usb_devices_description(char* szOutput, int iMaxLength);
+
+// Signature of the current radio hardware topology (USB device paths and ids, wifi interfaces and their drivers, USB serial ports)
+// Returns HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN if it can't be computed completely (too many entries)
+u32 hardware_radio_sysfs_get_topology_signature();
+
+#ifdef __cplusplus
+}  
+#endif 
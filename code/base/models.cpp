@@ -33,6 +33,7 @@
 
 #include "base.h"
 #include "models.h"
+#include "models_binary.h"
 #include <stdlib.h>
 #include <math.h>
 #include "config.h"
@@ -266,20 +267,84 @@ bool Model::reloadIfChanged(bool bLoadStats)
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_CONFIG);
    strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
-   FILE* fd = fopen(szFile, "r");
+   FILE* fd = fopen(szFile, "rb");
    if ( NULL == fd )
       return false;
 
-   int iV, iS = 0;
-   if ( 1 == fscanf(fd, "%*s %d", &iV) )
-   if ( 1 == fscanf(fd, "%*s %d", &iS) )
+   // Binary model files have the save counter in the header
+   t_model_binary_header header;
+   memset((u8*)&header, 0, sizeof(t_model_binary_header));
+   int iS = iSaveCount;
+   if ( sizeof(t_model_binary_header) == fread((u8*)&header, 1, sizeof(t_model_binary_header), fd) )
+   if ( header.uMagic == MODEL_BINARY_MAGIC )
+      iS = (int)header.uSaveCount;
+
+   if ( header.uMagic != MODEL_BINARY_MAGIC )
+   {
+      int iV = 0;
+      fseek(fd, 0, SEEK_SET);
+      if ( 1 == fscanf(fd, "%*s %d", &iV) )
+      if ( 1 != fscanf(fd, "%*s %d", &iS) )
+         iS = iSaveCount;
+   }
+   fclose(fd);
+
    if ( iS != iSaveCount )
    {
       log_line("Model: changed. Reload");
-      fclose(fd);
       return loadFromFile(szFile, bLoadStats);
    }
+   return true;
+}
+
+// Loads a binary or a text (version 8...10) model file
+
+bool Model::loadFile(const char* szFile)
+{
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+      return false;
+
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   int iLength = fread(uBuffer, 1, sizeof(u32), fd);
+   if ( (iLength == (int)sizeof(u32)) && (*((u32*)uBuffer) == MODEL_BINARY_MAGIC) )
+   {
+      iLength += fread(uBuffer + iLength, 1, sizeof(uBuffer) - iLength, fd);
+      fclose(fd);
+      if ( ! loadFromBinaryBuffer(uBuffer, iLength) )
+      {
+         log_softerror_and_alarm("Invalid binary vehicle configuration file: %s", szFile);
+         return false;
+      }
+      iLoadedFileVersion = MODEL_BINARY_FILE_VERSION;
+      return true;
+   }
+
+   fseek(fd, 0, SEEK_SET);
+   int iVersion = 0;
+   bool bLoadedOk = false;
+   if ( 1 != fscanf(fd, "%*s %d", &iVersion) )
+   {
+      log_softerror_and_alarm("Load model: Error on version line. Invalid vehicle configuration file: %s", szFile);
+      fclose(fd);
+      return false;
+   }
+
+   //log_line("Found model file version: %d.", iVersion);
+   if ( 8 == iVersion )
+      bLoadedOk = loadVersion8(fd);
+   if ( 9 == iVersion )
+      bLoadedOk = loadVersion9(fd);
+   if ( 10 == iVersion )
+      bLoadedOk = loadVersion10(fd);
    fclose(fd);
+
+   if ( ! bLoadedOk )
+   {
+      log_softerror_and_alarm("Invalid vehicle configuration file: %s", szFile);
+      return false;
+   }
+   iLoadedFileVersion = iVersion;
    return true;
 }
 
@@ -294,62 +359,22 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
    szFileBackup[strlen(szFileBackup)-2] = 'a';
    szFileBackup[strlen(szFileBackup)-1] = 'k';
 
-   bool bMainFileLoadedOk = false;
-   bool bBackupFileLoadedOk = false;
-
    type_vehicle_stats_info stats;
    memcpy((u8*)&stats, (u8*)&m_Stats, sizeof(type_vehicle_stats_info));
 
    u32 timeStart = get_current_timestamp_ms();
 
-   int iVersionMain = 0;
-   int iVersionBackup = 0;
-   FILE* fd = fopen(szFileNormal, "r");
-   if ( NULL != fd )
-   {
-      if ( 1 != fscanf(fd, "%*s %d", &iVersionMain) )
-      {
-         log_softerror_and_alarm("Load model: Error on version line. Invalid vehicle configuration file: %s", szFileNormal);
-         bMainFileLoadedOk = false;
-      }
-      else
-      {
-         //log_line("Found model file version: %d.", iVersion);
-         if ( 8 == iVersionMain )
-            bMainFileLoadedOk = loadVersion8(fd);
-         if ( 9 == iVersionMain )
-            bMainFileLoadedOk = loadVersion9(fd);
-         if ( 10 == iVersionMain )
-            bMainFileLoadedOk = loadVersion10(fd);
-         if ( bMainFileLoadedOk )
-         {
-            iLoadedFileVersion = iVersionMain;
-         }
-         else
-            log_softerror_and_alarm("Invalid vehicle configuration file: %s",szFileNormal);
-      }
-      fclose(fd);
-   }
-   else
-      bMainFileLoadedOk = false;
-
-   if ( bMainFileLoadedOk )
+   if ( loadFile(szFileNormal) )
    {
       if ( ! bLoadStats ) 
          memcpy((u8*)&m_Stats, (u8*)&stats, sizeof(type_vehicle_stats_info));
       validate_settings();
 
       timeStart = get_current_timestamp_ms() - timeStart;
-      char szFreq1[64];
-      char szFreq2[64];
-      char szFreq3[64];
-      strcpy(szFreq1, str_format_frequency(radioLinksParams.link_frequency_khz[0]));
-      strcpy(szFreq2, str_format_frequency(radioLinksParams.link_frequency_khz[1]));
-      strcpy(szFreq3, str_format_frequency(radioLinksParams.link_frequency_khz[2]));
-
-      log_line("Loaded vehicle (%s) successfully from file: %s; name: [%s], VID: %u, %s, software: %d.%d (b%d), on time: %02d:%02d",
-         bLoadStats?"with stats":"without stats",
-         filename, vehicle_name, uVehicleId, 
+
+      log_line("Loaded vehicle (%s) successfully (%u ms) from file: %s, version %d; name: [%s], VID: %u, %s, software: %d.%d (b%d), on time: %02d:%02d",
+         bLoadStats?"with stats":"without stats", timeStart,
+         filename, iLoadedFileVersion, vehicle_name, uVehicleId, 
          is_spectator?"spectator mode": "control mode",
          (sw_version >> 8) & 0xFF, sw_version & 0xFF, sw_version>>16,
          m_Stats.uCurrentOnTime/60, m_Stats.uCurrentOnTime%60);
@@ -357,37 +382,7 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
       return true;
    }
 
-
-   fd = fopen(szFileBackup, "r");
-   if ( NULL != fd )
-   {
-      if ( 1 != fscanf(fd, "%*s %d", &iVersionBackup) )
-      {
-         log_softerror_and_alarm("Load model: Error on version line. Invalid vehicle configuration file: %s", szFileBackup);
-         bBackupFileLoadedOk = false;
-      }
-      else
-      {
-         //log_line("Found model file version: %d.", iVersion);
-         if ( 8 == iVersionBackup )
-            bBackupFileLoadedOk = loadVersion8(fd);
-         if ( 9 == iVersionBackup )
-            bBackupFileLoadedOk = loadVersion9(fd);
-         if ( 10 == iVersionBackup )
-            bBackupFileLoadedOk = loadVersion10(fd);
-         if ( bBackupFileLoadedOk )
-         {
-            iLoadedFileVersion = iVersionBackup;
-         }
-         else
-            log_softerror_and_alarm("Invalid vehicle configuration file: %s",szFileBackup);
-      }
-      fclose(fd);
-   }
-   else
-      bBackupFileLoadedOk = false;
-
-   if ( !bBackupFileLoadedOk )
+   if ( ! loadFile(szFileBackup) )
    {
       if ( ! bLoadStats ) 
          memcpy((u8*)&m_Stats, (u8*)&stats, sizeof(type_vehicle_stats_info));
@@ -405,20 +400,14 @@ bool Model::loadFromFile(const char* filename, bool bLoadStats)
 
    constructLongName();
    
-   fd = fopen(szFileNormal, "w");
-   if ( NULL != fd )
-   {
-      saveVersion10(fd, false);
-      fclose(fd);
+   if ( saveBinaryFile(szFileNormal, false) )
       log_line("Restored main model file from backup model file.");
-   }
    else
       log_softerror_and_alarm("Failed to write main model file from backup model file.");
 
    return true;
 }
 
-
 bool Model::loadVersion8(FILE* fd)
 {
    char szBuff[256];
@@ -2229,6 +2218,33 @@ bool Model::loadVersion10(FILE* fd)
 }
 
 
+bool Model::saveBinaryFile(const char* szFile, bool isOnController)
+{
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   int iLength = saveToBinaryBuffer(uBuffer, sizeof(uBuffer), isOnController, NULL);
+   if ( iLength <= 0 )
+   {
+      log_softerror_and_alarm("Failed to generate binary model configuration for file: %s", szFile);
+      return false;
+   }
+
+   FILE* fd = fopen(szFile, "wb");
+   if ( NULL == fd )
+   {
+      log_softerror_and_alarm("Failed to save model configuration to file: %s", szFile);
+      return false;
+   }
+   if ( iLength != (int)fwrite(uBuffer, 1, iLength, fd) )
+   {
+      log_softerror_and_alarm("Failed to write model configuration to file: %s", szFile);
+      fclose(fd);
+      return false;
+   }
+   fflush(fd);
+   fclose(fd);
+   return true;
+}
+
 bool Model::saveToFile(const char* filename, bool isOnController)
 {
    iSaveCount++;
@@ -2250,15 +2266,8 @@ bool Model::saveToFile(const char* filename, bool isOnController)
          vehicle_name[i] = '_';
    }
 
-   FILE* fd = fopen(filename, "w");
-   if ( NULL == fd )
-   {
-      log_softerror_and_alarm("Failed to save model configuration to file: %s",filename);
+   if ( ! saveBinaryFile(filename, isOnController) )
       return false;
-   }
-   saveVersion10(fd, isOnController);
-   fflush(fd);
-   fclose(fd);
 
    log_line("Saved vehicle successfully to file: %s; name: [%s], VID: %u, software: %d.%d (b%d), is on controller: %s, %s, on time: %02d:%02d",
          filename, vehicle_name, uVehicleId, (sw_version >> 8) & 0xFF, sw_version & 0xFF, sw_version>>16,
@@ -2271,33 +2280,24 @@ bool Model::saveToFile(const char* filename, bool isOnController)
    szBuff[strlen(szBuff)-2] = 'a';
    szBuff[strlen(szBuff)-1] = 'k';
 
-   fd = fopen(szBuff, "w");
+   if ( ! saveBinaryFile(szBuff, isOnController) )
+      return false;
+   return true;
+}
+
+// Text (version 10) model file, for controllers that do not support the binary model format
+
+bool Model::exportToTextFile(const char* filename, bool isOnController)
+{
+   FILE* fd = fopen(filename, "w");
    if ( NULL == fd )
    {
-      log_softerror_and_alarm("Failed to save model configuration to file: %s",szBuff);
+      log_softerror_and_alarm("Failed to export model configuration to file: %s", filename);
       return false;
    }
    saveVersion10(fd, isOnController);
    fflush(fd);
    fclose(fd);
-
-   /*
-   timeStart = get_current_timestamp_ms() - timeStart;
-   char szLog[512];
-   char szFreq1[64];
-   char szFreq2[64];
-   char szFreq3[64];
-   strcpy(szFreq1, str_format_frequency(radioLinksParams.link_frequency_khz[0]));
-   strcpy(szFreq2, str_format_frequency(radioLinksParams.link_frequency_khz[1]));
-   strcpy(szFreq3, str_format_frequency(radioLinksParams.link_frequency_khz[2]));
-   
-   sprintf(szLog, "Saved model version 8 (%d ms) to file [%s] and [*.bak], UID: %u, save count: %d: name: [%s], vehicle id: %u, software: %d.%d (b%d), (is on controller side: %s, is in control mode: %s), %d radio links: 1: %s 2: %s 3: %s",
-      timeStart, filename, uVehicleId,
-      iSaveCount, vehicle_name, uVehicleId, (sw_version >> 8) & 0xFF, sw_version & 0xFF, sw_version >> 16, isOnController?"yes":"no", is_spectator?"no (spectator mode)":"yes",
-      radioLinksParams.links_count, szFreq1, szFreq2, szFreq3 );
-   log_line(szLog);
-   */
-
    return true;
 }
 
@@ -585,6 +585,11 @@ class Model
       bool reloadIfChanged(bool bLoadStats);
       bool loadFromFile(const char* filename, bool bLoadStats = false);
       bool saveToFile(const char* filename, bool isOnController);
+      bool exportToTextFile(const char* filename, bool isOnController);
+      int  saveToBinaryBuffer(u8* pOutput, int iMaxLength, bool isOnController, u32* pBaseSectionsCRCs);
+      bool loadFromBinaryBuffer(u8* pData, int iLength);
+      int  getBinarySectionsCRCs(u32* pCRCs);
+      u32  getBinaryModelCRC();
       int  getLoadedFileVersion();
       bool isRunningOnOpenIPCHardware();
       bool isRunningOnPiHardware();
@@ -692,6 +697,8 @@ class Model
       int iSaveCount;
 
       void generateUID();
+      bool loadFile(const char* szFile);
+      bool saveBinaryFile(const char* szFile, bool isOnController);
       bool loadVersion8(FILE* fd);
       bool loadVersion9(FILE* fd); // from 7.4
       bool loadVersion10(FILE* fd); // from 7.6
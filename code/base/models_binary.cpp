@@ -0,0 +1,534 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "base.h"
+#include "models.h"
+#include "models_binary.h"
+#include "hardware.h"
+
+// Section with the model's own scalar fields
+typedef struct
+{
+   u32 uDummyM1;
+   u32 uDeveloperFlags;
+   u32 uModelFlags;
+   char vehicle_name[MAX_VEHICLE_NAME_LENGTH];
+   u32 uVehicleId;
+   u32 uControllerId;
+   u32 sw_version;
+   u8 is_spectator;
+   u8 vehicle_type;
+   u8 enableDHCP;
+   u8 uDummy;
+   int rxtx_sync_type;
+   u32 alarms;
+   int iRadioInterfacesGraphRefreshInterval;
+   u32 camera_rc_channels;
+   u32 enc_flags;
+   int iGPSCount;
+   int iCameraCount;
+   int iCurrentCamera;
+} __attribute__((packed)) t_model_binary_general;
+
+// rc_parameters_t has long fields, which have a different size on 32 and 64 bits controllers,
+// so it's stored using fixed size fields
+typedef struct
+{
+   u8 rc_enabled;
+   u8 dummy1;
+   int rc_frames_per_second;
+   int rc_failsafe_timeout_ms;
+   int receiver_type;
+   int inputType;
+   int inputSerialPort;
+   int inputSerialPortSpeed;
+   int outputSerialPort;
+   int outputSerialPortSpeed;
+   u32 rcChAssignment[MAX_RC_CHANNELS];
+   u16 rcChMid[MAX_RC_CHANNELS];
+   u16 rcChMin[MAX_RC_CHANNELS];
+   u16 rcChMax[MAX_RC_CHANNELS];
+   u16 rcChFailSafe[MAX_RC_CHANNELS];
+   u8 rcChExpo[MAX_RC_CHANNELS];
+   u8 rcChFlags[MAX_RC_CHANNELS];
+   u32 failsafeFlags;
+   int channelsCount;
+   u32 hid_id;
+   u32 flags;
+   u32 rcChAssignmentThrotleReverse;
+   int iRCTranslationType;
+   u32 rcDummy[8];
+} __attribute__((packed)) t_model_binary_rc;
+
+#define MODEL_BINARY_MAX_SECTION_SIZE 2048
+
+int model_binary_is_valid(u8* pData, int iLength)
+{
+   if ( (NULL == pData) || (iLength < (int)sizeof(t_model_binary_header)) )
+      return 0;
+   t_model_binary_header header;
+   memcpy((u8*)&header, pData, sizeof(t_model_binary_header));
+   if ( header.uMagic != MODEL_BINARY_MAGIC )
+      return 0;
+   if ( (header.uSchemaVersion < 1) || (header.uSchemaVersion > MODEL_BINARY_SCHEMA_VERSION) )
+      return 0;
+   if ( (int)header.uDataLength != iLength - (int)sizeof(t_model_binary_header) )
+      return 0;
+   if ( header.uDataCRC != base_compute_crc32(pData + sizeof(t_model_binary_header), header.uDataLength) )
+      return 0;
+   return 1;
+}
+
+int model_binary_is_delta(u8* pData, int iLength)
+{
+   if ( ! model_binary_is_valid(pData, iLength) )
+      return 0;
+   t_model_binary_header* pHeader = (t_model_binary_header*)pData;
+   if ( pHeader->uFlags & MODEL_BINARY_FLAG_DELTA )
+      return 1;
+   return 0;
+}
+
+// Model structures are mostly zeros, so only zero runs are encoded: 0x00 followed by the run length (1..255)
+
+int model_binary_compress(u8* pInput, int iLength, u8* pOutput, int iMaxLength)
+{
+   if ( ! model_binary_is_valid(pInput, iLength) )
+      return -1;
+   if ( iMaxLength < (int)sizeof(t_model_binary_header) )
+      return -1;
+
+   t_model_binary_header header;
+   memcpy((u8*)&header, pInput, sizeof(t_model_binary_header));
+   if ( header.uFlags & MODEL_BINARY_FLAG_ZERO_RLE )
+   {
+      if ( iLength > iMaxLength )
+         return -1;
+      memcpy(pOutput, pInput, iLength);
+      return iLength;
+   }
+
+   int iPosOut = sizeof(t_model_binary_header);
+   int iPosIn = sizeof(t_model_binary_header);
+   while ( iPosIn < iLength )
+   {
+      if ( iPosOut >= iMaxLength )
+         return -1;
+      if ( 0 != pInput[iPosIn] )
+      {
+         pOutput[iPosOut++] = pInput[iPosIn++];
+         continue;
+      }
+      int iRun = 0;
+      while ( (iPosIn < iLength) && (0 == pInput[iPosIn]) && (iRun < 255) )
+      {
+         iRun++;
+         iPosIn++;
+      }
+      if ( iPosOut + 2 > iMaxLength )
+         return -1;
+      pOutput[iPosOut++] = 0;
+      pOutput[iPosOut++] = (u8)iRun;
+   }
+
+   header.uFlags |= MODEL_BINARY_FLAG_ZERO_RLE;
+   header.uDataLength = iPosOut - sizeof(t_model_binary_header);
+   header.uDataCRC = base_compute_crc32(pOutput + sizeof(t_model_binary_header), header.uDataLength);
+   memcpy(pOutput, (u8*)&header, sizeof(t_model_binary_header));
+   return iPosOut;
+}
+
+int model_binary_decompress(u8* pInput, int iLength, u8* pOutput, int iMaxLength)
+{
+   if ( ! model_binary_is_valid(pInput, iLength) )
+      return -1;
+   if ( iMaxLength < (int)sizeof(t_model_binary_header) )
+      return -1;
+
+   t_model_binary_header header;
+   memcpy((u8*)&header, pInput, sizeof(t_model_binary_header));
+   if ( ! (header.uFlags & MODEL_BINARY_FLAG_ZERO_RLE) )
+   {
+      if ( iLength > iMaxLength )
+         return -1;
+      memcpy(pOutput, pInput, iLength);
+      return iLength;
+   }
+
+   int iPosOut = sizeof(t_model_binary_header);
+   int iPosIn = sizeof(t_model_binary_header);
+   while ( iPosIn < iLength )
+   {
+      if ( 0 != pInput[iPosIn] )
+      {
+         if ( iPosOut >= iMaxLength )
+            return -1;
+         pOutput[iPosOut++] = pInput[iPosIn++];
+         continue;
+      }
+      if ( iPosIn + 1 >= iLength )
+         return -1;
+      int iRun = pInput[iPosIn+1];
+      iPosIn += 2;
+      if ( (0 == iRun) || (iPosOut + iRun > iMaxLength) )
+         return -1;
+      memset(pOutput + iPosOut, 0, iRun);
+      iPosOut += iRun;
+   }
+
+   header.uFlags &= ~MODEL_BINARY_FLAG_ZERO_RLE;
+   header.uDataLength = iPosOut - sizeof(t_model_binary_header);
+   header.uDataCRC = base_compute_crc32(pOutput + sizeof(t_model_binary_header), header.uDataLength);
+   memcpy(pOutput, (u8*)&header, sizeof(t_model_binary_header));
+   return iPosOut;
+}
+
+static u8* _model_binary_get_struct_section(Model* pModel, int iSectionId, int* piSize)
+{
+   switch ( iSectionId )
+   {
+      case MODEL_BINARY_SECTION_HW_CAPABILITIES: *piSize = sizeof(pModel->hwCapabilities); return (u8*)&(pModel->hwCapabilities);
+      case MODEL_BINARY_SECTION_HW_INTERFACES: *piSize = sizeof(pModel->hardwareInterfacesInfo); return (u8*)&(pModel->hardwareInterfacesInfo);
+      case MODEL_BINARY_SECTION_PROCESSES: *piSize = sizeof(pModel->processesPriorities); return (u8*)&(pModel->processesPriorities);
+      case MODEL_BINARY_SECTION_RADIO_INTERFACES: *piSize = sizeof(pModel->radioInterfacesParams); return (u8*)&(pModel->radioInterfacesParams);
+      case MODEL_BINARY_SECTION_RADIO_LINKS: *piSize = sizeof(pModel->radioLinksParams); return (u8*)&(pModel->radioLinksParams);
+      case MODEL_BINARY_SECTION_LOGGING: *piSize = sizeof(pModel->loggingParams); return (u8*)&(pModel->loggingParams);
+      case MODEL_BINARY_SECTION_STATS: *piSize = sizeof(pModel->m_Stats); return (u8*)&(pModel->m_Stats);
+      case MODEL_BINARY_SECTION_CAMERAS: *piSize = sizeof(pModel->camera_params); return (u8*)&(pModel->camera_params[0]);
+      case MODEL_BINARY_SECTION_VIDEO: *piSize = sizeof(pModel->video_params); return (u8*)&(pModel->video_params);
+      case MODEL_BINARY_SECTION_VIDEO_PROFILES: *piSize = sizeof(pModel->video_link_profiles); return (u8*)&(pModel->video_link_profiles[0]);
+      case MODEL_BINARY_SECTION_OSD: *piSize = sizeof(pModel->osd_params); return (u8*)&(pModel->osd_params);
+      case MODEL_BINARY_SECTION_TELEMETRY: *piSize = sizeof(pModel->telemetry_params); return (u8*)&(pModel->telemetry_params);
+      case MODEL_BINARY_SECTION_AUDIO: *piSize = sizeof(pModel->audio_params); return (u8*)&(pModel->audio_params);
+      case MODEL_BINARY_SECTION_FUNCTIONS: *piSize = sizeof(pModel->functions_params); return (u8*)&(pModel->functions_params);
+      case MODEL_BINARY_SECTION_RELAY: *piSize = sizeof(pModel->relay_params); return (u8*)&(pModel->relay_params);
+      case MODEL_BINARY_SECTION_ALARMS: *piSize = sizeof(pModel->alarms_params); return (u8*)&(pModel->alarms_params);
+   }
+   *piSize = 0;
+   return NULL;
+}
+
+static void _model_binary_general_from_model(Model* pModel, t_model_binary_general* pGeneral)
+{
+   memset((u8*)pGeneral, 0, sizeof(t_model_binary_general));
+   pGeneral->uDummyM1 = pModel->uDummyM1;
+   pGeneral->uDeveloperFlags = pModel->uDeveloperFlags;
+   pGeneral->uModelFlags = pModel->uModelFlags;
+   // Bytes after the name terminator are not part of the model state
+   strncpy(pGeneral->vehicle_name, pModel->vehicle_name, MAX_VEHICLE_NAME_LENGTH-1);
+   pGeneral->uVehicleId = pModel->uVehicleId;
+   pGeneral->uControllerId = pModel->uControllerId;
+   pGeneral->sw_version = pModel->sw_version;
+   pGeneral->is_spectator = pModel->is_spectator?1:0;
+   pGeneral->vehicle_type = pModel->vehicle_type;
+   pGeneral->enableDHCP = pModel->enableDHCP?1:0;
+   pGeneral->rxtx_sync_type = pModel->rxtx_sync_type;
+   pGeneral->alarms = pModel->alarms;
+   pGeneral->iRadioInterfacesGraphRefreshInterval = pModel->m_iRadioInterfacesGraphRefreshInterval;
+   pGeneral->camera_rc_channels = pModel->camera_rc_channels;
+   pGeneral->enc_flags = pModel->enc_flags;
+   pGeneral->iGPSCount = pModel->iGPSCount;
+   pGeneral->iCameraCount = pModel->iCameraCount;
+   pGeneral->iCurrentCamera = pModel->iCurrentCamera;
+}
+
+static void _model_binary_general_to_model(t_model_binary_general* pGeneral, Model* pModel)
+{
+   pModel->uDummyM1 = pGeneral->uDummyM1;
+   pModel->uDeveloperFlags = pGeneral->uDeveloperFlags;
+   pModel->uModelFlags = pGeneral->uModelFlags;
+   memcpy(pModel->vehicle_name, pGeneral->vehicle_name, MAX_VEHICLE_NAME_LENGTH);
+   pModel->vehicle_name[MAX_VEHICLE_NAME_LENGTH-1] = 0;
+   pModel->uVehicleId = pGeneral->uVehicleId;
+   pModel->uControllerId = pGeneral->uControllerId;
+   pModel->sw_version = pGeneral->sw_version;
+   pModel->is_spectator = pGeneral->is_spectator?true:false;
+   pModel->vehicle_type = pGeneral->vehicle_type;
+   pModel->enableDHCP = pGeneral->enableDHCP?true:false;
+   pModel->rxtx_sync_type = pGeneral->rxtx_sync_type;
+   pModel->alarms = pGeneral->alarms;
+   pModel->m_iRadioInterfacesGraphRefreshInterval = pGeneral->iRadioInterfacesGraphRefreshInterval;
+   pModel->camera_rc_channels = pGeneral->camera_rc_channels;
+   pModel->enc_flags = pGeneral->enc_flags;
+   pModel->iGPSCount = pGeneral->iGPSCount;
+   pModel->iCameraCount = pGeneral->iCameraCount;
+   pModel->iCurrentCamera = pGeneral->iCurrentCamera;
+}
+
+static void _model_binary_rc_from_model(Model* pModel, t_model_binary_rc* pRC)
+{
+   rc_parameters_t* pParams = &(pModel->rc_params);
+   memset((u8*)pRC, 0, sizeof(t_model_binary_rc));
+   pRC->rc_enabled = pParams->rc_enabled?1:0;
+   pRC->dummy1 = pParams->dummy1?1:0;
+   pRC->rc_frames_per_second = pParams->rc_frames_per_second;
+   pRC->rc_failsafe_timeout_ms = pParams->rc_failsafe_timeout_ms;
+   pRC->receiver_type = pParams->receiver_type;
+   pRC->inputType = pParams->inputType;
+   pRC->inputSerialPort = pParams->inputSerialPort;
+   pRC->inputSerialPortSpeed = (int)pParams->inputSerialPortSpeed;
+   pRC->outputSerialPort = pParams->outputSerialPort;
+   pRC->outputSerialPortSpeed = (int)pParams->outputSerialPortSpeed;
+   memcpy(pRC->rcChAssignment, pParams->rcChAssignment, sizeof(pRC->rcChAssignment));
+   memcpy(pRC->rcChMid, pParams->rcChMid, sizeof(pRC->rcChMid));
+   memcpy(pRC->rcChMin, pParams->rcChMin, sizeof(pRC->rcChMin));
+   memcpy(pRC->rcChMax, pParams->rcChMax, sizeof(pRC->rcChMax));
+   memcpy(pRC->rcChFailSafe, pParams->rcChFailSafe, sizeof(pRC->rcChFailSafe));
+   memcpy(pRC->rcChExpo, pParams->rcChExpo, sizeof(pRC->rcChExpo));
+   memcpy(pRC->rcChFlags, pParams->rcChFlags, sizeof(pRC->rcChFlags));
+   pRC->failsafeFlags = pParams->failsafeFlags;
+   pRC->channelsCount = pParams->channelsCount;
+   pRC->hid_id = pParams->hid_id;
+   pRC->flags = pParams->flags;
+   pRC->rcChAssignmentThrotleReverse = pParams->rcChAssignmentThrotleReverse;
+   pRC->iRCTranslationType = pParams->iRCTranslationType;
+   memcpy(pRC->rcDummy, pParams->rcDummy, sizeof(pRC->rcDummy));
+}
+
+static void _model_binary_rc_to_model(t_model_binary_rc* pRC, Model* pModel)
+{
+   rc_parameters_t* pParams = &(pModel->rc_params);
+   pParams->rc_enabled = pRC->rc_enabled?true:false;
+   pParams->dummy1 = pRC->dummy1?true:false;
+   pParams->rc_frames_per_second = pRC->rc_frames_per_second;
+   pParams->rc_failsafe_timeout_ms = pRC->rc_failsafe_timeout_ms;
+   pParams->receiver_type = pRC->receiver_type;
+   pParams->inputType = pRC->inputType;
+   pParams->inputSerialPort = pRC->inputSerialPort;
+   pParams->inputSerialPortSpeed = pRC->inputSerialPortSpeed;
+   pParams->outputSerialPort = pRC->outputSerialPort;
+   pParams->outputSerialPortSpeed = pRC->outputSerialPortSpeed;
+   memcpy(pParams->rcChAssignment, pRC->rcChAssignment, sizeof(pRC->rcChAssignment));
+   memcpy(pParams->rcChMid, pRC->rcChMid, sizeof(pRC->rcChMid));
+   memcpy(pParams->rcChMin, pRC->rcChMin, sizeof(pRC->rcChMin));
+   memcpy(pParams->rcChMax, pRC->rcChMax, sizeof(pRC->rcChMax));
+   memcpy(pParams->rcChFailSafe, pRC->rcChFailSafe, sizeof(pRC->rcChFailSafe));
+   memcpy(pParams->rcChExpo, pRC->rcChExpo, sizeof(pRC->rcChExpo));
+   memcpy(pParams->rcChFlags, pRC->rcChFlags, sizeof(pRC->rcChFlags));
+   pParams->failsafeFlags = pRC->failsafeFlags;
+   pParams->channelsCount = pRC->channelsCount;
+   pParams->hid_id = pRC->hid_id;
+   pParams->flags = pRC->flags;
+   pParams->rcChAssignmentThrotleReverse = pRC->rcChAssignmentThrotleReverse;
+   pParams->iRCTranslationType = pRC->iRCTranslationType;
+   memcpy(pParams->rcDummy, pRC->rcDummy, sizeof(pRC->rcDummy));
+}
+
+// Returns the section size
+static int _model_binary_get_section(Model* pModel, int iSectionId, u8* pOutput)
+{
+   if ( MODEL_BINARY_SECTION_GENERAL == iSectionId )
+   {
+      t_model_binary_general general;
+      _model_binary_general_from_model(pModel, &general);
+      memcpy(pOutput, (u8*)&general, sizeof(general));
+      return sizeof(general);
+   }
+   if ( MODEL_BINARY_SECTION_RC == iSectionId )
+   {
+      t_model_binary_rc rc;
+      _model_binary_rc_from_model(pModel, &rc);
+      memcpy(pOutput, (u8*)&rc, sizeof(rc));
+      return sizeof(rc);
+   }
+   int iSize = 0;
+   u8* pSource = _model_binary_get_struct_section(pModel, iSectionId, &iSize);
+   if ( NULL == pSource )
+      return 0;
+   memcpy(pOutput, pSource, iSize);
+   return iSize;
+}
+
+// Shorter data (from an older schema) updates only the first part of the section
+static bool _model_binary_set_section(Model* pModel, int iSectionId, u8* pData, int iLength)
+{
+   u8 uSection[MODEL_BINARY_MAX_SECTION_SIZE];
+   int iSize = _model_binary_get_section(pModel, iSectionId, uSection);
+   if ( 0 == iSize )
+      return false;
+   if ( iLength > iSize )
+      iLength = iSize;
+   memcpy(uSection, pData, iLength);
+
+   if ( MODEL_BINARY_SECTION_GENERAL == iSectionId )
+      _model_binary_general_to_model((t_model_binary_general*)uSection, pModel);
+   else if ( MODEL_BINARY_SECTION_RC == iSectionId )
+      _model_binary_rc_to_model((t_model_binary_rc*)uSection, pModel);
+   else
+      memcpy(_model_binary_get_struct_section(pModel, iSectionId, &iSize), uSection, iSize);
+   return true;
+}
+
+int Model::getBinarySectionsCRCs(u32* pCRCs)
+{
+   u8 uSection[MODEL_BINARY_MAX_SECTION_SIZE];
+   for( int i=0; i<MODEL_BINARY_MAX_SECTIONS; i++ )
+   {
+      int iSize = _model_binary_get_section(this, i+1, uSection);
+      pCRCs[i] = base_compute_crc32(uSection, iSize);
+   }
+   return MODEL_BINARY_MAX_SECTIONS;
+}
+
+u32 Model::getBinaryModelCRC()
+{
+   u32 uCRCs[MODEL_BINARY_MAX_SECTIONS];
+   getBinarySectionsCRCs(uCRCs);
+   return base_compute_crc32((u8*)uCRCs, sizeof(uCRCs));
+}
+
+// Returns the binary model size or -1 if it does not fit in the output buffer.
+// If pBaseSectionsCRCs is not NULL, a delta is generated, with only the sections that have a different CRC.
+
+int Model::saveToBinaryBuffer(u8* pOutput, int iMaxLength, bool isOnController, u32* pBaseSectionsCRCs)
+{
+   if ( (NULL == pOutput) || (iMaxLength < (int)sizeof(t_model_binary_header)) )
+      return -1;
+
+   if ( ! isOnController )
+      sw_version = (SYSTEM_SW_VERSION_MAJOR * 256 + SYSTEM_SW_VERSION_MINOR) | (SYSTEM_SW_BUILD_NUMBER<<16);
+
+   t_model_binary_header header;
+   memset((u8*)&header, 0, sizeof(t_model_binary_header));
+   header.uMagic = MODEL_BINARY_MAGIC;
+   header.uSchemaVersion = MODEL_BINARY_SCHEMA_VERSION;
+   if ( NULL != pBaseSectionsCRCs )
+      header.uFlags |= MODEL_BINARY_FLAG_DELTA;
+   header.uSaveCount = (u32)iSaveCount;
+
+   u32 uCRCs[MODEL_BINARY_MAX_SECTIONS];
+   u8 uSection[MODEL_BINARY_MAX_SECTION_SIZE];
+   int iPos = sizeof(t_model_binary_header);
+
+   for( int i=0; i<MODEL_BINARY_MAX_SECTIONS; i++ )
+   {
+      int iSize = _model_binary_get_section(this, i+1, uSection);
+      uCRCs[i] = base_compute_crc32(uSection, iSize);
+      if ( (NULL != pBaseSectionsCRCs) && (pBaseSectionsCRCs[i] == uCRCs[i]) )
+         continue;
+      if ( iPos + (int)sizeof(t_model_binary_section_header) + iSize > iMaxLength )
+         return -1;
+
+      t_model_binary_section_header sectionHeader;
+      sectionHeader.uSectionId = i+1;
+      sectionHeader.uFlags = 0;
+      sectionHeader.uLength = iSize;
+      memcpy(pOutput + iPos, (u8*)&sectionHeader, sizeof(t_model_binary_section_header));
+      iPos += sizeof(t_model_binary_section_header);
+      memcpy(pOutput + iPos, uSection, iSize);
+      iPos += iSize;
+      header.uSectionsCount++;
+   }
+
+   header.uModelCRC = base_compute_crc32((u8*)uCRCs, sizeof(uCRCs));
+   header.uDataLength = iPos - sizeof(t_model_binary_header);
+   header.uDataCRC = base_compute_crc32(pOutput + sizeof(t_model_binary_header), header.uDataLength);
+   memcpy(pOutput, (u8*)&header, sizeof(t_model_binary_header));
+   return iPos;
+}
+
+// Loads a full binary model or applies a binary delta on top of the current model values.
+// A delta must be applied on the same model state it was generated from: if the resulting model
+// does not match the source model, returns false and the model is left partially updated.
+
+bool Model::loadFromBinaryBuffer(u8* pData, int iLength)
+{
+   if ( ! model_binary_is_valid(pData, iLength) )
+   {
+      log_softerror_and_alarm("Load model: invalid binary model buffer (%d bytes).", iLength);
+      return false;
+   }
+
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   t_model_binary_header header;
+   memcpy((u8*)&header, pData, sizeof(t_model_binary_header));
+   if ( header.uFlags & MODEL_BINARY_FLAG_ZERO_RLE )
+   {
+      iLength = model_binary_decompress(pData, iLength, uBuffer, sizeof(uBuffer));
+      if ( iLength < 0 )
+      {
+         log_softerror_and_alarm("Load model: failed to decompress binary model buffer.");
+         return false;
+      }
+      pData = uBuffer;
+   }
+
+   int iPos = sizeof(t_model_binary_header);
+   int iCountSections = 0;
+   while ( iPos < iLength )
+   {
+      t_model_binary_section_header sectionHeader;
+      if ( iPos + (int)sizeof(t_model_binary_section_header) > iLength )
+         break;
+      memcpy((u8*)&sectionHeader, pData + iPos, sizeof(t_model_binary_section_header));
+      iPos += sizeof(t_model_binary_section_header);
+      if ( iPos + (int)sectionHeader.uLength > iLength )
+         break;
+      if ( ! _model_binary_set_section(this, sectionHeader.uSectionId, pData + iPos, sectionHeader.uLength) )
+         log_line("Load model: skipped unknown binary model section %d (%d bytes).", (int)sectionHeader.uSectionId, (int)sectionHeader.uLength);
+      iPos += sectionHeader.uLength;
+      iCountSections++;
+   }
+
+   if ( (iPos != iLength) || (iCountSections != (int)header.uSectionsCount) )
+   {
+      log_softerror_and_alarm("Load model: truncated binary model, loaded %d of %d sections.", iCountSections, (int)header.uSectionsCount);
+      return false;
+   }
+
+   if ( radioInterfacesParams.interfaces_count < 0 || radioInterfacesParams.interfaces_count > MAX_RADIO_INTERFACES )
+      radioInterfacesParams.interfaces_count = 0;
+   if ( radioLinksParams.links_count < 0 || radioLinksParams.links_count > MAX_RADIO_INTERFACES )
+      radioLinksParams.links_count = 0;
+   if ( hardwareInterfacesInfo.i2c_bus_count < 0 || hardwareInterfacesInfo.i2c_bus_count > MAX_MODEL_I2C_BUSSES )
+      hardwareInterfacesInfo.i2c_bus_count = 0;
+   if ( hardwareInterfacesInfo.i2c_device_count < 0 || hardwareInterfacesInfo.i2c_device_count > MAX_MODEL_I2C_DEVICES )
+      hardwareInterfacesInfo.i2c_device_count = 0;
+   if ( hardwareInterfacesInfo.serial_port_count < 0 || hardwareInterfacesInfo.serial_port_count > MAX_MODEL_SERIAL_PORTS )
+      hardwareInterfacesInfo.serial_port_count = 0;
+   if ( iCameraCount < 0 || iCameraCount > MODEL_MAX_CAMERAS )
+      iCameraCount = 0;
+
+   iSaveCount = (int)header.uSaveCount;
+
+   if ( header.uFlags & MODEL_BINARY_FLAG_DELTA )
+   if ( getBinaryModelCRC() != header.uModelCRC )
+   {
+      log_softerror_and_alarm("Load model: binary model delta (%d sections) was applied on a different model state.", iCountSections);
+      return false;
+   }
+
+   if ( hardware_is_vehicle() )
+      sw_version = (SYSTEM_SW_VERSION_MAJOR * 256 + SYSTEM_SW_VERSION_MINOR) | (SYSTEM_SW_BUILD_NUMBER<<16);
+   return true;
+}
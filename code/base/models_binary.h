@@ -0,0 +1,83 @@
+#pragma once
+#include "base.h"
+
+// Binary model format:
+//   t_model_binary_header, then a list of sections: t_model_binary_section_header + section data.
+//   Section data is the in-memory model structure, so loading is just a copy, no parsing.
+//   When MODEL_BINARY_FLAG_ZERO_RLE is set, everything after the header is zero run length encoded.
+//   When MODEL_BINARY_FLAG_DELTA is set, only some sections are present (the ones that changed).
+//
+// Model structures must only get new fields appended at the end or reuse the dummy fields.
+// Shorter sections (from older versions) are loaded partially, the rest keeps the default values.
+// Any other structure layout change must increase MODEL_BINARY_SCHEMA_VERSION.
+
+#define MODEL_BINARY_MAGIC 0x4C444D52 // "RMDL"
+#define MODEL_BINARY_SCHEMA_VERSION 1
+#define MODEL_BINARY_FILE_VERSION 20 // Reported as loaded file version, text files are 8...10
+#define MODEL_BINARY_MAX_SIZE 8192
+
+#define MODEL_BINARY_FLAG_DELTA ((u8)0x01)
+#define MODEL_BINARY_FLAG_ZERO_RLE ((u8)0x02)
+
+#define MODEL_BINARY_SECTION_GENERAL 1
+#define MODEL_BINARY_SECTION_HW_CAPABILITIES 2
+#define MODEL_BINARY_SECTION_HW_INTERFACES 3
+#define MODEL_BINARY_SECTION_PROCESSES 4
+#define MODEL_BINARY_SECTION_RADIO_INTERFACES 5
+#define MODEL_BINARY_SECTION_RADIO_LINKS 6
+#define MODEL_BINARY_SECTION_LOGGING 7
+#define MODEL_BINARY_SECTION_STATS 8
+#define MODEL_BINARY_SECTION_CAMERAS 9
+#define MODEL_BINARY_SECTION_VIDEO 10
+#define MODEL_BINARY_SECTION_VIDEO_PROFILES 11
+#define MODEL_BINARY_SECTION_OSD 12
+#define MODEL_BINARY_SECTION_RC 13
+#define MODEL_BINARY_SECTION_TELEMETRY 14
+#define MODEL_BINARY_SECTION_AUDIO 15
+#define MODEL_BINARY_SECTION_FUNCTIONS 16
+#define MODEL_BINARY_SECTION_RELAY 17
+#define MODEL_BINARY_SECTION_ALARMS 18
+#define MODEL_BINARY_MAX_SECTIONS 18
+
+// Bit in COMMAND_ID_GET_ALL_PARAMS_ZIP command param: controller accepts binary model settings.
+// The command buffer holds the controller's current sections CRCs (MODEL_BINARY_MAX_SECTIONS u32 values), if any.
+#define MODEL_BINARY_GET_PARAMS_FLAG (((u32)0x01)<<7)
+
+// Command response param (and model settings packet start flag) when model settings are sent in binary format
+#define MODEL_BINARY_COMMAND_RESPONSE_PARAM 2
+#define MODEL_BINARY_SETTINGS_START_FLAG 0xFFFFFFF1
+
+typedef struct
+{
+   u32 uMagic;
+   u8 uSchemaVersion;
+   u8 uFlags;
+   u8 uSectionsCount; // sections present in this buffer
+   u8 uDummy;
+   u32 uSaveCount;
+   u32 uModelCRC; // CRC of all the sections CRCs of the complete model; identifies the full model state, even for a delta
+   u32 uDataLength; // bytes after this header, as stored (encoded or not)
+   u32 uDataCRC; // CRC of the bytes after this header, as stored
+} __attribute__((packed)) t_model_binary_header;
+
+typedef struct
+{
+   u8 uSectionId;
+   u8 uFlags;
+   u16 uLength;
+} __attribute__((packed)) t_model_binary_section_header;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int model_binary_is_valid(u8* pData, int iLength);
+int model_binary_is_delta(u8* pData, int iLength);
+
+// Return the output length or -1 if it does not fit in the output buffer
+int model_binary_compress(u8* pInput, int iLength, u8* pOutput, int iMaxLength);
+int model_binary_decompress(u8* pInput, int iLength, u8* pOutput, int iMaxLength);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,965 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "base.h"
+#include "flags_video.h"
+#include "mp4_muxer.h"
+#include <sys/uio.h>
+#include <unistd.h>
+
+typedef struct
+{
+   u8* pData;
+   int iPos;
+} t_mp4_writer;
+
+static u8 s_uMP4MuxerZeroPadding[MP4_MUXER_WRITE_ALIGNMENT];
+
+static const u32 s_uMP4Matrix[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+
+static void _mp4_put8(t_mp4_writer* pWriter, u32 uValue)
+{
+   pWriter->pData[pWriter->iPos++] = (u8)uValue;
+}
+
+static void _mp4_put16(t_mp4_writer* pWriter, u32 uValue)
+{
+   _mp4_put8(pWriter, uValue >> 8);
+   _mp4_put8(pWriter, uValue);
+}
+
+static void _mp4_put32(t_mp4_writer* pWriter, u32 uValue)
+{
+   _mp4_put16(pWriter, uValue >> 16);
+   _mp4_put16(pWriter, uValue);
+}
+
+static void _mp4_put64(t_mp4_writer* pWriter, unsigned long long uValue)
+{
+   _mp4_put32(pWriter, (u32)(uValue >> 32));
+   _mp4_put32(pWriter, (u32)uValue);
+}
+
+static void _mp4_put_bytes(t_mp4_writer* pWriter, const u8* pData, int iLength)
+{
+   memcpy(pWriter->pData + pWriter->iPos, pData, iLength);
+   pWriter->iPos += iLength;
+}
+
+static void _mp4_put_fourcc(t_mp4_writer* pWriter, const char* szType)
+{
+   _mp4_put_bytes(pWriter, (const u8*)szType, 4);
+}
+
+static void _mp4_put_zeros(t_mp4_writer* pWriter, int iCount)
+{
+   memset(pWriter->pData + pWriter->iPos, 0, iCount);
+   pWriter->iPos += iCount;
+}
+
+static void _mp4_put_matrix(t_mp4_writer* pWriter)
+{
+   for( int i=0; i<9; i++ )
+      _mp4_put32(pWriter, s_uMP4Matrix[i]);
+}
+
+// Returns the box start position, to be used by _mp4_end_box
+static int _mp4_begin_box(t_mp4_writer* pWriter, const char* szType)
+{
+   int iStart = pWriter->iPos;
+   _mp4_put32(pWriter, 0);
+   _mp4_put_fourcc(pWriter, szType);
+   return iStart;
+}
+
+static int _mp4_begin_full_box(t_mp4_writer* pWriter, const char* szType, u32 uVersion, u32 uFlags)
+{
+   int iStart = _mp4_begin_box(pWriter, szType);
+   _mp4_put32(pWriter, (uVersion << 24) | (uFlags & 0xFFFFFF));
+   return iStart;
+}
+
+static void _mp4_end_box(t_mp4_writer* pWriter, int iStart)
+{
+   u32 uSize = pWriter->iPos - iStart;
+   pWriter->pData[iStart] = (u8)(uSize >> 24);
+   pWriter->pData[iStart+1] = (u8)(uSize >> 16);
+   pWriter->pData[iStart+2] = (u8)(uSize >> 8);
+   pWriter->pData[iStart+3] = (u8)uSize;
+}
+
+static u32 _mp4_get32(const u8* pData)
+{
+   return (((u32)pData[0]) << 24) | (((u32)pData[1]) << 16) | (((u32)pData[2]) << 8) | ((u32)pData[3]);
+}
+
+// H265 SPS: 2 bytes NAL header, 1 byte (VPS id, max sub layers, nesting), then the 12 bytes general profile, tier and level
+static bool _mp4_get_h265_profile_tier_level(u8* pSPS, int iLength, u8* pOutput)
+{
+   u8 uRBSP[16];
+   int iRBSPLength = 0;
+   int iZeros = 0;
+   for( int i=0; (i<iLength) && (iRBSPLength < 15); i++ )
+   {
+      if ( (iZeros >= 2) && (pSPS[i] == 0x03) )
+      {
+         iZeros = 0;
+         continue;
+      }
+      iZeros = (pSPS[i] == 0)?(iZeros+1):0;
+      uRBSP[iRBSPLength++] = pSPS[i];
+   }
+   if ( iRBSPLength < 15 )
+      return false;
+   memcpy(pOutput, &uRBSP[3], 12);
+   return true;
+}
+
+MP4Muxer::MP4Muxer()
+{
+   m_iFile = -1;
+   m_pBuffer = NULL;
+   m_uBufferSize = 0;
+   m_uBufferUsed = 0;
+   m_iVideoType = VIDEO_TYPE_H264;
+   m_iWidth = 0;
+   m_iHeight = 0;
+   m_uSampleDuration = MP4_MUXER_TIMESCALE/30;
+   m_bFoundFirstNAL = false;
+   m_bHeaderWritten = false;
+   m_bWriteFailed = false;
+   m_iVPSLength = 0;
+   m_iSPSLength = 0;
+   m_iPPSLength = 0;
+   m_uCurrentNALOffset = 0;
+   m_uCurrentAUOffset = 0;
+   m_bCurrentAUHasVCL = false;
+   m_bCurrentAUIsKeyframe = false;
+   m_iFragmentSamplesCount = 0;
+   m_uFragmentsCount = 0;
+   m_uFileOffset = 0;
+   m_uDurationFileOffset = 0;
+   m_uWrittenFramesCount = 0;
+}
+
+MP4Muxer::~MP4Muxer()
+{
+   if ( NULL != m_pBuffer )
+      free(m_pBuffer);
+   m_pBuffer = NULL;
+}
+
+bool MP4Muxer::open(int iFile, int iVideoType, int iWidth, int iHeight, int iFPS)
+{
+   if ( iFile < 0 )
+      return false;
+
+   if ( NULL == m_pBuffer )
+   {
+      m_uBufferSize = 2*1024*1024;
+      m_pBuffer = (u8*) malloc(m_uBufferSize);
+      if ( NULL == m_pBuffer )
+      {
+         m_uBufferSize = 0;
+         log_softerror_and_alarm("[MP4Muxer] Failed to allocate samples buffer.");
+         return false;
+      }
+   }
+   m_Parser.init();
+   m_Parser.setPrefix("MP4Muxer");
+   m_iFile = iFile;
+   m_iVideoType = iVideoType;
+   m_iWidth = iWidth;
+   m_iHeight = iHeight;
+   if ( iFPS <= 0 )
+      iFPS = 30;
+   m_uSampleDuration = MP4_MUXER_TIMESCALE / iFPS;
+   m_bFoundFirstNAL = false;
+   m_bHeaderWritten = false;
+   m_bWriteFailed = false;
+   m_iVPSLength = 0;
+   m_iSPSLength = 0;
+   m_iPPSLength = 0;
+   m_uBufferUsed = 0;
+   m_uCurrentNALOffset = 0;
+   m_uCurrentAUOffset = 0;
+   m_bCurrentAUHasVCL = false;
+   m_bCurrentAUIsKeyframe = false;
+   m_iFragmentSamplesCount = 0;
+   m_uFragmentsCount = 0;
+   m_uFileOffset = 0;
+   m_uDurationFileOffset = 0;
+   m_uWrittenFramesCount = 0;
+   log_line("[MP4Muxer] Opened, video type: %s, %d x %d, %d fps", (iVideoType == VIDEO_TYPE_H265)?"H265":"H264", iWidth, iHeight, iFPS);
+   return true;
+}
+
+void MP4Muxer::addData(u8* pData, int iLength)
+{
+   if ( (m_iFile < 0) || m_bWriteFailed || (NULL == pData) )
+      return;
+
+   while ( iLength > 0 )
+   {
+      int iBytesParsed = m_Parser.parseDataUntilStartOfNextNALOrLimit(pData, iLength, iLength, 0);
+      if ( iBytesParsed <= 0 )
+         break;
+      _addParsedBytes(pData, iBytesParsed);
+      pData += iBytesParsed;
+      iLength -= iBytesParsed;
+   }
+}
+
+void MP4Muxer::close()
+{
+   if ( m_iFile < 0 )
+      return;
+
+   if ( m_bFoundFirstNAL && (! m_bWriteFailed) )
+   if ( _ensureBufferSpace(4) )
+   {
+      // End the last NAL and the last frame as if a new NAL would start
+      m_pBuffer[m_uBufferUsed++] = 0;
+      m_pBuffer[m_uBufferUsed++] = 0;
+      m_pBuffer[m_uBufferUsed++] = 0;
+      m_pBuffer[m_uBufferUsed++] = 1;
+      _onNALEnd();
+      if ( m_bCurrentAUHasVCL )
+         _onAccessUnitEnd(m_uCurrentNALOffset);
+      if ( (m_iFragmentSamplesCount > 0) && (! m_bWriteFailed) )
+         _writeFragment(m_uCurrentAUOffset);
+   }
+
+   if ( m_bHeaderWritten && (0 != m_uDurationFileOffset) )
+   {
+      u8 uDuration[4];
+      t_mp4_writer writer = { uDuration, 0 };
+      _mp4_put32(&writer, m_uWrittenFramesCount * m_uSampleDuration);
+      if ( 4 != pwrite(m_iFile, uDuration, 4, (off_t)m_uDurationFileOffset) )
+         log_softerror_and_alarm("[MP4Muxer] Failed to update the file duration.");
+   }
+   log_line("[MP4Muxer] Closed. Written %u frames in %u fragments, %u bytes.", m_uWrittenFramesCount, m_uFragmentsCount, (u32)m_uFileOffset);
+   m_iFile = -1;
+   m_uBufferUsed = 0;
+   m_iFragmentSamplesCount = 0;
+}
+
+bool MP4Muxer::isOpen()
+{
+   return (m_iFile >= 0);
+}
+
+bool MP4Muxer::hasStarted()
+{
+   return m_bHeaderWritten;
+}
+
+u32 MP4Muxer::getWrittenFramesCount()
+{
+   return m_uWrittenFramesCount;
+}
+
+u32 MP4Muxer::getWrittenBytesCount()
+{
+   return (u32)m_uFileOffset;
+}
+
+void MP4Muxer::_addParsedBytes(u8* pData, int iLength)
+{
+   bool bNALStart = m_Parser.lastParseDetectedNALStart();
+   if ( ! m_bFoundFirstNAL )
+   {
+      if ( ! bNALStart )
+         return;
+      // The start code bytes become the length field of the first NAL
+      m_bFoundFirstNAL = true;
+      m_uBufferUsed = 4;
+      m_uCurrentNALOffset = 0;
+      m_uCurrentAUOffset = 0;
+      return;
+   }
+
+   if ( ! _ensureBufferSpace(iLength) )
+      return;
+   memcpy(m_pBuffer + m_uBufferUsed, pData, iLength);
+   m_uBufferUsed += iLength;
+   if ( bNALStart )
+      _onNALEnd();
+}
+
+// The NAL is in the buffer from m_uCurrentNALOffset + 4 up to the next start code, the last 4 bytes in the buffer
+void MP4Muxer::_onNALEnd()
+{
+   u32 uNALStart = m_uCurrentNALOffset + 4;
+   u32 uNALEnd = m_uBufferUsed - 4;
+   if ( uNALEnd <= uNALStart )
+   {
+      // Empty NAL
+      m_uBufferUsed = uNALStart;
+      return;
+   }
+   u32 uNALLength = uNALEnd - uNALStart;
+   u8* pNAL = m_pBuffer + uNALStart;
+
+   bool bVCL = false;
+   bool bFirstSlice = false;
+   bool bKeyframe = false;
+   bool bStartsAU = false;
+   if ( m_iVideoType == VIDEO_TYPE_H265 )
+   {
+      u32 uType = (pNAL[0] >> 1) & 0x3F;
+      if ( uType < 32 )
+      {
+         bVCL = true;
+         bFirstSlice = (uNALLength > 2) && (pNAL[2] & 0x80);
+         bKeyframe = (uType >= 16) && (uType <= 21);
+      }
+      else if ( (uType <= 35) || (uType == 39) || ((uType >= 41) && (uType <= 44)) || ((uType >= 48) && (uType <= 55)) )
+         bStartsAU = true;
+
+      if ( (uType >= 32) && (uType <= 34) && (uNALLength <= MP4_MUXER_MAX_PARAM_SET_SIZE) )
+      {
+         u8* pDest = (uType == 32)?m_uVPS:((uType == 33)?m_uSPS:m_uPPS);
+         memcpy(pDest, pNAL, uNALLength);
+         if ( uType == 32 )
+            m_iVPSLength = uNALLength;
+         else if ( uType == 33 )
+            m_iSPSLength = uNALLength;
+         else
+            m_iPPSLength = uNALLength;
+      }
+   }
+   else
+   {
+      u32 uType = pNAL[0] & 0x1F;
+      if ( (uType >= 1) && (uType <= 5) )
+      {
+         bVCL = true;
+         // first_mb_in_slice is 0 (coded as a single 1 bit) for the first slice of a frame
+         bFirstSlice = (uNALLength > 1) && (pNAL[1] & 0x80);
+         bKeyframe = (uType == 5);
+      }
+      else if ( ((uType >= 6) && (uType <= 9)) || ((uType >= 14) && (uType <= 18)) )
+         bStartsAU = true;
+
+      if ( (uType == 7) && (uNALLength <= MP4_MUXER_MAX_PARAM_SET_SIZE) )
+      {
+         memcpy(m_uSPS, pNAL, uNALLength);
+         m_iSPSLength = uNALLength;
+      }
+      if ( (uType == 8) && (uNALLength <= MP4_MUXER_MAX_PARAM_SET_SIZE) )
+      {
+         memcpy(m_uPPS, pNAL, uNALLength);
+         m_iPPSLength = uNALLength;
+      }
+   }
+
+   if ( m_bCurrentAUHasVCL && (bStartsAU || (bVCL && bFirstSlice)) )
+      _onAccessUnitEnd(m_uCurrentNALOffset);
+
+   if ( bVCL )
+      m_bCurrentAUHasVCL = true;
+   if ( bKeyframe )
+      m_bCurrentAUIsKeyframe = true;
+
+   u8* pLength = m_pBuffer + m_uCurrentNALOffset;
+   pLength[0] = (u8)(uNALLength >> 24);
+   pLength[1] = (u8)(uNALLength >> 16);
+   pLength[2] = (u8)(uNALLength >> 8);
+   pLength[3] = (u8)uNALLength;
+   m_uCurrentNALOffset = m_uBufferUsed - 4;
+}
+
+// The frame is in the buffer from m_uCurrentAUOffset up to uEndOffset. What follows it belongs to the next frame.
+void MP4Muxer::_onAccessUnitEnd(u32 uEndOffset)
+{
+   bool bKeep = true;
+   if ( ! m_bHeaderWritten )
+   {
+      bKeep = false;
+      if ( m_bCurrentAUIsKeyframe && (m_iSPSLength > 0) && (m_iPPSLength > 0) )
+      if ( (m_iVideoType != VIDEO_TYPE_H265) || (m_iVPSLength > 0) )
+         bKeep = _writeHeader();
+   }
+
+   if ( bKeep && (uEndOffset > m_uCurrentAUOffset) )
+   {
+      m_uFragmentSamplesSizes[m_iFragmentSamplesCount] = uEndOffset - m_uCurrentAUOffset;
+      // sample_depends_on: 2 (no other samples) for keyframes, 1 and sample_is_non_sync_sample for the rest
+      m_uFragmentSamplesFlags[m_iFragmentSamplesCount] = m_bCurrentAUIsKeyframe?0x02000000:0x01010000;
+      m_iFragmentSamplesCount++;
+   }
+   else if ( uEndOffset > m_uCurrentAUOffset )
+   {
+      u32 uShift = uEndOffset - m_uCurrentAUOffset;
+      memmove(m_pBuffer + m_uCurrentAUOffset, m_pBuffer + uEndOffset, m_uBufferUsed - uEndOffset);
+      m_uBufferUsed -= uShift;
+      m_uCurrentNALOffset -= uShift;
+      uEndOffset = m_uCurrentAUOffset;
+   }
+
+   m_uCurrentAUOffset = uEndOffset;
+   m_bCurrentAUHasVCL = false;
+   m_bCurrentAUIsKeyframe = false;
+
+   if ( 0 == m_iFragmentSamplesCount )
+      return;
+   if ( (m_iFragmentSamplesCount < MP4_MUXER_MAX_FRAGMENT_SAMPLES) &&
+        ((u32)m_iFragmentSamplesCount * m_uSampleDuration < (u32)(MP4_MUXER_FRAGMENT_DURATION_MS * (MP4_MUXER_TIMESCALE/1000))) &&
+        (uEndOffset < MP4_MUXER_MAX_BUFFER_SIZE/2) )
+      return;
+
+   _writeFragment(uEndOffset);
+   memmove(m_pBuffer, m_pBuffer + uEndOffset, m_uBufferUsed - uEndOffset);
+   m_uBufferUsed -= uEndOffset;
+   m_uCurrentNALOffset -= uEndOffset;
+   m_uCurrentAUOffset = 0;
+}
+
+bool MP4Muxer::_writeHeader()
+{
+   u8 uHeader[1024 + 3*MP4_MUXER_MAX_PARAM_SET_SIZE];
+   t_mp4_writer writer = { uHeader, 0 };
+   t_mp4_writer* w = &writer;
+   bool bH265 = (m_iVideoType == VIDEO_TYPE_H265);
+
+   u8 uPTL[12];
+   if ( bH265 && (! _mp4_get_h265_profile_tier_level(m_uSPS, m_iSPSLength, uPTL)) )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Invalid H265 SPS (%d bytes).", m_iSPSLength);
+      return false;
+   }
+
+   int iFTYP = _mp4_begin_box(w, "ftyp");
+   _mp4_put_fourcc(w, "isom");
+   _mp4_put32(w, 0x200);
+   _mp4_put_fourcc(w, "isom");
+   _mp4_put_fourcc(w, "iso6");
+   _mp4_put_fourcc(w, "mp41");
+   _mp4_put_fourcc(w, bH265?"hvc1":"avc1");
+   _mp4_end_box(w, iFTYP);
+
+   int iMOOV = _mp4_begin_box(w, "moov");
+
+   int iMVHD = _mp4_begin_full_box(w, "mvhd", 0, 0);
+   _mp4_put32(w, 0); // creation time
+   _mp4_put32(w, 0); // modification time
+   _mp4_put32(w, MP4_MUXER_TIMESCALE);
+   _mp4_put32(w, 0); // duration, from the fragments
+   _mp4_put32(w, 0x00010000); // rate
+   _mp4_put16(w, 0x0100); // volume
+   _mp4_put_zeros(w, 10);
+   _mp4_put_matrix(w);
+   _mp4_put_zeros(w, 24);
+   _mp4_put32(w, 2); // next track id
+   _mp4_end_box(w, iMVHD);
+
+   int iTRAK = _mp4_begin_box(w, "trak");
+   int iTKHD = _mp4_begin_full_box(w, "tkhd", 0, 3);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 1); // track id
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 0); // duration
+   _mp4_put_zeros(w, 8);
+   _mp4_put16(w, 0); // layer
+   _mp4_put16(w, 0); // alternate group
+   _mp4_put16(w, 0); // volume
+   _mp4_put16(w, 0);
+   _mp4_put_matrix(w);
+   _mp4_put32(w, ((u32)m_iWidth) << 16);
+   _mp4_put32(w, ((u32)m_iHeight) << 16);
+   _mp4_end_box(w, iTKHD);
+
+   int iMDIA = _mp4_begin_box(w, "mdia");
+   int iMDHD = _mp4_begin_full_box(w, "mdhd", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, MP4_MUXER_TIMESCALE);
+   _mp4_put32(w, 0);
+   _mp4_put16(w, 0x55C4); // language: und
+   _mp4_put16(w, 0);
+   _mp4_end_box(w, iMDHD);
+
+   int iHDLR = _mp4_begin_full_box(w, "hdlr", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_put_fourcc(w, "vide");
+   _mp4_put_zeros(w, 12);
+   _mp4_put_bytes(w, (const u8*)"VideoHandler", 13);
+   _mp4_end_box(w, iHDLR);
+
+   int iMINF = _mp4_begin_box(w, "minf");
+   int iVMHD = _mp4_begin_full_box(w, "vmhd", 0, 1);
+   _mp4_put_zeros(w, 8);
+   _mp4_end_box(w, iVMHD);
+
+   int iDINF = _mp4_begin_box(w, "dinf");
+   int iDREF = _mp4_begin_full_box(w, "dref", 0, 0);
+   _mp4_put32(w, 1);
+   int iURL = _mp4_begin_full_box(w, "url ", 0, 1);
+   _mp4_end_box(w, iURL);
+   _mp4_end_box(w, iDREF);
+   _mp4_end_box(w, iDINF);
+
+   int iSTBL = _mp4_begin_box(w, "stbl");
+   int iSTSD = _mp4_begin_full_box(w, "stsd", 0, 0);
+   _mp4_put32(w, 1);
+   int iEntry = _mp4_begin_box(w, bH265?"hvc1":"avc1");
+   _mp4_put_zeros(w, 6);
+   _mp4_put16(w, 1); // data reference index
+   _mp4_put_zeros(w, 16);
+   _mp4_put16(w, m_iWidth);
+   _mp4_put16(w, m_iHeight);
+   _mp4_put32(w, 0x00480000); // 72 dpi
+   _mp4_put32(w, 0x00480000);
+   _mp4_put32(w, 0);
+   _mp4_put16(w, 1); // frame count
+   _mp4_put_zeros(w, 32); // compressor name
+   _mp4_put16(w, 0x0018); // depth
+   _mp4_put16(w, 0xFFFF);
+
+   if ( bH265 )
+   {
+      int iHVCC = _mp4_begin_box(w, "hvcC");
+      _mp4_put8(w, 1);
+      _mp4_put_bytes(w, uPTL, 12);
+      _mp4_put16(w, 0xF000); // min spatial segmentation
+      _mp4_put8(w, 0xFC); // parallelism type
+      _mp4_put8(w, 0xFD); // chroma format 4:2:0
+      _mp4_put8(w, 0xF8); // luma bit depth 8
+      _mp4_put8(w, 0xF8); // chroma bit depth 8
+      _mp4_put16(w, 0); // average frame rate
+      _mp4_put8(w, 0x0F); // 1 temporal layer, temporal id nested, 4 bytes NAL lengths
+      _mp4_put8(w, 3);
+      u8* pSets[3] = { m_uVPS, m_uSPS, m_uPPS };
+      int iLengths[3] = { m_iVPSLength, m_iSPSLength, m_iPPSLength };
+      for( int i=0; i<3; i++ )
+      {
+         _mp4_put8(w, 0x80 | (32+i));
+         _mp4_put16(w, 1);
+         _mp4_put16(w, iLengths[i]);
+         _mp4_put_bytes(w, pSets[i], iLengths[i]);
+      }
+      _mp4_end_box(w, iHVCC);
+   }
+   else
+   {
+      int iAVCC = _mp4_begin_box(w, "avcC");
+      _mp4_put8(w, 1);
+      _mp4_put8(w, (m_iSPSLength > 1)?m_uSPS[1]:0); // profile
+      _mp4_put8(w, (m_iSPSLength > 2)?m_uSPS[2]:0); // profile compatibility
+      _mp4_put8(w, (m_iSPSLength > 3)?m_uSPS[3]:0); // level
+      _mp4_put8(w, 0xFF); // 4 bytes NAL lengths
+      _mp4_put8(w, 0xE1); // one SPS
+      _mp4_put16(w, m_iSPSLength);
+      _mp4_put_bytes(w, m_uSPS, m_iSPSLength);
+      _mp4_put8(w, 1);
+      _mp4_put16(w, m_iPPSLength);
+      _mp4_put_bytes(w, m_uPPS, m_iPPSLength);
+      _mp4_end_box(w, iAVCC);
+   }
+   _mp4_end_box(w, iEntry);
+   _mp4_end_box(w, iSTSD);
+
+   // Empty samples tables, the samples are in the fragments
+   int iBox = _mp4_begin_full_box(w, "stts", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_end_box(w, iBox);
+   iBox = _mp4_begin_full_box(w, "stsc", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_end_box(w, iBox);
+   iBox = _mp4_begin_full_box(w, "stsz", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 0);
+   _mp4_end_box(w, iBox);
+   iBox = _mp4_begin_full_box(w, "stco", 0, 0);
+   _mp4_put32(w, 0);
+   _mp4_end_box(w, iBox);
+   _mp4_end_box(w, iSTBL);
+   _mp4_end_box(w, iMINF);
+   _mp4_end_box(w, iMDIA);
+   _mp4_end_box(w, iTRAK);
+
+   int iMVEX = _mp4_begin_box(w, "mvex");
+   int iMEHD = _mp4_begin_full_box(w, "mehd", 0, 0);
+   u32 uDurationOffset = w->iPos;
+   _mp4_put32(w, 0); // updated on close
+   _mp4_end_box(w, iMEHD);
+   int iTREX = _mp4_begin_full_box(w, "trex", 0, 0);
+   _mp4_put32(w, 1); // track id
+   _mp4_put32(w, 1); // sample description index
+   _mp4_put32(w, m_uSampleDuration);
+   _mp4_put32(w, 0);
+   _mp4_put32(w, 0x01010000);
+   _mp4_end_box(w, iTREX);
+   _mp4_end_box(w, iMVEX);
+   _mp4_end_box(w, iMOOV);
+
+   m_uDurationFileOffset = m_uFileOffset + uDurationOffset;
+   if ( ! _writeBuffers(uHeader, w->iPos, NULL, 0) )
+      return false;
+   m_bHeaderWritten = true;
+   log_line("[MP4Muxer] Written header (%d bytes), SPS: %d bytes, PPS: %d bytes.", w->iPos, m_iSPSLength, m_iPPSLength);
+   return true;
+}
+
+bool MP4Muxer::_writeFragment(u32 uLength)
+{
+   u8 uHeader[128 + 8*MP4_MUXER_MAX_FRAGMENT_SAMPLES];
+   t_mp4_writer writer = { uHeader, 0 };
+   t_mp4_writer* w = &writer;
+
+   m_uFragmentsCount++;
+   int iMOOF = _mp4_begin_box(w, "moof");
+   int iMFHD = _mp4_begin_full_box(w, "mfhd", 0, 0);
+   _mp4_put32(w, m_uFragmentsCount);
+   _mp4_end_box(w, iMFHD);
+
+   int iTRAF = _mp4_begin_box(w, "traf");
+   int iTFHD = _mp4_begin_full_box(w, "tfhd", 0, 0x020000); // default base is moof
+   _mp4_put32(w, 1);
+   _mp4_end_box(w, iTFHD);
+   int iTFDT = _mp4_begin_full_box(w, "tfdt", 1, 0);
+   _mp4_put64(w, ((unsigned long long)m_uWrittenFramesCount) * m_uSampleDuration);
+   _mp4_end_box(w, iTFDT);
+
+   // data offset, samples sizes and samples flags present
+   int iTRUN = _mp4_begin_full_box(w, "trun", 0, 0x000001 | 0x000200 | 0x000400);
+   _mp4_put32(w, m_iFragmentSamplesCount);
+   int iDataOffsetPos = w->iPos;
+   _mp4_put32(w, 0);
+   for( int i=0; i<m_iFragmentSamplesCount; i++ )
+   {
+      _mp4_put32(w, m_uFragmentSamplesSizes[i]);
+      _mp4_put32(w, m_uFragmentSamplesFlags[i]);
+   }
+   _mp4_end_box(w, iTRUN);
+   _mp4_end_box(w, iTRAF);
+   _mp4_end_box(w, iMOOF);
+
+   int iMOOFSize = w->iPos - iMOOF;
+   t_mp4_writer writerOffset = { uHeader, iDataOffsetPos };
+   _mp4_put32(&writerOffset, iMOOFSize + 8);
+
+   _mp4_put32(w, uLength + 8);
+   _mp4_put_fourcc(w, "mdat");
+
+   bool bOk = _writeBuffers(uHeader, w->iPos, m_pBuffer, uLength);
+   if ( bOk )
+      m_uWrittenFramesCount += m_iFragmentSamplesCount;
+   m_iFragmentSamplesCount = 0;
+   return bOk;
+}
+
+// Writes the buffers and a free box that aligns the file to MP4_MUXER_WRITE_ALIGNMENT, in a single write
+bool MP4Muxer::_writeBuffers(u8* pHeader, int iHeaderLength, u8* pData, u32 uDataLength)
+{
+   u32 uTotal = iHeaderLength + uDataLength;
+   u32 uPadding = (MP4_MUXER_WRITE_ALIGNMENT - ((m_uFileOffset + uTotal) % MP4_MUXER_WRITE_ALIGNMENT)) % MP4_MUXER_WRITE_ALIGNMENT;
+   if ( (uPadding > 0) && (uPadding < 8) )
+      uPadding += MP4_MUXER_WRITE_ALIGNMENT;
+
+   u8 uFreeBox[8];
+   t_mp4_writer writer = { uFreeBox, 0 };
+   _mp4_put32(&writer, uPadding);
+   _mp4_put_fourcc(&writer, "free");
+
+   struct iovec vectors[5];
+   int iCount = 0;
+   vectors[iCount].iov_base = pHeader;
+   vectors[iCount].iov_len = iHeaderLength;
+   iCount++;
+   if ( (NULL != pData) && (uDataLength > 0) )
+   {
+      vectors[iCount].iov_base = pData;
+      vectors[iCount].iov_len = uDataLength;
+      iCount++;
+   }
+   if ( uPadding > 0 )
+   {
+      vectors[iCount].iov_base = uFreeBox;
+      vectors[iCount].iov_len = 8;
+      iCount++;
+      u32 uZeros = uPadding - 8;
+      while ( uZeros > 0 )
+      {
+         u32 uChunk = (uZeros > MP4_MUXER_WRITE_ALIGNMENT)?MP4_MUXER_WRITE_ALIGNMENT:uZeros;
+         vectors[iCount].iov_base = s_uMP4MuxerZeroPadding;
+         vectors[iCount].iov_len = uChunk;
+         iCount++;
+         uZeros -= uChunk;
+      }
+   }
+
+   ssize_t iRes = writev(m_iFile, vectors, iCount);
+   if ( iRes != (ssize_t)(uTotal + uPadding) )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Failed to write %u bytes, result: %d, error: %d (%s)", uTotal + uPadding, (int)iRes, errno, strerror(errno));
+      m_bWriteFailed = true;
+      return false;
+   }
+   // Commit each fragment, so that a power loss keeps all but the last one
+   fdatasync(m_iFile);
+   m_uFileOffset += uTotal + uPadding;
+   return true;
+}
+
+bool MP4Muxer::_ensureBufferSpace(u32 uSize)
+{
+   if ( m_uBufferUsed + uSize <= m_uBufferSize )
+      return true;
+
+   u32 uNewSize = m_uBufferSize * 2;
+   while ( uNewSize < m_uBufferUsed + uSize )
+      uNewSize *= 2;
+   if ( uNewSize > MP4_MUXER_MAX_BUFFER_SIZE )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Frame too big (%u bytes buffered). Discard buffered data.", m_uBufferUsed + uSize);
+      m_bFoundFirstNAL = false;
+      m_uBufferUsed = 0;
+      m_uCurrentNALOffset = 0;
+      m_uCurrentAUOffset = 0;
+      m_bCurrentAUHasVCL = false;
+      m_bCurrentAUIsKeyframe = false;
+      m_iFragmentSamplesCount = 0;
+      return false;
+   }
+   u8* pNewBuffer = (u8*) realloc(m_pBuffer, uNewSize);
+   if ( NULL == pNewBuffer )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Failed to grow samples buffer to %u bytes.", uNewSize);
+      return false;
+   }
+   m_pBuffer = pNewBuffer;
+   m_uBufferSize = uNewSize;
+   return true;
+}
+
+static bool _mp4_write_start_code_and_nal(FILE* fdOut, u8* pNAL, u32 uLength)
+{
+   static const u8 s_uStartCode[4] = { 0, 0, 0, 1 };
+   if ( 1 != fwrite(s_uStartCode, 4, 1, fdOut) )
+      return false;
+   if ( 1 != fwrite(pNAL, uLength, 1, fdOut) )
+      return false;
+   return true;
+}
+
+// Writes the parameter sets from the codec configuration box (avcC or hvcC)
+static int _mp4_write_parameter_sets(FILE* fdOut, u8* pData, u32 uLength)
+{
+   int iCount = 0;
+   for( u32 u=0; u+8 < uLength; u++ )
+   {
+      if ( 0 == memcmp(pData+u, "avcC", 4) )
+      {
+         u8* p = pData + u + 4;
+         u8* pEnd = pData + uLength;
+         if ( p + 6 > pEnd )
+            return iCount;
+         p += 5;
+         for( int iSet=0; iSet<2; iSet++ )
+         {
+            if ( p >= pEnd )
+               break;
+            int iSets = (0 == iSet)?((*p) & 0x1F):(*p);
+            p++;
+            for( int i=0; i<iSets; i++ )
+            {
+               if ( p + 2 > pEnd )
+                  return iCount;
+               u32 uSetLength = (((u32)p[0]) << 8) | p[1];
+               p += 2;
+               if ( p + uSetLength > pEnd )
+                  return iCount;
+               if ( _mp4_write_start_code_and_nal(fdOut, p, uSetLength) )
+                  iCount++;
+               p += uSetLength;
+            }
+         }
+         return iCount;
+      }
+      if ( 0 == memcmp(pData+u, "hvcC", 4) )
+      {
+         u8* p = pData + u + 4;
+         u8* pEnd = pData + uLength;
+         if ( p + 23 > pEnd )
+            return iCount;
+         p += 22;
+         int iArrays = *p;
+         p++;
+         for( int iArray=0; iArray<iArrays; iArray++ )
+         {
+            if ( p + 3 > pEnd )
+               return iCount;
+            int iNALs = (((int)p[1]) << 8) | p[2];
+            p += 3;
+            for( int i=0; i<iNALs; i++ )
+            {
+               if ( p + 2 > pEnd )
+                  return iCount;
+               u32 uSetLength = (((u32)p[0]) << 8) | p[1];
+               p += 2;
+               if ( p + uSetLength > pEnd )
+                  return iCount;
+               if ( _mp4_write_start_code_and_nal(fdOut, p, uSetLength) )
+                  iCount++;
+               p += uSetLength;
+            }
+         }
+         return iCount;
+      }
+   }
+   return iCount;
+}
+
+int mp4_muxer_extract_video_stream(const char* szFileIn, const char* szFileOut)
+{
+   if ( (NULL == szFileIn) || (NULL == szFileOut) )
+      return -1;
+   FILE* fdIn = fopen(szFileIn, "rb");
+   if ( NULL == fdIn )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Failed to open input file [%s]", szFileIn);
+      return -1;
+   }
+   FILE* fdOut = fopen(szFileOut, "wb");
+   if ( NULL == fdOut )
+   {
+      log_softerror_and_alarm("[MP4Muxer] Failed to create output file [%s]", szFileOut);
+      fclose(fdIn);
+      return -1;
+   }
+
+   int iCountNALs = 0;
+   u8* pBox = NULL;
+   u32 uBoxAllocated = 0;
+   u8 uBoxHeader[8];
+   while ( 1 == fread(uBoxHeader, 8, 1, fdIn) )
+   {
+      u32 uBoxSize = _mp4_get32(uBoxHeader);
+      if ( uBoxSize < 8 )
+         break;
+      u32 uPayload = uBoxSize - 8;
+      bool bMDAT = (0 == memcmp(uBoxHeader+4, "mdat", 4));
+      bool bMOOV = (0 == memcmp(uBoxHeader+4, "moov", 4));
+      if ( (! bMDAT) && (! bMOOV) )
+      {
+         if ( 0 != fseek(fdIn, uPayload, SEEK_CUR) )
+            break;
+         continue;
+      }
+      if ( uPayload > uBoxAllocated )
+      {
+         u8* pNew = (u8*) realloc(pBox, uPayload);
+         if ( NULL == pNew )
+            break;
+         pBox = pNew;
+         uBoxAllocated = uPayload;
+      }
+      // A cut file can end inside the last box; use what is there
+      u32 uRead = (u32)fread(pBox, 1, uPayload, fdIn);
+
+      if ( bMOOV )
+      {
+         iCountNALs += _mp4_write_parameter_sets(fdOut, pBox, uRead);
+         continue;
+      }
+      u32 uPos = 0;
+      while ( uPos + 4 <= uRead )
+      {
+         u32 uNALLength = _mp4_get32(pBox + uPos);
+         uPos += 4;
+         if ( (0 == uNALLength) || (uPos + uNALLength > uRead) )
+            break;
+         if ( ! _mp4_write_start_code_and_nal(fdOut, pBox + uPos, uNALLength) )
+            break;
+         iCountNALs++;
+         uPos += uNALLength;
+      }
+      if ( uRead < uPayload )
+         break;
+   }
+
+   if ( NULL != pBox )
+      free(pBox);
+   fclose(fdIn);
+   fclose(fdOut);
+   log_line("[MP4Muxer] Extracted %d NAL units from [%s] to [%s]", iCountNALs, szFileIn, szFileOut);
+   return iCountNALs;
+}
+
+int mp4_muxer_get_frames_count(const char* szFile)
+{
+   if ( NULL == szFile )
+      return -1;
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+      return -1;
+
+   fseek(fd, 0, SEEK_END);
+   long lFileSize = ftell(fd);
+   fseek(fd, 0, SEEK_SET);
+
+   int iFrames = 0;
+   int iFragmentFrames = 0;
+   long lPos = 0;
+   u8 uBox[8 + 16 + 8 + 16 + 20 + 16];
+   while ( lPos + 8 <= lFileSize )
+   {
+      if ( 0 != fseek(fd, lPos, SEEK_SET) )
+         break;
+      if ( 1 != fread(uBox, 8, 1, fd) )
+         break;
+      u32 uBoxSize = _mp4_get32(uBox);
+      if ( (uBoxSize < 8) || (lPos + (long)uBoxSize > lFileSize) )
+         break;
+      if ( 0 == memcmp(uBox+4, "moof", 4) )
+      {
+         // moof: mfhd, traf: tfhd, tfdt, trun (as written by MP4Muxer)
+         iFragmentFrames = 0;
+         if ( 1 == fread(uBox+8, sizeof(uBox)-8, 1, fd) )
+         if ( 0 == memcmp(uBox + 8 + 16 + 8 + 16 + 20 + 4, "trun", 4) )
+            iFragmentFrames = (int)_mp4_get32(uBox + 8 + 16 + 8 + 16 + 20 + 12);
+      }
+      // A fragment counts only if its data is complete
+      if ( 0 == memcmp(uBox+4, "mdat", 4) )
+      {
+         iFrames += iFragmentFrames;
+         iFragmentFrames = 0;
+      }
+      lPos += uBoxSize;
+   }
+   fclose(fd);
+   return iFrames;
+}
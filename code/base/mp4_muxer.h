@@ -0,0 +1,82 @@
+#pragma once
+#include "base.h"
+#include "parser_h264.h"
+
+// Streaming fragmented MP4 muxer for H264/H265 Annex B streams.
+// The header (ftyp, moov) is written on the first keyframe, then each fragment (moof, mdat) is written at once,
+// padded to MP4_MUXER_WRITE_ALIGNMENT bytes. A file cut at any point plays up to the last complete fragment.
+
+#define MP4_MUXER_TIMESCALE 90000
+#define MP4_MUXER_FRAGMENT_DURATION_MS 1000
+#define MP4_MUXER_MAX_FRAGMENT_SAMPLES 512
+#define MP4_MUXER_WRITE_ALIGNMENT 4096
+#define MP4_MUXER_MAX_BUFFER_SIZE (32*1024*1024)
+#define MP4_MUXER_MAX_PARAM_SET_SIZE 256
+
+class MP4Muxer
+{
+   public:
+      MP4Muxer();
+      virtual ~MP4Muxer();
+
+      // iFile must be an empty file opened for writing. iFPS of 0 uses a default frame rate.
+      bool open(int iFile, int iVideoType, int iWidth, int iHeight, int iFPS);
+      void addData(u8* pData, int iLength);
+      // Writes the pending frames and the final duration. Does not close the file.
+      void close();
+
+      bool isOpen();
+      bool hasStarted();
+      u32 getWrittenFramesCount();
+      u32 getWrittenBytesCount();
+
+   protected:
+      void _addParsedBytes(u8* pData, int iLength);
+      void _onNALEnd();
+      void _onAccessUnitEnd(u32 uEndOffset);
+      bool _writeHeader();
+      bool _writeFragment(u32 uLength);
+      bool _writeBuffers(u8* pHeader, int iHeaderLength, u8* pData, u32 uDataLength);
+      bool _ensureBufferSpace(u32 uSize);
+
+      ParserH264 m_Parser;
+      int m_iFile;
+      int m_iVideoType;
+      int m_iWidth;
+      int m_iHeight;
+      u32 m_uSampleDuration;
+      bool m_bFoundFirstNAL;
+      bool m_bHeaderWritten;
+      bool m_bWriteFailed;
+
+      // Parameter sets, used for the codec configuration in the header
+      u8 m_uVPS[MP4_MUXER_MAX_PARAM_SET_SIZE];
+      u8 m_uSPS[MP4_MUXER_MAX_PARAM_SET_SIZE];
+      u8 m_uPPS[MP4_MUXER_MAX_PARAM_SET_SIZE];
+      int m_iVPSLength;
+      int m_iSPSLength;
+      int m_iPPSLength;
+
+      // Samples data, as length prefixed NAL units (the mdat payload). Start codes are replaced in place by the NAL lengths.
+      u8* m_pBuffer;
+      u32 m_uBufferSize;
+      u32 m_uBufferUsed;
+      u32 m_uCurrentNALOffset;
+      u32 m_uCurrentAUOffset;
+      bool m_bCurrentAUHasVCL;
+      bool m_bCurrentAUIsKeyframe;
+
+      u32 m_uFragmentSamplesSizes[MP4_MUXER_MAX_FRAGMENT_SAMPLES];
+      u32 m_uFragmentSamplesFlags[MP4_MUXER_MAX_FRAGMENT_SAMPLES];
+      int m_iFragmentSamplesCount;
+      u32 m_uFragmentsCount;
+
+      unsigned long long m_uFileOffset;
+      unsigned long long m_uDurationFileOffset;
+      u32 m_uWrittenFramesCount;
+};
+
+// Converts a file written by MP4Muxer back to an Annex B stream. Returns the number of NAL units written or -1 on error.
+int mp4_muxer_extract_video_stream(const char* szFileIn, const char* szFileOut);
+// Returns the number of frames in the complete fragments of a file written by MP4Muxer, or -1 on error
+int mp4_muxer_get_frames_count(const char* szFile);
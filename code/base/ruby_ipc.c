@@ -40,10 +40,17 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
 #include <errno.h>
 
+// Only one IPC backend must be enabled
 //#define RUBY_USE_FIFO_PIPES 1
-#define RUBY_USES_MSGQUEUES 1
+//#define RUBY_USES_MSGQUEUES 1
+#define RUBY_USES_SHM_RINGS 1
 
 #define FIFO_RUBY_ROUTER_TO_CENTRAL "/tmp/ruby/fiforoutercentral"
 #define FIFO_RUBY_CENTRAL_TO_ROUTER "/tmp/ruby/fifocentralrouter"
@@ -116,6 +123,328 @@ char* _ruby_ipc_get_channel_name(int nChannelType)
    return s_szRubyIPCChannelType;
 }
 
+#ifdef RUBY_USES_SHM_RINGS
+
+// Shared memory ring transport: one ring per channel type, in a shared memory object,
+// created by whichever endpoint (reader or writer) opens the channel first.
+// Multiple writers / single reader bounded queue: each slot has a sequence number that tells
+// if it's free for the writer at a given position or ready for the reader.
+// Writers wake up a blocked reader (ruby_ipc_wait_for_message) using a shared futex,
+// only when the reader flagged that it's waiting.
+// A reader that (re)opens a ring used by a previous reader discards the pending messages, they were for the old reader.
+// A slot claimed by a writer that never published it (i.e. writer killed while writing) is skipped
+// by the reader after a timeout, so the ring does not stay blocked.
+// As a writer that was only slow can still write into a skipped (and reused) slot, each slot CRC
+// also covers the ring position the message was written for, and the reader drops messages that don't match it.
+
+#define IPC_SHM_RING_MAGIC 0x52554249
+#define IPC_SHM_RING_VERSION 3
+#define IPC_SHM_RING_SLOTS 64
+#define IPC_SHM_RING_STUCK_SLOT_TIMEOUT_MS 500
+
+typedef struct
+{
+   u32 uSequence;
+   u32 uLength;
+   u32 uCRC; // CRC of the message data, xor the ring position it was written for
+   u8  uMsgId;
+   u8  uData[IPC_CHANNEL_MAX_MSG_SIZE];
+} type_ipc_shm_ring_slot;
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uSlotsCount;
+   u32 uSlotSize;
+   u32 uEnqueuePos; // Shared by all writers
+   u32 uDequeuePos; // Reader only
+   u32 uReaderWaiting;
+   u32 uWakeCounter; // Futex word
+   u32 uStatsFullCount;
+   u32 uStatsSkippedCount; // Claimed slots never published by the writer
+   u32 uReaderPid;
+   u32 uReaderSessions; // How many times a reader opened this ring
+   u32 uStuckPos; // Reader only: position+1 of the head slot claimed but not published yet, 0 if none
+   u32 uStuckSinceMs; // Reader only
+   type_ipc_shm_ring_slot slots[IPC_SHM_RING_SLOTS];
+} type_ipc_shm_ring;
+
+type_ipc_shm_ring* s_pRubyIPCChannelsRings[MAX_CHANNELS];
+
+char* _ruby_ipc_get_shm_ring_name(int nChannelType)
+{
+   static char s_szRubyShmRingName[64];
+   sprintf(s_szRubyShmRingName, "/ruby_ipc_ring_%d", nChannelType);
+   return s_szRubyShmRingName;
+}
+
+// Opens (and creates and initializes if needed) the shared memory ring for a channel type.
+// Returns the shared memory fd and the mapped ring in ppRing.
+
+int _ruby_ipc_open_shm_ring(int nChannelType, type_ipc_shm_ring** ppRing)
+{
+   *ppRing = NULL;
+   char* szName = _ruby_ipc_get_shm_ring_name(nChannelType);
+   int bCreated = 1;
+   int fd = shm_open(szName, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+   if ( (fd < 0) && (errno == EEXIST) )
+   {
+      bCreated = 0;
+      fd = shm_open(szName, O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+   }
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[IPC] Failed to open shared memory ring %s for channel %s, error %d, %s",
+         szName, _ruby_ipc_get_channel_name(nChannelType), errno, strerror(errno));
+      return -1;
+   }
+
+   if ( bCreated )
+   if ( 0 != ftruncate(fd, sizeof(type_ipc_shm_ring)) )
+   {
+      log_softerror_and_alarm("[IPC] Failed to set size of shared memory ring %s, error %d, %s", szName, errno, strerror(errno));
+      close(fd);
+      shm_unlink(szName);
+      return -1;
+   }
+
+   // The endpoint that did not create it waits for the creator to size it and initialize it
+   struct stat statBuff;
+   for( int i=0; i<100; i++ )
+   {
+      if ( (0 == fstat(fd, &statBuff)) && (statBuff.st_size >= (off_t)sizeof(type_ipc_shm_ring)) )
+         break;
+      hardware_sleep_ms(1);
+   }
+   if ( (0 != fstat(fd, &statBuff)) || (statBuff.st_size < (off_t)sizeof(type_ipc_shm_ring)) )
+   {
+      log_softerror_and_alarm("[IPC] Shared memory ring %s has invalid size.", szName);
+      close(fd);
+      return -1;
+   }
+
+   type_ipc_shm_ring* pRing = (type_ipc_shm_ring*) mmap(NULL, sizeof(type_ipc_shm_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if ( (MAP_FAILED == pRing) || (NULL == pRing) )
+   {
+      log_softerror_and_alarm("[IPC] Failed to map shared memory ring %s, error %d, %s", szName, errno, strerror(errno));
+      close(fd);
+      return -1;
+   }
+
+   if ( bCreated )
+   {
+      pRing->uVersion = IPC_SHM_RING_VERSION;
+      pRing->uSlotsCount = IPC_SHM_RING_SLOTS;
+      pRing->uSlotSize = sizeof(type_ipc_shm_ring_slot);
+      pRing->uEnqueuePos = 0;
+      pRing->uDequeuePos = 0;
+      pRing->uReaderWaiting = 0;
+      pRing->uWakeCounter = 0;
+      pRing->uStatsFullCount = 0;
+      pRing->uStatsSkippedCount = 0;
+      pRing->uReaderPid = 0;
+      pRing->uReaderSessions = 0;
+      pRing->uStuckPos = 0;
+      pRing->uStuckSinceMs = 0;
+      for( u32 i=0; i<IPC_SHM_RING_SLOTS; i++ )
+         pRing->slots[i].uSequence = i;
+      __atomic_store_n(&pRing->uMagic, IPC_SHM_RING_MAGIC, __ATOMIC_RELEASE);
+   }
+   else
+   {
+      for( int i=0; i<100; i++ )
+      {
+         if ( IPC_SHM_RING_MAGIC == __atomic_load_n(&pRing->uMagic, __ATOMIC_ACQUIRE) )
+            break;
+         hardware_sleep_ms(1);
+      }
+      if ( (IPC_SHM_RING_MAGIC != __atomic_load_n(&pRing->uMagic, __ATOMIC_ACQUIRE)) ||
+           (pRing->uVersion != IPC_SHM_RING_VERSION) || (pRing->uSlotsCount != IPC_SHM_RING_SLOTS) || (pRing->uSlotSize != sizeof(type_ipc_shm_ring_slot)) )
+      {
+         log_softerror_and_alarm("[IPC] Shared memory ring %s is not initialized or has a different version.", szName);
+         munmap(pRing, sizeof(type_ipc_shm_ring));
+         close(fd);
+         return -1;
+      }
+   }
+
+   log_line("[IPC] %s shared memory ring %s for channel %s (%d slots, %d bytes)", bCreated?"Created":"Opened",
+      szName, _ruby_ipc_get_channel_name(nChannelType), IPC_SHM_RING_SLOTS, (int)sizeof(type_ipc_shm_ring));
+   *ppRing = pRing;
+   return fd;
+}
+
+void _ruby_ipc_close_shm_ring(int iChannelIndex)
+{
+   if ( NULL != s_pRubyIPCChannelsRings[iChannelIndex] )
+      munmap(s_pRubyIPCChannelsRings[iChannelIndex], sizeof(type_ipc_shm_ring));
+   s_pRubyIPCChannelsRings[iChannelIndex] = NULL;
+   if ( s_iRubyIPCChannelsFd[iChannelIndex] > 0 )
+      close(s_iRubyIPCChannelsFd[iChannelIndex]);
+}
+
+// Returns 1 if the message was added to the ring, 0 if the ring is full
+
+int _ruby_ipc_shm_ring_write(type_ipc_shm_ring* pRing, u8 uMsgId, u8* pMessage, int iLength)
+{
+   u32 uPos = __atomic_load_n(&pRing->uEnqueuePos, __ATOMIC_RELAXED);
+   type_ipc_shm_ring_slot* pSlot = NULL;
+   while ( 1 )
+   {
+      pSlot = &(pRing->slots[uPos % IPC_SHM_RING_SLOTS]);
+      u32 uSeq = __atomic_load_n(&pSlot->uSequence, __ATOMIC_ACQUIRE);
+      int iDiff = (int)(uSeq - uPos);
+      if ( 0 == iDiff )
+      {
+         if ( __atomic_compare_exchange_n(&pRing->uEnqueuePos, &uPos, uPos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            break;
+      }
+      else if ( iDiff < 0 )
+         return 0;
+      else
+         uPos = __atomic_load_n(&pRing->uEnqueuePos, __ATOMIC_RELAXED);
+   }
+
+   pSlot->uMsgId = uMsgId;
+   pSlot->uLength = (u32)iLength;
+   memcpy(pSlot->uData, pMessage, iLength);
+   // From the source buffer, so that a concurrent stale writer into this slot can't make it match
+   pSlot->uCRC = base_compute_crc32(pMessage, iLength) ^ uPos;
+   // The reader might have skipped this slot if the writer was stalled for too long; the caller retries on a new slot
+   u32 uExpectedSeq = uPos;
+   if ( ! __atomic_compare_exchange_n(&pSlot->uSequence, &uExpectedSeq, uPos+1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) )
+      return 0;
+
+   if ( __atomic_load_n(&pRing->uReaderWaiting, __ATOMIC_SEQ_CST) )
+   {
+      __atomic_add_fetch(&pRing->uWakeCounter, 1, __ATOMIC_SEQ_CST);
+      syscall(SYS_futex, &pRing->uWakeCounter, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+   }
+   return 1;
+}
+
+int _ruby_ipc_shm_ring_has_message(type_ipc_shm_ring* pRing)
+{
+   u32 uPos = pRing->uDequeuePos;
+   u32 uSeq = __atomic_load_n(&pRing->slots[uPos % IPC_SHM_RING_SLOTS].uSequence, __ATOMIC_ACQUIRE);
+   return ((int)(uSeq - (uPos+1)) >= 0)?1:0;
+}
+
+// Returns 1 if the head slot was claimed by a writer that did not publish it in time, and it was skipped
+
+int _ruby_ipc_shm_ring_skip_stuck_slot(type_ipc_shm_ring* pRing, int iChannelType)
+{
+   u32 uPos = pRing->uDequeuePos;
+   if ( __atomic_load_n(&pRing->uEnqueuePos, __ATOMIC_ACQUIRE) == uPos )
+   {
+      pRing->uStuckPos = 0;
+      return 0;
+   }
+
+   u32 uTimeNow = get_current_timestamp_ms();
+   if ( pRing->uStuckPos != uPos+1 )
+   {
+      pRing->uStuckPos = uPos+1;
+      pRing->uStuckSinceMs = uTimeNow;
+      return 0;
+   }
+   if ( uTimeNow < pRing->uStuckSinceMs + IPC_SHM_RING_STUCK_SLOT_TIMEOUT_MS )
+      return 0;
+
+   // Release the slot for the next round only if the writer still did not publish it
+   u32 uExpectedSeq = uPos;
+   if ( ! __atomic_compare_exchange_n(&pRing->slots[uPos % IPC_SHM_RING_SLOTS].uSequence, &uExpectedSeq, uPos + IPC_SHM_RING_SLOTS, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) )
+      return 0;
+
+   pRing->uDequeuePos = uPos+1;
+   pRing->uStuckPos = 0;
+   pRing->uStatsSkippedCount++;
+   log_softerror_and_alarm("[IPC] Skipped a message slot on channel %s that was not written by the sender in %d ms (%u skipped so far).",
+      _ruby_ipc_get_channel_name(iChannelType), IPC_SHM_RING_STUCK_SLOT_TIMEOUT_MS, pRing->uStatsSkippedCount);
+   return 1;
+}
+
+// Called by the reader when it opens or closes the ring: drops the pending messages
+// Returns the number of messages dropped
+
+int _ruby_ipc_shm_ring_discard_pending(type_ipc_shm_ring* pRing)
+{
+   int iCount = 0;
+   while ( 1 )
+   {
+      u32 uPos = pRing->uDequeuePos;
+      type_ipc_shm_ring_slot* pSlot = &(pRing->slots[uPos % IPC_SHM_RING_SLOTS]);
+      u32 uSeq = __atomic_load_n(&pSlot->uSequence, __ATOMIC_ACQUIRE);
+      // A previous reader that died after releasing the slot but before moving the read position
+      if ( uSeq == uPos + IPC_SHM_RING_SLOTS )
+      {
+         pRing->uDequeuePos = uPos+1;
+         continue;
+      }
+      if ( uSeq != uPos+1 )
+         break;
+      __atomic_store_n(&pSlot->uSequence, uPos + IPC_SHM_RING_SLOTS, __ATOMIC_RELEASE);
+      pRing->uDequeuePos = uPos+1;
+      iCount++;
+   }
+   pRing->uStuckPos = 0;
+   return iCount;
+}
+
+void _ruby_ipc_shm_ring_open_reader(type_ipc_shm_ring* pRing, int nChannelType)
+{
+   if ( pRing->uReaderSessions > 0 )
+   {
+      int iCount = _ruby_ipc_shm_ring_discard_pending(pRing);
+      log_line("[IPC] Reset shared memory ring for channel %s on reopen (previous reader pid: %u), discarded %d stale messages.",
+         _ruby_ipc_get_channel_name(nChannelType), pRing->uReaderPid, iCount);
+   }
+   pRing->uReaderSessions++;
+   __atomic_store_n(&pRing->uReaderPid, (u32)getpid(), __ATOMIC_RELEASE);
+}
+
+// Returns the message length, 0 if there is no message, -1 for an invalid or skipped message (it's consumed)
+
+int _ruby_ipc_shm_ring_read(type_ipc_shm_ring* pRing, int iChannelType, u8* pOutputBuffer)
+{
+   if ( ! _ruby_ipc_shm_ring_has_message(pRing) )
+   {
+      if ( _ruby_ipc_shm_ring_skip_stuck_slot(pRing, iChannelType) )
+         return -1;
+      return 0;
+   }
+
+   pRing->uStuckPos = 0;
+
+   u32 uPos = pRing->uDequeuePos;
+   type_ipc_shm_ring_slot* pSlot = &(pRing->slots[uPos % IPC_SHM_RING_SLOTS]);
+   int iLength = (int)pSlot->uLength;
+   int iResult = iLength;
+   if ( (iLength <= 0) || (iLength >= IPC_CHANNEL_MAX_MSG_SIZE - 6) )
+   {
+      log_softerror_and_alarm("[IPC] Received invalid message on channel %s, id: %d, length: %d", _ruby_ipc_get_channel_name(iChannelType), pSlot->uMsgId, iLength );
+      iResult = -1;
+   }
+   else
+   {
+      // Check the copy, not the slot, so that what is returned is what was checked
+      memcpy(pOutputBuffer, pSlot->uData, iLength);
+      u32 uCRC = base_compute_crc32(pOutputBuffer, iLength) ^ uPos;
+      if ( uCRC != pSlot->uCRC )
+      {
+         log_softerror_and_alarm("[IPC] Received invalid CRC on channel %s on message id: %d, CRC computed/received: %u / %u, msg length: %d (overwritten by a stalled sender?)", _ruby_ipc_get_channel_name(iChannelType), pSlot->uMsgId, uCRC, pSlot->uCRC, iLength );
+         iResult = -1;
+      }
+   }
+
+   __atomic_store_n(&pSlot->uSequence, uPos + IPC_SHM_RING_SLOTS, __ATOMIC_RELEASE);
+   pRing->uDequeuePos = uPos+1;
+   return iResult;
+}
+
+#endif
+
 char* _ruby_ipc_get_pipe_name(int nChannelType )
 {
    static char s_szRubyPipeName[256];
@@ -164,6 +493,21 @@ void _ruby_ipc_log_channel_info(int iChannelType, int iChannelId, int iChannelFd
 {
    if ( iChannelFd < 0 )
       return;
+
+   #ifdef RUBY_USES_SHM_RINGS
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+   {
+      if ( (s_iRubyIPCChannelsUniqueIds[i] != iChannelId) || (NULL == s_pRubyIPCChannelsRings[i]) )
+         continue;
+      type_ipc_shm_ring* pRing = s_pRubyIPCChannelsRings[i];
+      log_line("[IPC] Channel %s (id: %d, fd: %d) info: %u pending messages, %d slots, ring full %u times",
+         _ruby_ipc_get_channel_name(iChannelType), iChannelId, iChannelFd,
+         __atomic_load_n(&pRing->uEnqueuePos, __ATOMIC_RELAXED) - __atomic_load_n(&pRing->uDequeuePos, __ATOMIC_RELAXED),
+         IPC_SHM_RING_SLOTS, pRing->uStatsFullCount);
+   }
+   #endif
+
+   #ifdef RUBY_USES_MSGQUEUES
    struct msqid_ds msg_stats;
    if ( 0 != msgctl(iChannelFd, IPC_STAT, &msg_stats) )
       log_softerror_and_alarm("[IPC] Failed to get statistics on ICP message queue %s, id %d, fd %d",
@@ -172,6 +516,7 @@ void _ruby_ipc_log_channel_info(int iChannelType, int iChannelId, int iChannelFd
       log_line("[IPC] Channel %s (id: %d, fd: %d) info: %u pending messages, %u used bytes, max bytes in the IPC channel: %u bytes",
          _ruby_ipc_get_channel_name(iChannelType), iChannelId,
          iChannelFd, (u32)msg_stats.msg_qnum, (u32)msg_stats.msg_cbytes, (u32)msg_stats.msg_qbytes);
+   #endif
 }
 
 void _check_ruby_ipc_consistency()
@@ -267,6 +612,25 @@ void ruby_clear_all_ipc_channels()
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+      _ruby_ipc_close_shm_ring(i);
+   s_iRubyIPCChannelsCount = 0;
+
+   int iChannelTypes[] = { IPC_CHANNEL_TYPE_ROUTER_TO_CENTRAL, IPC_CHANNEL_TYPE_CENTRAL_TO_ROUTER,
+      IPC_CHANNEL_TYPE_ROUTER_TO_TELEMETRY, IPC_CHANNEL_TYPE_TELEMETRY_TO_ROUTER,
+      IPC_CHANNEL_TYPE_ROUTER_TO_RC, IPC_CHANNEL_TYPE_RC_TO_ROUTER,
+      IPC_CHANNEL_TYPE_ROUTER_TO_COMMANDS, IPC_CHANNEL_TYPE_COMMANDS_TO_ROUTER };
+   for( int i=0; i<(int)(sizeof(iChannelTypes)/sizeof(iChannelTypes[0])); i++ )
+   {
+      if ( (0 != shm_unlink(_ruby_ipc_get_shm_ring_name(iChannelTypes[i]))) && (errno != ENOENT) )
+         log_softerror_and_alarm("[IPC] Failed to remove shared memory ring [%s], error code: %d, error: %s",
+          _ruby_ipc_get_channel_name(iChannelTypes[i]), errno, strerror(errno));
+   }
+
+   #endif
+
    log_line("[IPC] Done clearing all IPC channels.");
 }
 
@@ -347,6 +711,19 @@ int ruby_open_ipc_channel_write_endpoint(int nChannelType)
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   s_uRubyIPCChannelsKeys[s_iRubyIPCChannelsCount] = 0;
+   s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount] = _ruby_ipc_open_shm_ring(nChannelType, &(s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount]));
+   if ( s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount] < 0 )
+   {
+      log_softerror_and_alarm("[IPC] Failed to create IPC shared memory ring write endpoint for channel %s",
+         _ruby_ipc_get_channel_name(nChannelType));
+      return -1;
+   }
+
+   #endif
+
    s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount] = s_iRubyIPCChannelsUniqueIdCounter;
    s_iRubyIPCChannelsUniqueIdCounter++;
 
@@ -433,6 +810,20 @@ int ruby_open_ipc_channel_read_endpoint(int nChannelType)
    //   log_line("[IPC] IPC channels pools max: %u bytes, max msg size: %u bytes, max msg queue total size: %u bytes", (u32)msg_info.msgpool, (u32)msg_info.msgmax, (u32)msg_info.msgmnb);
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+
+   s_uRubyIPCChannelsKeys[s_iRubyIPCChannelsCount] = 0;
+   s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount] = _ruby_ipc_open_shm_ring(nChannelType, &(s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount]));
+   if ( s_iRubyIPCChannelsFd[s_iRubyIPCChannelsCount] < 0 )
+   {
+      log_softerror_and_alarm("[IPC] Failed to create IPC shared memory ring read endpoint for channel %s",
+         _ruby_ipc_get_channel_name(nChannelType));
+      return -1;
+   }
+   _ruby_ipc_shm_ring_open_reader(s_pRubyIPCChannelsRings[s_iRubyIPCChannelsCount], nChannelType);
+
+   #endif
+
    s_iRubyIPCChannelsUniqueIds[s_iRubyIPCChannelsCount] = s_iRubyIPCChannelsUniqueIdCounter;
    s_iRubyIPCChannelsUniqueIdCounter++;
 
@@ -478,6 +869,19 @@ int ruby_close_ipc_channel(int iChannelUniqueId)
    msgctl(fdToClose,IPC_RMID,NULL);
    #endif
 
+   // The shared memory ring stays in place for the writers; the reader endpoint drops what was not read yet
+   #ifdef RUBY_USES_SHM_RINGS
+   type_ipc_shm_ring* pRingToClose = s_pRubyIPCChannelsRings[iChannelIndex];
+   if ( (NULL != pRingToClose) && (pRingToClose->uReaderPid == (u32)getpid()) )
+   {
+      int iCount = _ruby_ipc_shm_ring_discard_pending(pRingToClose);
+      if ( iCount > 0 )
+         log_line("[IPC] Discarded %d unread messages on closing channel %s read endpoint.", iCount, _ruby_ipc_get_channel_name(s_iRubyIPCChannelsType[iChannelIndex]));
+      __atomic_store_n(&pRingToClose->uReaderPid, 0, __ATOMIC_RELEASE);
+   }
+   _ruby_ipc_close_shm_ring(iChannelIndex);
+   #endif
+
 
    log_line("[IPC] Closed IPC channel %s, channel index %d, unique id %d, fd %d",
        _ruby_ipc_get_channel_name(s_iRubyIPCChannelsType[iChannelIndex]),
@@ -489,6 +893,9 @@ int ruby_close_ipc_channel(int iChannelUniqueId)
       s_iRubyIPCChannelsType[k] = s_iRubyIPCChannelsType[k+1];
       s_iRubyIPCChannelsUniqueIds[k] = s_iRubyIPCChannelsUniqueIds[k+1];
       s_uRubyIPCChannelsMsgId[k] = s_uRubyIPCChannelsMsgId[k+1];
+      #ifdef RUBY_USES_SHM_RINGS
+      s_pRubyIPCChannelsRings[k] = s_pRubyIPCChannelsRings[k+1];
+      #endif
 
    }
    s_iRubyIPCChannelsCount--;
@@ -652,6 +1059,29 @@ int ruby_ipc_channel_send_message(int iChannelUniqueId, u8* pMessage, int iLengt
    } while (iRetryCounter > 0);
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+   type_ipc_shm_ring* pRing = s_pRubyIPCChannelsRings[iFoundIndex];
+   // Give the reader a short time to free up slots if the ring is full
+   for( int iRetry=0; iRetry<3; iRetry++ )
+   {
+      if ( _ruby_ipc_shm_ring_write(pRing, s_uRubyIPCChannelsMsgId[iFoundIndex], pMessage, iLength) )
+      {
+         res = iLength;
+         break;
+      }
+      if ( 0 == iRetry )
+         __atomic_add_fetch(&pRing->uStatsFullCount, 1, __ATOMIC_RELAXED);
+      if ( pRing->uReaderWaiting )
+      {
+         __atomic_add_fetch(&pRing->uWakeCounter, 1, __ATOMIC_SEQ_CST);
+         syscall(SYS_futex, &pRing->uWakeCounter, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+      }
+      hardware_sleep_ms(2);
+   }
+   if ( 0 == res )
+      log_softerror_and_alarm("[IPC] Failed to write to IPC %s, ring is full (%d slots)", _ruby_ipc_get_channel_name(s_iRubyIPCChannelsType[iFoundIndex]), IPC_SHM_RING_SLOTS);
+   #endif
+
    #ifdef PROFILE_IPC
    u32 uTimeTotal = get_current_timestamp_ms() - uTimeStart;
    if ( uTimeTotal > PROFILE_IPC_MAX_TIME )
@@ -811,6 +1241,21 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
 
    #endif
 
+   #ifdef RUBY_USES_SHM_RINGS
+   (void)iChannelFd;
+   if ( NULL != s_pRubyIPCChannelsRings[iFoundIndex] )
+   {
+      // Skip invalid messages, return the first valid one, if any
+      do
+      {
+         lenReadIPCMsgQueue = _ruby_ipc_shm_ring_read(s_pRubyIPCChannelsRings[iFoundIndex], iChannelType, pOutputBuffer);
+      }
+      while ( lenReadIPCMsgQueue < 0 );
+      if ( lenReadIPCMsgQueue > 0 )
+         pReturn = pOutputBuffer;
+   }
+   #endif
+
    #ifdef PROFILE_IPC
    u32 uTimeTotal = get_current_timestamp_ms() - uTimeStart;
    if ( (uTimeTotal > PROFILE_IPC_MAX_TIME + timeoutMicrosec/1000) || uTimeTotal >= 50 )
@@ -831,4 +1276,47 @@ u8* ruby_ipc_try_read_message(int iChannelUniqueId, u8* pTempBuffer, int* pTempB
 int ruby_ipc_get_read_continous_error_count()
 {
    return s_iRubyIPCCountReadErrors;
-}
\ No newline at end of file
+}
+
+// Blocks until there is a message to read on the channel or the timeout expires.
+// Returns 1 if a message is available (or might be, for backends that can't wait: they just sleep for the timeout), 0 on timeout.
+
+int ruby_ipc_wait_for_message(int iChannelUniqueId, u32 uTimeoutMicroSec)
+{
+   #ifdef RUBY_USES_SHM_RINGS
+   type_ipc_shm_ring* pRing = NULL;
+   for( int i=0; i<s_iRubyIPCChannelsCount; i++ )
+   {
+      if ( s_iRubyIPCChannelsUniqueIds[i] == iChannelUniqueId )
+      {
+         pRing = s_pRubyIPCChannelsRings[i];
+         break;
+      }
+   }
+   if ( NULL == pRing )
+   {
+      hardware_sleep_micros(uTimeoutMicroSec);
+      return 0;
+   }
+
+   if ( _ruby_ipc_shm_ring_has_message(pRing) )
+      return 1;
+
+   u32 uWakeCounter = __atomic_load_n(&pRing->uWakeCounter, __ATOMIC_SEQ_CST);
+   __atomic_store_n(&pRing->uReaderWaiting, 1, __ATOMIC_SEQ_CST);
+
+   // Check again after publishing the waiting flag, as a writer might have just added a message
+   if ( ! _ruby_ipc_shm_ring_has_message(pRing) )
+   {
+      struct timespec ts;
+      ts.tv_sec = uTimeoutMicroSec / 1000000;
+      ts.tv_nsec = (uTimeoutMicroSec % 1000000) * 1000;
+      syscall(SYS_futex, &pRing->uWakeCounter, FUTEX_WAIT, uWakeCounter, &ts, NULL, 0);
+   }
+   __atomic_store_n(&pRing->uReaderWaiting, 0, __ATOMIC_SEQ_CST);
+   return _ruby_ipc_shm_ring_has_message(pRing);
+   #else
+   hardware_sleep_micros(uTimeoutMicroSec);
+   return 1;
+   #endif
+}
@@ -33,6 +33,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sched.h>
+#include <sys/stat.h>
 #include "base.h"
 #include "shared_mem.h"
 #include "../radio/radiopackets2.h"
@@ -92,6 +94,130 @@ void* open_shared_mem_for_read(const char* name, int size)
    return open_shared_mem(name, size, 1);
 }
 
+static shared_mem_seqlock_header* _shared_mem_get_seqlock_header(const void* pSegment, int size)
+{
+   return (shared_mem_seqlock_header*)(((u8*)pSegment) + SHARED_MEM_SEQLOCK_OFFSET(size));
+}
+
+void* open_shared_mem_versioned_for_write(const char* name, int size)
+{
+   void* pSegment = open_shared_mem(name, SHARED_MEM_VERSIONED_SIZE(size), 0);
+   if ( NULL == pSegment )
+      return NULL;
+   shared_mem_seqlock_header* pHeader = _shared_mem_get_seqlock_header(pSegment, size);
+   pHeader->uSegmentSize = (u32)size;
+   pHeader->uSequence = 0;
+   __atomic_store_n(&pHeader->uMagic, SHARED_MEM_SEQLOCK_MAGIC, __ATOMIC_RELEASE);
+   return pSegment;
+}
+
+void* open_shared_mem_versioned_for_read(const char* name, int size)
+{
+   // Do not map past the end of a segment created by an older writer (it would fault on access)
+   int fd = shm_open(name, O_RDONLY, S_IRUSR | S_IWUSR);
+   if ( fd < 0 )
+   {
+      log_softerror_and_alarm("[SharedMem] Failed to open shared memory for read: %s, error: %s", name, strerror(errno));
+      return NULL;
+   }
+   struct stat statSegment;
+   int iRes = fstat(fd, &statSegment);
+   close(fd);
+   if ( (0 != iRes) || (statSegment.st_size < (off_t)SHARED_MEM_VERSIONED_SIZE(size)) )
+   {
+      log_softerror_and_alarm("[SharedMem] Shared memory %s is not a versioned segment of the expected size (%d bytes).", name, (int)SHARED_MEM_VERSIONED_SIZE(size));
+      return NULL;
+   }
+
+   void* pSegment = open_shared_mem(name, SHARED_MEM_VERSIONED_SIZE(size), 1);
+   if ( NULL == pSegment )
+      return NULL;
+   shared_mem_seqlock_header* pHeader = _shared_mem_get_seqlock_header(pSegment, size);
+   if ( (SHARED_MEM_SEQLOCK_MAGIC == __atomic_load_n(&pHeader->uMagic, __ATOMIC_ACQUIRE)) && (pHeader->uSegmentSize != (u32)size) )
+   {
+      log_softerror_and_alarm("[SharedMem] Shared memory %s has a different segment size (%u bytes, expected %d bytes).", name, pHeader->uSegmentSize, size);
+      munmap(pSegment, SHARED_MEM_VERSIONED_SIZE(size));
+      return NULL;
+   }
+   return pSegment;
+}
+
+void close_shared_mem_versioned(void* pSegment, int size)
+{
+   if ( NULL != pSegment )
+      munmap(pSegment, SHARED_MEM_VERSIONED_SIZE(size));
+}
+
+void shared_mem_write_begin(void* pSegment, int size)
+{
+   if ( NULL == pSegment )
+      return;
+   shared_mem_seqlock_header* pHeader = _shared_mem_get_seqlock_header(pSegment, size);
+   u32 uSeq = __atomic_load_n(&pHeader->uSequence, __ATOMIC_RELAXED);
+   __atomic_store_n(&pHeader->uSequence, uSeq+1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void shared_mem_write_commit(void* pSegment, int size)
+{
+   if ( NULL == pSegment )
+      return;
+   shared_mem_seqlock_header* pHeader = _shared_mem_get_seqlock_header(pSegment, size);
+   u32 uSeq = __atomic_load_n(&pHeader->uSequence, __ATOMIC_RELAXED);
+   __atomic_store_n(&pHeader->uSequence, uSeq+1, __ATOMIC_RELEASE);
+}
+
+void shared_mem_publish(void* pSegment, const void* pSource, int size)
+{
+   if ( (NULL == pSegment) || (NULL == pSource) )
+      return;
+   shared_mem_write_begin(pSegment, size);
+   memcpy(pSegment, pSource, size);
+   shared_mem_write_commit(pSegment, size);
+}
+
+u32 shared_mem_get_sequence(const void* pSegment, int size)
+{
+   if ( NULL == pSegment )
+      return 0;
+   return __atomic_load_n(&(_shared_mem_get_seqlock_header(pSegment, size)->uSequence), __ATOMIC_ACQUIRE);
+}
+
+// Copies the segment to pOutput if it changed since *pLastSequence (if pLastSequence is not NULL).
+// Retries if the writer updated the segment while copying it.
+// Returns SHARED_MEM_SNAPSHOT_UPDATED, SHARED_MEM_SNAPSHOT_UNCHANGED or SHARED_MEM_SNAPSHOT_FAILED
+// (the writer kept updating the segment; pOutput might contain a partial update).
+
+int shared_mem_try_snapshot(const void* pSegment, int size, void* pOutput, u32* pLastSequence)
+{
+   if ( (NULL == pSegment) || (NULL == pOutput) )
+      return SHARED_MEM_SNAPSHOT_FAILED;
+
+   shared_mem_seqlock_header* pHeader = _shared_mem_get_seqlock_header(pSegment, size);
+   for( int iRetry=0; iRetry<20; iRetry++ )
+   {
+      u32 uSeqStart = __atomic_load_n(&pHeader->uSequence, __ATOMIC_ACQUIRE);
+      if ( uSeqStart & 0x01 )
+      {
+         sched_yield();
+         continue;
+      }
+      if ( (NULL != pLastSequence) && (0 != uSeqStart) && (uSeqStart == *pLastSequence) )
+         return SHARED_MEM_SNAPSHOT_UNCHANGED;
+
+      memcpy(pOutput, pSegment, size);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      u32 uSeqEnd = __atomic_load_n(&pHeader->uSequence, __ATOMIC_RELAXED);
+      if ( uSeqStart == uSeqEnd )
+      {
+         if ( NULL != pLastSequence )
+            *pLastSequence = uSeqStart;
+         return SHARED_MEM_SNAPSHOT_UPDATED;
+      }
+   }
+   return SHARED_MEM_SNAPSHOT_FAILED;
+}
+
 shared_mem_process_stats* shared_mem_process_stats_open_read(const char* szName)
 {
    void *retVal =  open_shared_mem(szName, sizeof(shared_mem_process_stats), 1);
@@ -137,112 +263,106 @@ void process_stats_mark_active(shared_mem_process_stats* pStats, u32 timeNow)
 
 shared_mem_radio_stats* shared_mem_radio_stats_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_RADIO_STATS, sizeof(shared_mem_radio_stats));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_RADIO_STATS, sizeof(shared_mem_radio_stats));
    return (shared_mem_radio_stats*)retVal;
 }
 
 shared_mem_radio_stats* shared_mem_radio_stats_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_RADIO_STATS, sizeof(shared_mem_radio_stats));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_RADIO_STATS, sizeof(shared_mem_radio_stats));
    return (shared_mem_radio_stats*)retVal;
 }
 
 void shared_mem_radio_stats_close(shared_mem_radio_stats* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_radio_stats));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_radio_stats));
    //shm_unlink(szName);
 }
 
 shared_mem_radio_stats_rx_hist* shared_mem_radio_stats_rx_hist_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_RADIO_STATS_RX_HIST, sizeof(shared_mem_radio_stats_rx_hist));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_RADIO_STATS_RX_HIST, sizeof(shared_mem_radio_stats_rx_hist));
    return (shared_mem_radio_stats_rx_hist*)retVal;
 }
 
 shared_mem_radio_stats_rx_hist* shared_mem_radio_stats_rx_hist_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_RADIO_STATS_RX_HIST, sizeof(shared_mem_radio_stats_rx_hist));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_RADIO_STATS_RX_HIST, sizeof(shared_mem_radio_stats_rx_hist));
    return (shared_mem_radio_stats_rx_hist*)retVal;
 }
 
 void shared_mem_radio_stats_rx_hist_close(shared_mem_radio_stats_rx_hist* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_radio_stats_rx_hist));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_radio_stats_rx_hist));
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_VIDEO_FRAMES_STATS , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_VIDEO_FRAMES_STATS, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_VIDEO_FRAMES_STATS , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_VIDEO_FRAMES_STATS, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 void shared_mem_video_frames_stats_close(shared_mem_video_frames_stats* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_in_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_IN , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_IN, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_in_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_IN , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_IN, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 void shared_mem_video_frames_stats_radio_in_close(shared_mem_video_frames_stats* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_out_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_OUT , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_OUT, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 shared_mem_video_frames_stats* shared_mem_video_frames_stats_radio_out_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_OUT , sizeof(shared_mem_video_frames_stats));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_VIDEO_FRAMES_STATS_RADIO_OUT, sizeof(shared_mem_video_frames_stats));
    return (shared_mem_video_frames_stats*)retVal;
 }
 
 void shared_mem_video_frames_stats_radio_out_close(shared_mem_video_frames_stats* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_frames_stats));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_video_frames_stats));
 }
 
 shared_mem_video_link_graphs* shared_mem_video_link_graphs_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_VIDEO_LINK_GRAPHS , sizeof(shared_mem_video_link_graphs));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_VIDEO_LINK_GRAPHS, sizeof(shared_mem_video_link_graphs));
    return (shared_mem_video_link_graphs*)retVal;
 }
 
 shared_mem_video_link_graphs* shared_mem_video_link_graphs_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_VIDEO_LINK_GRAPHS , sizeof(shared_mem_video_link_graphs));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_VIDEO_LINK_GRAPHS, sizeof(shared_mem_video_link_graphs));
    return (shared_mem_video_link_graphs*)retVal;
 }
 
 void shared_mem_video_link_graphs_close(shared_mem_video_link_graphs* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(shared_mem_video_link_graphs));
+   close_shared_mem_versioned(pAddress, sizeof(shared_mem_video_link_graphs));
 }
 
 
@@ -188,6 +188,39 @@ void* open_shared_mem(const char* name, int size, int readOnly);
 void* open_shared_mem_for_write(const char* name, int size);
 void* open_shared_mem_for_read(const char* name, int size);
 
+// Versioned shared memory segments: the segment data is followed by a seqlock header.
+// The single writer publishes a full update using shared_mem_publish (or
+// shared_mem_write_begin/commit around in place changes); readers use shared_mem_try_snapshot
+// to get a consistent copy and to skip the copy if nothing changed since their last snapshot.
+// The segment pointer stays a plain pointer to the segment data.
+
+#define SHARED_MEM_SEQLOCK_MAGIC 0x534C4B31
+#define SHARED_MEM_SEQLOCK_OFFSET(size) ((((u32)(size)) + 7) & (~((u32)7)))
+#define SHARED_MEM_VERSIONED_SIZE(size) (SHARED_MEM_SEQLOCK_OFFSET(size) + sizeof(shared_mem_seqlock_header))
+
+#define SHARED_MEM_SNAPSHOT_FAILED -1
+#define SHARED_MEM_SNAPSHOT_UNCHANGED 0
+#define SHARED_MEM_SNAPSHOT_UPDATED 1
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uSegmentSize;
+   u32 uSequence; // odd while the writer updates the segment
+   u32 uReserved;
+} shared_mem_seqlock_header;
+
+void* open_shared_mem_versioned_for_write(const char* name, int size);
+void* open_shared_mem_versioned_for_read(const char* name, int size);
+void close_shared_mem_versioned(void* pSegment, int size);
+
+void shared_mem_write_begin(void* pSegment, int size);
+void shared_mem_write_commit(void* pSegment, int size);
+void shared_mem_publish(void* pSegment, const void* pSource, int size);
+
+u32 shared_mem_get_sequence(const void* pSegment, int size);
+int shared_mem_try_snapshot(const void* pSegment, int size, void* pOutput, u32* pLastSequence);
+
 shared_mem_process_stats* shared_mem_process_stats_open_read(const char* szName);
 shared_mem_process_stats* shared_mem_process_stats_open_write(const char* szName);
 void shared_mem_process_stats_close(const char* szName, shared_mem_process_stats* pAddress);
@@ -995,78 +995,100 @@ bool radio_utils_set_interface_frequency(Model* pModel, int iRadioIndex, int iAs
                   bTryHT40 = true;
          }
 
-         if ( bTryHT40 )
+         // Use the nl80211 backend first, fall back to the iw/iwconfig commands if it fails
+         bool bNetlinkHT40 = false;
+         #if defined(HW_PLATFORM_RASPBERRY)
+         bNetlinkHT40 = bTryHT40;
+         #endif
+         int iNlResult = hardware_radio_nl80211_set_frequency(pRadioInfo->szName, uFrequencyKhz, bNetlinkHT40?1:0);
+         if ( (-EINVAL == iNlResult) && bNetlinkHT40 )
          {
-            #if defined(HW_PLATFORM_RASPBERRY)
-            if ( pRadioInfo->iRadioType == RADIO_TYPE_ATHEROS )
+            log_softerror_and_alarm("Failed to switch radio interface %d (%s, %s) to frequency %s in HT40 mode. Retry operation.", i+1, pRadioInfo->szName, str_get_radio_driver_description(pRadioInfo->iRadioDriver), str_format_frequency(uFrequencyKhz));
+            hardware_sleep_ms(delayMs);
+            iNlResult = hardware_radio_nl80211_set_frequency(pRadioInfo->szName, uFrequencyKhz, 0);
+         }
+         if ( (-EBUSY == iNlResult) || (-ENODEV == iNlResult) )
+         {
+            hardware_initialize_radio_interface(i, delayMs);
+            hardware_sleep_ms(delayMs);
+            iNlResult = hardware_radio_nl80211_set_frequency(pRadioInfo->szName, uFrequencyKhz, 0);
+         }
+         if ( 0 != iNlResult )
+         {
+            log_softerror_and_alarm("Failed to switch radio interface %d (%s) to frequency %s using netlink (%s). Using iw command.", i+1, pRadioInfo->szName, str_format_frequency(uFrequencyKhz), strerror(-iNlResult));
+            if ( bTryHT40 )
             {
-               sprintf(cmd, "iw dev %s set freq %u HT40+ 2>&1", pRadioInfo->szName, uFreqWifi);
-               bUsedHT40 = true;
+               #if defined(HW_PLATFORM_RASPBERRY)
+               if ( pRadioInfo->iRadioType == RADIO_TYPE_ATHEROS )
+               {
+                  sprintf(cmd, "iw dev %s set freq %u HT40+ 2>&1", pRadioInfo->szName, uFreqWifi);
+                  bUsedHT40 = true;
+               }
+               else
+               {
+                  sprintf(cmd, "iw dev %s set freq %u HT40+ 2>&1", pRadioInfo->szName, uFreqWifi);
+                  bUsedHT40 = true;
+               }
+               #else
+                  sprintf(cmd, "iwconfig %s freq %u000 2>&1", pRadioInfo->szName, uFrequencyKhz);            
+               #endif
             }
-            else
+            else if ( pRadioInfo->isHighCapacityInterface )
             {
-               sprintf(cmd, "iw dev %s set freq %u HT40+ 2>&1", pRadioInfo->szName, uFreqWifi);
-               bUsedHT40 = true;
-            }
-            #else
+               #if defined(HW_PLATFORM_RASPBERRY)
+               sprintf(cmd, "iw dev %s set freq %u 2>&1", pRadioInfo->szName, uFreqWifi);
+               #else
                sprintf(cmd, "iwconfig %s freq %u000 2>&1", pRadioInfo->szName, uFrequencyKhz);            
-            #endif
-         }
-         else if ( pRadioInfo->isHighCapacityInterface )
-         {
-            #if defined(HW_PLATFORM_RASPBERRY)
-            sprintf(cmd, "iw dev %s set freq %u 2>&1", pRadioInfo->szName, uFreqWifi);
-            #else
-            sprintf(cmd, "iwconfig %s freq %u000 2>&1", pRadioInfo->szName, uFrequencyKhz);            
-            #endif
-         }
-         hw_execute_bash_command_raw(cmd, szOutput);
+               #endif
+            }
+            hw_execute_bash_command_raw(cmd, szOutput);
 
-         if ( 5 < strlen(szOutput) )
-            log_softerror_and_alarm("Received a response from set freq command: [%s]", szOutput);
+            if ( 5 < strlen(szOutput) )
+               log_softerror_and_alarm("Received a response from set freq command: [%s]", szOutput);
            
-         if ( NULL != strstr( szOutput, "Invalid argument" ) )
-         if ( bUsedHT40 )
-         if ( pRadioInfo->isHighCapacityInterface )
-         {
-            int len = strlen(szOutput);
-            for( int k=0; k<len; k++ )
+            if ( NULL != strstr( szOutput, "Invalid argument" ) )
+            if ( bUsedHT40 )
+            if ( pRadioInfo->isHighCapacityInterface )
             {
-               if ( szOutput[k] == 10 || szOutput[k] == 13 )
-                  szOutput[k] = '.';
+               int len = strlen(szOutput);
+               for( int k=0; k<len; k++ )
+               {
+                  if ( szOutput[k] == 10 || szOutput[k] == 13 )
+                     szOutput[k] = '.';
+               }
+               log_softerror_and_alarm("Failed to switch radio interface %d (%s, %s) to frequency %s in HT40 mode, returned error: [%s]. Retry operation.", i+1, pRadioInfo->szName, str_get_radio_driver_description(pRadioInfo->iRadioDriver), str_format_frequency(uFrequencyKhz), szOutput);
+               hardware_sleep_ms(delayMs);
+               szOutput[0] = 0;
+               #if defined(HW_PLATFORM_RASPBERRY)
+               sprintf(cmd, "iw dev %s set freq %u 2>&1", pRadioInfo->szName, uFreqWifi);
+               #else
+               sprintf(cmd, "iwconfig %s freq %u000 2>&1", pRadioInfo->szName, uFrequencyKhz);
+               #endif
+               hw_execute_bash_command_raw(cmd, szOutput);
             }
-            log_softerror_and_alarm("Failed to switch radio interface %d (%s, %s) to frequency %s in HT40 mode, returned error: [%s]. Retry operation.", i+1, pRadioInfo->szName, str_get_radio_driver_description(pRadioInfo->iRadioDriver), str_format_frequency(uFrequencyKhz), szOutput);
-            hardware_sleep_ms(delayMs);
-            szOutput[0] = 0;
-            #if defined(HW_PLATFORM_RASPBERRY)
-            sprintf(cmd, "iw dev %s set freq %u 2>&1", pRadioInfo->szName, uFreqWifi);
-            #else
-            sprintf(cmd, "iwconfig %s freq %u000 2>&1", pRadioInfo->szName, uFrequencyKhz);
-            #endif
-            hw_execute_bash_command_raw(cmd, szOutput);
-         }
 
-         if ( (NULL != strstr(szOutput, "busy")) || (NULL != strstr(szOutput, "such device")) )
-         {
-             hardware_initialize_radio_interface(i, delayMs);
-             hardware_sleep_ms(delayMs);
-             hw_execute_bash_command_raw(cmd, szOutput);
-         }
-         if ( NULL != strstr(szOutput, "failed") )
-         {
-            pRadioInfo->lastFrequencySetFailed = 1;
-            pRadioInfo->uFailedFrequencyKhz = uFrequencyKhz;
-            pRadioInfo->uCurrentFrequencyKhz = 0;
-            failed = true;
-            int len = strlen(szOutput);
-            for( int k=0; k<len; k++ )
+            if ( (NULL != strstr(szOutput, "busy")) || (NULL != strstr(szOutput, "such device")) )
             {
-               if ( szOutput[k] == 10 || szOutput[k] == 13 )
-                  szOutput[k] = '.';
+                hardware_initialize_radio_interface(i, delayMs);
+                hardware_sleep_ms(delayMs);
+                hw_execute_bash_command_raw(cmd, szOutput);
+            }
+            if ( NULL != strstr(szOutput, "failed") )
+            {
+               pRadioInfo->lastFrequencySetFailed = 1;
+               pRadioInfo->uFailedFrequencyKhz = uFrequencyKhz;
+               pRadioInfo->uCurrentFrequencyKhz = 0;
+               failed = true;
+               int len = strlen(szOutput);
+               for( int k=0; k<len; k++ )
+               {
+                  if ( szOutput[k] == 10 || szOutput[k] == 13 )
+                     szOutput[k] = '.';
+               }
+               log_softerror_and_alarm("Failed to switch radio interface %d (%s, %s) to frequency %s, returned error: [%s]", i+1, pRadioInfo->szName, str_get_radio_driver_description(pRadioInfo->iRadioDriver), str_format_frequency(uFrequencyKhz), szOutput);
+               hardware_sleep_ms(delayMs);
+               continue;
             }
-            log_softerror_and_alarm("Failed to switch radio interface %d (%s, %s) to frequency %s, returned error: [%s]", i+1, pRadioInfo->szName, str_get_radio_driver_description(pRadioInfo->iRadioDriver), str_format_frequency(uFrequencyKhz), szOutput);
-            hardware_sleep_ms(delayMs);
-            continue;
          }
       }
       
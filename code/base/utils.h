@@ -19,6 +19,7 @@ typedef struct
    u32  uTimeLastSiKReinitCheck;
    u32  uTimeIntervalSiKReinitCheck;
    u32  uSiKInterfaceIndexThatBrokeDown;
+   volatile bool bMustPublishRadioStats; // set by the worker thread; the radio stats shared memory is published only from the main thread
 
    // Helper configure tool info
    bool bConfiguringToolInProgress; // SiK configuring is in progress using the helper tool
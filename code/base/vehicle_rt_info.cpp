@@ -40,13 +40,13 @@
 
 vehicle_runtime_info* vehicle_rt_info_open_for_read()
 {
-   void *retVal = open_shared_mem_for_read(SHARED_MEM_VEHICLE_RUNTIME_INFO, sizeof(vehicle_runtime_info));
+   void *retVal = open_shared_mem_versioned_for_read(SHARED_MEM_VEHICLE_RUNTIME_INFO, sizeof(vehicle_runtime_info));
    return (vehicle_runtime_info*)retVal;
 }
 
 vehicle_runtime_info* vehicle_rt_info_open_for_write()
 {
-   void *retVal = open_shared_mem_for_write(SHARED_MEM_VEHICLE_RUNTIME_INFO, sizeof(vehicle_runtime_info));
+   void *retVal = open_shared_mem_versioned_for_write(SHARED_MEM_VEHICLE_RUNTIME_INFO, sizeof(vehicle_runtime_info));
    vehicle_runtime_info* pRTInfo = (vehicle_runtime_info*)retVal;
    vehicle_rt_info_init(pRTInfo);
    return pRTInfo;
@@ -54,8 +54,7 @@ vehicle_runtime_info* vehicle_rt_info_open_for_write()
 
 void vehicle_rt_info_close(vehicle_runtime_info* pAddress)
 {
-   if ( NULL != pAddress )
-      munmap(pAddress, sizeof(vehicle_runtime_info));
+   close_shared_mem_versioned(pAddress, sizeof(vehicle_runtime_info));
    //shm_unlink(szName);
 }
 
@@ -264,6 +264,7 @@ char* str_get_packet_type(int iPacketType)
       case PACKET_TYPE_VIDEO_DATA:               strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_DATA"); break;
       case PACKET_TYPE_AUDIO_SEGMENT:            strcpy(s_szPacketType, "PACKET_TYPE_AUDIO_SEGMENT"); break;
       case PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS:   strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS"); break;
+      case PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT:   strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT"); break;
       case PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL:     strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL"); break;
       case PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL_ACK: strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL_ACK"); break;
       case PACKET_TYPE_VIDEO_SWITCH_VIDEO_KEYFRAME_TO_VALUE:     strcpy(s_szPacketType, "PACKET_TYPE_VIDEO_SWITCH_VIDEO_KEYFRAME_TO_VALUE"); break;
@@ -374,7 +375,8 @@ char* str_get_packet_history_symbol(int iPacketType, int iRepeatCount)
       s_szOSDRenderRxHistoryPacketSymbol[0] = 'A';
 
    if ( iPacketType == PACKET_TYPE_VIDEO_DATA ||
-        iPacketType == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS )
+        iPacketType == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS ||
+        iPacketType == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT )
      s_szOSDRenderRxHistoryPacketSymbol[0] = 'V';
 
    if ( iPacketType == PACKET_TYPE_AUX_DATA_LINK_UPLOAD ||
@@ -37,6 +37,43 @@ typedef unsigned char u8;
 #define CORE_PLUGIN_VIDEO_STREAM_SOURCE_IP    9
 #define CORE_PLUGIN_VIDEO_STREAM_SOURCE_CUSTOM 20
 
+// Plugin API versions. Plugins that do not export core_plugin_get_api_version are version 1.
+// Version 2 adds optional zero-copy segments rings (see below) for high rate plugins.
+#define CORE_PLUGIN_API_VERSION_1 1
+#define CORE_PLUGIN_API_VERSION_2 2
+
+// A segments ring is a single producer / single consumer circular buffer of data segments, in a single memory block:
+// the ring header, then uSlotsCount slots headers, then uSlotsCount data buffers of uSlotDataSize bytes each.
+// The producer fills the next data buffer in place and then publishes it by increasing uWriteCount;
+// the consumer reads the published data buffers in place and then releases them by increasing uReadCount.
+// Released slots keep their data until the producer reuses them, so they can still be looked up by segment index for retransmissions.
+// Use the helpers in utils/core_plugins_ring.h to access a ring.
+//
+// Tx ring: allocated and filled by the plugin, read directly by Ruby (core_plugin_v2_get_tx_ring).
+// Rx ring: allocated and filled by Ruby, read directly by the plugin (core_plugin_v2_set_rx_ring, core_plugin_v2_on_rx_batch).
+
+#define CORE_PLUGIN_RING_MAGIC 0x47524350 // "PCRG"
+#define CORE_PLUGIN_RING_VERSION 1
+
+typedef struct
+{
+   u32 uSegmentIndex;
+   u32 uLength;
+   u32 uType;
+   u32 uDummy;
+} t_core_plugin_ring_slot;
+
+typedef struct
+{
+   u32 uMagic;
+   u32 uVersion;
+   u32 uSlotsCount; // must be a power of 2
+   u32 uSlotDataSize;
+   volatile u32 uWriteCount; // total slots published by the producer
+   volatile u32 uReadCount; // total slots released by the consumer
+   u32 uDummy[2];
+} t_core_plugin_ring;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -130,6 +167,25 @@ void core_plugin_on_allocated_uart(char* szUARTName);
 void core_plugin_on_stop_using_uart();
 
 
+// Optional API version 2 methods. Ruby uses them instead of the per segment methods above, if the plugin exports them.
+
+// The plugin should return CORE_PLUGIN_API_VERSION_2 if it exports the methods below.
+int core_plugin_get_api_version();
+
+// Called once, after core_plugin_init. The plugin should return it's tx segments ring, already initialized.
+// Ruby reads the pending segments directly from the ring, in batches, with no call into the plugin for each segment.
+// Retransmissions are looked up by segment index in the same ring.
+// Segments indexes must be monotonically increasing (the ring helpers generate them if you pass 0).
+t_core_plugin_ring* core_plugin_v2_get_tx_ring();
+
+// Called once, after core_plugin_init. Ruby gives the plugin the ring where received segments are stored.
+// The ring stays valid until core_plugin_uninit is called.
+void core_plugin_v2_set_rx_ring(t_core_plugin_ring* pRing);
+
+// Called after Ruby stored a batch of received segments in the rx ring.
+// The plugin should read the pending segments from the rx ring and release them (it does not need to do it from this call).
+void core_plugin_v2_on_rx_batch(u32 uFirstSegmentIndex, int iCount);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "core_plugins_ring.h"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static t_core_plugin_ring_slot* _core_plugin_ring_get_slot(t_core_plugin_ring* pRing, u32 uPosition)
+{
+   return ((t_core_plugin_ring_slot*)(((u8*)pRing) + sizeof(t_core_plugin_ring))) + (uPosition & (pRing->uSlotsCount-1));
+}
+
+static u8* _core_plugin_ring_get_data(t_core_plugin_ring* pRing, u32 uPosition)
+{
+   return ((u8*)pRing) + sizeof(t_core_plugin_ring) + pRing->uSlotsCount * sizeof(t_core_plugin_ring_slot) + (uPosition & (pRing->uSlotsCount-1)) * pRing->uSlotDataSize;
+}
+
+// Returns the ring position of the segment or 0 if it's not (or no longer) in the ring. Positions start at 1.
+static u32 _core_plugin_ring_find_position(t_core_plugin_ring* pRing, u32 uSegmentIndex)
+{
+   u32 uWriteCount = __atomic_load_n(&pRing->uWriteCount, __ATOMIC_ACQUIRE);
+   if ( 0 == uWriteCount )
+      return 0;
+
+   // The oldest slot is excluded if it was released, it's the one the producer can overwrite now
+   u32 uRetained = uWriteCount;
+   u32 uMaxRetained = pRing->uSlotsCount - 1;
+   if ( uWriteCount - __atomic_load_n(&pRing->uReadCount, __ATOMIC_ACQUIRE) >= pRing->uSlotsCount )
+      uMaxRetained = pRing->uSlotsCount;
+   if ( uRetained > uMaxRetained )
+      uRetained = uMaxRetained;
+
+   // Segments indexes are usually consecutive, so try the direct position first
+   u32 uLastSegmentIndex = _core_plugin_ring_get_slot(pRing, uWriteCount-1)->uSegmentIndex;
+   u32 uDelta = uLastSegmentIndex - uSegmentIndex;
+   if ( uDelta < uRetained )
+   if ( _core_plugin_ring_get_slot(pRing, uWriteCount-1-uDelta)->uSegmentIndex == uSegmentIndex )
+      return uWriteCount - uDelta;
+
+   for( u32 u=0; u<uRetained; u++ )
+   {
+      if ( _core_plugin_ring_get_slot(pRing, uWriteCount-1-u)->uSegmentIndex == uSegmentIndex )
+         return uWriteCount - u;
+   }
+   return 0;
+}
+
+int core_plugin_ring_get_memory_size(u32 uSlotsCount, u32 uSlotDataSize)
+{
+   return sizeof(t_core_plugin_ring) + uSlotsCount * (sizeof(t_core_plugin_ring_slot) + uSlotDataSize);
+}
+
+t_core_plugin_ring* core_plugin_ring_init(void* pMemory, int iMemorySize, u32 uSlotsCount, u32 uSlotDataSize)
+{
+   if ( (0 == pMemory) || (uSlotsCount < 2) || (0 == uSlotDataSize) )
+      return 0;
+   if ( 0 != (uSlotsCount & (uSlotsCount-1)) )
+      return 0;
+   if ( iMemorySize < core_plugin_ring_get_memory_size(uSlotsCount, uSlotDataSize) )
+      return 0;
+
+   t_core_plugin_ring* pRing = (t_core_plugin_ring*)pMemory;
+   memset(pMemory, 0, sizeof(t_core_plugin_ring) + uSlotsCount * sizeof(t_core_plugin_ring_slot));
+   pRing->uVersion = CORE_PLUGIN_RING_VERSION;
+   pRing->uSlotsCount = uSlotsCount;
+   pRing->uSlotDataSize = uSlotDataSize;
+   pRing->uWriteCount = 0;
+   pRing->uReadCount = 0;
+   __atomic_store_n(&pRing->uMagic, CORE_PLUGIN_RING_MAGIC, __ATOMIC_RELEASE);
+   return pRing;
+}
+
+int core_plugin_ring_is_valid(t_core_plugin_ring* pRing)
+{
+   if ( 0 == pRing )
+      return 0;
+   if ( (__atomic_load_n(&pRing->uMagic, __ATOMIC_ACQUIRE) != CORE_PLUGIN_RING_MAGIC) || (pRing->uVersion != CORE_PLUGIN_RING_VERSION) )
+      return 0;
+   if ( (pRing->uSlotsCount < 2) || (0 != (pRing->uSlotsCount & (pRing->uSlotsCount-1))) || (0 == pRing->uSlotDataSize) )
+      return 0;
+   return 1;
+}
+
+u8* core_plugin_ring_get_write_buffer(t_core_plugin_ring* pRing)
+{
+   if ( core_plugin_ring_get_free_count(pRing) <= 0 )
+      return 0;
+   return _core_plugin_ring_get_data(pRing, pRing->uWriteCount);
+}
+
+u32 core_plugin_ring_commit_write(t_core_plugin_ring* pRing, int iLength, int iType, u32 uSegmentIndex)
+{
+   if ( core_plugin_ring_get_free_count(pRing) <= 0 )
+      return 0;
+   u32 uWriteCount = pRing->uWriteCount;
+   if ( 0 == uSegmentIndex )
+   {
+      uSegmentIndex = 1;
+      if ( uWriteCount > 0 )
+         uSegmentIndex = _core_plugin_ring_get_slot(pRing, uWriteCount-1)->uSegmentIndex + 1;
+   }
+   if ( iLength < 0 )
+      iLength = 0;
+   if ( iLength > (int)pRing->uSlotDataSize )
+      iLength = pRing->uSlotDataSize;
+
+   t_core_plugin_ring_slot* pSlot = _core_plugin_ring_get_slot(pRing, uWriteCount);
+   pSlot->uSegmentIndex = uSegmentIndex;
+   pSlot->uLength = (u32)iLength;
+   pSlot->uType = (u32)iType;
+   __atomic_store_n(&pRing->uWriteCount, uWriteCount+1, __ATOMIC_RELEASE);
+   return uSegmentIndex;
+}
+
+int core_plugin_ring_get_free_count(t_core_plugin_ring* pRing)
+{
+   u32 uReadCount = __atomic_load_n(&pRing->uReadCount, __ATOMIC_ACQUIRE);
+   return (int)(pRing->uSlotsCount - (pRing->uWriteCount - uReadCount));
+}
+
+int core_plugin_ring_get_pending_count(t_core_plugin_ring* pRing)
+{
+   u32 uWriteCount = __atomic_load_n(&pRing->uWriteCount, __ATOMIC_ACQUIRE);
+   return (int)(uWriteCount - pRing->uReadCount);
+}
+
+int core_plugin_ring_peek(t_core_plugin_ring* pRing, int iOffset, u8** ppData, int* piLength, int* piType, u32* puSegmentIndex)
+{
+   if ( (iOffset < 0) || (iOffset >= core_plugin_ring_get_pending_count(pRing)) )
+      return 0;
+   u32 uPosition = pRing->uReadCount + (u32)iOffset;
+   t_core_plugin_ring_slot* pSlot = _core_plugin_ring_get_slot(pRing, uPosition);
+   if ( 0 != ppData )
+      *ppData = _core_plugin_ring_get_data(pRing, uPosition);
+   if ( 0 != piLength )
+      *piLength = (int)pSlot->uLength;
+   if ( 0 != piType )
+      *piType = (int)pSlot->uType;
+   if ( 0 != puSegmentIndex )
+      *puSegmentIndex = pSlot->uSegmentIndex;
+   return 1;
+}
+
+void core_plugin_ring_release(t_core_plugin_ring* pRing, int iCount)
+{
+   int iPending = core_plugin_ring_get_pending_count(pRing);
+   if ( iCount > iPending )
+      iCount = iPending;
+   if ( iCount <= 0 )
+      return;
+   __atomic_store_n(&pRing->uReadCount, pRing->uReadCount + (u32)iCount, __ATOMIC_RELEASE);
+}
+
+int core_plugin_ring_find_segment(t_core_plugin_ring* pRing, u32 uSegmentIndex, u8** ppData, int* piLength, int* piType)
+{
+   u32 uPosition = _core_plugin_ring_find_position(pRing, uSegmentIndex);
+   if ( 0 == uPosition )
+      return 0;
+   t_core_plugin_ring_slot* pSlot = _core_plugin_ring_get_slot(pRing, uPosition-1);
+   if ( 0 != ppData )
+      *ppData = _core_plugin_ring_get_data(pRing, uPosition-1);
+   if ( 0 != piLength )
+      *piLength = (int)pSlot->uLength;
+   if ( 0 != piType )
+      *piType = (int)pSlot->uType;
+   return 1;
+}
+
+int core_plugin_ring_is_segment_present(t_core_plugin_ring* pRing, u32 uSegmentIndex)
+{
+   return (0 != _core_plugin_ring_find_position(pRing, uSegmentIndex))?1:0;
+}
+
+#ifdef __cplusplus
+}
+#endif
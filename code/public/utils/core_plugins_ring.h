@@ -0,0 +1,38 @@
+#pragma once
+#include "../ruby_core_plugin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Helpers for core plugins segments rings (plugin API version 2).
+// One thread produces and one thread consumes a ring; no locks are used.
+
+// Returns the memory size required for a ring
+int core_plugin_ring_get_memory_size(u32 uSlotsCount, u32 uSlotDataSize);
+// Initializes a ring in the provided memory block. Returns the ring or 0 on invalid parameters.
+t_core_plugin_ring* core_plugin_ring_init(void* pMemory, int iMemorySize, u32 uSlotsCount, u32 uSlotDataSize);
+int core_plugin_ring_is_valid(t_core_plugin_ring* pRing);
+
+// Producer side
+// Returns the data buffer of the next free slot (uSlotDataSize bytes), or 0 if the ring is full
+u8* core_plugin_ring_get_write_buffer(t_core_plugin_ring* pRing);
+// Publishes the slot returned by core_plugin_ring_get_write_buffer. Returns the segment index of the published slot.
+// If uSegmentIndex is 0, a new one is generated (the previous one + 1)
+u32 core_plugin_ring_commit_write(t_core_plugin_ring* pRing, int iLength, int iType, u32 uSegmentIndex);
+int core_plugin_ring_get_free_count(t_core_plugin_ring* pRing);
+
+// Consumer side
+int core_plugin_ring_get_pending_count(t_core_plugin_ring* pRing);
+// Gets the iOffset-th pending segment, in place. Returns 1 if it exists.
+int core_plugin_ring_peek(t_core_plugin_ring* pRing, int iOffset, u8** ppData, int* piLength, int* piType, u32* puSegmentIndex);
+void core_plugin_ring_release(t_core_plugin_ring* pRing, int iCount);
+
+// Finds a segment (pending or already released, but not yet reused) by segment index. Returns 1 if found.
+// The data can be overwritten by the producer after it was released, so copy it and then check it with core_plugin_ring_is_segment_present.
+int core_plugin_ring_find_segment(t_core_plugin_ring* pRing, u32 uSegmentIndex, u8** ppData, int* piLength, int* piType);
+int core_plugin_ring_is_segment_present(t_core_plugin_ring* pRing, u32 uSegmentIndex);
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,6 +33,7 @@
 #include <pthread.h>
 //#include "../base/radio_utils.h"
 #include "../base/ctrl_settings.h"
+#include "../base/models_binary.h"
 #include "../common/models_connect_frequencies.h"
 #include "../common/string_utils.h"
 #include "../utils/utils_controller.h"
@@ -93,6 +94,7 @@ static u8 s_CommandReplyBuffer[MAX_PACKET_TOTAL_SIZE];
 static int s_CommandReplyLength = 0;
 
 static int s_iCountRetriesToGetModelSettingsCommand = 0;
+static bool s_bRequestFullBinaryModelSettings = false;
 static int s_RetryGetCorePluginsCounter = 0;
 
 
@@ -126,6 +128,52 @@ void update_processes_priorities()
    hw_set_proc_priority("ruby_central", pCS->iNiceCentral, 0, 1 );
 }
 
+// Rebuilds the full vehicle model from a binary model settings buffer (full or delta against the
+// controller's copy of the model) and writes it to the temporary received model file.
+static bool _handle_commands_write_binary_model_settings(int iIndexRuntime, u8* pData, int iLength, const char* szFile)
+{
+   Model modelTemp;
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   int iBufferLength = 0;
+
+   if ( model_binary_is_delta(pData, iLength) )
+   {
+      Model* pBaseModel = g_VehiclesRuntimeInfo[iIndexRuntime].pModel;
+      if ( NULL == pBaseModel )
+      {
+         log_softerror_and_alarm("[Commands] Received binary model settings delta, but there is no model for runtime index %d.", iIndexRuntime);
+         return false;
+      }
+      iBufferLength = pBaseModel->saveToBinaryBuffer(uBuffer, sizeof(uBuffer), true, NULL);
+      if ( (iBufferLength <= 0) || (! modelTemp.loadFromBinaryBuffer(uBuffer, iBufferLength)) )
+      {
+         log_softerror_and_alarm("[Commands] Failed to copy the controller's model to apply the received binary model settings delta.");
+         return false;
+      }
+   }
+
+   if ( ! modelTemp.loadFromBinaryBuffer(pData, iLength) )
+   {
+      log_softerror_and_alarm("[Commands] Failed to load the received binary model settings (%d bytes, %s).", iLength, model_binary_is_delta(pData, iLength)?"delta":"full");
+      return false;
+   }
+
+   iBufferLength = modelTemp.saveToBinaryBuffer(uBuffer, sizeof(uBuffer), true, NULL);
+   if ( iBufferLength <= 0 )
+      return false;
+
+   FILE* fd = fopen(szFile, "wb");
+   if ( NULL == fd )
+   {
+      log_softerror_and_alarm("Failed to write received model settings to temporary model file [%s].", szFile);
+      return false;
+   }
+   fwrite(uBuffer, 1, iBufferLength, fd);
+   fclose(fd);
+   log_line("[Commands] Received binary model settings (%d bytes, %s), full model: %d bytes.", iLength, model_binary_is_delta(pData, iLength)?"delta":"full", iBufferLength);
+   return true;
+}
+
 int handle_commands_on_full_model_settings_received(u32 uVehicleId, int iResponseParam, u8* pData, int iLength)
 {
    if ( (NULL == pData) || (iLength <= 0) )
@@ -181,33 +229,55 @@ int handle_commands_on_full_model_settings_received(u32 uVehicleId, int iRespons
    char szComm[256];
    sprintf(szComm, "rm -rf %s/model.mdl", FOLDER_RUBY_TEMP);
    hw_execute_bash_command(szComm, NULL);
-   char szRecvFile[MAX_FILE_PATH_SIZE];
-   sprintf(szRecvFile, "%s/last_recv_model.tar", FOLDER_RUBY_TEMP);
-   if ( iResponseParam != 0 )
-      sprintf(szRecvFile, "%s/last_recv_model.tar.gz", FOLDER_RUBY_TEMP);
-
-   FILE* fd = fopen(szRecvFile, "wb");
-   if ( NULL == fd )
-   {
-      log_softerror_and_alarm("Failed to write received model settings to temporary model file [%s].", szRecvFile);
-      return -1;
-   }
+   FILE* fd = NULL;
 
-   fwrite(pData, 1, iLength, fd);
-   fclose(fd);
-   fd = NULL;
-
-   if ( 0 == iResponseParam )
+   if ( (iResponseParam == MODEL_BINARY_COMMAND_RESPONSE_PARAM) || model_binary_is_valid(pData, iLength) )
    {
-      sprintf(szComm, "tar -C %s -zxf %s/last_recv_model.tar 2>&1", FOLDER_RUBY_TEMP, FOLDER_RUBY_TEMP);
-      hw_execute_bash_command(szComm, NULL);
+      iResponseParam = MODEL_BINARY_COMMAND_RESPONSE_PARAM;
+      char szBinaryFile[MAX_FILE_PATH_SIZE];
+      sprintf(szBinaryFile, "%s/model.mdl", FOLDER_RUBY_TEMP);
+      if ( ! _handle_commands_write_binary_model_settings(iIndexRuntime, pData, iLength, szBinaryFile) )
+      {
+         // Next request gets the full model, without a delta
+         s_bRequestFullBinaryModelSettings = true;
+         if ( NULL != g_VehiclesRuntimeInfo[iIndexRuntime].pModel )
+            g_VehiclesRuntimeInfo[iIndexRuntime].pModel->b_mustSyncFromVehicle = true;
+         s_CommandType = 0;
+         s_bHasCommandInProgress = false;
+         return -1;
+      }
+      s_bRequestFullBinaryModelSettings = false;
    }
    else
    {
-      sprintf(szComm, "gzip -df %s/last_recv_model.tar.gz 2>&1", FOLDER_RUBY_TEMP);
-      hw_execute_bash_command(szComm, NULL);
-      sprintf(szComm, "tar -C %s -xf %s/last_recv_model.tar 2>&1", FOLDER_RUBY_TEMP, FOLDER_RUBY_TEMP);
-      hw_execute_bash_command(szComm, NULL);    
+      char szRecvFile[MAX_FILE_PATH_SIZE];
+      sprintf(szRecvFile, "%s/last_recv_model.tar", FOLDER_RUBY_TEMP);
+      if ( iResponseParam != 0 )
+         sprintf(szRecvFile, "%s/last_recv_model.tar.gz", FOLDER_RUBY_TEMP);
+
+      fd = fopen(szRecvFile, "wb");
+      if ( NULL == fd )
+      {
+         log_softerror_and_alarm("Failed to write received model settings to temporary model file [%s].", szRecvFile);
+         return -1;
+      }
+
+      fwrite(pData, 1, iLength, fd);
+      fclose(fd);
+      fd = NULL;
+
+      if ( 0 == iResponseParam )
+      {
+         sprintf(szComm, "tar -C %s -zxf %s/last_recv_model.tar 2>&1", FOLDER_RUBY_TEMP, FOLDER_RUBY_TEMP);
+         hw_execute_bash_command(szComm, NULL);
+      }
+      else
+      {
+         sprintf(szComm, "gzip -df %s/last_recv_model.tar.gz 2>&1", FOLDER_RUBY_TEMP);
+         hw_execute_bash_command(szComm, NULL);
+         sprintf(szComm, "tar -C %s -xf %s/last_recv_model.tar 2>&1", FOLDER_RUBY_TEMP, FOLDER_RUBY_TEMP);
+         hw_execute_bash_command(szComm, NULL);    
+      }
    }
 
    char szFile[MAX_FILE_PATH_SIZE];
@@ -330,8 +400,8 @@ int handle_commands_on_full_model_settings_received(u32 uVehicleId, int iRespons
       return -1;
    }
    
-   u8 uBuffer[5048];
-   int length = fread(uBuffer, 1, 5000, fd);
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   int length = fread(uBuffer, 1, sizeof(uBuffer), fd);
    fclose(fd);
    
    onEventReceivedModelSettings(modelTemp.uVehicleId, uBuffer, length, false);
@@ -356,8 +426,8 @@ void _handle_received_command_response_to_get_all_params_zip(u8* pPacket, int iL
    u8* pDataBuffer = pPacket + sizeof(t_packet_header) + sizeof(t_packet_header_command_response);
    int iDataLength = pPH->total_length - sizeof(t_packet_header) - sizeof(t_packet_header_command_response);
    
-   // Did we a full, complete, single zip response?
-   if ( iDataLength > 500 )
+   // Did we a full, complete, single zip or binary response?
+   if ( (iDataLength > 500) || ((pPHCR->command_response_param == MODEL_BINARY_COMMAND_RESPONSE_PARAM) && model_binary_is_valid(pDataBuffer, iDataLength)) )
    {
       log_line("[Commands] Received model settings response (from VID %u) as full single compressed file. Model file size (compressed): %d, command response param: %d", pPH->vehicle_id_src, iDataLength, pPHCR->command_response_param);
       handle_commands_on_full_model_settings_received(pPH->vehicle_id_src, pPHCR->command_response_param, pDataBuffer, iDataLength);
@@ -2034,7 +2104,14 @@ bool _commands_check_send_get_settings()
 
       log_line("[Commands] Send request to router to request model settings from vehicle.");
       reset_model_settings_download_buffers(g_pCurrentModel->uVehicleId);
-      return handle_commands_send_to_vehicle(COMMAND_ID_GET_ALL_PARAMS_ZIP, flags, NULL, 0);
+
+      // Newer vehicles send the model in binary format, as a delta against our copy, if we send our sections CRCs
+      flags |= MODEL_BINARY_GET_PARAMS_FLAG;
+      if ( s_bRequestFullBinaryModelSettings || g_bIsFirstConnectionToCurrentVehicle )
+         return handle_commands_send_to_vehicle(COMMAND_ID_GET_ALL_PARAMS_ZIP, flags, NULL, 0);
+      u32 uSectionsCRCs[MODEL_BINARY_MAX_SECTIONS];
+      g_pCurrentModel->getBinarySectionsCRCs(uSectionsCRCs);
+      return handle_commands_send_to_vehicle(COMMAND_ID_GET_ALL_PARAMS_ZIP, flags, (u8*)uSectionsCRCs, sizeof(uSectionsCRCs));
    }
 
    if ( (NULL != g_pCurrentModel) && (g_pCurrentModel->b_mustSyncFromVehicle || g_bIsFirstConnectionToCurrentVehicle ) && (!g_pCurrentModel->is_spectator))
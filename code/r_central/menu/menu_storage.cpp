@@ -697,10 +697,13 @@ bool MenuStorage::moveVideos(bool bDelete)
       }
 
       strcpy(szOutFile, szSrcFile);
-      szOutFile[strlen(szOutFile)-4] = 'm';
-      szOutFile[strlen(szOutFile)-3] = 'p';
-      szOutFile[strlen(szOutFile)-2] = '4';
-      szOutFile[strlen(szOutFile)-1] = 0;
+      if ( NULL == strstr(szOutFile, ".mp4") )
+      {
+         szOutFile[strlen(szOutFile)-4] = 'm';
+         szOutFile[strlen(szOutFile)-3] = 'p';
+         szOutFile[strlen(szOutFile)-2] = '4';
+         szOutFile[strlen(szOutFile)-1] = 0;
+      }
       snprintf(szCommand, sizeof(szCommand)/sizeof(szCommand[0]), "rm -rf %sRuby/%s", FOLDER_USB_MOUNT, szOutFile);
       hw_execute_bash_command(szCommand, NULL);
       snprintf(szCommand, sizeof(szCommand)/sizeof(szCommand[0]), "rm -rf %s%s", FOLDER_RUBY_TEMP, szOutFile);
@@ -785,6 +788,11 @@ bool MenuStorage::moveVideos(bool bDelete)
          szCommand[strlen(szCommand)-2] = '6';
          szCommand[strlen(szCommand)-1] = '*';
          hw_execute_bash_command(szCommand, NULL);
+         szCommand[strlen(szCommand)-4] = 'm';
+         szCommand[strlen(szCommand)-3] = 'p';
+         szCommand[strlen(szCommand)-2] = '4';
+         szCommand[strlen(szCommand)-1] = 0;
+         hw_execute_bash_command(szCommand, NULL);
       }
    }
 
@@ -887,6 +895,8 @@ void MenuStorage::stopVideoPlay()
    char szComm[256];
    snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "rm -rf %s", CONFIG_FILE_FULLPATH_PAUSE_VIDEO_PLAYER);
    hw_execute_bash_command(szComm, NULL);
+   snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "rm -rf %s%s %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_PLAYBACK_H264_FILE, FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_PLAYBACK_H265_FILE);
+   hw_execute_bash_command(szComm, NULL);
       
    //if ( m_bWasPairingStarted )
    //   pairing_start_normal();
@@ -1052,6 +1062,29 @@ void MenuStorage::playVideoFile(int iMenuItemIndex)
    }
    fclose(fd);
 
+   char szPlayFile[MAX_FILE_PATH_SIZE];
+   snprintf(szPlayFile, sizeof(szPlayFile)/sizeof(szPlayFile[0]), "%s%s", FOLDER_MEDIA, szFile);
+
+   // The local video players play raw video streams. Extract it from mp4 recordings.
+   if ( NULL != strstr(szFile, ".mp4") )
+   {
+      snprintf(szPlayFile, sizeof(szPlayFile)/sizeof(szPlayFile[0]), "%s%s", FOLDER_RUBY_TEMP, (m_VideoFilesType[index] == VIDEO_TYPE_H265)?FILE_TEMP_VIDEO_PLAYBACK_H265_FILE:FILE_TEMP_VIDEO_PLAYBACK_H264_FILE);
+      snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "./ruby_video_proc -es %s%s %s &", FOLDER_MEDIA, szFile, szPlayFile);
+      hw_execute_bash_command(szBuff, NULL);
+      u32 uTimeStart = get_current_timestamp_ms();
+      while ( ! g_bQuit )
+      {
+         hardware_sleep_ms(100);
+         g_TimeNow = get_current_timestamp_ms();
+         ruby_signal_alive();
+         ruby_processing_loop(true);
+         render_all(g_TimeNow);
+         if ( (g_TimeNow > uTimeStart + 500) && (! hw_process_exists("ruby_video_proc")) )
+            break;
+      }
+      log_line("Extracted video stream from %s in %u ms", szFile, get_current_timestamp_ms() - uTimeStart);
+   }
+
    /*
    if ( pairing_isStarted() )
    {
@@ -1072,11 +1105,11 @@ void MenuStorage::playVideoFile(int iMenuItemIndex)
       hardware_sleep_ms(200);
    }  
    #ifdef HW_PLATFORM_RASPBERRY
-   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "./%s %s%s %d&", VIDEO_PLAYER_OFFLINE, FOLDER_MEDIA, szFile, m_VideoFilesFPS[index]);
+   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "./%s %s %d&", VIDEO_PLAYER_OFFLINE, szPlayFile, m_VideoFilesFPS[index]);
    #endif
 
    #ifdef HW_PLATFORM_RADXA_ZERO3
-   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "./%s -f %s%s %d&", VIDEO_PLAYER_OFFLINE, FOLDER_MEDIA, szFile, m_VideoFilesFPS[index]);
+   snprintf(szBuff, sizeof(szBuff)/sizeof(szBuff[0]), "./%s -f %s %d&", VIDEO_PLAYER_OFFLINE, szPlayFile, m_VideoFilesFPS[index]);
    #endif
    hw_execute_bash_command_nonblock(szBuff, NULL);
    hardware_sleep_ms(100);
@@ -1084,6 +1117,6 @@ void MenuStorage::playVideoFile(int iMenuItemIndex)
    g_uVideoPlayingTimeMs = 0;
    g_uVideoPlayingLengthSec = m_VideoFilesDuration[index];
    m_uTimestampLastLoopMs = g_TimeNow;
-   log_line("Started video playback of file: (%s%s)", FOLDER_MEDIA, szFile);
+   log_line("Started video playback of file: (%s)", szPlayFile);
 
 }
@@ -323,7 +323,7 @@ void MenuVehicleManagement::onSelectItem()
       str_sanitize_filename(szModelName);
 
       snprintf(szFile, sizeof(szFile)/sizeof(szFile[0]), "%s/ruby_model_%s_%u.txt", FOLDER_USB_MOUNT, szModelName, g_pCurrentModel->uVehicleId);
-      g_pCurrentModel->saveToFile(szFile, false);
+      g_pCurrentModel->exportToTextFile(szFile, false);
    
       hardware_unmount_usb();
       ruby_signal_alive();
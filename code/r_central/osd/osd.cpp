@@ -2667,7 +2667,9 @@ void osd_render_all()
       Model* pModel = osd_get_current_data_source_vehicle_model();
       if ( (NULL == pModel) || (0 == g_uActiveControllerModelVID) )
          return;
-      osd_render_instruments();
+      if ( g_pRenderEngine->beginRegion(OSD_RENDER_REGION_MAIN, 0, 0, 1.0, 1.0, 0) )
+         osd_render_instruments();
+      g_pRenderEngine->endRegion();
       osd_widgets_render(pModel->uVehicleId, osd_get_current_layout_index());
       osd_plugins_render();
       return;
@@ -2688,16 +2690,19 @@ void osd_render_all()
    
    s_RenderCount++;
 
+   // The OSD elements can change on any frame, so they are always drawn and compared to the last frame
+   g_pRenderEngine->beginRegion(OSD_RENDER_REGION_MAIN, 0, 0, 1.0, 1.0, 0);
+
    if ( pModel->osd_params.osd_flags2[osd_get_current_layout_index()] & OSD_FLAG2_LAYOUT_ENABLED )
    if ( (NULL != p) && (p->iShowProcessesMonitor) )
       osd_show_monitor();
 
 
    if ( pModel->is_spectator && (!(pModel->telemetry_params.flags & TELEMETRY_FLAGS_SPECTATOR_ENABLE)) )
+   {
+      g_pRenderEngine->endRegion();
       return;
-
-   if ( !pairing_isStarted() )
-      return;
+   }
 
    float fAlfaOrg = g_pRenderEngine->getGlobalAlfa();
    
@@ -2759,15 +2764,20 @@ void osd_render_all()
    osd_set_colors();
 
    if ( ! g_bDebugStats )
-   {
-      if ( pModel->osd_params.osd_flags2[osd_get_current_layout_index()] & OSD_FLAG2_LAYOUT_ENABLED )
-         osd_render_instruments();
+   if ( pModel->osd_params.osd_flags2[osd_get_current_layout_index()] & OSD_FLAG2_LAYOUT_ENABLED )
+      osd_render_instruments();
+
+   g_pRenderEngine->endRegion();
 
+   if ( ! g_bDebugStats )
+   {
       osd_widgets_render(pModel->uVehicleId, osd_get_current_layout_index());
       osd_plugins_render();
    }
    g_pRenderEngine->drawBackgroundBoundingBoxes(false);
 
+   g_pRenderEngine->beginRegion(OSD_RENDER_REGION_STATS, 0, 0, 1.0, 1.0, 0);
+
    if ( ! g_bDebugStats )
    {
       if ( pModel->osd_params.osd_flags2[osd_get_current_layout_index()] & OSD_FLAG2_LAYOUT_ENABLED )
@@ -2793,6 +2803,8 @@ void osd_render_all()
          osd_render_relay( 0.5, 1.0 - osd_getMarginY() - osd_getBarHeight() - osd_getSecondBarHeight() - osd_getSpacingV(), true);
    }
 
+   g_pRenderEngine->endRegion();
+
    g_pRenderEngine->drawBackgroundBoundingBoxes(false);
    g_pRenderEngine->setGlobalAlfa(fAlfaOrg);
 }
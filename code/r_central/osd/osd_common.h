@@ -10,6 +10,12 @@
 #define OSD_QUALITY_LEVEL_WARNING 50
 #define OSD_QUALITY_LEVEL_CRITICAL 30
 
+// Render regions ids (for damage tracking)
+#define OSD_RENDER_REGION_BACKGROUND 0x0001
+#define OSD_RENDER_REGION_MAIN 0x0100
+#define OSD_RENDER_REGION_STATS 0x0101
+#define OSD_RENDER_REGION_FIRST_WIDGET 0x0200
+
 extern u32 g_idIconRuby;
 extern u32 g_idIconDrone;
 extern u32 g_idIconPlane;
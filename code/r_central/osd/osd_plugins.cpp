@@ -574,6 +574,30 @@ void osd_plugins_render()
    }
 }
 
+// Plugins are third party code that can draw outside of their area or without blending,
+// so frames that render them are not composed from cached render regions.
+bool osd_plugins_are_rendered()
+{
+   if ( g_bToglleAllOSDOff || g_bToglleOSDOff )
+      return false;
+
+   Model* pModel = osd_get_current_data_source_vehicle_model();
+   if ( NULL == pModel )
+      return false;
+   if ( pModel->is_spectator && (!(pModel->telemetry_params.flags & TELEMETRY_FLAGS_SPECTATOR_ENABLE)) )
+      return false;
+
+   for( int i=0; i<g_iPluginsOSDCount; i++ )
+   {
+      if ( NULL == g_pPluginsOSD[i] )
+         continue;
+      SinglePluginSettings* pPlugin = osd_get_settings_for_plugin_for_model(osd_plugins_get_uid(i), pModel);
+      if ( (NULL != pPlugin) && (0 != pPlugin->nEnabled) )
+         return true;
+   }
+   return false;
+}
+
 int osd_plugins_get_count()
 {
    return g_iPluginsOSDCount;
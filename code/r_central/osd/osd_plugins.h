@@ -42,6 +42,7 @@ extern bool g_bOSDPluginsNeedTelemetryStreams;
 
 void osd_plugins_load();
 void osd_plugins_render();
+bool osd_plugins_are_rendered();
 
 int osd_plugins_get_count();
 plugin_osd_t* osd_plugins_get(int index);
@@ -257,6 +257,29 @@ bool osd_widgets_save()
    return true;
 }
 
+// Widgets draw from their display settings, the OSD colors and the vehicle telemetry
+u32 _osd_widget_get_content_hash(int iIndex, type_osd_widget_display_info* pDisplayInfo, u32 uVehicleId, int iOSDScreen)
+{
+   u32 uHash = render_engine_hash(0, &(s_ListOSDWidgets[iIndex].info.uGUID), sizeof(u32));
+   uHash = render_engine_hash(uHash, pDisplayInfo, sizeof(type_osd_widget_display_info));
+   uHash = render_engine_hash(uHash, get_Color_OSDText(), 4*sizeof(double));
+   uHash = render_engine_hash(uHash, get_Color_OSDTextOutline(), 4*sizeof(double));
+   uHash = render_engine_hash(uHash, get_Color_OSDBackground(), 4*sizeof(double));
+   float fValues[2];
+   fValues[0] = osd_getScaleOSD();
+   fValues[1] = g_pRenderEngine->getGlobalAlfa();
+   uHash = render_engine_hash(uHash, fValues, sizeof(fValues));
+   if ( (NULL != g_pCurrentModel) && (iOSDScreen >= 0) && (iOSDScreen < MODEL_MAX_OSD_PROFILES) )
+      uHash = render_engine_hash(uHash, &(g_pCurrentModel->osd_params.osd_preferences[iOSDScreen]), sizeof(u32));
+   t_structure_vehicle_info* pVInfo = get_vehicle_runtime_info_for_vehicle_id(uVehicleId);
+   if ( NULL != pVInfo )
+   {
+      uHash = render_engine_hash(uHash, &(pVInfo->bGotFCTelemetry), sizeof(bool));
+      uHash = render_engine_hash(uHash, &(pVInfo->headerFCTelemetry), sizeof(pVInfo->headerFCTelemetry));
+   }
+   return uHash;
+}
+
 void _osd_render_widget(int iIndex, int iModelIndex, u32 uModelId, int iOSDScreen)
 {
    if ( (iIndex < 0) || (iIndex >= s_iListOSDWidgetsCount) )
@@ -373,7 +396,10 @@ void osd_widgets_render(u32 uCurrentVehicleId, int iOSDScreen)
          if ( s_ListOSDWidgets[iWidget].display_info[iModel][iOSDScreen].uVehicleId == uCurrentVehicleId )
          if ( s_ListOSDWidgets[iWidget].display_info[iModel][iOSDScreen].bShow )
          {
-            _osd_render_widget(iWidget, iModel, uCurrentVehicleId, iOSDScreen);
+            type_osd_widget_display_info* pDisplayInfo = &(s_ListOSDWidgets[iWidget].display_info[iModel][iOSDScreen]);
+            if ( g_pRenderEngine->beginRegion(OSD_RENDER_REGION_FIRST_WIDGET + iWidget, pDisplayInfo->fXPos, pDisplayInfo->fYPos, pDisplayInfo->fWidth, pDisplayInfo->fHeight, _osd_widget_get_content_hash(iWidget, pDisplayInfo, uCurrentVehicleId, iOSDScreen)) )
+               _osd_render_widget(iWidget, iModel, uCurrentVehicleId, iOSDScreen);
+            g_pRenderEngine->endRegion();
          }
       }
    }
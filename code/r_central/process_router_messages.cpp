@@ -35,6 +35,7 @@
 #include "../base/ruby_ipc.h"
 #include "../base/ctrl_interfaces.h"
 #include "../base/ctrl_preferences.h"
+#include "../base/models_binary.h"
 #include "../common/string_utils.h"
 #include "menu/menu.h"
 #include "menu/menu_objects.h"
@@ -449,7 +450,9 @@ void _process_received_model_settings(u8* pPacketBuffer)
       else
          log_line("Received legacy model settings from router in a single packet with full zip model settings from vehicle %u (%d bytes).", pPH->vehicle_id_src, iDataSize);
       int iResponseParam = 0;
-      if ( uStartFlag != MAX_U32 )
+      if ( uStartFlag == MODEL_BINARY_SETTINGS_START_FLAG )
+         iResponseParam = MODEL_BINARY_COMMAND_RESPONSE_PARAM;
+      else if ( uStartFlag != MAX_U32 )
          iResponseParam = 1;
       handle_commands_on_full_model_settings_received(pPH->vehicle_id_src, iResponseParam, pData, iDataSize);
       return;
@@ -498,7 +501,7 @@ void _process_received_model_settings(u8* pPacketBuffer)
          if ( bHasAll )
          {
             log_line("Got all model settings segments. Total size: %d bytes", iTotalSize);
-            handle_commands_on_full_model_settings_received(pPH->vehicle_id_src, 0, bufferAll, iTotalSize);
+            handle_commands_on_full_model_settings_received(pPH->vehicle_id_src, (uStartFlag == MODEL_BINARY_SETTINGS_START_FLAG)?MODEL_BINARY_COMMAND_RESPONSE_PARAM:0, bufferAll, iTotalSize);
          }
       }
       return;
@@ -814,7 +817,7 @@ int _process_received_message_from_router(u8* pPacketBuffer)
       g_bSwitchingRadioLink = false;
 
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)&g_SM_RadioStats, (u8*)g_pSM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_try_snapshot(g_pSM_RadioStats, sizeof(shared_mem_radio_stats), &g_SM_RadioStats, NULL);
 
       log_line("Received response from router to switch to vehicle radio link %d: succeeded: %d", iLink+1, iSucceeded);
       warnings_remove_switching_radio_link(iLink, uFreqKhz, (bool) iSucceeded);
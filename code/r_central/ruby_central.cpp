@@ -478,6 +478,28 @@ void _render_background_and_paddings(bool bForceBackground)
    if ( NULL != g_pPopupLooking )
       bForceBackground = true;
 
+   // Over the video only the paddings are drawn, and they change only with the video or screen size
+   u32 uContentHash = 0;
+   if ( ! (showBg || bForceBackground || (! link_has_received_videostream(0))) )
+   {
+      int iSizes[4];
+      iSizes[0] = g_pRenderEngine->getScreenWidth();
+      iSizes[1] = g_pRenderEngine->getScreenHeight();
+      iSizes[2] = iSizes[3] = 0;
+      if ( NULL != g_pCurrentModel )
+      {
+         iSizes[2] = g_pCurrentModel->video_link_profiles[g_pCurrentModel->video_params.user_selected_video_link_profile].width;
+         iSizes[3] = g_pCurrentModel->video_link_profiles[g_pCurrentModel->video_params.user_selected_video_link_profile].height;
+      }
+      uContentHash = render_engine_hash(0, iSizes, sizeof(iSizes));
+      bool bFlags[2];
+      bFlags[0] = g_bSearching && (! g_bSearchFoundVehicle);
+      bFlags[1] = (NULL != g_pCurrentModel);
+      uContentHash = render_engine_hash(uContentHash, bFlags, sizeof(bFlags));
+   }
+   bool bDrawRegion = g_pRenderEngine->beginRegion(OSD_RENDER_REGION_BACKGROUND, 0, 0, 1.0, 1.0, uContentHash);
+
+   if ( bDrawRegion )
    if ( showBg || bForceBackground || (! link_has_received_videostream(0)) )
    {
       if ( bForceBackground || (! pairing_isStarted()) || (g_TimeNow < pairing_getStartTime() + 1000) )
@@ -487,6 +509,7 @@ void _render_background_and_paddings(bool bForceBackground)
    }
 
    float fScreenAspect = (float)(g_pRenderEngine->getScreenWidth())/(float)(g_pRenderEngine->getScreenHeight());
+   if ( bDrawRegion )
    if ( (!g_bSearching) || g_bSearchFoundVehicle )
    if ( (NULL != g_pCurrentModel) && (!bForceBackground) )
    {
@@ -518,6 +541,31 @@ void _render_background_and_paddings(bool bForceBackground)
          }
       }
    }
+   g_pRenderEngine->endRegion();
+}
+
+// Frames can be composed from the cached render regions only if everything they draw is in a region
+bool _can_render_with_damage_tracking(bool bRenderMenus, bool bForceBackground)
+{
+   if ( bForceBackground )
+      return false;
+   if ( bRenderMenus && isMenuOn() )
+      return false;
+   if ( (popups_get_count() > 0) || (popups_get_topmost_count() > 0) )
+      return false;
+   if ( handle_commands_is_command_in_progress() )
+      return false;
+   if ( osd_plugins_are_rendered() )
+      return false;
+
+   // Developer mode draws extra info outside the OSD
+   ControllerSettings* pCS = get_ControllerSettings();
+   if ( (NULL != pCS) && (0 != pCS->iDeveloperMode) )
+      return false;
+   Preferences* p = get_Preferences();
+   if ( (NULL != p) && p->iOSDFlipVertical )
+      return false;
+   return true;
 }
 
 void render_all_with_menus(u32 timeNow, bool bRenderMenus, bool bForceBackground, bool bDoInputLoop)
@@ -534,6 +582,8 @@ void render_all_with_menus(u32 timeNow, bool bRenderMenus, bool bForceBackground
       return;
    }
 
+   if ( _can_render_with_damage_tracking(bRenderMenus, bForceBackground) )
+      g_pRenderEngine->enableDamageTrackingForNextFrame();
    g_pRenderEngine->startFrame();
    
    _render_background_and_paddings(bForceBackground);
@@ -1549,6 +1599,11 @@ void start_loop()
       char szFile2[128];
       strcpy(szFile, FOLDER_RUBY_TEMP);
       strcat(szFile, FILE_TEMP_VIDEO_FILE);
+      if ( access(szFile, R_OK) == -1 )
+      {
+         strcpy(szFile, FOLDER_RUBY_TEMP);
+         strcat(szFile, FILE_TEMP_VIDEO_MP4_FILE);
+      }
       strcpy(szFile2, FOLDER_RUBY_TEMP);
       strcat(szFile2, FILE_TEMP_VIDEO_FILE_INFO);
       if ( access(szFile, R_OK) != -1 )
@@ -1730,8 +1785,24 @@ void start_loop()
 }
 
 
+// Last published sequence numbers of the versioned shared memory segments copied locally,
+// so that unchanged segments are not copied again
+static u32 s_uSMSequenceControllerRTInfo = 0;
+static u32 s_uSMSequenceVehicleRTInfo = 0;
+static u32 s_uSMSequenceRadioStats = 0;
+static u32 s_uSMSequenceHistoryRxStats = 0;
+static u32 s_uSMSequenceVideoFramesStatsOutput = 0;
+static u32 s_uSMSequenceVideoLinkGraphs = 0;
+
 void clear_shared_mems()
 {
+   s_uSMSequenceControllerRTInfo = 0;
+   s_uSMSequenceVehicleRTInfo = 0;
+   s_uSMSequenceRadioStats = 0;
+   s_uSMSequenceHistoryRxStats = 0;
+   s_uSMSequenceVideoFramesStatsOutput = 0;
+   s_uSMSequenceVideoLinkGraphs = 0;
+
    memset(&g_SM_VideoFramesStatsOutput, 0, sizeof(shared_mem_video_frames_stats));
    //memset(&g_SM_VideoInfoStatsRadioIn, 0, sizeof(shared_mem_video_frames_stats));
    //memset(&g_VideoInfoStatsFromVehicleCameraOut, 0, sizeof(shared_mem_video_frames_stats));
@@ -1815,7 +1886,7 @@ void synchronize_shared_mems()
    }
    if ( NULL != g_pSMControllerRTInfo )
    {
-      memcpy((u8*)&g_SMControllerRTInfo, g_pSMControllerRTInfo, sizeof(controller_runtime_info));
+      shared_mem_try_snapshot(g_pSMControllerRTInfo, sizeof(controller_runtime_info), &g_SMControllerRTInfo, &s_uSMSequenceControllerRTInfo);
       if ( (g_SMControllerRTInfo.iCurrentIndex != g_SMControllerRTInfo.iCurrentIndex2) ||
            (g_SMControllerRTInfo.iCurrentIndex2 != g_SMControllerRTInfo.iCurrentIndex3) )
       {
@@ -1832,7 +1903,7 @@ void synchronize_shared_mems()
          log_line("Opened shared mem to vehicle runtime info for reading.");
    }
    if ( NULL != g_pSMVehicleRTInfo )
-      memcpy((u8*)&g_SMVehicleRTInfo, g_pSMVehicleRTInfo, sizeof(vehicle_runtime_info));
+      shared_mem_try_snapshot(g_pSMVehicleRTInfo, sizeof(vehicle_runtime_info), &g_SMVehicleRTInfo, &s_uSMSequenceVehicleRTInfo);
 
 
    if ( g_bFreezeOSD )
@@ -1851,10 +1922,10 @@ void synchronize_shared_mems()
    if ( NULL != g_pSM_RouterVehiclesRuntimeInfo )
       memcpy((u8*)&g_SM_RouterVehiclesRuntimeInfo, g_pSM_RouterVehiclesRuntimeInfo, sizeof(shared_mem_router_vehicles_runtime_info));
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)&g_SM_RadioStats, g_pSM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_try_snapshot(g_pSM_RadioStats, sizeof(shared_mem_radio_stats), &g_SM_RadioStats, &s_uSMSequenceRadioStats);
    
    if ( NULL != g_pSM_HistoryRxStats )
-      memcpy((u8*)&g_SM_HistoryRxStats, g_pSM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_try_snapshot(g_pSM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist), &g_SM_HistoryRxStats, &s_uSMSequenceHistoryRxStats);
    if ( NULL != g_pSM_AudioDecodeStats )
       memcpy((u8*)&g_SM_AudioDecodeStats, g_pSM_AudioDecodeStats, sizeof(shared_mem_audio_decode_stats));
    
@@ -1864,7 +1935,7 @@ void synchronize_shared_mems()
    {
       if ( NULL != g_pSM_VideoFramesStatsOutput )
       if ( g_TimeNow >= g_SM_VideoFramesStatsOutput.uLastTimeStatsUpdate + 200 )
-         memcpy((u8*)&g_SM_VideoFramesStatsOutput, g_pSM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_try_snapshot(g_pSM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats), &g_SM_VideoFramesStatsOutput, &s_uSMSequenceVideoFramesStatsOutput);
       //if ( NULL != g_pSM_VideoInfoStatsRadioIn )
       //if ( g_TimeNow >= g_SM_VideoInfoStatsRadioIn.uLastTimeStatsUpdate + 200 )
       //   memcpy((u8*)&g_SM_VideoInfoStatsRadioIn, g_pSM_VideoInfoStatsRadioIn, sizeof(shared_mem_video_frames_stats));
@@ -1878,7 +1949,7 @@ void synchronize_shared_mems()
    //if ( NULL != g_pSM_VideoLinkStats )
    //   memcpy((u8*)&g_SM_VideoLinkStats, g_pSM_VideoLinkStats, sizeof(shared_mem_video_link_stats_and_overwrites));
    if ( NULL != g_pSM_VideoLinkGraphs )
-      memcpy((u8*)&g_SM_VideoLinkGraphs, g_pSM_VideoLinkGraphs, sizeof(shared_mem_video_link_graphs));
+      shared_mem_try_snapshot(g_pSM_VideoLinkGraphs, sizeof(shared_mem_video_link_graphs), &g_SM_VideoLinkGraphs, &s_uSMSequenceVideoLinkGraphs);
    if ( NULL != g_pSM_RCIn )
       memcpy((u8*)&g_SM_RCIn, g_pSM_RCIn, sizeof(t_shared_mem_i2c_controller_rc_in));
    if ( NULL != g_pSMVoltage )
@@ -2112,6 +2183,7 @@ void handle_sigint(int sig)
    log_line("--------------------------");
    log_line("Caught signal to stop: %d", sig);
    log_line("--------------------------");
+   log_flush();
    g_bQuit = true;
 } 
 
@@ -1,7 +1,22 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
 #include "../public/ruby_core_plugin.h"
 #include "../public/utils/core_plugins_utils.h"
+#include "../public/utils/core_plugins_ring.h"
+
+// This example generates a high rate data stream on the vehicle (a synthetic sensor stream, one frame per segment)
+// and checks the received stream on the controller.
+// It uses the API version 2 segments rings: a capture thread writes the frames directly in the tx ring and Ruby reads them from there.
+// The API version 1 methods are implemented on top of the same ring, for older Ruby versions.
+
+#define EXAMPLE_TX_RING_SLOTS 256
+#define EXAMPLE_SEGMENT_SIZE 1024
+#define EXAMPLE_DEFAULT_SEGMENTS_PER_SECOND 2000
 
 const char* g_szPluginNameExample = "Example Core Plugin";
 const char* g_szUIDExample = "A34776T-A2123Q-WE19J-XX24";
@@ -9,6 +24,86 @@ const char* g_szUIDExample = "A34776T-A2123Q-WE19J-XX24";
 u32 g_uRuntimeLocation = 0;
 u32 g_uAllocatedCapabilities = 0;
 
+static t_core_plugin_ring* s_pTxRing = NULL;
+static t_core_plugin_ring* s_pRxRing = NULL;
+static pthread_t s_pThreadCapture;
+static volatile int s_iCaptureRunning = 0;
+static volatile int s_iSegmentsPerSecond = EXAMPLE_DEFAULT_SEGMENTS_PER_SECOND;
+static u32 s_uFrameCounter = 0;
+static int s_iV1SegmentsToRelease = 0;
+
+static u32 s_uRxSegments = 0;
+static u32 s_uRxBytes = 0;
+static u32 s_uRxErrors = 0;
+
+static void _example_fill_frame(u8* pBuffer, u32 uFrame)
+{
+   memcpy(pBuffer, &uFrame, sizeof(u32));
+   for( int i=sizeof(u32); i<EXAMPLE_SEGMENT_SIZE; i++ )
+      pBuffer[i] = (u8)(uFrame + i);
+}
+
+static int _example_check_frame(u8* pData, int iLength)
+{
+   if ( (NULL == pData) || (iLength != EXAMPLE_SEGMENT_SIZE) )
+      return 0;
+   u32 uFrame = 0;
+   memcpy(&uFrame, pData, sizeof(u32));
+   // Check just the frame ends, to keep the check cheap at high rates
+   if ( (pData[sizeof(u32)] != (u8)(uFrame + sizeof(u32))) || (pData[iLength-1] != (u8)(uFrame + iLength-1)) )
+      return 0;
+   return 1;
+}
+
+static void _example_on_rx_segment(u8* pData, int iLength)
+{
+   s_uRxSegments++;
+   s_uRxBytes += iLength;
+   if ( ! _example_check_frame(pData, iLength) )
+      s_uRxErrors++;
+}
+
+static void* _thread_capture(void* pParam)
+{
+   struct timespec tsStart;
+   clock_gettime(CLOCK_MONOTONIC, &tsStart);
+   u32 uFramesSent = 0;
+
+   while ( s_iCaptureRunning )
+   {
+      int iRate = s_iSegmentsPerSecond;
+      if ( iRate < 0 )
+      {
+         usleep(1000);
+         continue;
+      }
+      if ( iRate > 0 )
+      {
+         struct timespec tsNow;
+         clock_gettime(CLOCK_MONOTONIC, &tsNow);
+         long long llElapsedMicros = (tsNow.tv_sec - tsStart.tv_sec)*1000000LL + (tsNow.tv_nsec - tsStart.tv_nsec)/1000;
+         if ( (long long)uFramesSent * 1000000LL > llElapsedMicros * iRate )
+         {
+            usleep(500);
+            continue;
+         }
+      }
+
+      u8* pBuffer = core_plugin_ring_get_write_buffer(s_pTxRing);
+      if ( NULL == pBuffer )
+      {
+         // Ruby did not read the ring fast enough
+         usleep(200);
+         continue;
+      }
+      s_uFrameCounter++;
+      _example_fill_frame(pBuffer, s_uFrameCounter);
+      core_plugin_ring_commit_write(s_pTxRing, EXAMPLE_SEGMENT_SIZE, CORE_PLUGIN_TYPE_DATA_SEGMENT, 0);
+      uFramesSent++;
+   }
+   return NULL;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,7 +114,7 @@ u32 core_plugin_on_requested_capabilities()
 {
    core_plugin_util_log_line("My plugin request capabilities.");
 
-   return CORE_PLUGIN_CAPABILITY_DATA_STREAM | CORE_PLUGIN_CAPABILITY_HARDWARE_ACCESS_UART;
+   return CORE_PLUGIN_CAPABILITY_DATA_STREAM | CORE_PLUGIN_CAPABILITY_RETRANSMISSIONS | CORE_PLUGIN_CAPABILITY_HARDWARE_ACCESS_UART;
 }
 
 // The plugin should return a user friendly name for the plugin
@@ -49,15 +144,133 @@ int core_plugin_init(u32 uRuntimeLocation, u32 uAllocatedCapabilities)
    g_uAllocatedCapabilities = uAllocatedCapabilities;
 
    core_plugin_util_log_line("My plugin init");
+
+   int iSize = core_plugin_ring_get_memory_size(EXAMPLE_TX_RING_SLOTS, EXAMPLE_SEGMENT_SIZE);
+   s_pTxRing = core_plugin_ring_init(malloc(iSize), iSize, EXAMPLE_TX_RING_SLOTS, EXAMPLE_SEGMENT_SIZE);
+   if ( NULL == s_pTxRing )
+      return -1;
+
+   if ( (uRuntimeLocation & CORE_PLUGIN_RUNTIME_LOCATION_VEHICLE) && (uAllocatedCapabilities & CORE_PLUGIN_CAPABILITY_DATA_STREAM) )
+   {
+      s_iCaptureRunning = 1;
+      if ( 0 != pthread_create(&s_pThreadCapture, NULL, &_thread_capture, NULL) )
+      {
+         s_iCaptureRunning = 0;
+         core_plugin_util_log_line("My plugin failed to start the capture thread");
+         return -1;
+      }
+   }
    return 0;
 }
 
 // This is the last method called at runtime, before a plugin is unloaded (due to a reboot or plugin uninstall).
 void core_plugin_uninit()
 {
+   if ( s_iCaptureRunning )
+   {
+      s_iCaptureRunning = 0;
+      pthread_join(s_pThreadCapture, NULL);
+   }
+   if ( NULL != s_pTxRing )
+      free(s_pTxRing);
+   s_pTxRing = NULL;
+   s_pRxRing = NULL;
    core_plugin_util_log_line("My plugin uninit");
 }
 
+// API version 1 data methods, on top of the tx ring
+
+void core_plugin_on_rx_data(u8* pData, int iDataLength, int iDataType, u32 uSegmentIndex)
+{
+   _example_on_rx_segment(pData, iDataLength);
+}
+
+// Returns the next segment from the tx ring. The one returned by the previous call is released now, Ruby is done with it.
+u32 core_plugin_has_pending_tx_data()
+{
+   if ( NULL == s_pTxRing )
+      return 0;
+   core_plugin_ring_release(s_pTxRing, s_iV1SegmentsToRelease);
+   s_iV1SegmentsToRelease = 0;
+
+   u32 uSegmentIndex = 0;
+   if ( ! core_plugin_ring_peek(s_pTxRing, 0, NULL, NULL, NULL, &uSegmentIndex) )
+      return 0;
+   s_iV1SegmentsToRelease = 1;
+   return uSegmentIndex;
+}
+
+u8* core_plugin_on_get_segment_data(u32 uSegmentIndex)
+{
+   u8* pData = NULL;
+   if ( (NULL == s_pTxRing) || (! core_plugin_ring_find_segment(s_pTxRing, uSegmentIndex, &pData, NULL, NULL)) )
+      return NULL;
+   return pData;
+}
+
+int core_plugin_on_get_segment_length(u32 uSegmentIndex)
+{
+   int iLength = 0;
+   if ( (NULL == s_pTxRing) || (! core_plugin_ring_find_segment(s_pTxRing, uSegmentIndex, NULL, &iLength, NULL)) )
+      return 0;
+   return iLength;
+}
+
+int core_plugin_on_get_segment_type(u32 uSegmentIndex)
+{
+   return CORE_PLUGIN_TYPE_DATA_SEGMENT;
+}
+
+// API version 2 data methods
+
+int core_plugin_get_api_version()
+{
+   return CORE_PLUGIN_API_VERSION_2;
+}
+
+t_core_plugin_ring* core_plugin_v2_get_tx_ring()
+{
+   return s_pTxRing;
+}
+
+void core_plugin_v2_set_rx_ring(t_core_plugin_ring* pRing)
+{
+   s_pRxRing = pRing;
+}
+
+void core_plugin_v2_on_rx_batch(u32 uFirstSegmentIndex, int iCount)
+{
+   if ( NULL == s_pRxRing )
+      return;
+   int iPending = core_plugin_ring_get_pending_count(s_pRxRing);
+   for( int i=0; i<iPending; i++ )
+   {
+      u8* pData = NULL;
+      int iLength = 0;
+      if ( core_plugin_ring_peek(s_pRxRing, i, &pData, &iLength, NULL, NULL) )
+         _example_on_rx_segment(pData, iLength);
+   }
+   core_plugin_ring_release(s_pRxRing, iPending);
+}
+
+// Not part of the plugin API, used by the throughput test
+// Segments per second: 0 means as fast as Ruby reads them, negative pauses the capture
+
+void core_plugin_example_set_tx_rate(int iSegmentsPerSecond)
+{
+   s_iSegmentsPerSecond = iSegmentsPerSecond;
+}
+
+void core_plugin_example_get_rx_stats(u32* puSegments, u32* puBytes, u32* puErrors)
+{
+   if ( NULL != puSegments )
+      *puSegments = s_uRxSegments;
+   if ( NULL != puBytes )
+      *puBytes = s_uRxBytes;
+   if ( NULL != puErrors )
+      *puErrors = s_uRxErrors;
+}
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <time.h>
+#include "../public/ruby_core_plugin.h"
+#include "../public/utils/core_plugins_ring.h"
+
+// Loads the example core plugin and compares reading/sending data segments through
+// the API version 1 methods (calls for each segment) and the API version 2 rings (batches, in place).
+// Also checks the segments content and the lookup of old segments for retransmissions.
+//
+// Usage: test_plugin_core_throughput [-plugin file.so] [-rounds n]
+
+#define TEST_RX_SEGMENTS 100000
+#define TEST_RX_BATCH 32
+#define TEST_SEGMENT_SIZE 1024
+
+int (*pFunctionInit)(u32, u32) = NULL;
+void (*pFunctionUninit)(void) = NULL;
+void (*pFunctionOnRxData)(u8*, int, int, u32) = NULL;
+u32 (*pFunctionHasPendingTxData)(void) = NULL;
+u8* (*pFunctionGetSegmentData)(u32) = NULL;
+int (*pFunctionGetSegmentLength)(u32) = NULL;
+int (*pFunctionGetSegmentType)(u32) = NULL;
+int (*pFunctionGetAPIVersion)(void) = NULL;
+t_core_plugin_ring* (*pFunctionGetTxRing)(void) = NULL;
+void (*pFunctionSetRxRing)(t_core_plugin_ring*) = NULL;
+void (*pFunctionOnRxBatch)(u32, int) = NULL;
+void (*pFunctionSetTxRate)(int) = NULL;
+void (*pFunctionGetRxStats)(u32*, u32*, u32*) = NULL;
+
+int s_iTotalErrors = 0;
+u8 s_uPacket[2048];
+
+static void _check(bool bCondition, const char* szTest)
+{
+   printf("  %s: %s\n", szTest, bCondition?"ok":"FAILED");
+   if ( ! bCondition )
+      s_iTotalErrors++;
+}
+
+static long long _get_micros()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+
+static bool _check_frame(u8* pData, int iLength)
+{
+   if ( (NULL == pData) || (iLength != TEST_SEGMENT_SIZE) )
+      return false;
+   u32 uFrame = 0;
+   memcpy(&uFrame, pData, sizeof(u32));
+   // Check just the frame ends, to keep the check cheap in the timed loops
+   if ( (pData[sizeof(u32)] != (u8)(uFrame + sizeof(u32))) || (pData[iLength-1] != (u8)(uFrame + iLength-1)) )
+      return false;
+   return true;
+}
+
+// Sets just the frame bytes the plugin checks
+static void _set_frame(u8* pBuffer, u32 uFrame)
+{
+   memcpy(pBuffer, &uFrame, sizeof(u32));
+   pBuffer[sizeof(u32)] = (u8)(uFrame + sizeof(u32));
+   pBuffer[TEST_SEGMENT_SIZE-1] = (u8)(uFrame + TEST_SEGMENT_SIZE-1);
+}
+
+static void _wait_ring_full(t_core_plugin_ring* pRing)
+{
+   while ( core_plugin_ring_get_free_count(pRing) > 0 )
+      usleep(100);
+}
+
+// Reads the segments the way the vehicle radio tx loop would: copy each one in a radio packet
+static long long _test_tx_v1(t_core_plugin_ring* pRing, int iRounds, int* piSegments, int* piErrors, u32* puLastSegment)
+{
+   long long llTotal = 0;
+   u32 uLastSegment = *puLastSegment;
+   for( int r=0; r<iRounds; r++ )
+   {
+      _wait_ring_full(pRing);
+      long long llStart = _get_micros();
+      for( u32 u=0; u<pRing->uSlotsCount; u++ )
+      {
+         u32 uSegment = (*pFunctionHasPendingTxData)();
+         if ( 0 == uSegment )
+            break;
+         u8* pData = (*pFunctionGetSegmentData)(uSegment);
+         int iLength = (*pFunctionGetSegmentLength)(uSegment);
+         (*pFunctionGetSegmentType)(uSegment);
+         if ( (NULL == pData) || (iLength <= 0) || (iLength > (int)sizeof(s_uPacket)) )
+         {
+            (*piErrors)++;
+            continue;
+         }
+         memcpy(s_uPacket, pData, iLength);
+         if ( (uSegment != uLastSegment + 1) || (! _check_frame(s_uPacket, iLength)) )
+            (*piErrors)++;
+         uLastSegment = uSegment;
+         (*piSegments)++;
+      }
+      llTotal += _get_micros() - llStart;
+   }
+   *puLastSegment = uLastSegment;
+   return llTotal;
+}
+
+static long long _test_tx_v2(t_core_plugin_ring* pRing, int iRounds, int* piSegments, int* piErrors, u32* puLastSegment)
+{
+   long long llTotal = 0;
+   u32 uLastSegment = *puLastSegment;
+   for( int r=0; r<iRounds; r++ )
+   {
+      _wait_ring_full(pRing);
+      long long llStart = _get_micros();
+      int iCount = core_plugin_ring_get_pending_count(pRing);
+      for( int i=0; i<iCount; i++ )
+      {
+         u8* pData = NULL;
+         int iLength = 0;
+         u32 uSegment = 0;
+         if ( ! core_plugin_ring_peek(pRing, i, &pData, &iLength, NULL, &uSegment) )
+            break;
+         memcpy(s_uPacket, pData, iLength);
+         if ( (uSegment != uLastSegment + 1) || (! _check_frame(s_uPacket, iLength)) )
+            (*piErrors)++;
+         uLastSegment = uSegment;
+         (*piSegments)++;
+      }
+      core_plugin_ring_release(pRing, iCount);
+      llTotal += _get_micros() - llStart;
+   }
+   *puLastSegment = uLastSegment;
+   return llTotal;
+}
+
+int main(int argc, char *argv[])
+{
+   const char* szPlugin = "./plugin_core_example.so.1.0.1";
+   int iRounds = 200;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-plugin") )
+         szPlugin = argv[++i];
+      else if ( 0 == strcmp(argv[i], "-rounds") )
+         iRounds = atoi(argv[++i]);
+   }
+
+   void* pLibrary = dlopen(szPlugin, RTLD_NOW);
+   if ( NULL == pLibrary )
+   {
+      printf("Failed to load plugin [%s]: %s\n", szPlugin, dlerror());
+      return -1;
+   }
+   pFunctionInit = (int (*)(u32, u32)) dlsym(pLibrary, "core_plugin_init");
+   pFunctionUninit = (void (*)(void)) dlsym(pLibrary, "core_plugin_uninit");
+   pFunctionOnRxData = (void (*)(u8*, int, int, u32)) dlsym(pLibrary, "core_plugin_on_rx_data");
+   pFunctionHasPendingTxData = (u32 (*)(void)) dlsym(pLibrary, "core_plugin_has_pending_tx_data");
+   pFunctionGetSegmentData = (u8* (*)(u32)) dlsym(pLibrary, "core_plugin_on_get_segment_data");
+   pFunctionGetSegmentLength = (int (*)(u32)) dlsym(pLibrary, "core_plugin_on_get_segment_length");
+   pFunctionGetSegmentType = (int (*)(u32)) dlsym(pLibrary, "core_plugin_on_get_segment_type");
+   pFunctionGetAPIVersion = (int (*)(void)) dlsym(pLibrary, "core_plugin_get_api_version");
+   pFunctionGetTxRing = (t_core_plugin_ring* (*)(void)) dlsym(pLibrary, "core_plugin_v2_get_tx_ring");
+   pFunctionSetRxRing = (void (*)(t_core_plugin_ring*)) dlsym(pLibrary, "core_plugin_v2_set_rx_ring");
+   pFunctionOnRxBatch = (void (*)(u32, int)) dlsym(pLibrary, "core_plugin_v2_on_rx_batch");
+   pFunctionSetTxRate = (void (*)(int)) dlsym(pLibrary, "core_plugin_example_set_tx_rate");
+   pFunctionGetRxStats = (void (*)(u32*, u32*, u32*)) dlsym(pLibrary, "core_plugin_example_get_rx_stats");
+
+   if ( (NULL == pFunctionInit) || (NULL == pFunctionUninit) || (NULL == pFunctionOnRxData) || (NULL == pFunctionHasPendingTxData) ||
+        (NULL == pFunctionGetSegmentData) || (NULL == pFunctionGetSegmentLength) || (NULL == pFunctionGetSegmentType) ||
+        (NULL == pFunctionGetAPIVersion) || (NULL == pFunctionGetTxRing) || (NULL == pFunctionSetRxRing) || (NULL == pFunctionOnRxBatch) ||
+        (NULL == pFunctionSetTxRate) || (NULL == pFunctionGetRxStats) )
+   {
+      printf("Plugin [%s] does not export all the test methods.\n", szPlugin);
+      return -1;
+   }
+
+   printf("\nTesting core plugin data throughput [%s], %d rounds:\n", szPlugin, iRounds);
+   _check(CORE_PLUGIN_API_VERSION_2 == (*pFunctionGetAPIVersion)(), "plugin API version 2");
+   _check(0 == (*pFunctionInit)(CORE_PLUGIN_RUNTIME_LOCATION_VEHICLE, CORE_PLUGIN_CAPABILITY_DATA_STREAM | CORE_PLUGIN_CAPABILITY_RETRANSMISSIONS), "plugin init");
+   (*pFunctionSetTxRate)(0);
+
+   t_core_plugin_ring* pTxRing = (*pFunctionGetTxRing)();
+   _check(core_plugin_ring_is_valid(pTxRing), "plugin tx ring");
+   if ( ! core_plugin_ring_is_valid(pTxRing) )
+      return 1;
+
+   // Tx: plugin to Ruby
+   int iSegmentsV1 = 0, iErrorsV1 = 0, iSegmentsV2 = 0, iErrorsV2 = 0;
+   u32 uLastSegment = 0;
+   long long llTimeV1 = _test_tx_v1(pTxRing, iRounds, &iSegmentsV1, &iErrorsV1, &uLastSegment);
+   // The last segment read with the API version 1 calls is released by the plugin only on the next call
+   core_plugin_ring_release(pTxRing, 1);
+   long long llTimeV2 = _test_tx_v2(pTxRing, iRounds, &iSegmentsV2, &iErrorsV2, &uLastSegment);
+   // API version 1 reads one segment less on some rounds: the plugin keeps the last one it returned until the next call
+   _check((iSegmentsV1 >= iRounds*(int)(pTxRing->uSlotsCount-1)) && (0 == iErrorsV1), "tx segments, API version 1");
+   _check((iSegmentsV2 == iRounds*(int)pTxRing->uSlotsCount) && (0 == iErrorsV2), "tx segments, API version 2");
+   printf("  tx: API v1: %.1f ns/segment, API v2: %.1f ns/segment (%.2fx)\n",
+      (1000.0*llTimeV1)/iSegmentsV1, (1000.0*llTimeV2)/iSegmentsV2, (llTimeV2 > 0)?((double)llTimeV1*iSegmentsV2)/((double)llTimeV2*iSegmentsV1):0.0);
+
+   // Retransmissions: recently sent segments are still in the ring, old ones are gone
+   _wait_ring_full(pTxRing);
+   (*pFunctionSetTxRate)(-1);
+   usleep(20000);
+   int iCount = core_plugin_ring_get_pending_count(pTxRing)/2;
+   u32 uSentSegment = 0;
+   core_plugin_ring_peek(pTxRing, iCount-1, NULL, NULL, NULL, &uSentSegment);
+   core_plugin_ring_release(pTxRing, iCount);
+
+   u8* pData = NULL;
+   int iLength = 0;
+   u32 uOldSegment = uSentSegment - iCount/2;
+   bool bFound = core_plugin_ring_find_segment(pTxRing, uOldSegment, &pData, &iLength, NULL);
+   u32 uFrame = 0;
+   if ( bFound )
+      memcpy(&uFrame, pData, sizeof(u32));
+   _check(bFound && (uFrame == uOldSegment) && _check_frame(pData, iLength) && core_plugin_ring_is_segment_present(pTxRing, uOldSegment), "retransmission lookup");
+   _check(! core_plugin_ring_find_segment(pTxRing, uSentSegment - 10*pTxRing->uSlotsCount, NULL, NULL, NULL), "old segment is not available");
+
+   // Rx: Ruby to plugin
+   int iSize = core_plugin_ring_get_memory_size(64, TEST_SEGMENT_SIZE);
+   t_core_plugin_ring* pRxRing = core_plugin_ring_init(malloc(iSize), iSize, 64, TEST_SEGMENT_SIZE);
+   (*pFunctionSetRxRing)(pRxRing);
+
+   // Received radio data: API version 1 gets a pointer to it, API version 2 gets a copy in the rx ring
+   u8 uSegment[TEST_SEGMENT_SIZE];
+   memset(uSegment, 0, sizeof(uSegment));
+   long long llStart = _get_micros();
+   for( u32 u=1; u<=TEST_RX_SEGMENTS; u++ )
+   {
+      _set_frame(uSegment, u);
+      (*pFunctionOnRxData)(uSegment, TEST_SEGMENT_SIZE, CORE_PLUGIN_TYPE_DATA_SEGMENT, u);
+   }
+   long long llTimeRxV1 = _get_micros() - llStart;
+
+   llStart = _get_micros();
+   for( u32 u=1; u<=TEST_RX_SEGMENTS; )
+   {
+      u32 uFirst = u;
+      int iCount = 0;
+      while ( (iCount < TEST_RX_BATCH) && (u <= TEST_RX_SEGMENTS) )
+      {
+         u8* pBuffer = core_plugin_ring_get_write_buffer(pRxRing);
+         if ( NULL == pBuffer )
+            break;
+         _set_frame(uSegment, u);
+         memcpy(pBuffer, uSegment, TEST_SEGMENT_SIZE);
+         core_plugin_ring_commit_write(pRxRing, TEST_SEGMENT_SIZE, CORE_PLUGIN_TYPE_DATA_SEGMENT, u);
+         iCount++;
+         u++;
+      }
+      (*pFunctionOnRxBatch)(uFirst, iCount);
+   }
+   long long llTimeRxV2 = _get_micros() - llStart;
+
+   u32 uRxSegments = 0, uRxBytes = 0, uRxErrors = 0;
+   (*pFunctionGetRxStats)(&uRxSegments, &uRxBytes, &uRxErrors);
+   _check((uRxSegments == 2*TEST_RX_SEGMENTS) && (uRxBytes == 2*TEST_RX_SEGMENTS*TEST_SEGMENT_SIZE) && (0 == uRxErrors), "rx segments, API version 1 and 2");
+   _check(0 == core_plugin_ring_get_pending_count(pRxRing), "rx ring is consumed");
+   printf("  rx: API v1: %.1f ns/segment, API v2: %.1f ns/segment\n", (1000.0*llTimeRxV1)/TEST_RX_SEGMENTS, (1000.0*llTimeRxV2)/TEST_RX_SEGMENTS);
+
+   (*pFunctionUninit)();
+   free(pRxRing);
+   dlclose(pLibrary);
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nCore plugin throughput test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nCore plugin throughput test passed.\n");
+   return 0;
+}
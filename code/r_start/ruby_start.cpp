@@ -39,6 +39,7 @@
 
 #include "../base/base.h"
 #include "../base/config.h"
+#include "../base/crc32.h"
 #include "../base/shared_mem.h"
 #include "../base/models.h"
 #include "../base/models_list.h"
@@ -1083,6 +1084,12 @@ void _step_check_binaries_and_processes()
    log_line("Ruby: Base version is %d.%d", iMajor, iMinor);
    printf("Ruby: Base version is %d.%d\n", iMajor, iMinor);
 
+   log_line("Ruby: Using %s CRC32 kernel.", crc32_get_kernel_name(crc32_get_kernel()));
+   #if defined(__arm__) || defined(__aarch64__)
+   if ( ! crc32_armv8_is_built() )
+      log_softerror_and_alarm("Ruby: The ARMv8 CRC32 kernel is not built in this binary (missing CRC compile flags), using the generic CRC32 code.");
+   #endif
+
    char szInfo[256];
    char szOutput[1024];
    strcpy(szInfo, "Ruby: Platform: ");
@@ -1345,7 +1352,9 @@ void _step_enumerate_radios()
    log_line("Ruby: Enumerating supported 2.4/5.8Ghz radio interfaces...");
    fflush(stdout);
 
-   hardware_radio_remove_stored_config();
+   // Reuse the stored radio config if the radio hardware did not change since it was saved
+   if ( ! hardware_radio_stored_config_matches_hardware() )
+      hardware_radio_remove_stored_config();
    hardware_enumerate_radio_interfaces_step(0);
 
    //int iCountHighCapacityInterfaces = hardware_get_radio_interfaces_count();
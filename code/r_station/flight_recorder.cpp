@@ -0,0 +1,267 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "flight_recorder.h"
+
+static int s_iFlightRecorderFd = -1;
+static u8* s_pFlightRecorderMap = NULL;
+static u32 s_uFlightRecorderMapSize = 0;
+static t_flight_recorder_header* s_pFlightRecorderHeader = NULL;
+static t_flight_recorder_record* s_pFlightRecorderRecords = NULL;
+
+static signed char _flight_recorder_dbm_to_s8(int iDbm)
+{
+   if ( (iDbm >= FLIGHT_RECORDER_DBM_INVALID) || (iDbm < -127) )
+      return FLIGHT_RECORDER_DBM_INVALID;
+   return (signed char)iDbm;
+}
+
+static bool _flight_recorder_header_is_valid(t_flight_recorder_header* pHeader)
+{
+   if ( (pHeader->uMagic != FLIGHT_RECORDER_MAGIC) || (pHeader->uVersion != FLIGHT_RECORDER_VERSION) )
+      return false;
+   if ( (pHeader->uRecordSize != sizeof(t_flight_recorder_record)) || (pHeader->uHeaderSize != FLIGHT_RECORDER_HEADER_SIZE) )
+      return false;
+   if ( pHeader->uMaxRecords != FLIGHT_RECORDER_MAX_RECORDS )
+      return false;
+   return true;
+}
+
+bool flight_recorder_init(u32 uVehicleId, u32 uTimeNow)
+{
+   if ( NULL != s_pFlightRecorderMap )
+      return true;
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_LOGS);
+   strcat(szFile, LOG_FILE_FLIGHT_RECORDER);
+
+   s_uFlightRecorderMapSize = FLIGHT_RECORDER_HEADER_SIZE + FLIGHT_RECORDER_MAX_RECORDS * sizeof(t_flight_recorder_record);
+
+   // Do not fill up the SD card: the file is allocated only if enough free space remains after it
+   struct stat statFileExisting;
+   u32 uExistingSize = 0;
+   if ( 0 == stat(szFile, &statFileExisting) )
+      uExistingSize = (u32)statFileExisting.st_size;
+   struct statvfs statFS;
+   if ( (uExistingSize != s_uFlightRecorderMapSize) && (0 == statvfs(FOLDER_LOGS, &statFS)) )
+   {
+      unsigned long long uFreeBytes = (unsigned long long)statFS.f_bavail * (unsigned long long)statFS.f_frsize + uExistingSize;
+      if ( uFreeBytes < (unsigned long long)s_uFlightRecorderMapSize + FLIGHT_RECORDER_MIN_FREE_SPACE )
+      {
+         log_softerror_and_alarm("[FlightRecorder] Not enough free space for the flight recorder file (%llu kb free, %u kb needed). Flight recorder is disabled.",
+            uFreeBytes/1024, (u32)((s_uFlightRecorderMapSize + FLIGHT_RECORDER_MIN_FREE_SPACE)/1024));
+         return false;
+      }
+   }
+
+   s_iFlightRecorderFd = open(szFile, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+   if ( s_iFlightRecorderFd < 0 )
+   {
+      log_softerror_and_alarm("[FlightRecorder] Failed to open file %s, error: %s", szFile, strerror(errno));
+      return false;
+   }
+
+   // Allocate the file blocks now, so that writes through the memory map can't fail later on a full disk
+   struct stat statFile;
+   if ( (0 != fstat(s_iFlightRecorderFd, &statFile)) || (statFile.st_size != (off_t)s_uFlightRecorderMapSize) )
+   {
+      if ( (0 != ftruncate(s_iFlightRecorderFd, 0)) || (0 != posix_fallocate(s_iFlightRecorderFd, 0, s_uFlightRecorderMapSize)) )
+      {
+         log_softerror_and_alarm("[FlightRecorder] Failed to allocate %u bytes for file %s", s_uFlightRecorderMapSize, szFile);
+         close(s_iFlightRecorderFd);
+         s_iFlightRecorderFd = -1;
+         unlink(szFile);
+         return false;
+      }
+   }
+
+   s_pFlightRecorderMap = (u8*) mmap(NULL, s_uFlightRecorderMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, s_iFlightRecorderFd, 0);
+   if ( MAP_FAILED == s_pFlightRecorderMap )
+   {
+      log_softerror_and_alarm("[FlightRecorder] Failed to map file %s, error: %s", szFile, strerror(errno));
+      s_pFlightRecorderMap = NULL;
+      close(s_iFlightRecorderFd);
+      s_iFlightRecorderFd = -1;
+      return false;
+   }
+
+   s_pFlightRecorderHeader = (t_flight_recorder_header*)s_pFlightRecorderMap;
+   s_pFlightRecorderRecords = (t_flight_recorder_record*)(s_pFlightRecorderMap + FLIGHT_RECORDER_HEADER_SIZE);
+
+   if ( ! _flight_recorder_header_is_valid(s_pFlightRecorderHeader) )
+   {
+      log_line("[FlightRecorder] Creating new flight recorder file %s (%u records of %d bytes).", szFile, FLIGHT_RECORDER_MAX_RECORDS, (int)sizeof(t_flight_recorder_record));
+      memset(s_pFlightRecorderHeader, 0, FLIGHT_RECORDER_HEADER_SIZE);
+      s_pFlightRecorderHeader->uVersion = FLIGHT_RECORDER_VERSION;
+      s_pFlightRecorderHeader->uRecordSize = sizeof(t_flight_recorder_record);
+      s_pFlightRecorderHeader->uHeaderSize = FLIGHT_RECORDER_HEADER_SIZE;
+      s_pFlightRecorderHeader->uMaxRecords = FLIGHT_RECORDER_MAX_RECORDS;
+      s_pFlightRecorderHeader->uNextRecordIndex = 0;
+      s_pFlightRecorderHeader->uCountSessions = 0;
+      s_pFlightRecorderHeader->uMagic = FLIGHT_RECORDER_MAGIC;
+   }
+   s_pFlightRecorderHeader->uSliceIntervalMs = SYSTEM_RT_INFO_UPDATE_INTERVAL_MS;
+
+   t_flight_recorder_session* pSession = &(s_pFlightRecorderHeader->sessions[s_pFlightRecorderHeader->uCountSessions % FLIGHT_RECORDER_MAX_SESSIONS]);
+   pSession->uStartRecordIndex = s_pFlightRecorderHeader->uNextRecordIndex;
+   pSession->uStartTime = uTimeNow;
+   pSession->uStartUnixTime = (u32)time(NULL);
+   pSession->uVehicleId = uVehicleId;
+   s_pFlightRecorderHeader->uCountSessions++;
+
+   log_line("[FlightRecorder] Started session %u at record %u, file: %s",
+      s_pFlightRecorderHeader->uCountSessions, pSession->uStartRecordIndex, szFile);
+   return true;
+}
+
+void flight_recorder_uninit()
+{
+   if ( NULL == s_pFlightRecorderMap )
+      return;
+   msync(s_pFlightRecorderMap, s_uFlightRecorderMapSize, MS_ASYNC);
+   munmap(s_pFlightRecorderMap, s_uFlightRecorderMapSize);
+   close(s_iFlightRecorderFd);
+   s_pFlightRecorderMap = NULL;
+   s_pFlightRecorderHeader = NULL;
+   s_pFlightRecorderRecords = NULL;
+   s_iFlightRecorderFd = -1;
+   log_line("[FlightRecorder] Closed.");
+}
+
+// Stores the current (just completed) slice of the runtime info.
+// Must be called before the runtime info slice index is advanced.
+// No formatting and no syncing here: the kernel writes the dirty pages back in the background.
+
+void flight_recorder_add_slice(controller_runtime_info* pRTInfo, u32 uTimeNow)
+{
+   if ( (NULL == s_pFlightRecorderHeader) || (NULL == pRTInfo) )
+      return;
+
+   int iIndex = pRTInfo->iCurrentIndex;
+   if ( (iIndex < 0) || (iIndex >= SYSTEM_RT_INFO_INTERVALS) )
+      return;
+
+   u32 uRecordIndex = s_pFlightRecorderHeader->uNextRecordIndex;
+   t_flight_recorder_record* pRecord = &(s_pFlightRecorderRecords[uRecordIndex % FLIGHT_RECORDER_MAX_RECORDS]);
+
+   pRecord->uRecordIndex = uRecordIndex;
+   pRecord->uSliceStartTime = pRTInfo->uCurrentSliceStartTime;
+   pRecord->uSliceDurationMs = (u16)((uTimeNow > pRTInfo->uCurrentSliceStartTime)?(uTimeNow - pRTInfo->uCurrentSliceStartTime):0);
+   pRecord->uRadioLinkQuality = pRTInfo->uRadioLinkQuality[iIndex];
+   pRecord->uFlagsAdaptiveVideo = pRTInfo->uFlagsAdaptiveVideo[iIndex];
+   pRecord->uTotalCountOutputSkippedBlocks = pRTInfo->uTotalCountOutputSkippedBlocks;
+
+   pRecord->uRxProcessedPackets = pRTInfo->uRxProcessedPackets[iIndex];
+   pRecord->uRxMaxAirgapSlots = pRTInfo->uRxMaxAirgapSlots[iIndex];
+   pRecord->uTxPackets = pRTInfo->uTxPackets[iIndex];
+   pRecord->uTxHighPriorityPackets = pRTInfo->uTxHighPriorityPackets[iIndex];
+   pRecord->uRecvVideoDataPackets = pRTInfo->uRecvVideoDataPackets[iIndex];
+   pRecord->uRecvVideoECPackets = pRTInfo->uRecvVideoECPackets[iIndex];
+   pRecord->uRecvFramesInfo = pRTInfo->uRecvFramesInfo[iIndex];
+
+   pRecord->uOutputedVideoPackets = pRTInfo->uOutputedVideoPackets[iIndex];
+   pRecord->uOutputedVideoPacketsRetransmitted = pRTInfo->uOutputedVideoPacketsRetransmitted[iIndex];
+   pRecord->uOutputedVideoPacketsSingleECUsed = pRTInfo->uOutputedVideoPacketsSingleECUsed[iIndex];
+   pRecord->uOutputedVideoPacketsTwoECUsed = pRTInfo->uOutputedVideoPacketsTwoECUsed[iIndex];
+   pRecord->uOutputedVideoPacketsMultipleECUsed = pRTInfo->uOutputedVideoPacketsMultipleECUsed[iIndex];
+   pRecord->uOutputedVideoPacketsMaxECUsed = pRTInfo->uOutputedVideoPacketsMaxECUsed[iIndex];
+   pRecord->uOutputedVideoPacketsSkippedBlocks = pRTInfo->uOutputedVideoPacketsSkippedBlocks[iIndex];
+
+   int iCountVehicles = 0;
+   int iReqRetransmissions = 0;
+   int iReqRetrPackets = 0;
+   int iAckRetransmissions = 0;
+   for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
+   {
+      if ( 0 == pRTInfo->vehicles[i].uVehicleId )
+         continue;
+      iCountVehicles++;
+      iReqRetransmissions += pRTInfo->vehicles[i].uCountReqRetransmissions[iIndex];
+      iReqRetrPackets += pRTInfo->vehicles[i].uCountReqRetrPackets[iIndex];
+      iAckRetransmissions += pRTInfo->vehicles[i].uCountAckRetransmissions[iIndex];
+   }
+   pRecord->uCountVehicles = (u8)iCountVehicles;
+   pRecord->uCountReqRetransmissions = (u8)((iReqRetransmissions > 255)?255:iReqRetransmissions);
+   pRecord->uCountReqRetrPackets = (u8)((iReqRetrPackets > 255)?255:iReqRetrPackets);
+   pRecord->uCountAckRetransmissions = (u8)((iAckRetransmissions > 255)?255:iAckRetransmissions);
+
+   int iCountInterfaces = hardware_get_radio_interfaces_count();
+   if ( iCountInterfaces > FLIGHT_RECORDER_MAX_INTERFACES )
+      iCountInterfaces = FLIGHT_RECORDER_MAX_INTERFACES;
+   pRecord->uCountInterfaces = (u8)iCountInterfaces;
+
+   for( int i=0; i<FLIGHT_RECORDER_MAX_INTERFACES; i++ )
+   {
+      t_flight_recorder_interface_slice* pInterface = &(pRecord->interfaces[i]);
+      if ( i >= iCountInterfaces )
+      {
+         memset(pInterface, 0, sizeof(t_flight_recorder_interface_slice));
+         continue;
+      }
+      pInterface->uRxVideoPackets = pRTInfo->uRxVideoPackets[iIndex][i];
+      pInterface->uRxVideoECPackets = pRTInfo->uRxVideoECPackets[iIndex][i];
+      pInterface->uRxDataPackets = pRTInfo->uRxDataPackets[iIndex][i];
+      pInterface->uRxHighPriorityPackets = pRTInfo->uRxHighPriorityPackets[iIndex][i];
+      pInterface->uRxMissingPackets = pRTInfo->uRxMissingPackets[iIndex][i];
+      pInterface->uRxMissingPacketsMaxGap = pRTInfo->uRxMissingPacketsMaxGap[iIndex][i];
+      pInterface->uMinAckTime = pRTInfo->vehicles[0].uMinAckTime[iIndex][i];
+      pInterface->uMaxAckTime = pRTInfo->vehicles[0].uMaxAckTime[iIndex][i];
+
+      controller_runtime_info_radio_interface_rx_signal* pSignal = &(pRTInfo->radioInterfacesDbm[iIndex][i]);
+      for( int k=0; k<FLIGHT_RECORDER_MAX_ANTENNAS; k++ )
+      {
+         if ( k >= pSignal->iCountAntennas )
+         {
+            pInterface->iDbmAvg[k] = pInterface->iDbmMin[k] = pInterface->iDbmMax[k] = pInterface->iDbmNoiseAvg[k] = FLIGHT_RECORDER_DBM_INVALID;
+            continue;
+         }
+         pInterface->iDbmAvg[k] = _flight_recorder_dbm_to_s8(pSignal->iDbmAvg[k]);
+         pInterface->iDbmMin[k] = _flight_recorder_dbm_to_s8(pSignal->iDbmMin[k]);
+         pInterface->iDbmMax[k] = _flight_recorder_dbm_to_s8(pSignal->iDbmMax[k]);
+         pInterface->iDbmNoiseAvg[k] = _flight_recorder_dbm_to_s8(pSignal->iDbmNoiseAvg[k]);
+      }
+   }
+
+   // Publish the record only after it is complete, for readers of the live file
+   __atomic_store_n(&(s_pFlightRecorderHeader->uNextRecordIndex), uRecordIndex+1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/controller_rt_info.h"
+
+// Flight recorder: stores each completed controller runtime info slice as a fixed size binary
+// record in a preallocated, memory mapped ring file (LOG_FILE_FLIGHT_RECORDER in the logs folder, kept across reboots).
+// The file starts with a header page (layout info, write position and an index of the
+// last router sessions), followed by the records ring.
+// Record i (counting from the first record ever written to the file) is stored in slot i % uMaxRecords.
+// Use ruby_flight_recorder (r_utils) to dump or convert the file.
+
+#define FLIGHT_RECORDER_MAGIC 0x52464252
+#define FLIGHT_RECORDER_VERSION 1
+#define FLIGHT_RECORDER_HEADER_SIZE 4096
+#define FLIGHT_RECORDER_MAX_RECORDS 65536 // About 6.5 Mb, the last 5 minutes at 5 ms slices
+#define FLIGHT_RECORDER_MIN_FREE_SPACE (64*1024*1024) // Free space to leave on the disk after allocating the file
+#define FLIGHT_RECORDER_MAX_SESSIONS 32
+#define FLIGHT_RECORDER_MAX_INTERFACES 4
+#define FLIGHT_RECORDER_MAX_ANTENNAS 2
+#define FLIGHT_RECORDER_DBM_INVALID 127
+
+typedef struct
+{
+   u8 uRxVideoPackets;
+   u8 uRxVideoECPackets;
+   u8 uRxDataPackets;
+   u8 uRxHighPriorityPackets;
+   u8 uRxMissingPackets;
+   u8 uRxMissingPacketsMaxGap;
+   u8 uMinAckTime; // first vehicle
+   u8 uMaxAckTime; // first vehicle
+   signed char iDbmAvg[FLIGHT_RECORDER_MAX_ANTENNAS];
+   signed char iDbmMin[FLIGHT_RECORDER_MAX_ANTENNAS];
+   signed char iDbmMax[FLIGHT_RECORDER_MAX_ANTENNAS];
+   signed char iDbmNoiseAvg[FLIGHT_RECORDER_MAX_ANTENNAS];
+} ALIGN_STRUCT_SPEC_INFO t_flight_recorder_interface_slice;
+
+typedef struct
+{
+   u32 uRecordIndex;
+   u32 uSliceStartTime; // router timestamp, ms
+   u16 uSliceDurationMs;
+   u8 uCountInterfaces;
+   u8 uRadioLinkQuality;
+   u32 uFlagsAdaptiveVideo;
+   u32 uTotalCountOutputSkippedBlocks;
+
+   u8 uRxProcessedPackets;
+   u8 uRxMaxAirgapSlots;
+   u8 uTxPackets;
+   u8 uTxHighPriorityPackets;
+
+   u8 uRecvVideoDataPackets;
+   u8 uRecvVideoECPackets;
+   u8 uRecvFramesInfo;
+   u8 uCountVehicles;
+
+   u8 uOutputedVideoPackets;
+   u8 uOutputedVideoPacketsRetransmitted;
+   u8 uOutputedVideoPacketsSingleECUsed;
+   u8 uOutputedVideoPacketsTwoECUsed;
+   u8 uOutputedVideoPacketsMultipleECUsed;
+   u8 uOutputedVideoPacketsMaxECUsed;
+   u8 uOutputedVideoPacketsSkippedBlocks;
+   u8 uReserved;
+
+   // Totals for all vehicles
+   u8 uCountReqRetransmissions;
+   u8 uCountReqRetrPackets;
+   u8 uCountAckRetransmissions;
+   u8 uReserved2;
+
+   t_flight_recorder_interface_slice interfaces[FLIGHT_RECORDER_MAX_INTERFACES];
+} ALIGN_STRUCT_SPEC_INFO t_flight_recorder_record;
+
+typedef struct
+{
+   u32 uStartRecordIndex;
+   u32 uStartTime; // router timestamp, ms
+   u32 uStartUnixTime;
+   u32 uVehicleId;
+} ALIGN_STRUCT_SPEC_INFO t_flight_recorder_session;
+
+typedef struct
+{
+   u32 uMagic;
+   u16 uVersion;
+   u16 uRecordSize;
+   u32 uHeaderSize;
+   u32 uMaxRecords;
+   u32 uSliceIntervalMs;
+   u32 uNextRecordIndex; // Total records written to the file
+   u32 uCountSessions; // Total sessions; session s is in slot s % FLIGHT_RECORDER_MAX_SESSIONS
+   t_flight_recorder_session sessions[FLIGHT_RECORDER_MAX_SESSIONS];
+} ALIGN_STRUCT_SPEC_INFO t_flight_recorder_header;
+
+bool flight_recorder_init(u32 uVehicleId, u32 uTimeNow);
+void flight_recorder_uninit();
+void flight_recorder_add_slice(controller_runtime_info* pRTInfo, u32 uTimeNow);
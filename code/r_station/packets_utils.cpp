@@ -53,7 +53,7 @@
 #include "test_link_params.h"
 #include "ruby_rt_station.h"
 
-u8 s_RadioRawPacket[MAX_PACKET_TOTAL_SIZE];
+u8 s_RadioRawPacket[MAX_PACKET_TOTAL_SIZE + ENCR_PACKET_OVERHEAD];
 
 u32 s_StreamsTxPacketIndex[MAX_RADIO_STREAMS];
 u16 s_StreamsLastTxTime[MAX_RADIO_STREAMS];
@@ -474,6 +474,7 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
 
    t_packet_header* pPH = (t_packet_header*)pPacketData;
    if ( (pPH->packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS) ||
+        (pPH->packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT) ||
         (pPH->packet_type == PACKET_TYPE_VIDEO_SWITCH_VIDEO_KEYFRAME_TO_VALUE) ||
         (pPH->packet_type == PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL) )
       bShouldDuplicate = true;
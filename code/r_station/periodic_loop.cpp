@@ -44,6 +44,7 @@
 #include "../radio/radiolink.h"
 #include "../radio/radio_rx.h"
 #include "../radio/radiopacketsqueue.h"
+#include "../radio/fec.h"
 #include "periodic_loop.h"
 #include "shared_vars.h"
 #include "shared_vars_state.h"
@@ -101,9 +102,9 @@ void _synchronize_shared_mems()
    {
       s_TimeLastControllerRTInfoUpdate = g_TimeNow;
       if ( NULL != g_pSMControllerRTInfo )
-         memcpy((u8*)g_pSMControllerRTInfo, (u8*)&g_SMControllerRTInfo, sizeof(controller_runtime_info));
+         shared_mem_publish(g_pSMControllerRTInfo, &g_SMControllerRTInfo, sizeof(controller_runtime_info));
       if ( NULL != g_pSMVehicleRTInfo )
-         memcpy((u8*)g_pSMVehicleRTInfo, (u8*)&g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
+         shared_mem_publish(g_pSMVehicleRTInfo, &g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
    }
    //---------------------------------------------
    
@@ -115,7 +116,7 @@ void _synchronize_shared_mems()
       //update_shared_mem_video_frames_stats( &g_SM_VideoInfoStatsRadioIn, g_TimeNow);
 
       if ( NULL != g_pSM_VideoFramesStatsOutput )
-         memcpy((u8*)g_pSM_VideoFramesStatsOutput, (u8*)&g_SM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoFramesStatsOutput, &g_SM_VideoFramesStatsOutput, sizeof(shared_mem_video_frames_stats));
       //if ( NULL != g_pSM_VideoInfoStatsRadioIn )
       //   memcpy((u8*)g_pSM_VideoInfoStatsRadioIn, (u8*)&g_SM_VideoInfoStatsRadioIn, sizeof(shared_mem_video_frames_stats));
    }
@@ -125,7 +126,7 @@ void _synchronize_shared_mems()
    if ( g_TimeNow >= s_uTimeLastRxHistorySync + 100 )
    {
       s_uTimeLastRxHistorySync = g_TimeNow;
-      memcpy((u8*)g_pSM_HistoryRxStats, (u8*)&g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_publish(g_pSM_HistoryRxStats, &g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
    }
 }
 
@@ -462,6 +463,40 @@ void _check_free_storage_space()
    }
 }
 
+void _check_log_dropped_entries()
+{
+   static u32 sl_uTimeLastLogDroppedCheck = 0;
+   static u32 sl_uLastLogDroppedEntries = 0;
+
+   if ( g_TimeNow < sl_uTimeLastLogDroppedCheck + 10000 )
+      return;
+   sl_uTimeLastLogDroppedCheck = g_TimeNow;
+
+   u32 uDropped = log_get_dropped_entries_count();
+   if ( uDropped == sl_uLastLogDroppedEntries )
+      return;
+   log_softerror_and_alarm("Async log writer dropped %u log entries in the last 10 seconds (%u total).", uDropped - sl_uLastLogDroppedEntries, uDropped);
+   sl_uLastLogDroppedEntries = uDropped;
+}
+
+void _log_fec_decode_cache_stats()
+{
+   static u32 sl_uTimeLastFECCacheStatsLog = 0;
+   static unsigned int sl_uLastFECCacheLookups = 0;
+
+   if ( g_TimeNow < sl_uTimeLastFECCacheStatsLog + 20000 )
+      return;
+   sl_uTimeLastFECCacheStatsLog = g_TimeNow;
+
+   unsigned int uHits = 0;
+   unsigned int uMisses = 0;
+   fec_get_decode_cache_stats(&uHits, &uMisses);
+   if ( uHits + uMisses == sl_uLastFECCacheLookups )
+      return;
+   sl_uLastFECCacheLookups = uHits + uMisses;
+   log_line("FEC decode inverse matrix cache: %u hits, %u misses (%u%% hit rate).", uHits, uMisses, (unsigned int)((100ULL*uHits)/(uHits + uMisses)));
+}
+
 
 void router_periodic_loop()
 {
@@ -519,7 +554,7 @@ void router_periodic_loop()
       {
          s_uTimeLastRadioStatsSharedMemSync = g_TimeNow;
          if ( NULL != g_pSM_RadioStats )
-            memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+            shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
       }
 
       for( int i=0; i<MAX_CONCURENT_VEHICLES; i++ )
@@ -639,6 +674,8 @@ void router_periodic_loop()
    }
 
    _check_free_storage_space();
+   _check_log_dropped_entries();
+   _log_fec_decode_cache_stats();
    _check_send_pairing_requests();
 
    static u32 s_uTimeLastCheckForRetransmissionsDevAlarm = 0;
@@ -60,6 +60,7 @@
 #include "../common/radio_stats.h"
 #include "../radio/radiolink.h"
 #include "../radio/radiopackets2.h"
+#include "../radio/radiopackets_retr.h"
 #include "../radio/radiopacketsqueue.h"
 
 #include "shared_vars.h"
@@ -146,6 +147,7 @@ ProcessorRxVideo::ProcessorRxVideo(u32 uVehicleId, u8 uVideoStreamIndex)
    m_uVideoStreamIndex = uVideoStreamIndex;
    m_uLastTimeRequestedRetransmission = 0;
    m_uRequestRetransmissionUniqueId = 0;
+   m_bVehicleSupportsCompactRetrRequests = false;
    m_uTimeLastReceivedNewVideoPacket = 0;
    m_TimeLastHistoryStatsUpdate = 0;
    m_TimeLastRetransmissionsStatsUpdate = 0;
@@ -325,6 +327,7 @@ void ProcessorRxVideo::resetStateOnVehicleRestart()
    resetReceiveState();
    resetOutputState();
    m_uRequestRetransmissionUniqueId = 0;
+   m_bVehicleSupportsCompactRetrRequests = false;
    m_uLastVideoBlockIndexResolutionChange = 0;
    m_uLastVideoBlockPacketIndexResolutionChange = 0;
 }
@@ -637,6 +640,8 @@ int ProcessorRxVideo::handleReceivedVideoPacket(int interfaceNb, u8* pBuffer, in
    if ( (NULL != pRuntimeInfo) && (! pRuntimeInfo->bIsPairingDone) )
       return 0;
 
+   m_bVehicleSupportsCompactRetrRequests = (pPHVS->uVideoStatusFlags2 & VIDEO_STATUS_FLAGS2_SUPPORTS_COMPACT_RETR_REQUESTS)?true:false;
+
    if ( pPH->packet_flags & PACKET_FLAGS_BIT_RETRANSMITED )
    if ( (0 != m_uLastVideoBlockIndexResolutionChange) && (0 != m_uLastVideoBlockPacketIndexResolutionChange) )
    {
@@ -1022,9 +1027,15 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    //   u8: video stream index
    //   u8: number of video packets requested
    //   (u32+u8)*n = each (video block index + video packet index) requested 
+   //
+   // Vehicles that support it get PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT instead, that can carry more packets in fewer bytes
+
+   int iMaxPacketsToRequest = DEFAULT_VIDEO_RETRANS_MAX_PCOUNT;
+   if ( m_bVehicleSupportsCompactRetrRequests )
+      iMaxPacketsToRequest = DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT;
 
    t_packet_header PH;
-   radio_packet_init(&PH, PACKET_COMPONENT_VIDEO, PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS, STREAM_ID_DATA);
+   radio_packet_init(&PH, PACKET_COMPONENT_VIDEO, m_bVehicleSupportsCompactRetrRequests?PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT:PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS, STREAM_ID_DATA);
    PH.vehicle_id_src = g_uControllerId;
    PH.vehicle_id_dest = m_uVehicleId;
    if ( m_uVehicleId == 0 || m_uVehicleId == MAX_U32 )
@@ -1041,15 +1052,11 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
    #endif
 
    u8 packet[MAX_PACKET_TOTAL_SIZE];
-   m_uRequestRetransmissionUniqueId++;
-   memcpy(packet + sizeof(t_packet_header), (u8*)&m_uRequestRetransmissionUniqueId, sizeof(u32));
-   memcpy(packet + sizeof(t_packet_header) + sizeof(u32), (u8*)&m_uVideoStreamIndex, sizeof(u8));
-   u8* pDataInfo = packet + sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
+   u32 uReqVideoBlocks[DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT];
+   u8 uReqVideoPackets[DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT];
    u32 uTopVideoBlockIndexInBuffer = 0;
    u32 uTopVideoBlockPacketIndexInBuffer = 0xFF;
    u32 uTopVideoBlockLastRecvTime = 0;
-   u32 uLastRequestedVideoBlockIndex = 0;
-   int iLastRequestedVideoBlockPacketIndex = 0;
 
    int iCountPacketsRequested = 0;
    int iCountBlocks = m_pVideoRxBuffer->getBlocksCountInBuffer();
@@ -1103,34 +1110,60 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
             if ( ! pVideoBlock->packets[k].bEmpty )
                continue;
 
-            uLastRequestedVideoBlockIndex = pVideoBlock->uVideoBlockIndex;
-            iLastRequestedVideoBlockPacketIndex = k;
-            memcpy(pDataInfo, &pVideoBlock->uVideoBlockIndex, sizeof(u32));
-            pDataInfo += sizeof(u32);
-            u8 uPacketIndex = k;
-            memcpy(pDataInfo, &uPacketIndex, sizeof(u8));
-            pDataInfo += sizeof(u8);
+            uReqVideoBlocks[iCountPacketsRequested] = pVideoBlock->uVideoBlockIndex;
+            uReqVideoPackets[iCountPacketsRequested] = (u8)k;
 
             iCountToRequestFromBlock--;
             iCountPacketsRequested++;
             if ( iCountToRequestFromBlock == 0 )
                break;
-            if ( iCountPacketsRequested >= DEFAULT_VIDEO_RETRANS_MAX_PCOUNT )
+            if ( iCountPacketsRequested >= iMaxPacketsToRequest )
               break;
          }
       }
-      if ( iCountPacketsRequested >= DEFAULT_VIDEO_RETRANS_MAX_PCOUNT )
+      if ( iCountPacketsRequested >= iMaxPacketsToRequest )
         break;
    }
 
    if ( iCountPacketsRequested == 0 )
       return 0;
 
-   u8 uCount = iCountPacketsRequested;
-   memcpy(packet + sizeof(t_packet_header) + sizeof(u32) + sizeof(u8), (u8*)&uCount, sizeof(u8));
-   PH.total_length = sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
-   PH.total_length += iCountPacketsRequested*(sizeof(u32) + sizeof(u8)); 
+   m_uRequestRetransmissionUniqueId++;
+   memcpy(packet + sizeof(t_packet_header), (u8*)&m_uRequestRetransmissionUniqueId, sizeof(u32));
+   memcpy(packet + sizeof(t_packet_header) + sizeof(u32), (u8*)&m_uVideoStreamIndex, sizeof(u8));
+   PH.total_length = sizeof(t_packet_header) + sizeof(u32) + sizeof(u8);
+
+   if ( PH.packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT )
+   {
+      int iLength = 0;
+      iCountPacketsRequested = radio_packet_retr_request_compact_encode(packet + PH.total_length, MAX_PACKET_TOTAL_SIZE - PH.total_length, uReqVideoBlocks, uReqVideoPackets, iCountPacketsRequested, &iLength);
+      if ( iCountPacketsRequested <= 0 )
+         return 0;
+      PH.total_length += iLength;
+
+      // A few isolated packets are smaller in the legacy format
+      if ( iCountPacketsRequested <= DEFAULT_VIDEO_RETRANS_MAX_PCOUNT )
+      if ( (int)(sizeof(u8) + iCountPacketsRequested*(sizeof(u32) + sizeof(u8))) <= iLength )
+      {
+         PH.packet_type = PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS;
+         PH.total_length = sizeof(t_packet_header) + sizeof(u32) + sizeof(u8);
+      }
+   }
+   if ( PH.packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS )
+   {
+      u8 uCount = iCountPacketsRequested;
+      memcpy(packet + PH.total_length, (u8*)&uCount, sizeof(u8));
+      PH.total_length += sizeof(u8);
+      for( int i=0; i<iCountPacketsRequested; i++ )
+      {
+         memcpy(packet + PH.total_length, &uReqVideoBlocks[i], sizeof(u32));
+         PH.total_length += sizeof(u32);
+         memcpy(packet + PH.total_length, &uReqVideoPackets[i], sizeof(u8));
+         PH.total_length += sizeof(u8);
+      }
+   }
    memcpy(packet, (u8*)&PH, sizeof(t_packet_header));
+   u8 uCount = (iCountPacketsRequested > 255)?255:iCountPacketsRequested;
 
    m_uLastTimeRequestedRetransmission = g_TimeNow;
 
@@ -1144,12 +1177,10 @@ int ProcessorRxVideo::checkAndRequestMissingPackets(bool bForceSyncNow)
          pRTInfo->uCountReqRetrPackets[g_SMControllerRTInfo.iCurrentIndex] += uCount;
    }
 
-   pDataInfo = packet + sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
-   u32 uFirstReqBlockIndex =0;
-   memcpy(&uFirstReqBlockIndex, pDataInfo, sizeof(u32));
-   log_line("[AdaptiveVideo] Requested retr id %u from vehicle for %d packets ([%u/%d]...[%u/%d])",
+   log_line("[AdaptiveVideo] Requested retr id %u from vehicle for %d packets ([%u/%d]...[%u/%d]), %d bytes%s",
       m_uRequestRetransmissionUniqueId, iCountPacketsRequested,
-      uFirstReqBlockIndex, (int)pDataInfo[sizeof(u32)], uLastRequestedVideoBlockIndex, iLastRequestedVideoBlockPacketIndex);
+      uReqVideoBlocks[0], (int)uReqVideoPackets[0], uReqVideoBlocks[iCountPacketsRequested-1], (int)uReqVideoPackets[iCountPacketsRequested-1],
+      PH.total_length, (PH.packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT)?" (compact)":"");
    
    log_line("[AdaptiveVideo] Video blocks in buffer: %d, top/max video block index in buffer: [%u/%u] / [%u/%u]",
       iCountBlocks, uTopVideoBlockIndexInBuffer, uTopVideoBlockPacketIndexInBuffer, m_pVideoRxBuffer->getMaxReceivedVideoBlockIndexPresentInBuffer(), m_pVideoRxBuffer->getMaxReceivedVideoBlockPacketIndexPresentInBuffer());
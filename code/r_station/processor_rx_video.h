@@ -155,6 +155,7 @@ class ProcessorRxVideo
 
       u32 m_uLastTimeRequestedRetransmission;
       u32 m_uRequestRetransmissionUniqueId;
+      bool m_bVehicleSupportsCompactRetrRequests;
 
       u32 m_uEncodingsChangeCount;
       u32 m_uTimeLastVideoStreamChanged;
@@ -112,20 +112,20 @@ void radio_links_reinit_radio_interfaces()
    //hw_execute_bash_command("ifconfig wlan1 down", NULL);
    //hw_execute_bash_command("ifconfig wlan2 down", NULL);
    //hw_execute_bash_command("ifconfig wlan3 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan0 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan1 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan2 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan3 down", NULL);
+   hardware_radio_set_link_up("wlan0", 0);
+   hardware_radio_set_link_up("wlan1", 0);
+   hardware_radio_set_link_up("wlan2", 0);
+   hardware_radio_set_link_up("wlan3", 0);
    hardware_sleep_ms(200);
 
    //hw_execute_bash_command("ifconfig wlan0 up", NULL);
    //hw_execute_bash_command("ifconfig wlan1 up", NULL);
    //hw_execute_bash_command("ifconfig wlan2 up", NULL);
    //hw_execute_bash_command("ifconfig wlan3 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan0 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan1 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan2 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan3 up", NULL);
+   hardware_radio_set_link_up("wlan0", 1);
+   hardware_radio_set_link_up("wlan1", 1);
+   hardware_radio_set_link_up("wlan2", 1);
+   hardware_radio_set_link_up("wlan3", 1);
    
    sprintf(szComm, "rm -rf %s%s", FOLDER_CONFIG, FILE_CONFIG_CURRENT_RADIO_HW_CONFIG);
    hw_execute_bash_command(szComm, NULL);
@@ -224,7 +224,7 @@ void radio_links_close_rxtx_radio_interfaces()
       g_SM_RadioStats.radio_interfaces[i].openedForWrite = 0;
    }
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Closed all radio interfaces (rx/tx)."); 
 }
 
@@ -322,7 +322,7 @@ void radio_links_open_rxtx_radio_interfaces_for_search( u32 uSearchFreq )
    }
    
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Opening RX radio interfaces for search complete. %d interfaces opened for RX:", iCountOpenRead);
    
    for( int i=0; i<hardware_get_radio_interfaces_count(); i++ )
@@ -479,7 +479,7 @@ void radio_links_open_rxtx_radio_interfaces()
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Opening RX/TX radio interfaces complete. %d interfaces opened for RX, %d interfaces opened for TX:", totalCountForRead, totalCountForWrite);
 
    if ( totalCountForRead == 0 )
@@ -553,7 +553,7 @@ void radio_links_open_rxtx_radio_interfaces()
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Finished opening RX/TX radio interfaces.");
 
    radio_links_set_monitor_mode();
@@ -597,7 +597,7 @@ bool radio_links_apply_settings(Model* pModel, int iRadioLink, type_radio_links_
 
       hardware_save_radio_info();
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    }
 
    // Apply data rates
@@ -640,28 +640,22 @@ void radio_links_set_monitor_mode()
          continue;
 
       #ifdef HW_PLATFORM_RADXA_ZERO3
-      char szComm[128];
       //sprintf(szComm, "iwconfig %s mode monitor 2>&1", pRadioHWInfo->szName );
       //hw_execute_bash_command(szComm, NULL);
       //hardware_sleep_ms(uDelayMS);
 
-      sprintf(szComm, "iw dev %s set monitor none 2>&1", pRadioHWInfo->szName);
-      hw_execute_bash_command(szComm, NULL);
+      hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAGS_NONE);
       hardware_sleep_ms(uDelayMS);
 
-      sprintf(szComm, "iw dev %s set monitor fcsfail 2>&1", pRadioHWInfo->szName);
-      hw_execute_bash_command(szComm, NULL);
+      hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
       hardware_sleep_ms(uDelayMS);
       #endif
 
       #ifdef HW_PLATFORM_RASPBERRY
-      char szComm[128];
-      sprintf(szComm, "iw dev %s set monitor none 2>&1", pRadioHWInfo->szName);
-      hw_execute_bash_command(szComm, NULL);
+      hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAGS_NONE);
       hardware_sleep_ms(uDelayMS);
 
-      sprintf(szComm, "iw dev %s set monitor fcsfail 2>&1", pRadioHWInfo->szName);
-      hw_execute_bash_command(szComm, NULL);
+      hardware_radio_set_monitor_flags(pRadioHWInfo->szName, HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
       hardware_sleep_ms(uDelayMS);
       #endif
    }
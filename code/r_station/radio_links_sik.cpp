@@ -216,8 +216,7 @@ static void * _reinit_sik_thread_func(void *ignored_argument)
                    g_SiKRadiosState.iMustReconfigureSiKInterfaceIndex+1,
                    uTxPower, uDataRate, uECC, uLBT, uMCSTR);
                radio_stats_set_card_current_frequency(&g_SM_RadioStats, g_SiKRadiosState.iMustReconfigureSiKInterfaceIndex, uFreqKhz);
-               if ( NULL != g_pSM_RadioStats )
-                  memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+               g_SiKRadiosState.bMustPublishRadioStats = true;
             }
          }
       }
@@ -252,6 +251,13 @@ static void * _reinit_sik_thread_func(void *ignored_argument)
 
 int radio_links_check_reinit_sik_interfaces()
 {
+   if ( g_SiKRadiosState.bMustPublishRadioStats )
+   {
+      g_SiKRadiosState.bMustPublishRadioStats = false;
+      if ( NULL != g_pSM_RadioStats )
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+   }
+
    if ( g_SiKRadiosState.bConfiguringToolInProgress && (g_SiKRadiosState.uTimeStartConfiguring != 0) )
    if ( g_TimeNow >= g_SiKRadiosState.uTimeStartConfiguring+500 )
    {
@@ -78,6 +78,7 @@
 #include "radio_links.h"
 #include "radio_links_sik.h"
 #include "adaptive_video.h"
+#include "flight_recorder.h"
 
 u8 s_BufferCommands[MAX_PACKET_TOTAL_SIZE];
 u8 s_PipeBufferCommands[MAX_PACKET_TOTAL_SIZE];
@@ -385,7 +386,7 @@ void _compute_radio_interfaces_assignment()
       iCountAssignedVehicleRadioLinks = 1;
       g_SM_RadioStats.countLocalRadioLinks = 1;
       if ( NULL != g_pSM_RadioStats )
-         memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+         shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
       if ( 0 == iCountInterfacesAssigned )
          send_alarm_to_central(ALARM_ID_CONTROLLER_NO_INTERFACES_FOR_RADIO_LINK,iConnectFirstUsableRadioLinkId, 0);
       
@@ -551,7 +552,7 @@ void _compute_radio_interfaces_assignment()
    log_line("Assigned %d controller local radio links to vehicle radio links (vehicle has %d active radio links)", iCountAssignedVehicleRadioLinks, iCountVehicleActiveUsableRadioLinks);
    
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
    //---------------------------------------------------------------
    // Log errors
@@ -713,7 +714,7 @@ bool links_set_cards_frequencies_for_search( u32 uSearchFreq, bool bSiKSearch, i
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
    log_line("Links: Set all cards frequencies for search mode to %s. Completed.", str_format_frequency(uSearchFreq));
    return true;
 }
@@ -832,7 +833,7 @@ bool links_set_cards_frequencies_and_params(int iVehicleLinkId)
    }
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
    hardware_save_radio_info();
 
@@ -1087,7 +1088,7 @@ void init_shared_memory_objects()
       log_line("Opened shared mem to controller runtime info for writing.");
 
    if ( NULL != g_pSMControllerRTInfo )
-      memcpy((u8*)g_pSMControllerRTInfo, (u8*)&g_SMControllerRTInfo, sizeof(controller_runtime_info));
+      shared_mem_publish(g_pSMControllerRTInfo, &g_SMControllerRTInfo, sizeof(controller_runtime_info));
 
    g_pSMVehicleRTInfo = vehicle_rt_info_open_for_write();
    if ( NULL == g_pSMVehicleRTInfo )
@@ -1096,7 +1097,7 @@ void init_shared_memory_objects()
       log_line("Opened shared mem to vehicle runtime info for writing.");
 
    if ( NULL != g_pSMVehicleRTInfo )
-      memcpy((u8*)g_pSMVehicleRTInfo, (u8*)&g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
+      shared_mem_publish(g_pSMVehicleRTInfo, &g_SMVehicleRTInfo, sizeof(vehicle_runtime_info));
 
    g_pSM_RadioStats = shared_mem_radio_stats_open_for_write();
    if ( NULL == g_pSM_RadioStats )
@@ -1115,7 +1116,7 @@ void init_shared_memory_objects()
    radio_stats_reset(&g_SM_RadioStats, g_pControllerSettings->nGraphRadioRefreshInterval);
 
    if ( NULL != g_pSM_RadioStats )
-      memcpy((u8*)g_pSM_RadioStats, (u8*)&g_SM_RadioStats, sizeof(shared_mem_radio_stats));
+      shared_mem_publish(g_pSM_RadioStats, &g_SM_RadioStats, sizeof(shared_mem_radio_stats));
 
 
    if ( (NULL != g_pCurrentModel) && g_pCurrentModel->audio_params.has_audio_device && g_pCurrentModel->audio_params.enabled )
@@ -1279,20 +1280,34 @@ int _consume_ipc_messages()
 int _try_read_consume_rx_packets(bool bHighPriority, int iCountMax, u32 uTimeoutMicrosec)
 {
    int iCountConsumed = 0;
+   int iCountPackets = 0;
+   int iPacketIndex = 0;
+   type_received_radio_packet packets[20];
    int iPacketLength = 0;
-   int iPacketIsShort = 0;
    int iRadioInterfaceIndex = 0;
    u8* pPacket = NULL;
 
    while ( (iCountConsumed < iCountMax) && (!g_bQuit) )
    {
-      if ( bHighPriority )
-         pPacket = radio_rx_wait_get_next_received_high_prio_packet(uTimeoutMicrosec, &iPacketLength, &iPacketIsShort, &iRadioInterfaceIndex);
-      else
-         pPacket = radio_rx_wait_get_next_received_reg_prio_packet(uTimeoutMicrosec, &iPacketLength, &iPacketIsShort, &iRadioInterfaceIndex);
+      // Packets are processed in place in the rx queue slots, a batch at a time
+      if ( iPacketIndex >= iCountPackets )
+      {
+         int iCountToGet = iCountMax - iCountConsumed;
+         if ( iCountToGet > (int)(sizeof(packets)/sizeof(packets[0])) )
+            iCountToGet = (int)(sizeof(packets)/sizeof(packets[0]));
+         if ( bHighPriority )
+            iCountPackets = radio_rx_wait_get_next_received_high_prio_packets(packets, iCountToGet, uTimeoutMicrosec);
+         else
+            iCountPackets = radio_rx_wait_get_next_received_reg_prio_packets(packets, iCountToGet, uTimeoutMicrosec);
+         iPacketIndex = 0;
+         if ( iCountPackets <= 0 )
+            break;
+      }
+      pPacket = packets[iPacketIndex].pPacketData;
+      iPacketLength = packets[iPacketIndex].iPacketLength;
+      iRadioInterfaceIndex = packets[iPacketIndex].iPacketRxInterface;
+      iPacketIndex++;
 
-      if ( NULL == pPacket )
-         break;
       iCountConsumed++;
       if ( g_bQuit )
          break;
@@ -1342,6 +1357,10 @@ int _try_read_consume_rx_packets(bool bHighPriority, int iCountMax, u32 uTimeout
       }      
    }
 
+   if ( bHighPriority )
+      radio_rx_release_high_prio_packets();
+   else
+      radio_rx_release_reg_prio_packets();
    return iCountConsumed;
 }
 
@@ -1354,6 +1373,7 @@ void handle_sigint(int sig)
    log_line("--------------------------");
    log_line("Caught signal to stop: %d", sig);
    log_line("--------------------------");
+   log_flush();
    radio_rx_mark_quit();
    g_bQuit = true;
 } 
@@ -1581,6 +1601,7 @@ int main(int argc, char *argv[])
       log_line("Router started with the default model (first model pairing was never completed)");
 
    adaptive_video_init();
+   flight_recorder_init((NULL != g_pCurrentModel)?g_pCurrentModel->uVehicleId:0, g_TimeNow);
    video_processors_init();
    if ( ! g_bSearching )
    if ( g_pCurrentModel->audio_params.has_audio_device && g_pCurrentModel->audio_params.enabled )
@@ -1678,6 +1699,7 @@ int main(int argc, char *argv[])
    if ( is_audio_processing_started() )
       uninit_processing_audio();
 
+   flight_recorder_uninit();
    controller_rt_info_close(g_pSMControllerRTInfo);
    vehicle_rt_info_close(g_pSMVehicleRTInfo);
    
@@ -1942,6 +1964,9 @@ void _main_loop_simple(bool bDoBasicTxSync)
       s_iCountCPULoopOverflows = 0;
    }
 
+   if ( controller_rt_info_will_advance_index(&g_SMControllerRTInfo, g_TimeNow) )
+      flight_recorder_add_slice(&g_SMControllerRTInfo, g_TimeNow);
+
    if ( controller_rt_info_check_advance_index(&g_SMControllerRTInfo, g_TimeNow) )
    {
       radio_rx_set_packet_counter_output(&(g_SMControllerRTInfo.uRxHighPriorityPackets[g_SMControllerRTInfo.iCurrentIndex][0]),
@@ -2099,6 +2124,9 @@ void _main_loop_adv_sync()
       s_iCountCPULoopOverflows = 0;
    }
 
+   if ( controller_rt_info_will_advance_index(&g_SMControllerRTInfo, g_TimeNow) )
+      flight_recorder_add_slice(&g_SMControllerRTInfo, g_TimeNow);
+
    if ( controller_rt_info_check_advance_index(&g_SMControllerRTInfo, g_TimeNow) )
    {
       radio_rx_set_packet_counter_output(&(g_SMControllerRTInfo.uRxHighPriorityPackets[g_SMControllerRTInfo.iCurrentIndex][0]),
@@ -250,6 +250,7 @@ void handle_sigint(int sig)
    log_line("--------------------------");
    log_line("Caught signal to stop: %d", sig);
    log_line("--------------------------");
+   log_flush();
    g_bQuit = true;
 } 
 
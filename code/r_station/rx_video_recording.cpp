@@ -57,6 +57,7 @@
 #include "../base/hw_procs.h"
 #include "../base/ruby_ipc.h"
 #include "../base/parser_h264.h"
+#include "../base/mp4_muxer.h"
 #include "../base/camera_utils.h"
 #include "../common/string_utils.h"
 #include "../radio/radiolink.h"
@@ -85,6 +86,71 @@ u32 s_uRecordingStreamCurrentParsedToken = 0x11111111;
 u32 s_uRecordingStreamPrevParsedToken = 0x11111111;
 bool s_bRecordingFoundStartOfFirstNAL = false;
 
+// The recording is muxed to fragmented MP4 as it's received, by the recording thread (or inline if there is no thread)
+MP4Muxer s_MP4MuxerRecording;
+bool s_bStopRecordingThread = false;
+
+static void _rx_video_recording_get_stream_info(int* piWidth, int* piHeight, int* piFPS, int* piVideoType)
+{
+   *piWidth = 1280;
+   *piHeight = 720;
+   *piFPS = 0;
+   *piVideoType = VIDEO_TYPE_H264;
+   for( int i=0; i<MAX_VIDEO_PROCESSORS; i++ )
+   {
+      if( NULL == g_pVideoProcessorRxList[i] )
+         break;
+      if ( g_pCurrentModel->uVehicleId != g_pVideoProcessorRxList[i]->m_uVehicleId )
+         continue;
+      *piWidth = g_pVideoProcessorRxList[i]->getVideoWidth();
+      *piHeight = g_pVideoProcessorRxList[i]->getVideoHeight();
+      *piFPS = g_pVideoProcessorRxList[i]->getVideoFPS();
+      *piVideoType = g_pVideoProcessorRxList[i]->getVideoType();
+      log_line("[VideoRecording] Found info for VID %u: w/h/fps: %dx%d@%d, type: %d", g_pCurrentModel->uVehicleId, *piWidth, *piHeight, *piFPS, *piVideoType);
+      return;
+   }
+   log_softerror_and_alarm("[VideoRecording] Can't find processor rx video stream info for VID: %u", g_pCurrentModel->uVehicleId);
+}
+
+// Written when the recording starts too, so that a recording cut by a power loss is still stored on next start
+static void _rx_video_recording_write_info_file(int iDurationSec)
+{
+   int width, height, fps, iVideoType;
+   _rx_video_recording_get_stream_info(&width, &height, &fps, &iVideoType);
+
+   char szFile[128];
+   strcpy(szFile, FOLDER_RUBY_TEMP);
+   strcat(szFile, FILE_TEMP_VIDEO_FILE_INFO);
+   log_line("[VideoRecording] Writing video info file %s ...", szFile);
+   FILE* fd = fopen(szFile, "w");
+   if ( NULL == fd )
+   {
+      system("sudo mount -o remount,rw /");
+      char szTmp[128];
+      sprintf(szTmp, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_FILE_INFO);
+      hw_execute_bash_command(szTmp, NULL);
+      fd = fopen(szFile, "w");
+   }
+
+   if ( NULL == fd )
+   {
+      log_softerror_and_alarm("[VideoRecording] Failed to create video info file %s", szFile);
+      strcpy(szFile, FOLDER_RUBY_TEMP);
+      strcat(szFile, FILE_TEMP_VIDEO_FILE_PROCESS_ERROR);
+      fd = fopen(szFile, "a");
+      fprintf(fd, "%s\n", "Failed to create video recording info file.");
+      fclose(fd);
+      return;
+   }
+   fprintf(fd, "%s\n", s_szFileRecordingOutput);
+   fprintf(fd, "%d %d\n", fps, iDurationSec);
+   fprintf(fd, "%d %d\n", width, height);
+   fprintf(fd, "%d\n", iVideoType);
+   fclose(fd);
+
+   log_line("[VideoRecording] Video info file content: (%s, %d fps, %d seconds, %d x %d, type: %d)", s_szFileRecordingOutput, fps, iDurationSec, width, height, iVideoType);
+}
+
 
 void * _thread_video_recording(void *argument)
 {
@@ -116,6 +182,9 @@ void * _thread_video_recording(void *argument)
       }
       if ( iSelectResult == 0 )
       {
+         // Stop only after all the data in the pipe was muxed
+         if ( s_bStopRecordingThread )
+            break;
          hardware_sleep_ms(10);
          continue;
       }
@@ -127,16 +196,13 @@ void * _thread_video_recording(void *argument)
       }
       if ( iRead == 0 )
       {
+         if ( s_bStopRecordingThread )
+            break;
          hardware_sleep_ms(10);
          continue;
       }
 
-      int iRes = write(s_iFileVideoRecordingOutput, uRecBuffer, iRead);
-      if ( iRes == iRead )
-         continue;
-
-      // Error writing to recording file
-      log_softerror_and_alarm("[VideoRecording] Recording thread failed to write %d bytes to recording file, result: %d , error: %d (%s)", iRead, iRes, errno, strerror(errno));
+      s_MP4MuxerRecording.addData(uRecBuffer, iRead);
    }
 
    log_line("[VideoRecording] Exit recording thread.");
@@ -200,14 +266,14 @@ void rx_video_recording_start()
 
    s_uRecordingFileSize = 0;
    strcpy(s_szFileRecordingOutput, FOLDER_RUBY_TEMP);
-   strcat(s_szFileRecordingOutput, FILE_TEMP_VIDEO_FILE);
+   strcat(s_szFileRecordingOutput, FILE_TEMP_VIDEO_MP4_FILE);
 
    load_Preferences();
    Preferences* p = get_Preferences();
    if ( p->iVideoDestination == 1 )
    {
       strcpy(s_szFileRecordingOutput, FOLDER_TEMP_VIDEO_MEM);
-      strcat(s_szFileRecordingOutput, FILE_TEMP_VIDEO_MEM_FILE);
+      strcat(s_szFileRecordingOutput, FILE_TEMP_VIDEO_MP4_FILE);
       char szBuff[2048];
       char szTemp[1024];
    
@@ -228,7 +294,7 @@ void rx_video_recording_start()
    if ( s_iFileVideoRecordingOutput > 0 )
       close(s_iFileVideoRecordingOutput);
 
-   int iOpenFlags = O_CREAT | O_WRONLY;
+   int iOpenFlags = O_CREAT | O_WRONLY | O_TRUNC;
    //if ( RUBY_PIPES_EXTRA_FLAGS & O_NONBLOCK )
    //   iOpenFlags |= O_NONBLOCK;
    s_iFileVideoRecordingOutput = open(s_szFileRecordingOutput, iOpenFlags);
@@ -248,6 +314,15 @@ void rx_video_recording_start()
 
    log_line("[VideoRecording] Video recording file flags: %s", str_get_pipe_flags(fcntl(s_iFileVideoRecordingOutput, F_GETFL)));
 
+   if ( -1 != s_iFileVideoRecordingOutput )
+   {
+      int iWidth, iHeight, iFPS, iVideoType;
+      _rx_video_recording_get_stream_info(&iWidth, &iHeight, &iFPS, &iVideoType);
+      if ( ! s_MP4MuxerRecording.open(s_iFileVideoRecordingOutput, iVideoType, iWidth, iHeight, iFPS) )
+         log_softerror_and_alarm("[VideoRecording] Failed to open the MP4 muxer.");
+      _rx_video_recording_write_info_file(0);
+   }
+
    log_line("[VideoRecording] Recording started.");
    s_bRecording = true;
    s_TimeStartRecording = 0;
@@ -256,6 +331,7 @@ void rx_video_recording_start()
    s_bRecordingFoundStartOfFirstNAL = false;
 
    s_bRecordingUsingThread = true;
+   s_bStopRecordingThread = false;
    s_iPipeRecordingThreadWrite = -1;
    s_iPipeRecordingThreadRead = -1;
    int iRetries = 100;
@@ -309,7 +385,11 @@ void rx_video_recording_start()
 void rx_video_recording_stop()
 {
    if ( s_bRecordingUsingThread )
-       pthread_cancel(s_pThreadVideoRecording);
+   {
+      s_bStopRecordingThread = true;
+      pthread_join(s_pThreadVideoRecording, NULL);
+      s_bRecordingUsingThread = false;
+   }
 
    if ( -1 != s_iPipeRecordingThreadWrite )
    {
@@ -325,6 +405,9 @@ void rx_video_recording_stop()
    }
    s_iPipeRecordingThreadRead = -1;
 
+   if ( s_MP4MuxerRecording.isOpen() )
+      s_MP4MuxerRecording.close();
+
    if ( -1 != s_iFileVideoRecordingOutput )
       close(s_iFileVideoRecordingOutput);
    s_iFileVideoRecordingOutput = -1;
@@ -336,9 +419,9 @@ void rx_video_recording_stop()
       return;
    }
 
-   if ( (0 == s_TimeStartRecording) || (s_uRecordingFileSize < 10000) )
+   if ( (0 == s_TimeStartRecording) || (s_uRecordingFileSize < 10000) || (! s_MP4MuxerRecording.hasStarted()) )
    {
-      log_line("[VideoRecording] Not recorded anything as first NAL was not found (start time: %u) or size too small (recording size: %u bytes)", s_TimeStartRecording, s_uRecordingFileSize);
+      log_line("[VideoRecording] Not recorded anything as first NAL or keyframe was not found (start time: %u) or size too small (recording size: %u bytes)", s_TimeStartRecording, s_uRecordingFileSize);
       s_bRecording = false;
       s_uRecordingStreamCurrentParsedToken = 0x11111111;
       s_uRecordingStreamPrevParsedToken = 0x11111111;
@@ -349,6 +432,8 @@ void rx_video_recording_stop()
          char szComm[256];
          snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "rm -rf %s 2>/dev/null 1>/dev/null", s_szFileRecordingOutput);
          hw_execute_bash_command_silent(szComm, NULL);
+         snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "rm -rf %s%s 2>/dev/null 1>/dev/null", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_FILE_INFO);
+         hw_execute_bash_command_silent(szComm, NULL);
       }
       s_szFileRecordingOutput[0] = 0;
       log_line("[VideoRecording] Recording stopped.");
@@ -358,62 +443,7 @@ void rx_video_recording_stop()
    u32 duration_ms = get_current_timestamp_ms() - s_TimeStartRecording;
    log_line("[VideoRecording] Recording duration: %u ms (%u sec), total %u bytes", duration_ms, duration_ms/1000, s_uRecordingFileSize);
 
-   int width = 1280;
-   int height = 720;
-   int fps = 0;
-   int iVideoType = VIDEO_TYPE_H264;
-   for( int i=0; i<MAX_VIDEO_PROCESSORS; i++ )
-   {
-      if( NULL == g_pVideoProcessorRxList[i] )
-         break;
-      if ( g_pCurrentModel->uVehicleId != g_pVideoProcessorRxList[i]->m_uVehicleId )
-         continue;
-      width = g_pVideoProcessorRxList[i]->getVideoWidth();
-      height = g_pVideoProcessorRxList[i]->getVideoHeight();
-      fps = g_pVideoProcessorRxList[i]->getVideoFPS();
-      iVideoType = g_pVideoProcessorRxList[i]->getVideoType();
-      log_line("[VideoRecording] Found info for VID %u: w/h/fps: %dx%d@%d, type: %d", g_pCurrentModel->uVehicleId, width, height, fps, iVideoType);
-      break;
-   }
-   if ( 0 == width )
-      log_softerror_and_alarm("[VideoRecording] Can't find processor rx video stream info for VID: %u", g_pCurrentModel->uVehicleId);
-
-   char szFile[128];
-   strcpy(szFile, FOLDER_RUBY_TEMP);
-   strcat(szFile, FILE_TEMP_VIDEO_FILE_INFO);
-   log_line("[VideoRecording] Writing video info file %s ...", szFile);
-   FILE* fd = fopen(szFile, "w");
-   if ( NULL == fd )
-   {
-      system("sudo mount -o remount,rw /");
-      char szTmp[128];
-      sprintf(szTmp, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_FILE_INFO);
-      hw_execute_bash_command(szTmp, NULL);
-      fd = fopen(szFile, "w");
-   }
-
-   if ( NULL == fd )
-   {
-      log_softerror_and_alarm("[VideoRecording] Failed to create video info file %s", szFile);
-      strcpy(szFile, FOLDER_RUBY_TEMP);
-      strcat(szFile, FILE_TEMP_VIDEO_FILE_PROCESS_ERROR);
-      fd = fopen(szFile, "a");
-      fprintf(fd, "%s\n", "Failed to create video recording info file.");
-      fclose(fd);
-   }
-   else
-   {
-      fprintf(fd, "%s\n", s_szFileRecordingOutput);
-      fprintf(fd, "%d %d\n", fps, (int)(duration_ms/1000));
-      fprintf(fd, "%d %d\n", width, height);
-      fprintf(fd, "%d\n", iVideoType);
-      fclose(fd);
-   }
-
-   log_line("[VideoRecording] Created video info file %s, for resolution: %d x %d, %d fps, video type: %d",
-      szFile, width, height, fps, iVideoType);
-
-   log_line("[VideoRecording] Video info file content: (%s, %d fps, %d seconds, %d x %d, type: %d)", s_szFileRecordingOutput, fps, duration_ms/1000, width, height, iVideoType);
+   _rx_video_recording_write_info_file((int)(duration_ms/1000));
    hw_execute_bash_command("./ruby_video_proc &", NULL);
    s_bRecording = false;
    s_uRecordingFileSize = 0;
@@ -444,9 +474,14 @@ void rx_video_recording_on_new_data(u8* pData, int iLength)
          s_TimeStartRecording = get_current_timestamp_ms();
          u8 uHeader[5];
          uHeader[0] = 0; uHeader[1] = 0; uHeader[2] = 0; uHeader[3] = 0x01;
-         int iRes = write(s_iPipeRecordingThreadWrite, uHeader, 4);
-         if ( iRes != 4 )
-            log_softerror_and_alarm("[VideoRecording] Failed to write initial NAL header to recording file (%s), result: %d, error: %d (%s)", s_szFileRecordingOutput, iRes, errno, strerror(errno));
+         if ( (s_bRecordingUsingThread) && (s_iPipeRecordingThreadWrite > 0) )
+         {
+            int iRes = write(s_iPipeRecordingThreadWrite, uHeader, 4);
+            if ( iRes != 4 )
+               log_softerror_and_alarm("[VideoRecording] Failed to write initial NAL header to recording file (%s), result: %d, error: %d (%s)", s_szFileRecordingOutput, iRes, errno, strerror(errno));
+         }
+         else
+            s_MP4MuxerRecording.addData(uHeader, 4);
          break;
       }
    }
@@ -467,15 +502,7 @@ void rx_video_recording_on_new_data(u8* pData, int iLength)
          iLength, iRes, errno, strerror(errno));
    }
    else
-   {
-      int iRes = write(s_iFileVideoRecordingOutput, pData, iLength);
-      if ( iRes == iLength )
-         return;
-
-      // Error writing to recording file
-
-      log_softerror_and_alarm("[VideoRecording] Failed to write %d bytes to recording file, result: %d , error: %d (%s)", iLength, iRes, errno, strerror(errno));
-   }
+      s_MP4MuxerRecording.addData(pData, iLength);
 }
 
 void rx_video_recording_periodic_loop()
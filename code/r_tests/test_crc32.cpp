@@ -0,0 +1,164 @@
+#include "../base/base.h"
+#include "../base/crc32.h"
+#include "test_utils.h"
+
+// Tests the CRC32 kernels used by base_compute_crc32 against a bit by bit reference of the same polynomial,
+// on random buffers of every length from 0 to TEST_MAX_LENGTH bytes and at all alignments, then measures the throughput of each kernel.
+//
+// Usage: test_crc32 [-iterations N]
+
+#define TEST_MAX_LENGTH 1500
+#define TEST_BUFFER_SIZE (TEST_MAX_LENGTH + 64)
+
+static u32 _compute_crc32_reference(const u8* pBuffer, int iLength)
+{
+   u32 uCRC = ~0U;
+   for( int i=0; i<iLength; i++ )
+   {
+      uCRC ^= pBuffer[i];
+      for( int k=0; k<8; k++ )
+         uCRC = (uCRC >> 1) ^ ((uCRC & 1) ? 0xEDB88320 : 0);
+   }
+   return uCRC ^ ~0U;
+}
+
+static u32 _compute_crc32(int iKernel, const u8* pBuffer, int iLength)
+{
+   return crc32_update_with_kernel(iKernel, ~0U, pBuffer, iLength) ^ ~0U;
+}
+
+static void _test_known_values()
+{
+   printf("\nTesting known values:\n");
+   u8 uCheck[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+   _check(0xCBF43926 == _compute_crc32_reference(uCheck, sizeof(uCheck)), "reference check value");
+   _check(0xCBF43926 == base_compute_crc32(uCheck, sizeof(uCheck)), "base_compute_crc32 check value");
+   _check(0 == base_compute_crc32(uCheck, 0), "empty buffer");
+
+   u8 uPacket[64];
+   for( int i=0; i<(int)sizeof(uPacket); i++ )
+      uPacket[i] = rand() & 0xFF;
+   u32 uCRC = base_compute_crc32(uPacket + sizeof(u32), sizeof(uPacket) - sizeof(u32));
+   memcpy(uPacket, &uCRC, sizeof(u32));
+   _check(1 == base_check_crc32(uPacket, sizeof(uPacket)), "base_check_crc32 accepts valid buffer");
+   uPacket[20] ^= 0x10;
+   _check(0 == base_check_crc32(uPacket, sizeof(uPacket)), "base_check_crc32 rejects corrupted buffer");
+}
+
+static void _test_kernel(int iKernel)
+{
+   static u8 s_uBuffer[TEST_BUFFER_SIZE];
+   char szTest[128];
+
+   if ( ! crc32_kernel_is_supported(iKernel) )
+   {
+      printf("\nKernel %s is not supported on this CPU, skipped.\n", crc32_get_kernel_name(iKernel));
+      return;
+   }
+   printf("\nTesting kernel %s:\n", crc32_get_kernel_name(iKernel));
+
+   int iMismatches = 0;
+   for( int iLength=0; iLength<=TEST_MAX_LENGTH; iLength++ )
+   for( int iOffset=0; iOffset<16; iOffset++ )
+   {
+      for( int i=0; i<iLength; i++ )
+         s_uBuffer[iOffset+i] = rand() & 0xFF;
+      if ( _compute_crc32(iKernel, s_uBuffer+iOffset, iLength) != _compute_crc32_reference(s_uBuffer+iOffset, iLength) )
+      {
+         if ( 0 == iMismatches )
+            printf("  first mismatch at length %d, offset %d\n", iLength, iOffset);
+         iMismatches++;
+      }
+   }
+   snprintf(szTest, sizeof(szTest), "random buffers of 0 to %d bytes, all alignments (%d mismatches)", TEST_MAX_LENGTH, iMismatches);
+   _check(0 == iMismatches, szTest);
+
+   // A running CRC split at any point gives the same result
+   int iLength = TEST_MAX_LENGTH;
+   for( int i=0; i<iLength; i++ )
+      s_uBuffer[i] = rand() & 0xFF;
+   u32 uCRCRef = _compute_crc32_reference(s_uBuffer, iLength);
+   iMismatches = 0;
+   for( int iSplit=0; iSplit<=iLength; iSplit += 7 )
+   {
+      u32 uCRC = crc32_update_with_kernel(iKernel, ~0U, s_uBuffer, iSplit);
+      uCRC = crc32_update_with_kernel(iKernel, uCRC, s_uBuffer + iSplit, iLength - iSplit);
+      if ( (uCRC ^ ~0U) != uCRCRef )
+         iMismatches++;
+   }
+   _check(0 == iMismatches, "split buffers");
+
+   _check(1 == crc32_set_kernel(iKernel), "set as active kernel");
+   _check(base_compute_crc32(s_uBuffer, iLength) == uCRCRef, "base_compute_crc32 with this kernel");
+}
+
+static void _benchmark(int iIterations)
+{
+   static u8 s_uBuffer[TEST_BUFFER_SIZE];
+   int iSizes[] = { 64, 256, 1500 };
+
+   for( int i=0; i<TEST_BUFFER_SIZE; i++ )
+      s_uBuffer[i] = rand() & 0xFF;
+
+   printf("\nThroughput (MB/s, %d iterations):\n", iIterations);
+   printf("  kernel   %10d %10d %10d   speedup (1500 bytes)\n", iSizes[0], iSizes[1], iSizes[2]);
+   double fRefSpeed = 0.0;
+   for( int iKernel=0; iKernel<CRC32_KERNELS_COUNT; iKernel++ )
+   {
+      if ( ! crc32_kernel_is_supported(iKernel) )
+         continue;
+      printf("  %-8s", crc32_get_kernel_name(iKernel));
+      double fSpeed = 0.0;
+      u32 uSum = 0;
+      for( int k=0; k<3; k++ )
+      {
+         unsigned long long uTimeStart = _get_time_us();
+         for( int i=0; i<iIterations; i++ )
+            uSum += _compute_crc32(iKernel, s_uBuffer + (i & 7), iSizes[k]);
+         unsigned long long uTime = _get_time_us() - uTimeStart;
+         if ( 0 == uTime )
+            uTime = 1;
+         fSpeed = (double)iSizes[k] * (double)iIterations / (double)uTime;
+         printf(" %10.1f", fSpeed);
+      }
+      if ( iKernel == CRC32_KERNEL_TABLE )
+         fRefSpeed = fSpeed;
+      printf("   %.2fx (%08X)\n", fSpeed/fRefSpeed, uSum);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestCRC32");
+
+   int iIterations = 100000;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-iterations") )
+         iIterations = atoi(argv[i+1]);
+   }
+
+   srand(1234);
+   printf("Default CRC32 kernel: %s\n", crc32_get_kernel_name(crc32_get_kernel()));
+   int iDefaultKernel = crc32_get_kernel();
+
+   #if defined(__arm__) || defined(__aarch64__)
+   printf("\nTesting ARM build:\n");
+   _check(1 == crc32_armv8_is_built(), "ARMv8 CRC32 kernel is built in");
+   #endif
+
+   _test_known_values();
+   for( int iKernel=0; iKernel<CRC32_KERNELS_COUNT; iKernel++ )
+      _test_kernel(iKernel);
+   crc32_set_kernel(iDefaultKernel);
+
+   _benchmark(iIterations);
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nCRC32 test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nCRC32 test passed.\n");
+   return 0;
+}
@@ -0,0 +1,309 @@
+#include "../base/base.h"
+#include "../base/encr_aead.h"
+#include "test_utils.h"
+
+// Tests the ChaCha20-Poly1305 encryption used for the radio packets: the RFC 8439 known answers,
+// the SIMD kernels against the scalar one on all lengths up to a full radio packet, tampering detection,
+// then checks that the default kernel costs less per packet than the previous pass phrase XOR.
+//
+// Usage: test_encr [-iterations N]
+
+#define TEST_MAX_LENGTH 1500
+#define TEST_PACKET_LENGTH 1400
+
+static int _parse_hex(const char* szHex, u8* pOutput)
+{
+   int iCount = 0;
+   while ( szHex[0] && szHex[1] )
+   {
+      unsigned int uValue = 0;
+      sscanf(szHex, "%2x", &uValue);
+      pOutput[iCount++] = (u8)uValue;
+      szHex += 2;
+   }
+   return iCount;
+}
+
+static const char* s_szSunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+static void _test_known_answers()
+{
+   u8 uKey[AEAD_KEY_SIZE];
+   u8 uNonce[AEAD_NONCE_SIZE];
+   u8 uExpected[256];
+   u8 uBuffer[256];
+   u8 uTag[AEAD_TAG_SIZE];
+
+   printf("\nTesting RFC 8439 known answers:\n");
+
+   // 2.3.2: block function
+   for( int i=0; i<AEAD_KEY_SIZE; i++ )
+      uKey[i] = i;
+   _parse_hex("000000090000004a00000000", uNonce);
+   int iLength = _parse_hex(
+      "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+      "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e", uExpected);
+   for( int iKernel=0; iKernel<AEAD_KERNELS_COUNT; iKernel++ )
+   {
+      if ( ! aead_set_kernel(iKernel) )
+         continue;
+      char szTest[64];
+      memset(uBuffer, 0, sizeof(uBuffer));
+      aead_chacha20_xor(uKey, uNonce, 1, uBuffer, iLength);
+      snprintf(szTest, sizeof(szTest), "chacha20 block (%s)", aead_get_kernel_name(iKernel));
+      _check(0 == memcmp(uBuffer, uExpected, iLength), szTest);
+   }
+
+   // 2.5.2: Poly1305
+   _parse_hex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b", uKey);
+   _parse_hex("a8061dc1305136c6c22b8baf0c0127a9", uExpected);
+   const char* szMessage = "Cryptographic Forum Research Group";
+   aead_poly1305(uKey, (const u8*)szMessage, strlen(szMessage), uTag);
+   _check(0 == memcmp(uTag, uExpected, AEAD_TAG_SIZE), "poly1305");
+
+   // 2.8.2: AEAD
+   u8 uAAD[12];
+   _parse_hex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f", uKey);
+   _parse_hex("070000004041424344454647", uNonce);
+   _parse_hex("50515253c0c1c2c3c4c5c6c7", uAAD);
+   iLength = _parse_hex(
+      "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+      "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+      "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+      "3ff4def08e4b7a9de576d26586cec64b6116", uExpected);
+   u8 uExpectedTag[AEAD_TAG_SIZE];
+   _parse_hex("1ae10b594f09e26a7e902ecbd0600691", uExpectedTag);
+   _check(iLength == (int)strlen(s_szSunscreen), "test vector length");
+
+   for( int iKernel=0; iKernel<AEAD_KERNELS_COUNT; iKernel++ )
+   {
+      if ( ! aead_set_kernel(iKernel) )
+         continue;
+      char szTest[64];
+      memcpy(uBuffer, s_szSunscreen, iLength);
+      aead_seal(uKey, uNonce, uAAD, sizeof(uAAD), uBuffer, iLength, uTag);
+      snprintf(szTest, sizeof(szTest), "aead seal (%s)", aead_get_kernel_name(iKernel));
+      _check((0 == memcmp(uBuffer, uExpected, iLength)) && (0 == memcmp(uTag, uExpectedTag, AEAD_TAG_SIZE)), szTest);
+      snprintf(szTest, sizeof(szTest), "aead open (%s)", aead_get_kernel_name(iKernel));
+      int iOpened = aead_open(uKey, uNonce, uAAD, sizeof(uAAD), uBuffer, iLength, uTag);
+      _check((1 == iOpened) && (0 == memcmp(uBuffer, s_szSunscreen, iLength)), szTest);
+   }
+
+   // HChaCha20 (XChaCha20 draft, section 2.2.1)
+   _parse_hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", uKey);
+   _parse_hex("000000090000004a0000000031415927", uBuffer);
+   _parse_hex("82413b4227b27bfed30e42508a877d73a0f9e4d58a74a853c12ec41326d3ecdc", uExpected);
+   u8 uOutput[32];
+   aead_hchacha20(uKey, uBuffer, uOutput);
+   _check(0 == memcmp(uOutput, uExpected, 32), "hchacha20");
+}
+
+static void _test_kernels()
+{
+   static u8 s_uReference[TEST_MAX_LENGTH + 16];
+   static u8 s_uBuffer[TEST_MAX_LENGTH + 16];
+   u8 uKey[AEAD_KEY_SIZE];
+   u8 uNonce[AEAD_NONCE_SIZE];
+   u8 uTagReference[AEAD_TAG_SIZE];
+   u8 uTag[AEAD_TAG_SIZE];
+
+   for( int i=0; i<AEAD_KEY_SIZE; i++ )
+      uKey[i] = rand() & 0xFF;
+
+   for( int iKernel=1; iKernel<AEAD_KERNELS_COUNT; iKernel++ )
+   {
+      if ( ! aead_kernel_is_supported(iKernel) )
+      {
+         printf("\nKernel %s is not supported on this CPU, skipped.\n", aead_get_kernel_name(iKernel));
+         continue;
+      }
+      printf("\nTesting kernel %s against scalar:\n", aead_get_kernel_name(iKernel));
+      int iMismatches = 0;
+      for( int iLength=0; iLength<=TEST_MAX_LENGTH; iLength++ )
+      {
+         int iOffset = iLength & 15;
+         for( int i=0; i<AEAD_NONCE_SIZE; i++ )
+            uNonce[i] = rand() & 0xFF;
+         for( int i=0; i<iLength; i++ )
+            s_uReference[iOffset+i] = s_uBuffer[iOffset+i] = rand() & 0xFF;
+
+         aead_set_kernel(AEAD_KERNEL_SCALAR);
+         aead_seal(uKey, uNonce, uNonce, 8, s_uReference + iOffset, iLength, uTagReference);
+         aead_set_kernel(iKernel);
+         aead_seal(uKey, uNonce, uNonce, 8, s_uBuffer + iOffset, iLength, uTag);
+         if ( (0 != memcmp(s_uBuffer + iOffset, s_uReference + iOffset, iLength)) || (0 != memcmp(uTag, uTagReference, AEAD_TAG_SIZE)) )
+         {
+            if ( 0 == iMismatches )
+               printf("  first mismatch at length %d\n", iLength);
+            iMismatches++;
+         }
+      }
+      char szTest[128];
+      snprintf(szTest, sizeof(szTest), "random buffers of 0 to %d bytes (%d mismatches)", TEST_MAX_LENGTH, iMismatches);
+      _check(0 == iMismatches, szTest);
+   }
+   aead_set_kernel(AEAD_KERNEL_SCALAR);
+}
+
+static void _test_tampering()
+{
+   u8 uKey[AEAD_KEY_SIZE];
+   u8 uNonce[AEAD_NONCE_SIZE];
+   u8 uHeader[32];
+   u8 uPacket[TEST_PACKET_LENGTH];
+   u8 uPlain[TEST_PACKET_LENGTH];
+   u8 uTag[AEAD_TAG_SIZE];
+
+   printf("\nTesting tampering detection:\n");
+   for( int i=0; i<AEAD_KEY_SIZE; i++ )
+      uKey[i] = rand() & 0xFF;
+   for( int i=0; i<AEAD_NONCE_SIZE; i++ )
+      uNonce[i] = rand() & 0xFF;
+   for( int i=0; i<(int)sizeof(uHeader); i++ )
+      uHeader[i] = rand() & 0xFF;
+   for( int i=0; i<TEST_PACKET_LENGTH; i++ )
+      uPlain[i] = rand() & 0xFF;
+   memcpy(uPacket, uPlain, sizeof(uPacket));
+   aead_seal(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag);
+   _check(0 != memcmp(uPacket, uPlain, sizeof(uPacket)), "data is encrypted");
+
+   u8 uEncrypted[TEST_PACKET_LENGTH];
+   memcpy(uEncrypted, uPacket, sizeof(uPacket));
+
+   uPacket[700] ^= 0x01;
+   _check(0 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag), "modified data rejected");
+   uPacket[700] ^= 0x01;
+   _check(0 == memcmp(uPacket, uEncrypted, sizeof(uPacket)), "rejected data left unchanged");
+
+   uHeader[5] ^= 0x80;
+   _check(0 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag), "modified header rejected");
+   uHeader[5] ^= 0x80;
+
+   uNonce[11] ^= 0x01;
+   _check(0 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag), "different nonce rejected");
+   uNonce[11] ^= 0x01;
+
+   uTag[15] ^= 0x40;
+   _check(0 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag), "modified tag rejected");
+   uTag[15] ^= 0x40;
+
+   _check(0 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket) - 1, uTag), "truncated data rejected");
+
+   _check(1 == aead_open(uKey, uNonce, uHeader, sizeof(uHeader), uPacket, sizeof(uPacket), uTag), "valid packet accepted");
+   _check(0 == memcmp(uPacket, uPlain, sizeof(uPacket)), "valid packet decrypted");
+}
+
+// The previous radio packets encryption: XOR with the pass phrase
+static void _legacy_xor(u8* pData, int iLength, u8* pPass, int iPassLength)
+{
+   for( int iPos=0; iPos<iLength; iPos++ )
+   {
+      *pData = (*pData) ^ pPass[iPos % iPassLength];
+      pData++;
+   }
+}
+
+#define TEST_BENCHMARK_ROUNDS 5
+
+// Returns the best per packet cost (ns) over a few rounds: the other rounds are slowed down by the rest of the machine
+static double _benchmark_kernel(int iKernel, int iIterations, u8* pKey, u8* pPacket)
+{
+   u8 uNonce[AEAD_NONCE_SIZE];
+   u8 uHeader[24];
+   u8 uTag[AEAD_TAG_SIZE];
+   memset(uNonce, 0, sizeof(uNonce));
+   memset(uHeader, 0, sizeof(uHeader));
+   char szPass[] = "ruby-test-passphrase";
+   // The pass phrase length is only known at runtime, as in the radio code
+   volatile int iRuntimePassLength = strlen(szPass);
+
+   double fBest = 0.0;
+   for( int r=0; r<TEST_BENCHMARK_ROUNDS; r++ )
+   {
+      unsigned long long uTimeStart = _get_time_us();
+      if ( iKernel < 0 )
+      {
+         for( int i=0; i<iIterations; i++ )
+            _legacy_xor(pPacket, TEST_PACKET_LENGTH, (u8*)szPass, iRuntimePassLength);
+      }
+      else
+      {
+         aead_set_kernel(iKernel);
+         for( int i=0; i<iIterations; i++ )
+         {
+            uNonce[4] = i & 0xFF;
+            uNonce[5] = (i >> 8) & 0xFF;
+            aead_seal(pKey, uNonce, uHeader, sizeof(uHeader), pPacket, TEST_PACKET_LENGTH, uTag);
+         }
+      }
+      unsigned long long uTime = _get_time_us() - uTimeStart;
+      if ( 0 == uTime )
+         uTime = 1;
+      double fCost = (double)uTime * 1000.0 / (double)iIterations;
+      if ( (fBest <= 0.0) || (fCost < fBest) )
+         fBest = fCost;
+   }
+   return fBest;
+}
+
+static void _benchmark(int iIterations, int iDefaultKernel)
+{
+   static u8 s_uPacket[TEST_PACKET_LENGTH];
+   u8 uKey[AEAD_KEY_SIZE];
+
+   for( int i=0; i<TEST_PACKET_LENGTH; i++ )
+      s_uPacket[i] = rand() & 0xFF;
+   for( int i=0; i<AEAD_KEY_SIZE; i++ )
+      uKey[i] = rand() & 0xFF;
+
+   printf("\nPer packet cost, %d bytes packets, best of %d rounds of %d iterations:\n", TEST_PACKET_LENGTH, TEST_BENCHMARK_ROUNDS, iIterations);
+
+   double fLegacy = _benchmark_kernel(-1, iIterations, uKey, s_uPacket);
+   printf("  %-24s: %8.0f ns/packet, %7.1f MB/s\n", "legacy xor", fLegacy, (double)TEST_PACKET_LENGTH * 1000.0 / fLegacy);
+
+   double fDefault = 0.0;
+   for( int iKernel=0; iKernel<AEAD_KERNELS_COUNT; iKernel++ )
+   {
+      if ( ! aead_kernel_is_supported(iKernel) )
+         continue;
+      double fCost = _benchmark_kernel(iKernel, iIterations, uKey, s_uPacket);
+      if ( iKernel == iDefaultKernel )
+         fDefault = fCost;
+      char szName[64];
+      snprintf(szName, sizeof(szName), "chacha20-poly1305 %s", aead_get_kernel_name(iKernel));
+      printf("  %-24s: %8.0f ns/packet, %7.1f MB/s, %.2fx legacy%s\n", szName, fCost, (double)TEST_PACKET_LENGTH * 1000.0 / fCost, fLegacy/fCost, (iKernel == iDefaultKernel)?" (default)":"");
+   }
+
+   printf("\nChecking the per packet cost of the default kernel (%s):\n", aead_get_kernel_name(iDefaultKernel));
+   _check(fDefault < fLegacy, "cheaper than the legacy xor");
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestEncr");
+
+   int iIterations = 20000;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-iterations") )
+         iIterations = atoi(argv[i+1]);
+   }
+
+   srand(1234);
+   int iDefaultKernel = aead_get_kernel();
+   printf("Default kernel: %s\n", aead_get_kernel_name(iDefaultKernel));
+
+   _test_known_answers();
+   _test_kernels();
+   _test_tampering();
+   _benchmark(iIterations, iDefaultKernel);
+   aead_set_kernel(iDefaultKernel);
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nEncryption test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nEncryption test passed.\n");
+   return 0;
+}
@@ -1,95 +1,353 @@
 #include "../base/base.h"
 #include "../base/config.h"
-#include "../base/shared_mem.h"
-#include "../radio/radiolink.h"
 #include "../radio/radiopackets2.h"
 
 #include "../radio/fec.h"
 
-int packet_length = 32;
-int packets_per_block = 6;
-int fecs_per_block = 3;
+#include <time.h>
 
-#define MAX_PACKETS 64
+// FEC correctness and performance test.
+// Sweeps packet sizes, data/EC schemes and random erasure patterns for each
+// available GF kernel, checks every result against the scalar kernel and the
+// original data, and reports encode/reduce/invert/resolve times separately.
+// Must be built with PROFILE defined (see Makefile target test_fec).
+//
+// Usage: test_fec [-quick] [-iterations N]
 
+#define MAX_TEST_PACKETS 32
 
-u8* packetsArray[MAX_PACKETS];
-u8* fecsArray[MAX_PACKETS];
-u8* fecsForDecode[MAX_PACKETS];
+int s_iPacketSizes[] = { 64, 256, 512, 1024, 1250, MAX_PACKET_TOTAL_SIZE };
+int s_iSchemes[][2] = { {4,2}, {6,3}, {8,4}, {12,6}, {16,8}, {16,16}, {24,12}, {32,16}, {32,32} };
 
-void print_all()
+int s_iIterations = 200;
+bool s_bQuick = false;
+int s_iTotalErrors = 0;
+
+u8* s_pDataPackets[MAX_TEST_PACKETS];
+u8* s_pDecodePackets[MAX_TEST_PACKETS];
+u8* s_pECPackets[MAX_TEST_PACKETS];
+u8* s_pECPacketsReference[MAX_TEST_PACKETS];
+u8* s_pECPacketsForDecode[MAX_TEST_PACKETS];
+
+long long _now_nanos()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return ((long long)t.tv_sec) * 1000000000LL + (long long)t.tv_nsec;
+}
+
+double _mb_per_sec(long long lBytes, long long lNanos)
+{
+   if ( lNanos <= 0 )
+      return 0.0;
+   return ((double)lBytes * 1000.0) / (double)lNanos;
+}
+
+void _fill_random_data(int iDataPackets, int iPacketSize)
 {
-   for( int i=0; i<packets_per_block; i++ )
+   for( int i=0; i<iDataPackets; i++ )
+   for( int j=0; j<iPacketSize; j++ )
+      s_pDataPackets[i][j] = (u8)(rand() & 0xFF);
+}
+
+// Picks iErased distinct data packets (sorted, as fec_decode expects them) and as many distinct EC packets
+void _pick_erasure_pattern(int iDataPackets, int iECPackets, int iErased, unsigned int* pErased, unsigned int* pECIndexes)
+{
+   int iUsed[MAX_TEST_PACKETS];
+   memset(iUsed, 0, sizeof(iUsed));
+   int iCount = 0;
+   while ( iCount < iErased )
    {
-      printf("\nPacket %d: ", i);
-      for( int j=0; j<packet_length; j++ )
-         printf("%d,", packetsArray[i][j]); 
+      int k = rand() % iDataPackets;
+      if ( iUsed[k] )
+         continue;
+      iUsed[k] = 1;
+      iCount++;
    }
-   printf("\n");
-   for( int i=0; i<fecs_per_block; i++ )
+   iCount = 0;
+   for( int i=0; i<iDataPackets; i++ )
+      if ( iUsed[i] )
+         pErased[iCount++] = i;
+
+   memset(iUsed, 0, sizeof(iUsed));
+   iCount = 0;
+   while ( iCount < iErased )
    {
-      printf("\nFEC %d: ", i);
-      for( int j=0; j<packet_length; j++ )
-         printf("%d,", fecsArray[i][j]); 
+      int k = rand() % iECPackets;
+      if ( iUsed[k] )
+         continue;
+      iUsed[k] = 1;
+      iCount++;
    }
-   printf("\n");
+   iCount = 0;
+   for( int i=0; i<iECPackets; i++ )
+      if ( iUsed[i] )
+         pECIndexes[iCount++] = i;
 }
 
-int main(int argc, char *argv[])
+void _test_scheme(int iKernel, int iPacketSize, int iDataPackets, int iECPackets)
 {
-   printf("\nTesting FEC encode/decode\n");
+   int iIterations = s_iIterations;
+   if ( iIterations < 1 )
+      iIterations = 1;
+   int iErrors = 0;
 
-   fec_init();
+   _fill_random_data(iDataPackets, iPacketSize);
+
+   // Reference EC packets from the scalar kernel
+   fec_set_kernel(FEC_KERNEL_SCALAR);
+   fec_encode(iPacketSize, s_pDataPackets, iDataPackets, s_pECPacketsReference, iECPackets);
+   fec_set_kernel(iKernel);
+
+   // Encode
 
-   for( int i=0; i<packets_per_block; i++ )
+   long long lStart = _now_nanos();
+   for( int i=0; i<iIterations; i++ )
+      fec_encode(iPacketSize, s_pDataPackets, iDataPackets, s_pECPackets, iECPackets);
+   long long lEncodeNanos = _now_nanos() - lStart;
+
+   for( int i=0; i<iECPackets; i++ )
+   {
+      if ( 0 != memcmp(s_pECPackets[i], s_pECPacketsReference[i], iPacketSize) )
+      {
+         printf("  ERROR: EC packet %d differs from scalar reference (kernel %s, %d bytes, %d/%d)\n", i, fec_get_kernel_name(), iPacketSize, iDataPackets, iECPackets);
+         iErrors++;
+         break;
+      }
+   }
+
+   // Decode, with random erasure patterns taken from a small pool,
+   // as repeated patterns are what happens under steady interference
+
+   #define PATTERNS_POOL 8
+   unsigned int uErased[PATTERNS_POOL][MAX_TEST_PACKETS];
+   unsigned int uECIndexes[PATTERNS_POOL][MAX_TEST_PACKETS];
+   int iErasedCount[PATTERNS_POOL];
+   int iMaxErased = (iDataPackets < iECPackets)?iDataPackets:iECPackets;
+   for( int p=0; p<PATTERNS_POOL; p++ )
+   {
+      iErasedCount[p] = 1 + rand() % iMaxErased;
+      _pick_erasure_pattern(iDataPackets, iECPackets, iErasedCount[p], uErased[p], uECIndexes[p]);
+   }
+
+   fec_reset_decode_cache();
+   reduceTime = resolveTime = invTime = 0;
+   invCacheHits = invCacheMisses = 0;
+   long long lRecoveredPackets = 0;
+   long long lDecodeNanos = 0;
+
+   for( int i=0; i<iIterations; i++ )
    {
-      packetsArray[i] = (u8*)malloc(packet_length);
-      for( int j=0; j<packet_length; j++ )
-         packetsArray[i][j] = 32 + i + j;
+      int p = rand() % PATTERNS_POOL;
+      for( int k=0; k<iDataPackets; k++ )
+         memcpy(s_pDecodePackets[k], s_pDataPackets[k], iPacketSize);
+      for( int k=0; k<iErasedCount[p]; k++ )
+      {
+         memset(s_pDecodePackets[uErased[p][k]], 0, iPacketSize);
+         // fec_decode reduces the EC packets in place, so give it copies
+         memcpy(s_pECPacketsForDecode[k], s_pECPacketsReference[uECIndexes[p][k]], iPacketSize);
+      }
+      u8* pECs[MAX_TEST_PACKETS];
+      for( int k=0; k<iErasedCount[p]; k++ )
+         pECs[k] = s_pECPacketsForDecode[k];
+
+      lStart = _now_nanos();
+      fec_decode(iPacketSize, s_pDecodePackets, iDataPackets, pECs, uECIndexes[p], uErased[p], iErasedCount[p]);
+      lDecodeNanos += _now_nanos() - lStart;
+      lRecoveredPackets += iErasedCount[p];
+
+      for( int k=0; k<iDataPackets; k++ )
+      {
+         if ( 0 != memcmp(s_pDecodePackets[k], s_pDataPackets[k], iPacketSize) )
+         {
+            if ( iErrors < 5 )
+               printf("  ERROR: decoded packet %d is wrong (kernel %s, %d bytes, %d/%d, %d erased)\n", k, fec_get_kernel_name(), iPacketSize, iDataPackets, iECPackets, iErasedCount[p]);
+            iErrors++;
+            break;
+         }
+      }
    }
-   for( int i=0; i<fecs_per_block; i++ )
+
+   long long lEncodeBytes = (long long)iIterations * iDataPackets * iPacketSize;
+   long long lInvCount = invCacheMisses;
+   printf("  %4d bytes %2d/%-2d | enc %8.1f MB/s %7lld ns/pkt | dec %8.1f MB/s | reduce %7lld ns/blk, resolve %7lld ns/blk, invert %7lld ns/inv, cache %lld/%lld%s\n",
+      iPacketSize, iDataPackets, iECPackets,
+      _mb_per_sec(lEncodeBytes, lEncodeNanos), lEncodeNanos/((long long)iIterations*iDataPackets),
+      _mb_per_sec(lRecoveredPackets * iPacketSize, lDecodeNanos),
+      reduceTime/iIterations,
+      (resolveTime-invTime)/iIterations,
+      invTime/((lInvCount>0)?lInvCount:1),
+      invCacheHits, invCacheHits+invCacheMisses,
+      iErrors?"  FAILED":"");
+   s_iTotalErrors += iErrors;
+}
+
+int _compare_ec_to_reference(int iPacketSize, int iECPackets, const char* szTest)
+{
+   for( int i=0; i<iECPackets; i++ )
    {
-      fecsArray[i] = (u8*)malloc(packet_length);
+      if ( 0 != memcmp(s_pECPackets[i], s_pECPacketsReference[i], iPacketSize) )
+      {
+         printf("  ERROR: incremental encoder (%s) EC packet %d differs from fec_encode (kernel %s, %d bytes, %d EC)\n", szTest, i, fec_get_kernel_name(), iPacketSize, iECPackets);
+         return 1;
+      }
    }
+   return 0;
+}
 
-   print_all();
+// The incremental encoder used by the video tx buffers must give byte identical EC packets to
+// fec_encode() on the full block, whatever the order the data packets are added in, and after
+// already added packets are changed in place (as the video tx buffers do on the end of frame flags)
+void _test_incremental_encoder(int iKernel, int iPacketSize, int iDataPackets, int iECPackets)
+{
+   int iErrors = 0;
+   fec_encoder_state_t encoderState;
+   int iOrder[MAX_TEST_PACKETS];
+
+   fec_set_kernel(iKernel);
+   _fill_random_data(iDataPackets, iPacketSize);
+   fec_encode(iPacketSize, s_pDataPackets, iDataPackets, s_pECPacketsReference, iECPackets);
+
+   // In order
+
+   fec_encode_begin(&encoderState, iPacketSize, iDataPackets, s_pECPackets, iECPackets);
+   for( int i=0; i<iDataPackets; i++ )
+   {
+      if ( fec_encode_finish(&encoderState) )
+      {
+         printf("  ERROR: incremental encoder reports a complete block after %d of %d packets\n", i, iDataPackets);
+         iErrors++;
+      }
+      fec_encode_add_packet(&encoderState, i, s_pDataPackets[i]);
+   }
+   if ( ! fec_encode_finish(&encoderState) )
+   {
+      printf("  ERROR: incremental encoder does not report a complete block\n");
+      iErrors++;
+   }
+   iErrors += _compare_ec_to_reference(iPacketSize, iECPackets, "in order");
 
-   fec_encode(packet_length, packetsArray, packets_per_block, fecsArray, fecs_per_block);
+   // Out of order
 
-   printf("\nEncode result:\n");
-   print_all();
+   for( int i=0; i<iDataPackets; i++ )
+      iOrder[i] = i;
+   for( int i=iDataPackets-1; i>0; i-- )
+   {
+      int k = rand() % (i+1);
+      int iTmp = iOrder[i];
+      iOrder[i] = iOrder[k];
+      iOrder[k] = iTmp;
+   }
+   fec_encode_begin(&encoderState, iPacketSize, iDataPackets, s_pECPackets, iECPackets);
+   for( int i=0; i<iDataPackets; i++ )
+      fec_encode_add_packet(&encoderState, iOrder[i], s_pDataPackets[iOrder[i]]);
+   if ( ! fec_encode_finish(&encoderState) )
+   {
+      printf("  ERROR: incremental encoder does not report a complete block (out of order)\n");
+      iErrors++;
+   }
+   iErrors += _compare_ec_to_reference(iPacketSize, iECPackets, "out of order");
 
+   // Packets changed after being added, while the rest of the block is still being added
 
-   for( int j=0; j<packet_length; j++ )
-    {
-      packetsArray[2][j] = 0;
-      packetsArray[4][j] = 0;
-      fecsArray[1][j] = 0;
-    }
+   u8 uOldData[MAX_PACKET_TOTAL_SIZE];
+   fec_encode_begin(&encoderState, iPacketSize, iDataPackets, s_pECPackets, iECPackets);
+   for( int i=0; i<iDataPackets; i++ )
+   {
+      fec_encode_add_packet(&encoderState, iOrder[i], s_pDataPackets[iOrder[i]]);
 
-   printf("\nRandomised data:\n");
-   print_all();
+      int iChanged = iOrder[rand() % (i+1)];
+      int iOffset = rand() % iPacketSize;
+      int iLength = 1 + rand() % (iPacketSize - iOffset);
+      if ( (i % 2) == 0 )
+         iLength = 1;
+      memcpy(uOldData, &(s_pDataPackets[iChanged][iOffset]), iLength);
+      for( int k=0; k<iLength; k++ )
+         s_pDataPackets[iChanged][iOffset+k] = (u8)(rand() & 0xFF);
+      fec_encode_update_packet(&encoderState, iChanged, iOffset, uOldData, &(s_pDataPackets[iChanged][iOffset]), iLength);
+   }
+   fec_encode(iPacketSize, s_pDataPackets, iDataPackets, s_pECPacketsReference, iECPackets);
+   iErrors += _compare_ec_to_reference(iPacketSize, iECPackets, "updated packets");
 
-   //the following three fields are infos for fec_decode
-    unsigned int fec_block_nos[MAX_PACKETS];
-    unsigned int erased_blocks[MAX_PACKETS];
-    unsigned int nr_fec_blocks = 0;
+   if ( iErrors )
+      printf("  Incremental encoder %4d bytes %2d/%-2d: FAILED\n", iPacketSize, iDataPackets, iECPackets);
+   s_iTotalErrors += iErrors;
+}
 
-    erased_blocks[0] = 2;
-    fec_block_nos[0] = 0;
-    fecsForDecode[0] = fecsArray[0];
+int main(int argc, char *argv[])
+{
+   for( int i=1; i<argc; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-quick") )
+         s_bQuick = true;
+      if ( (0 == strcmp(argv[i], "-iterations")) && (i < argc-1) )
+      {
+         i++;
+         s_iIterations = atoi(argv[i]);
+      }
+   }
+   if ( s_bQuick )
+      s_iIterations = 10;
 
-    erased_blocks[1] = 4;
-    fec_block_nos[1] = 2;
-    fecsForDecode[1] = fecsArray[2];
+   srand((unsigned int)_now_nanos());
+   fec_init();
+   printf("\nTesting FEC encode/decode. Default kernel: %s, %d iterations per test.\n", fec_get_kernel_name(), s_iIterations);
+   int iDefaultKernel = fec_get_kernel();
 
-    nr_fec_blocks = 2;
+   for( int i=0; i<MAX_TEST_PACKETS; i++ )
+   {
+      s_pDataPackets[i] = (u8*)malloc(MAX_PACKET_TOTAL_SIZE);
+      s_pDecodePackets[i] = (u8*)malloc(MAX_PACKET_TOTAL_SIZE);
+      s_pECPackets[i] = (u8*)malloc(MAX_PACKET_TOTAL_SIZE);
+      s_pECPacketsReference[i] = (u8*)malloc(MAX_PACKET_TOTAL_SIZE);
+      s_pECPacketsForDecode[i] = (u8*)malloc(MAX_PACKET_TOTAL_SIZE);
+      if ( (NULL == s_pDataPackets[i]) || (NULL == s_pDecodePackets[i]) || (NULL == s_pECPackets[i]) || (NULL == s_pECPacketsReference[i]) || (NULL == s_pECPacketsForDecode[i]) )
+      {
+         printf("Failed to allocate memory.\n");
+         return -1;
+      }
+   }
 
-   fec_decode(packet_length, packetsArray, packets_per_block, fecsForDecode, fec_block_nos, erased_blocks, nr_fec_blocks );
+   int iKernels[] = { FEC_KERNEL_SCALAR, FEC_KERNEL_SSSE3, FEC_KERNEL_AVX2, FEC_KERNEL_NEON };
+   for( int k=0; k<(int)(sizeof(iKernels)/sizeof(iKernels[0])); k++ )
+   {
+      if ( ! fec_set_kernel(iKernels[k]) )
+         continue;
+      printf("\nKernel %s:\n", fec_get_kernel_name());
+      for( int s=0; s<(int)(sizeof(s_iSchemes)/sizeof(s_iSchemes[0])); s++ )
+      for( int p=0; p<(int)(sizeof(s_iPacketSizes)/sizeof(s_iPacketSizes[0])); p++ )
+      {
+         if ( s_bQuick && (s_iPacketSizes[p] != MAX_PACKET_TOTAL_SIZE) && (s_iPacketSizes[p] != 64) )
+            continue;
+         _test_scheme(iKernels[k], s_iPacketSizes[p], s_iSchemes[s][0], s_iSchemes[s][1]);
+      }
+   }
 
-   printf("\nDecoded data:\n");
-   print_all();
+   printf("\nTesting the incremental FEC encoder.\n");
+   for( int k=0; k<(int)(sizeof(iKernels)/sizeof(iKernels[0])); k++ )
+   {
+      if ( ! fec_set_kernel(iKernels[k]) )
+         continue;
+      for( int s=0; s<(int)(sizeof(s_iSchemes)/sizeof(s_iSchemes[0])); s++ )
+      for( int p=0; p<(int)(sizeof(s_iPacketSizes)/sizeof(s_iPacketSizes[0])); p++ )
+         _test_incremental_encoder(iKernels[k], s_iPacketSizes[p], s_iSchemes[s][0], s_iSchemes[s][1]);
+   }
 
+   // Later fec_init() calls (i.e. from the video tx buffers) must keep the kernel that was set
+   fec_set_kernel(FEC_KERNEL_SCALAR);
+   fec_init();
+   if ( fec_get_kernel() != FEC_KERNEL_SCALAR )
+   {
+      printf("\n  ERROR: fec_init() changed the selected kernel to %s\n", fec_get_kernel_name());
+      s_iTotalErrors++;
+   }
+   fec_set_kernel(iDefaultKernel);
 
-   return (0);
-} 
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nFEC test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nFEC test passed.\n");
+   return 0;
+}
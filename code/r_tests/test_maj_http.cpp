@@ -0,0 +1,250 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_cam_maj_http.h"
+#include "test_utils.h"
+
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Tests the majestic keep-alive HTTP client against a local stand-in HTTP server:
+// connection reuse, coalescing of changes queued while a request is in flight,
+// reconnect after the server closes the connection, chunked responses, retry of failed requests and latency stats.
+//
+// Usage: test_maj_http
+
+#define SERVER_RESPONSE_NORMAL 0
+#define SERVER_RESPONSE_CLOSE 1
+#define SERVER_RESPONSE_CHUNKED 2
+
+int s_iServerSocket = -1;
+int s_iServerPort = 0;
+volatile int s_iServerResponseMode = SERVER_RESPONSE_NORMAL;
+volatile int s_iServerDelayMs = 0;
+volatile int s_iServerFailRequests = 0;
+volatile int s_iServerConnections = 0;
+volatile int s_iServerRequests = 0;
+char s_szServerLastQuery[1024];
+pthread_mutex_t s_ServerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void _server_respond(int iSocket)
+{
+   const char* szBody = "{\"result\":\"ok\"}";
+   char szResponse[512];
+   int iLength = 0;
+   if ( s_iServerFailRequests > 0 )
+   {
+      s_iServerFailRequests--;
+      iLength = snprintf(szResponse, sizeof(szResponse), "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
+   }
+   else if ( s_iServerResponseMode == SERVER_RESPONSE_CHUNKED )
+      iLength = snprintf(szResponse, sizeof(szResponse), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n%x\r\n%s\r\n0\r\n\r\n", (int)strlen(szBody), szBody);
+   else
+      iLength = snprintf(szResponse, sizeof(szResponse), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\n%s\r\n%s",
+         (int)strlen(szBody), (s_iServerResponseMode == SERVER_RESPONSE_CLOSE)?"Connection: close\r\n":"", szBody);
+   send(iSocket, szResponse, iLength, MSG_NOSIGNAL);
+}
+
+static void* _server_thread(void* pParam)
+{
+   char szBuffer[4096];
+   while ( 1 )
+   {
+      int iSocket = accept(s_iServerSocket, NULL, NULL);
+      if ( iSocket < 0 )
+         return NULL;
+      s_iServerConnections++;
+      int iLength = 0;
+      while ( 1 )
+      {
+         int iRead = recv(iSocket, szBuffer + iLength, sizeof(szBuffer) - 1 - iLength, 0);
+         if ( iRead <= 0 )
+            break;
+         iLength += iRead;
+         szBuffer[iLength] = 0;
+         char* pEnd = strstr(szBuffer, "\r\n\r\n");
+         if ( NULL == pEnd )
+            continue;
+
+         pthread_mutex_lock(&s_ServerMutex);
+         char* pQuery = strchr(szBuffer, '?');
+         char* pQueryEnd = strstr(szBuffer, " HTTP/1.1");
+         s_szServerLastQuery[0] = 0;
+         if ( (NULL != pQuery) && (NULL != pQueryEnd) && (pQueryEnd > pQuery) )
+         {
+            memcpy(s_szServerLastQuery, pQuery+1, pQueryEnd - pQuery - 1);
+            s_szServerLastQuery[pQueryEnd - pQuery - 1] = 0;
+         }
+         s_iServerRequests++;
+         pthread_mutex_unlock(&s_ServerMutex);
+
+         if ( s_iServerDelayMs > 0 )
+            hardware_sleep_ms(s_iServerDelayMs);
+         _server_respond(iSocket);
+
+         // Keep any pipelined bytes after this request
+         int iConsumed = (pEnd + 4) - szBuffer;
+         memmove(szBuffer, pEnd + 4, iLength - iConsumed + 1);
+         iLength -= iConsumed;
+         if ( s_iServerResponseMode == SERVER_RESPONSE_CLOSE )
+            break;
+      }
+      close(iSocket);
+   }
+   return NULL;
+}
+
+static bool _start_server()
+{
+   s_iServerSocket = socket(AF_INET, SOCK_STREAM, 0);
+   if ( s_iServerSocket < 0 )
+      return false;
+   int iFlag = 1;
+   setsockopt(s_iServerSocket, SOL_SOCKET, SO_REUSEADDR, &iFlag, sizeof(iFlag));
+   struct sockaddr_in addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port = 0;
+   if ( 0 != bind(s_iServerSocket, (struct sockaddr*)&addr, sizeof(addr)) )
+      return false;
+   if ( 0 != listen(s_iServerSocket, 4) )
+      return false;
+   socklen_t iAddrLength = sizeof(addr);
+   getsockname(s_iServerSocket, (struct sockaddr*)&addr, &iAddrLength);
+   s_iServerPort = ntohs(addr.sin_port);
+
+   pthread_t pThread;
+   if ( 0 != pthread_create(&pThread, NULL, &_server_thread, NULL) )
+      return false;
+   pthread_detach(pThread);
+   return true;
+}
+
+static void _get_last_query(char* szOutput)
+{
+   pthread_mutex_lock(&s_ServerMutex);
+   strcpy(szOutput, s_szServerLastQuery);
+   pthread_mutex_unlock(&s_ServerMutex);
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestMajHttp");
+   log_enable_stdout();
+
+   if ( ! _start_server() )
+   {
+      printf("Failed to start the local HTTP server.\n");
+      return -1;
+   }
+   hardware_camera_maj_http_init("127.0.0.1", s_iServerPort);
+   printf("\nTesting majestic HTTP client against local server on port %d:\n", s_iServerPort);
+
+   char szQuery[1024];
+   t_maj_http_stats stats;
+
+   hardware_camera_maj_http_set_param_u32("video0.bitrate", 4000);
+   _check(hardware_camera_maj_http_wait_idle(2000), "single change completes");
+   _get_last_query(szQuery);
+   _check(0 == strcmp(szQuery, "video0.bitrate=4000"), "single change query");
+
+   for( int i=0; i<5; i++ )
+   {
+      hardware_camera_maj_http_set_param_int("video0.qpDelta", -i);
+      hardware_camera_maj_http_wait_idle(2000);
+   }
+   hardware_camera_maj_http_get_stats(&stats);
+   _check((6 == stats.uRequestsSent) && (1 == stats.uConnectionsOpened) && (1 == s_iServerConnections), "connection is kept alive");
+
+   // Changes queued while a request is in flight are merged into the next request
+   hardware_camera_maj_http_reset_stats();
+   s_iServerRequests = 0;
+   s_iServerDelayMs = 30;
+   for( int i=1; i<=200; i++ )
+   {
+      hardware_camera_maj_http_set_param_u32("video0.bitrate", 1000 + i);
+      if ( 0 == (i % 20) )
+         hardware_sleep_ms(5);
+   }
+   _check(hardware_camera_maj_http_wait_idle(5000), "burst completes");
+   hardware_camera_maj_http_get_stats(&stats);
+   _get_last_query(szQuery);
+   printf("  burst: 200 changes sent in %d requests, %u coalesced\n", s_iServerRequests, stats.uParamsCoalesced);
+   _check((s_iServerRequests < 20) && (stats.uParamsCoalesced > 150) && (0 == strcmp(szQuery, "video0.bitrate=1200")), "burst is coalesced, last value wins");
+   s_iServerDelayMs = 0;
+
+   hardware_camera_maj_http_set_param_u32("video0.bitrate", 6000);
+   hardware_camera_maj_http_set_param_int("video0.qpDelta", -12);
+   hardware_camera_maj_http_wait_idle(2000);
+   _get_last_query(szQuery);
+   _check((0 == strcmp(szQuery, "video0.bitrate=6000&video0.qpDelta=-12")) || (0 == strcmp(szQuery, "video0.qpDelta=-12")), "different params share a request");
+
+   // Server closes the connection after each response; the first request still uses the open connection
+   s_iServerResponseMode = SERVER_RESPONSE_CLOSE;
+   int iConnectionsBefore = s_iServerConnections;
+   hardware_camera_maj_http_reset_stats();
+   for( int i=0; i<3; i++ )
+   {
+      hardware_camera_maj_http_set_param_u32("image.luminance", 40+i);
+      hardware_camera_maj_http_wait_idle(2000);
+   }
+   hardware_camera_maj_http_get_stats(&stats);
+   _get_last_query(szQuery);
+   _check((3 == stats.uRequestsSent) && (0 == stats.uRequestsFailed) && (s_iServerConnections - iConnectionsBefore == 2) && (0 == strcmp(szQuery, "image.luminance=42")), "reconnects when server closes connection");
+
+   s_iServerResponseMode = SERVER_RESPONSE_CHUNKED;
+   hardware_camera_maj_http_reset_stats();
+   for( int i=0; i<3; i++ )
+   {
+      hardware_camera_maj_http_set_param_u32("image.contrast", 50+i);
+      hardware_camera_maj_http_wait_idle(2000);
+   }
+   hardware_camera_maj_http_get_stats(&stats);
+   _check((3 == stats.uRequestsSent) && (0 == stats.uRequestsFailed), "chunked responses");
+   _check((stats.uMinLatencyMicros > 0) && (stats.uMinLatencyMicros <= stats.uAvgLatencyMicros) && (stats.uAvgLatencyMicros <= stats.uMaxLatencyMicros), "latency stats");
+   printf("  latency min/avg/max: %u/%u/%u us\n", stats.uMinLatencyMicros, stats.uAvgLatencyMicros, stats.uMaxLatencyMicros);
+
+   // Failed requests are retried, unless a newer value for the same param was queued meanwhile
+   s_iServerResponseMode = SERVER_RESPONSE_NORMAL;
+   hardware_camera_maj_http_reset_stats();
+   s_iServerFailRequests = 2;
+   hardware_camera_maj_http_set_param_u32("video0.fps", 60);
+   _check(hardware_camera_maj_http_wait_idle(3000), "failed request is retried");
+   hardware_camera_maj_http_get_stats(&stats);
+   _get_last_query(szQuery);
+   _check((2 == stats.uRequestsFailed) && (2 == stats.uParamsRequeued) && (1 == stats.uRequestsSent) && (0 == stats.uParamsFailed) && (0 == strcmp(szQuery, "video0.fps=60")), "failed param is sent on retry");
+
+   hardware_camera_maj_http_reset_stats();
+   s_iServerFailRequests = 1;
+   s_iServerDelayMs = 50;
+   hardware_camera_maj_http_set_param_u32("video0.fps", 90);
+   hardware_sleep_ms(20);
+   hardware_camera_maj_http_set_param_u32("video0.fps", 120);
+   hardware_camera_maj_http_set_param_u32("video0.gop", 10);
+   _check(hardware_camera_maj_http_wait_idle(3000), "newer value after a failed request completes");
+   s_iServerDelayMs = 0;
+   hardware_camera_maj_http_get_stats(&stats);
+   _get_last_query(szQuery);
+   _check((1 == stats.uRequestsFailed) && (0 == stats.uParamsRequeued) && (0 == strcmp(szQuery, "video0.fps=120&video0.gop=10")), "failed value is not requeued over a newer one");
+
+   hardware_camera_maj_http_reset_stats();
+   s_iServerFailRequests = MAJ_HTTP_MAX_RETRIES + 1;
+   hardware_camera_maj_http_set_param_u32("video0.fps", 30);
+   _check(hardware_camera_maj_http_wait_idle(5000), "failing param is dropped after the max retries");
+   hardware_camera_maj_http_get_stats(&stats);
+   _check((MAJ_HTTP_MAX_RETRIES + 1 == stats.uRequestsFailed) && (MAJ_HTTP_MAX_RETRIES == stats.uParamsRequeued) && (1 == stats.uParamsFailed) && (0 == stats.uRequestsSent), "failed params stats");
+   s_iServerFailRequests = 0;
+
+   hardware_camera_maj_http_uninit();
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nMajestic HTTP client test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nMajestic HTTP client test passed.\n");
+   return 0;
+}
@@ -0,0 +1,121 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/models.h"
+#include "../base/models_binary.h"
+#include "test_utils.h"
+
+// Tests the binary model format: full save/load round trip, compressed transfer buffer,
+// section deltas, corrupted buffers and loading of text (version 10) model files.
+// Also compares the text and binary model files load times.
+//
+// Usage: test_model_binary
+
+static void _setup_model(Model* pModel)
+{
+   pModel->resetToDefaults(true);
+   strcpy(pModel->vehicle_name, "Test Drone");
+   pModel->uVehicleId = 123456;
+   pModel->uControllerId = 654321;
+   pModel->radioLinksParams.links_count = 1;
+   pModel->radioLinksParams.link_frequency_khz[0] = 5825000;
+   pModel->video_link_profiles[0].bitrate_fixed_bps = 7000000;
+   pModel->rc_params.inputSerialPortSpeed = 115200;
+   pModel->m_Stats.uTotalFlights = 12;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestModelBinary");
+   log_enable_stdout();
+
+   printf("\nTesting binary model format:\n");
+
+   Model model;
+   _setup_model(&model);
+
+   u8 uBuffer[MODEL_BINARY_MAX_SIZE];
+   int iLength = model.saveToBinaryBuffer(uBuffer, sizeof(uBuffer), false, NULL);
+   _check((iLength > 0) && model_binary_is_valid(uBuffer, iLength) && (! model_binary_is_delta(uBuffer, iLength)), "full binary buffer");
+
+   Model modelLoaded;
+   _check(modelLoaded.loadFromBinaryBuffer(uBuffer, iLength), "load full binary buffer");
+   _check(modelLoaded.getBinaryModelCRC() == model.getBinaryModelCRC(), "full round trip keeps all sections");
+   _check((0 == strcmp(modelLoaded.vehicle_name, "Test Drone")) && (modelLoaded.uVehicleId == 123456) &&
+          (modelLoaded.rc_params.inputSerialPortSpeed == 115200) && (modelLoaded.video_link_profiles[0].bitrate_fixed_bps == 7000000), "full round trip values");
+
+   u8 uCompressed[MODEL_BINARY_MAX_SIZE];
+   u8 uDecompressed[MODEL_BINARY_MAX_SIZE];
+   int iCompressedLength = model_binary_compress(uBuffer, iLength, uCompressed, sizeof(uCompressed));
+   int iDecompressedLength = model_binary_decompress(uCompressed, iCompressedLength, uDecompressed, sizeof(uDecompressed));
+   printf("  binary model: %d bytes, compressed: %d bytes\n", iLength, iCompressedLength);
+   _check((iCompressedLength > 0) && (iCompressedLength < iLength*2/3), "compressed model is smaller");
+   _check((iDecompressedLength == iLength) && (0 == memcmp(uBuffer, uDecompressed, iLength)), "compress round trip");
+
+   Model modelCompressed;
+   _check(modelCompressed.loadFromBinaryBuffer(uCompressed, iCompressedLength) && (modelCompressed.getBinaryModelCRC() == model.getBinaryModelCRC()), "load compressed buffer");
+
+   // Delta against the controller's copy
+   u32 uBaseCRCs[MODEL_BINARY_MAX_SECTIONS];
+   modelLoaded.getBinarySectionsCRCs(uBaseCRCs);
+   model.video_link_profiles[0].bitrate_fixed_bps = 9000000;
+   model.osd_params.iCurrentOSDLayout = 2;
+   int iDeltaLength = model.saveToBinaryBuffer(uBuffer, sizeof(uBuffer), false, uBaseCRCs);
+   t_model_binary_header* pHeader = (t_model_binary_header*)uBuffer;
+   printf("  delta for 2 changed sections: %d bytes\n", iDeltaLength);
+   _check(model_binary_is_delta(uBuffer, iDeltaLength) && (2 == pHeader->uSectionsCount), "delta has only the changed sections");
+
+   Model modelWrongBase;
+   _setup_model(&modelWrongBase);
+   modelWrongBase.telemetry_params.update_rate++;
+   _check(! modelWrongBase.loadFromBinaryBuffer(uBuffer, iDeltaLength), "delta on a different model is rejected");
+
+   _check(modelLoaded.loadFromBinaryBuffer(uBuffer, iDeltaLength) && (modelLoaded.getBinaryModelCRC() == model.getBinaryModelCRC()) &&
+          (modelLoaded.video_link_profiles[0].bitrate_fixed_bps == 9000000), "delta applied on the controller's copy");
+
+   iDeltaLength = model.saveToBinaryBuffer(uBuffer, sizeof(uBuffer), false, uBaseCRCs);
+   uBuffer[iDeltaLength-1] ^= 0x10;
+   _check(! model_binary_is_valid(uBuffer, iDeltaLength) && (! modelLoaded.loadFromBinaryBuffer(uBuffer, iDeltaLength)), "corrupted buffer is rejected");
+
+   // Files
+   char szFile[MAX_FILE_PATH_SIZE];
+   char szFileText[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, "/tmp/ruby_test_model.mdl");
+   strcpy(szFileText, "/tmp/ruby_test_model_text.mdl");
+
+   _check(model.saveToFile(szFile, false), "save binary file");
+   Model modelFile;
+   _check(modelFile.loadFromFile(szFile, true) && (modelFile.getLoadedFileVersion() == MODEL_BINARY_FILE_VERSION) &&
+          (modelFile.video_link_profiles[0].bitrate_fixed_bps == 9000000) && (modelFile.m_Stats.uTotalFlights == 12), "load binary file");
+   _check(modelFile.getSaveCount() == model.getSaveCount(), "save counter in binary file");
+
+   _check(model.exportToTextFile(szFileText, false), "export text file");
+   Model modelText;
+   _check(modelText.loadFromFile(szFileText, true) && (10 == modelText.getLoadedFileVersion()) &&
+          (modelText.uVehicleId == 123456) && (modelText.radioLinksParams.link_frequency_khz[0] == 5825000) &&
+          (modelText.m_Stats.uTotalFlights == 12) && (modelText.rc_params.inputSerialPortSpeed == 115200), "load text version 10 file");
+
+   int iCount = 200;
+   log_disable_stdout();
+   u32 uTimeStart = get_current_timestamp_micros();
+   for( int i=0; i<iCount; i++ )
+      modelText.loadFromFile(szFileText, true);
+   u32 uTimeText = get_current_timestamp_micros() - uTimeStart;
+   uTimeStart = get_current_timestamp_micros();
+   for( int i=0; i<iCount; i++ )
+      modelText.loadFromFile(szFile, true);
+   u32 uTimeBinary = get_current_timestamp_micros() - uTimeStart;
+   log_enable_stdout();
+   printf("  load time: text: %u us, binary: %u us\n", uTimeText/iCount, uTimeBinary/iCount);
+
+   unlink(szFile);
+   unlink("/tmp/ruby_test_model.bak");
+   unlink(szFileText);
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nBinary model test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nBinary model test passed.\n");
+   return 0;
+}
@@ -0,0 +1,306 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/flags_video.h"
+#include "../base/mp4_muxer.h"
+#include "test_utils.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Tests the fragmented MP4 muxer used for video recordings: muxes synthetic H264 and H265 streams fed in
+// random sized chunks, checks the boxes layout, alignment and samples tables, extracts the stream back and
+// compares it with the input. Also extracts from a file cut in the middle, as after a power loss.
+//
+// Usage: test_mp4_muxer [-frames N]
+
+#define TEST_FILE_MP4 "/tmp/test_mp4_muxer.mp4"
+#define TEST_FILE_CUT_MP4 "/tmp/test_mp4_muxer_cut.mp4"
+#define TEST_FILE_ES "/tmp/test_mp4_muxer.h26x"
+
+static u32 _get32(const u8* pData)
+{
+   return (((u32)pData[0]) << 24) | (((u32)pData[1]) << 16) | (((u32)pData[2]) << 8) | ((u32)pData[3]);
+}
+
+typedef struct
+{
+   u8* pData;
+   int iLength;
+   int iSize;
+} t_test_buffer;
+
+static void _append(t_test_buffer* pBuffer, const u8* pData, int iLength)
+{
+   if ( pBuffer->iLength + iLength > pBuffer->iSize )
+   {
+      pBuffer->iSize = (pBuffer->iLength + iLength) * 2;
+      pBuffer->pData = (u8*) realloc(pBuffer->pData, pBuffer->iSize);
+   }
+   memcpy(pBuffer->pData + pBuffer->iLength, pData, iLength);
+   pBuffer->iLength += iLength;
+}
+
+// Appends a NAL: start code, header bytes, then payload bytes without zeros (no start code emulation)
+static void _append_nal(t_test_buffer* pBuffer, const u8* pHeader, int iHeaderLength, int iPayloadLength)
+{
+   static const u8 uStartCode[4] = { 0, 0, 0, 1 };
+   _append(pBuffer, uStartCode, 4);
+   _append(pBuffer, pHeader, iHeaderLength);
+   u8 uPayload[256];
+   while ( iPayloadLength > 0 )
+   {
+      int iChunk = (iPayloadLength > (int)sizeof(uPayload))?(int)sizeof(uPayload):iPayloadLength;
+      for( int i=0; i<iChunk; i++ )
+         uPayload[i] = (u8)(1 + (rand() % 255));
+      _append(pBuffer, uPayload, iChunk);
+      iPayloadLength -= iChunk;
+   }
+}
+
+// Builds a stream that starts with garbage and frames before the first keyframe (dropped by the muxer).
+// Returns the number of frames from the first keyframe on; *piKeptOffset is where those frames start in the stream.
+static int _build_stream(t_test_buffer* pStream, int iVideoType, int iFrames, int* piKeptOffset)
+{
+   static const u8 uGarbage[5] = { 0x12, 0x34, 0x00, 0x56, 0x78 };
+   static const u8 uH264SPS[8] = { 0x67, 0x64, 0x00, 0x28, 0xAC, 0xD9, 0x40, 0x78 };
+   static const u8 uH264PPS[4] = { 0x68, 0xEE, 0x3C, 0x80 };
+   static const u8 uH264IDR[2] = { 0x65, 0x88 };
+   static const u8 uH264P[2] = { 0x41, 0x9A };
+   static const u8 uH264PSecondSlice[2] = { 0x41, 0x40 };
+   static const u8 uH265VPS[4] = { 0x40, 0x01, 0x0C, 0x01 };
+   static const u8 uH265SPS[16] = { 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03 };
+   static const u8 uH265PPS[3] = { 0x44, 0x01, 0xC1 };
+   static const u8 uH265IDR[3] = { 0x26, 0x01, 0xAF };
+   static const u8 uH265P[3] = { 0x02, 0x01, 0xD0 };
+   static const u8 uH265PSecondSlice[3] = { 0x02, 0x01, 0x40 };
+   bool bH265 = (iVideoType == VIDEO_TYPE_H265);
+
+   _append(pStream, uGarbage, sizeof(uGarbage));
+   _append_nal(pStream, bH265?uH265P:uH264P, bH265?3:2, 500);
+   _append_nal(pStream, bH265?uH265P:uH264P, bH265?3:2, 500);
+   *piKeptOffset = pStream->iLength;
+
+   for( int i=0; i<iFrames; i++ )
+   {
+      if ( 0 == (i % 30) )
+      {
+         if ( bH265 )
+            _append_nal(pStream, uH265VPS, sizeof(uH265VPS), 20);
+         if ( bH265 )
+            _append_nal(pStream, uH265SPS, sizeof(uH265SPS), 30);
+         else
+            _append_nal(pStream, uH264SPS, sizeof(uH264SPS), 0);
+         if ( bH265 )
+            _append_nal(pStream, uH265PPS, sizeof(uH265PPS), 4);
+         else
+            _append_nal(pStream, uH264PPS, sizeof(uH264PPS), 0);
+         _append_nal(pStream, bH265?uH265IDR:uH264IDR, bH265?3:2, 20000 + rand()%20000);
+         continue;
+      }
+      _append_nal(pStream, bH265?uH265P:uH264P, bH265?3:2, 1000 + rand()%8000);
+      if ( 0 == (i % 7) )
+         _append_nal(pStream, bH265?uH265PSecondSlice:uH264PSecondSlice, bH265?3:2, 2000);
+   }
+   return iFrames;
+}
+
+static bool _read_file(const char* szFile, t_test_buffer* pBuffer)
+{
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+      return false;
+   u8 uBuffer[65536];
+   int iRead = 0;
+   while ( (iRead = fread(uBuffer, 1, sizeof(uBuffer), fd)) > 0 )
+      _append(pBuffer, uBuffer, iRead);
+   fclose(fd);
+   return true;
+}
+
+static void _test_stream(int iVideoType, int iFrames)
+{
+   bool bH265 = (iVideoType == VIDEO_TYPE_H265);
+   printf("\nTesting %s stream, %d frames:\n", bH265?"H265":"H264", iFrames);
+
+   t_test_buffer stream = { NULL, 0, 0 };
+   int iKeptOffset = 0;
+   int iKeptFrames = _build_stream(&stream, iVideoType, iFrames, &iKeptOffset);
+
+   unlink(TEST_FILE_MP4);
+   int iFile = open(TEST_FILE_MP4, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+   _check(iFile >= 0, "create output file");
+   if ( iFile < 0 )
+      return;
+
+   MP4Muxer muxer;
+   _check(muxer.open(iFile, iVideoType, 1280, 720, 30), "open muxer");
+   long long llStart = get_current_timestamp_micros();
+   int iPos = 0;
+   while ( iPos < stream.iLength )
+   {
+      int iChunk = 1 + (rand() % 3000);
+      if ( iChunk > stream.iLength - iPos )
+         iChunk = stream.iLength - iPos;
+      muxer.addData(stream.pData + iPos, iChunk);
+      iPos += iChunk;
+   }
+   muxer.close();
+   long long llDuration = get_current_timestamp_micros() - llStart;
+   close(iFile);
+   printf("  muxed %d bytes in %lld us (%.1f MB/s, including a sync per fragment)\n", stream.iLength, llDuration, (llDuration > 0)?((double)stream.iLength/(double)llDuration):0.0);
+
+   _check(muxer.hasStarted(), "header written");
+   _check((int)muxer.getWrittenFramesCount() == iKeptFrames, "all frames from the first keyframe written");
+
+   t_test_buffer file = { NULL, 0, 0 };
+   _check(_read_file(TEST_FILE_MP4, &file), "read output file");
+   _check((file.iLength > 0) && (0 == (file.iLength % MP4_MUXER_WRITE_ALIGNMENT)), "file size is aligned");
+   _check((u32)file.iLength == muxer.getWrittenBytesCount(), "written bytes count");
+
+   // Walk the top level boxes
+   bool bLayoutOk = true;
+   bool bAlignedFragments = true;
+   bool bSamplesMatchData = true;
+   bool bFirstSampleIsKeyframe = false;
+   bool bFoundCodecConfig = false;
+   int iTotalSamples = 0;
+   int iFragments = 0;
+   u32 uLastSamplesSize = 0;
+   int iPosBox = 0;
+   int iIndex = 0;
+   while ( iPosBox + 8 <= file.iLength )
+   {
+      u32 uSize = _get32(file.pData + iPosBox);
+      const char* szType = (const char*)(file.pData + iPosBox + 4);
+      if ( (uSize < 8) || (iPosBox + (int)uSize > file.iLength) )
+      {
+         bLayoutOk = false;
+         break;
+      }
+      if ( (0 == iIndex) && (0 != memcmp(szType, "ftyp", 4)) )
+         bLayoutOk = false;
+      if ( (1 == iIndex) && (0 != memcmp(szType, "moov", 4)) )
+         bLayoutOk = false;
+      if ( 0 == memcmp(szType, "moov", 4) )
+      {
+         for( u32 u=8; u+4<uSize; u++ )
+            if ( 0 == memcmp(file.pData + iPosBox + u, bH265?"hvcC":"avcC", 4) )
+               bFoundCodecConfig = true;
+      }
+      if ( 0 == memcmp(szType, "moof", 4) )
+      {
+         iFragments++;
+         if ( 0 != (iPosBox % MP4_MUXER_WRITE_ALIGNMENT) )
+            bAlignedFragments = false;
+         // moof: mfhd (16 bytes), traf: tfhd (16 bytes), tfdt (20 bytes), trun
+         u8* pTRUN = file.pData + iPosBox + 8 + 16 + 8 + 16 + 20;
+         if ( 0 != memcmp(pTRUN + 4, "trun", 4) )
+            bLayoutOk = false;
+         else
+         {
+            int iSamples = (int)_get32(pTRUN + 12);
+            u32 uDataOffset = _get32(pTRUN + 16);
+            if ( uDataOffset != uSize + 8 )
+               bLayoutOk = false;
+            uLastSamplesSize = 0;
+            for( int i=0; i<iSamples; i++ )
+            {
+               uLastSamplesSize += _get32(pTRUN + 20 + 8*i);
+               u32 uFlags = _get32(pTRUN + 24 + 8*i);
+               if ( (0 == iTotalSamples) && (0 == i) )
+                  bFirstSampleIsKeyframe = (uFlags == 0x02000000);
+            }
+            iTotalSamples += iSamples;
+         }
+      }
+      if ( 0 == memcmp(szType, "mdat", 4) )
+      if ( uSize - 8 != uLastSamplesSize )
+         bSamplesMatchData = false;
+      iPosBox += uSize;
+      iIndex++;
+   }
+   printf("  file: %d bytes, %d fragments, %d samples, overhead: %.2f%%\n", file.iLength, iFragments, iTotalSamples, 100.0*(double)(file.iLength - (stream.iLength - iKeptOffset))/(double)file.iLength);
+   _check(bLayoutOk && (iPosBox == file.iLength), "boxes layout");
+   _check(bFoundCodecConfig, "codec configuration box");
+   _check(bAlignedFragments, "fragments are aligned");
+   _check(bSamplesMatchData, "samples sizes match the data");
+   _check(iTotalSamples == iKeptFrames, "samples count");
+   _check(bFirstSampleIsKeyframe, "first sample is a keyframe");
+   _check(mp4_muxer_get_frames_count(TEST_FILE_MP4) == iKeptFrames, "frames count from file");
+
+   // Extract back: the parameter sets from the codec configuration, then the stream from the first keyframe on
+   int iNALs = mp4_muxer_extract_video_stream(TEST_FILE_MP4, TEST_FILE_ES);
+   t_test_buffer extracted = { NULL, 0, 0 };
+   _read_file(TEST_FILE_ES, &extracted);
+   t_test_buffer expected = { NULL, 0, 0 };
+   int iParamSetsLength = 0;
+   int iParamSets = 0;
+   for( int i=iKeptOffset; i<stream.iLength; )
+   {
+      // Length of this NAL, up to the next start code
+      int iEnd = i+4;
+      while ( (iEnd + 4 <= stream.iLength) && (0 != memcmp(stream.pData + iEnd, "\0\0\0\1", 4)) )
+         iEnd++;
+      if ( iEnd + 4 > stream.iLength )
+         iEnd = stream.iLength;
+      u8 uType = bH265?((stream.pData[i+4] >> 1) & 0x3F):(stream.pData[i+4] & 0x1F);
+      bool bParamSet = bH265?((uType >= 32) && (uType <= 34)):((uType == 7) || (uType == 8));
+      if ( ! bParamSet )
+         break;
+      iParamSetsLength = iEnd - iKeptOffset;
+      iParamSets++;
+      i = iEnd;
+   }
+   _append(&expected, stream.pData + iKeptOffset, iParamSetsLength);
+   _append(&expected, stream.pData + iKeptOffset, stream.iLength - iKeptOffset);
+   _check((iNALs > iParamSets) && (extracted.iLength == expected.iLength) && (0 == memcmp(extracted.pData, expected.pData, expected.iLength)), "extracted stream matches the input");
+
+   // Cut the file in the middle of a fragment, as after a power loss
+   FILE* fd = fopen(TEST_FILE_CUT_MP4, "wb");
+   if ( NULL != fd )
+   {
+      fwrite(file.pData, 1, file.iLength/2 + 1234, fd);
+      fclose(fd);
+   }
+   int iFramesCut = mp4_muxer_get_frames_count(TEST_FILE_CUT_MP4);
+   _check((iFramesCut > 0) && (iFramesCut < iKeptFrames), "frames count from cut file");
+   int iNALsCut = mp4_muxer_extract_video_stream(TEST_FILE_CUT_MP4, TEST_FILE_ES);
+   t_test_buffer extractedCut = { NULL, 0, 0 };
+   _read_file(TEST_FILE_ES, &extractedCut);
+   _check((iNALsCut > 0) && (iNALsCut < iNALs) && (extractedCut.iLength > 0) && (0 == memcmp(extractedCut.pData, expected.pData, extractedCut.iLength)), "cut file keeps the complete fragments");
+
+   free(stream.pData);
+   free(file.pData);
+   free(extracted.pData);
+   free(expected.pData);
+   free(extractedCut.pData);
+   unlink(TEST_FILE_MP4);
+   unlink(TEST_FILE_CUT_MP4);
+   unlink(TEST_FILE_ES);
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestMP4Muxer");
+
+   int iFrames = 600;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-frames") )
+         iFrames = atoi(argv[i+1]);
+   }
+   if ( iFrames < 60 )
+      iFrames = 60;
+
+   srand(1234);
+   _test_stream(VIDEO_TYPE_H264, iFrames);
+   _test_stream(VIDEO_TYPE_H265, iFrames);
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nMP4 muxer test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nMP4 muxer test passed.\n");
+   return 0;
+}
@@ -0,0 +1,292 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_radio_nl80211.h"
+#include "test_utils.h"
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <net/if.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+// Tests the nl80211/rtnetlink radio configuration client against a mock netlink peer
+// (SOCK_SEQPACKET socketpairs), checking the generated requests for each operation
+// and the parsing of the wiphy channels dump.
+// Uses the loopback interface, as the client resolves interface names to indexes.
+//
+// Usage: test_nl80211
+
+#define MOCK_FAMILY_ID 0x22
+
+int s_iMockGenericFd = -1;
+int s_iMockRouteFd = -1;
+int s_iLoopbackIndex = 0;
+
+// Last request received by the mock peer
+u8 s_uLastCommand = 0;
+u16 s_uLastType = 0;
+u32 s_uLastIfIndex = 0;
+u32 s_uLastFreq = 0;
+u32 s_uLastChannelType = 0;
+u32 s_uLastIfType = 0;
+u32 s_uLastMonitorFlags = 0;
+int s_iLastHasMonitorFlags = 0;
+u32 s_uLastLinkFlags = 0;
+u32 s_uLastLinkChange = 0;
+int s_iMockErrorToReturn = 0;
+
+static void _mock_send_reply(int iFd, struct nlmsghdr* pRequest, int iError)
+{
+   u8 uBuffer[256];
+   memset(uBuffer, 0, sizeof(uBuffer));
+   struct nlmsghdr* pReply = (struct nlmsghdr*)uBuffer;
+   pReply->nlmsg_len = NLMSG_LENGTH(sizeof(struct nlmsgerr));
+   pReply->nlmsg_type = NLMSG_ERROR;
+   pReply->nlmsg_seq = pRequest->nlmsg_seq;
+   struct nlmsgerr* pError = (struct nlmsgerr*)NLMSG_DATA(pReply);
+   pError->error = iError;
+   memcpy(&pError->msg, pRequest, sizeof(struct nlmsghdr));
+   send(iFd, uBuffer, pReply->nlmsg_len, 0);
+}
+
+static void _mock_send_family(int iFd, struct nlmsghdr* pRequest)
+{
+   u8 uBuffer[256];
+   memset(uBuffer, 0, sizeof(uBuffer));
+   struct nlmsghdr* pReply = (struct nlmsghdr*)uBuffer;
+   pReply->nlmsg_type = GENL_ID_CTRL;
+   pReply->nlmsg_seq = pRequest->nlmsg_seq;
+   struct genlmsghdr* pGenl = (struct genlmsghdr*)NLMSG_DATA(pReply);
+   pGenl->cmd = CTRL_CMD_NEWFAMILY;
+   struct nlattr* pAttr = (struct nlattr*)(((u8*)pGenl) + GENL_HDRLEN);
+   pAttr->nla_type = CTRL_ATTR_FAMILY_ID;
+   pAttr->nla_len = NLA_HDRLEN + sizeof(u16);
+   u16 uFamily = MOCK_FAMILY_ID;
+   memcpy(((u8*)pAttr) + NLA_HDRLEN, &uFamily, sizeof(u16));
+   pReply->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_ALIGN(pAttr->nla_len));
+   // Family reply followed by the ack, in the same datagram
+   int iLength = NLMSG_ALIGN(pReply->nlmsg_len);
+   struct nlmsghdr* pAck = (struct nlmsghdr*)(uBuffer + iLength);
+   pAck->nlmsg_len = NLMSG_LENGTH(sizeof(struct nlmsgerr));
+   pAck->nlmsg_type = NLMSG_ERROR;
+   pAck->nlmsg_seq = pRequest->nlmsg_seq;
+   iLength += pAck->nlmsg_len;
+   send(iFd, uBuffer, iLength, 0);
+}
+
+static struct nlattr* _mock_put_attr(u8* pBuffer, int* piPos, u16 uType, const void* pData, int iLength)
+{
+   struct nlattr* pAttr = (struct nlattr*)(pBuffer + *piPos);
+   pAttr->nla_type = uType;
+   pAttr->nla_len = NLA_HDRLEN + iLength;
+   if ( (NULL != pData) && (iLength > 0) )
+      memcpy(((u8*)pAttr) + NLA_HDRLEN, pData, iLength);
+   *piPos += NLA_ALIGN(pAttr->nla_len);
+   return pAttr;
+}
+
+static void _mock_end_nest(u8* pBuffer, int iPos, struct nlattr* pNest)
+{
+   pNest->nla_len = (pBuffer + iPos) - (u8*)pNest;
+}
+
+// Wiphy dump for phy 1: one band with 2427 and 5745 Mhz channels, then NLMSG_DONE
+static void _mock_send_wiphy_dump(int iFd, struct nlmsghdr* pRequest)
+{
+   u8 uBuffer[1024];
+   memset(uBuffer, 0, sizeof(uBuffer));
+   struct nlmsghdr* pReply = (struct nlmsghdr*)uBuffer;
+   pReply->nlmsg_type = MOCK_FAMILY_ID;
+   pReply->nlmsg_flags = NLM_F_MULTI;
+   pReply->nlmsg_seq = pRequest->nlmsg_seq;
+   struct genlmsghdr* pGenl = (struct genlmsghdr*)NLMSG_DATA(pReply);
+   pGenl->cmd = NL80211_CMD_NEW_WIPHY;
+   int iPos = NLMSG_LENGTH(GENL_HDRLEN);
+
+   u32 uPhy = 1;
+   _mock_put_attr(uBuffer, &iPos, NL80211_ATTR_WIPHY, &uPhy, sizeof(u32));
+   struct nlattr* pBands = _mock_put_attr(uBuffer, &iPos, NL80211_ATTR_WIPHY_BANDS | NLA_F_NESTED, NULL, 0);
+   struct nlattr* pBand = _mock_put_attr(uBuffer, &iPos, 0 | NLA_F_NESTED, NULL, 0);
+   struct nlattr* pFreqs = _mock_put_attr(uBuffer, &iPos, NL80211_BAND_ATTR_FREQS | NLA_F_NESTED, NULL, 0);
+   u32 uFreqs[] = { 2427, 5745 };
+   for( int i=0; i<2; i++ )
+   {
+      struct nlattr* pFreq = _mock_put_attr(uBuffer, &iPos, i | NLA_F_NESTED, NULL, 0);
+      _mock_put_attr(uBuffer, &iPos, NL80211_FREQUENCY_ATTR_FREQ, &uFreqs[i], sizeof(u32));
+      _mock_end_nest(uBuffer, iPos, pFreq);
+   }
+   _mock_end_nest(uBuffer, iPos, pFreqs);
+   _mock_end_nest(uBuffer, iPos, pBand);
+   _mock_end_nest(uBuffer, iPos, pBands);
+   pReply->nlmsg_len = iPos;
+   send(iFd, uBuffer, iPos, 0);
+
+   memset(uBuffer, 0, sizeof(uBuffer));
+   pReply->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+   pReply->nlmsg_type = NLMSG_DONE;
+   pReply->nlmsg_flags = NLM_F_MULTI;
+   pReply->nlmsg_seq = pRequest->nlmsg_seq;
+   send(iFd, uBuffer, pReply->nlmsg_len, 0);
+}
+
+static void _mock_parse_genl_attributes(struct nlattr* pAttr, int iLength)
+{
+   while ( (iLength >= NLA_HDRLEN) && (pAttr->nla_len >= NLA_HDRLEN) && (pAttr->nla_len <= iLength) )
+   {
+      u32 uValue = 0;
+      if ( pAttr->nla_len >= NLA_HDRLEN + 4 )
+         memcpy(&uValue, ((u8*)pAttr) + NLA_HDRLEN, 4);
+      switch ( pAttr->nla_type & NLA_TYPE_MASK )
+      {
+         case NL80211_ATTR_IFINDEX: s_uLastIfIndex = uValue; break;
+         case NL80211_ATTR_WIPHY_FREQ: s_uLastFreq = uValue; break;
+         case NL80211_ATTR_WIPHY_CHANNEL_TYPE: s_uLastChannelType = uValue; break;
+         case NL80211_ATTR_IFTYPE: s_uLastIfType = uValue; break;
+         case NL80211_ATTR_MNTR_FLAGS:
+         {
+            s_iLastHasMonitorFlags = 1;
+            s_uLastMonitorFlags = 0;
+            int iNestLength = pAttr->nla_len - NLA_HDRLEN;
+            struct nlattr* pFlag = (struct nlattr*)(((u8*)pAttr) + NLA_HDRLEN);
+            while ( iNestLength >= NLA_HDRLEN )
+            {
+               s_uLastMonitorFlags |= ((u32)1) << (pFlag->nla_type & NLA_TYPE_MASK);
+               iNestLength -= NLA_ALIGN(pFlag->nla_len);
+               pFlag = (struct nlattr*)(((u8*)pFlag) + NLA_ALIGN(pFlag->nla_len));
+            }
+            break;
+         }
+      }
+      iLength -= NLA_ALIGN(pAttr->nla_len);
+      pAttr = (struct nlattr*)(((u8*)pAttr) + NLA_ALIGN(pAttr->nla_len));
+   }
+}
+
+static void* _mock_thread(void* pParam)
+{
+   u8 uBuffer[4096];
+   while ( 1 )
+   {
+      struct pollfd fds[2];
+      fds[0].fd = s_iMockGenericFd;
+      fds[0].events = POLLIN;
+      fds[1].fd = s_iMockRouteFd;
+      fds[1].events = POLLIN;
+      if ( poll(fds, 2, -1) <= 0 )
+         continue;
+      for( int i=0; i<2; i++ )
+      {
+         if ( ! (fds[i].revents & (POLLIN | POLLHUP)) )
+            continue;
+         int iLength = recv(fds[i].fd, uBuffer, sizeof(uBuffer), 0);
+         if ( iLength <= 0 )
+            return NULL;
+         struct nlmsghdr* pMsg = (struct nlmsghdr*)uBuffer;
+         s_uLastType = pMsg->nlmsg_type;
+         if ( 0 == i )
+         {
+            struct genlmsghdr* pGenl = (struct genlmsghdr*)NLMSG_DATA(pMsg);
+            s_uLastCommand = pGenl->cmd;
+            if ( (pMsg->nlmsg_type == GENL_ID_CTRL) && (pGenl->cmd == CTRL_CMD_GETFAMILY) )
+            {
+               _mock_send_family(fds[i].fd, pMsg);
+               continue;
+            }
+            if ( pGenl->cmd == NL80211_CMD_GET_WIPHY )
+            {
+               _mock_send_wiphy_dump(fds[i].fd, pMsg);
+               continue;
+            }
+            s_iLastHasMonitorFlags = 0;
+            _mock_parse_genl_attributes((struct nlattr*)(((u8*)pGenl) + GENL_HDRLEN), pMsg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+         }
+         else
+         {
+            struct ifinfomsg* pInfo = (struct ifinfomsg*)NLMSG_DATA(pMsg);
+            s_uLastIfIndex = pInfo->ifi_index;
+            s_uLastLinkFlags = pInfo->ifi_flags;
+            s_uLastLinkChange = pInfo->ifi_change;
+         }
+         _mock_send_reply(fds[i].fd, pMsg, s_iMockErrorToReturn);
+      }
+   }
+   return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestNL80211");
+   log_enable_stdout();
+
+   s_iLoopbackIndex = (int)if_nametoindex("lo");
+   if ( 0 == s_iLoopbackIndex )
+   {
+      printf("No loopback interface, can't run the test.\n");
+      return -1;
+   }
+
+   int iGenericPair[2];
+   int iRoutePair[2];
+   if ( (0 != socketpair(AF_UNIX, SOCK_SEQPACKET, 0, iGenericPair)) || (0 != socketpair(AF_UNIX, SOCK_SEQPACKET, 0, iRoutePair)) )
+   {
+      printf("Failed to create socket pairs.\n");
+      return -1;
+   }
+   s_iMockGenericFd = iGenericPair[1];
+   s_iMockRouteFd = iRoutePair[1];
+   hardware_radio_nl80211_use_sockets(iGenericPair[0], iRoutePair[0]);
+
+   pthread_t pThread;
+   pthread_create(&pThread, NULL, &_mock_thread, NULL);
+
+   printf("\nTesting nl80211/rtnetlink client:\n");
+
+   int iRes = hardware_radio_nl80211_set_frequency("lo", 5745000, 0);
+   _check((0 == iRes) && (s_uLastType == MOCK_FAMILY_ID) && (s_uLastCommand == NL80211_CMD_SET_WIPHY) && ((int)s_uLastIfIndex == s_iLoopbackIndex) &&
+          (s_uLastFreq == 5745) && (s_uLastChannelType == NL80211_CHAN_NO_HT), "set frequency");
+
+   iRes = hardware_radio_nl80211_set_frequency("lo", 2427000, 1);
+   _check((0 == iRes) && (s_uLastFreq == 2427) && (s_uLastChannelType == NL80211_CHAN_HT40PLUS), "set frequency HT40");
+
+   iRes = hardware_radio_nl80211_set_type_monitor("lo");
+   _check((0 == iRes) && (s_uLastCommand == NL80211_CMD_SET_INTERFACE) && (s_uLastIfType == NL80211_IFTYPE_MONITOR) && (! s_iLastHasMonitorFlags), "set type monitor");
+
+   iRes = hardware_radio_nl80211_set_monitor_flags("lo", HW_RADIO_NL80211_MONITOR_FLAG_FCSFAIL);
+   _check((0 == iRes) && (s_uLastCommand == NL80211_CMD_SET_INTERFACE) && s_iLastHasMonitorFlags && (s_uLastMonitorFlags == (((u32)1) << NL80211_MNTR_FLAG_FCSFAIL)), "set monitor fcsfail");
+
+   iRes = hardware_radio_nl80211_set_monitor_flags("lo", HW_RADIO_NL80211_MONITOR_FLAGS_NONE);
+   _check((0 == iRes) && s_iLastHasMonitorFlags && (s_uLastMonitorFlags == 0), "set monitor none");
+
+   iRes = hardware_radio_nl80211_set_link_up("lo", 0);
+   _check((0 == iRes) && (s_uLastType == RTM_NEWLINK) && ((int)s_uLastIfIndex == s_iLoopbackIndex) && (s_uLastLinkFlags == 0) && (s_uLastLinkChange == IFF_UP), "set link down");
+
+   iRes = hardware_radio_nl80211_set_link_up("lo", 1);
+   _check((0 == iRes) && (s_uLastLinkFlags == IFF_UP) && (s_uLastLinkChange == IFF_UP), "set link up");
+
+   u32 uFrequencies[16];
+   iRes = hardware_radio_nl80211_get_phy_frequencies(1, uFrequencies, 16);
+   _check((2 == iRes) && (uFrequencies[0] == 2427) && (uFrequencies[1] == 5745), "get phy frequencies");
+
+   iRes = hardware_radio_nl80211_get_phy_frequencies(0, uFrequencies, 16);
+   _check(0 == iRes, "get frequencies of other phy");
+
+   s_iMockErrorToReturn = -EBUSY;
+   iRes = hardware_radio_nl80211_set_frequency("lo", 5745000, 0);
+   _check(-EBUSY == iRes, "kernel error is returned");
+   s_iMockErrorToReturn = 0;
+
+   iRes = hardware_radio_nl80211_set_link_up("no_such_interface", 1);
+   _check(-ENODEV == iRes, "missing interface");
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nnl80211 test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nnl80211 test passed.\n");
+   return 0;
+}
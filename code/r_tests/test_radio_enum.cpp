@@ -0,0 +1,193 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/hardware_radio_sysfs.h"
+#include "test_utils.h"
+
+#include <sys/stat.h>
+
+// Tests the sysfs based radio interfaces enumeration helpers against a fake sysfs tree:
+// wifi interfaces filtering, driver/MAC/phy lookup, USB devices description (lsusb format)
+// and the radio hardware topology signature used to reuse the stored radio config.
+//
+// Usage: test_radio_enum [-root folder]
+
+char s_szRoot[MAX_FILE_PATH_SIZE] = "/tmp/ruby_test_sysfs/";
+static void _make_folder(const char* szRelativePath)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   snprintf(szPath, sizeof(szPath), "%s%s", s_szRoot, szRelativePath);
+   for( char* p = szPath + strlen(s_szRoot); *p; p++ )
+   {
+      if ( *p != '/' )
+         continue;
+      *p = 0;
+      mkdir(szPath, 0755);
+      *p = '/';
+   }
+   mkdir(szPath, 0755);
+}
+
+static void _write_file(const char* szRelativePath, const char* szContent)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   snprintf(szPath, sizeof(szPath), "%s%s", s_szRoot, szRelativePath);
+   FILE* fd = fopen(szPath, "w");
+   if ( NULL == fd )
+   {
+      printf("Failed to create file %s\n", szPath);
+      s_iTotalErrors++;
+      return;
+   }
+   fputs(szContent, fd);
+   fclose(fd);
+}
+
+static void _make_link(const char* szTarget, const char* szRelativePath)
+{
+   char szPath[MAX_FILE_PATH_SIZE];
+   snprintf(szPath, sizeof(szPath), "%s%s", s_szRoot, szRelativePath);
+   unlink(szPath);
+   if ( 0 != symlink(szTarget, szPath) )
+   {
+      printf("Failed to create link %s\n", szPath);
+      s_iTotalErrors++;
+   }
+}
+
+static void _build_fake_sysfs()
+{
+   char szComm[256];
+   snprintf(szComm, sizeof(szComm), "rm -rf %s", s_szRoot);
+   if ( 0 != system(szComm) )
+      printf("Failed to remove old fake sysfs tree.\n");
+   mkdir(s_szRoot, 0755);
+
+   // wlan0: realtek USB card, driver and phy from files
+   _make_folder("class/net/wlan0/device");
+   _make_folder("class/net/wlan0/phy80211");
+   _write_file("class/net/wlan0/device/uevent", "DEVTYPE=usb_interface\nDRIVER=rtl88xxau\nPRODUCT=bda/8812/0\n");
+   _write_file("class/net/wlan0/address", "00:c0:ca:b1:2e:f3\n");
+   _write_file("class/net/wlan0/phy80211/index", "2\n");
+
+   // wlan1: driver and phy only as links
+   _make_folder("class/net/wlan1/device");
+   _make_folder("bus/usb/drivers/rt2800usb");
+   _make_folder("class/ieee80211/phy11");
+   _make_link("../../../../bus/usb/drivers/rt2800usb", "class/net/wlan1/device/driver");
+   _make_link("../../ieee80211/phy11", "class/net/wlan1/phy80211");
+   _write_file("class/net/wlan1/address", "14:CC:20:00:00:01");
+
+   // Not radio interfaces
+   _make_folder("class/net/lo");
+   _make_folder("class/net/eth0");
+   _make_folder("class/net/wlx0013eff1");
+   _make_folder("class/net/usb0");
+
+   // USB devices: root hub, the card and it's interface
+   _make_folder("bus/usb/devices/usb1");
+   _write_file("bus/usb/devices/usb1/idVendor", "1d6b\n");
+   _write_file("bus/usb/devices/usb1/idProduct", "0002\n");
+   _write_file("bus/usb/devices/usb1/busnum", "1\n");
+   _write_file("bus/usb/devices/usb1/devnum", "1\n");
+   _make_folder("bus/usb/devices/1-1.2");
+   _write_file("bus/usb/devices/1-1.2/idVendor", "0bda\n");
+   _write_file("bus/usb/devices/1-1.2/idProduct", "8812\n");
+   _write_file("bus/usb/devices/1-1.2/busnum", "1\n");
+   _write_file("bus/usb/devices/1-1.2/devnum", "3\n");
+   _write_file("bus/usb/devices/1-1.2/manufacturer", "Realtek\n");
+   _write_file("bus/usb/devices/1-1.2/product", "802.11n NIC\n");
+   _make_folder("bus/usb/devices/1-1.2:1.0/net/wlan0");
+   _write_file("bus/usb/devices/1-1.2:1.0/uevent", "DEVTYPE=usb_interface\nDRIVER=rtl88xxau\nPRODUCT=bda/8812/0\n");
+   _write_file("bus/usb/devices/1-1.2:1.0/net/wlan0/uevent", "DEVTYPE=wlan\nINTERFACE=wlan0\nIFINDEX=3\n");
+}
+
+int main(int argc, char *argv[])
+{
+   for( int i=1; i<argc; i++ )
+   {
+      if ( (0 == strcmp(argv[i], "-root")) && (i < argc-1) )
+      {
+         i++;
+         snprintf(s_szRoot, sizeof(s_szRoot), "%s/", argv[i]);
+      }
+   }
+
+   log_init("TestRadioEnum");
+   log_enable_stdout();
+
+   printf("\nTesting radio interfaces enumeration on fake sysfs tree [%s]:\n", s_szRoot);
+   _build_fake_sysfs();
+   hardware_radio_sysfs_set_root(s_szRoot);
+
+   char szInterfaces[8][HW_SYSFS_MAX_NAME_LENGTH];
+   int iCount = hardware_radio_sysfs_get_wifi_interfaces(szInterfaces, 8);
+   _check((2 == iCount) && (0 == strcmp(szInterfaces[0], "wlan0")) && (0 == strcmp(szInterfaces[1], "wlan1")), "wifi interfaces");
+
+   char szValue[128];
+   _check(hardware_radio_sysfs_get_interface_driver("wlan0", szValue, sizeof(szValue)) && (0 == strcmp(szValue, "rtl88xxau")), "driver from uevent");
+   _check(hardware_radio_sysfs_get_interface_driver("wlan1", szValue, sizeof(szValue)) && (0 == strcmp(szValue, "rt2800usb")), "driver from link");
+   _check(! hardware_radio_sysfs_get_interface_driver("wlan5", szValue, sizeof(szValue)), "missing interface driver");
+
+   _check(hardware_radio_sysfs_get_interface_mac("wlan0", szValue, sizeof(szValue)) && (0 == strcmp(szValue, "00C0CAB12EF3")), "MAC address");
+   _check(2 == hardware_radio_sysfs_get_interface_phy_index("wlan0"), "phy index from file");
+   _check(11 == hardware_radio_sysfs_get_interface_phy_index("wlan1"), "phy index from link");
+   _check(-1 == hardware_radio_sysfs_get_interface_phy_index("lo"), "no phy");
+
+   _check(hardware_radio_sysfs_read_uevent_value("bus/usb/devices/1-1.2:1.0/net/wlan0/uevent", "INTERFACE", szValue, sizeof(szValue)) && (0 == strcmp(szValue, "wlan0")), "uevent value");
+   _check(! hardware_radio_sysfs_read_uevent_value("bus/usb/devices/1-1.2:1.0/net/wlan0/uevent", "DRIVER", szValue, sizeof(szValue)), "missing uevent value");
+
+   char szUSB[1024];
+   iCount = hardware_radio_sysfs_get_usb_devices_description(szUSB, sizeof(szUSB));
+   _check((2 == iCount) &&
+          (NULL != strstr(szUSB, "Bus 001 Device 003: ID 0bda:8812 Realtek 802.11n NIC\n")) &&
+          (NULL != strstr(szUSB, "Bus 001 Device 001: ID 1d6b:0002")), "USB devices description");
+
+   u32 uSignature1 = hardware_radio_sysfs_get_topology_signature();
+   u32 uSignature2 = hardware_radio_sysfs_get_topology_signature();
+   _check(uSignature1 == uSignature2, "topology signature is stable");
+
+   _make_folder("class/net/wifihotspot0");
+   _check(uSignature1 == hardware_radio_sysfs_get_topology_signature(), "topology ignores other network interfaces");
+
+   _make_folder("class/tty/ttyUSB0");
+   u32 uSignature3 = hardware_radio_sysfs_get_topology_signature();
+   _check(uSignature3 != uSignature1, "topology changes on new serial port");
+
+   _write_file("bus/usb/devices/1-1.2/idProduct", "a81a\n");
+   _check(uSignature3 != hardware_radio_sysfs_get_topology_signature(), "topology changes on different USB card");
+
+   // More tty entries than the list size, as on a stock kernel: USB serial ports must still be part of the signature
+   char szName[64];
+   for( int i=0; i<HW_SYSFS_MAX_FOLDER_ENTRIES + 6; i++ )
+   {
+      snprintf(szName, sizeof(szName), "class/tty/tty%d", i);
+      _make_folder(szName);
+   }
+   char szEntries[HW_SYSFS_MAX_FOLDER_ENTRIES][HW_SYSFS_MAX_NAME_LENGTH];
+   iCount = hardware_radio_sysfs_list_folder("class/tty", NULL, szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   _check((HW_SYSFS_MAX_FOLDER_ENTRIES + 7 == iCount) && (0 == strcmp(szEntries[0], "tty0")) && (0 == strcmp(szEntries[1], "tty1")), "list folder counts all entries and keeps the first ones sorted");
+   iCount = hardware_radio_sysfs_list_folder("class/tty", "ttyUSB", szEntries, HW_SYSFS_MAX_FOLDER_ENTRIES);
+   _check((1 == iCount) && (0 == strcmp(szEntries[0], "ttyUSB0")), "list folder with prefix");
+
+   u32 uSignature4 = hardware_radio_sysfs_get_topology_signature();
+   _make_folder("class/tty/ttyUSB1");
+   _check(uSignature4 != hardware_radio_sysfs_get_topology_signature(), "topology changes on new serial port with many tty entries");
+
+   for( int i=2; i<=HW_SYSFS_MAX_FOLDER_ENTRIES; i++ )
+   {
+      snprintf(szName, sizeof(szName), "class/tty/ttyUSB%d", i);
+      _make_folder(szName);
+   }
+   _check(HW_SYSFS_TOPOLOGY_SIGNATURE_UNKNOWN == hardware_radio_sysfs_get_topology_signature(), "topology is unknown when the serial ports list is truncated");
+
+   hardware_radio_sysfs_set_root(NULL);
+   _check(0 == strcmp(hardware_radio_sysfs_get_root(), "/sys/"), "default root");
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nRadio enumeration test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nRadio enumeration test passed.\n");
+   return 0;
+}
@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../renderer/fbgraphics.h"
+#include "../renderer/fbg_blend.h"
+#include "test_utils.h"
+
+// Tests the fbgraphics span kernels: the SIMD kernels supported by this CPU must give the exact same output as
+// the scalar reference kernels, for all spans lengths and alignments. The scalar kernels are also checked
+// against the per pixel blending the renderer used before.
+// Then benchmarks drawing a recorded OSD frame (translucent bars and panels, a menu, text and icons)
+// with each kernels type.
+//
+// Usage: test_render_blend [-frames N]
+
+#define TEST_FRAME_WIDTH 1280
+#define TEST_FRAME_HEIGHT 720
+#define TEST_GLYPH_WIDTH 12
+#define TEST_GLYPH_HEIGHT 22
+#define TEST_ICON_SIZE 48
+
+static void _fill_random(unsigned char* pBuffer, int iLength)
+{
+   for( int i=0; i<iLength; i++ )
+   {
+      pBuffer[i] = rand() & 0xFF;
+      // Favor the edge values: transparent and opaque pixels
+      if ( (i % 4) == 3 )
+      {
+         int iRand = rand() % 4;
+         if ( 0 == iRand )
+            pBuffer[i] = 0;
+         else if ( 1 == iRand )
+            pBuffer[i] = 255;
+      }
+   }
+}
+
+// Per pixel blending, as fbgraphics did it before the span kernels
+static void _legacy_pixela(unsigned char* pPixel, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   if ( pPixel[3] == 255 )
+   {
+      pPixel[0] = (a * r + (255 - a) * pPixel[0]) >> 8;
+      pPixel[1] = (a * g + (255 - a) * pPixel[1]) >> 8;
+      pPixel[2] = (a * b + (255 - a) * pPixel[2]) >> 8;
+   }
+   else
+   {
+      pPixel[0] = (a * r + (255 - a) * pPixel[0]) >> 8;
+      pPixel[1] = (a * g + (255 - a) * pPixel[1]) >> 8;
+      pPixel[2] = (a * b + (255 - a) * pPixel[2]) >> 8;
+      pPixel[3] = pPixel[3] + (((255 - pPixel[3]) * a) >> 8);
+   }
+}
+
+static void _legacy_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode)
+{
+   for( int i=0; i<iCount; i++, pDest += 4, pSrc += 4 )
+   {
+      if ( (iMode == FBG_BLEND_IMAGE_SKIP_DARK) && (pSrc[0] + pSrc[1] + pSrc[2] < 120) )
+         continue;
+      if ( (iMode == FBG_BLEND_IMAGE_COPY_OPAQUE) && (pSrc[3] < 120) )
+         continue;
+      unsigned char uColor[4];
+      for( int k=0; k<4; k++ )
+         uColor[k] = (NULL != pMixColor)?((pSrc[k] * pMixColor[k]) >> 8):pSrc[k];
+      if ( iMode == FBG_BLEND_IMAGE_COPY_OPAQUE )
+         memcpy(pDest, uColor, 4);
+      else
+         _legacy_pixela(pDest, uColor[0], uColor[1], uColor[2], uColor[3]);
+   }
+}
+
+static void _test_scalar_reference()
+{
+   printf("\nScalar kernels vs per pixel blending:\n");
+
+   // Exhaustive over the alpha and destination values for one channel
+   bool bOk = true;
+   for( int a=0; a<256 && bOk; a++ )
+   for( int d=0; d<256 && bOk; d++ )
+   {
+      unsigned char uPixel1[4] = { (unsigned char)d, (unsigned char)(255-d), (unsigned char)d, (unsigned char)d };
+      unsigned char uPixel2[4];
+      memcpy(uPixel2, uPixel1, 4);
+      _legacy_pixela(uPixel1, 200, 17, (unsigned char)a, (unsigned char)a);
+      fbg_blend_scalar_blend_fill(uPixel2, 1, 200, 17, (unsigned char)a, (unsigned char)a);
+      if ( 0 != memcmp(uPixel1, uPixel2, 4) )
+         bOk = false;
+   }
+   _check(bOk, "blend fill, all alpha and destination values");
+
+   unsigned char uDest1[256*4], uDest2[256*4], uSrc[256*4];
+   unsigned char uMix[4] = { 255, 180, 90, 230 };
+   const char* szModes[3] = { "all", "skip dark", "copy opaque" };
+   for( int iMode=0; iMode<3; iMode++ )
+   {
+      bOk = true;
+      for( int iRun=0; iRun<200; iRun++ )
+      {
+         _fill_random(uDest1, sizeof(uDest1));
+         _fill_random(uSrc, sizeof(uSrc));
+         memcpy(uDest2, uDest1, sizeof(uDest1));
+         const unsigned char* pMix = (iRun % 2)?uMix:NULL;
+         _legacy_blend_image(uDest1, uSrc, 256, pMix, iMode);
+         fbg_blend_scalar_blend_image(uDest2, uSrc, 256, pMix, iMode);
+         if ( 0 != memcmp(uDest1, uDest2, sizeof(uDest1)) )
+            bOk = false;
+      }
+      char szTest[64];
+      snprintf(szTest, sizeof(szTest), "blend image, mode %s", szModes[iMode]);
+      _check(bOk, szTest);
+   }
+}
+
+static void _test_kernels(int iKernelsType)
+{
+   t_fbg_blend_kernels kernelsRef, kernels;
+   fbg_blend_get_kernels(FBG_BLEND_KERNELS_SCALAR, &kernelsRef);
+   if ( ! fbg_blend_get_kernels(iKernelsType, &kernels) )
+      return;
+
+   printf("\nKernels %s vs scalar:\n", kernels.szName);
+
+   // Spans of all lengths up to a few SIMD widths, at all alignments
+   const int iMaxCount = 70;
+   unsigned char* pDest1 = (unsigned char*) malloc(iMaxCount*4 + 64);
+   unsigned char* pDest2 = (unsigned char*) malloc(iMaxCount*4 + 64);
+   unsigned char* pSrc = (unsigned char*) malloc(iMaxCount*4 + 64);
+   unsigned char uMix[4] = { 250, 128, 33, 200 };
+
+   bool bOkFill = true, bOkBlendFill = true;
+   bool bOkImage[3] = { true, true, true };
+   for( int iCount=0; iCount<=iMaxCount; iCount++ )
+   for( int iAlign=0; iAlign<16; iAlign++ )
+   {
+      unsigned char* p1 = pDest1 + iAlign;
+      unsigned char* p2 = pDest2 + iAlign;
+      unsigned char* pS = pSrc + ((iAlign*4) % 16);
+      unsigned char r = rand(), g = rand(), b = rand(), a = rand();
+      if ( 0 == (iAlign % 4) )
+         a = (iAlign % 8)?255:0;
+
+      _fill_random(pDest1, iMaxCount*4 + 64);
+      memcpy(pDest2, pDest1, iMaxCount*4 + 64);
+      kernelsRef.pFill(p1, iCount, r, g, b, a);
+      kernels.pFill(p2, iCount, r, g, b, a);
+      if ( 0 != memcmp(pDest1, pDest2, iMaxCount*4 + 64) )
+         bOkFill = false;
+
+      _fill_random(pDest1, iMaxCount*4 + 64);
+      memcpy(pDest2, pDest1, iMaxCount*4 + 64);
+      kernelsRef.pBlendFill(p1, iCount, r, g, b, a);
+      kernels.pBlendFill(p2, iCount, r, g, b, a);
+      if ( 0 != memcmp(pDest1, pDest2, iMaxCount*4 + 64) )
+         bOkBlendFill = false;
+
+      for( int iMode=0; iMode<3; iMode++ )
+      {
+         _fill_random(pDest1, iMaxCount*4 + 64);
+         _fill_random(pSrc, iMaxCount*4 + 64);
+         memcpy(pDest2, pDest1, iMaxCount*4 + 64);
+         const unsigned char* pMix = (iAlign % 2)?uMix:NULL;
+         kernelsRef.pBlendImage(p1, pS, iCount, pMix, iMode);
+         kernels.pBlendImage(p2, pS, iCount, pMix, iMode);
+         if ( 0 != memcmp(pDest1, pDest2, iMaxCount*4 + 64) )
+            bOkImage[iMode] = false;
+      }
+   }
+   _check(bOkFill, "fill");
+   _check(bOkBlendFill, "blend fill");
+   _check(bOkImage[FBG_BLEND_IMAGE_ALL], "blend image, mode all");
+   _check(bOkImage[FBG_BLEND_IMAGE_SKIP_DARK], "blend image, mode skip dark");
+   _check(bOkImage[FBG_BLEND_IMAGE_COPY_OPAQUE], "blend image, mode copy opaque");
+
+   free(pDest1);
+   free(pDest2);
+   free(pSrc);
+}
+
+// ---------------------------------------------------------
+// Recorded OSD frame
+
+#define OP_RECT_BLEND 0
+#define OP_RECT 1
+#define OP_HLINE 2
+#define OP_VLINE 3
+#define OP_TEXT 4
+#define OP_TEXT_NO_OUTLINE 5
+#define OP_ICON 6
+#define OP_ICON_SCALED 7
+
+typedef struct
+{
+   int iType;
+   int x, y, w, h;
+   unsigned char uColor[4];
+   const char* szText;
+} t_test_draw_op;
+
+// Draw calls of an OSD frame at 1280x720 with the main menu open, as issued by the raw render engine
+static const t_test_draw_op s_TestFrameOps[] =
+{
+   // OSD top and bottom bars
+   { OP_RECT_BLEND, 0, 0, 1280, 38, {0, 0, 0, 110}, NULL },
+   { OP_TEXT, 10, 8, 0, 0, {255, 255, 255, 255}, "Ruby 10.2  RC 34%  Batt 16.2V 12.4A  Alt 124m  Dist 1.4km  Home 264 deg" },
+   { OP_ICON, 1200, 0, 0, 0, {255, 255, 255, 255}, NULL },
+   { OP_ICON, 1150, 0, 0, 0, {255, 255, 255, 255}, NULL },
+   { OP_RECT_BLEND, 0, 682, 1280, 38, {0, 0, 0, 110}, NULL },
+   { OP_TEXT, 10, 690, 0, 0, {255, 255, 255, 255}, "5805 MHz  RSSI -52 dBm  SNR 28  Video 8.1/12.0 Mbps  EC 2/6  H264 1280x720 60fps" },
+   { OP_TEXT, 1000, 690, 0, 0, {255, 200, 80, 255}, "REC 00:12:44" },
+
+   // Radio and video stats panels
+   { OP_RECT_BLEND, 16, 60, 270, 330, {20, 20, 24, 150}, NULL },
+   { OP_HLINE, 16, 60, 270, 0, {220, 220, 220, 180}, NULL },
+   { OP_HLINE, 16, 389, 270, 0, {220, 220, 220, 180}, NULL },
+   { OP_VLINE, 16, 60, 0, 330, {220, 220, 220, 180}, NULL },
+   { OP_VLINE, 285, 60, 0, 330, {220, 220, 220, 180}, NULL },
+   { OP_TEXT, 24, 66, 0, 0, {255, 255, 255, 255}, "Radio Interfaces" },
+   { OP_TEXT_NO_OUTLINE, 24, 92, 0, 0, {200, 200, 200, 255}, "wlan0  RTL8812EU  5805" },
+   { OP_TEXT_NO_OUTLINE, 24, 116, 0, 0, {200, 200, 200, 255}, "  rx 1024 pkt/s  lost 2" },
+   { OP_TEXT_NO_OUTLINE, 24, 140, 0, 0, {200, 200, 200, 255}, "  dbm -52  snr 28  q 98%" },
+   { OP_TEXT_NO_OUTLINE, 24, 164, 0, 0, {200, 200, 200, 255}, "wlan1  RTL8812AU  5805" },
+   { OP_TEXT_NO_OUTLINE, 24, 188, 0, 0, {200, 200, 200, 255}, "  rx 1011 pkt/s  lost 9" },
+   { OP_TEXT_NO_OUTLINE, 24, 212, 0, 0, {200, 200, 200, 255}, "  dbm -61  snr 22  q 91%" },
+   { OP_RECT_BLEND, 24, 240, 254, 140, {0, 0, 0, 90}, NULL },
+   { OP_HLINE, 24, 330, 254, 0, {80, 255, 80, 200}, NULL },
+   { OP_HLINE, 24, 300, 254, 0, {255, 220, 80, 200}, NULL },
+   { OP_RECT_BLEND, 994, 60, 270, 230, {20, 20, 24, 150}, NULL },
+   { OP_TEXT, 1002, 66, 0, 0, {255, 255, 255, 255}, "Video Stream" },
+   { OP_TEXT_NO_OUTLINE, 1002, 92, 0, 0, {200, 200, 200, 255}, "bitrate 8.1 Mbps" },
+   { OP_TEXT_NO_OUTLINE, 1002, 116, 0, 0, {200, 200, 200, 255}, "keyframe 0.5 s" },
+   { OP_TEXT_NO_OUTLINE, 1002, 140, 0, 0, {200, 200, 200, 255}, "ec 2/6  retr 14/s" },
+   { OP_TEXT_NO_OUTLINE, 1002, 164, 0, 0, {200, 200, 200, 255}, "latency 82 ms" },
+
+   // Main menu, with a selected item and a popup
+   { OP_RECT_BLEND, 380, 90, 520, 500, {30, 30, 40, 210}, NULL },
+   { OP_RECT_BLEND, 380, 90, 520, 40, {60, 60, 90, 230}, NULL },
+   { OP_TEXT, 396, 99, 0, 0, {255, 255, 255, 255}, "Main Menu" },
+   { OP_ICON_SCALED, 850, 96, 28, 28, {255, 255, 255, 255}, NULL },
+   { OP_RECT_BLEND, 388, 176, 504, 30, {120, 160, 255, 120}, NULL },
+   { OP_TEXT, 400, 146, 0, 0, {230, 230, 230, 255}, "Vehicle Settings" },
+   { OP_TEXT, 400, 180, 0, 0, {255, 255, 255, 255}, "Radio Links" },
+   { OP_TEXT, 400, 214, 0, 0, {230, 230, 230, 255}, "Video" },
+   { OP_TEXT, 400, 248, 0, 0, {230, 230, 230, 255}, "Camera" },
+   { OP_TEXT, 400, 282, 0, 0, {230, 230, 230, 255}, "Audio" },
+   { OP_TEXT, 400, 316, 0, 0, {230, 230, 230, 255}, "OSD / Instruments" },
+   { OP_TEXT, 400, 350, 0, 0, {230, 230, 230, 255}, "Controller Settings" },
+   { OP_TEXT, 400, 384, 0, 0, {230, 230, 230, 255}, "Search" },
+   { OP_TEXT, 400, 418, 0, 0, {230, 230, 230, 255}, "Media & Storage" },
+   { OP_TEXT, 400, 452, 0, 0, {230, 230, 230, 255}, "System" },
+   { OP_HLINE, 388, 486, 504, 0, {200, 200, 200, 160}, NULL },
+   { OP_TEXT, 400, 500, 0, 0, {180, 180, 180, 255}, "About" },
+   { OP_ICON_SCALED, 860, 180, 24, 24, {255, 255, 255, 255}, NULL },
+   { OP_ICON_SCALED, 860, 214, 24, 24, {255, 255, 255, 255}, NULL },
+   { OP_RECT_BLEND, 440, 540, 400, 110, {50, 20, 20, 230}, NULL },
+   { OP_RECT, 440, 540, 400, 2, {255, 80, 80, 255}, NULL },
+   { OP_TEXT, 456, 556, 0, 0, {255, 255, 255, 255}, "Link lost on wlan1, switching to wlan0" },
+   { OP_TEXT, 456, 590, 0, 0, {255, 220, 220, 255}, "Press any key to dismiss" },
+};
+
+static void _create_font_atlas(struct _fbg* pFBG, struct _fbg_img** ppFont, struct _fbg_img** ppIcon)
+{
+   // 96 glyphs: white strokes with a dark outline and antialiased edges on a transparent background
+   struct _fbg_img* pFont = fbg_createImage(pFBG, 16*TEST_GLYPH_WIDTH, 6*TEST_GLYPH_HEIGHT);
+   for( int iGlyph=0; iGlyph<96; iGlyph++ )
+   {
+      int x0 = (iGlyph % 16) * TEST_GLYPH_WIDTH;
+      int y0 = (iGlyph / 16) * TEST_GLYPH_HEIGHT;
+      for( int y=2; y<TEST_GLYPH_HEIGHT-2; y++ )
+      for( int x=1; x<TEST_GLYPH_WIDTH-1; x++ )
+      {
+         unsigned char* pPixel = pFont->data + ((y0+y) * pFont->width + x0 + x) * 4;
+         int iShape = (x * 7 + y * 3 + iGlyph * 5) % 11;
+         if ( iShape < 3 )
+         {
+            pPixel[0] = pPixel[1] = pPixel[2] = 255;
+            pPixel[3] = 255;
+         }
+         else if ( iShape < 5 )
+         {
+            pPixel[0] = pPixel[1] = pPixel[2] = 10;
+            pPixel[3] = 255;
+         }
+         else if ( iShape < 6 )
+         {
+            pPixel[0] = pPixel[1] = pPixel[2] = 160;
+            pPixel[3] = 40 + iGlyph;
+         }
+      }
+   }
+   *ppFont = pFont;
+
+   struct _fbg_img* pIcon = fbg_createImage(pFBG, TEST_ICON_SIZE, TEST_ICON_SIZE);
+   for( int y=0; y<TEST_ICON_SIZE; y++ )
+   for( int x=0; x<TEST_ICON_SIZE; x++ )
+   {
+      unsigned char* pPixel = pIcon->data + (y * TEST_ICON_SIZE + x) * 4;
+      int dx = x - TEST_ICON_SIZE/2;
+      int dy = y - TEST_ICON_SIZE/2;
+      int iDist = dx*dx + dy*dy;
+      pPixel[0] = 255;
+      pPixel[1] = 255 - 4*y;
+      pPixel[2] = 4*x;
+      pPixel[3] = (iDist < 400)?255:((iDist < 576)?128:0);
+   }
+   *ppIcon = pIcon;
+}
+
+// Text is drawn one glyph at a time, as RenderEngineRaw::_drawSimpleText() does
+static void _draw_text(struct _fbg* pFBG, struct _fbg_img* pFont, const t_test_draw_op* pOp)
+{
+   pFBG->mix_color.r = pOp->uColor[0];
+   pFBG->mix_color.g = pOp->uColor[1];
+   pFBG->mix_color.b = pOp->uColor[2];
+   pFBG->mix_color.a = pOp->uColor[3];
+   pFBG->disableFontOutline = (pOp->iType == OP_TEXT_NO_OUTLINE)?1:0;
+
+   int x = pOp->x;
+   for( const char* szText = pOp->szText; *szText; szText++ )
+   {
+      int iGlyph = ((*szText) - 32) % 96;
+      if ( ((*szText) != ' ') && (iGlyph >= 0) && (x + TEST_GLYPH_WIDTH < TEST_FRAME_WIDTH) )
+         fbg_imageClipAColor(pFBG, pFont, x, pOp->y, (iGlyph % 16) * TEST_GLYPH_WIDTH, (iGlyph / 16) * TEST_GLYPH_HEIGHT, TEST_GLYPH_WIDTH, TEST_GLYPH_HEIGHT);
+      x += TEST_GLYPH_WIDTH - 1;
+   }
+   pFBG->disableFontOutline = 0;
+}
+
+static void _draw_frame(struct _fbg* pFBG, struct _fbg_img* pFont, struct _fbg_img* pIcon)
+{
+   fbg_clear(pFBG, 0);
+   for( int i=0; i<(int)(sizeof(s_TestFrameOps)/sizeof(s_TestFrameOps[0])); i++ )
+   {
+      const t_test_draw_op* pOp = &s_TestFrameOps[i];
+      const unsigned char* c = pOp->uColor;
+      switch ( pOp->iType )
+      {
+         case OP_RECT_BLEND: fbg_recta(pFBG, pOp->x, pOp->y, pOp->w, pOp->h, c[0], c[1], c[2], c[3]); break;
+         case OP_RECT: fbg_rect(pFBG, pOp->x, pOp->y, pOp->w, pOp->h, c[0], c[1], c[2], c[3]); break;
+         case OP_HLINE: fbg_hline(pFBG, pOp->x, pOp->y, pOp->w, c[0], c[1], c[2], c[3]); break;
+         case OP_VLINE: fbg_vline(pFBG, pOp->x, pOp->y, pOp->h, c[0], c[1], c[2], c[3]); break;
+         case OP_TEXT:
+         case OP_TEXT_NO_OUTLINE: _draw_text(pFBG, pFont, pOp); break;
+         case OP_ICON: fbg_imageClipA(pFBG, pIcon, pOp->x, pOp->y, 0, 0, TEST_ICON_SIZE, TEST_ICON_SIZE); break;
+         case OP_ICON_SCALED:
+            pFBG->mix_color.r = c[0];
+            pFBG->mix_color.g = c[1];
+            pFBG->mix_color.b = c[2];
+            pFBG->mix_color.a = c[3];
+            fbg_imageDrawAlpha(pFBG, pIcon, pOp->x, pOp->y, pOp->w, pOp->h, 0, 0, TEST_ICON_SIZE, TEST_ICON_SIZE);
+            break;
+      }
+   }
+}
+
+static unsigned int _compute_hash(const unsigned char* pData, int iLength)
+{
+   unsigned int uHash = 2166136261u;
+   for( int i=0; i<iLength; i++ )
+      uHash = (uHash ^ pData[i]) * 16777619u;
+   return uHash;
+}
+
+static void _benchmark_frame(int iFrames)
+{
+   printf("\nRecorded OSD frame, %dx%d, %d draw calls, %d frames:\n", TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT, (int)(sizeof(s_TestFrameOps)/sizeof(s_TestFrameOps[0])), iFrames);
+
+   struct _fbg* pFBG = fbg_customSetup(TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT, 4, 1, 0, NULL, NULL, NULL, NULL, NULL);
+   if ( NULL == pFBG )
+   {
+      _check(false, "create frame buffer");
+      return;
+   }
+   struct _fbg_img* pFont = NULL;
+   struct _fbg_img* pIcon = NULL;
+   _create_font_atlas(pFBG, &pFont, &pIcon);
+
+   int iTypes[3] = { FBG_BLEND_KERNELS_SCALAR, FBG_BLEND_KERNELS_SSE2, FBG_BLEND_KERNELS_NEON };
+   unsigned int uHashRef = 0;
+   unsigned long long uTimeRef = 0;
+   for( int k=0; k<3; k++ )
+   {
+      t_fbg_blend_kernels kernels;
+      if ( ! fbg_blend_get_kernels(iTypes[k], &kernels) )
+         continue;
+      fbg_blend_set_kernels(iTypes[k]);
+
+      _draw_frame(pFBG, pFont, pIcon);
+      unsigned int uHash = _compute_hash(pFBG->back_buffer, pFBG->size);
+
+      unsigned long long uTimeStart = _get_time_us();
+      for( int i=0; i<iFrames; i++ )
+         _draw_frame(pFBG, pFont, pIcon);
+      unsigned long long uTime = _get_time_us() - uTimeStart;
+      if ( 0 == uTime )
+         uTime = 1;
+
+      if ( iTypes[k] == FBG_BLEND_KERNELS_SCALAR )
+      {
+         uHashRef = uHash;
+         uTimeRef = uTime;
+      }
+      printf("  %-6s: %.3f ms/frame, %.2fx, frame hash %08X\n", kernels.szName, (double)uTime/1000.0/(double)iFrames, (double)uTimeRef/(double)uTime, uHash);
+      if ( iTypes[k] != FBG_BLEND_KERNELS_SCALAR )
+         _check(uHash == uHashRef, "frame identical to scalar");
+   }
+   fbg_blend_set_kernels(FBG_BLEND_KERNELS_AUTO);
+
+   fbg_freeImage(pFont);
+   fbg_freeImage(pIcon);
+   fbg_close(pFBG);
+}
+
+int main(int argc, char *argv[])
+{
+   int iFrames = 200;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-frames") )
+         iFrames = atoi(argv[i+1]);
+   }
+   if ( iFrames < 1 )
+      iFrames = 1;
+
+   srand(1234);
+   fbg_blend_set_kernels(FBG_BLEND_KERNELS_AUTO);
+   printf("Selected blend kernels: %s\n", fbg_blend_get_kernels_name());
+   _test_scalar_reference();
+   _test_kernels(FBG_BLEND_KERNELS_SSE2);
+   _test_kernels(FBG_BLEND_KERNELS_NEON);
+   _benchmark_frame(iFrames);
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nRender blend test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nRender blend test passed.\n");
+   return 0;
+}
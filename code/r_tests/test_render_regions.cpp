@@ -0,0 +1,221 @@
+#include "../base/base.h"
+#include "../renderer/render_engine_raw.h"
+#include "../renderer/fbg_dispmanx.h"
+#include "test_utils.h"
+
+// Tests the damage tracking of the RAW renderer: frames composed from the cached render regions must
+// display the same pixels as frames drawn directly into the back buffer.
+// The dispmanx display is replaced by two in memory resources (this test provides fbg_dispmanxSetup and
+// fbg_dispmanxDrawRows, so it is not linked with fbg_dispmanx.o).
+//
+// Usage: test_render_regions
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 200
+#define TEST_FRAMES 300
+#define TEST_REGIONS 12
+#define TEST_MAX_PIXEL_DIFF 3
+
+typedef struct
+{
+   float fX, fY, fWidth, fHeight;
+   int r, g, b;
+   float fAlpha;
+   bool bBlend;
+   bool bShow;
+   u32 uContentHash;
+} t_test_region;
+
+static u8 s_uDisplayResources[2][TEST_WIDTH*TEST_HEIGHT*4];
+static int s_iBackResource = 0;
+static int s_iFlips = 0;
+static int s_iRowsUploaded = 0;
+// The reference engine draws into its own back buffer only
+static bool s_bDrawingReference = false;
+
+static void _display_draw(struct _fbg* pFBG)
+{
+   if ( s_bDrawingReference )
+      return;
+   memcpy(s_uDisplayResources[s_iBackResource], pFBG->back_buffer, TEST_WIDTH*TEST_HEIGHT*4);
+   s_iRowsUploaded += TEST_HEIGHT;
+}
+
+static void _display_flip(struct _fbg* pFBG)
+{
+   if ( s_bDrawingReference )
+      return;
+   s_iBackResource = 1 - s_iBackResource;
+   s_iFlips++;
+}
+
+struct _fbg *fbg_dispmanxSetup(uint32_t displayNumber, VC_IMAGE_TYPE_T image_type)
+{
+   return fbg_customSetup(TEST_WIDTH, TEST_HEIGHT, 4, 1, 0, NULL, _display_draw, _display_flip, NULL, NULL);
+}
+
+void fbg_dispmanxDrawRows(struct _fbg *fbg, int start_row, int rows_count)
+{
+   s_iRowsUploaded += rows_count;
+   memcpy(s_uDisplayResources[s_iBackResource] + start_row*TEST_WIDTH*4, fbg->back_buffer + start_row*fbg->line_length, rows_count*TEST_WIDTH*4);
+}
+
+class TestRenderEngineRaw: public RenderEngineRaw
+{
+   public:
+      u8* getBackBuffer() { return m_pFBG->back_buffer; }
+      bool frameTracksDamage() { return m_bFrameTracksDamage; }
+};
+
+static void _draw_regions(RenderEngine* pEngine, t_test_region* pRegions, int iCount)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( ! pRegions[i].bShow )
+         continue;
+      t_test_region* p = &(pRegions[i]);
+      if ( pEngine->beginRegion(100+i, p->fX, p->fY, p->fWidth, p->fHeight, p->uContentHash) )
+      {
+         pEngine->setStroke(0,0,0,0);
+         pEngine->setFill(p->r, p->g, p->b, p->fAlpha);
+         if ( ! p->bBlend )
+            pEngine->disableRectBlending();
+         pEngine->drawRect(p->fX, p->fY, p->fWidth*0.5, p->fHeight);
+         pEngine->setFill(p->b, p->r, p->g, p->fAlpha*0.5);
+         pEngine->drawRect(p->fX + p->fWidth*0.25, p->fY + p->fHeight*0.25, p->fWidth*0.5, p->fHeight*0.5);
+         pEngine->enableRectBlending();
+      }
+      pEngine->endRegion();
+   }
+}
+
+static void _init_regions(t_test_region* pRegions, int iCount)
+{
+   for( int i=0; i<iCount; i++ )
+   {
+      pRegions[i].fX = (rand()%80)/100.0;
+      pRegions[i].fY = (rand()%80)/100.0;
+      pRegions[i].fWidth = 0.05 + (rand()%20)/100.0;
+      pRegions[i].fHeight = 0.05 + (rand()%20)/100.0;
+      pRegions[i].r = rand()%256;
+      pRegions[i].g = rand()%256;
+      pRegions[i].b = rand()%256;
+      pRegions[i].fAlpha = (rand()%100)/100.0;
+      pRegions[i].bBlend = true;
+      pRegions[i].bShow = true;
+      pRegions[i].uContentHash = 1 + rand();
+   }
+   // A region with unknown content, compared to its cache each frame
+   pRegions[3].uContentHash = 0;
+}
+
+static void _change_regions(t_test_region* pRegions, int iCount)
+{
+   for( int k=0; k<2; k++ )
+   {
+      int i = rand() % iCount;
+      switch ( rand() % 5 )
+      {
+         case 0: pRegions[i].fX = (rand()%80)/100.0; pRegions[i].uContentHash++; break;
+         case 1: pRegions[i].bShow = ! pRegions[i].bShow; break;
+         case 2: pRegions[i].r = rand()%256; pRegions[i].uContentHash++; break;
+         // Content hash changes, same pixels
+         case 3: if ( 0 != pRegions[i].uContentHash ) pRegions[i].uContentHash++; break;
+         default: break;
+      }
+   }
+}
+
+// Draws one frame with both engines and returns the max difference between the displayed pixels and the reference
+static int _draw_and_compare(TestRenderEngineRaw* pEngine, TestRenderEngineRaw* pReference, t_test_region* pRegions, int iCount, bool bTrackDamage)
+{
+   if ( bTrackDamage )
+      pEngine->enableDamageTrackingForNextFrame();
+   pEngine->startFrame();
+   _draw_regions(pEngine, pRegions, iCount);
+   pEngine->endFrame();
+
+   pReference->startFrame();
+   _draw_regions(pReference, pRegions, iCount);
+
+   // The displayed resource is the one that is not the back one
+   u8* pDisplayed = s_uDisplayResources[1-s_iBackResource];
+   u8* pExpected = pReference->getBackBuffer();
+   int iMaxDiff = 0;
+   for( int i=0; i<TEST_WIDTH*TEST_HEIGHT*4; i++ )
+   {
+      int iDiff = abs((int)pDisplayed[i] - (int)pExpected[i]);
+      if ( iDiff > iMaxDiff )
+         iMaxDiff = iDiff;
+   }
+
+   s_bDrawingReference = true;
+   pReference->endFrame();
+   s_bDrawingReference = false;
+   return iMaxDiff;
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestRenderRegions");
+   log_enable_stdout();
+   srand(7);
+
+   TestRenderEngineRaw* pEngine = new TestRenderEngineRaw();
+   TestRenderEngineRaw* pReference = new TestRenderEngineRaw();
+   t_test_region regions[TEST_REGIONS];
+   _init_regions(regions, TEST_REGIONS);
+
+   printf("\nTesting render regions damage tracking (%d x %d, %d frames):\n", TEST_WIDTH, TEST_HEIGHT, TEST_FRAMES);
+
+   int iMaxDiff = 0;
+   int iSkippedFrames = 0;
+   s_iRowsUploaded = 0;
+   for( int iFrame=0; iFrame<TEST_FRAMES; iFrame++ )
+   {
+      if ( (iFrame > 0) && ((iFrame % 7) != 0) )
+         _change_regions(regions, TEST_REGIONS);
+      int iFlips = s_iFlips;
+      // Some frames are drawn without damage tracking, as when a menu is shown
+      int iDiff = _draw_and_compare(pEngine, pReference, regions, TEST_REGIONS, (iFrame % 50) != 25);
+      if ( iDiff > iMaxDiff )
+         iMaxDiff = iDiff;
+      if ( s_iFlips == iFlips )
+         iSkippedFrames++;
+   }
+   printf("  max pixel difference: %d, unchanged frames not flipped: %d, rows uploaded per frame: %d of %d\n", iMaxDiff, iSkippedFrames, s_iRowsUploaded/TEST_FRAMES, TEST_HEIGHT);
+   _check(iMaxDiff <= TEST_MAX_PIXEL_DIFF, "composed frames match direct drawing");
+   _check(iSkippedFrames > 0, "unchanged frames are not flipped");
+   _check(s_iRowsUploaded/TEST_FRAMES < TEST_HEIGHT, "only damaged rows are uploaded");
+
+   // A region drawn without blending can't be composed from the cache: damage tracking stops after that frame
+   regions[5].bBlend = false;
+   regions[5].bShow = true;
+   regions[5].fAlpha = 0.5;
+   regions[5].uContentHash++;
+   _draw_and_compare(pEngine, pReference, regions, TEST_REGIONS, true);
+   iMaxDiff = 0;
+   bool bTracked = false;
+   for( int iFrame=0; iFrame<20; iFrame++ )
+   {
+      _change_regions(regions, TEST_REGIONS);
+      int iDiff = _draw_and_compare(pEngine, pReference, regions, TEST_REGIONS, true);
+      if ( iDiff > iMaxDiff )
+         iMaxDiff = iDiff;
+      if ( pEngine->frameTracksDamage() )
+         bTracked = true;
+   }
+   _check(! bTracked, "damage tracking is disabled after a region is drawn without blending");
+   _check(iMaxDiff <= TEST_MAX_PIXEL_DIFF, "frames match direct drawing after a region is drawn without blending");
+
+   delete pEngine;
+   delete pReference;
+
+   if ( s_iTotalErrors > 0 )
+   {
+      printf("\nRender regions test FAILED: %d errors.\n", s_iTotalErrors);
+      return 1;
+   }
+   printf("\nRender regions test passed.\n");
+   return 0;
+}
@@ -0,0 +1,283 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../radio/radiopackets2.h"
+#include "../radio/radiopackets_retr.h"
+#include "test_utils.h"
+
+// Tests the compact encoding of the video retransmission requests: round trips typical loss patterns
+// and random ones, compares the size with the PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS format and checks
+// that malformed buffers are rejected. The controller sends the legacy format when it is smaller (a few isolated packets).
+//
+// Usage: test_retr_requests [-iterations N]
+
+#define TEST_MAX_REQUESTS 256
+
+// Same size as built by the controller for PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS (after the packet header)
+static int _get_legacy_size(int iCount)
+{
+   return sizeof(u32) + 2*sizeof(u8) + iCount*(sizeof(u32) + sizeof(u8));
+}
+
+static int _get_compact_size(int iEncodedLength)
+{
+   return sizeof(u32) + sizeof(u8) + iEncodedLength;
+}
+
+// Returns true if the requests decode back to the same list
+static bool _round_trip(u32* pBlocks, u8* pPackets, int iCount, int* piCompactSize)
+{
+   u8 uBuffer[MAX_PACKET_TOTAL_SIZE];
+   int iLength = 0;
+   int iEncoded = radio_packet_retr_request_compact_encode(uBuffer, sizeof(uBuffer), pBlocks, pPackets, iCount, &iLength);
+   if ( NULL != piCompactSize )
+      *piCompactSize = _get_compact_size(iLength);
+   if ( iEncoded != iCount )
+      return false;
+
+   u32 uBlocks[TEST_MAX_REQUESTS];
+   u8 uPackets[TEST_MAX_REQUESTS];
+   int iDecoded = radio_packet_retr_request_compact_decode(uBuffer, iLength, uBlocks, uPackets, TEST_MAX_REQUESTS);
+   if ( iDecoded != iCount )
+      return false;
+   for( int i=0; i<iCount; i++ )
+   {
+      if ( (uBlocks[i] != pBlocks[i]) || (uPackets[i] != pPackets[i]) )
+         return false;
+   }
+   return true;
+}
+
+static void _test_pattern(const char* szName, u32* pBlocks, u8* pPackets, int iCount, bool bExpectSmaller)
+{
+   int iCompactSize = 0;
+   bool bOk = _round_trip(pBlocks, pPackets, iCount, &iCompactSize);
+   printf("%s: %d packets, legacy: %d bytes, compact: %d bytes\n", szName, iCount, _get_legacy_size(iCount), iCompactSize);
+   _check(bOk, "round trip");
+   if ( bExpectSmaller )
+      _check(iCompactSize < _get_legacy_size(iCount), "smaller than legacy format");
+}
+
+static void _test_loss_patterns()
+{
+   u32 uBlocks[TEST_MAX_REQUESTS];
+   u8 uPackets[TEST_MAX_REQUESTS];
+   int iCount = 0;
+
+   printf("\nTesting loss patterns:\n");
+
+   uBlocks[0] = 100000; uPackets[0] = 5;
+   _test_pattern("Single packet", uBlocks, uPackets, 1, false);
+
+   iCount = 0;
+   for( int k=10; k<MAX_DATA_PACKETS_IN_BLOCK; k++ )
+   {
+      uBlocks[iCount] = 100000;
+      uPackets[iCount] = k;
+      iCount++;
+   }
+   _test_pattern("Burst at block end", uBlocks, uPackets, iCount, true);
+
+   iCount = 0;
+   for( int k=0; k<MAX_DATA_PACKETS_IN_BLOCK; k++ )
+   {
+      uBlocks[iCount] = 100000;
+      uPackets[iCount] = k;
+      iCount++;
+   }
+   _test_pattern("Full block", uBlocks, uPackets, iCount, true);
+
+   iCount = 0;
+   for( int b=0; b<10; b++ )
+   for( int k=b%3; k<MAX_DATA_PACKETS_IN_BLOCK; k += 7 )
+   {
+      uBlocks[iCount] = 100000 + b;
+      uPackets[iCount] = k;
+      iCount++;
+   }
+   _test_pattern("Scattered over 10 blocks", uBlocks, uPackets, iCount, true);
+
+   iCount = 0;
+   for( int b=0; b<8; b++ )
+   for( int k=0; k<5; k++ )
+   {
+      uBlocks[iCount] = 100000 + 3*b;
+      uPackets[iCount] = (b*5 + k*3) % MAX_DATA_PACKETS_IN_BLOCK;
+      iCount++;
+   }
+   // Keep packets sorted inside each block, as the controller requests them
+   for( int i=0; i<iCount; i++ )
+   for( int j=i+1; j<iCount; j++ )
+   {
+      if ( (uBlocks[j] == uBlocks[i]) && (uPackets[j] < uPackets[i]) )
+      {
+         u8 uTmp = uPackets[i];
+         uPackets[i] = uPackets[j];
+         uPackets[j] = uTmp;
+      }
+   }
+   _test_pattern("40 packets over 8 blocks", uBlocks, uPackets, iCount, true);
+
+   uBlocks[0] = 100000; uPackets[0] = MAX_TOTAL_PACKETS_IN_BLOCK-1;
+   uBlocks[1] = 100255; uPackets[1] = 0;
+   _test_pattern("Last packet index and max block delta", uBlocks, uPackets, 2, false);
+}
+
+static void _test_random_patterns(int iIterations)
+{
+   printf("\nTesting %d random loss patterns:\n", iIterations);
+   int iFailed = 0;
+   int iSmaller = 0;
+   int iTested = 0;
+   long long llTotalLegacy = 0;
+   long long llTotalCompact = 0;
+   for( int i=0; i<iIterations; i++ )
+   {
+      u32 uBlocks[TEST_MAX_REQUESTS];
+      u8 uPackets[TEST_MAX_REQUESTS];
+      int iCount = 0;
+      u32 uBlock = (u32)rand();
+      int iBlocks = 1 + rand() % 10;
+      int iLossPercent = 1 + rand() % 60;
+      for( int b=0; (b<iBlocks) && (iCount < DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT); b++ )
+      {
+         for( int k=0; (k<MAX_DATA_PACKETS_IN_BLOCK) && (iCount < DEFAULT_VIDEO_RETRANS_MAX_PCOUNT_COMPACT); k++ )
+         {
+            if ( (rand() % 100) >= iLossPercent )
+               continue;
+            uBlocks[iCount] = uBlock;
+            uPackets[iCount] = k;
+            iCount++;
+         }
+         uBlock += 1 + rand() % 4;
+      }
+      if ( 0 == iCount )
+         continue;
+      int iCompactSize = 0;
+      if ( ! _round_trip(uBlocks, uPackets, iCount, &iCompactSize) )
+         iFailed++;
+      if ( iCompactSize < _get_legacy_size(iCount) )
+         iSmaller++;
+      llTotalLegacy += _get_legacy_size(iCount);
+      llTotalCompact += iCompactSize;
+      iTested++;
+   }
+   printf("Total legacy: %lld bytes, total compact: %lld bytes (%.1f%%), compact smaller in %d of %d requests\n",
+      llTotalLegacy, llTotalCompact, (llTotalLegacy > 0)?(100.0*(double)llTotalCompact/(double)llTotalLegacy):0.0, iSmaller, iTested);
+   _check(0 == iFailed, "random round trips");
+}
+
+static void _test_limits()
+{
+   printf("\nTesting limits:\n");
+   u32 uBlocks[TEST_MAX_REQUESTS];
+   u8 uPackets[TEST_MAX_REQUESTS];
+   u8 uBuffer[MAX_PACKET_TOTAL_SIZE];
+   int iLength = 0;
+
+   for( int i=0; i<4; i++ )
+   {
+      uBlocks[i] = 500 + i*10;
+      uPackets[i] = 3;
+   }
+   int iEncoded = radio_packet_retr_request_compact_encode(uBuffer, RETR_REQUEST_COMPACT_HEADER_SIZE + 6, uBlocks, uPackets, 4, &iLength);
+   _check((iEncoded == 2) && (iLength == RETR_REQUEST_COMPACT_HEADER_SIZE + 6), "stops when the buffer is full");
+   int iDecoded = radio_packet_retr_request_compact_decode(uBuffer, iLength, uBlocks + 10, uPackets + 10, 10);
+   _check((iDecoded == 2) && (uBlocks[10] == 500) && (uBlocks[11] == 510), "decodes the requests that fit");
+
+   uBlocks[0] = 500; uBlocks[1] = 756;
+   iEncoded = radio_packet_retr_request_compact_encode(uBuffer, sizeof(uBuffer), uBlocks, uPackets, 2, &iLength);
+   _check(iEncoded == 1, "stops on block delta over 255");
+
+   uBlocks[0] = 500; uBlocks[1] = 499;
+   iEncoded = radio_packet_retr_request_compact_encode(uBuffer, sizeof(uBuffer), uBlocks, uPackets, 2, &iLength);
+   _check(iEncoded == 1, "stops on unsorted blocks");
+
+   uBlocks[0] = 500; uPackets[0] = MAX_TOTAL_PACKETS_IN_BLOCK;
+   iEncoded = radio_packet_retr_request_compact_encode(uBuffer, sizeof(uBuffer), uBlocks, uPackets, 1, &iLength);
+   _check((iEncoded == 0) && (iLength == 0), "rejects invalid packet index");
+
+   for( int k=0; k<MAX_DATA_PACKETS_IN_BLOCK; k++ )
+   {
+      uBlocks[k] = 500;
+      uPackets[k] = k;
+   }
+   iEncoded = radio_packet_retr_request_compact_encode(uBuffer, sizeof(uBuffer), uBlocks, uPackets, MAX_DATA_PACKETS_IN_BLOCK, &iLength);
+   iDecoded = radio_packet_retr_request_compact_decode(uBuffer, iLength, uBlocks, uPackets, 5);
+   _check((iEncoded == MAX_DATA_PACKETS_IN_BLOCK) && (iDecoded == 5) && (uPackets[4] == 4), "decode truncates to max count");
+}
+
+static void _test_malformed()
+{
+   printf("\nTesting malformed buffers:\n");
+   u32 uBlocks[TEST_MAX_REQUESTS];
+   u8 uPackets[TEST_MAX_REQUESTS];
+
+   // Valid: block 1000, bitmap of one byte with packets 0 and 2
+   u8 uValid[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0xE8, 0x03, 0, 0, 1, 0, RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP | 1, 0x05 };
+   int iDecoded = radio_packet_retr_request_compact_decode(uValid, sizeof(uValid), uBlocks, uPackets, TEST_MAX_REQUESTS);
+   _check((iDecoded == 2) && (uBlocks[0] == 1000) && (uPackets[0] == 0) && (uPackets[1] == 2), "valid buffer");
+
+   u8 uTest[32];
+   memcpy(uTest, uValid, sizeof(uValid));
+   uTest[0] = RETR_REQUEST_COMPACT_FORMAT_VERSION + 1;
+   _check(-1 == radio_packet_retr_request_compact_decode(uTest, sizeof(uValid), uBlocks, uPackets, TEST_MAX_REQUESTS), "unknown version");
+
+   bool bAllTruncatedRejected = true;
+   for( int i=0; i<(int)sizeof(uValid); i++ )
+   {
+      if ( -1 != radio_packet_retr_request_compact_decode(uValid, i, uBlocks, uPackets, TEST_MAX_REQUESTS) )
+         bAllTruncatedRejected = false;
+   }
+   _check(bAllTruncatedRejected, "truncated buffers");
+
+   memcpy(uTest, uValid, sizeof(uValid));
+   uTest[sizeof(uValid)] = 0;
+   _check(-1 == radio_packet_retr_request_compact_decode(uTest, sizeof(uValid)+1, uBlocks, uPackets, TEST_MAX_REQUESTS), "trailing bytes");
+
+   memcpy(uTest, uValid, sizeof(uValid));
+   uTest[7] = RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP;
+   _check(-1 == radio_packet_retr_request_compact_decode(uTest, sizeof(uValid) - 1, uBlocks, uPackets, TEST_MAX_REQUESTS), "empty bitmap");
+
+   u8 uBigBitmap[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0, 0, 0, 0, 1, 0, RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP | 9, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+   _check(-1 == radio_packet_retr_request_compact_decode(uBigBitmap, sizeof(uBigBitmap), uBlocks, uPackets, TEST_MAX_REQUESTS), "bitmap too large");
+
+   u8 uNoRanges[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0, 0, 0, 0, 1, 0, 0 };
+   _check(-1 == radio_packet_retr_request_compact_decode(uNoRanges, sizeof(uNoRanges), uBlocks, uPackets, TEST_MAX_REQUESTS), "zero ranges");
+
+   u8 uBadRange[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0, 0, 0, 0, 1, 0, 1, MAX_TOTAL_PACKETS_IN_BLOCK-2, 3 };
+   _check(-1 == radio_packet_retr_request_compact_decode(uBadRange, sizeof(uBadRange), uBlocks, uPackets, TEST_MAX_REQUESTS), "range past block end");
+
+   u8 uEmptyRange[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0, 0, 0, 0, 1, 0, 1, 4, 0 };
+   _check(-1 == radio_packet_retr_request_compact_decode(uEmptyRange, sizeof(uEmptyRange), uBlocks, uPackets, TEST_MAX_REQUESTS), "empty range");
+
+   #if MAX_TOTAL_PACKETS_IN_BLOCK < 64
+   u8 uBadBitmap[] = { RETR_REQUEST_COMPACT_FORMAT_VERSION, 0, 0, 0, 0, 1, 0, RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP | 8, 0, 0, 0, 0, 0, 0, 0, 0x80 };
+   _check(-1 == radio_packet_retr_request_compact_decode(uBadBitmap, sizeof(uBadBitmap), uBlocks, uPackets, TEST_MAX_REQUESTS), "bitmap packet past block end");
+   #endif
+}
+
+int main(int argc, char *argv[])
+{
+   log_init("TestRetrRequests");
+
+   int iIterations = 10000;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-iterations") )
+         iIterations = atoi(argv[i+1]);
+   }
+
+   srand(1234);
+   _test_loss_patterns();
+   _test_random_patterns(iIterations);
+   _test_limits();
+   _test_malformed();
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nRetransmission requests test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nRetransmission requests test passed.\n");
+   return 0;
+}
@@ -0,0 +1,321 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../r_vehicle/video_tx_retr_scheduler.h"
+#include "test_utils.h"
+
+// Simulates the vehicle video link with synthetic retransmission request streams and compares
+// resending right away, in request order (the old behaviour), with the deadline scheduler.
+// The simulated controller drops a block the retransmission window after it last received a packet of it.
+// Reports the resends wasted (sent after the controller dropped the block, or duplicated by repeated
+// requests) and the latency added to new video packets. Also checks the scheduler queue rules.
+//
+// Usage: test_retr_scheduler [-seconds N]
+
+#define SIM_PACKETS_PER_MS 2.0 // link capacity
+#define SIM_BLOCK_PACKETS 12 // 8 data + 4 EC
+#define SIM_FPS_INTERVAL_MS 16
+#define SIM_FRAME_PACKETS 12
+#define SIM_KEYFRAME_PACKETS 120
+#define SIM_KEYFRAME_INTERVAL_MS 1000
+#define SIM_RETR_WINDOW_MS 60
+#define SIM_REQUEST_INTERVAL_MS 10
+#define SIM_SLICE_PACKETS 10
+#define SIM_MAX_BLOCKS 100000
+#define SIM_MAX_FRESH 400000
+
+typedef struct
+{
+   double fLinkFreeTime;
+   int iSentRetr;
+   int iWastedExpired;
+   int iWastedDuplicate;
+   double fFreshLatencyTotal;
+   double fFreshLatencyMax;
+   int iFreshSent;
+} t_sim_result;
+
+// Vehicle side: time the latest packet of the block was generated or sent
+static u32 s_uBlockLastSentTime[SIM_MAX_BLOCKS];
+// Controller side: time the latest packet of the block was received, and blocks dropped already
+static double s_fBlockLastReceivedTime[SIM_MAX_BLOCKS];
+static bool s_bBlockDropped[SIM_MAX_BLOCKS];
+static u32 s_uLastBlockReceived;
+static u32 s_uFreshGeneratedTime[SIM_MAX_FRESH];
+static u32 s_uLastRetrIdSent[SIM_MAX_BLOCKS][SIM_BLOCK_PACKETS];
+static int s_iCountSentForRetrId[SIM_MAX_BLOCKS][SIM_BLOCK_PACKETS];
+
+// Sends one packet on the link not earlier than fTime. Returns the time the packet is on air.
+static double _sim_transmit(t_sim_result* pResult, double fTime)
+{
+   double fStart = (fTime > pResult->fLinkFreeTime)?fTime:pResult->fLinkFreeTime;
+   pResult->fLinkFreeTime = fStart + 1.0/SIM_PACKETS_PER_MS;
+   return pResult->fLinkFreeTime;
+}
+
+// The controller receives a packet of the block. Returns false if the block was dropped already.
+static bool _sim_receive(u32 uBlock, double fOnAir)
+{
+   if ( (! s_bBlockDropped[uBlock]) && (s_fBlockLastReceivedTime[uBlock] > 0.0) )
+   if ( fOnAir >= s_fBlockLastReceivedTime[uBlock] + (double)SIM_RETR_WINDOW_MS )
+      s_bBlockDropped[uBlock] = true;
+   if ( s_bBlockDropped[uBlock] )
+      return false;
+   s_fBlockLastReceivedTime[uBlock] = fOnAir;
+   if ( uBlock > s_uLastBlockReceived )
+      s_uLastBlockReceived = uBlock;
+   return true;
+}
+
+// The vehicle sent a packet of the block: queued retransmissions of it get a later deadline
+static void _sim_block_sent(VideoTxRetrScheduler* pScheduler, u32 uBlock, u32 uTime)
+{
+   s_uBlockLastSentTime[uBlock] = uTime;
+   if ( NULL != pScheduler )
+      pScheduler->extendBlockDeadline(uBlock, uTime + SIM_RETR_WINDOW_MS - DEFAULT_VIDEO_RETRANS_DEADLINE_MARGIN_MS);
+}
+
+static void _sim_transmit_retr(t_sim_result* pResult, VideoTxRetrScheduler* pScheduler, u32 uTime, u32 uRetrId, u32 uBlock, int iPacket, int iSendCount)
+{
+   double fOnAir = _sim_transmit(pResult, (double)uTime);
+   _sim_block_sent(pScheduler, uBlock, uTime);
+   pResult->iSentRetr++;
+   if ( s_uLastRetrIdSent[uBlock][iPacket] == uRetrId )
+   {
+      s_iCountSentForRetrId[uBlock][iPacket]++;
+      if ( s_iCountSentForRetrId[uBlock][iPacket] > iSendCount )
+      {
+         pResult->iWastedDuplicate++;
+         return;
+      }
+   }
+   else
+   {
+      s_uLastRetrIdSent[uBlock][iPacket] = uRetrId;
+      s_iCountSentForRetrId[uBlock][iPacket] = 1;
+   }
+   if ( ! _sim_receive(uBlock, fOnAir) )
+      pResult->iWastedExpired++;
+}
+
+// iMode: 0 - no retransmissions, 1 - resend right away, 2 - scheduler
+static void _simulate(int iMode, int iSeconds, t_sim_result* pResult)
+{
+   memset(pResult, 0, sizeof(t_sim_result));
+   memset(s_uLastRetrIdSent, 0, sizeof(s_uLastRetrIdSent));
+   memset(s_iCountSentForRetrId, 0, sizeof(s_iCountSentForRetrId));
+   memset(s_uBlockLastSentTime, 0, sizeof(s_uBlockLastSentTime));
+   memset(s_fBlockLastReceivedTime, 0, sizeof(s_fBlockLastReceivedTime));
+   memset(s_bBlockDropped, 0, sizeof(s_bBlockDropped));
+   s_uLastBlockReceived = 0;
+
+   VideoTxRetrScheduler scheduler;
+   VideoTxRetrScheduler* pScheduler = (2 == iMode)?&scheduler:NULL;
+   srand(4321);
+
+   u32 uBlocksCount = 0;
+   int iBlockPacketsFilled = 0;
+   int iFreshGenerated = 0;
+   int iFreshNextToSend = 0;
+   u32 uRetrId = 0;
+
+   u32 uRequestBlocks[64];
+   u8 uRequestPackets[64];
+   int iRequestCount = 0;
+   u32 uLastRequestId = 0;
+
+   for( u32 uTime=1; uTime<(u32)iSeconds*1000; uTime++ )
+   {
+      // New video frames
+      if ( 0 == (uTime % SIM_FPS_INTERVAL_MS) )
+      {
+         int iPackets = (0 == (uTime % SIM_KEYFRAME_INTERVAL_MS))?SIM_KEYFRAME_PACKETS:(SIM_FRAME_PACKETS/2 + rand() % SIM_FRAME_PACKETS);
+         for( int i=0; (i<iPackets) && (iFreshGenerated < SIM_MAX_FRESH) && (uBlocksCount < SIM_MAX_BLOCKS); i++ )
+         {
+            s_uBlockLastSentTime[uBlocksCount] = uTime;
+            s_uFreshGeneratedTime[iFreshGenerated++] = uTime;
+            iBlockPacketsFilled++;
+            if ( iBlockPacketsFilled >= SIM_BLOCK_PACKETS )
+            {
+               iBlockPacketsFilled = 0;
+               uBlocksCount++;
+            }
+         }
+      }
+
+      // Retransmission requests: lost packets from recently received blocks, some already too old
+      // when the request arrives. Radio duplicates of a request repeat the same id.
+      bool bHasRequest = false;
+      u32 uThisRequestId = 0;
+      if ( (iMode != 0) && (0 == (uTime % SIM_REQUEST_INTERVAL_MS)) && (s_uLastBlockReceived > 20) )
+      {
+         uRetrId++;
+         uThisRequestId = uRetrId;
+         iRequestCount = 0;
+         u32 uFirstBlock = s_uLastBlockReceived - (rand() % 6);
+         int iBlocks = 1 + rand() % 3;
+         for( int b=0; b<iBlocks; b++ )
+         {
+            u32 uBlock = uFirstBlock + b;
+            if ( uBlock > s_uLastBlockReceived )
+               break;
+            int iLost = 1 + rand() % 4;
+            int iStart = rand() % (SIM_BLOCK_PACKETS - iLost);
+            for( int k=iStart; (k<iStart+iLost) && (iRequestCount < 64); k++ )
+            {
+               uRequestBlocks[iRequestCount] = uBlock;
+               uRequestPackets[iRequestCount] = k;
+               iRequestCount++;
+            }
+         }
+         uLastRequestId = uThisRequestId;
+         bHasRequest = true;
+      }
+      else if ( (iMode != 0) && (0 == ((uTime + 2) % SIM_REQUEST_INTERVAL_MS)) && (0 != uLastRequestId) && ((rand() % 100) < 30) )
+      {
+         uThisRequestId = uLastRequestId;
+         bHasRequest = true;
+      }
+
+      if ( bHasRequest )
+      {
+         int iSendCount = (iRequestCount < 4)?2:1;
+         if ( 1 == iMode )
+         {
+            for( int i=0; i<iRequestCount; i++ )
+            for( int c=0; c<iSendCount; c++ )
+               _sim_transmit_retr(pResult, NULL, uTime, uThisRequestId, uRequestBlocks[i], uRequestPackets[i], iSendCount);
+         }
+         else if ( scheduler.startRequest(uThisRequestId, uTime) )
+         {
+            for( int i=0; i<iRequestCount; i++ )
+            {
+               u32 uBlock = uRequestBlocks[i];
+               u32 uDeadline = s_uBlockLastSentTime[uBlock] + SIM_RETR_WINDOW_MS - DEFAULT_VIDEO_RETRANS_DEADLINE_MARGIN_MS;
+               scheduler.addPacket(uThisRequestId, uBlock, uRequestPackets[i], 0, iSendCount, uDeadline, uTime);
+            }
+         }
+      }
+
+      // Send slices while the link has room in this millisecond
+      while ( pResult->fLinkFreeTime < (double)(uTime+1) )
+      {
+         int iFreshPending = iFreshGenerated - iFreshNextToSend;
+         int iRetrPending = (2 == iMode)?scheduler.getQueuedCount():0;
+         if ( iFreshPending + iRetrPending <= 0 )
+            break;
+         int iSlice = iFreshPending + iRetrPending;
+         if ( iSlice > SIM_SLICE_PACKETS )
+            iSlice = SIM_SLICE_PACKETS;
+
+         if ( iRetrPending > 0 )
+         {
+            int iBudget = scheduler.getSliceBudget(iSlice, iFreshPending);
+            type_tx_video_retr_request request;
+            int iSent = 0;
+            while ( (iSent < iBudget) && scheduler.popNext(uTime, &request) )
+            {
+               for( int c=0; c<request.iSendCount; c++ )
+                  _sim_transmit_retr(pResult, pScheduler, uTime, request.uRetransmissionId, request.uVideoBlockIndex, request.iVideoBlockPacketIndex, request.iSendCount);
+               iSent++;
+            }
+            iSlice -= iSent;
+         }
+         for( int i=0; (i<iSlice) && (iFreshNextToSend < iFreshGenerated); i++ )
+         {
+            double fOnAir = _sim_transmit(pResult, (double)uTime);
+            u32 uBlock = (u32)(iFreshNextToSend / SIM_BLOCK_PACKETS);
+            _sim_block_sent(pScheduler, uBlock, uTime);
+            _sim_receive(uBlock, fOnAir);
+            double fLatency = fOnAir - (double)s_uFreshGeneratedTime[iFreshNextToSend];
+            pResult->fFreshLatencyTotal += fLatency;
+            if ( fLatency > pResult->fFreshLatencyMax )
+               pResult->fFreshLatencyMax = fLatency;
+            pResult->iFreshSent++;
+            iFreshNextToSend++;
+         }
+      }
+   }
+}
+
+static void _test_queue_rules()
+{
+   printf("\nTesting scheduler queue rules:\n");
+   VideoTxRetrScheduler scheduler;
+   type_tx_video_retr_request request;
+
+   _check(scheduler.startRequest(10, 1000), "new retransmission id accepted");
+   _check(!scheduler.startRequest(10, 1010), "repeated retransmission id ignored");
+   _check(scheduler.startRequest(10, 1000 + TX_VIDEO_RETR_DUPLICATE_ID_TIMEOUT_MS), "old retransmission id accepted again");
+
+   _check(!scheduler.addPacket(10, 5, 1, 0, 1, 1000, 1000), "expired packet dropped on add");
+   scheduler.addPacket(10, 7, 2, 0, 1, 1100, 1000);
+   scheduler.addPacket(10, 6, 3, 0, 1, 1050, 1000);
+   scheduler.addPacket(10, 6, 1, 0, 1, 1050, 1000);
+   scheduler.addPacket(11, 6, 3, 0, 2, 1050, 1001);
+   _check(scheduler.getQueuedCount() == 3, "same packet requested again is merged");
+
+   _check(scheduler.popNext(1010, &request) && (request.uVideoBlockIndex == 6) && (request.iVideoBlockPacketIndex == 1), "earliest deadline first, then lowest packet");
+   _check(scheduler.popNext(1010, &request) && (request.iVideoBlockPacketIndex == 3) && (request.uRetransmissionId == 11) && (request.iSendCount == 2), "merged packet uses latest id and send count");
+   _check(!scheduler.popNext(1100, &request), "expired packet dropped on send");
+   _check(scheduler.getCountDroppedExpired() == 2, "expired packets counted");
+
+   scheduler.addPacket(12, 8, 0, 0, 1, 1120, 1100);
+   scheduler.addPacket(12, 8, 1, 0, 1, 1120, 1100);
+   scheduler.addPacket(13, 8, 0, 0, 1, 1150, 1110);
+   scheduler.extendBlockDeadline(8, 1180);
+   scheduler.extendBlockDeadline(8, 1160);
+   _check(scheduler.popNext(1170, &request) && (request.iVideoBlockPacketIndex == 0) && (request.uDeadlineTime == 1180), "deadline extended when the block is sent again");
+   _check(scheduler.popNext(1170, &request) && (request.iVideoBlockPacketIndex == 1) && (request.uDeadlineTime == 1180), "deadline extension applies to all packets of the block");
+
+   scheduler.addPacket(12, 9, 0, 0, 1, 0, 1000);
+   _check(scheduler.getSliceBudget(10, 20) == (10*DEFAULT_VIDEO_RETRANS_AIRTIME_PERCENT)/100, "budget share with new video pending");
+   _check(scheduler.getSliceBudget(10, 0) == 10, "full slice without new video pending");
+   _check(scheduler.popNext(500000, &request), "packet without deadline never expires");
+}
+
+int main(int argc, char *argv[])
+{
+   int iSeconds = 60;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-seconds") )
+         iSeconds = atoi(argv[i+1]);
+   }
+   if ( iSeconds < 5 )
+      iSeconds = 5;
+   if ( iSeconds > 120 )
+      iSeconds = 120;
+
+   _test_queue_rules();
+
+   t_sim_result resultNone, resultDirect, resultScheduler;
+   _simulate(0, iSeconds, &resultNone);
+   _simulate(1, iSeconds, &resultDirect);
+   _simulate(2, iSeconds, &resultScheduler);
+
+   double fBaseLatency = resultNone.fFreshLatencyTotal/(double)resultNone.iFreshSent;
+   double fDirectLatency = resultDirect.fFreshLatencyTotal/(double)resultDirect.iFreshSent;
+   double fSchedulerLatency = resultScheduler.fFreshLatencyTotal/(double)resultScheduler.iFreshSent;
+
+   printf("\nSimulated %d seconds, %.1f packets/ms link, %d ms retransmission window:\n", iSeconds, SIM_PACKETS_PER_MS, SIM_RETR_WINDOW_MS);
+   printf("  No retransmissions: new video latency avg %.2f ms, max %.2f ms\n", fBaseLatency, resultNone.fFreshLatencyMax);
+   printf("  Resend right away:  %d resends, %d wasted (%d expired, %d duplicated), new video latency avg +%.2f ms, max %.2f ms\n",
+      resultDirect.iSentRetr, resultDirect.iWastedExpired + resultDirect.iWastedDuplicate, resultDirect.iWastedExpired, resultDirect.iWastedDuplicate,
+      fDirectLatency - fBaseLatency, resultDirect.fFreshLatencyMax);
+   printf("  Scheduler:          %d resends, %d wasted (%d expired, %d duplicated), new video latency avg +%.2f ms, max %.2f ms\n",
+      resultScheduler.iSentRetr, resultScheduler.iWastedExpired + resultScheduler.iWastedDuplicate, resultScheduler.iWastedExpired, resultScheduler.iWastedDuplicate,
+      fSchedulerLatency - fBaseLatency, resultScheduler.fFreshLatencyMax);
+
+   printf("\nChecking simulation results:\n");
+   _check(resultScheduler.iWastedDuplicate == 0, "scheduler sends no duplicated resends");
+   _check(resultScheduler.iWastedExpired < resultDirect.iWastedExpired, "scheduler wastes fewer resends on expired blocks");
+   _check(fSchedulerLatency <= fDirectLatency, "scheduler adds no more latency to new video");
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nRetransmission scheduler test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nRetransmission scheduler test passed.\n");
+   return 0;
+}
@@ -0,0 +1,244 @@
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../base/models.h"
+#include "../base/hardware_radio.h"
+#include "../r_vehicle/tx_routes.h"
+#include "test_utils.h"
+
+// Compares the vehicle tx routing done for each sent packet (checking the radio links and interfaces
+// capabilities every time, the old behaviour) with the precomputed tx routes table.
+// Radio interfaces are faked: packets are only counted, no pcap or serial writes are done.
+// Also checks that the routes table matches the per packet checks for different radio configurations.
+//
+// Usage: test_tx_routes [-packets N]
+
+#define TEST_RADIO_INTERFACES 4
+
+Model s_Model;
+shared_mem_radio_stats s_RadioStats;
+radio_hw_info_t s_RadioInfo[TEST_RADIO_INTERFACES];
+
+u32 s_uFakeSentPackets[TEST_RADIO_INTERFACES];
+u32 s_uFakeSentBytes[TEST_RADIO_INTERFACES];
+u32 s_uFakeSentChecksum = 0;
+
+static void _fake_radio_send(int iRadioInterfaceIndex, u8* pPacketData, int iLength)
+{
+   s_uFakeSentPackets[iRadioInterfaceIndex]++;
+   s_uFakeSentBytes[iRadioInterfaceIndex] += iLength;
+   s_uFakeSentChecksum += pPacketData[0] + pPacketData[iLength-1];
+}
+
+static void _reset_fake_radio()
+{
+   for( int i=0; i<TEST_RADIO_INTERFACES; i++ )
+   {
+      s_uFakeSentPackets[i] = 0;
+      s_uFakeSentBytes[i] = 0;
+   }
+   s_uFakeSentChecksum = 0;
+}
+
+// Radio link 1: two high capacity cards (video and data), radio link 2: SiK radio (data), radio link 3: a relay link
+
+static void _setup_radio_config()
+{
+   memset(&s_RadioStats, 0, sizeof(shared_mem_radio_stats));
+   memset(s_RadioInfo, 0, sizeof(s_RadioInfo));
+
+   u32 uWiFiFlags = RADIO_HW_CAPABILITY_FLAG_CAN_RX | RADIO_HW_CAPABILITY_FLAG_CAN_TX | RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_VIDEO | RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_DATA | RADIO_HW_CAPABILITY_FLAG_HIGH_CAPACITY;
+   u32 uSiKFlags = RADIO_HW_CAPABILITY_FLAG_CAN_RX | RADIO_HW_CAPABILITY_FLAG_CAN_TX | RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_DATA | RADIO_HW_CAPABILITY_FLAG_SERIAL_LINK | RADIO_HW_CAPABILITY_FLAG_SERIAL_LINK_SIK;
+
+   s_Model.radioLinksParams.links_count = 3;
+   s_Model.radioLinksParams.link_capabilities_flags[0] = uWiFiFlags;
+   s_Model.radioLinksParams.link_capabilities_flags[1] = uSiKFlags;
+   s_Model.radioLinksParams.link_capabilities_flags[2] = uWiFiFlags;
+   s_Model.relay_params.isRelayEnabledOnRadioLinkId = 2;
+
+   s_Model.radioInterfacesParams.interfaces_count = TEST_RADIO_INTERFACES;
+   s_Model.radioInterfacesParams.interface_link_id[0] = 0;
+   s_Model.radioInterfacesParams.interface_link_id[1] = 0;
+   s_Model.radioInterfacesParams.interface_link_id[2] = 1;
+   s_Model.radioInterfacesParams.interface_link_id[3] = 2;
+   s_Model.radioInterfacesParams.interface_capabilities_flags[0] = uWiFiFlags;
+   s_Model.radioInterfacesParams.interface_capabilities_flags[1] = uWiFiFlags;
+   s_Model.radioInterfacesParams.interface_capabilities_flags[2] = uSiKFlags;
+   s_Model.radioInterfacesParams.interface_capabilities_flags[3] = uWiFiFlags;
+
+   for( int i=0; i<TEST_RADIO_INTERFACES; i++ )
+   {
+      s_RadioInfo[i].openedForWrite = 1;
+      s_RadioInfo[i].isHighCapacityInterface = (i == 2)?0:1;
+      s_RadioInfo[i].isSerialRadio = (i == 2)?1:0;
+   }
+   for( int i=0; i<s_Model.radioLinksParams.links_count; i++ )
+      s_RadioStats.radio_links[i].matchingVehicleRadioLinkId = i;
+}
+
+// Returns true if the routes table has the same routes as the per packet checks
+
+static bool _routes_match_checks(type_tx_routes_table* pTable)
+{
+   for( int iClass=0; iClass<TX_ROUTE_CLASSES_COUNT; iClass++ )
+   {
+      type_tx_routes_list* pList = &(pTable->classes[iClass]);
+      int iRoute = 0;
+      for( int iRadioLinkId=0; iRadioLinkId<s_Model.radioLinksParams.links_count; iRadioLinkId++ )
+      {
+         int iRadioInterfaceIndex = tx_routes_find_radio_interface(&s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES, iRadioLinkId, iClass);
+         if ( iRadioInterfaceIndex < 0 )
+            continue;
+         if ( iRoute >= pList->iRoutesCount )
+            return false;
+         if ( (pList->routes[iRoute].iLocalRadioLinkId != iRadioLinkId) || (pList->routes[iRoute].iRadioInterfaceIndex != iRadioInterfaceIndex) )
+            return false;
+         if ( pList->routes[iRoute].bIsSerialRadio != (bool)s_RadioInfo[iRadioInterfaceIndex].isSerialRadio )
+            return false;
+         iRoute++;
+      }
+      if ( iRoute != pList->iRoutesCount )
+         return false;
+   }
+   return true;
+}
+
+static void _test_routes()
+{
+   type_tx_routes_table table;
+
+   printf("\nChecking tx routes:\n");
+   _setup_radio_config();
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+   _check(_routes_match_checks(&table), "default config routes match the per packet checks");
+   _check(table.classes[TX_ROUTE_CLASS_VIDEO].iRoutesCount == 1, "video is sent only on the high capacity radio link");
+   _check(table.classes[TX_ROUTE_CLASS_DATA].iRoutesCount == 2, "data is sent on the high capacity and SiK radio links");
+   _check(table.classes[TX_ROUTE_CLASS_DATA].routes[1].bIsSerialRadio, "SiK radio interface is marked as serial");
+
+   s_Model.relay_params.isRelayEnabledOnRadioLinkId = -1;
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+   _check(_routes_match_checks(&table), "relay disabled routes match the per packet checks");
+   _check(table.classes[TX_ROUTE_CLASS_VIDEO].iRoutesCount == 2, "video is sent on the former relay link");
+
+   s_Model.radioLinksParams.link_capabilities_flags[2] |= RADIO_HW_CAPABILITY_FLAG_USED_FOR_RELAY;
+   s_Model.radioLinksParams.link_capabilities_flags[0] |= RADIO_HW_CAPABILITY_FLAG_DISABLED;
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+   _check(_routes_match_checks(&table), "disabled link routes match the per packet checks");
+   _check(table.classes[TX_ROUTE_CLASS_VIDEO].iRoutesCount == 0, "no video routes when the high capacity link is disabled");
+
+   _setup_radio_config();
+   s_Model.radioInterfacesParams.interface_capabilities_flags[2] &= ~RADIO_HW_CAPABILITY_FLAG_CAN_TX;
+   s_RadioStats.radio_links[0].matchingVehicleRadioLinkId = 1;
+   s_RadioStats.radio_links[1].matchingVehicleRadioLinkId = 0;
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+   _check(_routes_match_checks(&table), "rotated radio links routes match the per packet checks");
+   _check((table.classes[TX_ROUTE_CLASS_DATA].iRoutesCount == 1) && (table.classes[TX_ROUTE_CLASS_DATA].routes[0].iLocalRadioLinkId == 1),
+      "data is sent on the local radio link now matching the high capacity link");
+
+   _setup_radio_config();
+   s_RadioStats.radio_links[1].matchingVehicleRadioLinkId = -1;
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+   _check(_routes_match_checks(&table), "unassigned local radio link routes match the per packet checks");
+   _check(table.classes[TX_ROUTE_CLASS_DATA].iRoutesCount == 1, "no routes on an unassigned local radio link");
+}
+
+// Both functions pick the radio interfaces the same way send_packet_to_radio_interfaces does
+
+static void _send_checking_each_packet(u8* pPacketData, int iLength, int iClass, bool bIsRetransmited)
+{
+   for( int iRadioLinkId=0; iRadioLinkId<s_Model.radioLinksParams.links_count; iRadioLinkId++ )
+   {
+      int iRadioInterfaceIndex = tx_routes_find_radio_interface(&s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES, iRadioLinkId, iClass);
+      if ( iRadioInterfaceIndex < 0 )
+         continue;
+      radio_hw_info_t* pRadioHWInfo = &(s_RadioInfo[iRadioInterfaceIndex]);
+      if ( ! pRadioHWInfo->openedForWrite )
+         continue;
+      if ( hardware_radio_is_serial_radio(pRadioHWInfo) )
+      {
+         if ( (iClass == TX_ROUTE_CLASS_DATA) && (! bIsRetransmited) )
+            _fake_radio_send(iRadioInterfaceIndex, pPacketData, iLength);
+      }
+      else
+         _fake_radio_send(iRadioInterfaceIndex, pPacketData, iLength);
+   }
+}
+
+static void _send_using_routes(type_tx_routes_table* pTable, u8* pPacketData, int iLength, int iClass, bool bIsRetransmited)
+{
+   type_tx_routes_list* pRoutes = &(pTable->classes[iClass]);
+   for( int iRoute=0; iRoute<pRoutes->iRoutesCount; iRoute++ )
+   {
+      type_tx_route* pRoute = &(pRoutes->routes[iRoute]);
+      if ( ! pRoute->pRadioHWInfo->openedForWrite )
+         continue;
+      if ( pRoute->bIsSerialRadio )
+      {
+         if ( (iClass == TX_ROUTE_CLASS_DATA) && (! bIsRetransmited) )
+            _fake_radio_send(pRoute->iRadioInterfaceIndex, pPacketData, iLength);
+      }
+      else
+         _fake_radio_send(pRoute->iRadioInterfaceIndex, pPacketData, iLength);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int iPackets = 5000000;
+   for( int i=1; i<argc-1; i++ )
+   {
+      if ( 0 == strcmp(argv[i], "-packets") )
+         iPackets = atoi(argv[i+1]);
+   }
+   if ( iPackets < 100000 )
+      iPackets = 100000;
+
+   _test_routes();
+
+   // Same packets stream for both: mostly video, some data and retransmissions
+
+   u8 uPacket[MAX_PACKET_TOTAL_SIZE];
+   for( int i=0; i<MAX_PACKET_TOTAL_SIZE; i++ )
+      uPacket[i] = (u8)(i*7);
+
+   _setup_radio_config();
+   type_tx_routes_table table;
+   tx_routes_build(&table, &s_Model, &s_RadioStats, s_RadioInfo, TEST_RADIO_INTERFACES);
+
+   _reset_fake_radio();
+   u32 uTime1 = get_current_timestamp_micros();
+   for( int i=0; i<iPackets; i++ )
+      _send_checking_each_packet(uPacket + (i & 0x3F), 1000 + (i & 0xFF), ((i % 5) == 0)?TX_ROUTE_CLASS_DATA:TX_ROUTE_CLASS_VIDEO, (i % 11) == 0);
+   u32 uTime2 = get_current_timestamp_micros();
+   u32 uSentPacketsChecks[TEST_RADIO_INTERFACES];
+   u32 uSentBytesChecks[TEST_RADIO_INTERFACES];
+   memcpy(uSentPacketsChecks, s_uFakeSentPackets, sizeof(uSentPacketsChecks));
+   memcpy(uSentBytesChecks, s_uFakeSentBytes, sizeof(uSentBytesChecks));
+   u32 uChecksumChecks = s_uFakeSentChecksum;
+
+   _reset_fake_radio();
+   u32 uTime3 = get_current_timestamp_micros();
+   for( int i=0; i<iPackets; i++ )
+      _send_using_routes(&table, uPacket + (i & 0x3F), 1000 + (i & 0xFF), ((i % 5) == 0)?TX_ROUTE_CLASS_DATA:TX_ROUTE_CLASS_VIDEO, (i % 11) == 0);
+   u32 uTime4 = get_current_timestamp_micros();
+
+   double fPacketsPerSecChecks = (double)iPackets * 1000000.0 / (double)((uTime2 > uTime1)?(uTime2 - uTime1):1);
+   double fPacketsPerSecRoutes = (double)iPackets * 1000000.0 / (double)((uTime4 > uTime3)?(uTime4 - uTime3):1);
+
+   printf("\nRouted %d packets over %d radio links (fake radio interfaces):\n", iPackets, s_Model.radioLinksParams.links_count);
+   printf("  Checks for each packet: %.2f M packets/sec\n", fPacketsPerSecChecks/1000000.0);
+   printf("  Tx routes table:        %.2f M packets/sec (x%.2f)\n", fPacketsPerSecRoutes/1000000.0, fPacketsPerSecRoutes/fPacketsPerSecChecks);
+
+   printf("\nChecking sent packets:\n");
+   _check(0 == memcmp(uSentPacketsChecks, s_uFakeSentPackets, sizeof(uSentPacketsChecks)), "same packets sent on each radio interface");
+   _check(0 == memcmp(uSentBytesChecks, s_uFakeSentBytes, sizeof(uSentBytesChecks)), "same bytes sent on each radio interface");
+   _check(uChecksumChecks == s_uFakeSentChecksum, "same packets data sent");
+   _check((s_uFakeSentPackets[1] == 0) && (s_uFakeSentPackets[3] == 0), "nothing sent on the second card of a link or on the relay link");
+
+   if ( 0 != s_iTotalErrors )
+   {
+      printf("\nTx routes test failed: %d errors.\n", s_iTotalErrors);
+      return -1;
+   }
+   printf("\nTx routes test passed.\n");
+   return 0;
+}
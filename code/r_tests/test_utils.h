@@ -0,0 +1,23 @@
+#pragma once
+
+// Shared check helpers for the self-checking r_tests programs.
+// Each test includes this once; the test's main returns non zero if s_iTotalErrors > 0.
+
+#include <stdio.h>
+#include <time.h>
+
+static int s_iTotalErrors = 0;
+
+static inline void _check(bool bCondition, const char* szTest)
+{
+   printf("  %s: %s\n", szTest, bCondition?"ok":"FAILED");
+   if ( ! bCondition )
+      s_iTotalErrors++;
+}
+
+static inline unsigned long long _get_time_us()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((unsigned long long)ts.tv_sec) * 1000000LL + ((unsigned long long)ts.tv_nsec) / 1000LL;
+}
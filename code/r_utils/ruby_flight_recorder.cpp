@@ -0,0 +1,300 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../base/base.h"
+#include "../base/config.h"
+#include "../r_station/flight_recorder.h"
+
+// Dumps the controller flight recorder file (written by ruby_rt_station) as text or CSV.
+// Usage: ruby_flight_recorder [-f file] [-sessions] [-session N] [-last N] [-csv]
+//   -sessions: list the recorded sessions and exit
+//   -session N: dump only the records of session N (as listed by -sessions)
+//   -last N: dump only the last N records (of the selected session, if any)
+//   -csv: output comma separated values, one line per slice and radio interface
+
+static t_flight_recorder_header s_Header;
+
+static void _print_usage()
+{
+   printf("Usage: ruby_flight_recorder [-f file] [-sessions] [-session N] [-last N] [-csv]\n");
+}
+
+static void _format_unix_time(u32 uUnixTime, u32 uOffsetMs, char* szOutput)
+{
+   time_t tTime = (time_t)uUnixTime + (time_t)(uOffsetMs/1000);
+   struct tm* pTM = localtime(&tTime);
+   if ( NULL == pTM )
+   {
+      sprintf(szOutput, "%u.%03u", (u32)tTime, uOffsetMs % 1000);
+      return;
+   }
+   sprintf(szOutput, "%04d-%02d-%02d %02d:%02d:%02d.%03u",
+      pTM->tm_year + 1900, pTM->tm_mon + 1, pTM->tm_mday, pTM->tm_hour, pTM->tm_min, pTM->tm_sec, uOffsetMs % 1000);
+}
+
+// Returns the number of sessions still stored in the header index
+static u32 _get_sessions_count()
+{
+   if ( s_Header.uCountSessions > FLIGHT_RECORDER_MAX_SESSIONS )
+      return FLIGHT_RECORDER_MAX_SESSIONS;
+   return s_Header.uCountSessions;
+}
+
+static t_flight_recorder_session* _get_session(u32 uSession)
+{
+   return &(s_Header.sessions[uSession % FLIGHT_RECORDER_MAX_SESSIONS]);
+}
+
+static u32 _get_first_available_record()
+{
+   if ( s_Header.uNextRecordIndex > s_Header.uMaxRecords )
+      return s_Header.uNextRecordIndex - s_Header.uMaxRecords;
+   return 0;
+}
+
+static void _list_sessions()
+{
+   u32 uFirstSession = s_Header.uCountSessions - _get_sessions_count();
+   printf("%u sessions recorded, %u records written (%u available), %u ms per record.\n",
+      s_Header.uCountSessions, s_Header.uNextRecordIndex, s_Header.uNextRecordIndex - _get_first_available_record(), s_Header.uSliceIntervalMs);
+   for( u32 u=uFirstSession; u<s_Header.uCountSessions; u++ )
+   {
+      t_flight_recorder_session* pSession = _get_session(u);
+      u32 uEnd = s_Header.uNextRecordIndex;
+      if ( u+1 < s_Header.uCountSessions )
+         uEnd = _get_session(u+1)->uStartRecordIndex;
+      char szTime[64];
+      _format_unix_time(pSession->uStartUnixTime, 0, szTime);
+      const char* szState = "";
+      if ( uEnd <= _get_first_available_record() )
+         szState = " (overwritten)";
+      else if ( pSession->uStartRecordIndex < _get_first_available_record() )
+         szState = " (partially overwritten)";
+      printf("Session %u: started %s, vehicle id %u, records %u to %u%s\n", u, szTime, pSession->uVehicleId,
+         pSession->uStartRecordIndex, (uEnd > 0)?(uEnd-1):0, szState);
+   }
+}
+
+// Finds the session a record belongs to, for computing absolute times
+static t_flight_recorder_session* _get_session_for_record(u32 uRecordIndex)
+{
+   u32 uFirstSession = s_Header.uCountSessions - _get_sessions_count();
+   for( u32 u=s_Header.uCountSessions; u>uFirstSession; u-- )
+   {
+      t_flight_recorder_session* pSession = _get_session(u-1);
+      if ( uRecordIndex >= pSession->uStartRecordIndex )
+         return pSession;
+   }
+   return NULL;
+}
+
+static void _print_record(t_flight_recorder_record* pRecord, bool bCSV)
+{
+   char szTime[64];
+   szTime[0] = 0;
+   t_flight_recorder_session* pSession = _get_session_for_record(pRecord->uRecordIndex);
+   if ( (NULL != pSession) && (pRecord->uSliceStartTime >= pSession->uStartTime) )
+      _format_unix_time(pSession->uStartUnixTime, pRecord->uSliceStartTime - pSession->uStartTime, szTime);
+   else
+      sprintf(szTime, "%u", pRecord->uSliceStartTime);
+
+   if ( ! bCSV )
+   {
+      printf("#%u %s (%u ms): link q %u%%, rx %u, tx %u/%u, video recv %u/%u, out %u (retr %u, ec %u/%u/%u max %u, skipped %u, total skipped %u), retr req %u/%u ack %u, adaptive 0x%08X\n",
+         pRecord->uRecordIndex, szTime, pRecord->uSliceDurationMs, pRecord->uRadioLinkQuality,
+         pRecord->uRxProcessedPackets, pRecord->uTxPackets, pRecord->uTxHighPriorityPackets,
+         pRecord->uRecvVideoDataPackets, pRecord->uRecvVideoECPackets,
+         pRecord->uOutputedVideoPackets, pRecord->uOutputedVideoPacketsRetransmitted,
+         pRecord->uOutputedVideoPacketsSingleECUsed, pRecord->uOutputedVideoPacketsTwoECUsed, pRecord->uOutputedVideoPacketsMultipleECUsed, pRecord->uOutputedVideoPacketsMaxECUsed,
+         pRecord->uOutputedVideoPacketsSkippedBlocks, pRecord->uTotalCountOutputSkippedBlocks,
+         pRecord->uCountReqRetransmissions, pRecord->uCountReqRetrPackets, pRecord->uCountAckRetransmissions,
+         pRecord->uFlagsAdaptiveVideo);
+      for( int i=0; (i<pRecord->uCountInterfaces) && (i<FLIGHT_RECORDER_MAX_INTERFACES); i++ )
+      {
+         t_flight_recorder_interface_slice* pInterface = &(pRecord->interfaces[i]);
+         printf("   if %d: video %u/%u, data %u, hp %u, missing %u (max gap %u), ack %u-%u ms, dbm %d/%d/%d noise %d, dbm2 %d/%d/%d noise %d\n",
+            i+1, pInterface->uRxVideoPackets, pInterface->uRxVideoECPackets, pInterface->uRxDataPackets, pInterface->uRxHighPriorityPackets,
+            pInterface->uRxMissingPackets, pInterface->uRxMissingPacketsMaxGap, pInterface->uMinAckTime, pInterface->uMaxAckTime,
+            pInterface->iDbmAvg[0], pInterface->iDbmMin[0], pInterface->iDbmMax[0], pInterface->iDbmNoiseAvg[0],
+            pInterface->iDbmAvg[1], pInterface->iDbmMin[1], pInterface->iDbmMax[1], pInterface->iDbmNoiseAvg[1]);
+      }
+      return;
+   }
+
+   int iCountInterfaces = pRecord->uCountInterfaces;
+   if ( iCountInterfaces > FLIGHT_RECORDER_MAX_INTERFACES )
+      iCountInterfaces = FLIGHT_RECORDER_MAX_INTERFACES;
+   for( int i=0; (i<iCountInterfaces) || ((0 == i) && (0 == iCountInterfaces)); i++ )
+   {
+      printf("%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+         pRecord->uRecordIndex, szTime, pRecord->uSliceStartTime, pRecord->uSliceDurationMs, pRecord->uRadioLinkQuality, pRecord->uFlagsAdaptiveVideo,
+         pRecord->uRxProcessedPackets, pRecord->uRxMaxAirgapSlots, pRecord->uTxPackets, pRecord->uTxHighPriorityPackets,
+         pRecord->uRecvVideoDataPackets, pRecord->uRecvVideoECPackets, pRecord->uRecvFramesInfo,
+         pRecord->uOutputedVideoPackets, pRecord->uOutputedVideoPacketsRetransmitted,
+         pRecord->uOutputedVideoPacketsSingleECUsed, pRecord->uOutputedVideoPacketsTwoECUsed, pRecord->uOutputedVideoPacketsMultipleECUsed, pRecord->uOutputedVideoPacketsMaxECUsed,
+         pRecord->uOutputedVideoPacketsSkippedBlocks, pRecord->uTotalCountOutputSkippedBlocks,
+         pRecord->uCountVehicles, pRecord->uCountReqRetransmissions, pRecord->uCountReqRetrPackets, pRecord->uCountAckRetransmissions);
+      if ( i >= iCountInterfaces )
+      {
+         printf(",,,,,,,,,,,,,,,,,\n");
+         continue;
+      }
+      t_flight_recorder_interface_slice* pInterface = &(pRecord->interfaces[i]);
+      printf(",%d,%u,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d,%d,%d,%d,%d\n",
+         i+1, pInterface->uRxVideoPackets, pInterface->uRxVideoECPackets, pInterface->uRxDataPackets, pInterface->uRxHighPriorityPackets,
+         pInterface->uRxMissingPackets, pInterface->uRxMissingPacketsMaxGap, pInterface->uMinAckTime, pInterface->uMaxAckTime,
+         pInterface->iDbmAvg[0], pInterface->iDbmMin[0], pInterface->iDbmMax[0], pInterface->iDbmNoiseAvg[0],
+         pInterface->iDbmAvg[1], pInterface->iDbmMin[1], pInterface->iDbmMax[1], pInterface->iDbmNoiseAvg[1]);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   if ( (argc > 1) && (strcmp(argv[argc-1], "-ver") == 0) )
+   {
+      printf("%d.%d (b%d)\n", SYSTEM_SW_VERSION_MAJOR, SYSTEM_SW_VERSION_MINOR/10, SYSTEM_SW_BUILD_NUMBER);
+      return 0;
+   }
+
+   char szFile[MAX_FILE_PATH_SIZE];
+   strcpy(szFile, FOLDER_LOGS);
+   strcat(szFile, LOG_FILE_FLIGHT_RECORDER);
+   bool bListSessions = false;
+   bool bCSV = false;
+   int iSession = -1;
+   u32 uLast = 0;
+
+   for( int i=1; i<argc; i++ )
+   {
+      if ( (0 == strcmp(argv[i], "-f")) && (i < argc-1) )
+      {
+         i++;
+         strncpy(szFile, argv[i], MAX_FILE_PATH_SIZE-1);
+         szFile[MAX_FILE_PATH_SIZE-1] = 0;
+      }
+      else if ( 0 == strcmp(argv[i], "-sessions") )
+         bListSessions = true;
+      else if ( (0 == strcmp(argv[i], "-session")) && (i < argc-1) )
+      {
+         i++;
+         iSession = atoi(argv[i]);
+      }
+      else if ( (0 == strcmp(argv[i], "-last")) && (i < argc-1) )
+      {
+         i++;
+         uLast = (u32)atoi(argv[i]);
+      }
+      else if ( 0 == strcmp(argv[i], "-csv") )
+         bCSV = true;
+      else
+      {
+         _print_usage();
+         return -1;
+      }
+   }
+
+   FILE* fd = fopen(szFile, "rb");
+   if ( NULL == fd )
+   {
+      printf("Failed to open flight recorder file %s\n", szFile);
+      return -1;
+   }
+   if ( 1 != fread(&s_Header, sizeof(t_flight_recorder_header), 1, fd) )
+   {
+      printf("Failed to read flight recorder file header.\n");
+      fclose(fd);
+      return -1;
+   }
+   if ( (s_Header.uMagic != FLIGHT_RECORDER_MAGIC) || (s_Header.uVersion != FLIGHT_RECORDER_VERSION) ||
+        (s_Header.uRecordSize != sizeof(t_flight_recorder_record)) || (0 == s_Header.uMaxRecords) )
+   {
+      printf("Invalid or unsupported flight recorder file (version %u, record size %u).\n", s_Header.uVersion, s_Header.uRecordSize);
+      fclose(fd);
+      return -1;
+   }
+
+   if ( bListSessions )
+   {
+      _list_sessions();
+      fclose(fd);
+      return 0;
+   }
+
+   u32 uStart = _get_first_available_record();
+   u32 uEnd = s_Header.uNextRecordIndex;
+   if ( iSession >= 0 )
+   {
+      u32 uFirstSession = s_Header.uCountSessions - _get_sessions_count();
+      if ( ((u32)iSession < uFirstSession) || ((u32)iSession >= s_Header.uCountSessions) )
+      {
+         printf("Session %d is not available. Use -sessions to list the available sessions.\n", iSession);
+         fclose(fd);
+         return -1;
+      }
+      if ( _get_session(iSession)->uStartRecordIndex > uStart )
+         uStart = _get_session(iSession)->uStartRecordIndex;
+      if ( (u32)iSession+1 < s_Header.uCountSessions )
+         uEnd = _get_session(iSession+1)->uStartRecordIndex;
+   }
+   if ( (uLast > 0) && (uEnd > uStart + uLast) )
+      uStart = uEnd - uLast;
+
+   if ( bCSV )
+      printf("record,time,router_time_ms,duration_ms,link_quality,adaptive_flags,rx_packets,rx_max_airgap,tx_packets,tx_high_prio_packets,"
+             "recv_video_data,recv_video_ec,recv_frames_info,out_video,out_retransmitted,out_ec1,out_ec2,out_ec_multiple,out_ec_max,out_skipped_blocks,total_skipped_blocks,"
+             "vehicles,retr_requests,retr_req_packets,retr_acks,"
+             "interface,if_rx_video,if_rx_video_ec,if_rx_data,if_rx_high_prio,if_rx_missing,if_rx_missing_max_gap,if_min_ack_ms,if_max_ack_ms,"
+             "dbm_avg_1,dbm_min_1,dbm_max_1,noise_avg_1,dbm_avg_2,dbm_min_2,dbm_max_2,noise_avg_2\n");
+
+   t_flight_recorder_record record;
+   for( u32 u=uStart; u<uEnd; u++ )
+   {
+      long lOffset = (long)s_Header.uHeaderSize + (long)(u % s_Header.uMaxRecords) * (long)sizeof(t_flight_recorder_record);
+      if ( (0 != fseek(fd, lOffset, SEEK_SET)) || (1 != fread(&record, sizeof(t_flight_recorder_record), 1, fd)) )
+      {
+         printf("Failed to read record %u.\n", u);
+         break;
+      }
+      // Skip slots that were not written yet or are being overwritten by the router
+      if ( record.uRecordIndex != u )
+         continue;
+      _print_record(&record, bCSV);
+   }
+   fclose(fd);
+   return 0;
+}
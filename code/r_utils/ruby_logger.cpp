@@ -43,6 +43,7 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <sys/stat.h>
 
 bool g_bQuit = false;
 int s_iCounter = 0;
@@ -67,6 +68,19 @@ void _log_logger_message(const char* szMsg)
       log_line("Failed to write to logger (%s)", szFile);
 }
 
+// Log files can be deleted while the logger runs; close them so they get recreated
+
+FILE* _reopen_log_file_if_removed(FILE* fd)
+{
+   if ( NULL == fd )
+      return NULL;
+   struct stat statFile;
+   if ( (0 == fstat(fileno(fd), &statFile)) && (statFile.st_nlink > 0) )
+      return fd;
+   fclose(fd);
+   return NULL;
+}
+
 void handle_sigint(int sig) 
 { 
    log_line("--------------------------");
@@ -176,6 +190,12 @@ int main(int argc, char *argv[])
    strcpy(szFileSoft, FOLDER_LOGS);
    strcat(szFileSoft, LOG_FILE_ERRORS_SOFT);
 
+   // Log files are kept opened and flushed once the message queue is empty
+   FILE* fdLog = NULL;
+   FILE* fdErrors = NULL;
+   FILE* fdSoft = NULL;
+   u32 uTimeLastFilesCheck = 0;
+
    while ( !g_bQuit )
    {
       // This is blocking
@@ -197,44 +217,59 @@ int main(int argc, char *argv[])
           else
              continue;
       }
-      logMessage.text[len-1] = 0;
-      //sprintf(szTmp, "len %d", len);
-      //_log_logger_message(szTmp);
-      //_log_logger_message(logMessage.text);
-      //log_line("Received message type: %d, length: %d bytes", logMessage.type, len);
-
-      //if ( logMessage.type == 1 )
-      if ( 1 )
+
+      if ( get_current_timestamp_ms() > uTimeLastFilesCheck + 1000 )
       {
-         FILE* fd = fopen(szFileLog, "a+");
-         if ( NULL != fd )
-         {
-            fprintf(fd, "%s\n", logMessage.text);
-            fclose(fd);
-         }
+         uTimeLastFilesCheck = get_current_timestamp_ms();
+         fdLog = _reopen_log_file_if_removed(fdLog);
+         fdErrors = _reopen_log_file_if_removed(fdErrors);
+         fdSoft = _reopen_log_file_if_removed(fdSoft);
       }
 
-      if ( logMessage.type == 2 )
+      // Write this message and any other already queued ones, then flush once
+      do
       {
-         FILE* fd = fopen(szFileSoft, "a+");
-         if ( NULL != fd )
+         logMessage.text[len-1] = 0;
+
+         if ( NULL == fdLog )
+            fdLog = fopen(szFileLog, "a+");
+         if ( NULL != fdLog )
+            fprintf(fdLog, "%s\n", logMessage.text);
+
+         if ( logMessage.type == 2 )
          {
-            fprintf(fd, "%s\n", logMessage.text);
-            fclose(fd);
+            if ( NULL == fdSoft )
+               fdSoft = fopen(szFileSoft, "a+");
+            if ( NULL != fdSoft )
+               fprintf(fdSoft, "%s\n", logMessage.text);
          }
-      }
 
-      if ( logMessage.type == 3 )
-      {
-         FILE* fd = fopen(szFileErrors, "a+");
-         if ( NULL != fd )
+         if ( logMessage.type == 3 )
          {
-            fprintf(fd, "%s\n", logMessage.text);
-            fclose(fd);
+            if ( NULL == fdErrors )
+               fdErrors = fopen(szFileErrors, "a+");
+            if ( NULL != fdErrors )
+               fprintf(fdErrors, "%s\n", logMessage.text);
          }
+         len = msgrcv(iLogMsgQueue, &logMessage, MAX_SERVICE_LOG_ENTRY_LENGTH, 0, MSG_NOERROR | IPC_NOWAIT);
       }
+      while ( (len > 0) && (!g_bQuit) );
+
+      if ( NULL != fdLog )
+         fflush(fdLog);
+      if ( NULL != fdSoft )
+         fflush(fdSoft);
+      if ( NULL != fdErrors )
+         fflush(fdErrors);
    }
 
+   if ( NULL != fdLog )
+      fclose(fdLog);
+   if ( NULL != fdSoft )
+      fclose(fdSoft);
+   if ( NULL != fdErrors )
+      fclose(fdErrors);
+
    if ( iLogMsgQueue >= 0 )
    {
       msgctl(iLogMsgQueue,IPC_RMID,NULL);
@@ -36,6 +36,7 @@
 #include "../base/hw_procs.h"
 #include "../base/models.h"
 #include "../base/flags_video.h"
+#include "../base/mp4_muxer.h"
 #include "../common/string_utils.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -61,6 +62,12 @@ bool gbQuit = false;
 bool g_bDebug = false;
 int niceValue = 10;
 
+static bool _is_mp4_file(const char* szFile)
+{
+   int iLength = strlen(szFile);
+   return (iLength > 4) && (0 == strcmp(szFile + iLength - 4, ".mp4"));
+}
+
 void _store_error(const char* szErrorMsg)
 {
    if ( (NULL == szErrorMsg) || (0 == szErrorMsg[0]) )
@@ -123,15 +130,24 @@ bool store_video()
    log_line("Read video info file: fps: %d, length: %d, w x h: %d x %d, type: %d, in video file: [%s]",
       fps, length, width, height, iVideoType, szFileInVideo);
 
+   bool bMP4 = _is_mp4_file(szFileInVideo);
    if ( NULL != strstr(szFileInVideo, FOLDER_TEMP_VIDEO_MEM) )
    {
-      snprintf(szComm, 511, "nice -n %d mv %s %s%s", niceValue, szFileInVideo, FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_FILE);
+      snprintf(szComm, 511, "nice -n %d mv %s %s%s", niceValue, szFileInVideo, FOLDER_RUBY_TEMP, bMP4?FILE_TEMP_VIDEO_MP4_FILE:FILE_TEMP_VIDEO_FILE);
       hw_execute_bash_command(szComm, NULL);
 
       sprintf(szComm, "umount %s", FOLDER_TEMP_VIDEO_MEM);
       hw_execute_bash_command(szComm, NULL);
       strcpy(szFileInVideo, FOLDER_RUBY_TEMP);
-      strcat(szFileInVideo, FILE_TEMP_VIDEO_FILE);
+      strcat(szFileInVideo, bMP4?FILE_TEMP_VIDEO_MP4_FILE:FILE_TEMP_VIDEO_FILE);
+   }
+
+   // A recording that was not stopped (i.e. power loss) has no duration; get it from the complete fragments
+   if ( bMP4 && (0 == length) )
+   {
+      int iFrames = mp4_muxer_get_frames_count(szFileInVideo);
+      length = iFrames / ((fps > 0)?fps:30);
+      log_line("Video recording was not stopped. Found %d frames in the file, %d seconds.", iFrames, length);
    }
 
    long lSizeVideo = 0;
@@ -180,12 +196,22 @@ bool store_video()
    sprintf(szOutFileInfo, FILE_FORMAT_VIDEO_INFO, vehicle_name, g_iBootCount, (int)timeNow/1000, (int)timeNow%1000 );
 
    strncpy(szOutFileVideo, szOutFileInfo, sizeof(szOutFileVideo)/sizeof(szOutFileVideo[0]));
-   szOutFileVideo[strlen(szOutFileVideo)-4] = 'h';
-   szOutFileVideo[strlen(szOutFileVideo)-3] = '2';
-   szOutFileVideo[strlen(szOutFileVideo)-2] = '6';
-   szOutFileVideo[strlen(szOutFileVideo)-1] = '4';
-   if ( iVideoType == VIDEO_TYPE_H265 )
-      szOutFileVideo[strlen(szOutFileVideo)-1] = '5';
+   if ( bMP4 )
+   {
+      szOutFileVideo[strlen(szOutFileVideo)-4] = 'm';
+      szOutFileVideo[strlen(szOutFileVideo)-3] = 'p';
+      szOutFileVideo[strlen(szOutFileVideo)-2] = '4';
+      szOutFileVideo[strlen(szOutFileVideo)-1] = 0;
+   }
+   else
+   {
+      szOutFileVideo[strlen(szOutFileVideo)-4] = 'h';
+      szOutFileVideo[strlen(szOutFileVideo)-3] = '2';
+      szOutFileVideo[strlen(szOutFileVideo)-2] = '6';
+      szOutFileVideo[strlen(szOutFileVideo)-1] = '4';
+      if ( iVideoType == VIDEO_TYPE_H265 )
+         szOutFileVideo[strlen(szOutFileVideo)-1] = '5';
+   }
 
    snprintf(szFullOutFileInfo, sizeof(szFullOutFileInfo)/sizeof(szFullOutFileInfo[0]), "%s%s", FOLDER_MEDIA, szOutFileInfo);
 
@@ -259,6 +285,15 @@ bool process_video(char* szFileInfo, char* szFileOut)
       return true;
    }
 
+   // Recordings muxed while received are already MP4 files
+   if ( _is_mp4_file(szFileInVideo) )
+   {
+      snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "nice -n %d cp -f %s%s %s", niceValue, FOLDER_MEDIA, szFileInVideo, szFileOut);
+      hw_execute_bash_command(szComm, NULL);
+      log_line("Copied mp4 video file to: %s", szFileOut);
+      return true;
+   }
+
    // Convert input file to output file
    snprintf(szComm, sizeof(szComm)/sizeof(szComm[0]), "ffmpeg -framerate %d -y -i %s%s -c:v copy %s 2>&1 1>/dev/null", fps, FOLDER_MEDIA, szFileInVideo, szFileOut);
    log_line("Execute conversion: %s", szComm);
@@ -325,6 +360,17 @@ int main(int argc, char *argv[])
    szFileInfo[0] = 0;
    szFileOut[0] = 0;
 
+   // Extract the video stream from a mp4 recording, for the local video player
+   if ( (argc >= 4) && (0 == strcmp(argv[1], "-es")) )
+   {
+      if ( strcmp(argv[argc-1], "-debug") == 0 )
+         log_enable_stdout();
+      log_line("Extracting video stream from %s to %s ...", argv[2], argv[3]);
+      int iResult = mp4_muxer_extract_video_stream(argv[2], argv[3]);
+      log_line("Finished extracting video stream.");
+      return (iResult > 0)?0:-1;
+   }
+
    bool bStoreOnly = true;
    // Default, when no params:
    // Just store the temporary recording to media folder
@@ -356,6 +402,8 @@ int main(int argc, char *argv[])
       hw_execute_bash_command(szComm, NULL);
       sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_FILE);
       hw_execute_bash_command(szComm, NULL);
+      sprintf(szComm, "rm -rf %s%s", FOLDER_RUBY_TEMP, FILE_TEMP_VIDEO_MP4_FILE);
+      hw_execute_bash_command(szComm, NULL);
    }
    else
    {
@@ -43,12 +43,13 @@
 #include "timers.h"
 #include "processor_tx_video.h"
 #include "test_link_params.h"
+#include "tx_routes.h"
 
 #include "../radio/radiopackets2.h"
 #include "../radio/radiolink.h"
 #include "../radio/radio_tx.h"
 
-u8 s_RadioRawPacket[MAX_PACKET_TOTAL_SIZE];
+u8 s_RadioRawPacket[MAX_PACKET_TOTAL_SIZE + ENCR_PACKET_OVERHEAD];
 
 u32 s_StreamsTxPacketIndex[MAX_RADIO_STREAMS];
 
@@ -58,6 +59,9 @@ int s_LastTxDataRatesData[MAX_RADIO_INTERFACES];
 
 u32 s_VehicleLogSegmentIndex = 0;
 
+type_tx_routes_table s_TxRoutes;
+bool s_bTxRoutesValid = false;
+
 
 typedef struct
 {
@@ -85,6 +89,14 @@ void packet_utils_init()
       s_LastTxDataRatesVideo[i] = 0;
       s_LastTxDataRatesData[i] = 0;
    }
+   s_bTxRoutesValid = false;
+}
+
+// Must be called when the model radio configuration or the local radio links/interfaces change
+
+void packet_utils_invalidate_tx_routes()
+{
+   s_bTxRoutesValid = false;
 }
 
 void packet_utils_set_adaptive_video_datarate(int iDatarateBPS)
@@ -322,19 +334,11 @@ bool _send_packet_to_serial_radio_interface(int iLocalRadioLinkId, int iRadioInt
    return false;
 }
 
-bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInterfaceIndex, u8* pPacketData, int nPacketLength)
-{
-   if ( (NULL == pPacketData) || (nPacketLength <= 0) || (NULL == g_pCurrentModel) )
-      return false;
-
-   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iRadioInterfaceIndex);
-   if ( NULL == pRadioHWInfo )
-      return false;
+// Sets the radio tx params (datarate, frames flags) for this packet and builds the raw radio packet (radiotap + ieee headers) in pRawPacket
+// Returns the raw packet length
 
-   int iVehicleRadioLinkId = g_SM_RadioStats.radio_links[iLocalRadioLinkId].matchingVehicleRadioLinkId;
-   if ( (iVehicleRadioLinkId < 0) || (iVehicleRadioLinkId >= g_pCurrentModel->radioLinksParams.links_count) )
-      return false;
-   
+int _build_raw_packet_for_wifi_radio_interface(int iLocalRadioLinkId, int iVehicleRadioLinkId, int iRadioInterfaceIndex, u8* pPacketData, int nPacketLength, u8* pRawPacket, int* pRateTx)
+{
    t_packet_header* pPH = (t_packet_header*)pPacketData;
    u32 uStreamId = (pPH->stream_packet_idx) >> PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
 
@@ -396,7 +400,36 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
    }
   */ 
 
-   int totalLength = radio_build_new_raw_ieee_packet(iLocalRadioLinkId, s_RadioRawPacket, pPacketData, nPacketLength, RADIO_PORT_ROUTER_DOWNLINK, be);
+   if ( NULL != pRateTx )
+      *pRateTx = nRateTx;
+   return radio_build_new_raw_ieee_packet(iLocalRadioLinkId, pRawPacket, pPacketData, nPacketLength, RADIO_PORT_ROUTER_DOWNLINK, be);
+}
+
+bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInterfaceIndex, u8* pPacketData, int nPacketLength)
+{
+   if ( (NULL == pPacketData) || (nPacketLength <= 0) || (NULL == g_pCurrentModel) )
+      return false;
+
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iRadioInterfaceIndex);
+   if ( NULL == pRadioHWInfo )
+      return false;
+
+   int iVehicleRadioLinkId = g_SM_RadioStats.radio_links[iLocalRadioLinkId].matchingVehicleRadioLinkId;
+   if ( (iVehicleRadioLinkId < 0) || (iVehicleRadioLinkId >= g_pCurrentModel->radioLinksParams.links_count) )
+      return false;
+   
+   t_packet_header* pPH = (t_packet_header*)pPacketData;
+   u32 uStreamId = (pPH->stream_packet_idx) >> PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
+
+   bool bIsVideoPacket = false;
+   bool bIsAudioPacket = false;
+   if ( (pPH->packet_flags & PACKET_FLAGS_MASK_MODULE) == PACKET_COMPONENT_AUDIO )
+      bIsAudioPacket = true;
+   if ( uStreamId >= STREAM_ID_VIDEO_1 )
+      bIsVideoPacket = true;
+
+   int nRateTx = 0;
+   int totalLength = _build_raw_packet_for_wifi_radio_interface(iLocalRadioLinkId, iVehicleRadioLinkId, iRadioInterfaceIndex, pPacketData, nPacketLength, s_RadioRawPacket, &nRateTx);
 
    u32 microT1 = get_current_timestamp_micros();
 
@@ -427,6 +460,105 @@ bool _send_packet_to_wifi_radio_interface(int iLocalRadioLinkId, int iRadioInter
    return false;
 }
 
+void _update_tx_stats_on_packet_sent(t_packet_header* pPH, u32 uDestVehicleId, u32 uStreamId, bool bIsVideoPacket)
+{
+   radio_stats_update_on_packet_sent_for_radio_stream(&g_SM_RadioStats, g_TimeNow, uDestVehicleId, uStreamId, pPH->packet_type, pPH->total_length);
+
+   g_PHVehicleTxStats.tmp_uAverageTxCount++;
+
+   if ( g_PHVehicleTxStats.historyTxPackets[0] < 255 )
+      g_PHVehicleTxStats.historyTxPackets[0]++;
+
+   u32 uTxGap = g_TimeNow - g_TimeLastTxPacket;
+   g_TimeLastTxPacket = g_TimeNow;
+
+   if ( uTxGap > 254 )
+      uTxGap = 254;
+
+   g_PHVehicleTxStats.tmp_uAverageTxSum += uTxGap;
+
+   if ( 0xFF == g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] )
+      g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] = uTxGap;
+   if ( 0xFF == g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] )
+      g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] = uTxGap;
+
+
+   if ( uTxGap > g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] )
+      g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] = uTxGap;
+   if ( uTxGap < g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] )
+      g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] = uTxGap;
+
+
+   // To do / fix: compute now and averages per radio link, not total
+     
+   if ( g_TimeNow >= g_RadioTxTimers.uTimeLastUpdated + g_RadioTxTimers.uUpdateIntervalMs )
+   {
+      u32 uDeltaTime = g_TimeNow - g_RadioTxTimers.uTimeLastUpdated;
+      g_RadioTxTimers.uTimeLastUpdated = g_TimeNow;
+      
+      g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow = 0;
+      g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow = 0;
+      
+      for( int i=0; i<g_pCurrentModel->radioInterfacesParams.interfaces_count; i++ )
+      {
+         g_RadioTxTimers.aInterfacesTxTotalTimeMilisecPerSecond[i] = g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[i] / uDeltaTime;
+         g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[i] = 0;
+
+         g_RadioTxTimers.aInterfacesTxVideoTimeMilisecPerSecond[i] = g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[i] / uDeltaTime;
+         g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[i] = 0;
+
+         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow += g_RadioTxTimers.aInterfacesTxTotalTimeMilisecPerSecond[i];
+         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow += g_RadioTxTimers.aInterfacesTxVideoTimeMilisecPerSecond[i];
+      }
+
+      if ( 0 == g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
+         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow;
+      else if ( g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow > g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
+         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow*2)/3 + g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage/3;
+      else
+         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow)/4 + (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage*3)/4;
+
+      if ( 0 == g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage )
+         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow;
+      else if ( g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow > g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
+         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow*2)/3 + g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage/3;
+      else
+         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow)/4 + (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage*3)/4;
+   
+      g_RadioTxTimers.aHistoryTotalRadioTxTimes[g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes] = g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow;
+      g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes++;
+      if ( g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes >= MAX_RADIO_TX_TIMES_HISTORY_INTERVALS )
+         g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes = 0;
+   }
+
+   if ( bIsVideoPacket )
+   {
+      s_countTXVideoPacketsOutTemp++;
+   }
+   else
+   {
+      s_countTXDataPacketsOutTemp++;
+      s_countTXCompactedPacketsOutTemp++;
+   }
+
+   if ( NULL != g_pProcessStats )
+      g_pProcessStats->lastRadioTxTime = g_TimeNow;
+}
+
+// Returns the tx routes for the given class of packets. Rebuilds the routes if they were invalidated.
+
+type_tx_routes_list* _get_tx_routes(int iClass)
+{
+   if ( ! s_bTxRoutesValid )
+   {
+      tx_routes_build(&s_TxRoutes, g_pCurrentModel, &g_SM_RadioStats, hardware_get_radio_info_array(), hardware_get_radio_interfaces_count());
+      s_bTxRoutesValid = true;
+      log_line("[PacketUtils] Rebuilt tx routes:");
+      tx_routes_log(&s_TxRoutes);
+   }
+   return &(s_TxRoutes.classes[iClass]);
+}
+
 // Sends a radio packet to all posible radio interfaces or just to a single radio link
 
 int send_packet_to_radio_interfaces(u8* pPacketData, int nPacketLength, int iSendToSingleRadioLink)
@@ -542,65 +674,29 @@ int send_packet_to_radio_interfaces(u8* pPacketData, int nPacketLength, int iSen
 
    bool bPacketSent = false;
 
-   for( int iRadioLinkId=0; iRadioLinkId<g_pCurrentModel->radioLinksParams.links_count; iRadioLinkId++ )
+   type_tx_routes_list* pRoutes = _get_tx_routes((bIsVideoPacket || bIsAudioPacket)?TX_ROUTE_CLASS_VIDEO:TX_ROUTE_CLASS_DATA);
+   for( int iRoute=0; iRoute<pRoutes->iRoutesCount; iRoute++ )
    {
-      int iVehicleRadioLinkId = g_SM_RadioStats.radio_links[iRadioLinkId].matchingVehicleRadioLinkId;
-      int iRadioInterfaceIndex = -1;
-      for( int k=0; k<g_pCurrentModel->radioInterfacesParams.interfaces_count; k++ )
-      {
-         if ( g_pCurrentModel->radioInterfacesParams.interface_link_id[k] == iVehicleRadioLinkId )
-         {
-            iRadioInterfaceIndex = k;
-            break;
-         }
-      }
-      if ( iRadioInterfaceIndex < 0 )
-         continue;
+      type_tx_route* pRoute = &(pRoutes->routes[iRoute]);
+      int iRadioLinkId = pRoute->iLocalRadioLinkId;
+      int iRadioInterfaceIndex = pRoute->iRadioInterfaceIndex;
 
       if ( (-1 != iSendToSingleRadioLink) && (iRadioLinkId != iSendToSingleRadioLink) )
          continue;
 
-      if ( g_pCurrentModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId] & RADIO_HW_CAPABILITY_FLAG_DISABLED )
-         continue;
-
       if ( bIsPingReplyPacket && (uPingReplySendOnLocalRadioLinkId != 0xFF) )
       if ( iRadioLinkId != (int) uPingReplySendOnLocalRadioLinkId )
          continue;
 
-      // Do not send regular packets to controller using relay links
-      if ( (g_pCurrentModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId] & RADIO_HW_CAPABILITY_FLAG_USED_FOR_RELAY) ||
-           (g_pCurrentModel->relay_params.isRelayEnabledOnRadioLinkId == iVehicleRadioLinkId) )
-         continue;
-
       // Send Ping reply packets only to the assigned radio link
       if ( bIsPingPacket )
       if ( iRadioLinkId != iPingOnLocalRadioLinkId )
          continue;
 
-      if ( !(g_pCurrentModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId] & RADIO_HW_CAPABILITY_FLAG_CAN_TX) )
-         continue;
-
-      if ( bIsVideoPacket || bIsAudioPacket )
-      if ( ! (g_pCurrentModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId] & RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_VIDEO) )
-         continue;
-
-      if ( (! bIsVideoPacket) && (! bIsAudioPacket) )
-      if ( ! (g_pCurrentModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId] & RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_DATA) )
-         continue;
-
-      radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(iRadioInterfaceIndex);
-      if ( ! pRadioHWInfo->openedForWrite )
-         continue;
-      if ( g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[iRadioInterfaceIndex] & RADIO_HW_CAPABILITY_FLAG_DISABLED )
-         continue;
-      if ( !(g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[iRadioInterfaceIndex] & RADIO_HW_CAPABILITY_FLAG_CAN_TX) )
-         continue;
-      if ( (bIsVideoPacket || bIsAudioPacket) && (!(g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[iRadioInterfaceIndex] & RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_VIDEO)) )
-         continue;
-      if ( (!bIsVideoPacket) && (!bIsAudioPacket) && (!(g_pCurrentModel->radioInterfacesParams.interface_capabilities_flags[iRadioInterfaceIndex] & RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_DATA)) )
+      if ( ! pRoute->pRadioHWInfo->openedForWrite )
          continue;
       
-      if ( hardware_radio_index_is_serial_radio(iRadioInterfaceIndex) )
+      if ( pRoute->bIsSerialRadio )
       {
          if ( (! bIsVideoPacket) && (!bIsRetransmited) && (!bIsAudioPacket) )
          if ( _send_packet_to_serial_radio_interface(iRadioLinkId, iRadioInterfaceIndex, pPacketData, nPacketLength) )
@@ -675,99 +771,106 @@ int send_packet_to_radio_interfaces(u8* pPacketData, int nPacketLength, int iSen
 
    // Packet sent. Update stats and info
 
-   radio_stats_update_on_packet_sent_for_radio_stream(&g_SM_RadioStats, g_TimeNow, uDestVehicleId, uStreamId, pPH->packet_type, pPH->total_length);
-
-   g_PHVehicleTxStats.tmp_uAverageTxCount++;
-
-   if ( g_PHVehicleTxStats.historyTxPackets[0] < 255 )
-      g_PHVehicleTxStats.historyTxPackets[0]++;
-
-   u32 uTxGap = g_TimeNow - g_TimeLastTxPacket;
-   g_TimeLastTxPacket = g_TimeNow;
+   _update_tx_stats_on_packet_sent(pPH, uDestVehicleId, uStreamId, bIsVideoPacket);
 
-   if ( uTxGap > 254 )
-      uTxGap = 254;
+   #ifdef LOG_RAW_TELEMETRY
+   t_packet_header* pPH = (t_packet_header*) pPacketData;
+   if ( pPH->packet_type == PACKET_TYPE_TELEMETRY_RAW_DOWNLOAD )
+   {
+      t_packet_header_telemetry_raw* pPHTR = (t_packet_header_telemetry_raw*)(pPacketData + sizeof(t_packet_header));
+      log_line("[Raw_Telem] Send raw telemetry packet to radio interfaces, index %u, %d bytes", pPHTR->telem_segment_index, pPH->total_length);
+   }
+   #endif
 
-   g_PHVehicleTxStats.tmp_uAverageTxSum += uTxGap;
+   return 0;
+}
 
-   if ( 0xFF == g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] )
-      g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] = uTxGap;
-   if ( 0xFF == g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] )
-      g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] = uTxGap;
+// Sends a slice of video packets on all the radio links that can send video.
+// The raw packets are built for each radio interface and written to it in a single batch.
+// Returns the number of packets sent on at least one radio interface.
 
+int send_video_packets_to_radio_interfaces(u8** pPackets, int iCount)
+{
+   static u8 s_RadioRawPackets[MAX_RADIO_TX_BATCH_PACKETS][MAX_PACKET_TOTAL_SIZE + ENCR_PACKET_OVERHEAD];
+   u8* pRawPackets[MAX_RADIO_TX_BATCH_PACKETS];
+   int iRawLengths[MAX_RADIO_TX_BATCH_PACKETS];
+   int iRatesTx[MAX_RADIO_TX_BATCH_PACKETS];
+   bool bPacketsSent[MAX_RADIO_TX_BATCH_PACKETS];
 
-   if ( uTxGap > g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] )
-      g_PHVehicleTxStats.historyTxGapMaxMiliseconds[0] = uTxGap;
-   if ( uTxGap < g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] )
-      g_PHVehicleTxStats.historyTxGapMinMiliseconds[0] = uTxGap;
+   if ( (NULL == pPackets) || (iCount <= 0) || (NULL == g_pCurrentModel) )
+      return 0;
+   if ( iCount > MAX_RADIO_TX_BATCH_PACKETS )
+      iCount = MAX_RADIO_TX_BATCH_PACKETS;
 
+   for( int i=0; i<iCount; i++ )
+   {
+      t_packet_header* pPH = (t_packet_header*)pPackets[i];
+      u32 uStreamId = (pPH->stream_packet_idx) >> PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
+      s_StreamsTxPacketIndex[uStreamId]++;
+      pPH->stream_packet_idx = (((u32)uStreamId)<<PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX) | (s_StreamsTxPacketIndex[uStreamId] & PACKET_FLAGS_MASK_STREAM_PACKET_IDX);
+      pRawPackets[i] = s_RadioRawPackets[i];
+      bPacketsSent[i] = false;
+   }
 
-   // To do / fix: compute now and averages per radio link, not total
-     
-   if ( g_TimeNow >= g_RadioTxTimers.uTimeLastUpdated + g_RadioTxTimers.uUpdateIntervalMs )
+   type_tx_routes_list* pRoutes = _get_tx_routes(TX_ROUTE_CLASS_VIDEO);
+   for( int iRoute=0; iRoute<pRoutes->iRoutesCount; iRoute++ )
    {
-      u32 uDeltaTime = g_TimeNow - g_RadioTxTimers.uTimeLastUpdated;
-      g_RadioTxTimers.uTimeLastUpdated = g_TimeNow;
-      
-      g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow = 0;
-      g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow = 0;
-      
-      for( int i=0; i<g_pCurrentModel->radioInterfacesParams.interfaces_count; i++ )
-      {
-         g_RadioTxTimers.aInterfacesTxTotalTimeMilisecPerSecond[i] = g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[i] / uDeltaTime;
-         g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[i] = 0;
+      type_tx_route* pRoute = &(pRoutes->routes[iRoute]);
+      if ( pRoute->bIsSerialRadio || (! pRoute->pRadioHWInfo->openedForWrite) )
+         continue;
+      int iRadioLinkId = pRoute->iLocalRadioLinkId;
+      int iVehicleRadioLinkId = pRoute->iVehicleRadioLinkId;
+      int iRadioInterfaceIndex = pRoute->iRadioInterfaceIndex;
 
-         g_RadioTxTimers.aInterfacesTxVideoTimeMilisecPerSecond[i] = g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[i] / uDeltaTime;
-         g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[i] = 0;
+      for( int i=0; i<iCount; i++ )
+      {
+         t_packet_header* pPH = (t_packet_header*)pPackets[i];
+         iRawLengths[i] = _build_raw_packet_for_wifi_radio_interface(iRadioLinkId, iVehicleRadioLinkId, iRadioInterfaceIndex, pPackets[i], pPH->total_length, pRawPackets[i], &iRatesTx[i]);
+      }
 
-         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow += g_RadioTxTimers.aInterfacesTxTotalTimeMilisecPerSecond[i];
-         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow += g_RadioTxTimers.aInterfacesTxVideoTimeMilisecPerSecond[i];
+      u32 microT1 = get_current_timestamp_micros();
+      int iCountWritten = radio_write_raw_ieee_packets(iRadioInterfaceIndex, pRawPackets, iRawLengths, iCount);
+      u32 microT2 = get_current_timestamp_micros();
+      if ( microT2 > microT1 )
+      {
+         g_RadioTxTimers.aTmpInterfacesTxTotalTimeMicros[iRadioInterfaceIndex] += microT2 - microT1;
+         g_RadioTxTimers.aTmpInterfacesTxVideoTimeMicros[iRadioInterfaceIndex] += microT2 - microT1;
       }
 
-      if ( 0 == g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
-         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow;
-      else if ( g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow > g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
-         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow*2)/3 + g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage/3;
-      else
-         g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow)/4 + (g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage*3)/4;
+      for( int i=0; i<iCountWritten; i++ )
+      {
+         t_packet_header* pPH = (t_packet_header*)pPackets[i];
+         u32 uStreamId = (pPH->stream_packet_idx) >> PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
+         radio_stats_update_on_packet_sent_on_radio_interface(&g_SM_RadioStats, g_TimeNow, iRadioInterfaceIndex, pPH->total_length);
+         radio_stats_set_tx_radio_datarate_for_packet(&g_SM_RadioStats, iRadioInterfaceIndex, iRadioLinkId, iRatesTx[i], 1);
+         radio_stats_update_on_packet_sent_on_radio_link(&g_SM_RadioStats, g_TimeNow, iRadioLinkId, (int)uStreamId, pPH->total_length);
+         bPacketsSent[i] = true;
+      }
 
-      if ( 0 == g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage )
-         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow;
-      else if ( g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow > g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondAverage )
-         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow*2)/3 + g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage/3;
-      else
-         g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage = (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondNow)/4 + (g_RadioTxTimers.uComputedVideoTxTimeMilisecPerSecondAverage*3)/4;
-   
-      g_RadioTxTimers.aHistoryTotalRadioTxTimes[g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes] = g_RadioTxTimers.uComputedTotalTxTimeMilisecPerSecondNow;
-      g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes++;
-      if ( g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes >= MAX_RADIO_TX_TIMES_HISTORY_INTERVALS )
-         g_RadioTxTimers.iCurrentIndexHistoryTotalRadioTxTimes = 0;
+      if ( iCountWritten < iCount )
+         log_softerror_and_alarm("Failed to write video packets to radio interface %d (%d of %d packets written)", iRadioInterfaceIndex+1, iCountWritten, iCount);
    }
 
-   if ( bIsVideoPacket )
-   {
-      s_countTXVideoPacketsOutTemp++;
-   }
-   else
+   int iCountSent = 0;
+   for( int i=0; i<iCount; i++ )
    {
-      s_countTXDataPacketsOutTemp++;
-      s_countTXCompactedPacketsOutTemp++;
+      if ( ! bPacketsSent[i] )
+         continue;
+      t_packet_header* pPH = (t_packet_header*)pPackets[i];
+      u32 uStreamId = (pPH->stream_packet_idx) >> PACKET_FLAGS_MASK_SHIFT_STREAM_INDEX;
+      _update_tx_stats_on_packet_sent(pPH, pPH->vehicle_id_dest, uStreamId, true);
+      iCountSent++;
    }
 
-   if ( NULL != g_pProcessStats )
-      g_pProcessStats->lastRadioTxTime = g_TimeNow;
-   
-
-   #ifdef LOG_RAW_TELEMETRY
-   t_packet_header* pPH = (t_packet_header*) pPacketData;
-   if ( pPH->packet_type == PACKET_TYPE_TELEMETRY_RAW_DOWNLOAD )
+   if ( 0 == iCountSent )
    {
-      t_packet_header_telemetry_raw* pPHTR = (t_packet_header_telemetry_raw*)(pPacketData + sizeof(t_packet_header));
-      log_line("[Raw_Telem] Send raw telemetry packet to radio interfaces, index %u, %d bytes", pPHTR->telem_segment_index, pPH->total_length);
+      if ( test_link_is_in_progress() )
+      if ( 1 == g_pCurrentModel->radioLinksParams.links_count )
+         return 0;
+      log_softerror_and_alarm("Video packets not sent! No radio interface could send them (%d packets). %d radio links.",
+         iCount, g_pCurrentModel->radioLinksParams.links_count);
    }
-   #endif
-
-   return 0;
+   return iCountSent;
 }
 
 void send_packet_vehicle_log(u8* pBuffer, int length)
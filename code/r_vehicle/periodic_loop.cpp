@@ -372,6 +372,22 @@ void _check_free_storage_space()
    }
 }
 
+void _check_log_dropped_entries()
+{
+   static u32 sl_uTimeLastLogDroppedCheck = 0;
+   static u32 sl_uLastLogDroppedEntries = 0;
+
+   if ( g_TimeNow < sl_uTimeLastLogDroppedCheck + 10000 )
+      return;
+   sl_uTimeLastLogDroppedCheck = g_TimeNow;
+
+   u32 uDropped = log_get_dropped_entries_count();
+   if ( uDropped == sl_uLastLogDroppedEntries )
+      return;
+   log_softerror_and_alarm("Async log writer dropped %u log entries in the last 10 seconds (%u total).", uDropped - sl_uLastLogDroppedEntries, uDropped);
+   sl_uLastLogDroppedEntries = uDropped;
+}
+
 void _check_write_filesystem()
 {
    static bool s_bRouterCheckedForWriteFileSystem = false;
@@ -922,6 +938,7 @@ int periodicLoop()
    _check_reinit_sik_interfaces();
    _check_for_debug_raspi_messages();
    _check_free_storage_space();
+   _check_log_dropped_entries();
 
    if ( test_link_is_in_progress() )
       test_link_loop();
@@ -335,6 +335,7 @@ void _process_local_notification_model_changed(t_packet_header* pPH, int changeT
       strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
       if ( ! g_pCurrentModel->loadFromFile(szFile, false) )
          log_error_and_alarm("Can't load current model vehicle.");
+      packet_utils_invalidate_tx_routes();
       ruby_ipc_channel_send_message(s_fIPCRouterToCommands, (u8*)pPH, pPH->total_length);
       return;
    }
@@ -346,6 +347,7 @@ void _process_local_notification_model_changed(t_packet_header* pPH, int changeT
       strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
       if ( ! g_pCurrentModel->loadFromFile(szFile, false) )
          log_error_and_alarm("Can't load current model vehicle.");
+      packet_utils_invalidate_tx_routes();
       hardware_reload_serial_ports_settings();
       ruby_ipc_channel_send_message(s_fIPCRouterToTelemetry, (u8*)pPH, pPH->total_length);
       if ( NULL != g_pProcessStats )
@@ -398,6 +400,7 @@ void _process_local_notification_model_changed(t_packet_header* pPH, int changeT
    strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
    if ( ! g_pCurrentModel->loadFromFile(szFile, false) )
       log_error_and_alarm("Can't load current model vehicle.");
+   packet_utils_invalidate_tx_routes();
 
 
    if ( (g_pCurrentModel->uDeveloperFlags &DEVELOPER_FLAGS_USE_PCAP_RADIO_TX ) != (uOldDevFlags & DEVELOPER_FLAGS_USE_PCAP_RADIO_TX) )
@@ -561,6 +564,7 @@ void _process_local_notification_model_changed(t_packet_header* pPH, int changeT
                iTmp, g_SM_RadioStats.radio_interfaces[i].assignedVehicleRadioLinkId);
          }
       }
+      packet_utils_invalidate_tx_routes();
 
       ruby_ipc_channel_send_message(s_fIPCRouterToTelemetry, (u8*)pPH, pPH->total_length);
       ruby_ipc_channel_send_message(s_fIPCRouterToCommands, (u8*)pPH, pPH->total_length);
@@ -1294,6 +1298,7 @@ void process_local_control_packet(t_packet_header* pPH)
       strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
       if ( ! g_pCurrentModel->loadFromFile(szFile, false) )
          log_error_and_alarm("Can't load current model vehicle.");
+      packet_utils_invalidate_tx_routes();
       if ( NULL != g_pProcessStats )
       {
          g_TimeNow = get_current_timestamp_ms();
@@ -159,6 +159,14 @@ void relay_process_received_radio_packet_from_relayed_vehicle(int iRadioLink, in
       if ( iPacketLength <= 0 )
          return;
 
+      // Decryption removed the encryption trailer from the buffer
+      if ( iPacketLength < iTotalLength )
+      {
+         iBufferLength -= iTotalLength - iPacketLength;
+         nRemainingLength -= iTotalLength - iPacketLength;
+         iTotalLength = iPacketLength;
+      }
+
       if ( uVehicleIdSrc != g_pCurrentModel->relay_params.uRelayedVehicleId )
       {
          pData += iTotalLength;
@@ -35,6 +35,7 @@
 #include "../base/models.h"
 #include "../radio/radiolink.h"
 #include "../radio/radiopackets2.h"
+#include "../radio/radiopackets_retr.h"
 #include "../radio/fec.h"
 #include "../base/camera_utils.h"
 #include "../base/parser_h264.h"
@@ -1349,27 +1350,49 @@ bool process_data_tx_video_command(int iRadioInterface, u8* pPacketBuffer)
 
    if ( pPH->packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS )
    {
-      static u32 s_uLastRecvRetransmissionId = 0;
+      if ( pPH->total_length < sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8) )
+         return true;
       u8 uCount = pPacketBuffer[sizeof(t_packet_header) + sizeof(u32) + sizeof(u8)];
       u32 uRetrId = 0;
       memcpy(&uRetrId, &pPacketBuffer[sizeof(t_packet_header)], sizeof(u32));
       
       log_line("[AdaptiveVideo] Received retr request id %u from controller for %d packets", uRetrId, (int)uCount);
       
+      u32 uVideoBlocks[256];
+      u8 uVideoPackets[256];
+      int iCount = 0;
       u8* pDataPackets = pPacketBuffer + sizeof(t_packet_header) + sizeof(u32) + 2*sizeof(u8);
       for( int i=0; i<(int)uCount; i++ )
       {
-         u32 uBlockId = 0;
-         int iPacketIndex = 0;
-         memcpy(&uBlockId, pDataPackets, sizeof(u32));
+         if ( pDataPackets + sizeof(u32) + sizeof(u8) > pPacketBuffer + pPH->total_length )
+            break;
+         memcpy(&uVideoBlocks[iCount], pDataPackets, sizeof(u32));
          pDataPackets += sizeof(u32);
-         iPacketIndex = (int) *pDataPackets;
+         uVideoPackets[iCount] = *pDataPackets;
          pDataPackets++;
-         g_pVideoTxBuffers->resendVideoPacket(uRetrId, uBlockId, iPacketIndex);
-         if ( (s_uLastRecvRetransmissionId != uRetrId) && (uCount < 4) )
-            g_pVideoTxBuffers->resendVideoPacket(uRetrId, uBlockId, iPacketIndex);
+         iCount++;
+      }
+      g_pVideoTxBuffers->resendVideoPackets(uRetrId, uVideoBlocks, uVideoPackets, iCount);
+   }
+
+   if ( pPH->packet_type == PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT )
+   {
+      if ( pPH->total_length < sizeof(t_packet_header) + sizeof(u32) + sizeof(u8) )
+         return true;
+      u32 uRetrId = 0;
+      memcpy(&uRetrId, &pPacketBuffer[sizeof(t_packet_header)], sizeof(u32));
+
+      u32 uVideoBlocks[MAX_TOTAL_PACKETS_IN_BLOCK*4];
+      u8 uVideoPackets[MAX_TOTAL_PACKETS_IN_BLOCK*4];
+      int iHeaderSize = sizeof(t_packet_header) + sizeof(u32) + sizeof(u8);
+      int iCount = radio_packet_retr_request_compact_decode(pPacketBuffer + iHeaderSize, pPH->total_length - iHeaderSize, uVideoBlocks, uVideoPackets, MAX_TOTAL_PACKETS_IN_BLOCK*4);
+      if ( iCount < 0 )
+      {
+         log_softerror_and_alarm("[AdaptiveVideo] Received invalid compact retr request id %u from controller (%d bytes)", uRetrId, pPH->total_length);
+         return true;
       }
-      s_uLastRecvRetransmissionId = uRetrId;
+      log_line("[AdaptiveVideo] Received compact retr request id %u from controller for %d packets", uRetrId, iCount);
+      g_pVideoTxBuffers->resendVideoPackets(uRetrId, uVideoBlocks, uVideoPackets, iCount);
    }
 
    if ( pPH->packet_type == PACKET_TYPE_VIDEO_SWITCH_TO_ADAPTIVE_VIDEO_LEVEL )
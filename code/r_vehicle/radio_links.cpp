@@ -38,6 +38,7 @@
 #include "../common/string_utils.h"
 #include "../common/radio_stats.h"
 #include "../radio/radio_tx.h"
+#include "packets_utils.h"
 #include "shared_vars.h"
 #include "timers.h"
 
@@ -46,6 +47,7 @@ int radio_links_open_rxtx_radio_interfaces()
 {
    log_line("OPENING INTERFACES BEGIN =========================================================");
    log_line("Opening RX/TX radio interfaces...");
+   packet_utils_invalidate_tx_routes();
    if ( g_pCurrentModel->relay_params.isRelayEnabledOnRadioLinkId >= 0 )
       log_line("Relaying is enabled on radio link %d on frequency: %s.", g_pCurrentModel->relay_params.isRelayEnabledOnRadioLinkId+1, str_format_frequency(g_pCurrentModel->relay_params.uRelayFrequencyKhz));
 
@@ -275,6 +277,7 @@ int radio_links_open_rxtx_radio_interfaces()
 void radio_links_close_rxtx_radio_interfaces()
 {
    log_line("Closing all radio interfaces (rx/tx).");
+   packet_utils_invalidate_tx_routes();
 
    radio_tx_mark_quit();
    hardware_sleep_ms(10);
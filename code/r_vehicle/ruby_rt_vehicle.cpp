@@ -528,20 +528,20 @@ void reinit_radio_interfaces()
    //hw_execute_bash_command("ifconfig wlan1 down", NULL);
    //hw_execute_bash_command("ifconfig wlan2 down", NULL);
    //hw_execute_bash_command("ifconfig wlan3 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan0 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan1 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan2 down", NULL);
-   hw_execute_bash_command("ip link set dev wlan3 down", NULL);
+   hardware_radio_set_link_up("wlan0", 0);
+   hardware_radio_set_link_up("wlan1", 0);
+   hardware_radio_set_link_up("wlan2", 0);
+   hardware_radio_set_link_up("wlan3", 0);
    hardware_sleep_ms(200);
 
    //hw_execute_bash_command("ifconfig wlan0 up", NULL);
    //hw_execute_bash_command("ifconfig wlan1 up", NULL);
    //hw_execute_bash_command("ifconfig wlan2 up", NULL);
    //hw_execute_bash_command("ifconfig wlan3 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan0 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan1 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan2 up", NULL);
-   hw_execute_bash_command("ip link set dev wlan3 up", NULL);
+   hardware_radio_set_link_up("wlan0", 1);
+   hardware_radio_set_link_up("wlan1", 1);
+   hardware_radio_set_link_up("wlan2", 1);
+   hardware_radio_set_link_up("wlan3", 1);
    
    hardware_radio_remove_stored_config();
    
@@ -856,7 +856,7 @@ void _synchronize_shared_mems()
       update_shared_mem_video_frames_stats( &g_VideoInfoStatsCameraOutput, g_TimeNow);
 
       if ( NULL != g_pSM_VideoInfoStatsCameraOutput )
-         memcpy((u8*)g_pSM_VideoInfoStatsCameraOutput, (u8*)&g_VideoInfoStatsCameraOutput, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoInfoStatsCameraOutput, &g_VideoInfoStatsCameraOutput, sizeof(shared_mem_video_frames_stats));
       else
       {
         g_pSM_VideoInfoStatsCameraOutput = shared_mem_video_frames_stats_open_for_write();
@@ -875,7 +875,7 @@ void _synchronize_shared_mems()
       update_shared_mem_video_frames_stats( &g_VideoInfoStatsRadioOut, g_TimeNow);
 
       if ( NULL != g_pSM_VideoInfoStatsRadioOut )
-         memcpy((u8*)g_pSM_VideoInfoStatsRadioOut, (u8*)&g_VideoInfoStatsRadioOut, sizeof(shared_mem_video_frames_stats));
+         shared_mem_publish(g_pSM_VideoInfoStatsRadioOut, &g_VideoInfoStatsRadioOut, sizeof(shared_mem_video_frames_stats));
       else
       {
         g_pSM_VideoInfoStatsRadioOut = shared_mem_video_frames_stats_radio_out_open_for_write();
@@ -892,7 +892,7 @@ void _synchronize_shared_mems()
    if ( g_TimeNow >= s_uTimeLastRxHistorySync + 100 )
    {
       s_uTimeLastRxHistorySync = g_TimeNow;
-      memcpy((u8*)g_pSM_HistoryRxStats, (u8*)&g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
+      shared_mem_publish(g_pSM_HistoryRxStats, &g_SM_HistoryRxStats, sizeof(shared_mem_radio_stats_rx_hist));
    }
 }
 
@@ -1184,6 +1184,7 @@ void handle_sigint(int sig)
    log_line("--------------------------");
    log_line("Caught signal to stop: %d", sig);
    log_line("--------------------------");
+   log_flush();
    g_bQuit = true;
    radio_rx_mark_quit();
 } 
@@ -1796,6 +1797,7 @@ int _main_loop_try_read_camera()
 
             process_received_single_radio_packet(iRadioInterfaceIndex, pPacket, iPacketLength);      
             shared_mem_radio_stats_rx_hist_update(&g_SM_HistoryRxStats, iRadioInterfaceIndex, pPacket, g_TimeNow);
+            radio_rx_release_high_prio_packets();
 
             g_pProcessStats->uLoopSubStep = 13;
          }
@@ -1852,6 +1854,7 @@ void _main_loop()
 
       process_received_single_radio_packet(iRadioInterfaceIndex, pPacket, iPacketLength);      
       shared_mem_radio_stats_rx_hist_update(&g_SM_HistoryRxStats, iRadioInterfaceIndex, pPacket, g_TimeNow);
+      radio_rx_release_high_prio_packets();
    }
 
    g_pProcessStats->uLoopSubStep = 3;
@@ -1883,6 +1886,7 @@ void _main_loop()
 
       shared_mem_radio_stats_rx_hist_update(&g_SM_HistoryRxStats, iRadioInterfaceIndex, pPacket, g_TimeNow);
       process_received_single_radio_packet(iRadioInterfaceIndex, pPacket, iPacketLength);
+      radio_rx_release_reg_prio_packets();
    
       g_pProcessStats->uLoopSubStep = 23;
 
@@ -38,6 +38,7 @@
 #include "../base/commands.h"
 #include "../base/models.h"
 #include "../base/models_list.h"
+#include "../base/models_binary.h"
 #include "../base/radio_utils.h"
 #include "../base/hardware.h"
 #include "../base/hardware_files.h"
@@ -98,6 +99,8 @@ static u32 s_ZIPParams_uLastRecvCommandNumber = 0;
 static u32 s_ZIPPAarams_uLastRecvCommandTime = 0;
 static u8  s_ZIPParams_Model_Buffer[3048];
 static int s_ZIPParams_Model_BufferLength = 0;
+static int s_ZIPParams_Model_ResponseParam = 1;
+static u32 s_uBinaryModelControllerId = 0; // Last controller that asked for the model settings in binary format
 
 // To fix
 //static shared_mem_video_link_overwrites s_CurrentVideoLinkOverwrites;
@@ -120,7 +123,7 @@ typedef struct
 t_structure_file_upload_info s_InfoLastFileUploaded;
 
 
-u8 s_bufferModelSettings[2048];
+u8 s_bufferModelSettings[MODEL_BINARY_MAX_SIZE];
 int s_bufferModelSettingsLength = 0;
 
 void signalReloadModel(u32 uChangeType, u8 uExtraParam);
@@ -191,14 +194,34 @@ bool _populate_camera_name()
    return bCameraNameUpdated;
 }
 
+// The format is chosen for the controller the model settings are sent to, not for the last one that asked for them
+
+static bool _controller_supports_binary_model(u32 uControllerId)
+{
+   return (0 != uControllerId) && (uControllerId == s_uBinaryModelControllerId);
+}
+
 void populate_model_settings_buffer()
 {
    _populate_camera_name();
 
+   if ( _controller_supports_binary_model(g_pCurrentModel->uControllerId) )
+   {
+      u8 uBinaryModel[MODEL_BINARY_MAX_SIZE];
+      int iBinaryLength = g_pCurrentModel->saveToBinaryBuffer(uBinaryModel, sizeof(uBinaryModel), false, NULL);
+      s_bufferModelSettingsLength = 0;
+      if ( iBinaryLength > 0 )
+         s_bufferModelSettingsLength = model_binary_compress(uBinaryModel, iBinaryLength, s_bufferModelSettings, sizeof(s_bufferModelSettings));
+      if ( s_bufferModelSettingsLength < 0 )
+         s_bufferModelSettingsLength = 0;
+      log_line("Generated buffer with binary model settings. Size: %d bytes, compressed: %d bytes", iBinaryLength, s_bufferModelSettingsLength);
+      return;
+   }
+
    char szFile[MAX_FILE_PATH_SIZE];
    strcpy(szFile, FOLDER_RUBY_TEMP);
    strcat(szFile, "tmp_download_model.mdl");
-   g_pCurrentModel->saveToFile(szFile, false);
+   g_pCurrentModel->exportToTextFile(szFile, false);
 
    char szComm[256];
    sprintf(szComm, "rm -rf %s/model.tar* 2>/dev/null", FOLDER_RUBY_TEMP);
@@ -235,8 +258,10 @@ void populate_model_settings_buffer()
 void send_model_settings_to_controller()
 {
    populate_model_settings_buffer();
+   bool bBinaryModel = _controller_supports_binary_model(g_pCurrentModel->uControllerId);
 
-   if ( 0 == s_bufferModelSettingsLength || s_bufferModelSettingsLength > MAX_PACKET_PAYLOAD )
+   // Binary model settings bigger than a packet are sent only as small segments
+   if ( (0 == s_bufferModelSettingsLength) || ((! bBinaryModel) && (s_bufferModelSettingsLength > MAX_PACKET_PAYLOAD)) )
    {
       log_softerror_and_alarm("Invalid compressed model file size (%d). Skipping sending it to controller.", s_bufferModelSettingsLength);
       return;
@@ -249,29 +274,35 @@ void send_model_settings_to_controller()
    static u32 s_uCommandsSettingsParamsUniqueCounter = 0;
    s_uCommandsSettingsParamsUniqueCounter++;
    u32 uStartFlag = 0xFFFFFFF0; // tar gzip format
+   if ( bBinaryModel )
+      uStartFlag = MODEL_BINARY_SETTINGS_START_FLAG;
    u8 uFlags = 0;
 
    t_packet_header PH;
-   radio_packet_init(&PH, PACKET_COMPONENT_RUBY, PACKET_TYPE_RUBY_MODEL_SETTINGS, STREAM_ID_DATA);
-   PH.vehicle_id_src = g_pCurrentModel->uVehicleId;
-   PH.vehicle_id_dest = g_pCurrentModel->uControllerId;
-   PH.total_length = sizeof(t_packet_header) + s_bufferModelSettingsLength + 2*sizeof(u32) + sizeof(u8);
-
    u8 packet[MAX_PACKET_TOTAL_SIZE];
-   memcpy(packet, (u8*)&PH, sizeof(t_packet_header));
-   memcpy(packet + sizeof(t_packet_header), (u8*)&uStartFlag, sizeof(u32));
-   memcpy(packet + sizeof(t_packet_header) + sizeof(u32), (u8*)&s_uCommandsSettingsParamsUniqueCounter, sizeof(u32));
-   memcpy(packet + sizeof(t_packet_header) + 2*sizeof(u32), (u8*)&uFlags, sizeof(u8));
-   memcpy(packet + sizeof(t_packet_header) + 2*sizeof(u32) + sizeof(u8), (u8*)&(s_bufferModelSettings[0]), s_bufferModelSettingsLength);
 
-   ruby_ipc_channel_send_message(s_fIPCToRouter, packet, PH.total_length);
+   if ( s_bufferModelSettingsLength <= MAX_PACKET_PAYLOAD )
+   {
+      radio_packet_init(&PH, PACKET_COMPONENT_RUBY, PACKET_TYPE_RUBY_MODEL_SETTINGS, STREAM_ID_DATA);
+      PH.vehicle_id_src = g_pCurrentModel->uVehicleId;
+      PH.vehicle_id_dest = g_pCurrentModel->uControllerId;
+      PH.total_length = sizeof(t_packet_header) + s_bufferModelSettingsLength + 2*sizeof(u32) + sizeof(u8);
 
-   if ( NULL != g_pProcessStats )
-      g_pProcessStats->lastIPCOutgoingTime = g_TimeNow;
-   if ( NULL != g_pProcessStats )
-      g_pProcessStats->lastActiveTime = get_current_timestamp_ms();
+      memcpy(packet, (u8*)&PH, sizeof(t_packet_header));
+      memcpy(packet + sizeof(t_packet_header), (u8*)&uStartFlag, sizeof(u32));
+      memcpy(packet + sizeof(t_packet_header) + sizeof(u32), (u8*)&s_uCommandsSettingsParamsUniqueCounter, sizeof(u32));
+      memcpy(packet + sizeof(t_packet_header) + 2*sizeof(u32), (u8*)&uFlags, sizeof(u8));
+      memcpy(packet + sizeof(t_packet_header) + 2*sizeof(u32) + sizeof(u8), (u8*)&(s_bufferModelSettings[0]), s_bufferModelSettingsLength);
+
+      ruby_ipc_channel_send_message(s_fIPCToRouter, packet, PH.total_length);
 
-   log_line("Sent to router all model settings (send unique id: %u). Total compressed size: %d bytes", s_uCommandsSettingsParamsUniqueCounter, s_bufferModelSettingsLength); 
+      if ( NULL != g_pProcessStats )
+         g_pProcessStats->lastIPCOutgoingTime = g_TimeNow;
+      if ( NULL != g_pProcessStats )
+         g_pProcessStats->lastActiveTime = get_current_timestamp_ms();
+
+      log_line("Sent to router all model settings (send unique id: %u). Total compressed size: %d bytes", s_uCommandsSettingsParamsUniqueCounter, s_bufferModelSettingsLength); 
+   }
    
    int iSegmentSize = 150;
    int iCountSegments = s_bufferModelSettingsLength / iSegmentSize;
@@ -3163,7 +3194,42 @@ bool process_command(u8* pBuffer, int length)
       log_line("Current OSD params, current layout: %d, enabled: %s", g_pCurrentModel->osd_params.iCurrentOSDLayout, (g_pCurrentModel->osd_params.osd_flags2[g_pCurrentModel->osd_params.iCurrentOSDLayout] & OSD_FLAG2_LAYOUT_ENABLED)?"yes":"no");
       log_line("Current on time: %02d:%02d, current flights: %d", g_pCurrentModel->m_Stats.uCurrentOnTime/60, g_pCurrentModel->m_Stats.uCurrentOnTime%60, g_pCurrentModel->m_Stats.uTotalFlights);
 
+      // Controllers that support the binary model format get it directly (no tar/gzip),
+      // as a delta against their current copy of the model, if they sent its sections CRCs
       if ( bNewZIPCommand )
+      {
+         if ( pPHC->command_param & MODEL_BINARY_GET_PARAMS_FLAG )
+            s_uBinaryModelControllerId = lastRecvSourceControllerId;
+         else if ( s_uBinaryModelControllerId == lastRecvSourceControllerId )
+            s_uBinaryModelControllerId = 0;
+      }
+
+      if ( bNewZIPCommand && (pPHC->command_param & MODEL_BINARY_GET_PARAMS_FLAG) )
+      {
+         u32* pBaseCRCs = NULL;
+         u32 uBaseCRCs[MODEL_BINARY_MAX_SECTIONS];
+         if ( iParamsLength == (int)sizeof(uBaseCRCs) )
+         {
+            memcpy((u8*)uBaseCRCs, pBuffer + sizeof(t_packet_header) + sizeof(t_packet_header_command), sizeof(uBaseCRCs));
+            pBaseCRCs = uBaseCRCs;
+         }
+         u8 uBinaryModel[MODEL_BINARY_MAX_SIZE];
+         int iBinaryLength = g_pCurrentModel->saveToBinaryBuffer(uBinaryModel, sizeof(uBinaryModel), false, pBaseCRCs);
+         s_ZIPParams_Model_BufferLength = 0;
+         if ( iBinaryLength > 0 )
+            s_ZIPParams_Model_BufferLength = model_binary_compress(uBinaryModel, iBinaryLength, s_ZIPParams_Model_Buffer, sizeof(s_ZIPParams_Model_Buffer));
+         if ( s_ZIPParams_Model_BufferLength <= 0 )
+         {
+            log_softerror_and_alarm("Failed to generate binary model settings (%d bytes). Skipping sending it to controller.", iBinaryLength);
+            s_ZIPParams_Model_BufferLength = 0;
+            sendCommandReply(COMMAND_RESPONSE_FLAGS_FAILED, 0, 0);
+            return true;
+         }
+         s_ZIPParams_Model_ResponseParam = MODEL_BINARY_COMMAND_RESPONSE_PARAM;
+         log_line("Generated binary model settings (%s): %d bytes, compressed: %d bytes",
+            (NULL != pBaseCRCs)?"delta":"full", iBinaryLength, s_ZIPParams_Model_BufferLength);
+      }
+      else if ( bNewZIPCommand )
       {
          char szComm[256];
          sprintf(szComm, "rm -rf %s/model.tar* 2>/dev/null", FOLDER_RUBY_TEMP);
@@ -3171,11 +3237,11 @@ bool process_command(u8* pBuffer, int length)
          sprintf(szComm, "rm -rf %s/model.mdl 2>/dev/null", FOLDER_RUBY_TEMP);
          hw_execute_bash_command(szComm, NULL);
 
+         // Older controllers only know the text model file format
          char szFile[128];
-         strcpy(szFile, FOLDER_CONFIG);
-         strcat(szFile, FILE_CONFIG_CURRENT_VEHICLE_MODEL);
-         sprintf(szComm, "cp -rf %s %s/model.mdl 2>/dev/null", szFile, FOLDER_RUBY_TEMP);
-         hw_execute_bash_command(szComm, NULL);
+         sprintf(szFile, "%s/model.mdl", FOLDER_RUBY_TEMP);
+         g_pCurrentModel->exportToTextFile(szFile, false);
+         s_ZIPParams_Model_ResponseParam = 1;
          sprintf(szComm, "tar -C %s -cf %s/model.tar model.mdl 2>&1", FOLDER_RUBY_TEMP, FOLDER_RUBY_TEMP);
          hw_execute_bash_command(szComm, NULL);
          sprintf(szComm, "gzip %s/model.tar 2>&1", FOLDER_RUBY_TEMP);
@@ -3207,10 +3273,22 @@ bool process_command(u8* pBuffer, int length)
          }
       }
 
-      setCommandReplyBuffer(s_ZIPParams_Model_Buffer, s_ZIPParams_Model_BufferLength);
-      sendCommandReply(COMMAND_RESPONSE_FLAGS_OK, 1, 10);
-      log_line("Sent back to router all model settings in one single command response. Total compressed size: %d bytes", s_ZIPParams_Model_BufferLength);
-      
+      // A full binary model can be bigger than a packet; it's sent only in small segments then
+      bool bFitsInSingleResponse = (s_ZIPParams_Model_BufferLength > 0) && (s_ZIPParams_Model_BufferLength <= MAX_PACKET_PAYLOAD);
+      if ( (! bFitsInSingleResponse) && ((! bSendBackSmallSegments) || (0 == s_ZIPParams_Model_BufferLength)) )
+      {
+         log_softerror_and_alarm("Invalid model settings size (%d) for a single response. Skipping sending it to controller.", s_ZIPParams_Model_BufferLength);
+         sendCommandReply(COMMAND_RESPONSE_FLAGS_FAILED, 0, 0);
+         return true;
+      }
+
+      if ( bFitsInSingleResponse )
+      {
+         setCommandReplyBuffer(s_ZIPParams_Model_Buffer, s_ZIPParams_Model_BufferLength);
+         sendCommandReply(COMMAND_RESPONSE_FLAGS_OK, s_ZIPParams_Model_ResponseParam, 10);
+         log_line("Sent back to router all model settings in one single command response. Total compressed size: %d bytes", s_ZIPParams_Model_BufferLength);
+      }
+
       if ( bSendBackSmallSegments )
       {
          int iSegmentSize = 150;
@@ -3235,7 +3313,7 @@ bool process_command(u8* pBuffer, int length)
             uSegment[3] = iSize;
             memcpy( &(uSegment[4]), s_ZIPParams_Model_Buffer + iPos, iSize);
             setCommandReplyBuffer(uSegment, iSize+4);
-            sendCommandReply(COMMAND_RESPONSE_FLAGS_OK, 1, 10);
+            sendCommandReply(COMMAND_RESPONSE_FLAGS_OK, s_ZIPParams_Model_ResponseParam, 10);
             log_line("Sent back to router model settings command response as small segment (%d of %d) size: %d bytes",
                iSegment+1, iCountSegments, iSize);             
             iSegment++;
@@ -3601,6 +3679,7 @@ void handle_sigint_rc(int sig)
    log_line("--------------------------");
    log_line("Caught signal to stop: %d", sig);
    log_line("--------------------------");
+   log_flush();
    g_bQuit = true;
 } 
 
@@ -3690,7 +3769,8 @@ int r_start_commands_rx(int argc, char* argv[])
 
    while (!g_bQuit) 
    {
-      hardware_sleep_ms(iSleepIntervalMS);
+      // Wakes up early if the router sends a message
+      ruby_ipc_wait_for_message(s_fIPCFromRouter, iSleepIntervalMS*1000);
       g_TimeNow = get_current_timestamp_ms();
       u32 tTime0 = g_TimeNow;
 
@@ -214,7 +214,8 @@ int r_start_rx_rc(int argc, char *argv[])
 
    while (!g_bQuit) 
    {
-      hardware_sleep_ms(iSleepIntervalMS);
+      // Wakes up early if the router sends a message
+      ruby_ipc_wait_for_message(s_fIPC_FromRouter, iSleepIntervalMS*1000);
       if ( iSleepIntervalMS < 50 )
          iSleepIntervalMS += 10;
 
@@ -42,6 +42,7 @@
 #include "shared_vars.h"
 #include "timers.h"
 #include "radio_links.h"
+#include "packets_utils.h"
 #include "adaptive_video.h"
 #include "video_source_csi.h"
 #include "video_source_majestic.h"
@@ -92,6 +93,7 @@ void _test_link_end_and_notify()
 
    memcpy(&(g_pCurrentModel->radioLinksParams), &s_RadioLinksParamsToTest, sizeof(type_radio_links_parameters));
    g_pCurrentModel->updateRadioInterfacesRadioFlagsFromRadioLinksFlags();
+   packet_utils_invalidate_tx_routes();
    
    log_line("Current radio power levels:");
    for( int i=0; i<g_pCurrentModel->radioInterfacesParams.interfaces_count; i++ )
@@ -327,6 +329,7 @@ void _test_link_switch_to_state(int iNewState, u32 uTimeout)
 
       memcpy(&(g_pCurrentModel->radioLinksParams), &s_RadioLinksParamsToTest, sizeof(type_radio_links_parameters));
       g_pCurrentModel->updateRadioInterfacesRadioFlagsFromRadioLinksFlags();
+      packet_utils_invalidate_tx_routes();
 
       if ( 0 != pthread_create(&s_pThreadTestLinkWorker, NULL, &_thread_test_link_worker_apply, NULL) )
       {
@@ -366,6 +369,7 @@ void _test_link_switch_to_state(int iNewState, u32 uTimeout)
 
       memcpy(&(g_pCurrentModel->radioLinksParams), &s_RadioLinksParamsOriginal, sizeof(type_radio_links_parameters));
       g_pCurrentModel->updateRadioInterfacesRadioFlagsFromRadioLinksFlags();
+      packet_utils_invalidate_tx_routes();
 
       if ( 0 != pthread_create(&s_pThreadTestLinkWorker, NULL, &_thread_test_link_worker_revert, NULL) )
       {
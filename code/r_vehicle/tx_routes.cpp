@@ -0,0 +1,131 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "tx_routes.h"
+
+int tx_routes_find_radio_interface(Model* pModel, shared_mem_radio_stats* pSMRS, radio_hw_info_t* pRadioInfoArray, int iRadioInfoCount, int iLocalRadioLinkId, int iClass)
+{
+   if ( (NULL == pModel) || (NULL == pSMRS) || (NULL == pRadioInfoArray) )
+      return -1;
+   if ( (iLocalRadioLinkId < 0) || (iLocalRadioLinkId >= MAX_RADIO_INTERFACES) )
+      return -1;
+
+   int iVehicleRadioLinkId = pSMRS->radio_links[iLocalRadioLinkId].matchingVehicleRadioLinkId;
+   if ( (iVehicleRadioLinkId < 0) || (iVehicleRadioLinkId >= pModel->radioLinksParams.links_count) )
+      return -1;
+
+   int iRadioInterfaceIndex = -1;
+   for( int k=0; k<pModel->radioInterfacesParams.interfaces_count; k++ )
+   {
+      if ( pModel->radioInterfacesParams.interface_link_id[k] == iVehicleRadioLinkId )
+      {
+         iRadioInterfaceIndex = k;
+         break;
+      }
+   }
+   if ( (iRadioInterfaceIndex < 0) || (iRadioInterfaceIndex >= iRadioInfoCount) )
+      return -1;
+
+   u32 uLinkFlags = pModel->radioLinksParams.link_capabilities_flags[iVehicleRadioLinkId];
+   u32 uInterfaceFlags = pModel->radioInterfacesParams.interface_capabilities_flags[iRadioInterfaceIndex];
+   u32 uUsageFlag = RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_DATA;
+   if ( iClass == TX_ROUTE_CLASS_VIDEO )
+      uUsageFlag = RADIO_HW_CAPABILITY_FLAG_CAN_USE_FOR_VIDEO;
+
+   if ( uLinkFlags & RADIO_HW_CAPABILITY_FLAG_DISABLED )
+      return -1;
+
+   // Do not send regular packets to controller using relay links
+   if ( (uLinkFlags & RADIO_HW_CAPABILITY_FLAG_USED_FOR_RELAY) ||
+        (pModel->relay_params.isRelayEnabledOnRadioLinkId == iVehicleRadioLinkId) )
+      return -1;
+
+   if ( !(uLinkFlags & RADIO_HW_CAPABILITY_FLAG_CAN_TX) )
+      return -1;
+   if ( !(uLinkFlags & uUsageFlag) )
+      return -1;
+
+   if ( uInterfaceFlags & RADIO_HW_CAPABILITY_FLAG_DISABLED )
+      return -1;
+   if ( !(uInterfaceFlags & RADIO_HW_CAPABILITY_FLAG_CAN_TX) )
+      return -1;
+   if ( !(uInterfaceFlags & uUsageFlag) )
+      return -1;
+   return iRadioInterfaceIndex;
+}
+
+void tx_routes_build(type_tx_routes_table* pTable, Model* pModel, shared_mem_radio_stats* pSMRS, radio_hw_info_t* pRadioInfoArray, int iRadioInfoCount)
+{
+   if ( NULL == pTable )
+      return;
+   for( int iClass=0; iClass<TX_ROUTE_CLASSES_COUNT; iClass++ )
+      pTable->classes[iClass].iRoutesCount = 0;
+
+   if ( (NULL == pModel) || (NULL == pSMRS) || (NULL == pRadioInfoArray) )
+      return;
+
+   for( int iClass=0; iClass<TX_ROUTE_CLASSES_COUNT; iClass++ )
+   {
+      type_tx_routes_list* pList = &(pTable->classes[iClass]);
+      for( int iRadioLinkId=0; iRadioLinkId<pModel->radioLinksParams.links_count; iRadioLinkId++ )
+      {
+         if ( pList->iRoutesCount >= MAX_RADIO_INTERFACES )
+            break;
+         int iRadioInterfaceIndex = tx_routes_find_radio_interface(pModel, pSMRS, pRadioInfoArray, iRadioInfoCount, iRadioLinkId, iClass);
+         if ( iRadioInterfaceIndex < 0 )
+            continue;
+
+         type_tx_route* pRoute = &(pList->routes[pList->iRoutesCount]);
+         pRoute->iLocalRadioLinkId = iRadioLinkId;
+         pRoute->iVehicleRadioLinkId = pSMRS->radio_links[iRadioLinkId].matchingVehicleRadioLinkId;
+         pRoute->iRadioInterfaceIndex = iRadioInterfaceIndex;
+         pRoute->pRadioHWInfo = &(pRadioInfoArray[iRadioInterfaceIndex]);
+         pRoute->bIsSerialRadio = hardware_radio_is_serial_radio(pRoute->pRadioHWInfo)?true:false;
+         pList->iRoutesCount++;
+      }
+   }
+}
+
+void tx_routes_log(type_tx_routes_table* pTable)
+{
+   if ( NULL == pTable )
+      return;
+   for( int iClass=0; iClass<TX_ROUTE_CLASSES_COUNT; iClass++ )
+   {
+      type_tx_routes_list* pList = &(pTable->classes[iClass]);
+      log_line("[TxRoutes] %s packets: %d routes.", (iClass == TX_ROUTE_CLASS_VIDEO)?"Video":"Data", pList->iRoutesCount);
+      for( int i=0; i<pList->iRoutesCount; i++ )
+         log_line("[TxRoutes]   Local radio link %d (vehicle radio link %d) -> radio interface %d%s",
+            pList->routes[i].iLocalRadioLinkId+1, pList->routes[i].iVehicleRadioLinkId+1,
+            pList->routes[i].iRadioInterfaceIndex+1, pList->routes[i].bIsSerialRadio?" (serial)":"");
+   }
+}
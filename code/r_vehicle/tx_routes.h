@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../base/base.h"
+#include "../base/models.h"
+#include "../base/hardware_radio.h"
+
+// Tx routing table: for each class of packets, the local radio links and the radio interfaces that can send them.
+// It depends only on the model radio configuration and on the local radio links assignment,
+// so it is built once when those change, not for each sent packet.
+// The opened for write state of the radio interfaces is not part of the table, it can change at any time (i.e. SiK reinit).
+
+#define TX_ROUTE_CLASS_DATA 0
+#define TX_ROUTE_CLASS_VIDEO 1 // Video and audio packets
+#define TX_ROUTE_CLASSES_COUNT 2
+
+typedef struct
+{
+   int iLocalRadioLinkId;
+   int iVehicleRadioLinkId;
+   int iRadioInterfaceIndex;
+   bool bIsSerialRadio;
+   radio_hw_info_t* pRadioHWInfo;
+}
+type_tx_route;
+
+typedef struct
+{
+   type_tx_route routes[MAX_RADIO_INTERFACES]; // In increasing local radio link order
+   int iRoutesCount;
+}
+type_tx_routes_list;
+
+typedef struct
+{
+   type_tx_routes_list classes[TX_ROUTE_CLASSES_COUNT];
+}
+type_tx_routes_table;
+
+// Returns the radio interface to use for tx on the given local radio link, or -1 if the link/interface can't send this class of packets
+int tx_routes_find_radio_interface(Model* pModel, shared_mem_radio_stats* pSMRS, radio_hw_info_t* pRadioInfoArray, int iRadioInfoCount, int iLocalRadioLinkId, int iClass);
+void tx_routes_build(type_tx_routes_table* pTable, Model* pModel, shared_mem_radio_stats* pSMRS, radio_hw_info_t* pRadioInfoArray, int iRadioInfoCount);
+void tx_routes_log(type_tx_routes_table* pTable);
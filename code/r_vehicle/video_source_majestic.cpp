@@ -35,6 +35,7 @@
 #include "../base/shared_mem.h"
 #include "../base/hardware_camera.h"
 #include "../base/hardware_cam_maj.h"
+#include "../base/hardware_cam_maj_http.h"
 #include "../base/hw_procs.h"
 #include "../base/ruby_ipc.h"
 #include "../base/parser_h264.h"
@@ -67,13 +68,11 @@
 
 int s_fInputVideoStreamUDPSocket = -1;
 int s_iInputVideoStreamUDPPort = 5600;
-bool s_bInputVideoStreamUSDPSocketSetupNonBlocking = false;
 u16 s_uLastRTPSeqNumberInUDPFrames[256];
 u16 s_uLastRTPSeqNumberInUDPFramesSkipCounter[256];
 
 bool s_bLogStartOfInputVideoData = true;
 
-u8 s_uInputVideoUDPBuffer[MAX_PACKET_TOTAL_SIZE];
 u8 s_uOutputUDPNALFrameSegment[MAX_PACKET_TOTAL_SIZE+10];
 u8 s_uInputMajAudioBuffer[MAX_AUDIO_MAJ_BUFFER];
 int s_iInputMajAudioBufferBytes = 0;
@@ -169,11 +168,16 @@ void video_source_majestic_cleanup()
    if ( s_bIsRestartingMajestic )
       pthread_cancel(s_pThreadRestartMajestic);
    s_bIsRestartingMajestic = false;
+   hardware_camera_maj_http_uninit();
 }
 
 
+void _video_source_majestic_start_capture_thread();
+void _video_source_majestic_stop_capture_thread();
+
 void video_source_majestic_close()
 {
+   _video_source_majestic_stop_capture_thread();
    if ( -1 != s_fInputVideoStreamUDPSocket )
    {
       log_line("[VideoSourceMaj] Closed input UDP socket.");
@@ -196,7 +200,6 @@ int video_source_majestic_open(int iUDPPort)
       s_uLastRTPSeqNumberInUDPFramesSkipCounter[i] = 0;
    }
    s_iInputVideoStreamUDPPort = iUDPPort;
-   s_bInputVideoStreamUSDPSocketSetupNonBlocking = false;
    struct sockaddr_in server_addr;
    s_fInputVideoStreamUDPSocket = socket(AF_INET, SOCK_DGRAM, 0);
    if (s_fInputVideoStreamUDPSocket == -1)
@@ -241,7 +244,8 @@ int video_source_majestic_open(int iUDPPort)
    }
 
    log_line("[VideoSourceMaj] Opened read socket on port %d for reading video stream. socket fd = %d", s_iInputVideoStreamUDPPort, s_fInputVideoStreamUDPSocket);
-   
+
+   _video_source_majestic_start_capture_thread();
    return s_fInputVideoStreamUDPSocket;
 }
 
@@ -315,166 +319,246 @@ uint32_t extract_udp_rxq_overflow(struct msghdr *msg)
     return 0;
 }
 
-int _video_source_majestic_try_read_input_udp_data(bool bAsync)
+// ---------------------------------------------------------
+// UDP capture thread: reads the RTP packets from majestic in batches (recvmmsg) into
+// a single producer/single consumer ring of preallocated slots, so the socket is drained
+// even when the router main loop is busy. The main loop consumes the slots without blocking.
+
+#define MAJESTIC_CAPTURE_RING_PACKETS 256
+#define MAJESTIC_CAPTURE_BATCH_PACKETS 32
+
+typedef struct
 {
-   if ( -1 == s_fInputVideoStreamUDPSocket )
-      return -1;
+   u8 uData[MAX_PACKET_TOTAL_SIZE];
+   int iLength;
+   u32 uTimeReceived;
+   u32 uRxqOverflowCounter; // Socket rxq drops counter at the time this packet was read
+} type_majestic_capture_slot;
+
+type_majestic_capture_slot* s_pMajesticCaptureRing = NULL;
+int s_iMajesticCaptureIndexWrite = 0; // Stored only by the capture thread
+int s_iMajesticCaptureIndexRead = 0; // Stored only by the consumer (router main loop)
+bool s_bMajesticCaptureHasHeldSlot = false; // Consumer holds the slot at the read index until the next read
+u32 s_uMajesticCaptureRingDrops = 0;
+volatile bool s_bMajesticCaptureThreadStop = false;
+bool s_bMajesticCaptureThreadStarted = false;
+pthread_t s_pThreadMajesticCapture;
+
+void* _thread_majestic_udp_capture(void *argument)
+{
+   log_line("[VideoSourceMajCapture] Started UDP capture thread.");
 
-   int nRecvBytes = 0;
-   if ( bAsync )
+   static struct mmsghdr s_Messages[MAJESTIC_CAPTURE_BATCH_PACKETS];
+   static struct iovec s_IOVectors[MAJESTIC_CAPTURE_BATCH_PACKETS];
+   static u8 s_uControlBuffers[MAJESTIC_CAPTURE_BATCH_PACKETS][CMSG_SPACE(sizeof(uint32_t))];
+   static u8 s_uDiscardBuffer[MAX_PACKET_TOTAL_SIZE];
+   u32 uRxqOverflowCounter = 0;
+
+   while ( ! s_bMajesticCaptureThreadStop )
    {
-      if ( s_bInputVideoStreamUSDPSocketSetupNonBlocking )
+      // Read directly into the free contiguous slots of the ring
+      int iIndexWrite = s_iMajesticCaptureIndexWrite;
+      int iIndexRead = __atomic_load_n(&s_iMajesticCaptureIndexRead, __ATOMIC_ACQUIRE);
+      int iFree = iIndexRead - iIndexWrite - 1;
+      if ( iFree < 0 )
+         iFree += MAJESTIC_CAPTURE_RING_PACKETS;
+      int iCount = iFree;
+      if ( iCount > MAJESTIC_CAPTURE_RING_PACKETS - iIndexWrite )
+         iCount = MAJESTIC_CAPTURE_RING_PACKETS - iIndexWrite;
+      if ( iCount > MAJESTIC_CAPTURE_BATCH_PACKETS )
+         iCount = MAJESTIC_CAPTURE_BATCH_PACKETS;
+
+      // Ring is full: keep draining the socket (into a discard buffer) so the drops are counted here, not in the socket
+      bool bDiscard = (iCount <= 0);
+      if ( bDiscard )
+         iCount = 1;
+
+      memset(s_Messages, 0, iCount * sizeof(struct mmsghdr));
+      for( int i=0; i<iCount; i++ )
       {
-         s_bInputVideoStreamUSDPSocketSetupNonBlocking = false;
-         if ( fcntl(s_fInputVideoStreamUDPSocket, F_SETFL, fcntl(s_fInputVideoStreamUDPSocket, F_GETFL, 0) | O_NONBLOCK) < 0 )
-            log_softerror_and_alarm("[VideoSourceMaj] Unable to set socket into nonblocked mode: %s", strerror(errno));
-
-         log_line("[VideoSourceMaj] Done first time video USD socket setup.");
+         s_IOVectors[i].iov_base = bDiscard?s_uDiscardBuffer:s_pMajesticCaptureRing[iIndexWrite+i].uData;
+         s_IOVectors[i].iov_len = MAX_PACKET_TOTAL_SIZE;
+         s_Messages[i].msg_hdr.msg_iov = &s_IOVectors[i];
+         s_Messages[i].msg_hdr.msg_iovlen = 1;
+         s_Messages[i].msg_hdr.msg_control = s_uControlBuffers[i];
+         s_Messages[i].msg_hdr.msg_controllen = sizeof(s_uControlBuffers[i]);
       }
 
-      static uint8_t cmsgbuf[CMSG_SPACE(sizeof(uint32_t))];
-
-      //static int nfds = 1;
-      //static struct pollfd fds[2];
-      //memset(fds, '\0', sizeof(fds));
-      //fds[0].fd = s_fInputVideoStreamUDPSocket;
-      //fds[0].events = POLLIN;
-      //int res = poll(fds, nfds, 1);
-      fd_set fdSet;
-      FD_ZERO(&fdSet);
-      FD_SET(s_fInputVideoStreamUDPSocket, &fdSet);
-      struct timeval timeWait;
-      timeWait.tv_sec = 0;
-      timeWait.tv_usec = 200;
-      int res = select(s_fInputVideoStreamUDPSocket+1, &fdSet, NULL, NULL, &timeWait);
-      if ( res < 0 )
+      // Blocks until at least one packet is available (or the socket receive timeout expires)
+      int iRead = recvmmsg(s_fInputVideoStreamUDPSocket, s_Messages, iCount, MSG_WAITFORONE, NULL);
+      if ( iRead <= 0 )
       {
-         log_error_and_alarm("[VideoSourceMaj] Failed to poll UDP socket.");
-         return -1;
+         if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR) )
+            continue;
+         if ( s_bMajesticCaptureThreadStop )
+            break;
+         log_softerror_and_alarm("[VideoSourceMajCapture] Failed to read from UDP socket, error: %s", strerror(errno));
+         hardware_sleep_ms(10);
+         continue;
       }
-      if ( 0 == res )
-         return 0;
-      /*
-      if (fds[0].revents & (POLLERR | POLLNVAL))
+
+      u32 uTimeNow = get_current_timestamp_ms();
+      if ( bDiscard )
       {
-         log_softerror_and_alarm("[VideoSourceMaj] Socket error pooling: %s", strerror(errno));
-         return -1;
+         s_uMajesticCaptureRingDrops++;
+         continue;
       }
-      if ( ! (fds[0].revents & POLLIN) )
-         return 0;
-      */
-      if ( 0 == FD_ISSET(s_fInputVideoStreamUDPSocket, &fdSet) )
-         return 0;
-      struct iovec iov = { .iov_base = (void*)s_uInputVideoUDPBuffer,
-                                            .iov_len = sizeof(s_uInputVideoUDPBuffer) };
-      struct msghdr msghdr = { .msg_name = NULL,
-                               .msg_namelen = 0,
-                               .msg_iov = &iov,
-                               .msg_iovlen = 1,
-                               .msg_control = &cmsgbuf,
-                               .msg_controllen = sizeof(cmsgbuf),
-                               .msg_flags = 0 };
-
-      memset(cmsgbuf, '\0', sizeof(cmsgbuf));
-
-      nRecvBytes = recvmsg(s_fInputVideoStreamUDPSocket, &msghdr, 0);
-      if ( nRecvBytes < 0 )
+
+      for( int i=0; i<iRead; i++ )
       {
-         log_softerror_and_alarm("[VideoSourceMaj] Failed to recvmsg from UDP socket, error: %s", strerror(errno));
-         return -1;
+         type_majestic_capture_slot* pSlot = &s_pMajesticCaptureRing[iIndexWrite+i];
+         u32 uCounter = extract_udp_rxq_overflow(&s_Messages[i].msg_hdr);
+         if ( 0 != uCounter )
+            uRxqOverflowCounter = uCounter;
+         pSlot->iLength = (int)s_Messages[i].msg_len;
+         if ( s_Messages[i].msg_hdr.msg_flags & MSG_TRUNC )
+            pSlot->iLength = MAX_PACKET_TOTAL_SIZE;
+         pSlot->uTimeReceived = uTimeNow;
+         pSlot->uRxqOverflowCounter = uRxqOverflowCounter;
       }
 
-      for(int i=4; i>0; i--)
-         s_uLastVideoSourceReadTimestamps[i] = s_uLastVideoSourceReadTimestamps[i-1];
-      s_uLastVideoSourceReadTimestamps[0] = g_TimeNow;
+      iIndexWrite += iRead;
+      if ( iIndexWrite >= MAJESTIC_CAPTURE_RING_PACKETS )
+         iIndexWrite = 0;
+      __atomic_store_n(&s_iMajesticCaptureIndexWrite, iIndexWrite, __ATOMIC_RELEASE);
+   }
 
-      if ( nRecvBytes > MAX_PACKET_TOTAL_SIZE )
-      {
-         log_softerror_and_alarm("[VideoSourceMaj] Read too much data %d bytes from UDP socket", nRecvBytes);
-         nRecvBytes = MAX_PACKET_TOTAL_SIZE;
-      }
+   log_line("[VideoSourceMajCapture] Stopped UDP capture thread.");
+   return NULL;
+}
+
+void _video_source_majestic_start_capture_thread()
+{
+   if ( s_bMajesticCaptureThreadStarted )
+      return;
 
-      static uint32_t rxq_overflow = 0;
-      uint32_t cur_rxq_overflow = extract_udp_rxq_overflow(&msghdr);
-      if (cur_rxq_overflow != rxq_overflow)
+   if ( NULL == s_pMajesticCaptureRing )
+   {
+      s_pMajesticCaptureRing = (type_majestic_capture_slot*) malloc(MAJESTIC_CAPTURE_RING_PACKETS * sizeof(type_majestic_capture_slot));
+      if ( NULL == s_pMajesticCaptureRing )
       {
-          u32 uDroppedCount = cur_rxq_overflow - rxq_overflow;
-          if ( s_bRequestedVideoMajesticCaptureUpdate )
-             log_line("[VideoSourceMaj] UDP dropped %u packets while reconfiguring majestic.", uDroppedCount);
-          else
-          {
-             log_softerror_and_alarm("[VideoSourceMaj] UDP rxq overflow: %u packets dropped (from %u to %u)", uDroppedCount, rxq_overflow, cur_rxq_overflow);
-             log_softerror_and_alarm("[VideoSourceMaj] Last 4 majestic UDP reads: %u ms ago, %u ms ago, %u ms ago, %u ms ago",
-                s_uLastVideoSourceReadTimestamps[1] - g_TimeNow, s_uLastVideoSourceReadTimestamps[2] - g_TimeNow, s_uLastVideoSourceReadTimestamps[3] - g_TimeNow, s_uLastVideoSourceReadTimestamps[4] - g_TimeNow );
-             if ( cur_rxq_overflow > rxq_overflow + 1 )
-             if ( g_TimeNow > s_uLastAlarmUDPOveflowTimestamp + 10000 )
-             if ( g_TimeNow > g_TimeStart + 10000 )
-             if ( g_TimeNow > hardware_camera_maj_get_last_change_time() + 3000 )
-             {
-                s_uLastAlarmUDPOveflowTimestamp = g_TimeNow;
-                u32 uFlags2 = 0;
-                u32 uDelta = s_uLastVideoSourceReadTimestamps[0] - s_uLastVideoSourceReadTimestamps[1];
-                if ( uDelta > 255 )
-                   uDelta = 255;
-                uFlags2 |= uDelta & 0xFF;
-                uDelta = s_uLastVideoSourceReadTimestamps[1] - s_uLastVideoSourceReadTimestamps[2];
-                if ( uDelta > 255 )
-                   uDelta = 255;
-                uFlags2 |= (uDelta & 0xFF) << 8;
-                uDelta = s_uLastVideoSourceReadTimestamps[2] - s_uLastVideoSourceReadTimestamps[3];
-                if ( uDelta > 255 )
-                   uDelta = 255;
-                uFlags2 |= (uDelta & 0xFF) << 16;
-                
-                send_alarm_to_controller(ALARM_ID_DEVELOPER_ALARM, ALARM_FLAG_DEVELOPER_ALARM_UDP_SKIPPED | ((uDroppedCount & 0xFF) << 8), uFlags2, 5);
-             }
-          }
-          rxq_overflow = cur_rxq_overflow;
+         log_error_and_alarm("[VideoSourceMaj] Failed to allocate UDP capture ring buffers.");
+         return;
       }
    }
-   else
+   s_iMajesticCaptureIndexWrite = 0;
+   s_iMajesticCaptureIndexRead = 0;
+   s_bMajesticCaptureHasHeldSlot = false;
+   s_uMajesticCaptureRingDrops = 0;
+
+   // Blocking socket with a receive timeout, so the thread can check for stop requests
+   struct timeval timeout;
+   timeout.tv_sec = 0;
+   timeout.tv_usec = 50*1000;
+   if ( 0 != setsockopt(s_fInputVideoStreamUDPSocket, SOL_SOCKET, SO_RCVTIMEO, (const void *)&timeout, sizeof(timeout)) )
+      log_softerror_and_alarm("[VideoSourceMaj] Unable to set SO_RCVTIMEO: %s", strerror(errno));
+
+   s_bMajesticCaptureThreadStop = false;
+   if ( 0 != pthread_create(&s_pThreadMajesticCapture, NULL, &_thread_majestic_udp_capture, NULL) )
    {
-      fd_set readset;
-      FD_ZERO(&readset);
-      FD_SET(s_fInputVideoStreamUDPSocket, &readset);
+      log_error_and_alarm("[VideoSourceMaj] Failed to create UDP capture thread.");
+      return;
+   }
+   s_bMajesticCaptureThreadStarted = true;
+   log_line("[VideoSourceMaj] Started UDP capture thread (%d packets ring, %d packets read batches).", MAJESTIC_CAPTURE_RING_PACKETS, MAJESTIC_CAPTURE_BATCH_PACKETS);
+}
 
-      struct timeval timePipeInput;
-      timePipeInput.tv_sec = 0;
-      timePipeInput.tv_usec = 5*1000; // 5 miliseconds timeout
+void _video_source_majestic_stop_capture_thread()
+{
+   if ( ! s_bMajesticCaptureThreadStarted )
+      return;
+   s_bMajesticCaptureThreadStop = true;
+   pthread_join(s_pThreadMajesticCapture, NULL);
+   s_bMajesticCaptureThreadStarted = false;
+   log_line("[VideoSourceMaj] Stopped UDP capture thread (%u packets dropped on full ring).", s_uMajesticCaptureRingDrops);
+}
 
-      int iSelectResult = select(s_fInputVideoStreamUDPSocket+1, &readset, NULL, NULL, &timePipeInput);
-      if ( iSelectResult < 0 )
+void _video_source_majestic_check_rxq_overflow(u32 uCurrentRxqOverflow)
+{
+   static uint32_t rxq_overflow = 0;
+   if ( uCurrentRxqOverflow == rxq_overflow )
+      return;
+
+   u32 uDroppedCount = uCurrentRxqOverflow - rxq_overflow;
+   if ( s_bRequestedVideoMajesticCaptureUpdate )
+      log_line("[VideoSourceMaj] UDP dropped %u packets while reconfiguring majestic.", uDroppedCount);
+   else
+   {
+      log_softerror_and_alarm("[VideoSourceMaj] UDP rxq overflow: %u packets dropped (from %u to %u)", uDroppedCount, rxq_overflow, uCurrentRxqOverflow);
+      log_softerror_and_alarm("[VideoSourceMaj] Last 4 majestic UDP reads: %u ms ago, %u ms ago, %u ms ago, %u ms ago",
+         s_uLastVideoSourceReadTimestamps[1] - g_TimeNow, s_uLastVideoSourceReadTimestamps[2] - g_TimeNow, s_uLastVideoSourceReadTimestamps[3] - g_TimeNow, s_uLastVideoSourceReadTimestamps[4] - g_TimeNow );
+      if ( uCurrentRxqOverflow > rxq_overflow + 1 )
+      if ( g_TimeNow > s_uLastAlarmUDPOveflowTimestamp + 10000 )
+      if ( g_TimeNow > g_TimeStart + 10000 )
+      if ( g_TimeNow > hardware_camera_maj_get_last_change_time() + 3000 )
       {
-         log_error_and_alarm("[VideoSourceMaj] Failed to select socket.");
-         return -1;
+         s_uLastAlarmUDPOveflowTimestamp = g_TimeNow;
+         u32 uFlags2 = 0;
+         u32 uDelta = s_uLastVideoSourceReadTimestamps[0] - s_uLastVideoSourceReadTimestamps[1];
+         if ( uDelta > 255 )
+            uDelta = 255;
+         uFlags2 |= uDelta & 0xFF;
+         uDelta = s_uLastVideoSourceReadTimestamps[1] - s_uLastVideoSourceReadTimestamps[2];
+         if ( uDelta > 255 )
+            uDelta = 255;
+         uFlags2 |= (uDelta & 0xFF) << 8;
+         uDelta = s_uLastVideoSourceReadTimestamps[2] - s_uLastVideoSourceReadTimestamps[3];
+         if ( uDelta > 255 )
+            uDelta = 255;
+         uFlags2 |= (uDelta & 0xFF) << 16;
+         
+         send_alarm_to_controller(ALARM_ID_DEVELOPER_ALARM, ALARM_FLAG_DEVELOPER_ALARM_UDP_SKIPPED | ((uDroppedCount & 0xFF) << 8), uFlags2, 5);
       }
-      if ( iSelectResult == 0 )
-         return 0;
+   }
+   rxq_overflow = uCurrentRxqOverflow;
+}
 
-      if( 0 == FD_ISSET(s_fInputVideoStreamUDPSocket, &readset) )
-         return 0;
+// Returns the next captured packet (in *ppData, valid until the next call) and its size, 0 if none, -1 on error
+// bAsync: do not wait for data; otherwise wait up to 5 milisec for data
 
-      struct sockaddr_in client_addr;
-      socklen_t len = sizeof(client_addr);
-      
-      memset(&client_addr, 0, sizeof(client_addr));
-      client_addr.sin_family = AF_INET;
-      client_addr.sin_addr.s_addr = INADDR_ANY;
-      client_addr.sin_port = htons( s_iInputVideoStreamUDPPort );
-
-      nRecvBytes = recvfrom(s_fInputVideoStreamUDPSocket, s_uInputVideoUDPBuffer, sizeof(s_uInputVideoUDPBuffer)/sizeof(s_uInputVideoUDPBuffer[0]), 
-                MSG_WAITALL, ( struct sockaddr *) &client_addr,
-                &len);
-      //int nRecv = recv(socket_server, szBuff, 1024, )
-      if ( nRecvBytes < 0 )
+int _video_source_majestic_try_read_input_udp_data(bool bAsync, u8** ppData)
+{
+   if ( (-1 == s_fInputVideoStreamUDPSocket) || (! s_bMajesticCaptureThreadStarted) )
+      return -1;
+
+   // Give back the slot returned by the previous read
+   if ( s_bMajesticCaptureHasHeldSlot )
+   {
+      int iIndexRead = s_iMajesticCaptureIndexRead + 1;
+      if ( iIndexRead >= MAJESTIC_CAPTURE_RING_PACKETS )
+         iIndexRead = 0;
+      __atomic_store_n(&s_iMajesticCaptureIndexRead, iIndexRead, __ATOMIC_RELEASE);
+      s_bMajesticCaptureHasHeldSlot = false;
+   }
+
+   if ( __atomic_load_n(&s_iMajesticCaptureIndexWrite, __ATOMIC_ACQUIRE) == s_iMajesticCaptureIndexRead )
+   {
+      if ( bAsync )
+         return 0;
+      for( int i=0; i<25; i++ )
       {
-         log_error_and_alarm("[VideoSourceMaj] Failed to receive from UDP socket.");
-         return -1;
+         hardware_sleep_micros(200);
+         if ( __atomic_load_n(&s_iMajesticCaptureIndexWrite, __ATOMIC_ACQUIRE) != s_iMajesticCaptureIndexRead )
+            break;
       }
-      if ( nRecvBytes == 0 )
+      if ( __atomic_load_n(&s_iMajesticCaptureIndexWrite, __ATOMIC_ACQUIRE) == s_iMajesticCaptureIndexRead )
          return 0;
    }
-   return nRecvBytes;
+
+   type_majestic_capture_slot* pSlot = &s_pMajesticCaptureRing[s_iMajesticCaptureIndexRead];
+   s_bMajesticCaptureHasHeldSlot = true;
+
+   for(int i=4; i>0; i--)
+      s_uLastVideoSourceReadTimestamps[i] = s_uLastVideoSourceReadTimestamps[i-1];
+   s_uLastVideoSourceReadTimestamps[0] = pSlot->uTimeReceived;
+
+   _video_source_majestic_check_rxq_overflow(pSlot->uRxqOverflowCounter);
+
+   if ( pSlot->iLength >= MAX_PACKET_TOTAL_SIZE )
+      log_softerror_and_alarm("[VideoSourceMaj] Read too much data %d bytes from UDP socket", pSlot->iLength);
+
+   *ppData = pSlot->uData;
+   return pSlot->iLength;
 }
 
 // Parse input raw bytes and returns a NAL packet (in s_uOutputUDPNALFrameSegment)
@@ -680,7 +764,8 @@ u8* video_source_majestic_read(int* piReadSize, bool bAsync)
    if ( s_bIsRestartingMajestic )
       return NULL;
 
-   int iRecvBytes = _video_source_majestic_try_read_input_udp_data(bAsync);
+   u8* pRecvData = NULL;
+   int iRecvBytes = _video_source_majestic_try_read_input_udp_data(bAsync, &pRecvData);
    if ( iRecvBytes <= 0 )
       return NULL;
 
@@ -698,7 +783,7 @@ u8* video_source_majestic_read(int* piReadSize, bool bAsync)
    if ( s_uRequestedVideoMajesticCaptureUpdateReason != MODEL_CHANGED_CAMERA_PARAMS)
       return NULL;
 
-   int iOutputBytes = _video_source_majestic_parse_rtp_data(s_uInputVideoUDPBuffer, iRecvBytes);
+   int iOutputBytes = _video_source_majestic_parse_rtp_data(pRecvData, iRecvBytes);
 
    // To remove
    //_parse_stream(s_uOutputUDPNALFrameSegment, iOutputBytes);
@@ -721,7 +806,8 @@ u8* video_source_majestic_raw_read(int* piReadSize, bool bAsync)
    if ( s_bIsRestartingMajestic )
       return NULL;
 
-   int iRecvBytes = _video_source_majestic_try_read_input_udp_data(bAsync);
+   u8* pRecvData = NULL;
+   int iRecvBytes = _video_source_majestic_try_read_input_udp_data(bAsync, &pRecvData);
    if ( iRecvBytes <= 0 )
       return NULL;
 
@@ -740,7 +826,7 @@ u8* video_source_majestic_raw_read(int* piReadSize, bool bAsync)
       return NULL;
 
    *piReadSize = iRecvBytes;
-   return s_uInputVideoUDPBuffer;
+   return pRecvData;
 }
 
 int video_source_majestic_get_audio_data(u8* pOutputBuffer, int iMaxToRead)
@@ -758,7 +844,7 @@ int video_source_majestic_get_audio_data(u8* pOutputBuffer, int iMaxToRead)
    else
    {
       for( int i=iRead; i<s_iInputMajAudioBufferBytes; i++ )
-        s_uInputMajAudioBuffer[i-iRead] = s_uInputVideoUDPBuffer[i];
+        s_uInputMajAudioBuffer[i-iRead] = s_uInputMajAudioBuffer[i];
       s_iInputMajAudioBufferBytes -= iRead;
    }
    return iRead;
@@ -859,8 +945,8 @@ bool video_source_majestic_periodic_checks()
       char szBitrate[64];
       str_format_bitrate(s_uDebugUDPInputBytes/10*8, szBitrate);
 
-      log_line("[VideoSourceMaj] Input video data: %u bytes/sec, %s, %u reads/sec",
-         s_uDebugUDPInputBytes/10, szBitrate, s_uDebugUDPInputReads/10);
+      log_line("[VideoSourceMaj] Input video data: %u bytes/sec, %s, %u reads/sec, %u packets dropped on full capture ring",
+         s_uDebugUDPInputBytes/10, szBitrate, s_uDebugUDPInputReads/10, s_uMajesticCaptureRingDrops);
       s_uDebugTimeLastUDPVideoInputCheck = g_TimeNow;
       // To fix log_line("[VideoSourceMaj] Detected video stream fps: %d, slices: %d", (int)s_ParserH264CameraOutput.getDetectedFPS(), s_ParserH264CameraOutput.getDetectedSlices());
       s_uDebugUDPInputBytes = 0;
@@ -30,6 +30,7 @@
     SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stddef.h>
 #include "video_tx_buffers.h"
 #include "shared_vars.h"
 #include "timers.h"
@@ -100,6 +101,13 @@ VideoTxPacketsBuffer::VideoTxPacketsBuffer(int iVideoStreamIndex, int iCameraInd
    m_pLastPacketHeaderVideoImportantFilledIn = &m_PacketHeaderVideoImportant;
    m_ParserInputH264.init();
    m_uTempBufferNALPresenceFlags = 0;
+
+   m_bECEncoderActive = false;
+   m_iECEncoderBufferIndex = -1;
+   m_uECEncoderTimeMicros = 0;
+
+   m_iRetransmissionWindowMs = 0;
+   memset(m_uBlocksLastPacketTime, 0, sizeof(m_uBlocksLastPacketTime));
 }
 
 VideoTxPacketsBuffer::~VideoTxPacketsBuffer()
@@ -132,6 +140,8 @@ bool VideoTxPacketsBuffer::init(Model* pModel)
       return false;
    }
    log_line("[VideoTXBuffer] Initialize video Tx buffer instance number %d.", m_iInstanceIndex+1);
+   fec_init();
+   log_line("[VideoTXBuffer] Using %s FEC kernel.", fec_get_kernel_name());
 
    m_uNextVideoBlockIndexToGenerate = 0;
    m_uNextVideoBlockPacketIndexToGenerate = 0;
@@ -171,6 +181,8 @@ void VideoTxPacketsBuffer::discardBuffer()
    m_iCurrentBufferIndexToSend = 0;
    m_iCurrentBufferPacketIndexToSend = 0;
    m_iCountReadyToSend = 0;
+   m_bECEncoderActive = false;
+   m_RetrScheduler.reset();
    
    log_line("[VideoTXBuffer] Discarded entire buffer.");
 }
@@ -280,9 +292,16 @@ void VideoTxPacketsBuffer::_fillVideoPacketHeaders(int iBufferIndex, int iPacket
             break;
    
          m_pLastPacketHeaderVideoImportantFilledIn = m_VideoPackets[iBufferIndex][iPacketIndex].pPHVSImp;
+         u8 uOldFlags = m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags;
          m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags &= 0b11111100;
          m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags |= VIDEO_PACKET_FLAGS_IS_END_OF_TRANSMISSION_FRAME;
          m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags |= (i & 0x03);
+
+         // This packet is already part of the EC packets being computed, update them too
+         if ( m_bECEncoderActive && (iBufferIndex == m_iECEncoderBufferIndex) )
+            fec_encode_update_packet(&m_ECEncoderState, (unsigned int)iPacketIndex,
+               offsetof(t_packet_header_video_segment_important, uFrameAndNALFlags),
+               &uOldFlags, &m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags, sizeof(u8));
       }
    }
 }
@@ -300,7 +319,7 @@ void VideoTxPacketsBuffer::updateVideoHeader(Model* pModel)
        m_iUsableRawVideoDataSize, hardware_camera_maj_get_current_nal_size());
 
    // Update status flags
-   m_PacketHeaderVideo.uVideoStatusFlags2 = 0;
+   m_PacketHeaderVideo.uVideoStatusFlags2 = VIDEO_STATUS_FLAGS2_SUPPORTS_COMPACT_RETR_REQUESTS;
    if ( g_bDeveloperMode )
       m_PacketHeaderVideo.uVideoStatusFlags2 |= VIDEO_STATUS_FLAGS2_HAS_DEBUG_TIMESTAMPS;
 
@@ -350,6 +369,7 @@ void VideoTxPacketsBuffer::updateVideoHeader(Model* pModel)
    }
    
    m_PacketHeaderVideo.uCurrentVideoLinkProfile = iVideoProfile;
+   m_iRetransmissionWindowMs = ((pModel->video_link_profiles[iVideoProfile].uProfileEncodingFlags & VIDEO_PROFILE_ENCODING_FLAG_MAX_RETRANSMISSION_WINDOW_MASK) >> 8) * 5;
    m_PacketHeaderVideo.uStreamInfoFlags = 0;
    m_PacketHeaderVideo.uStreamInfo = 0;
    updateCurrentKFValue();
@@ -479,6 +499,32 @@ bool VideoTxPacketsBuffer::fillVideoPacketsFromRTSPPacket(u8* pVideoRawData, int
    return bEndOfFrameDetected;
 }
 
+void VideoTxPacketsBuffer::_startECEncoding(int iBufferIndex)
+{
+   m_bECEncoderActive = false;
+   m_iECEncoderBufferIndex = -1;
+   m_uECEncoderTimeMicros = 0;
+
+   if ( 0 == m_PacketHeaderVideo.uCurrentBlockECPackets )
+      return;
+
+   u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
+   int iECDelta = m_PacketHeaderVideo.uCurrentBlockDataPackets;
+   for( int i=0; i<m_PacketHeaderVideo.uCurrentBlockECPackets; i++ )
+   {
+      _checkAllocatePacket(iBufferIndex, i+iECDelta);
+      p_fec_data_fecs[i] = m_VideoPackets[iBufferIndex][i+iECDelta].pVideoData;
+      if ( NULL == p_fec_data_fecs[i] )
+         return;
+   }
+
+   u32 tTemp = get_current_timestamp_micros();
+   fec_encode_begin(&m_ECEncoderState, m_PacketHeaderVideo.uCurrentBlockPacketSize, m_PacketHeaderVideo.uCurrentBlockDataPackets, p_fec_data_fecs, m_PacketHeaderVideo.uCurrentBlockECPackets);
+   m_uECEncoderTimeMicros += get_current_timestamp_micros() - tTemp;
+   m_iECEncoderBufferIndex = iBufferIndex;
+   m_bECEncoderActive = true;
+}
+
 void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDataSize, u32 uNALPresenceFlags, bool bEndOfTransmissionFrame)
 {
    if ( (! m_bInitialized) || (NULL == pRawVideoData) || (iRawVideoDataSize <= 0) || (iRawVideoDataSize > MAX_PACKET_PAYLOAD) )
@@ -510,6 +556,10 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
       log_line("[VideoTXBuffer] Current usable raw bytes: %d, majestic NAL size now: %d", m_PacketHeaderVideo.uCurrentBlockPacketSize, m_iUsableRawVideoDataSize, hardware_camera_maj_get_current_nal_size());
    }
 
+   if ( 0 == m_iNextBufferPacketIndexToFill )
+      _startECEncoding(m_iNextBufferIndexToFill);
+   m_uBlocksLastPacketTime[m_iNextBufferIndexToFill] = g_TimeNow;
+
    _fillVideoPacketHeaders(m_iNextBufferIndexToFill, m_iNextBufferPacketIndexToFill, false, iRawVideoDataSize, uNALPresenceFlags, bEndOfTransmissionFrame);
    
    // Copy video data
@@ -526,6 +576,14 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    if ( iSizeToZero > 0 )
       memset(pVideoDestination, 0, iSizeToZero);
 
+   // Fold the new data packet into the EC packets right away
+   if ( m_bECEncoderActive )
+   {
+      u32 tTemp = get_current_timestamp_micros();
+      fec_encode_add_packet(&m_ECEncoderState, (unsigned int)m_iNextBufferPacketIndexToFill, m_VideoPackets[m_iNextBufferIndexToFill][m_iNextBufferPacketIndexToFill].pVideoData);
+      m_uECEncoderTimeMicros += get_current_timestamp_micros() - tTemp;
+   }
+
    // Update state
    m_iNextBufferPacketIndexToFill++;
    m_iCountReadyToSend++;
@@ -534,26 +592,33 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    if ( m_uNextVideoBlockPacketIndexToGenerate >= pCurrentVideoPacketHeader->uCurrentBlockDataPackets )
    if ( pCurrentVideoPacketHeader->uCurrentBlockECPackets > 0 )
    {
-      // Compute EC packets
-      u8* p_fec_data_packets[MAX_DATA_PACKETS_IN_BLOCK];
-      u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
-
-      for( int i=0; i<m_PacketHeaderVideo.uCurrentBlockDataPackets; i++ )
-      {
-         _checkAllocatePacket(m_iNextBufferIndexToFill, i);
-         p_fec_data_packets[i] = m_VideoPackets[m_iNextBufferIndexToFill][i].pVideoData;
-      }
+      // EC packets were computed incrementally as data packets were added, just complete them
       int iECDelta = m_PacketHeaderVideo.uCurrentBlockDataPackets;
-      for( int i=0; i<m_PacketHeaderVideo.uCurrentBlockECPackets; i++ )
+      if ( (! m_bECEncoderActive) || (m_iECEncoderBufferIndex != m_iNextBufferIndexToFill) || (! fec_encode_finish(&m_ECEncoderState)) )
       {
-         _checkAllocatePacket(m_iNextBufferIndexToFill, i+iECDelta);
-         p_fec_data_fecs[i] = m_VideoPackets[m_iNextBufferIndexToFill][i+iECDelta].pVideoData;
+         log_softerror_and_alarm("[VideoTXBuffer] Incomplete EC encoding for video block %u, recompute it.", m_uNextVideoBlockIndexToGenerate);
+         u8* p_fec_data_packets[MAX_DATA_PACKETS_IN_BLOCK];
+         u8* p_fec_data_fecs[MAX_FECS_PACKETS_IN_BLOCK];
+
+         for( int i=0; i<m_PacketHeaderVideo.uCurrentBlockDataPackets; i++ )
+         {
+            _checkAllocatePacket(m_iNextBufferIndexToFill, i);
+            p_fec_data_packets[i] = m_VideoPackets[m_iNextBufferIndexToFill][i].pVideoData;
+         }
+         for( int i=0; i<m_PacketHeaderVideo.uCurrentBlockECPackets; i++ )
+         {
+            _checkAllocatePacket(m_iNextBufferIndexToFill, i+iECDelta);
+            p_fec_data_fecs[i] = m_VideoPackets[m_iNextBufferIndexToFill][i+iECDelta].pVideoData;
+         }
+
+         u32 tTemp = get_current_timestamp_micros();
+         fec_encode(m_PacketHeaderVideo.uCurrentBlockPacketSize, p_fec_data_packets, m_PacketHeaderVideo.uCurrentBlockDataPackets, p_fec_data_fecs, m_PacketHeaderVideo.uCurrentBlockECPackets);
+         m_uECEncoderTimeMicros += get_current_timestamp_micros() - tTemp;
       }
+      m_bECEncoderActive = false;
 
-      u32 tTemp = get_current_timestamp_micros();
-      fec_encode(m_PacketHeaderVideo.uCurrentBlockPacketSize, p_fec_data_packets, m_PacketHeaderVideo.uCurrentBlockDataPackets, p_fec_data_fecs, m_PacketHeaderVideo.uCurrentBlockECPackets);
-      tTemp = get_current_timestamp_micros() - tTemp;
-      s_uTimeTotalFecTimeMicroSec += tTemp;
+      s_uTimeTotalFecTimeMicroSec += m_uECEncoderTimeMicros;
+      m_uECEncoderTimeMicros = 0;
       if ( 0 == s_uLastTimeFecCalculation )
       {
          s_uTimeFecMicroPerSec = 0;
@@ -598,7 +663,8 @@ void VideoTxPacketsBuffer::_addNewVideoPacket(u8* pRawVideoData, int iRawVideoDa
    }
 }
 
-void VideoTxPacketsBuffer::_sendPacket(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId)
+// Updates the packet headers for sending it now. Returns false if video must not be sent now.
+bool VideoTxPacketsBuffer::_preparePacketForSend(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId)
 {
    t_packet_header* pCurrentPacketHeader = m_VideoPackets[iBufferIndex][iPacketIndex].pPH;
    t_packet_header_video_segment* pCurrentVideoPacketHeader = m_VideoPackets[iBufferIndex][iPacketIndex].pPHVS;
@@ -634,34 +700,94 @@ void VideoTxPacketsBuffer::_sendPacket(int iBufferIndex, int iPacketIndex, u32 u
    }
 
    if ( g_bVideoPaused || (! relay_current_vehicle_must_send_own_video_feeds()) )
-      return;
+      return false;
 
    //t_packet_header_video_full_98_debug_info* pPHVFDebugInfo = (t_packet_header_video_full_98_debug_info*) m_VideoPackets[iBufferIndex][iPacketIndex].pVideoData;
    //u8* pVideoData = m_VideoPackets[iBufferIndex][iPacketIndex].pVideoData;
    //pVideoData += sizeof(t_packet_header_video_full_98_debug_info);
    //u32 crc = base_compute_crc32(pVideoData, pCurrentVideoPacketHeader->uCurrentBlockPacketSize);
+   return true;
+}
 
+void VideoTxPacketsBuffer::_sendPacket(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId)
+{
+   if ( ! _preparePacketForSend(iBufferIndex, iPacketIndex, uRetransmissionId) )
+      return;
+   t_packet_header* pCurrentPacketHeader = m_VideoPackets[iBufferIndex][iPacketIndex].pPH;
    send_packet_to_radio_interfaces((u8*)pCurrentPacketHeader, pCurrentPacketHeader->total_length, -1);
+   _onBlockPacketSent(iBufferIndex, iPacketIndex);
+}
+
+// Returns the time after which a retransmission of this block is useless (0 for no deadline)
+
+u32 VideoTxPacketsBuffer::_getRetransmissionDeadline(int iBufferIndex)
+{
+   if ( m_iRetransmissionWindowMs <= 10 )
+      return 0;
+   return m_uBlocksLastPacketTime[iBufferIndex] + (u32)m_iRetransmissionWindowMs - DEFAULT_VIDEO_RETRANS_DEADLINE_MARGIN_MS;
+}
+
+// Each packet the controller receives for a block keeps that block alive there for another retransmission window
+
+void VideoTxPacketsBuffer::_onBlockPacketSent(int iBufferIndex, int iPacketIndex)
+{
+   if ( m_uBlocksLastPacketTime[iBufferIndex] == g_TimeNow )
+      return;
+   m_uBlocksLastPacketTime[iBufferIndex] = g_TimeNow;
+   if ( m_RetrScheduler.getQueuedCount() > 0 )
+      m_RetrScheduler.extendBlockDeadline(m_VideoPackets[iBufferIndex][iPacketIndex].pPHVS->uCurrentBlockIndex, _getRetransmissionDeadline(iBufferIndex));
 }
 
 int VideoTxPacketsBuffer::hasPendingPacketsToSend()
 {
-   return m_iCountReadyToSend;
+   return m_iCountReadyToSend + m_RetrScheduler.getQueuedCount();
+}
+
+// Returns the number of retransmitted packets sent
+
+int VideoTxPacketsBuffer::_sendQueuedRetransmissions(int iMaxCountToSend)
+{
+   int iCountSent = 0;
+   type_tx_video_retr_request request;
+   while ( (iCountSent < iMaxCountToSend) && m_RetrScheduler.popNext(g_TimeNow, &request) )
+   {
+      // The buffer slot could have been reused since the request was queued
+      if ( (NULL == m_VideoPackets[request.iBufferIndex][request.iVideoBlockPacketIndex].pPH) ||
+           (m_VideoPackets[request.iBufferIndex][request.iVideoBlockPacketIndex].pPHVS->uCurrentBlockIndex != request.uVideoBlockIndex) )
+         continue;
+      for( int i=0; i<request.iSendCount; i++ )
+         _sendPacket(request.iBufferIndex, request.iVideoBlockPacketIndex, request.uRetransmissionId);
+      iCountSent++;
+   }
+   return iCountSent;
 }
 
 int VideoTxPacketsBuffer::sendAvailablePackets(int iMaxCountToSend)
 {
-   if ( m_iCountReadyToSend <= 0 )
+   int iToSend = m_iCountReadyToSend + m_RetrScheduler.getQueuedCount();
+   if ( iToSend <= 0 )
       return 0;
 
-   int iToSend = m_iCountReadyToSend;
    if ( iToSend > MAX_PACKETS_TO_SEND_IN_ONE_SLICE )
       iToSend = MAX_PACKETS_TO_SEND_IN_ONE_SLICE;
    if ( iMaxCountToSend > 0 )
    if ( iToSend > iMaxCountToSend )
       iToSend = iMaxCountToSend;
 
+   // Retransmissions go first, within their share of the slice
    int iCountSent = 0;
+   if ( m_RetrScheduler.getQueuedCount() > 0 )
+   {
+      iCountSent = _sendQueuedRetransmissions(m_RetrScheduler.getSliceBudget(iToSend, m_iCountReadyToSend));
+      iToSend -= iCountSent;
+   }
+   if ( m_iCountReadyToSend <= 0 )
+      return iCountSent;
+
+   // Packets in the slice are sent to radio interfaces as a single batch
+   u8* pPacketsToSend[MAX_PACKETS_TO_SEND_IN_ONE_SLICE];
+   int iCountPacketsToSend = 0;
+
    for( int i=0; i<iToSend; i++ )
    {
       if ( NULL == m_VideoPackets[m_iCurrentBufferIndexToSend][m_iCurrentBufferPacketIndexToSend].pPH )
@@ -670,7 +796,11 @@ int VideoTxPacketsBuffer::sendAvailablePackets(int iMaxCountToSend)
          m_uNextVideoBlockIndexToGenerate, m_uNextVideoBlockPacketIndexToGenerate, m_iCountReadyToSend, m_VideoPackets[m_iCurrentBufferIndexToSend][m_iCurrentBufferPacketIndexToSend].pPH);
          continue;
       }
-      _sendPacket(m_iCurrentBufferIndexToSend, m_iCurrentBufferPacketIndexToSend, 0);
+      if ( _preparePacketForSend(m_iCurrentBufferIndexToSend, m_iCurrentBufferPacketIndexToSend, 0) )
+      {
+         pPacketsToSend[iCountPacketsToSend++] = (u8*)m_VideoPackets[m_iCurrentBufferIndexToSend][m_iCurrentBufferPacketIndexToSend].pPH;
+         _onBlockPacketSent(m_iCurrentBufferIndexToSend, m_iCurrentBufferPacketIndexToSend);
+      }
       iCountSent++;
       t_packet_header_video_segment* pCurrentVideoPacketHeader = m_VideoPackets[m_iCurrentBufferIndexToSend][m_iCurrentBufferPacketIndexToSend].pPHVS;
       m_iCurrentBufferPacketIndexToSend++;
@@ -688,17 +818,24 @@ int VideoTxPacketsBuffer::sendAvailablePackets(int iMaxCountToSend)
       if ( m_iCurrentBufferPacketIndexToSend == m_iNextBufferPacketIndexToFill )
          break;
    }
+
+   if ( iCountPacketsToSend > 0 )
+      send_video_packets_to_radio_interfaces(pPacketsToSend, iCountPacketsToSend);
    return iCountSent;
 }
 
 
-void VideoTxPacketsBuffer::resendVideoPacket(u32 uRetransmissionId, u32 uVideoBlockIndex, u32 uVideoBlockPacketIndex)
+// Returns the buffer index of the video packet to retransmit, or -1 if it's not in the buffer anymore
+
+int VideoTxPacketsBuffer::_getBufferIndexForRetransmission(u32 uVideoBlockIndex, u32 uVideoBlockPacketIndex)
 {
+   if ( uVideoBlockPacketIndex >= MAX_TOTAL_PACKETS_IN_BLOCK )
+      return -1;
    if ( uVideoBlockIndex > m_uNextVideoBlockIndexToGenerate )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv req for retr for block index %u which is greater than max present in buffer: %u",
          uVideoBlockIndex, m_uNextVideoBlockIndexToGenerate-1);
-      return;
+      return -1;
    }
    if ( uVideoBlockIndex == m_uNextVideoBlockIndexToGenerate )
    if ( uVideoBlockPacketIndex >= m_uNextVideoBlockPacketIndexToGenerate )
@@ -707,13 +844,13 @@ void VideoTxPacketsBuffer::resendVideoPacket(u32 uRetransmissionId, u32 uVideoBl
          uVideoBlockIndex, uVideoBlockPacketIndex, m_uNextVideoBlockIndexToGenerate, m_uNextVideoBlockPacketIndexToGenerate-1,
          (int)m_pLastPacketHeaderVideoFilldedIn->uCurrentBlockPacketIndex,
          (m_pLastPacketHeaderVideoImportantFilledIn->uFrameAndNALFlags & VIDEO_PACKET_FLAGS_IS_END_OF_TRANSMISSION_FRAME)?"yes":"no");
-      return;
+      return -1;
    }
    int iDeltaBlocksBack = (int)m_uNextVideoBlockIndexToGenerate - (int)uVideoBlockIndex;
    if ( (iDeltaBlocksBack < 0) || (iDeltaBlocksBack >= MAX_RXTX_BLOCKS_BUFFER) )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv req for retr for block index out of range: %d blocks back (of max %d blocks)", iDeltaBlocksBack, MAX_RXTX_BLOCKS_BUFFER);
-      return;
+      return -1;
    }
    int iBufferIndex = m_iNextBufferIndexToFill - iDeltaBlocksBack;
    if ( iBufferIndex < 0 )
@@ -723,27 +860,54 @@ void VideoTxPacketsBuffer::resendVideoPacket(u32 uRetransmissionId, u32 uVideoBl
    if ( iBufferIndex < 0 )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv request for retr for block index still out of range: %d ", iBufferIndex);
-      return;
+      return -1;
    }
    if ( NULL == m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPH )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv request for retr of empty video block index [%u/%u]", uVideoBlockIndex, uVideoBlockPacketIndex);
-      return;
+      return -1;
    }
    if ( m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPHVS->uCurrentBlockIndex != uVideoBlockIndex )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv request for retr of invalid video block [%u], buffer has video block [%u] at that position (%d)", uVideoBlockIndex, m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPHVS->uCurrentBlockIndex, iBufferIndex);
-      return;
+      return -1;
    }
    if ( m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPHVS->uCurrentBlockPacketIndex != uVideoBlockPacketIndex )
    {
       log_softerror_and_alarm("[VideoTXBuffer] Recv request for retr of invalid video block [%u/%u], buffer has video block [%u/%u] at that position (%d)", uVideoBlockIndex, uVideoBlockPacketIndex, m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPHVS->uCurrentBlockIndex, m_VideoPackets[iBufferIndex][uVideoBlockPacketIndex].pPHVS->uCurrentBlockPacketIndex, iBufferIndex);
-      return;
+      return -1;
    }
 
+   return iBufferIndex;
+}
+
+void VideoTxPacketsBuffer::resendVideoPackets(u32 uRetransmissionId, u32* pVideoBlocks, u8* pVideoBlockPackets, int iCount)
+{
+   if ( (NULL == pVideoBlocks) || (NULL == pVideoBlockPackets) || (iCount <= 0) )
+      return;
+   if ( ! m_RetrScheduler.startRequest(uRetransmissionId, g_TimeNow) )
+   {
+      log_line("[VideoTXBuffer] Ignored duplicate retr request id %u", uRetransmissionId);
+      return;
+   }
    if ( 0 == uRetransmissionId )
       uRetransmissionId = MAX_U32-1;
-   _sendPacket(iBufferIndex, (int)uVideoBlockPacketIndex, uRetransmissionId);
+
+   // Small requests are sent twice
+   int iSendCount = (iCount < 4)?2:1;
+   int iCountDropped = 0;
+   for( int i=0; i<iCount; i++ )
+   {
+      int iBufferIndex = _getBufferIndexForRetransmission(pVideoBlocks[i], pVideoBlockPackets[i]);
+      if ( iBufferIndex < 0 )
+         continue;
+
+      if ( ! m_RetrScheduler.addPacket(uRetransmissionId, pVideoBlocks[i], (int)pVideoBlockPackets[i], iBufferIndex, iSendCount, _getRetransmissionDeadline(iBufferIndex), g_TimeNow) )
+         iCountDropped++;
+   }
+   if ( iCountDropped > 0 )
+      log_line("[VideoTXBuffer] Dropped %d of %d packets of retr request id %u, past their retransmission deadline (%d ms window)",
+         iCountDropped, iCount, uRetransmissionId, m_iRetransmissionWindowMs);
 }
 
 
@@ -5,6 +5,8 @@
 #include "../base/models.h"
 #include "../base/parser_h264.h"
 #include "../radio/radiopackets2.h"
+#include "../radio/fec.h"
+#include "video_tx_retr_scheduler.h"
 
 //  [packet header][video segment header][video seg header important][video data][000]
 //  | pPH          | pPHVS               | pPHVSImp                  |pActualVideoData
@@ -38,7 +40,8 @@ class VideoTxPacketsBuffer
       bool fillVideoPacketsFromRTSPPacket(u8* pVideoRawData, int iRawDataSize, bool bSingle, bool bEnd, u32 uNALType);
       int hasPendingPacketsToSend();
       int sendAvailablePackets(int iMaxCountToSend);
-      void resendVideoPacket(u32 uRetransmissionId, u32 uVideoBlockIndex, u32 uVideoBlockPacketIndex);
+      // Queues the packets of a retransmission request, they are sent by sendAvailablePackets
+      void resendVideoPackets(u32 uRetransmissionId, u32* pVideoBlocks, u8* pVideoBlockPackets, int iCount);
 
       u32 getCurrentOutputFrameIndex();
       u32 getCurrentOutputNALIndex();
@@ -51,7 +54,13 @@ class VideoTxPacketsBuffer
       void _checkAllocatePacket(int iBufferIndex, int iPacketIndex);
       void _fillVideoPacketHeaders(int iBufferIndex, int iPacketIndex, bool bIsECPacket, int iRawVideoDataSize, u32 uNALPresenceFlags, bool bEndOfTransmissionFrame);
       void _addNewVideoPacket(u8* pRawVideoData, int iRawVideoDataSize, u32 uNALPresenceFlags, bool bEndOfTransmissionFrame);
+      void _startECEncoding(int iBufferIndex);
+      bool _preparePacketForSend(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId);
+      int _getBufferIndexForRetransmission(u32 uVideoBlockIndex, u32 uVideoBlockPacketIndex);
+      int _sendQueuedRetransmissions(int iMaxCountToSend);
       void _sendPacket(int iBufferIndex, int iPacketIndex, u32 uRetransmissionId);
+      u32 _getRetransmissionDeadline(int iBufferIndex);
+      void _onBlockPacketSent(int iBufferIndex, int iPacketIndex);
       static int m_siVideoBuffersInstancesCount;
       bool m_bInitialized;
       bool m_bOverflowFlag;
@@ -87,6 +96,19 @@ class VideoTxPacketsBuffer
       type_tx_video_packet_info m_VideoPackets[MAX_RXTX_BLOCKS_BUFFER][MAX_TOTAL_PACKETS_IN_BLOCK];
       int m_iCountReadyToSend;
 
+      // EC packets of the block currently being filled are computed incrementally, as data packets are added
+      fec_encoder_state_t m_ECEncoderState;
+      bool m_bECEncoderActive;
+      int m_iECEncoderBufferIndex;
+      u32 m_uECEncoderTimeMicros;
+
       u32 m_uRadioStreamPacketIndex;
+
+      // Retransmissions are queued and sent by deadline, interleaved with new video packets
+      VideoTxRetrScheduler m_RetrScheduler;
+      // Time the latest packet of each block was generated or sent. The controller drops a block
+      // the retransmission window after it last received a packet of it.
+      u32 m_uBlocksLastPacketTime[MAX_RXTX_BLOCKS_BUFFER];
+      int m_iRetransmissionWindowMs;
 };
 
@@ -0,0 +1,208 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "video_tx_retr_scheduler.h"
+#include "../base/config.h"
+
+VideoTxRetrScheduler::VideoTxRetrScheduler()
+{
+   m_iAirtimeBudgetPercent = DEFAULT_VIDEO_RETRANS_AIRTIME_PERCENT;
+   reset();
+}
+
+VideoTxRetrScheduler::~VideoTxRetrScheduler()
+{
+}
+
+void VideoTxRetrScheduler::reset()
+{
+   m_iQueuedCount = 0;
+   m_iRecentRetransmissionIdsCount = 0;
+   m_iRecentRetransmissionIdsNext = 0;
+   m_uCountDroppedExpired = 0;
+   m_uCountMerged = 0;
+   m_uCountIgnoredRequests = 0;
+}
+
+void VideoTxRetrScheduler::setAirtimeBudgetPercent(int iPercent)
+{
+   if ( iPercent < 1 )
+      iPercent = 1;
+   if ( iPercent > 100 )
+      iPercent = 100;
+   m_iAirtimeBudgetPercent = iPercent;
+}
+
+bool VideoTxRetrScheduler::startRequest(u32 uRetransmissionId, u32 uTimeNow)
+{
+   for( int i=0; i<m_iRecentRetransmissionIdsCount; i++ )
+   {
+      if ( m_uRecentRetransmissionIds[i] == uRetransmissionId )
+      if ( uTimeNow < m_uRecentRetransmissionIdsTime[i] + TX_VIDEO_RETR_DUPLICATE_ID_TIMEOUT_MS )
+      {
+         m_uCountIgnoredRequests++;
+         return false;
+      }
+   }
+   m_uRecentRetransmissionIds[m_iRecentRetransmissionIdsNext] = uRetransmissionId;
+   m_uRecentRetransmissionIdsTime[m_iRecentRetransmissionIdsNext] = uTimeNow;
+   m_iRecentRetransmissionIdsNext = (m_iRecentRetransmissionIdsNext + 1) % MAX_TX_VIDEO_RETR_RECENT_IDS;
+   if ( m_iRecentRetransmissionIdsCount < MAX_TX_VIDEO_RETR_RECENT_IDS )
+      m_iRecentRetransmissionIdsCount++;
+   return true;
+}
+
+bool VideoTxRetrScheduler::addPacket(u32 uRetransmissionId, u32 uVideoBlockIndex, int iVideoBlockPacketIndex, int iBufferIndex, int iSendCount, u32 uDeadlineTime, u32 uTimeNow)
+{
+   if ( (0 != uDeadlineTime) && (uTimeNow >= uDeadlineTime) )
+   {
+      m_uCountDroppedExpired++;
+      return false;
+   }
+
+   // Already queued from a previous request? Answer with the latest retransmission id
+   for( int i=0; i<m_iQueuedCount; i++ )
+   {
+      if ( (m_Queue[i].uVideoBlockIndex != uVideoBlockIndex) || (m_Queue[i].iVideoBlockPacketIndex != iVideoBlockPacketIndex) )
+         continue;
+      m_Queue[i].uRetransmissionId = uRetransmissionId;
+      if ( iSendCount > m_Queue[i].iSendCount )
+         m_Queue[i].iSendCount = iSendCount;
+      if ( (0 != m_Queue[i].uDeadlineTime) && ((0 == uDeadlineTime) || (uDeadlineTime > m_Queue[i].uDeadlineTime)) )
+         m_Queue[i].uDeadlineTime = uDeadlineTime;
+      m_uCountMerged++;
+      return true;
+   }
+
+   if ( m_iQueuedCount >= MAX_TX_VIDEO_RETR_QUEUE )
+      return false;
+
+   type_tx_video_retr_request* pRequest = &m_Queue[m_iQueuedCount];
+   pRequest->uRetransmissionId = uRetransmissionId;
+   pRequest->uVideoBlockIndex = uVideoBlockIndex;
+   pRequest->iVideoBlockPacketIndex = iVideoBlockPacketIndex;
+   pRequest->iBufferIndex = iBufferIndex;
+   pRequest->iSendCount = (iSendCount < 1)?1:iSendCount;
+   pRequest->uDeadlineTime = uDeadlineTime;
+   pRequest->uAddedTime = uTimeNow;
+   m_iQueuedCount++;
+   return true;
+}
+
+void VideoTxRetrScheduler::extendBlockDeadline(u32 uVideoBlockIndex, u32 uDeadlineTime)
+{
+   for( int i=0; i<m_iQueuedCount; i++ )
+   {
+      if ( m_Queue[i].uVideoBlockIndex != uVideoBlockIndex )
+         continue;
+      if ( (0 != m_Queue[i].uDeadlineTime) && (uDeadlineTime > m_Queue[i].uDeadlineTime) )
+         m_Queue[i].uDeadlineTime = uDeadlineTime;
+   }
+}
+
+void VideoTxRetrScheduler::_removeAt(int iIndex)
+{
+   m_iQueuedCount--;
+   if ( iIndex != m_iQueuedCount )
+      memcpy(&m_Queue[iIndex], &m_Queue[m_iQueuedCount], sizeof(type_tx_video_retr_request));
+}
+
+bool VideoTxRetrScheduler::popNext(u32 uTimeNow, type_tx_video_retr_request* pRequest)
+{
+   while ( m_iQueuedCount > 0 )
+   {
+      // Earliest deadline first; packets without deadline go last; older blocks and lower packet indexes first
+      int iBest = 0;
+      for( int i=1; i<m_iQueuedCount; i++ )
+      {
+         type_tx_video_retr_request* pR = &m_Queue[i];
+         type_tx_video_retr_request* pB = &m_Queue[iBest];
+         u32 uDeadlineR = (0 == pR->uDeadlineTime)?MAX_U32:pR->uDeadlineTime;
+         u32 uDeadlineB = (0 == pB->uDeadlineTime)?MAX_U32:pB->uDeadlineTime;
+         if ( uDeadlineR > uDeadlineB )
+            continue;
+         if ( uDeadlineR == uDeadlineB )
+         {
+            if ( pR->uVideoBlockIndex > pB->uVideoBlockIndex )
+               continue;
+            if ( (pR->uVideoBlockIndex == pB->uVideoBlockIndex) && (pR->iVideoBlockPacketIndex > pB->iVideoBlockPacketIndex) )
+               continue;
+         }
+         iBest = i;
+      }
+
+      if ( (0 != m_Queue[iBest].uDeadlineTime) && (uTimeNow >= m_Queue[iBest].uDeadlineTime) )
+      {
+         m_uCountDroppedExpired++;
+         _removeAt(iBest);
+         continue;
+      }
+      if ( NULL != pRequest )
+         memcpy(pRequest, &m_Queue[iBest], sizeof(type_tx_video_retr_request));
+      _removeAt(iBest);
+      return true;
+   }
+   return false;
+}
+
+int VideoTxRetrScheduler::getQueuedCount()
+{
+   return m_iQueuedCount;
+}
+
+int VideoTxRetrScheduler::getSliceBudget(int iSlicePackets, int iFreshPacketsPending)
+{
+   if ( (0 == m_iQueuedCount) || (iSlicePackets <= 0) )
+      return 0;
+   if ( iFreshPacketsPending <= 0 )
+      return iSlicePackets;
+   int iBudget = (iSlicePackets * m_iAirtimeBudgetPercent) / 100;
+   if ( iBudget < 1 )
+      iBudget = 1;
+   return iBudget;
+}
+
+u32 VideoTxRetrScheduler::getCountDroppedExpired()
+{
+   return m_uCountDroppedExpired;
+}
+
+u32 VideoTxRetrScheduler::getCountMerged()
+{
+   return m_uCountMerged;
+}
+
+u32 VideoTxRetrScheduler::getCountIgnoredRequests()
+{
+   return m_uCountIgnoredRequests;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../base/base.h"
+
+// Queue of video packets to retransmit, served earliest deadline first.
+// The deadline of a packet is the time after which the controller drops its video block (end of the retransmission window).
+// The controller keeps a block for the window after it last received a packet of it, so deadlines of queued
+// packets move later when other packets of the same block are sent meanwhile.
+// Requests that expire while queued are dropped, requests for a packet already queued are merged,
+// and repeated retransmission requests (same retransmission id) are ignored.
+
+#define MAX_TX_VIDEO_RETR_QUEUE 256
+#define MAX_TX_VIDEO_RETR_RECENT_IDS 16
+#define TX_VIDEO_RETR_DUPLICATE_ID_TIMEOUT_MS 500
+
+typedef struct
+{
+   u32 uRetransmissionId;
+   u32 uVideoBlockIndex;
+   int iVideoBlockPacketIndex;
+   int iBufferIndex;
+   int iSendCount;
+   u32 uDeadlineTime; // 0 for no deadline
+   u32 uAddedTime;
+}
+type_tx_video_retr_request;
+
+class VideoTxRetrScheduler
+{
+   public:
+      VideoTxRetrScheduler();
+      virtual ~VideoTxRetrScheduler();
+
+      void reset();
+      void setAirtimeBudgetPercent(int iPercent);
+
+      // Returns false if the retransmission id was received recently already, the whole request must be ignored
+      bool startRequest(u32 uRetransmissionId, u32 uTimeNow);
+      // Returns false if the packet was dropped (already expired or queue full)
+      bool addPacket(u32 uRetransmissionId, u32 uVideoBlockIndex, int iVideoBlockPacketIndex, int iBufferIndex, int iSendCount, u32 uDeadlineTime, u32 uTimeNow);
+      // Moves the deadline of the queued packets of this video block later, up to uDeadlineTime
+      void extendBlockDeadline(u32 uVideoBlockIndex, u32 uDeadlineTime);
+      // Removes and returns the most urgent packet that has not expired. Returns false if none left.
+      bool popNext(u32 uTimeNow, type_tx_video_retr_request* pRequest);
+
+      int getQueuedCount();
+      // Max number of retransmissions to send in a slice of iSlicePackets, when iFreshPacketsPending new video packets are waiting too
+      int getSliceBudget(int iSlicePackets, int iFreshPacketsPending);
+
+      u32 getCountDroppedExpired();
+      u32 getCountMerged();
+      u32 getCountIgnoredRequests();
+
+   protected:
+      void _removeAt(int iIndex);
+
+      type_tx_video_retr_request m_Queue[MAX_TX_VIDEO_RETR_QUEUE];
+      int m_iQueuedCount;
+      int m_iAirtimeBudgetPercent;
+
+      u32 m_uRecentRetransmissionIds[MAX_TX_VIDEO_RETR_RECENT_IDS];
+      u32 m_uRecentRetransmissionIdsTime[MAX_TX_VIDEO_RETR_RECENT_IDS];
+      int m_iRecentRetransmissionIdsCount;
+      int m_iRecentRetransmissionIdsNext;
+
+      u32 m_uCountDroppedExpired;
+      u32 m_uCountMerged;
+      u32 m_uCountIgnoredRequests;
+};
@@ -81,6 +81,7 @@
 #include <string.h>
 
 #include <assert.h>
+#include <pthread.h>
 #include "fec.h"
 
 /*
@@ -434,11 +435,6 @@ addmul1(gf *dst1, gf *src1, gf c, int sz)
 # define addmul1 slow_addmul1
 #endif
 
-static void addmul(gf *dst, gf *src, gf c, int sz) {
-    // fprintf(stderr, "Dst=%p Src=%p, gf=%02x sz=%d\n", dst, src, c, sz);
-    if (c != 0) addmul1(dst, src, c, sz);
-}
-
 /*
  * mul() computes dst[] = c * src[]
  * This is used often, so better optimize it! Currently the loop is
@@ -560,9 +556,373 @@ mul1(gf *dst1, gf *src1, gf c, int sz)
 # define mul1 slow_mul1
 #endif
 
+/*
+ * SIMD versions of addmul1()/mul1(), using the split nibble method:
+ * c*x = c*(x & 0x0f) ^ c*(x & 0xf0), so two 16 entries tables per
+ * constant c are enough to multiply 16 (or 32) bytes at once with a
+ * byte shuffle (PSHUFB on x86, VTBL/TBL on ARM NEON).
+ * The tables are built once, in fec_init(), from gf_mul_table, so the
+ * results are bit exact with the scalar functions above.
+ * The kernel is selected at run time in fec_init(); the scalar version
+ * is always available as a fallback and as the reference.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FEC_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/* The NEON kernels are in fec_neon.c, the only file built with the NEON flags on 32 bits ARM */
+#if defined(__arm__) || defined(__aarch64__)
+#define FEC_HAS_NEON 1
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#endif
+
+static gf gf_mul_nibble_lo[GF_SIZE+1][16] __attribute__((aligned (16)));
+static gf gf_mul_nibble_hi[GF_SIZE+1][16] __attribute__((aligned (16)));
+
+static void
+init_mul_nibble_tables(void)
+{
+    int c, i;
+    for (c=0; c < GF_SIZE+1; c++)
+	for (i=0; i < 16; i++) {
+	    gf_mul_nibble_lo[c][i] = gf_mul(c, i);
+	    gf_mul_nibble_hi[c][i] = gf_mul(c, (i<<4));
+	}
+}
+
+#ifdef FEC_HAS_X86_SIMD
+
+__attribute__((target("ssse3")))
+static void
+ssse3_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m128i vLo = _mm_load_si128((const __m128i*)gf_mul_nibble_lo[c]);
+    const __m128i vHi = _mm_load_si128((const __m128i*)gf_mul_nibble_hi[c]);
+    const __m128i vMask = _mm_set1_epi8(0x0f);
+    int i = 0;
+
+    for (; i + 16 <= sz; i += 16) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vDst = _mm_loadu_si128((const __m128i*)(dst+i));
+	__m128i vL = _mm_shuffle_epi8(vLo, _mm_and_si128(vSrc, vMask));
+	__m128i vH = _mm_shuffle_epi8(vHi, _mm_and_si128(_mm_srli_epi64(vSrc, 4), vMask));
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(vDst, _mm_xor_si128(vL, vH)));
+    }
+    if (i < sz)
+	slow_addmul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("ssse3")))
+static void
+ssse3_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m128i vLo = _mm_load_si128((const __m128i*)gf_mul_nibble_lo[c]);
+    const __m128i vHi = _mm_load_si128((const __m128i*)gf_mul_nibble_hi[c]);
+    const __m128i vMask = _mm_set1_epi8(0x0f);
+    int i = 0;
+
+    for (; i + 16 <= sz; i += 16) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vL = _mm_shuffle_epi8(vLo, _mm_and_si128(vSrc, vMask));
+	__m128i vH = _mm_shuffle_epi8(vHi, _mm_and_si128(_mm_srli_epi64(vSrc, 4), vMask));
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(vL, vH));
+    }
+    if (i < sz)
+	slow_mul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("avx2")))
+static void
+avx2_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m256i vLo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_lo[c]));
+    const __m256i vHi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_hi[c]));
+    const __m256i vMask = _mm256_set1_epi8(0x0f);
+    int i = 0;
+
+    for (; i + 32 <= sz; i += 32) {
+	__m256i vSrc = _mm256_loadu_si256((const __m256i*)(src+i));
+	__m256i vDst = _mm256_loadu_si256((const __m256i*)(dst+i));
+	__m256i vL = _mm256_shuffle_epi8(vLo, _mm256_and_si256(vSrc, vMask));
+	__m256i vH = _mm256_shuffle_epi8(vHi, _mm256_and_si256(_mm256_srli_epi64(vSrc, 4), vMask));
+	_mm256_storeu_si256((__m256i*)(dst+i), _mm256_xor_si256(vDst, _mm256_xor_si256(vL, vH)));
+    }
+    /* Do the 16 bytes tail here, using VEX encoded instructions: calling
+     * the SSSE3 version would mix AVX and legacy SSE code (slow) */
+    if (i + 16 <= sz) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vDst = _mm_loadu_si128((const __m128i*)(dst+i));
+	__m128i vL = _mm_shuffle_epi8(_mm256_castsi256_si128(vLo), _mm_and_si128(vSrc, _mm256_castsi256_si128(vMask)));
+	__m128i vH = _mm_shuffle_epi8(_mm256_castsi256_si128(vHi), _mm_and_si128(_mm_srli_epi64(vSrc, 4), _mm256_castsi256_si128(vMask)));
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(vDst, _mm_xor_si128(vL, vH)));
+	i += 16;
+    }
+    if (i < sz)
+	slow_addmul1(dst+i, src+i, c, sz-i);
+}
+
+__attribute__((target("avx2")))
+static void
+avx2_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    const __m256i vLo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_lo[c]));
+    const __m256i vHi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_hi[c]));
+    const __m256i vMask = _mm256_set1_epi8(0x0f);
+    int i = 0;
+
+    for (; i + 32 <= sz; i += 32) {
+	__m256i vSrc = _mm256_loadu_si256((const __m256i*)(src+i));
+	__m256i vL = _mm256_shuffle_epi8(vLo, _mm256_and_si256(vSrc, vMask));
+	__m256i vH = _mm256_shuffle_epi8(vHi, _mm256_and_si256(_mm256_srli_epi64(vSrc, 4), vMask));
+	_mm256_storeu_si256((__m256i*)(dst+i), _mm256_xor_si256(vL, vH));
+    }
+    if (i + 16 <= sz) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vL = _mm_shuffle_epi8(_mm256_castsi256_si128(vLo), _mm_and_si128(vSrc, _mm256_castsi256_si128(vMask)));
+	__m128i vH = _mm_shuffle_epi8(_mm256_castsi256_si128(vHi), _mm_and_si128(_mm_srli_epi64(vSrc, 4), _mm256_castsi256_si128(vMask)));
+	_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(vL, vH));
+	i += 16;
+    }
+    if (i < sz)
+	slow_mul1(dst+i, src+i, c, sz-i);
+}
+
+#endif /* FEC_HAS_X86_SIMD */
+
+#ifdef FEC_HAS_NEON
+
+static void
+neon_addmul1(gf *dst, gf *src, gf c, int sz)
+{
+    int i = fec_neon_addmul1(dst, src, gf_mul_nibble_lo[c], gf_mul_nibble_hi[c], sz);
+    if (i < sz)
+	slow_addmul1(dst+i, src+i, c, sz-i);
+}
+
+static void
+neon_mul1(gf *dst, gf *src, gf c, int sz)
+{
+    int i = fec_neon_mul1(dst, src, gf_mul_nibble_lo[c], gf_mul_nibble_hi[c], sz);
+    if (i < sz)
+	slow_mul1(dst+i, src+i, c, sz-i);
+}
+
+#endif /* FEC_HAS_NEON */
+
+/*
+ * Fused versions of addmul1(): dst[r][] = dst[r][] + c[r] * src[] for
+ * FEC_FUSED_ROWS destination rows at once. Each chunk of src is loaded
+ * (and split in nibbles) only once and then accumulated into all the
+ * rows, instead of re-reading src once for each row.
+ */
+#define FEC_FUSED_ROWS 4
+
+static void
+slow_addmul4(gf **dst, gf *src, const gf *c, int sz)
+{
+    gf *t0 = &gf_mul_table[c[0]<<8], *t1 = &gf_mul_table[c[1]<<8];
+    gf *t2 = &gf_mul_table[c[2]<<8], *t3 = &gf_mul_table[c[3]<<8];
+    gf *d0 = dst[0], *d1 = dst[1], *d2 = dst[2], *d3 = dst[3];
+    int i;
+
+    for (i = 0; i < sz; i++) {
+	gf x = src[i];
+	d0[i] ^= t0[x];
+	d1[i] ^= t1[x];
+	d2[i] ^= t2[x];
+	d3[i] ^= t3[x];
+    }
+}
+
+static void
+slow_addmul4_tail(gf **dst, gf *src, const gf *c, int offset, int sz)
+{
+    gf *pDst[FEC_FUSED_ROWS];
+    int r;
+
+    if (offset >= sz)
+	return;
+    for (r = 0; r < FEC_FUSED_ROWS; r++)
+	pDst[r] = dst[r] + offset;
+    slow_addmul4(pDst, src + offset, c, sz - offset);
+}
+
+#ifdef FEC_HAS_X86_SIMD
+
+__attribute__((target("ssse3")))
+static void
+ssse3_addmul4(gf **dst, gf *src, const gf *c, int sz)
+{
+    const __m128i vMask = _mm_set1_epi8(0x0f);
+    __m128i vLo[FEC_FUSED_ROWS], vHi[FEC_FUSED_ROWS];
+    int i = 0, r;
+
+    for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	vLo[r] = _mm_load_si128((const __m128i*)gf_mul_nibble_lo[c[r]]);
+	vHi[r] = _mm_load_si128((const __m128i*)gf_mul_nibble_hi[c[r]]);
+    }
+    for (; i + 16 <= sz; i += 16) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vIdxL = _mm_and_si128(vSrc, vMask);
+	__m128i vIdxH = _mm_and_si128(_mm_srli_epi64(vSrc, 4), vMask);
+	for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	    __m128i vDst = _mm_loadu_si128((const __m128i*)(dst[r]+i));
+	    __m128i vP = _mm_xor_si128(_mm_shuffle_epi8(vLo[r], vIdxL), _mm_shuffle_epi8(vHi[r], vIdxH));
+	    _mm_storeu_si128((__m128i*)(dst[r]+i), _mm_xor_si128(vDst, vP));
+	}
+    }
+    slow_addmul4_tail(dst, src, c, i, sz);
+}
+
+__attribute__((target("avx2")))
+static void
+avx2_addmul4(gf **dst, gf *src, const gf *c, int sz)
+{
+    const __m256i vMask = _mm256_set1_epi8(0x0f);
+    __m256i vLo[FEC_FUSED_ROWS], vHi[FEC_FUSED_ROWS];
+    int i = 0, r;
+
+    for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	vLo[r] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_lo[c[r]]));
+	vHi[r] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)gf_mul_nibble_hi[c[r]]));
+    }
+    for (; i + 32 <= sz; i += 32) {
+	__m256i vSrc = _mm256_loadu_si256((const __m256i*)(src+i));
+	__m256i vIdxL = _mm256_and_si256(vSrc, vMask);
+	__m256i vIdxH = _mm256_and_si256(_mm256_srli_epi64(vSrc, 4), vMask);
+	for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	    __m256i vDst = _mm256_loadu_si256((const __m256i*)(dst[r]+i));
+	    __m256i vP = _mm256_xor_si256(_mm256_shuffle_epi8(vLo[r], vIdxL), _mm256_shuffle_epi8(vHi[r], vIdxH));
+	    _mm256_storeu_si256((__m256i*)(dst[r]+i), _mm256_xor_si256(vDst, vP));
+	}
+    }
+    if (i + 16 <= sz) {
+	__m128i vSrc = _mm_loadu_si128((const __m128i*)(src+i));
+	__m128i vIdxL = _mm_and_si128(vSrc, _mm256_castsi256_si128(vMask));
+	__m128i vIdxH = _mm_and_si128(_mm_srli_epi64(vSrc, 4), _mm256_castsi256_si128(vMask));
+	for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	    __m128i vDst = _mm_loadu_si128((const __m128i*)(dst[r]+i));
+	    __m128i vP = _mm_xor_si128(_mm_shuffle_epi8(_mm256_castsi256_si128(vLo[r]), vIdxL), _mm_shuffle_epi8(_mm256_castsi256_si128(vHi[r]), vIdxH));
+	    _mm_storeu_si128((__m128i*)(dst[r]+i), _mm_xor_si128(vDst, vP));
+	}
+	i += 16;
+    }
+    slow_addmul4_tail(dst, src, c, i, sz);
+}
+
+#endif /* FEC_HAS_X86_SIMD */
+
+#ifdef FEC_HAS_NEON
+
+static void
+neon_addmul4(gf **dst, gf *src, const gf *c, int sz)
+{
+    const gf *pLo[FEC_FUSED_ROWS], *pHi[FEC_FUSED_ROWS];
+    int i, r;
+
+    for (r = 0; r < FEC_FUSED_ROWS; r++) {
+	pLo[r] = gf_mul_nibble_lo[c[r]];
+	pHi[r] = gf_mul_nibble_hi[c[r]];
+    }
+    i = fec_neon_addmul4(dst, src, pLo, pHi, sz);
+    slow_addmul4_tail(dst, src, c, i, sz);
+}
+
+#endif /* FEC_HAS_NEON */
+
+typedef void (*gf_mul_func_t)(gf *dst, gf *src, gf c, int sz);
+typedef void (*gf_addmul4_func_t)(gf **dst, gf *src, const gf *c, int sz);
+
+static gf_mul_func_t s_pFuncAddMul1 = addmul1;
+static gf_mul_func_t s_pFuncMul1 = mul1;
+static gf_addmul4_func_t s_pFuncAddMul4 = slow_addmul4;
+static int s_iFECKernel = FEC_KERNEL_SCALAR;
+
+static int
+fec_kernel_is_supported(int iKernel)
+{
+    if (iKernel == FEC_KERNEL_SCALAR)
+	return 1;
+#ifdef FEC_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (iKernel == FEC_KERNEL_SSSE3)
+	return __builtin_cpu_supports("ssse3") ? 1 : 0;
+    if (iKernel == FEC_KERNEL_AVX2)
+	return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("ssse3")) ? 1 : 0;
+#endif
+#ifdef FEC_HAS_NEON
+    if (iKernel == FEC_KERNEL_NEON) {
+	if (! fec_neon_is_built())
+	    return 0;
+#if defined(__aarch64__)
+	return 1;
+#else
+	return (getauxval(AT_HWCAP) & HWCAP_NEON) ? 1 : 0;
+#endif
+    }
+#endif
+    return 0;
+}
+
+static void
+fec_select_kernel(int iKernel)
+{
+    s_pFuncAddMul1 = addmul1;
+    s_pFuncMul1 = mul1;
+    s_pFuncAddMul4 = slow_addmul4;
+    s_iFECKernel = FEC_KERNEL_SCALAR;
+
+#ifdef FEC_HAS_X86_SIMD
+    if (iKernel == FEC_KERNEL_SSSE3) {
+	s_pFuncAddMul1 = ssse3_addmul1;
+	s_pFuncMul1 = ssse3_mul1;
+	s_pFuncAddMul4 = ssse3_addmul4;
+	s_iFECKernel = iKernel;
+    }
+    if (iKernel == FEC_KERNEL_AVX2) {
+	s_pFuncAddMul1 = avx2_addmul1;
+	s_pFuncMul1 = avx2_mul1;
+	s_pFuncAddMul4 = avx2_addmul4;
+	s_iFECKernel = iKernel;
+    }
+#endif
+#ifdef FEC_HAS_NEON
+    if (iKernel == FEC_KERNEL_NEON) {
+	s_pFuncAddMul1 = neon_addmul1;
+	s_pFuncMul1 = neon_mul1;
+	s_pFuncAddMul4 = neon_addmul4;
+	s_iFECKernel = iKernel;
+    }
+#endif
+}
+
+static void addmul(gf *dst, gf *src, gf c, int sz) {
+    // fprintf(stderr, "Dst=%p Src=%p, gf=%02x sz=%d\n", dst, src, c, sz);
+    if (c != 0) (*s_pFuncAddMul1)(dst, src, c, sz);
+}
+
 static inline void mul(gf *dst, gf *src, gf c, int sz) {
     /*fprintf(stderr, "%p = %02x * %p\n", dst, c, src);*/
-    if (c != 0) mul1(dst, src, c, sz); else memset(dst, 0, sz);
+    if (c != 0) (*s_pFuncMul1)(dst, src, c, sz); else memset(dst, 0, sz);
+}
+
+/*
+ * addmul_rows() computes dst[r][] = dst[r][] + c[r] * src[] for all
+ * nrows rows, FEC_FUSED_ROWS rows at a time.
+ */
+static void addmul_rows(gf **dst, gf *src, const gf *c, int nrows, int sz) {
+    int r = 0;
+    for (; r + FEC_FUSED_ROWS <= nrows; r += FEC_FUSED_ROWS)
+	(*s_pFuncAddMul4)(&dst[r], src, &c[r], sz);
+    for (; r < nrows; r++)
+	addmul(dst[r], src, c[r], sz);
 }
 
 /*
@@ -697,15 +1057,57 @@ static int fec_initialized = 0;
 
 void fec_init(void)
 {
+    /* Already done: keep the tables and any kernel set with fec_set_kernel() */
+    if (fec_initialized)
+	return;
     TICK(ticks[0]);
     generate_gf();
     TOCK(ticks[0]);
     DDB(fprintf(stderr, "generate_gf took %ldus\n", ticks[0]);)
 	TICK(ticks[0]);
     init_mul_table();
+    init_mul_nibble_tables();
     TOCK(ticks[0]);
     DDB(fprintf(stderr, "init_mul_table took %ldus\n", ticks[0]);)
-   	fec_initialized = 1 ;
+
+    /* Pick the fastest GF multiply kernel this CPU supports */
+    if (fec_kernel_is_supported(FEC_KERNEL_AVX2))
+	fec_select_kernel(FEC_KERNEL_AVX2);
+    else if (fec_kernel_is_supported(FEC_KERNEL_SSSE3))
+	fec_select_kernel(FEC_KERNEL_SSSE3);
+    else if (fec_kernel_is_supported(FEC_KERNEL_NEON))
+	fec_select_kernel(FEC_KERNEL_NEON);
+    else
+	fec_select_kernel(FEC_KERNEL_SCALAR);
+
+    fec_initialized = 1 ;
+}
+
+int fec_get_kernel(void)
+{
+    if ( 0 == fec_initialized )
+       fec_init();
+    return s_iFECKernel;
+}
+
+const char* fec_get_kernel_name(void)
+{
+    switch (fec_get_kernel()) {
+	case FEC_KERNEL_SSSE3: return "SSSE3";
+	case FEC_KERNEL_AVX2: return "AVX2";
+	case FEC_KERNEL_NEON: return "NEON";
+	default: return "Scalar";
+    }
+}
+
+int fec_set_kernel(int iKernel)
+{
+    if ( 0 == fec_initialized )
+       fec_init();
+    if (! fec_kernel_is_supported(iKernel))
+	return 0;
+    fec_select_kernel(iKernel);
+    return 1;
 }
 
 
@@ -810,8 +1212,32 @@ void fec_encode(unsigned int blockSize,
 		unsigned char **fec_blocks,
 		unsigned int nrFecBlocks)
 {
+    fec_encoder_state_t state;
     unsigned int blockNo; /* loop for block counter */
-    unsigned int row, col;
+
+    if(!nrDataBlocks)
+	return;
+
+    fec_encode_begin(&state, blockSize, nrDataBlocks, fec_blocks, nrFecBlocks);
+    for(blockNo=0; blockNo < nrDataBlocks; blockNo++)
+	fec_encode_add_packet(&state, blockNo, data_blocks[blockNo]);
+    fec_encode_finish(&state);
+}
+
+/**
+ * Incremental encoding: the FEC blocks are accumulators (they start as
+ * zero) and each data block is folded into all of them as soon as it is
+ * available, in any order. Because addition in GF is a xor, a data block
+ * that changes after it was added can be corrected by folding in just
+ * the difference between its old and new content.
+ */
+void fec_encode_begin(fec_encoder_state_t *pState,
+		unsigned int blockSize,
+		unsigned int nrDataBlocks,
+		unsigned char **fec_blocks,
+		unsigned int nrFecBlocks)
+{
+    unsigned int row;
 
     if ( 0 == fec_initialized )
        fec_init();
@@ -819,20 +1245,57 @@ void fec_encode(unsigned int blockSize,
     assert(nrDataBlocks <= 128);    
     assert(nrFecBlocks <= 128);
 
-    if(!nrDataBlocks)
-	return;
+    pState->blockSize = blockSize;
+    pState->nrDataBlocks = nrDataBlocks;
+    pState->nrFecBlocks = nrFecBlocks;
+    pState->nrAddedBlocks = 0;
+    for(row=0; row < nrFecBlocks; row++) {
+	pState->fec_blocks[row] = fec_blocks[row];
+	memset(fec_blocks[row], 0, blockSize);
+    }
+}
 
-    for(row=0; row < nrFecBlocks; row++)
-	mul(fec_blocks[row], data_blocks[0], inverse[128 ^ row], blockSize);
-    
-    for(col=129, blockNo=1; blockNo < nrDataBlocks; col++, blockNo ++) {
-	for(row=0; row < nrFecBlocks; row++)
-	    addmul(fec_blocks[row], data_blocks[blockNo],
-		   inverse[row ^ col],
-		   blockSize);
+void fec_encode_add_packet(fec_encoder_state_t *pState,
+		unsigned int blockNo,
+		unsigned char *data_block)
+{
+    unsigned int row, col;
+    gf coefs[128];
+
+    assert(blockNo < pState->nrDataBlocks);
+    col = 128 + blockNo;
+    for(row=0; row < pState->nrFecBlocks; row++)
+	coefs[row] = inverse[row ^ col];
+    addmul_rows(pState->fec_blocks, data_block, coefs, pState->nrFecBlocks, pState->blockSize);
+    pState->nrAddedBlocks++;
+}
+
+void fec_encode_update_packet(fec_encoder_state_t *pState,
+		unsigned int blockNo,
+		unsigned int offset,
+		const unsigned char *old_data,
+		const unsigned char *new_data,
+		unsigned int length)
+{
+    unsigned int row, col, i;
+
+    assert(blockNo < pState->nrDataBlocks);
+    assert(offset + length <= pState->blockSize);
+    col = 128 + blockNo;
+    for(i=0; i < length; i++) {
+	gf delta = old_data[i] ^ new_data[i];
+	if (0 == delta)
+	    continue;
+	for(row=0; row < pState->nrFecBlocks; row++)
+	    pState->fec_blocks[row][offset+i] ^= gf_mul(inverse[row ^ col], delta);
     }
 }
 
+int fec_encode_finish(fec_encoder_state_t *pState)
+{
+    return (pState->nrAddedBlocks == pState->nrDataBlocks) ? 1 : 0;
+}
+
 /**
  * Reduce the system by substracting all received data blocks from FEC blocks
  * This will allow to resolve the system by inverting a much smaller matrix
@@ -849,19 +1312,21 @@ static inline void reduce(unsigned int blockSize,
 {
     int erasedIdx=0;
     unsigned int col;
+    gf coefs[nr_fec_blocks];
 
     /* First we reduce the code vector by substracting all known elements
-     * (non-erased data packets) */
+     * (non-erased data packets). Each known data block is read once and
+     * substracted from all the FEC blocks at the same time. */
     for(col=0; col<nr_data_blocks; col++) {
 	if(erasedIdx < nr_fec_blocks && erased_blocks[erasedIdx] == col) {
 	    erasedIdx++;
 	} else {
-	    unsigned char *src = data_blocks[col];
 	    int j;
 	    for(j=0; j < nr_fec_blocks; j++) {
 		int blno = fec_block_nos[j];
-		addmul(fec_blocks[j],src,inverse[blno^col^128],blockSize);
+		coefs[j] = inverse[blno^col^128];
 	    }
+	    addmul_rows(fec_blocks, data_blocks[col], coefs, nr_fec_blocks, blockSize);
 	}
     }
 
@@ -869,24 +1334,146 @@ static inline void reduce(unsigned int blockSize,
 }
 
 #ifdef PROFILE
+/* Profiling counters are in nanoseconds (monotonic clock), so that they
+ * are comparable across x86 and ARM builds */
+#include <time.h>
 static long long rdtsc(void)
 {
-    unsigned long low, hi;
-    asm volatile ("rdtsc" : "=d" (hi), "=a" (low));
-    return ( (((long long)hi) << 32) | ((long long) low));
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((long long)t.tv_sec) * 1000000000LL + (long long)t.tv_nsec;
 }
 
 long long reduceTime = 0;
 long long resolveTime =0;
 long long invTime =0;
+long long invCacheHits =0;
+long long invCacheMisses =0;
 #endif
 
+/*
+ * Cache of inverted decode matrices. Under steady interference the same
+ * erasure pattern (same erased data blocks, same received FEC blocks)
+ * repeats for many blocks, so keep the last few inverted matrices and
+ * skip the O(k^3) inversion when the pattern was already seen.
+ * Least recently used entry is replaced on a miss.
+ */
+#define FEC_INV_CACHE_ENTRIES 16
+#define FEC_INV_CACHE_MAX_K 32
+
+typedef struct {
+    int used;
+    unsigned int uLastUseTime;
+    unsigned int nr_data_blocks;
+    short nr_fec_blocks;
+    unsigned char erased[FEC_INV_CACHE_MAX_K];
+    unsigned char fec_nos[FEC_INV_CACHE_MAX_K];
+    gf matrix[FEC_INV_CACHE_MAX_K*FEC_INV_CACHE_MAX_K];
+} fec_inv_cache_entry_t;
+
+static fec_inv_cache_entry_t s_FECInvCache[FEC_INV_CACHE_ENTRIES];
+static unsigned int s_uFECInvCacheUseTime = 0;
+static unsigned int s_uFECInvCacheHits = 0;
+static unsigned int s_uFECInvCacheMisses = 0;
+static pthread_mutex_t s_FECInvCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+inv_cache_matches(fec_inv_cache_entry_t *pEntry, unsigned int nr_data_blocks,
+		  unsigned int *fec_block_nos, unsigned int *erased_blocks, short nr_fec_blocks)
+{
+    int i;
+    if (!pEntry->used || pEntry->nr_fec_blocks != nr_fec_blocks || pEntry->nr_data_blocks != nr_data_blocks)
+	return 0;
+    for (i = 0; i < nr_fec_blocks; i++)
+	if (pEntry->erased[i] != erased_blocks[i] || pEntry->fec_nos[i] != fec_block_nos[i])
+	    return 0;
+    return 1;
+}
+
+/* Returns 1 and copies the inverted matrix if the pattern is in the cache */
+static int
+inv_cache_lookup(gf *matrix, unsigned int nr_data_blocks,
+		 unsigned int *fec_block_nos, unsigned int *erased_blocks, short nr_fec_blocks)
+{
+    int i, found = 0;
+
+    if (nr_fec_blocks > FEC_INV_CACHE_MAX_K)
+	return 0;
+
+    pthread_mutex_lock(&s_FECInvCacheMutex);
+    for (i = 0; i < FEC_INV_CACHE_ENTRIES; i++) {
+	if (inv_cache_matches(&s_FECInvCache[i], nr_data_blocks, fec_block_nos, erased_blocks, nr_fec_blocks)) {
+	    memcpy(matrix, s_FECInvCache[i].matrix, nr_fec_blocks*nr_fec_blocks);
+	    s_FECInvCache[i].uLastUseTime = ++s_uFECInvCacheUseTime;
+	    found = 1;
+	    break;
+	}
+    }
+    if (found)
+	s_uFECInvCacheHits++;
+    else
+	s_uFECInvCacheMisses++;
+    pthread_mutex_unlock(&s_FECInvCacheMutex);
+    return found;
+}
+
+static void
+inv_cache_store(gf *matrix, unsigned int nr_data_blocks,
+		unsigned int *fec_block_nos, unsigned int *erased_blocks, short nr_fec_blocks)
+{
+    int i, iOldest = 0;
+
+    if (nr_fec_blocks > FEC_INV_CACHE_MAX_K)
+	return;
+
+    pthread_mutex_lock(&s_FECInvCacheMutex);
+    for (i = 0; i < FEC_INV_CACHE_ENTRIES; i++) {
+	if (!s_FECInvCache[i].used) {
+	    iOldest = i;
+	    break;
+	}
+	if (s_FECInvCache[i].uLastUseTime < s_FECInvCache[iOldest].uLastUseTime)
+	    iOldest = i;
+    }
+    s_FECInvCache[iOldest].used = 1;
+    s_FECInvCache[iOldest].uLastUseTime = ++s_uFECInvCacheUseTime;
+    s_FECInvCache[iOldest].nr_data_blocks = nr_data_blocks;
+    s_FECInvCache[iOldest].nr_fec_blocks = nr_fec_blocks;
+    for (i = 0; i < nr_fec_blocks; i++) {
+	s_FECInvCache[iOldest].erased[i] = (unsigned char)erased_blocks[i];
+	s_FECInvCache[iOldest].fec_nos[i] = (unsigned char)fec_block_nos[i];
+    }
+    memcpy(s_FECInvCache[iOldest].matrix, matrix, nr_fec_blocks*nr_fec_blocks);
+    pthread_mutex_unlock(&s_FECInvCacheMutex);
+}
+
+void fec_get_decode_cache_stats(unsigned int *puHits, unsigned int *puMisses)
+{
+    pthread_mutex_lock(&s_FECInvCacheMutex);
+    if (NULL != puHits)
+	*puHits = s_uFECInvCacheHits;
+    if (NULL != puMisses)
+	*puMisses = s_uFECInvCacheMisses;
+    pthread_mutex_unlock(&s_FECInvCacheMutex);
+}
+
+void fec_reset_decode_cache(void)
+{
+    pthread_mutex_lock(&s_FECInvCacheMutex);
+    memset(s_FECInvCache, 0, sizeof(s_FECInvCache));
+    s_uFECInvCacheUseTime = 0;
+    s_uFECInvCacheHits = 0;
+    s_uFECInvCacheMisses = 0;
+    pthread_mutex_unlock(&s_FECInvCacheMutex);
+}
+
 /**
  * Resolves reduced system. Constructs "mini" encoding matrix, inverts
  * it, and multiply reduced vector by it.
  */
 static inline void resolve(int blockSize,
 			   unsigned char **data_blocks,
+			   unsigned int nr_data_blocks,
 			   unsigned char **fec_blocks,
 			   unsigned int *fec_block_nos,
 			   unsigned int *erased_blocks,
@@ -895,12 +1482,25 @@ static inline void resolve(int blockSize,
 #ifdef PROFILE
     long long begin;
 #endif
+    if (nr_fec_blocks <= 0)
+	return;
+
     /* construct matrix */
     int row;
     unsigned char matrix[nr_fec_blocks*nr_fec_blocks];
     int ptr;
     int r;
 
+    if (inv_cache_lookup(matrix, nr_data_blocks, fec_block_nos, erased_blocks, nr_fec_blocks)) {
+#ifdef PROFILE
+	invCacheHits++;
+#endif
+	goto multiply;
+    }
+#ifdef PROFILE
+    invCacheMisses++;
+#endif
+
     /* we pick the submatrix of code that keeps colums corresponding to
      * the erased data blocks, and rows corresponding to the present FEC
      * blocks. This is the matrix by which we would need to multiply the
@@ -936,14 +1536,24 @@ static inline void resolve(int blockSize,
 	fprintf(stderr, "\n");
 	assert(0);
     }
+    inv_cache_store(matrix, nr_data_blocks, fec_block_nos, erased_blocks, nr_fec_blocks);
 
-    /* do the multiplication with the reduced code vector */
-    for(row = 0, ptr=0; row < nr_fec_blocks; row++) {
+ multiply:
+    /* do the multiplication with the reduced code vector, column by
+     * column, so that each reduced FEC block is read only once and
+     * accumulated into all the missing data blocks */
+    {
 	int col;
-	unsigned char *target = data_blocks[erased_blocks[row]];
-	mul(target,fec_blocks[0],matrix[ptr++],blockSize);
-	for(col = 1; col < nr_fec_blocks;  col++,ptr++) {
-	    addmul(target,fec_blocks[col],matrix[ptr],blockSize);
+	gf *targets[nr_fec_blocks];
+	gf coefs[nr_fec_blocks];
+	for(row = 0; row < nr_fec_blocks; row++) {
+	    targets[row] = data_blocks[erased_blocks[row]];
+	    memset(targets[row], 0, blockSize);
+	}
+	for(col = 0; col < nr_fec_blocks; col++) {
+	    for(row = 0; row < nr_fec_blocks; row++)
+		coefs[row] = matrix[row*nr_fec_blocks + col];
+	    addmul_rows(targets, fec_blocks[col], coefs, nr_fec_blocks, blockSize);
 	}
     }
 }
@@ -974,7 +1584,7 @@ void fec_decode(unsigned int blockSize,
     reduceTime += end - begin;
     begin = end;
 #endif
-    resolve(blockSize, data_blocks,
+    resolve(blockSize, data_blocks, nr_data_blocks,
 	    fec_blocks, fec_block_nos, erased_blocks,
 	    nr_fec_blocks);
 #ifdef PROFILE
@@ -986,8 +1596,8 @@ void fec_decode(unsigned int blockSize,
 
 #ifdef PROFILE
 void printDetail(void) {
-    fprintf(stderr, "red=%9lld\nres=%9lld\ninv=%9lld\n",  
-	    reduceTime, resolveTime, invTime);
+    fprintf(stderr, "red=%9lld\nres=%9lld\ninv=%9lld\ninv cache hits=%lld misses=%lld\n",  
+	    reduceTime, resolveTime, invTime, invCacheHits, invCacheMisses);
 }
 #endif
 
@@ -12,12 +12,64 @@ typedef struct fec_parms *fec_code_t;
  */
 void fec_init(void);
 
+// GF(2^8) multiply kernels used by fec_encode/fec_decode.
+// The fastest one supported by the CPU is selected by fec_init()
+#define FEC_KERNEL_SCALAR 0
+#define FEC_KERNEL_SSSE3 1
+#define FEC_KERNEL_AVX2 2
+#define FEC_KERNEL_NEON 3
+
+int fec_get_kernel(void);
+const char* fec_get_kernel_name(void);
+// Returns 1 if the kernel is supported on this CPU and was selected, 0 otherwise
+int fec_set_kernel(int iKernel);
+
+// Implemented in fec_neon.c. Process the whole 16 bytes chunks and return the number of bytes done.
+// fec_neon_is_built() returns 0 if that file was not built with NEON support.
+int fec_neon_is_built(void);
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize);
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize);
+int fec_neon_addmul4(unsigned char** pDst, const unsigned char* pSrc, const unsigned char** pNibblesLo, const unsigned char** pNibblesHi, int iSize);
+
 void fec_encode(unsigned int blockSize,
 		unsigned char **data_blocks,
 		unsigned int nrDataBlocks,
 		unsigned char **fec_blocks,
 		unsigned int nrFecBlocks);
 
+// Incremental encoder: fec_encode_begin() clears the FEC blocks, then each
+// data block is folded into them with fec_encode_add_packet() as soon as it
+// is ready. The result is the same as calling fec_encode() on the full block.
+typedef struct
+{
+   unsigned int blockSize;
+   unsigned int nrDataBlocks;
+   unsigned int nrFecBlocks;
+   unsigned int nrAddedBlocks;
+   unsigned char* fec_blocks[128];
+} fec_encoder_state_t;
+
+void fec_encode_begin(fec_encoder_state_t *pState,
+		unsigned int blockSize,
+		unsigned int nrDataBlocks,
+		unsigned char **fec_blocks,
+		unsigned int nrFecBlocks);
+
+void fec_encode_add_packet(fec_encoder_state_t *pState,
+		unsigned int blockNo,
+		unsigned char *data_block);
+
+// Fixes the FEC blocks when bytes [offset, offset+length) of an already added data block change
+void fec_encode_update_packet(fec_encoder_state_t *pState,
+		unsigned int blockNo,
+		unsigned int offset,
+		const unsigned char *old_data,
+		const unsigned char *new_data,
+		unsigned int length);
+
+// Returns 1 if all the data blocks were added and the FEC blocks are complete
+int fec_encode_finish(fec_encoder_state_t *pState);
+
 void fec_decode(unsigned int blockSize,
 		unsigned char **data_blocks,
 		unsigned int nr_data_blocks,
@@ -26,6 +78,20 @@ void fec_decode(unsigned int blockSize,
 		unsigned int *erased_blocks,
 		unsigned short nr_fec_blocks  /* how many blocks per stripe */);
 
+// Decoding keeps a small cache of inverted matrices for recently seen erasure patterns
+void fec_get_decode_cache_stats(unsigned int *puHits, unsigned int *puMisses);
+void fec_reset_decode_cache(void);
+
+#ifdef PROFILE
+// Accumulated decode times (nanoseconds) and decode matrix cache usage, only when built with PROFILE
+extern long long reduceTime;
+extern long long resolveTime;
+extern long long invTime;
+extern long long invCacheHits;
+extern long long invCacheMisses;
+void printDetail(void);
+#endif
+
 void fec_print(fec_code_t code, int width);
 
 void fec_license(void);
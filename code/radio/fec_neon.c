@@ -0,0 +1,142 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "fec.h"
+
+// Built as a separate object so that only this file needs the NEON compiler flags on 32 bits ARM builds.
+// The kernels are used by fec.c only if the CPU supports NEON (see fec_kernel_is_supported()).
+// Each kernel processes only whole 16 bytes chunks and returns the number of bytes done; fec.c does the rest.
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static inline uint8x16_t _fec_neon_gf_lookup(uint8x16_t vTable, uint8x16_t vIndex)
+{
+#if defined(__aarch64__)
+   return vqtbl1q_u8(vTable, vIndex);
+#else
+   uint8x8x2_t t;
+   t.val[0] = vget_low_u8(vTable);
+   t.val[1] = vget_high_u8(vTable);
+   return vcombine_u8(vtbl2_u8(t, vget_low_u8(vIndex)), vtbl2_u8(t, vget_high_u8(vIndex)));
+#endif
+}
+
+int fec_neon_is_built(void)
+{
+   return 1;
+}
+
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize)
+{
+   const uint8x16_t vLo = vld1q_u8(pNibblesLo);
+   const uint8x16_t vHi = vld1q_u8(pNibblesHi);
+   const uint8x16_t vMask = vdupq_n_u8(0x0f);
+   int i = 0;
+
+   for( ; i + 16 <= iSize; i += 16 )
+   {
+      uint8x16_t vSrc = vld1q_u8(pSrc+i);
+      uint8x16_t vDst = vld1q_u8(pDst+i);
+      uint8x16_t vL = _fec_neon_gf_lookup(vLo, vandq_u8(vSrc, vMask));
+      uint8x16_t vH = _fec_neon_gf_lookup(vHi, vshrq_n_u8(vSrc, 4));
+      vst1q_u8(pDst+i, veorq_u8(vDst, veorq_u8(vL, vH)));
+   }
+   return i;
+}
+
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize)
+{
+   const uint8x16_t vLo = vld1q_u8(pNibblesLo);
+   const uint8x16_t vHi = vld1q_u8(pNibblesHi);
+   const uint8x16_t vMask = vdupq_n_u8(0x0f);
+   int i = 0;
+
+   for( ; i + 16 <= iSize; i += 16 )
+   {
+      uint8x16_t vSrc = vld1q_u8(pSrc+i);
+      uint8x16_t vL = _fec_neon_gf_lookup(vLo, vandq_u8(vSrc, vMask));
+      uint8x16_t vH = _fec_neon_gf_lookup(vHi, vshrq_n_u8(vSrc, 4));
+      vst1q_u8(pDst+i, veorq_u8(vL, vH));
+   }
+   return i;
+}
+
+int fec_neon_addmul4(unsigned char** pDst, const unsigned char* pSrc, const unsigned char** pNibblesLo, const unsigned char** pNibblesHi, int iSize)
+{
+   const uint8x16_t vMask = vdupq_n_u8(0x0f);
+   uint8x16_t vLo[4], vHi[4];
+   int i = 0;
+
+   for( int r=0; r<4; r++ )
+   {
+      vLo[r] = vld1q_u8(pNibblesLo[r]);
+      vHi[r] = vld1q_u8(pNibblesHi[r]);
+   }
+   for( ; i + 16 <= iSize; i += 16 )
+   {
+      uint8x16_t vSrc = vld1q_u8(pSrc+i);
+      uint8x16_t vIdxL = vandq_u8(vSrc, vMask);
+      uint8x16_t vIdxH = vshrq_n_u8(vSrc, 4);
+      for( int r=0; r<4; r++ )
+      {
+         uint8x16_t vDst = vld1q_u8(pDst[r]+i);
+         uint8x16_t vP = veorq_u8(_fec_neon_gf_lookup(vLo[r], vIdxL), _fec_neon_gf_lookup(vHi[r], vIdxH));
+         vst1q_u8(pDst[r]+i, veorq_u8(vDst, vP));
+      }
+   }
+   return i;
+}
+
+#else
+
+int fec_neon_is_built(void)
+{
+   return 0;
+}
+
+int fec_neon_addmul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize)
+{
+   return 0;
+}
+
+int fec_neon_mul1(unsigned char* pDst, const unsigned char* pSrc, const unsigned char* pNibblesLo, const unsigned char* pNibblesHi, int iSize)
+{
+   return 0;
+}
+
+int fec_neon_addmul4(unsigned char** pDst, const unsigned char* pSrc, const unsigned char** pNibblesLo, const unsigned char** pNibblesHi, int iSize)
+{
+   return 0;
+}
+
+#endif
@@ -78,8 +78,6 @@ int s_iRadioRxCountFDs = 0;
 int s_iRadioRxMaxFD = 0;
 struct timeval s_iRadioRxReadTimeInterval;
 
-u8 s_tmpLastProcessedRadioRxPacket[MAX_PACKET_TOTAL_SIZE];
-
 u32 s_uLastRxShortPacketsVehicleIds[MAX_RADIO_INTERFACES];
 
 // Pointers to array of int-s (max radio cards, for each card)
@@ -250,48 +248,110 @@ void _radio_rx_update_fd_sets()
 
 
 
-u8* _radio_rx_wait_get_queue_packet(t_radio_rx_state_packets_queue* pQueue, int iHighPriorityQueue, u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
+// Consumer side: packets published by the producer and not yet handed out to the consumer
+static int _radio_rx_queue_count_ready_packets(t_radio_rx_state_packets_queue* pQueue)
+{
+   int iIndexWrite = __atomic_load_n(&pQueue->iCurrentPacketIndexToWrite, __ATOMIC_ACQUIRE);
+   int iCount = iIndexWrite - pQueue->iCurrentPacketIndexToConsume;
+   if ( iCount < 0 )
+      iCount += pQueue->iQueueSize;
+   return iCount - pQueue->iCountPacketsHeldByConsumer;
+}
+
+static void _radio_rx_queue_release_packets(t_radio_rx_state_packets_queue* pQueue)
 {
-   int iRes = -1;
+   if ( pQueue->iCountPacketsHeldByConsumer <= 0 )
+      return;
+
+   int iIndex = pQueue->iCurrentPacketIndexToConsume + pQueue->iCountPacketsHeldByConsumer;
+   if ( iIndex >= pQueue->iQueueSize )
+      iIndex -= pQueue->iQueueSize;
+   pQueue->iCountPacketsHeldByConsumer = 0;
+   // Slots are given back to the producer only after the consumer is done reading them
+   __atomic_store_n(&pQueue->iCurrentPacketIndexToConsume, iIndex, __ATOMIC_RELEASE);
+}
 
-   if ( 0 == uTimeoutMicroSec )
+// Returns 1 if there are packets ready to be handed out. Blocks on the semaphore only when the
+// queue is empty; the producer posts the semaphore only when it sees the consumer waiting.
+static int _radio_rx_queue_wait_for_packets(t_radio_rx_state_packets_queue* pQueue, u32 uTimeoutMicroSec)
+{
+   if ( _radio_rx_queue_count_ready_packets(pQueue) > 0 )
+      return 1;
+   if ( (0 == uTimeoutMicroSec) || (NULL == pQueue->pSemaphoreRead) )
+      return 0;
+
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   ts.tv_nsec += 1000LL*(long long)uTimeoutMicroSec;
+   while ( ts.tv_nsec >= 1000000000LL )
    {
-      iRes = sem_trywait(pQueue->pSemaphoreRead);
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000LL;
    }
-   else
+
+   int iHasPackets = 0;
+   __atomic_store_n(&pQueue->iConsumerIsWaiting, 1, __ATOMIC_SEQ_CST);
+   while ( ! s_iRadioRxMarkedForQuit )
    {
-      struct timespec ts;
-      clock_gettime(CLOCK_REALTIME, &ts);
-      ts.tv_nsec += 1000LL*(long long)uTimeoutMicroSec;
-      iRes = sem_timedwait(pQueue->pSemaphoreRead, &ts);
+      if ( _radio_rx_queue_count_ready_packets(pQueue) > 0 )
+      {
+         iHasPackets = 1;
+         break;
+      }
+      // A stale post (from a previous wait that already found packets) just loops back here
+      if ( 0 != sem_timedwait(pQueue->pSemaphoreRead, &ts) )
+      if ( errno != EINTR )
+         break;
+      __atomic_store_n(&pQueue->iConsumerIsWaiting, 1, __ATOMIC_SEQ_CST);
    }
-   if ( 0 != iRes )
-      return NULL;
+   __atomic_store_n(&pQueue->iConsumerIsWaiting, 0, __ATOMIC_SEQ_CST);
 
-   int iIndexToCopy = 0;
+   if ( ! iHasPackets )
+      iHasPackets = (_radio_rx_queue_count_ready_packets(pQueue) > 0)?1:0;
+   return iHasPackets;
+}
 
-   iIndexToCopy = pQueue->iCurrentPacketIndexToConsume;
-   if ( (iIndexToCopy < 0) || (iIndexToCopy >= pQueue->iQueueSize) )
-      return NULL;
-   if ( (pQueue->iPacketsLengths[iIndexToCopy] <= 0) || (pQueue->iPacketsLengths[iIndexToCopy] > MAX_PACKET_TOTAL_SIZE) )
-      return NULL;
-   if ( NULL == pQueue->pPacketsBuffers[iIndexToCopy] )
+static int _radio_rx_queue_get_packets(t_radio_rx_state_packets_queue* pQueue, type_received_radio_packet* pPackets, int iMaxCount, u32 uTimeoutMicroSec)
+{
+   _radio_rx_queue_release_packets(pQueue);
+
+   if ( (NULL == pPackets) || (iMaxCount <= 0) )
+      return 0;
+   if ( ! _radio_rx_queue_wait_for_packets(pQueue, uTimeoutMicroSec) )
+      return 0;
+
+   int iCount = _radio_rx_queue_count_ready_packets(pQueue);
+   if ( iCount > iMaxCount )
+      iCount = iMaxCount;
+
+   int iIndex = pQueue->iCurrentPacketIndexToConsume;
+   for( int i=0; i<iCount; i++ )
+   {
+      pPackets[i].pPacketData = pQueue->pPacketsBuffers[iIndex];
+      pPackets[i].iPacketLength = pQueue->iPacketsLengths[iIndex];
+      pPackets[i].iPacketIsShort = pQueue->uPacketsAreShort[iIndex];
+      pPackets[i].iPacketRxInterface = pQueue->uPacketsRxInterface[iIndex];
+      iIndex++;
+      if ( iIndex >= pQueue->iQueueSize )
+         iIndex = 0;
+   }
+   pQueue->iCountPacketsHeldByConsumer = iCount;
+   return iCount;
+}
+
+u8* _radio_rx_wait_get_queue_packet(t_radio_rx_state_packets_queue* pQueue, u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
+{
+   type_received_radio_packet packet;
+   if ( 1 != _radio_rx_queue_get_packets(pQueue, &packet, 1, uTimeoutMicroSec) )
       return NULL;
 
    if ( NULL != pLength )
-      *pLength = pQueue->iPacketsLengths[iIndexToCopy];
+      *pLength = packet.iPacketLength;
    if ( NULL != pIsShortPacket )
-      *pIsShortPacket = pQueue->uPacketsAreShort[iIndexToCopy];
+      *pIsShortPacket = packet.iPacketIsShort;
    if ( NULL != pRadioInterfaceIndex )
-      *pRadioInterfaceIndex = pQueue->uPacketsRxInterface[iIndexToCopy];
-
-   memcpy(s_tmpLastProcessedRadioRxPacket, pQueue->pPacketsBuffers[iIndexToCopy], pQueue->iPacketsLengths[iIndexToCopy]);
-
-   pQueue->iCurrentPacketIndexToConsume++;
-   if ( pQueue->iCurrentPacketIndexToConsume >= pQueue->iQueueSize )
-      pQueue->iCurrentPacketIndexToConsume = 0;
-
-   return s_tmpLastProcessedRadioRxPacket;
+      *pRadioInterfaceIndex = packet.iPacketRxInterface;
+   return packet.pPacketData;
 }
 
 u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
@@ -305,7 +365,7 @@ u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int*
    if ( 0 == s_iRadioRxInitialized )
       return NULL;
 
-   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_high_priority), 1, uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
+   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_high_priority), uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
 }
 
 u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex)
@@ -319,12 +379,36 @@ u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* p
    if ( 0 == s_iRadioRxInitialized )
       return NULL;
 
-   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_reg_priority), 0, uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
+   return _radio_rx_wait_get_queue_packet(&(s_RadioRxState.queue_reg_priority), uTimeoutMicroSec, pLength, pIsShortPacket, pRadioInterfaceIndex);
+}
+
+int radio_rx_wait_get_next_received_high_prio_packets(type_received_radio_packet* pPackets, int iMaxCount, u32 uTimeoutMicroSec)
+{
+   if ( 0 == s_iRadioRxInitialized )
+      return 0;
+   return _radio_rx_queue_get_packets(&(s_RadioRxState.queue_high_priority), pPackets, iMaxCount, uTimeoutMicroSec);
+}
+
+int radio_rx_wait_get_next_received_reg_prio_packets(type_received_radio_packet* pPackets, int iMaxCount, u32 uTimeoutMicroSec)
+{
+   if ( 0 == s_iRadioRxInitialized )
+      return 0;
+   return _radio_rx_queue_get_packets(&(s_RadioRxState.queue_reg_priority), pPackets, iMaxCount, uTimeoutMicroSec);
+}
+
+void radio_rx_release_high_prio_packets()
+{
+   _radio_rx_queue_release_packets(&(s_RadioRxState.queue_high_priority));
+}
+
+void radio_rx_release_reg_prio_packets()
+{
+   _radio_rx_queue_release_packets(&(s_RadioRxState.queue_reg_priority));
 }
 
 void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterface)
 {
-   if ( (NULL == pPacket) || (iLength <= 0) || s_iRadioRxMarkedForQuit )
+   if ( (NULL == pPacket) || (iLength <= 0) || (iLength > MAX_PACKET_TOTAL_SIZE) || s_iRadioRxMarkedForQuit )
       return;
 
    t_packet_header* pPH = (t_packet_header*)pPacket;
@@ -335,26 +419,32 @@ void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterf
    if ( radio_packet_type_is_high_priority(uPacketFlags, uPacketType) )
       pQueue = &s_RadioRxState.queue_high_priority;
 
+   int iIndexWrite = pQueue->iCurrentPacketIndexToWrite;
+   int iIndexNext = iIndexWrite + 1;
+   if ( iIndexNext >= pQueue->iQueueSize )
+      iIndexNext = 0;
+   int iIndexConsume = __atomic_load_n(&pQueue->iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE);
+
    // No more room? Discard it
-   if ( ((pQueue->iCurrentPacketIndexToWrite+1) % pQueue->iQueueSize) == (pQueue->iCurrentPacketIndexToConsume % pQueue->iQueueSize) )
+   if ( iIndexNext == iIndexConsume )
    {
       //s_uRadioRxLastTimeQueue += get_current_timestamp_ms() - s_uRadioRxTimeNow;
       return;
    }
 
    // Add the packet to the queue
-   pQueue->uPacketsRxInterface[pQueue->iCurrentPacketIndexToWrite] = iRadioInterface;
-   pQueue->uPacketsAreShort[pQueue->iCurrentPacketIndexToWrite] = 0;
-   pQueue->iPacketsLengths[pQueue->iCurrentPacketIndexToWrite] = iLength;
-   memcpy(pQueue->pPacketsBuffers[pQueue->iCurrentPacketIndexToWrite], pPacket, iLength);
-      
-   pQueue->iCurrentPacketIndexToWrite++;
-   if ( pQueue->iCurrentPacketIndexToWrite >= pQueue->iQueueSize )
-      pQueue->iCurrentPacketIndexToWrite = 0;
+   pQueue->uPacketsRxInterface[iIndexWrite] = iRadioInterface;
+   pQueue->uPacketsAreShort[iIndexWrite] = 0;
+   pQueue->iPacketsLengths[iIndexWrite] = iLength;
+   memcpy(pQueue->pPacketsBuffers[iIndexWrite], pPacket, iLength);
 
-   int iCountPackets = pQueue->iCurrentPacketIndexToWrite - pQueue->iCurrentPacketIndexToConsume;
-   if ( pQueue->iCurrentPacketIndexToWrite < pQueue->iCurrentPacketIndexToConsume )
-      iCountPackets = pQueue->iCurrentPacketIndexToWrite + (pQueue->iQueueSize - pQueue->iCurrentPacketIndexToConsume);
+   // Publish the slot. Sequentially consistent so that it is ordered before the check of
+   // the consumer waiting flag below (pairs with the consumer setting the flag, then re-checking the ring)
+   __atomic_store_n(&pQueue->iCurrentPacketIndexToWrite, iIndexNext, __ATOMIC_SEQ_CST);
+
+   int iCountPackets = iIndexNext - iIndexConsume;
+   if ( iCountPackets < 0 )
+      iCountPackets += pQueue->iQueueSize;
 
    if ( iCountPackets > pQueue->iStatsMaxPacketsInQueueLastMinute )
       pQueue->iStatsMaxPacketsInQueueLastMinute = iCountPackets;
@@ -362,6 +452,8 @@ void _radio_rx_add_packet_to_rx_queue(u8* pPacket, int iLength, int iRadioInterf
       pQueue->iStatsMaxPacketsInQueue = iCountPackets;
 
    if ( NULL != pQueue->pSemaphoreWrite )
+   if ( __atomic_load_n(&pQueue->iConsumerIsWaiting, __ATOMIC_SEQ_CST) )
+   if ( __atomic_exchange_n(&pQueue->iConsumerIsWaiting, 0, __ATOMIC_SEQ_CST) )
    {
       if ( 0 != sem_post(pQueue->pSemaphoreWrite) )
          log_softerror_and_alarm("Failed to set semaphore for packet ready.");
@@ -744,13 +836,13 @@ void _radio_rx_update_stats(u32 uTimeNow)
       s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueueLastMinute = 0;
       s_RadioRxState.queue_reg_priority.iStatsMaxPacketsInQueueLastMinute = 0;
 
-      int iCountPacketsHigh = s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite - s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume;
-      if ( s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite < s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume )
-         iCountPacketsHigh = s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite + (s_RadioRxState.queue_high_priority.iQueueSize - s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume);
+      int iCountPacketsHigh = s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite - __atomic_load_n(&s_RadioRxState.queue_high_priority.iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE);
+      if ( iCountPacketsHigh < 0 )
+         iCountPacketsHigh += s_RadioRxState.queue_high_priority.iQueueSize;
 
-      int iCountPacketsReg = s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite - s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume;
-      if ( s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite < s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume )
-         iCountPacketsReg = s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite + (s_RadioRxState.queue_reg_priority.iQueueSize - s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume);
+      int iCountPacketsReg = s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite - __atomic_load_n(&s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume, __ATOMIC_ACQUIRE);
+      if ( iCountPacketsReg < 0 )
+         iCountPacketsReg += s_RadioRxState.queue_reg_priority.iQueueSize;
 
       log_line("[RadioRxThread] Packets in queues now pending consumption (high/reg prio): %d/%d",
          iCountPacketsHigh, iCountPacketsReg);
@@ -1045,6 +1137,10 @@ int radio_rx_start_rx_thread(shared_mem_radio_stats* pSMRadioStats, int iSearchM
    s_RadioRxState.queue_high_priority.iCurrentPacketIndexToWrite = 0;
    s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToConsume = 0;
    s_RadioRxState.queue_reg_priority.iCurrentPacketIndexToWrite = 0;
+   s_RadioRxState.queue_high_priority.iCountPacketsHeldByConsumer = 0;
+   s_RadioRxState.queue_reg_priority.iCountPacketsHeldByConsumer = 0;
+   s_RadioRxState.queue_high_priority.iConsumerIsWaiting = 0;
+   s_RadioRxState.queue_reg_priority.iConsumerIsWaiting = 0;
    
    s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueue = 0;
    s_RadioRxState.queue_high_priority.iStatsMaxPacketsInQueueLastMinute = 0;
@@ -1313,11 +1409,8 @@ int radio_rx_detect_firmware_type_from_packet(u8* pPacketBuffer, int nPacketLeng
       if ( pPH->total_length > nPacketLength )
       {
          if ( pPH->packet_flags & PACKET_FLAGS_BIT_HAS_ENCRYPTION )
-         {
-            int dx = sizeof(t_packet_header);
-            int l = nPacketLength-dx;
-            dpp(pPacketBuffer + dx, l);
-         }
+         if ( 0 == radio_packet_decrypt(pPacketBuffer, nPacketLength) )
+            return 0;
          u32 uCRC = 0;
          if ( pPH->packet_flags & PACKET_FLAGS_BIT_HEADERS_ONLY_CRC )
             uCRC = base_compute_crc32(pPacketBuffer+sizeof(u32), sizeof(t_packet_header)-sizeof(u32));
@@ -34,8 +34,15 @@ typedef struct
    u8  uPacketsAreShort[MAX_RX_PACKETS_QUEUE];
    u8  uPacketsRxInterface[MAX_RX_PACKETS_QUEUE];
    int iQueueSize;
-   volatile int iCurrentPacketIndexToWrite; // Where next packet will be added
-   volatile int iCurrentPacketIndexToConsume; // Where the first packet to read/consume is
+
+   // Single producer (radio rx thread) / single consumer (router loop) ring.
+   // The write index is stored only by the producer and the consume index only by the consumer;
+   // each is published with release semantics and read by the other side with acquire semantics.
+   // The consumer works directly on the slots and releases them when done (no copies).
+   int iCurrentPacketIndexToWrite; // Where next packet will be added
+   int iCurrentPacketIndexToConsume; // Where the first packet not yet released by the consumer is
+   int iCountPacketsHeldByConsumer; // Consumer side only: packets handed out but not released yet
+   int iConsumerIsWaiting; // Set while the consumer is blocked on the semaphore, so the producer only posts it then
    int iStatsMaxPacketsInQueue;
    int iStatsMaxPacketsInQueueLastMinute;
 
@@ -98,8 +105,16 @@ u32 radio_rx_get_and_reset_max_loop_time();
 u32 radio_rx_get_and_reset_max_loop_time_read();
 u32 radio_rx_get_and_reset_max_loop_time_queue();
 
+// Returned packets point directly into the rx queue slots. They stay valid until released
+// (radio_rx_release_*_prio_packets) or until the next get call on the same queue, which
+// releases any packets still held from the previous call.
 u8* radio_rx_wait_get_next_received_high_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex);
 u8* radio_rx_wait_get_next_received_reg_prio_packet(u32 uTimeoutMicroSec, int* pLength, int* pIsShortPacket, int* pRadioInterfaceIndex);
+// Batch variants: return up to iMaxCount packets (0 if none arrived within the timeout)
+int radio_rx_wait_get_next_received_high_prio_packets(type_received_radio_packet* pPackets, int iMaxCount, u32 uTimeoutMicroSec);
+int radio_rx_wait_get_next_received_reg_prio_packets(type_received_radio_packet* pPackets, int iMaxCount, u32 uTimeoutMicroSec);
+void radio_rx_release_high_prio_packets();
+void radio_rx_release_reg_prio_packets();
 
 #ifdef __cplusplus
 }  
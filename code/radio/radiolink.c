@@ -30,7 +30,11 @@
     SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <netpacket/packet.h>
 #include <net/if.h>
 #include <netinet/ether.h>
@@ -85,6 +89,18 @@ u32 s_uLastPacketSentRadioTapHeaderLength = 0;
 u32 s_uLastPacketSentIEEEHeaderLength = 0;
 
 u32 s_uNextRadioPacketIndexes[MAX_RADIO_INTERFACES];
+// Random for each radio link and each run, sent with each encrypted packet: makes the nonces unique across restarts
+u32 s_uEncryptionNonceSalts[MAX_RADIO_INTERFACES];
+int s_iEncryptionNonceSaltsReady = 0;
+
+// Peers (vehicle/controller ids) heard on the radio links and whether they can receive ChaCha20-Poly1305 encrypted packets.
+// Older peers get the legacy pass phrase XOR.
+#define MAX_ENCRYPTION_PEERS 16
+u32 s_uEncryptionPeersIds[MAX_ENCRYPTION_PEERS];
+int s_iEncryptionPeersSupportAEAD[MAX_ENCRYPTION_PEERS];
+int s_iEncryptionPeersCount = 0;
+int s_iEncryptionLegacyPeersCount = 0;
+u32 s_uTimeLastLogEncryptionAuthFailed = 0;
 
 u32 s_uTimesLastRadioPacketsOnSlowLink[256][MAX_RADIO_INTERFACES];
 u32 s_uFrequencyRadioPacketsOnSlowLinkVehicleToController[256]; // in milisec, how often or none can send a short packet of this type from vehicle to controller, MAX_U32 for none
@@ -1145,6 +1161,159 @@ u8* radio_process_wlan_data_in(int interfaceNumber, int* outPacketLength)
    return sPayloadBufferRead;
 }
 
+static void _radio_init_encryption_nonce_salts()
+{
+   if ( s_iEncryptionNonceSaltsReady )
+      return;
+   FILE* fd = fopen("/dev/urandom", "rb");
+   int iRead = 0;
+   if ( NULL != fd )
+   {
+      iRead = fread(s_uEncryptionNonceSalts, 1, sizeof(s_uEncryptionNonceSalts), fd);
+      fclose(fd);
+   }
+   if ( iRead != (int)sizeof(s_uEncryptionNonceSalts) )
+   {
+      log_softerror_and_alarm("[Radio] Failed to read random data for encryption nonces.");
+      srand(get_current_timestamp_micros() ^ (u32)getpid());
+      for( int i=0; i<MAX_RADIO_INTERFACES; i++ )
+         s_uEncryptionNonceSalts[i] = (((u32)rand()) << 16) ^ ((u32)rand()) ^ (((u32)i) << 28);
+   }
+   s_iEncryptionNonceSaltsReady = 1;
+}
+
+static void _radio_encryption_update_peer(u32 uVehicleId, int bSupportsAEAD)
+{
+   if ( (0 == uVehicleId) || (MAX_U32 == uVehicleId) )
+      return;
+   for( int i=0; i<s_iEncryptionPeersCount; i++ )
+   {
+      if ( s_uEncryptionPeersIds[i] != uVehicleId )
+         continue;
+      if ( s_iEncryptionPeersSupportAEAD[i] != bSupportsAEAD )
+      {
+         log_line("[Radio] VID %u now uses %s radio encryption.", uVehicleId, bSupportsAEAD?"ChaCha20-Poly1305":"legacy");
+         s_iEncryptionPeersSupportAEAD[i] = bSupportsAEAD;
+         s_iEncryptionLegacyPeersCount += bSupportsAEAD?-1:1;
+      }
+      return;
+   }
+   if ( s_iEncryptionPeersCount >= MAX_ENCRYPTION_PEERS )
+      return;
+   s_uEncryptionPeersIds[s_iEncryptionPeersCount] = uVehicleId;
+   s_iEncryptionPeersSupportAEAD[s_iEncryptionPeersCount] = bSupportsAEAD;
+   s_iEncryptionPeersCount++;
+   if ( ! bSupportsAEAD )
+      s_iEncryptionLegacyPeersCount++;
+   log_line("[Radio] VID %u uses %s radio encryption.", uVehicleId, bSupportsAEAD?"ChaCha20-Poly1305":"legacy");
+}
+
+// Packets to all (destination 0) use ChaCha20-Poly1305 only if all peers heard so far support it
+static int _radio_encryption_peer_supports_aead(u32 uVehicleIdDest)
+{
+   if ( (0 == uVehicleIdDest) || (MAX_U32 == uVehicleIdDest) )
+      return ((s_iEncryptionPeersCount > 0) && (0 == s_iEncryptionLegacyPeersCount))?1:0;
+   for( int i=0; i<s_iEncryptionPeersCount; i++ )
+   {
+      if ( s_uEncryptionPeersIds[i] == uVehicleIdDest )
+         return s_iEncryptionPeersSupportAEAD[i];
+   }
+   return 0;
+}
+
+// Nonce: salt, stream packet index, radio link packet index, low 16 bits of the source vehicle id
+static void _radio_build_encryption_nonce(t_packet_header* pPH, u32 uSalt, u8* pNonce)
+{
+   memcpy(pNonce, &uSalt, sizeof(u32));
+   memcpy(pNonce + 4, &pPH->stream_packet_idx, sizeof(u32));
+   memcpy(pNonce + 8, &pPH->radio_link_packet_index, sizeof(u16));
+   u16 uVehicleId = pPH->vehicle_id_src & 0xFFFF;
+   memcpy(pNonce + 10, &uVehicleId, sizeof(u16));
+}
+
+// Encrypts the packet at the start of pPacket (after its header) and appends the nonce salt and the tag.
+// Any following data (composed packets) is moved after the tag. Returns the number of bytes added or -1 on failure.
+static int _radio_packet_encrypt(int iLocalRadioLinkId, u8* pPacket, int iLength)
+{
+   t_packet_header* pPH = (t_packet_header*)pPacket;
+   int iPacketLength = pPH->total_length;
+   if ( (iPacketLength < (int)sizeof(t_packet_header)) || (iPacketLength > iLength) || (iPacketLength + ENCR_PACKET_OVERHEAD > 0xFFFF) )
+      return -1;
+
+   _radio_init_encryption_nonce_salts();
+   u32 uSalt = s_uEncryptionNonceSalts[iLocalRadioLinkId];
+
+   if ( iLength > iPacketLength )
+      memmove(pPacket + iPacketLength + ENCR_PACKET_OVERHEAD, pPacket + iPacketLength, iLength - iPacketLength);
+
+   pPH->packet_flags |= PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+   pPH->packet_flags_extended |= PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD;
+   pPH->total_length = iPacketLength + ENCR_PACKET_OVERHEAD;
+
+   u8* pTrailer = pPacket + iPacketLength;
+   memcpy(pTrailer, &uSalt, sizeof(u32));
+   u8 uNonce[AEAD_NONCE_SIZE];
+   _radio_build_encryption_nonce(pPH, uSalt, uNonce);
+
+   int dx = sizeof(t_packet_header);
+   if ( ! epp(pPacket, dx, pPacket + dx, iPacketLength - dx, uNonce, pTrailer + ENCR_NONCE_SALT_SIZE) )
+      return -1;
+   return ENCR_PACKET_OVERHEAD;
+}
+
+int radio_packet_decrypt(u8* pPacketBuffer, int iBufferLength)
+{
+   if ( (NULL == pPacketBuffer) || (iBufferLength < (int)sizeof(t_packet_header)) )
+      return 0;
+   t_packet_header* pPH = (t_packet_header*)pPacketBuffer;
+   if ( ! (pPH->packet_flags & PACKET_FLAGS_BIT_HAS_ENCRYPTION) )
+      return pPH->total_length;
+
+   int iTotalLength = pPH->total_length;
+   int dx = sizeof(t_packet_header);
+
+   // Legacy layout from older peers: pass phrase XOR, no trailer. The header keeps the encryption flag, the CRC includes it.
+   if ( ! (pPH->packet_flags_extended & PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD) )
+   {
+      if ( (iTotalLength > iBufferLength) || (iTotalLength < dx) )
+         return 0;
+      dpp_legacy(pPacketBuffer + dx, iTotalLength - dx);
+      return iTotalLength;
+   }
+
+   int iPacketLength = iTotalLength - ENCR_PACKET_OVERHEAD;
+   if ( (iTotalLength > iBufferLength) || (iPacketLength < dx) )
+      return 0;
+
+   u8* pTrailer = pPacketBuffer + iPacketLength;
+   u32 uSalt = 0;
+   memcpy(&uSalt, pTrailer, sizeof(u32));
+   u8 uNonce[AEAD_NONCE_SIZE];
+   _radio_build_encryption_nonce(pPH, uSalt, uNonce);
+
+   if ( ! dpp(pPacketBuffer, dx, pPacketBuffer + dx, iPacketLength - dx, uNonce, pTrailer + ENCR_NONCE_SALT_SIZE) )
+   {
+      u32 uTimeNow = get_current_timestamp_ms();
+      if ( uTimeNow > s_uTimeLastLogEncryptionAuthFailed + 2000 )
+      {
+         s_uTimeLastLogEncryptionAuthFailed = uTimeNow;
+         log_softerror_and_alarm("[Radio] Rejected encrypted packet from VID %u (type: %d, %d bytes): authentication failed (different pass phrase or corrupted packet).",
+            pPH->vehicle_id_src, pPH->packet_type, iTotalLength);
+      }
+      return 0;
+   }
+
+   // Restore the header as it was when the CRC was computed by the sender
+   pPH->packet_flags &= ~PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+   pPH->packet_flags_extended &= ~PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD;
+   pPH->total_length = iPacketLength;
+
+   // Remove the trailer, so that packets chained after this one follow it right away
+   if ( iBufferLength > iTotalLength )
+      memmove(pTrailer, pPacketBuffer + iTotalLength, iBufferLength - iTotalLength);
+   return iPacketLength;
+}
+
 // returns 0 for failure, total length of packet for success
 
 int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLength, int* pbCRCOk)
@@ -1195,9 +1364,12 @@ int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLeng
       #ifdef DEBUG_PACKET_RECEIVED
       log_line("enc detected");
       #endif
-      int dx = sizeof(t_packet_header);
-      int l = iPacketLength-dx;
-      dpp(pPacketBuffer + dx, l);
+      iPacketLength = radio_packet_decrypt(pPacketBuffer, iBufferLength);
+      if ( iPacketLength <= 0 )
+      {
+         s_iLastProcessingErrorCode = RADIO_PROCESSING_ERROR_CODE_DECRYPTION_FAILED;
+         return 0;
+      }
    }
 
    u32 uCRC = 0;
@@ -1222,6 +1394,8 @@ int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLeng
    if ( NULL != pbCRCOk )
       *pbCRCOk = 1;
 
+   _radio_encryption_update_peer(pPH->vehicle_id_src, (pPH->packet_flags_extended & PACKET_FLAGS_EXTENDED_BIT_SUPPORTS_ENCRYPTION_AEAD)?1:0);
+
    //#ifdef DEBUG_PACKET_RECEIVED
    //printf("Received packet correctly. Packet length: %d bytes\n", packetLength);
    //log_line("Received packet correctly. Packet length: %d bytes", packetLength);
@@ -1321,18 +1495,37 @@ int radio_build_new_raw_ieee_packet(int iLocalRadioLinkId, u8* pRawPacket, u8* p
   
    t_packet_header* pPH = (t_packet_header*)pRawPacket;
    pPH->radio_link_packet_index = uRadioLinkPacketIndex;
-   if ( bEncrypt )
+   pPH->packet_flags &= ~PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+   pPH->packet_flags_extended &= ~PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD;
+   pPH->packet_flags_extended |= PACKET_FLAGS_EXTENDED_BIT_SUPPORTS_ENCRYPTION_AEAD;
+
+   // Peers that did not tell they support ChaCha20-Poly1305 get the legacy layout
+   int bLegacyEncryption = 0;
+   if ( bEncrypt && (! _radio_encryption_peer_supports_aead(pPH->vehicle_id_dest)) )
+   {
+      bLegacyEncryption = 1;
       pPH->packet_flags |= PACKET_FLAGS_BIT_HAS_ENCRYPTION;
+   }
 
    if ( pPH->packet_flags & PACKET_FLAGS_BIT_HEADERS_ONLY_CRC )
       radio_packet_compute_crc((u8*)pPH, sizeof(t_packet_header));
    else
       radio_packet_compute_crc((u8*)pPH, pPH->total_length);
 
-   if ( bEncrypt )
+   if ( bLegacyEncryption )
    {
       int dx = sizeof(t_packet_header);
-      epp(pRawPacket+dx, pPH->total_length-dx);
+      epp_legacy(pRawPacket+dx, pPH->total_length-dx);
+   }
+   else if ( bEncrypt )
+   {
+      int iAdded = _radio_packet_encrypt(iLocalRadioLinkId, pRawPacket, nInputLength);
+      if ( iAdded < 0 )
+      {
+         log_softerror_and_alarm("[Radio] Failed to encrypt radio packet (type: %d, length: %d). Packet not sent.", pPH->packet_type, nInputLength);
+         return 0;
+      }
+      totalRadioLength += iAdded;
    }
    return totalRadioLength;
 }
@@ -1438,6 +1631,100 @@ int radio_write_raw_ieee_packet(int interfaceIndex, u8* pData, int dataLength, i
 }
 
 
+// Writes a batch of already built raw packets (see radio_build_new_raw_ieee_packet) to a radio interface.
+// On socket tx the whole batch goes out in a single sendmmsg() call (more calls only if the kernel sends a partial batch).
+// Returns the number of packets written; stops at the first failed packet.
+
+int radio_write_raw_ieee_packets(int interfaceIndex, u8** pPackets, int* pLengths, int iCount)
+{
+   radio_hw_info_t* pRadioHWInfo = hardware_get_radio_info(interfaceIndex);
+   if ( NULL == pRadioHWInfo || ( 0 == pRadioHWInfo->openedForWrite) || (pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd < 0 ) )
+   {
+      log_softerror_and_alarm("RadioError: Tried to write radio messages to an invalid interface (%d).", interfaceIndex+1);
+      return 0;
+   }
+
+   if ( (NULL == pPackets) || (NULL == pLengths) || (iCount <= 0) )
+      return 0;
+   if ( iCount > MAX_RADIO_TX_BATCH_PACKETS )
+      iCount = MAX_RADIO_TX_BATCH_PACKETS;
+
+   #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+   if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+      pthread_mutex_lock(&s_pMutexRadioSyncRxTxThreads);
+   #endif
+
+   int iCountSent = 0;
+
+   if ( s_iUsePCAPForTx )
+   {
+      for( ; iCountSent<iCount; iCountSent++ )
+      {
+         int len = pcap_inject(pRadioHWInfo->runtimeInterfaceInfoTx.ppcap, pPackets[iCountSent], pLengths[iCountSent]);
+         if ( len < pLengths[iCountSent] )
+         {
+            log_softerror_and_alarm("RadioError: tx ppcap failed to send radio message (%d bytes sent of %d bytes).", len, pLengths[iCountSent]);
+            break;
+         }
+      }
+   }
+   else
+   {
+      static struct mmsghdr s_TxMessages[MAX_RADIO_TX_BATCH_PACKETS];
+      static struct iovec s_TxIOVectors[MAX_RADIO_TX_BATCH_PACKETS];
+
+      memset(s_TxMessages, 0, iCount*sizeof(struct mmsghdr));
+      for( int i=0; i<iCount; i++ )
+      {
+         s_TxIOVectors[i].iov_base = pPackets[i];
+         s_TxIOVectors[i].iov_len = pLengths[i];
+         s_TxMessages[i].msg_hdr.msg_iov = &s_TxIOVectors[i];
+         s_TxMessages[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      while ( iCountSent < iCount )
+      {
+         int iRes = sendmmsg(pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, &s_TxMessages[iCountSent], iCount - iCountSent, 0);
+         if ( iRes <= 0 )
+         {
+            log_softerror_and_alarm("RadioError: Failed to send radio messages on radio interface %d, fd=%d (%d of %d messages sent), error: %d (%s).",
+               interfaceIndex+1, pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, iCountSent, iCount, errno, strerror(errno));
+            break;
+         }
+         for( int i=iCountSent; i<iCountSent+iRes; i++ )
+         {
+            if ( (int)s_TxMessages[i].msg_len < pLengths[i] )
+            {
+               log_softerror_and_alarm("RadioError: Failed to send radio message on radio interface %d, fd=%d (%d bytes sent of %d bytes).",
+                  interfaceIndex+1, pRadioHWInfo->runtimeInterfaceInfoTx.selectable_fd, (int)s_TxMessages[i].msg_len, pLengths[i]);
+               iRes = -1;
+               iCountSent = i;
+               break;
+            }
+         }
+         if ( iRes < 0 )
+            break;
+         iCountSent += iRes;
+      }
+   }
+
+   if ( iCountSent < iCount )
+      pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount++;
+   else
+      pRadioHWInfo->runtimeInterfaceInfoTx.iErrorCount = 0;
+
+   s_uPacketsSentUsingCurrent_RadioRate += iCountSent;
+   s_uPacketsSentUsingCurrent_RadioFlags += iCountSent;
+
+   #ifdef FEATURE_RADIO_SYNCHRONIZE_RXTX_THREADS
+   if ( 1 == s_iMutexRadioSyncRxTxThreadsInitialized )
+      pthread_mutex_unlock(&s_pMutexRadioSyncRxTxThreads);
+   #endif
+
+   return iCountSent;
+}
+
+
 // Returns the number of bytes written or -1 for error, -2 for write error
 
 int radio_write_serial_packet(int interfaceIndex, u8* pData, int dataLength, u32 uTimeNow)
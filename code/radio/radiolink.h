@@ -41,10 +41,12 @@
 #include <sys/resource.h>
 
 #define MAX_PACKET_LENGTH_PCAP 4096
+#define MAX_RADIO_TX_BATCH_PACKETS 64
 
 #define RADIO_PROCESSING_ERROR_NO_ERROR 0x00
 #define RADIO_PROCESSING_ERROR_CODE_INVALID_CRC_RECEIVED 0x01
 #define RADIO_PROCESSING_ERROR_CODE_PACKET_RECEIVED_TOO_SMALL 0x02
+#define RADIO_PROCESSING_ERROR_CODE_DECRYPTION_FAILED 0x03
 #define RADIO_PROCESSING_ERROR_INVALID_PARAMETERS 0x0E
 #define RADIO_PROCESSING_ERROR_INVALID_RECEIVED_PACKET 0x0F
 
@@ -92,10 +94,16 @@ int radio_get_last_read_error_code();
 // returns 0 for failure, total length of packet for success
 int packet_process_and_check(int interfaceNb, u8* pPacketBuffer, int iBufferLength, int* pbCRCOk);
 int get_last_processing_error_code();
+// Checks and decrypts in place an encrypted packet (ChaCha20-Poly1305 or the legacy layout). Returns the decrypted packet length
+// (now set in the header) or 0 on failure. The ChaCha20-Poly1305 nonce salt and tag are removed: any packets chained after it
+// in the buffer move down by ENCR_PACKET_OVERHEAD bytes.
+int radio_packet_decrypt(u8* pPacketBuffer, int iBufferLength);
 
 u32 radio_get_next_radio_link_packet_index(int iLocalRadioLinkId);
+// When encrypting, pRawPacket must have room for ENCR_PACKET_OVERHEAD more bytes. Returns 0 on failure.
 int radio_build_new_raw_ieee_packet(int iLocalRadioLinkId, u8* pRawPacket, u8* pPacketData, int nInputLength, int portNb, int bEncrypt);
 int radio_write_raw_ieee_packet(int interfaceIndex, u8* pData, int dataLength, int iRepeatCount);
+int radio_write_raw_ieee_packets(int interfaceIndex, u8** pPackets, int* pLengths, int iCount);
 int radio_write_serial_packet(int interfaceIndex, u8* pData, int dataLength, u32 uTimeNow);
 int radio_write_sik_packet(int interfaceIndex, u8* pData, int dataLength, u32 uTimeNow);
 
@@ -73,7 +73,10 @@
 // bit 3 - header only CRC
 // bit 4 - chained flag: has more radio packets in the same buffer, just after this packet
 // bit 5 - has extra data after the regular packet data
-// bit 6 - packet is encrypted (everything after packet_flags field is encrypted)
+// bit 6 - packet is encrypted. With PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD: the data after t_packet_header is encrypted
+//         (ChaCha20-Poly1305, the header is authenticated), the nonce salt and the tag follow the data and are included in
+//         total_length, and both bits are cleared by the receiver after decryption.
+//         Without it (older peers): the data after t_packet_header is XOR-ed with the pass phrase.
 // bit 7 - can TX after this one (to be used by the controller when it receives this packet)
 
 #define PACKET_FLAGS_MASK_MODULE 0b0111
@@ -90,6 +93,8 @@
 #define PACKET_FLAGS_EXTENDED_BIT_SEND_ON_HIGH_CAPACITY_LINK_ONLY  (((u16)1)<<8)
 #define PACKET_FLAGS_EXTENDED_BIT_SEND_ON_LOW_CAPACITY_LINK_ONLY  (((u16)1)<<9)
 #define PACKET_FLAGS_EXTENDED_BIT_REQUIRE_ACK  (((u16)1)<<10)
+#define PACKET_FLAGS_EXTENDED_BIT_SUPPORTS_ENCRYPTION_AEAD  (((u16)1)<<11)
+#define PACKET_FLAGS_EXTENDED_BIT_ENCRYPTION_AEAD  (((u16)1)<<12)
 
 // Max 8 components, for the first 3 bits of packet_flags field
 #define PACKET_COMPONENT_LOCAL_CONTROL 0 // Used only internally, to exchange data between processes
@@ -129,6 +134,8 @@ typedef struct
              //    bit 0: 1: send on high capacity links only;
              //    bit 1: 1: sent on low capacity links only;
              //    bit 2: 1: requires ACK for this packet
+             //    bit 3: 1: sender can receive ChaCha20-Poly1305 encrypted packets
+             //    bit 4: 1: encrypted packet uses ChaCha20-Poly1305 (see packet flags bit 6)
    u16 total_length; // Total length, including all the header data, including CRC
    u16 radio_link_packet_index; // Introduced in 7.7: monotonically increasing for each radio packet sent on a radio link
                                 // used to detect missing packets on receive side on a radio link, not for duplicate detection
@@ -257,6 +264,14 @@ typedef struct
 
 #define PACKET_TYPE_VIDEO_DATA 22
 
+#define PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT 23
+// Same as PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS, with the requested packets grouped by video block (see radiopackets_retr.h)
+// Sent only to vehicles that set VIDEO_STATUS_FLAGS2_SUPPORTS_COMPACT_RETR_REQUESTS
+// params after header:
+//   u32: retransmission request id
+//   u8: video stream index
+//   compact list of requested video packets
+
 #define VIDEO_STREAM_INFO_FLAG_NONE 0
 #define VIDEO_STREAM_INFO_FLAG_SIZE 1
 #define VIDEO_STREAM_INFO_FLAG_FPS 2
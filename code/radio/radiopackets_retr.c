@@ -0,0 +1,210 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "radiopackets_retr.h"
+
+static int _retr_request_compact_get_block_size(unsigned long long uMask, int* piBitmapBytes, int* piRanges)
+{
+   int iHighest = -1;
+   int iRanges = 0;
+   for( int i=0; i<64; i++ )
+   {
+      if ( ! (uMask & (((unsigned long long)1)<<i)) )
+         continue;
+      iHighest = i;
+      if ( (0 == i) || (!(uMask & (((unsigned long long)1)<<(i-1)))) )
+         iRanges++;
+   }
+   *piBitmapBytes = iHighest/8 + 1;
+   *piRanges = iRanges;
+   if ( 1 + *piBitmapBytes <= 1 + 2*iRanges )
+      return 2 + *piBitmapBytes;
+   return 2 + 2*iRanges;
+}
+
+int radio_packet_retr_request_compact_encode(u8* pBuffer, int iMaxLength, u32* pVideoBlocks, u8* pVideoPackets, int iCount, int* piLength)
+{
+   if ( NULL != piLength )
+      *piLength = 0;
+   if ( (NULL == pBuffer) || (NULL == pVideoBlocks) || (NULL == pVideoPackets) || (iCount <= 0) || (iMaxLength < RETR_REQUEST_COMPACT_HEADER_SIZE) )
+      return 0;
+
+   int iPos = RETR_REQUEST_COMPACT_HEADER_SIZE;
+   int iEncoded = 0;
+   int iBlocks = 0;
+   u32 uPrevVideoBlock = pVideoBlocks[0];
+
+   int i = 0;
+   while ( (i < iCount) && (iBlocks < 255) )
+   {
+      u32 uVideoBlock = pVideoBlocks[i];
+      if ( (uVideoBlock < uPrevVideoBlock) || (uVideoBlock - uPrevVideoBlock > 255) )
+         break;
+
+      // Collect all the requested packets from this video block
+      unsigned long long uMask = 0;
+      int iInvalidPacket = 0;
+      int k = i;
+      while ( (k < iCount) && (pVideoBlocks[k] == uVideoBlock) )
+      {
+         if ( pVideoPackets[k] >= MAX_TOTAL_PACKETS_IN_BLOCK )
+         {
+            iInvalidPacket = 1;
+            break;
+         }
+         uMask |= ((unsigned long long)1) << pVideoPackets[k];
+         k++;
+      }
+      if ( k == i )
+         break;
+
+      int iBitmapBytes = 0;
+      int iRanges = 0;
+      int iSize = _retr_request_compact_get_block_size(uMask, &iBitmapBytes, &iRanges);
+      if ( iPos + iSize > iMaxLength )
+         break;
+
+      pBuffer[iPos++] = (u8)(uVideoBlock - uPrevVideoBlock);
+      if ( iSize == 2 + iBitmapBytes )
+      {
+         pBuffer[iPos++] = RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP | (u8)iBitmapBytes;
+         for( int b=0; b<iBitmapBytes; b++ )
+            pBuffer[iPos++] = (u8)((uMask >> (8*b)) & 0xFF);
+      }
+      else
+      {
+         pBuffer[iPos++] = (u8)iRanges;
+         int p = 0;
+         while ( p < 64 )
+         {
+            if ( ! (uMask & (((unsigned long long)1)<<p)) )
+            {
+               p++;
+               continue;
+            }
+            int iStart = p;
+            while ( (p < 64) && (uMask & (((unsigned long long)1)<<p)) )
+               p++;
+            pBuffer[iPos++] = (u8)iStart;
+            pBuffer[iPos++] = (u8)(p - iStart);
+         }
+      }
+
+      iEncoded += k - i;
+      iBlocks++;
+      uPrevVideoBlock = uVideoBlock;
+      i = k;
+      if ( iInvalidPacket )
+         break;
+   }
+
+   if ( 0 == iBlocks )
+      return 0;
+
+   pBuffer[0] = RETR_REQUEST_COMPACT_FORMAT_VERSION;
+   memcpy(pBuffer + 1, &pVideoBlocks[0], sizeof(u32));
+   pBuffer[5] = (u8)iBlocks;
+   if ( NULL != piLength )
+      *piLength = iPos;
+   return iEncoded;
+}
+
+int radio_packet_retr_request_compact_decode(u8* pBuffer, int iLength, u32* pVideoBlocks, u8* pVideoPackets, int iMaxCount)
+{
+   if ( (NULL == pBuffer) || (iLength < RETR_REQUEST_COMPACT_HEADER_SIZE) )
+      return -1;
+   if ( pBuffer[0] != RETR_REQUEST_COMPACT_FORMAT_VERSION )
+      return -1;
+
+   u32 uVideoBlock = 0;
+   memcpy(&uVideoBlock, pBuffer + 1, sizeof(u32));
+   int iBlocks = pBuffer[5];
+   int iPos = RETR_REQUEST_COMPACT_HEADER_SIZE;
+   int iCount = 0;
+
+   for( int i=0; i<iBlocks; i++ )
+   {
+      if ( iPos + 2 > iLength )
+         return -1;
+      uVideoBlock += pBuffer[iPos++];
+      u8 uDescriptor = pBuffer[iPos++];
+
+      if ( uDescriptor & RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP )
+      {
+         int iBitmapBytes = uDescriptor & 0x7F;
+         if ( (iBitmapBytes < 1) || (iBitmapBytes > 8) || (iPos + iBitmapBytes > iLength) )
+            return -1;
+         for( int b=0; b<iBitmapBytes; b++ )
+         for( int k=0; k<8; k++ )
+         {
+            if ( ! (pBuffer[iPos+b] & (1<<k)) )
+               continue;
+            if ( b*8+k >= MAX_TOTAL_PACKETS_IN_BLOCK )
+               return -1;
+            if ( iCount < iMaxCount )
+            {
+               pVideoBlocks[iCount] = uVideoBlock;
+               pVideoPackets[iCount] = (u8)(b*8+k);
+               iCount++;
+            }
+         }
+         iPos += iBitmapBytes;
+      }
+      else
+      {
+         int iRanges = uDescriptor;
+         if ( (0 == iRanges) || (iPos + 2*iRanges > iLength) )
+            return -1;
+         for( int r=0; r<iRanges; r++ )
+         {
+            int iStart = pBuffer[iPos++];
+            int iRangeCount = pBuffer[iPos++];
+            if ( (0 == iRangeCount) || (iStart + iRangeCount > MAX_TOTAL_PACKETS_IN_BLOCK) )
+               return -1;
+            for( int k=iStart; k<iStart+iRangeCount; k++ )
+            {
+               if ( iCount < iMaxCount )
+               {
+                  pVideoBlocks[iCount] = uVideoBlock;
+                  pVideoPackets[iCount] = (u8)k;
+                  iCount++;
+               }
+            }
+         }
+      }
+   }
+
+   if ( iPos != iLength )
+      return -1;
+   return iCount;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "radiopackets2.h"
+
+// Compact encoding of the video retransmission requests (PACKET_TYPE_VIDEO_REQ_MULTIPLE_PACKETS_COMPACT)
+// Missing packets are grouped by video block. Each block is sent either as a bitmap or as a list of ranges, whichever is smaller.
+//
+// Layout:
+//   u8: format version (RETR_REQUEST_COMPACT_FORMAT_VERSION)
+//   u32: first video block index
+//   u8: number of video blocks
+//   for each video block:
+//      u8: delta from the previous video block index (0 for the first block)
+//      u8: descriptor:
+//          bit 7 set: bitmap; bits 0..6: bitmap size in bytes (1..8), followed by the bitmap (bit k = video packet k)
+//          bit 7 clear: bits 0..6: number of ranges, followed by (u8 first video packet index, u8 count) for each range
+
+#define RETR_REQUEST_COMPACT_FORMAT_VERSION 1
+#define RETR_REQUEST_COMPACT_HEADER_SIZE 6
+#define RETR_REQUEST_COMPACT_DESCRIPTOR_BITMAP 0x80
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Requests must be sorted by video block index. Encodes as many requests as fit in iMaxLength bytes.
+// Returns the number of requests encoded and sets *piLength to the number of bytes used.
+int radio_packet_retr_request_compact_encode(u8* pBuffer, int iMaxLength, u32* pVideoBlocks, u8* pVideoPackets, int iCount, int* piLength);
+
+// Returns the number of decoded requests (at most iMaxCount), or -1 if the buffer is malformed.
+int radio_packet_retr_request_compact_decode(u8* pBuffer, int iLength, u32* pVideoBlocks, u8* pVideoPackets, int iMaxCount);
+
+#ifdef __cplusplus
+}  
+#endif
@@ -0,0 +1,292 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include "fbg_blend.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define FBG_BLEND_HAS_SSE2
+#define FBG_BLEND_SSE2_FUNCTION __attribute__((target("sse2")))
+#endif
+
+#if defined(__arm__) || defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_ARM_NEON
+#define HWCAP_ARM_NEON 4096
+#endif
+#endif
+
+// All kernels blend a channel as (a*src + (255-a)*dest) >> 8 and the alpha channel as dest + ((255-dest)*a >> 8),
+// same as fbg_pixela_fast(). The alpha update is written as (255*a + (256-a)*dest) >> 8, which gives the same value,
+// so that all four channels are computed as (K + W*dest) >> 8 in 16 bits lanes by the SIMD kernels.
+
+void fbg_blend_scalar_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   for( ; iCount > 0; iCount-- )
+   {
+      *pDest++ = r;
+      *pDest++ = g;
+      *pDest++ = b;
+      *pDest++ = a;
+   }
+}
+
+void fbg_blend_scalar_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   unsigned int uKr = a*r;
+   unsigned int uKg = a*g;
+   unsigned int uKb = a*b;
+   unsigned int uKa = 255*a;
+   unsigned int uW = 255-a;
+   unsigned int uWa = 256-a;
+   for( ; iCount > 0; iCount-- )
+   {
+      pDest[0] = (uKr + uW * pDest[0]) >> 8;
+      pDest[1] = (uKg + uW * pDest[1]) >> 8;
+      pDest[2] = (uKb + uW * pDest[2]) >> 8;
+      pDest[3] = (uKa + uWa * pDest[3]) >> 8;
+      pDest += 4;
+   }
+}
+
+void fbg_blend_scalar_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode)
+{
+   unsigned int uMix[4] = { 256, 256, 256, 256 };
+   if ( NULL != pMixColor )
+   {
+      for( int i=0; i<4; i++ )
+         uMix[i] = pMixColor[i];
+   }
+
+   for( ; iCount > 0; iCount--, pDest += 4, pSrc += 4 )
+   {
+      if ( iMode == FBG_BLEND_IMAGE_SKIP_DARK )
+      if ( pSrc[0] + pSrc[1] + pSrc[2] < 120 )
+         continue;
+      if ( iMode == FBG_BLEND_IMAGE_COPY_OPAQUE )
+      if ( pSrc[3] < 120 )
+         continue;
+
+      unsigned int r = (pSrc[0] * uMix[0]) >> 8;
+      unsigned int g = (pSrc[1] * uMix[1]) >> 8;
+      unsigned int b = (pSrc[2] * uMix[2]) >> 8;
+      unsigned int a = (pSrc[3] * uMix[3]) >> 8;
+
+      if ( iMode == FBG_BLEND_IMAGE_COPY_OPAQUE )
+      {
+         pDest[0] = r;
+         pDest[1] = g;
+         pDest[2] = b;
+         pDest[3] = a;
+         continue;
+      }
+      pDest[0] = (a*r + (255-a) * pDest[0]) >> 8;
+      pDest[1] = (a*g + (255-a) * pDest[1]) >> 8;
+      pDest[2] = (a*b + (255-a) * pDest[2]) >> 8;
+      pDest[3] = (255*a + (256-a) * pDest[3]) >> 8;
+   }
+}
+
+#ifdef FBG_BLEND_HAS_SSE2
+
+// SSE2 kernels work on 4 pixels at once, as two groups of 2 pixels in 16 bits lanes
+
+FBG_BLEND_SSE2_FUNCTION static void _fbg_blend_sse2_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   __m128i vPixels = _mm_set1_epi32((int)(((unsigned int)r) | (((unsigned int)g) << 8) | (((unsigned int)b) << 16) | (((unsigned int)a) << 24)));
+   for( ; iCount >= 4; iCount -= 4, pDest += 16 )
+      _mm_storeu_si128((__m128i*)pDest, vPixels);
+   fbg_blend_scalar_fill(pDest, iCount, r, g, b, a);
+}
+
+FBG_BLEND_SSE2_FUNCTION static void _fbg_blend_sse2_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   __m128i vZero = _mm_setzero_si128();
+   __m128i vK = _mm_setr_epi16((short)(a*r), (short)(a*g), (short)(a*b), (short)(255*a), (short)(a*r), (short)(a*g), (short)(a*b), (short)(255*a));
+   __m128i vW = _mm_setr_epi16(255-a, 255-a, 255-a, 256-a, 255-a, 255-a, 255-a, 256-a);
+
+   for( ; iCount >= 4; iCount -= 4, pDest += 16 )
+   {
+      __m128i vDest = _mm_loadu_si128((const __m128i*)pDest);
+      __m128i vLow = _mm_unpacklo_epi8(vDest, vZero);
+      __m128i vHigh = _mm_unpackhi_epi8(vDest, vZero);
+      vLow = _mm_srli_epi16(_mm_add_epi16(vK, _mm_mullo_epi16(vLow, vW)), 8);
+      vHigh = _mm_srli_epi16(_mm_add_epi16(vK, _mm_mullo_epi16(vHigh, vW)), 8);
+      _mm_storeu_si128((__m128i*)pDest, _mm_packus_epi16(vLow, vHigh));
+   }
+   fbg_blend_scalar_blend_fill(pDest, iCount, r, g, b, a);
+}
+
+// Blends 2 source pixels over 2 destination pixels, both as 16 bits lanes
+FBG_BLEND_SSE2_FUNCTION static inline __m128i _fbg_blend_sse2_blend_pixels(__m128i vDest, __m128i vSrc, __m128i vMix, int iMode)
+{
+   __m128i vColor = _mm_srli_epi16(_mm_mullo_epi16(vSrc, vMix), 8);
+   __m128i vResult = vColor;
+
+   if ( iMode != FBG_BLEND_IMAGE_COPY_OPAQUE )
+   {
+      __m128i vAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vColor, 0xFF), 0xFF);
+      vColor = _mm_or_si128(_mm_and_si128(vColor, _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0)), _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+      __m128i vW = _mm_sub_epi16(_mm_setr_epi16(255, 255, 255, 256, 255, 255, 255, 256), vAlpha);
+      vResult = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(vColor, vAlpha), _mm_mullo_epi16(vDest, vW)), 8);
+   }
+   if ( iMode == FBG_BLEND_IMAGE_ALL )
+      return vResult;
+
+   __m128i vTest;
+   if ( iMode == FBG_BLEND_IMAGE_SKIP_DARK )
+   {
+      vTest = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(vSrc, 0x00), 0x00), _mm_shufflehi_epi16(_mm_shufflelo_epi16(vSrc, 0x55), 0x55));
+      vTest = _mm_add_epi16(vTest, _mm_shufflehi_epi16(_mm_shufflelo_epi16(vSrc, 0xAA), 0xAA));
+   }
+   else
+      vTest = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vSrc, 0xFF), 0xFF);
+
+   __m128i vKeep = _mm_cmpgt_epi16(vTest, _mm_set1_epi16(119));
+   return _mm_or_si128(_mm_and_si128(vKeep, vResult), _mm_andnot_si128(vKeep, vDest));
+}
+
+FBG_BLEND_SSE2_FUNCTION static void _fbg_blend_sse2_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode)
+{
+   __m128i vZero = _mm_setzero_si128();
+   __m128i vMix = _mm_set1_epi16(256);
+   if ( NULL != pMixColor )
+      vMix = _mm_setr_epi16(pMixColor[0], pMixColor[1], pMixColor[2], pMixColor[3], pMixColor[0], pMixColor[1], pMixColor[2], pMixColor[3]);
+
+   for( ; iCount >= 4; iCount -= 4, pDest += 16, pSrc += 16 )
+   {
+      __m128i vDest = _mm_loadu_si128((const __m128i*)pDest);
+      __m128i vSrc = _mm_loadu_si128((const __m128i*)pSrc);
+      __m128i vLow = _fbg_blend_sse2_blend_pixels(_mm_unpacklo_epi8(vDest, vZero), _mm_unpacklo_epi8(vSrc, vZero), vMix, iMode);
+      __m128i vHigh = _fbg_blend_sse2_blend_pixels(_mm_unpackhi_epi8(vDest, vZero), _mm_unpackhi_epi8(vSrc, vZero), vMix, iMode);
+      _mm_storeu_si128((__m128i*)pDest, _mm_packus_epi16(vLow, vHigh));
+   }
+   fbg_blend_scalar_blend_image(pDest, pSrc, iCount, pMixColor, iMode);
+}
+
+#endif
+
+static t_fbg_blend_kernels s_FBGBlendKernels =
+{
+   FBG_BLEND_KERNELS_SCALAR,
+   "scalar",
+   fbg_blend_scalar_fill,
+   fbg_blend_scalar_blend_fill,
+   fbg_blend_scalar_blend_image
+};
+
+int fbg_blend_get_kernels(int iKernelsType, t_fbg_blend_kernels* pKernels)
+{
+   if ( NULL == pKernels )
+      return 0;
+
+   if ( iKernelsType == FBG_BLEND_KERNELS_AUTO )
+   {
+      if ( fbg_blend_get_kernels(FBG_BLEND_KERNELS_NEON, pKernels) )
+         return 1;
+      if ( fbg_blend_get_kernels(FBG_BLEND_KERNELS_SSE2, pKernels) )
+         return 1;
+      return fbg_blend_get_kernels(FBG_BLEND_KERNELS_SCALAR, pKernels);
+   }
+
+   if ( iKernelsType == FBG_BLEND_KERNELS_SCALAR )
+   {
+      pKernels->iType = FBG_BLEND_KERNELS_SCALAR;
+      pKernels->szName = "scalar";
+      pKernels->pFill = fbg_blend_scalar_fill;
+      pKernels->pBlendFill = fbg_blend_scalar_blend_fill;
+      pKernels->pBlendImage = fbg_blend_scalar_blend_image;
+      return 1;
+   }
+
+   #ifdef FBG_BLEND_HAS_SSE2
+   if ( iKernelsType == FBG_BLEND_KERNELS_SSE2 )
+   {
+      __builtin_cpu_init();
+      if ( ! __builtin_cpu_supports("sse2") )
+         return 0;
+      pKernels->iType = FBG_BLEND_KERNELS_SSE2;
+      pKernels->szName = "sse2";
+      pKernels->pFill = _fbg_blend_sse2_fill;
+      pKernels->pBlendFill = _fbg_blend_sse2_blend_fill;
+      pKernels->pBlendImage = _fbg_blend_sse2_blend_image;
+      return 1;
+   }
+   #endif
+
+   #if defined(__arm__) || defined(__aarch64__)
+   if ( iKernelsType == FBG_BLEND_KERNELS_NEON )
+   {
+      #if defined(__arm__)
+      if ( ! (getauxval(AT_HWCAP) & HWCAP_ARM_NEON) )
+         return 0;
+      #endif
+      return fbg_blend_neon_get_kernels(pKernels);
+   }
+   #endif
+
+   return 0;
+}
+
+int fbg_blend_set_kernels(int iKernelsType)
+{
+   t_fbg_blend_kernels kernels;
+   if ( fbg_blend_get_kernels(iKernelsType, &kernels) )
+      s_FBGBlendKernels = kernels;
+   return s_FBGBlendKernels.iType;
+}
+
+int fbg_blend_get_kernels_type()
+{
+   return s_FBGBlendKernels.iType;
+}
+
+const char* fbg_blend_get_kernels_name()
+{
+   return s_FBGBlendKernels.szName;
+}
+
+void fbg_blend_span_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   s_FBGBlendKernels.pFill(pDest, iCount, r, g, b, a);
+}
+
+void fbg_blend_span_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   s_FBGBlendKernels.pBlendFill(pDest, iCount, r, g, b, a);
+}
+
+void fbg_blend_span_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode)
+{
+   s_FBGBlendKernels.pBlendImage(pDest, pSrc, iCount, pMixColor, iMode);
+}
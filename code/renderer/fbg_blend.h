@@ -0,0 +1,89 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Span kernels used by fbgraphics for fills and alpha blits on RGBA32 buffers.
+// The scalar kernels are the reference. The SIMD ones (SSE2, NEON) give the exact same output and are selected at runtime.
+
+#define FBG_BLEND_KERNELS_AUTO 0
+#define FBG_BLEND_KERNELS_SCALAR 1
+#define FBG_BLEND_KERNELS_SSE2 2
+#define FBG_BLEND_KERNELS_NEON 3
+
+// Blend modes for image spans:
+// ALL: blend all the source pixels;
+// SKIP_DARK: skip the source pixels with r+g+b < 120 (font outlines);
+// COPY_OPAQUE: no blending, copy the source pixels with alpha >= 120 and skip the others;
+#define FBG_BLEND_IMAGE_ALL 0
+#define FBG_BLEND_IMAGE_SKIP_DARK 1
+#define FBG_BLEND_IMAGE_COPY_OPAQUE 2
+
+typedef struct
+{
+   int iType;
+   const char* szName;
+   // Writes the color to iCount pixels
+   void (*pFill)(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+   // Blends the color over iCount pixels, same as fbg_pixela_fast() on each pixel
+   void (*pBlendFill)(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+   // Blends iCount source pixels, each one multiplied first by pMixColor (r,g,b,a bytes) if not NULL
+   void (*pBlendImage)(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode);
+} t_fbg_blend_kernels;
+
+// Selects the kernels used by the fbg_blend_span_* functions. Returns the selected type.
+// AUTO picks the fastest kernels supported by the CPU. Called once by fbg_customSetup().
+int fbg_blend_set_kernels(int iKernelsType);
+int fbg_blend_get_kernels_type();
+const char* fbg_blend_get_kernels_name();
+// Returns 0 if the kernels type is not supported by this build or CPU
+int fbg_blend_get_kernels(int iKernelsType, t_fbg_blend_kernels* pKernels);
+
+void fbg_blend_span_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void fbg_blend_span_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void fbg_blend_span_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode);
+
+// Scalar reference kernels, also used for the spans tails by the SIMD kernels
+void fbg_blend_scalar_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void fbg_blend_scalar_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void fbg_blend_scalar_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode);
+
+// Implemented in fbg_blend_neon.c. Returns 0 if that file was not built with NEON support.
+int fbg_blend_neon_get_kernels(t_fbg_blend_kernels* pKernels);
+
+#ifdef __cplusplus
+}
+#endif
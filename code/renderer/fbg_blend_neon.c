@@ -0,0 +1,142 @@
+/*
+    Ruby Licence
+    Copyright (c) 2025 Petru Soroaga petrusoroaga@yahoo.com
+    All rights reserved.
+
+    Redistribution and/or use in source and/or binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions and/or use of the source code (partially or complete) must retain
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Redistributions in binary form (partially or complete) must reproduce
+        the above copyright notice, this list of conditions and the following disclaimer
+        in the documentation and/or other materials provided with the distribution.
+        * Copyright info and developer info must be preserved as is in the user
+        interface, additions could be made to that info.
+        * Neither the name of the organization nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+        * Military use is not permitted.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE AUTHOR (PETRU SOROAGA) BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include "fbg_blend.h"
+
+// Built as a separate object so that only this file needs the NEON compiler flags on 32 bits ARM builds.
+// The kernels are selected at runtime only if the CPU supports NEON (see fbg_blend_get_kernels()).
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+// NEON kernels work on 8 pixels at once, loaded as separate r,g,b,a channels
+
+static void _fbg_blend_neon_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   uint8x8x4_t vPixels;
+   vPixels.val[0] = vdup_n_u8(r);
+   vPixels.val[1] = vdup_n_u8(g);
+   vPixels.val[2] = vdup_n_u8(b);
+   vPixels.val[3] = vdup_n_u8(a);
+   for( ; iCount >= 8; iCount -= 8, pDest += 32 )
+      vst4_u8(pDest, vPixels);
+   fbg_blend_scalar_fill(pDest, iCount, r, g, b, a);
+}
+
+static void _fbg_blend_neon_blend_fill(unsigned char* pDest, int iCount, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+   uint16x8_t vKr = vdupq_n_u16(a*r);
+   uint16x8_t vKg = vdupq_n_u16(a*g);
+   uint16x8_t vKb = vdupq_n_u16(a*b);
+   uint16x8_t vKa = vdupq_n_u16(255*a);
+   uint16x8_t vW = vdupq_n_u16(255-a);
+   uint16x8_t vWa = vdupq_n_u16(256-a);
+
+   for( ; iCount >= 8; iCount -= 8, pDest += 32 )
+   {
+      uint8x8x4_t vDest = vld4_u8(pDest);
+      vDest.val[0] = vshrn_n_u16(vmlaq_u16(vKr, vmovl_u8(vDest.val[0]), vW), 8);
+      vDest.val[1] = vshrn_n_u16(vmlaq_u16(vKg, vmovl_u8(vDest.val[1]), vW), 8);
+      vDest.val[2] = vshrn_n_u16(vmlaq_u16(vKb, vmovl_u8(vDest.val[2]), vW), 8);
+      vDest.val[3] = vshrn_n_u16(vmlaq_u16(vKa, vmovl_u8(vDest.val[3]), vWa), 8);
+      vst4_u8(pDest, vDest);
+   }
+   fbg_blend_scalar_blend_fill(pDest, iCount, r, g, b, a);
+}
+
+static void _fbg_blend_neon_blend_image(unsigned char* pDest, const unsigned char* pSrc, int iCount, const unsigned char* pMixColor, int iMode)
+{
+   uint16_t uMix[4] = { 256, 256, 256, 256 };
+   if ( NULL != pMixColor )
+   {
+      for( int i=0; i<4; i++ )
+         uMix[i] = pMixColor[i];
+   }
+   uint16x8_t v255 = vdupq_n_u16(255);
+   uint16x8_t v256 = vdupq_n_u16(256);
+
+   for( ; iCount >= 8; iCount -= 8, pDest += 32, pSrc += 32 )
+   {
+      uint8x8x4_t vSrc = vld4_u8(pSrc);
+      uint8x8x4_t vDest = vld4_u8(pDest);
+      uint8x8x4_t vResult;
+      uint16x8_t vColor[4];
+      for( int i=0; i<4; i++ )
+         vColor[i] = vshrq_n_u16(vmulq_n_u16(vmovl_u8(vSrc.val[i]), uMix[i]), 8);
+
+      if ( iMode == FBG_BLEND_IMAGE_COPY_OPAQUE )
+      {
+         for( int i=0; i<4; i++ )
+            vResult.val[i] = vmovn_u16(vColor[i]);
+      }
+      else
+      {
+         uint16x8_t vW = vsubq_u16(v255, vColor[3]);
+         for( int i=0; i<3; i++ )
+            vResult.val[i] = vshrn_n_u16(vmlaq_u16(vmulq_u16(vColor[i], vColor[3]), vmovl_u8(vDest.val[i]), vW), 8);
+         vResult.val[3] = vshrn_n_u16(vmlaq_u16(vmulq_u16(vColor[3], v255), vmovl_u8(vDest.val[3]), vsubq_u16(v256, vColor[3])), 8);
+      }
+
+      if ( iMode != FBG_BLEND_IMAGE_ALL )
+      {
+         uint8x8_t vKeep;
+         if ( iMode == FBG_BLEND_IMAGE_SKIP_DARK )
+            vKeep = vmovn_u16(vcgeq_u16(vaddw_u8(vaddl_u8(vSrc.val[0], vSrc.val[1]), vSrc.val[2]), vdupq_n_u16(120)));
+         else
+            vKeep = vcge_u8(vSrc.val[3], vdup_n_u8(120));
+         for( int i=0; i<4; i++ )
+            vResult.val[i] = vbsl_u8(vKeep, vResult.val[i], vDest.val[i]);
+      }
+      vst4_u8(pDest, vResult);
+   }
+   fbg_blend_scalar_blend_image(pDest, pSrc, iCount, pMixColor, iMode);
+}
+
+int fbg_blend_neon_get_kernels(t_fbg_blend_kernels* pKernels)
+{
+   pKernels->iType = FBG_BLEND_KERNELS_NEON;
+   pKernels->szName = "neon";
+   pKernels->pFill = _fbg_blend_neon_fill;
+   pKernels->pBlendFill = _fbg_blend_neon_blend_fill;
+   pKernels->pBlendImage = _fbg_blend_neon_blend_image;
+   return 1;
+}
+
+#else
+
+int fbg_blend_neon_get_kernels(t_fbg_blend_kernels* pKernels)
+{
+   return 0;
+}
+
+#endif
@@ -237,6 +237,30 @@ void fbg_dispmanxDraw(struct _fbg *fbg) {
 #endif
 }
 
+void fbg_dispmanxDrawRows(struct _fbg *fbg, int start_row, int rows_count) {
+#ifdef FBG_MMAL
+    fbg_dispmanxDraw(fbg);
+#else
+    struct _fbg_dispmanx_context *dispmanx_context = fbg->user_context;
+
+    if (start_row < 0) {
+        rows_count += start_row;
+        start_row = 0;
+    }
+    if (start_row + rows_count > fbg->height) {
+        rows_count = fbg->height - start_row;
+    }
+    if (rows_count <= 0) {
+        return;
+    }
+
+    // dispmanx uses only the rows of the rect and offsets the source address by them
+    VC_RECT_T rect;
+    vc_dispmanx_rect_set(&rect, 0, start_row, fbg->width, rows_count);
+    vc_dispmanx_resource_write_data(dispmanx_context->back_resource, dispmanx_context->resource_type, dispmanx_context->pitch, fbg->back_buffer, &rect);
+#endif
+}
+
 void fbg_dispmanxFlip(struct _fbg *fbg) {
     struct _fbg_dispmanx_context *dispmanx_context = fbg->user_context;
 
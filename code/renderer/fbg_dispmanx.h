@@ -101,6 +101,14 @@ extern "C" {
     */
     extern void fbg_dispmanxOnFlip(struct _fbg *fbg, void (*opt_flip)(struct _fbg *fbg));
 
+    //! copy only some rows of the back buffer to the dispmanx back resource (replaces fbg_draw)
+    /*!
+      \param fbg FBG data structure pointer
+      \param start_row first row to copy
+      \param rows_count number of rows to copy
+    */
+    extern void fbg_dispmanxDrawRows(struct _fbg *fbg, int start_row, int rows_count);
+
 #endif
 
 #ifdef __cplusplus
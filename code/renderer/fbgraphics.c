@@ -40,6 +40,7 @@
 #endif
 
 #include "fbgraphics.h"
+#include "fbg_blend.h"
 
 #ifdef FBG_PARALLEL
     void fbg_terminateFragments(struct _fbg *fbg);
@@ -99,6 +100,8 @@ struct _fbg *fbg_customSetup(
     fbg->user_context = user_context;
     fbg->s_iEnableRectBlending = 1;
 
+    fbg_blend_set_kernels(FBG_BLEND_KERNELS_AUTO);
+
     //printf("%d x %d x %d = %d\n", fbg->width, fbg->height, fbg->components, fbg->size);
     if (initialize_buffers) {
         fbg->back_buffer = calloc(1, fbg->size * sizeof(char) + fbg->line_length);
@@ -736,53 +739,20 @@ void fbg_pixel(struct _fbg *fbg, int x, int y, unsigned char r, unsigned char g,
 
 void fbg_pixela(struct _fbg *fbg, int x, int y, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-    char *pixel = (char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
-    if ( *(pixel+3) == 255 )
-    {
-       *pixel = ((a * r + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       *pixel = ((a * g + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       *pixel = ((a * b + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       pixel++;
-    }
-   else
-   {
-       *pixel = ((a * r + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       *pixel = ((a * g + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       *pixel = ((a * b + (255 - a) * (*pixel)) >> 8);
-       pixel++;
-       *pixel = (*pixel) + (((255-(*pixel))*a) >> 8);
-       pixel++;
-   }
+    unsigned char *pixel = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
+    fbg_pixela_fast(fbg, pixel, r, g, b, a);
 }
 
+// Same as fbg_blend_scalar_blend_fill() for one pixel. An opaque destination stays opaque, as (255-255)*a is 0.
 void fbg_pixela_fast(struct _fbg *fbg, unsigned char* pixel, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-   if ( *(pixel+3) == 255 )
-   {
-      *pixel = ((a * r + (255 - a) * (*pixel)) >> 8);
-      pixel++;
-      *pixel = ((a * g + (255 - a) * (*pixel)) >> 8);
-      pixel++;
-      *pixel = ((a * b + (255 - a) * (*pixel)) >> 8);
-      //pixel++;
-      //pixel++;
-   }
-   else
-   {
-      *pixel = ((a * r + (255 - a) * (*pixel)) >> 8);
-      pixel++;
-      *pixel = ((a * g + (255 - a) * (*pixel)) >> 8);
-      pixel++;
-      *pixel = ((a * b + (255 - a) * (*pixel)) >> 8);
-      pixel++;
-      *pixel = (*pixel) + (((255-(*pixel))*a) >> 8);
-      //pixel++;
-   }
+   *pixel = ((a * r + (255 - a) * (*pixel)) >> 8);
+   pixel++;
+   *pixel = ((a * g + (255 - a) * (*pixel)) >> 8);
+   pixel++;
+   *pixel = ((a * b + (255 - a) * (*pixel)) >> 8);
+   pixel++;
+   *pixel = (*pixel) + (((255-(*pixel))*a) >> 8);
 }
 
 void fbg_fpixel(struct _fbg *fbg, int x, int y) {
@@ -800,23 +770,9 @@ void fbg_hline(struct _fbg *fbg, int x, int y, int w, unsigned char r, unsigned
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
     if ( fbg->s_iEnableRectBlending )
-    {
-       for (int xx = 0; xx < w; xx++)
-       {
-         fbg_pixela_fast(fbg, pix_pointer, r,g,b,a);
-         pix_pointer += 4;
-       }
-    }
+       fbg_blend_span_blend_fill(pix_pointer, w, r,g,b,a);
     else
-    {
-       for (int xx = 0; xx < w; xx++)
-       {
-         *pix_pointer++ = r;
-         *pix_pointer++ = g;
-         *pix_pointer++ = b;
-         *pix_pointer++ = a;
-       }
-    }
+       fbg_blend_span_fill(pix_pointer, w, r,g,b,a);
 }
 
 void fbg_vline(struct _fbg *fbg, int x, int y, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
@@ -925,39 +881,23 @@ void fbg_polygon(struct _fbg *fbg, int num_vertices, int *vertices, unsigned cha
 
 void fbg_recta(struct _fbg *fbg, int x, int y, int w, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-    int xx = 0, yy = 0, w4 = w * fbg->components;
-
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
-    for (yy = 0; yy < h; yy += 1)
+    for (int yy = 0; yy < h; yy += 1)
     {
-        for (xx = 0; xx < w; xx += 1)
-        {
-           fbg_pixela_fast(fbg, pix_pointer, r,g,b,a);
-           //fbg_pixela(fbg, x + xx, y + yy, r,g,b,a);
-           pix_pointer += 4;
-        }
-
-        pix_pointer += (fbg->line_length - w4);
+        fbg_blend_span_blend_fill(pix_pointer, w, r,g,b,a);
+        pix_pointer += fbg->line_length;
     }
 }
 
 void fbg_rect(struct _fbg *fbg, int x, int y, int w, int h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-    int xx = 0, yy = 0, w3 = w * fbg->components;
-
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
 
-    for (yy = 0; yy < h; yy += 1) {
-        for (xx = 0; xx < w; xx += 1) {
-            *pix_pointer++ = r;
-            *pix_pointer++ = g;
-            *pix_pointer++ = b;
-            *pix_pointer++ = a;
-            pix_pointer += fbg->comp_offset;
-        }
-
-        pix_pointer += (fbg->line_length - w3);
+    for (int yy = 0; yy < h; yy += 1)
+    {
+        fbg_blend_span_fill(pix_pointer, w, r,g,b,a);
+        pix_pointer += fbg->line_length;
     }
 }
 
@@ -1586,20 +1526,11 @@ void fbg_imageClipA(struct _fbg *fbg, struct _fbg_img *img, int x, int y, int cx
     unsigned char *pix_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
     unsigned char *img_pointer = (unsigned char *)(img->data + (cy * img->width * fbg->components + cx * fbg->components));
 
-    int i = 0;
-    //int w4 = _FBG_MIN(cw * fbg->components, (fbg->width - x) * fbg->components);
-    int h = ch;
-
-    for (i = 0; i < h; i += 1) 
+    for (int i = 0; i < ch; i += 1) 
     {
-       for (int j=0; j<cw; j++ )
-       {
-         fbg_pixela_fast(fbg, pix_pointer, *img_pointer, *(img_pointer+1), *(img_pointer+2), *(img_pointer+3));
-        pix_pointer += 4;
-        img_pointer += 4;
-       }
-       pix_pointer += fbg->line_length - cw*4;
-       img_pointer += img->width * fbg->components - cw*4;
+       fbg_blend_span_blend_image(pix_pointer, img_pointer, cw, NULL, FBG_BLEND_IMAGE_ALL);
+       pix_pointer += fbg->line_length;
+       img_pointer += img->width * fbg->components;
     }
 }
 
@@ -1608,92 +1539,17 @@ void fbg_imageClipAColor(struct _fbg *fbg, struct _fbg_img *img, int x, int y, i
     unsigned char *pDestPointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
     unsigned char *pSrcPointer = (unsigned char *)(img->data + (cy * img->width * fbg->components + cx * fbg->components));
 
-    int i = 0;
-    //int w4 = _FBG_MIN(cw * fbg->components, (fbg->width - x) * fbg->components);
-    int h = ch;
-
-    char r,g,b,a;
-
+    int iMode = FBG_BLEND_IMAGE_ALL;
     if ( ! fbg->s_iEnableRectBlending )
-    {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            if ( *(pSrcPointer+3) < 120 )
-            {
-               pDestPointer += 4;
-               pSrcPointer += 4;
-               continue;
-            }
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            //fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            *pDestPointer++ = r;
-            *pDestPointer++ = g;
-            *pDestPointer++ = b;
-            *pDestPointer++ = a;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
-    }
+       iMode = FBG_BLEND_IMAGE_COPY_OPAQUE;
     else if ( fbg->disableFontOutline )
+       iMode = FBG_BLEND_IMAGE_SKIP_DARK;
+
+    for (int i = 0; i < ch; i += 1) 
     {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            if ( (*(pSrcPointer)) + (*(pSrcPointer+1)) + (*(pSrcPointer+2)) < 120 )
-            {
-               pDestPointer += 4;
-               pSrcPointer += 4;
-               continue;
-            }
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            pDestPointer += 4;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
-    }
-    else
-    {
-       for (i = 0; i < h; i += 1) 
-       {
-          for (int j=0; j<cw; j++ )
-          {
-            r = *pSrcPointer;
-            g = *(pSrcPointer+1);
-            b = *(pSrcPointer+2);
-            a = *(pSrcPointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            fbg_pixela_fast(fbg, pDestPointer, r,g,b,a);
-            pDestPointer += 4;
-            pSrcPointer += 4;
-          }
-          pDestPointer += fbg->line_length - cw*4;
-          pSrcPointer += img->width * fbg->components - cw*4;
-       }
+       fbg_blend_span_blend_image(pDestPointer, pSrcPointer, cw, (const unsigned char*)&fbg->mix_color, iMode);
+       pDestPointer += fbg->line_length;
+       pSrcPointer += img->width * fbg->components;
     }
 }
 
@@ -1776,7 +1632,8 @@ void fbg_imageDraw(struct _fbg *fbg, struct _fbg_img *img, int x, int y, int w,
 void fbg_imageDrawAlpha(struct _fbg *fbg, struct _fbg_img *img, int x, int y, int w, int h, int cx, int cy, int cw, int ch)
 {
     unsigned char *scr_pointer = (unsigned char *)(fbg->back_buffer + (y * fbg->line_length + x * fbg->components));
-    char r,g,b,a;
+    // Scaled rows are sampled into this buffer in chunks, then blended as a span
+    unsigned int uSampledPixels[256];
 
     float dxImg = (float)cw/(float)w;
     float dyImg = (float)ch/(float)h;
@@ -1789,23 +1646,26 @@ void fbg_imageDrawAlpha(struct _fbg *fbg, struct _fbg_img *img, int x, int y, in
        if ( iyImg >= ch )
           break;
        int yImgOffset = iyImg * img->width;
-       float xImg = cx;
-       for( int sx=0; sx<w; sx++ )
+       if ( w == cw )
+       {
+          unsigned char *img_pointer = (unsigned char *)(img->data + ((cx + yImgOffset) * fbg->components));
+          fbg_blend_span_blend_image(scr_pointer, img_pointer, w, (const unsigned char*)&fbg->mix_color, FBG_BLEND_IMAGE_ALL);
+       }
+       else
        {
-           unsigned char *img_pointer = (unsigned char *)(img->data + ((((int)xImg) + yImgOffset) * fbg->components));
-            r = *img_pointer;
-            g = *(img_pointer+1);
-            b = *(img_pointer+2);
-            a = *(img_pointer+3);
-            r = (r*fbg->mix_color.r)>>8;
-            g = (g*fbg->mix_color.g)>>8;
-            b = (b*fbg->mix_color.b)>>8;
-            a = (a*fbg->mix_color.a)>>8;
-            fbg_pixela_fast(fbg, scr_pointer, r,g,b,a);
-            scr_pointer += fbg->components;
-           xImg += dxImg;
+          float xImg = cx;
+          for( int sx=0; sx<w; sx += 256 )
+          {
+             int iCount = _FBG_MIN(256, w - sx);
+             for( int i=0; i<iCount; i++ )
+             {
+                memcpy(&uSampledPixels[i], img->data + ((((int)xImg) + yImgOffset) * fbg->components), 4);
+                xImg += dxImg;
+             }
+             fbg_blend_span_blend_image(scr_pointer + sx * fbg->components, (const unsigned char*)uSampledPixels, iCount, (const unsigned char*)&fbg->mix_color, FBG_BLEND_IMAGE_ALL);
+          }
        }
-       scr_pointer += fbg->line_length - w * fbg->components;
+       scr_pointer += fbg->line_length;
        yImg += dyImg;
     }
 }
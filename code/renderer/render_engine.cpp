@@ -74,6 +74,22 @@ bool render_engine_uses_raw_fonts()
    return s_bRenderEngineSupportsRawFonts;  
 }
 
+u32 render_engine_hash(u32 uHash, const void* pData, int iLength)
+{
+   // FNV-1a
+   if ( 0 == uHash )
+      uHash = 2166136261U;
+   const u8* pBytes = (const u8*)pData;
+   for( int i=0; i<iLength; i++ )
+   {
+      uHash ^= pBytes[i];
+      uHash *= 16777619U;
+   }
+   if ( 0 == uHash )
+      uHash = 1;
+   return uHash;
+}
+
 void render_free_engine()
 {
    if ( NULL != s_pRenderEngine )
@@ -106,6 +122,7 @@ RenderEngine::RenderEngine()
    m_fPixelWidth = 0.0;
    m_fPixelHeight = 0.0;
    m_uClearBufferByte = 0;
+   m_bDamageTrackingNextFrame = false;
    m_fGlobalAlfa = 1.0;
    m_bEnableRectBlending = true;
    m_bEnableFontScaling = false;
@@ -656,6 +673,20 @@ void RenderEngine::rotate180()
 {
 }
 
+void RenderEngine::enableDamageTrackingForNextFrame()
+{
+   m_bDamageTrackingNextFrame = true;
+}
+
+bool RenderEngine::beginRegion(u32 uRegionId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash)
+{
+   return true;
+}
+
+void RenderEngine::endRegion()
+{
+}
+
 void RenderEngine::drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 imageId)
 {
 }
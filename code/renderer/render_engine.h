@@ -101,6 +101,15 @@ class RenderEngine
 
      virtual void rotate180();
 
+     // Damage tracking. Applies to the next frame only, which must draw everything between beginRegion and endRegion.
+     // Engines that support it cache each region and only compose and flip the pixels that changed; unchanged frames are not flipped.
+     // Regions must be drawn with blending enabled and inside their declared area.
+     void enableDamageTrackingForNextFrame();
+     // Returns false if the region content is already cached and must not be drawn. endRegion must be called either way.
+     // A content hash of 0 means unknown: the region is drawn each frame and compared to the cached content.
+     virtual bool beginRegion(u32 uRegionId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash);
+     virtual void endRegion();
+
      virtual void drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 imageId);
      virtual void drawImageAlpha(float xPos, float yPos, float fWidth, float fHeight, u32 imageId, u8 uAlpha);
      virtual void bltImage(float xPosDest, float yPosDest, float fWidthDest, float fHeightDest, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, u32 uImageId);
@@ -155,6 +164,7 @@ class RenderEngine
       float m_fPixelHeight;
 
       u8 m_uClearBufferByte;
+      bool m_bDamageTrackingNextFrame;
       float m_fGlobalAlfa;
       bool m_bEnableRectBlending;
       bool m_bEnableFontScaling;
@@ -186,6 +196,8 @@ class RenderEngine
 RenderEngine* render_init_engine();
 RenderEngine* renderer_engine();
 bool render_engine_uses_raw_fonts();
+// Adds the data to a region content hash. Start with a hash of 0. Never returns 0.
+u32 render_engine_hash(u32 uHash, const void* pData, int iLength);
 
 void render_free_engine();
 
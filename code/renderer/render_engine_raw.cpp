@@ -53,6 +53,18 @@ RenderEngineRaw::RenderEngineRaw()
    m_CurrentImageId = 1;
    m_CurrentIconId = 1;
 
+   m_bFrameTracksDamage = false;
+   m_bDamageTrackingDisabled = false;
+   m_bBackBufferHasOnlyRegions = false;
+   m_pRegionsDrawBuffer = NULL;
+   m_iRegionsCount = 0;
+   m_iRegionsOrderCount = 0;
+   m_iCurrentRegionIndex = -1;
+   m_iRegionNestingLevel = 0;
+   m_iDamageRectsCount = 0;
+   m_iStaleRowsStart = 0;
+   m_iStaleRowsEnd = m_iRenderHeight;
+
    log_line("RendererRAW: Render init done.");
 }
 
@@ -60,6 +72,10 @@ RenderEngineRaw::RenderEngineRaw()
 RenderEngineRaw::~RenderEngineRaw()
 {
    log_line("Free graphics engine resources.");
+   _freeRegions();
+   if ( NULL != m_pRegionsDrawBuffer )
+      free(m_pRegionsDrawBuffer);
+   m_pRegionsDrawBuffer = NULL;
    if ( NULL != m_pFBG )
    {
       log_line("Free graphics engine instance.");
@@ -371,13 +387,107 @@ void RenderEngineRaw::_buildMipImage(struct _fbg_img* pSrc, struct _fbg_img* pDe
 
 void RenderEngineRaw::startFrame()
 {
-   fbg_clear(m_pFBG, m_uClearBufferByte);
+   m_bFrameTracksDamage = m_bDamageTrackingNextFrame && (4 == m_pFBG->components) && (! m_bDamageTrackingDisabled);
+   m_bDamageTrackingNextFrame = false;
+   m_iRegionsOrderCount = 0;
+   m_iCurrentRegionIndex = -1;
+   m_iRegionNestingLevel = 0;
+   m_iDamageRectsCount = 0;
+
+   if ( m_bFrameTracksDamage && (NULL == m_pRegionsDrawBuffer) )
+   {
+      m_pRegionsDrawBuffer = (u8*) calloc(1, m_pFBG->size + m_pFBG->line_length);
+      if ( NULL == m_pRegionsDrawBuffer )
+      {
+         log_softerror_and_alarm("RendererRAW: Failed to allocate the regions buffer. Damage tracking is disabled.");
+         m_bFrameTracksDamage = false;
+      }
+   }
+
+   // Regions are cached only while frames are composed from them
+   if ( ! m_bFrameTracksDamage )
+   {
+      _freeRegions();
+      fbg_clear(m_pFBG, m_uClearBufferByte);
+      return;
+   }
+
+   for( int i=0; i<m_iRegionsCount; i++ )
+      m_Regions[i].bDeclared = false;
+
+   if ( ! m_bBackBufferHasOnlyRegions )
+      _addDamage(0, 0, m_iRenderWidth, m_iRenderHeight);
 }
 
 void RenderEngineRaw::endFrame()
 {
-   fbg_draw(m_pFBG);
+   if ( ! m_bFrameTracksDamage )
+   {
+      fbg_draw(m_pFBG);
+      fbg_flip(m_pFBG);
+      m_bBackBufferHasOnlyRegions = false;
+      m_iStaleRowsStart = 0;
+      m_iStaleRowsEnd = m_iRenderHeight;
+      return;
+   }
+
+   if ( m_iRegionNestingLevel > 0 )
+   {
+      m_iRegionNestingLevel = 1;
+      endRegion();
+   }
+
+   // Regions not drawn in this frame are removed from the screen
+   for( int i=0; i<m_iRegionsCount; i++ )
+   {
+      if ( (! m_Regions[i].bDeclared) && m_Regions[i].bHasContent )
+         _addDamage(m_Regions[i].rect.iX, m_Regions[i].rect.iY, m_Regions[i].rect.iWidth, m_Regions[i].rect.iHeight);
+   }
+
+   if ( m_iDamageRectsCount > 0 )
+      _composeDamage();
+
+   int iCount = 0;
+   for( int i=0; i<m_iRegionsCount; i++ )
+   {
+      if ( m_Regions[i].bDeclared )
+      {
+         m_Regions[iCount] = m_Regions[i];
+         iCount++;
+      }
+      else if ( NULL != m_Regions[i].pPixels )
+         free(m_Regions[i].pPixels);
+   }
+   m_iRegionsCount = iCount;
+   m_iRegionsOrderCount = 0;
+   m_bBackBufferHasOnlyRegions = true;
+
+   // Nothing changed, the displayed frame is still the current one
+   if ( 0 == m_iDamageRectsCount )
+      return;
+
+   int iRowStart = m_iStaleRowsStart;
+   int iRowEnd = m_iStaleRowsEnd;
+   int iDamageRowStart = m_iRenderHeight;
+   int iDamageRowEnd = 0;
+   for( int i=0; i<m_iDamageRectsCount; i++ )
+   {
+      if ( m_DamageRects[i].iY < iDamageRowStart )
+         iDamageRowStart = m_DamageRects[i].iY;
+      if ( m_DamageRects[i].iY + m_DamageRects[i].iHeight > iDamageRowEnd )
+         iDamageRowEnd = m_DamageRects[i].iY + m_DamageRects[i].iHeight;
+   }
+   if ( (iRowEnd <= iRowStart) || (iDamageRowStart < iRowStart) )
+      iRowStart = iDamageRowStart;
+   if ( iDamageRowEnd > iRowEnd )
+      iRowEnd = iDamageRowEnd;
+
+   fbg_dispmanxDrawRows(m_pFBG, iRowStart, iRowEnd - iRowStart);
    fbg_flip(m_pFBG);
+
+   // The new back resource is the previous displayed one, it does not have this frame changes
+   m_iStaleRowsStart = iDamageRowStart;
+   m_iStaleRowsEnd = iDamageRowEnd;
 }
 
 void RenderEngineRaw::rotate180()
@@ -395,6 +505,292 @@ void RenderEngineRaw::rotate180()
    }
 }
 
+bool RenderEngineRaw::beginRegion(u32 uRegionId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash)
+{
+   if ( ! m_bFrameTracksDamage )
+      return true;
+
+   // Nested regions are part of the parent region
+   m_iRegionNestingLevel++;
+   if ( m_iRegionNestingLevel > 1 )
+      return (m_iCurrentRegionIndex >= 0);
+
+   m_iCurrentRegionIndex = -1;
+
+   RenderEngineRawRect rect;
+   rect.iX = xPos*m_iRenderWidth - RENDER_RAW_REGION_PADDING;
+   rect.iY = yPos*m_iRenderHeight - RENDER_RAW_REGION_PADDING;
+   int iX2 = (xPos+fWidth)*m_iRenderWidth + 1 + RENDER_RAW_REGION_PADDING;
+   int iY2 = (yPos+fHeight)*m_iRenderHeight + 1 + RENDER_RAW_REGION_PADDING;
+   if ( rect.iX < 0 )
+      rect.iX = 0;
+   if ( rect.iY < 0 )
+      rect.iY = 0;
+   if ( iX2 > m_iRenderWidth )
+      iX2 = m_iRenderWidth;
+   if ( iY2 > m_iRenderHeight )
+      iY2 = m_iRenderHeight;
+   rect.iWidth = iX2 - rect.iX;
+   rect.iHeight = iY2 - rect.iY;
+   if ( (rect.iWidth <= 0) || (rect.iHeight <= 0) )
+      return false;
+
+   int iIndex = _getFreeRegionIndex(uRegionId);
+   if ( iIndex < 0 )
+   {
+      static bool s_bLoggedRegionsFull = false;
+      if ( ! s_bLoggedRegionsFull )
+         log_softerror_and_alarm("RendererRAW: No more room for render regions (%d regions)", m_iRegionsCount);
+      s_bLoggedRegionsFull = true;
+      return false;
+   }
+
+   RenderEngineRawRegion* pRegion = &(m_Regions[iIndex]);
+   pRegion->bDeclared = true;
+   m_iRegionsOrder[m_iRegionsOrderCount] = iIndex;
+   m_iRegionsOrderCount++;
+
+   if ( pRegion->bHasContent )
+   if ( (pRegion->rect.iX != rect.iX) || (pRegion->rect.iY != rect.iY) || (pRegion->rect.iWidth != rect.iWidth) || (pRegion->rect.iHeight != rect.iHeight) )
+   {
+      _addDamage(pRegion->rect.iX, pRegion->rect.iY, pRegion->rect.iWidth, pRegion->rect.iHeight);
+      pRegion->bHasContent = false;
+   }
+   pRegion->rect = rect;
+
+   if ( pRegion->bHasContent && (0 != uContentHash) && (uContentHash == pRegion->uContentHash) )
+      return false;
+
+   int iSize = rect.iWidth * rect.iHeight * 4;
+   if ( iSize > pRegion->iPixelsSize )
+   {
+      if ( NULL != pRegion->pPixels )
+         free(pRegion->pPixels);
+      pRegion->pPixels = (u8*) malloc(iSize);
+      pRegion->iPixelsSize = (NULL != pRegion->pPixels)?iSize:0;
+      pRegion->bHasContent = false;
+      if ( NULL == pRegion->pPixels )
+      {
+         log_softerror_and_alarm("RendererRAW: Failed to allocate render region of %d x %d pixels", rect.iWidth, rect.iHeight);
+         pRegion->bDeclared = false;
+         m_iRegionsOrderCount--;
+         return false;
+      }
+   }
+   pRegion->uContentHash = uContentHash;
+
+   // Draw the region over a transparent background, into the regions buffer
+   for( int y=rect.iY; y<rect.iY + rect.iHeight; y++ )
+      memset(m_pRegionsDrawBuffer + y*m_pFBG->line_length + rect.iX*4, 0, rect.iWidth*4);
+   fbg_drawInto(m_pFBG, m_pRegionsDrawBuffer);
+   m_iCurrentRegionIndex = iIndex;
+   return true;
+}
+
+void RenderEngineRaw::endRegion()
+{
+   if ( (! m_bFrameTracksDamage) || (m_iRegionNestingLevel <= 0) )
+      return;
+
+   m_iRegionNestingLevel--;
+   if ( m_iRegionNestingLevel > 0 )
+      return;
+   if ( m_iCurrentRegionIndex < 0 )
+      return;
+
+   fbg_drawInto(m_pFBG, NULL);
+   _updateRegionContent(&(m_Regions[m_iCurrentRegionIndex]));
+   m_iCurrentRegionIndex = -1;
+}
+
+int RenderEngineRaw::_getFreeRegionIndex(u32 uRegionId)
+{
+   for( int i=0; i<m_iRegionsCount; i++ )
+   {
+      if ( (m_Regions[i].uRegionId == uRegionId) && (! m_Regions[i].bDeclared) )
+         return i;
+   }
+   if ( m_iRegionsCount >= RENDER_RAW_MAX_REGIONS )
+      return -1;
+
+   memset(&(m_Regions[m_iRegionsCount]), 0, sizeof(RenderEngineRawRegion));
+   m_Regions[m_iRegionsCount].uRegionId = uRegionId;
+   m_iRegionsCount++;
+   return m_iRegionsCount-1;
+}
+
+void RenderEngineRaw::_freeRegions()
+{
+   for( int i=0; i<m_iRegionsCount; i++ )
+   {
+      if ( NULL != m_Regions[i].pPixels )
+         free(m_Regions[i].pPixels);
+   }
+   m_iRegionsCount = 0;
+   m_iRegionsOrderCount = 0;
+}
+
+void RenderEngineRaw::_addDamage(int iX, int iY, int iWidth, int iHeight)
+{
+   if ( iX < 0 )
+   {
+      iWidth += iX;
+      iX = 0;
+   }
+   if ( iY < 0 )
+   {
+      iHeight += iY;
+      iY = 0;
+   }
+   if ( iX + iWidth > m_iRenderWidth )
+      iWidth = m_iRenderWidth - iX;
+   if ( iY + iHeight > m_iRenderHeight )
+      iHeight = m_iRenderHeight - iY;
+   if ( (iWidth <= 0) || (iHeight <= 0) )
+      return;
+
+   // Merge with the overlapping rects and with the vertically adjacent bands of the same columns
+   bool bMerged = true;
+   while ( bMerged )
+   {
+      bMerged = false;
+      for( int i=0; i<m_iDamageRectsCount; i++ )
+      {
+         RenderEngineRawRect* pRect = &(m_DamageRects[i]);
+         bool bOverlaps = (iX < pRect->iX + pRect->iWidth) && (pRect->iX < iX + iWidth) && (iY < pRect->iY + pRect->iHeight) && (pRect->iY < iY + iHeight);
+         bool bAdjacent = (iX == pRect->iX) && (iWidth == pRect->iWidth) && ((iY == pRect->iY + pRect->iHeight) || (pRect->iY == iY + iHeight));
+         if ( (! bOverlaps) && (! bAdjacent) )
+            continue;
+         int iX2 = ((iX + iWidth) > (pRect->iX + pRect->iWidth))?(iX + iWidth):(pRect->iX + pRect->iWidth);
+         int iY2 = ((iY + iHeight) > (pRect->iY + pRect->iHeight))?(iY + iHeight):(pRect->iY + pRect->iHeight);
+         if ( pRect->iX < iX )
+            iX = pRect->iX;
+         if ( pRect->iY < iY )
+            iY = pRect->iY;
+         iWidth = iX2 - iX;
+         iHeight = iY2 - iY;
+         m_DamageRects[i] = m_DamageRects[m_iDamageRectsCount-1];
+         m_iDamageRectsCount--;
+         bMerged = true;
+         break;
+      }
+   }
+
+   // No more room: keep a single rect, the bounding box of all of them
+   if ( m_iDamageRectsCount >= RENDER_RAW_MAX_DAMAGE_RECTS )
+   {
+      int iX2 = iX + iWidth;
+      int iY2 = iY + iHeight;
+      for( int i=0; i<m_iDamageRectsCount; i++ )
+      {
+         if ( m_DamageRects[i].iX < iX )
+            iX = m_DamageRects[i].iX;
+         if ( m_DamageRects[i].iY < iY )
+            iY = m_DamageRects[i].iY;
+         if ( m_DamageRects[i].iX + m_DamageRects[i].iWidth > iX2 )
+            iX2 = m_DamageRects[i].iX + m_DamageRects[i].iWidth;
+         if ( m_DamageRects[i].iY + m_DamageRects[i].iHeight > iY2 )
+            iY2 = m_DamageRects[i].iY + m_DamageRects[i].iHeight;
+      }
+      iWidth = iX2 - iX;
+      iHeight = iY2 - iY;
+      m_iDamageRectsCount = 0;
+   }
+
+   m_DamageRects[m_iDamageRectsCount].iX = iX;
+   m_DamageRects[m_iDamageRectsCount].iY = iY;
+   m_DamageRects[m_iDamageRectsCount].iWidth = iWidth;
+   m_DamageRects[m_iDamageRectsCount].iHeight = iHeight;
+   m_iDamageRectsCount++;
+}
+
+// Copies the region just drawn into its cache and adds the bands of rows that changed to the damage
+void RenderEngineRaw::_updateRegionContent(RenderEngineRawRegion* pRegion)
+{
+   int iRowSize = pRegion->rect.iWidth * 4;
+   for( int iBand=0; iBand<pRegion->rect.iHeight; iBand += RENDER_RAW_DAMAGE_BAND_HEIGHT )
+   {
+      int iBandHeight = RENDER_RAW_DAMAGE_BAND_HEIGHT;
+      if ( iBand + iBandHeight > pRegion->rect.iHeight )
+         iBandHeight = pRegion->rect.iHeight - iBand;
+
+      bool bChanged = ! pRegion->bHasContent;
+      for( int y=iBand; y<iBand + iBandHeight; y++ )
+      {
+         u8* pSrc = m_pRegionsDrawBuffer + (pRegion->rect.iY + y)*m_pFBG->line_length + pRegion->rect.iX*4;
+         u8* pDest = pRegion->pPixels + y*iRowSize;
+         if ( bChanged || (0 != memcmp(pSrc, pDest, iRowSize)) )
+         {
+            memcpy(pDest, pSrc, iRowSize);
+            bChanged = true;
+         }
+      }
+      if ( bChanged )
+         _addDamage(pRegion->rect.iX, pRegion->rect.iY + iBand, pRegion->rect.iWidth, iBandHeight);
+   }
+   pRegion->bHasContent = true;
+}
+
+// Pixels drawn without blending replace the pixels below them, which composing the cached regions can't reproduce.
+// The frame being drawn is composed anyway; the next ones are drawn without damage tracking.
+void RenderEngineRaw::_checkRegionDrawnWithoutBlending()
+{
+   if ( m_bEnableRectBlending || (! m_bFrameTracksDamage) || (m_iCurrentRegionIndex < 0) )
+      return;
+   if ( ! m_bDamageTrackingDisabled )
+      log_softerror_and_alarm("RendererRAW: Render region %u was drawn without blending. Damage tracking is disabled.", m_Regions[m_iCurrentRegionIndex].uRegionId);
+   m_bDamageTrackingDisabled = true;
+}
+
+// Redraws the damaged rects of the back buffer from the cached regions, in the order they were declared.
+// Regions are drawn with blending over a transparent background, so their pixels have premultiplied colors and
+// blending them gives the same result as drawing directly into the back buffer.
+void RenderEngineRaw::_composeDamage()
+{
+   for( int iRect=0; iRect<m_iDamageRectsCount; iRect++ )
+   {
+      RenderEngineRawRect* pRect = &(m_DamageRects[iRect]);
+      for( int y=pRect->iY; y<pRect->iY + pRect->iHeight; y++ )
+         memset(m_pFBG->back_buffer + y*m_pFBG->line_length + pRect->iX*4, m_uClearBufferByte, pRect->iWidth*4);
+
+      for( int iOrder=0; iOrder<m_iRegionsOrderCount; iOrder++ )
+      {
+         RenderEngineRawRegion* pRegion = &(m_Regions[m_iRegionsOrder[iOrder]]);
+         if ( ! pRegion->bHasContent )
+            continue;
+         int iX1 = (pRegion->rect.iX > pRect->iX)?pRegion->rect.iX:pRect->iX;
+         int iY1 = (pRegion->rect.iY > pRect->iY)?pRegion->rect.iY:pRect->iY;
+         int iX2 = ((pRegion->rect.iX + pRegion->rect.iWidth) < (pRect->iX + pRect->iWidth))?(pRegion->rect.iX + pRegion->rect.iWidth):(pRect->iX + pRect->iWidth);
+         int iY2 = ((pRegion->rect.iY + pRegion->rect.iHeight) < (pRect->iY + pRect->iHeight))?(pRegion->rect.iY + pRegion->rect.iHeight):(pRect->iY + pRect->iHeight);
+         if ( (iX1 >= iX2) || (iY1 >= iY2) )
+            continue;
+
+         for( int y=iY1; y<iY2; y++ )
+         {
+            u8* pSrc = pRegion->pPixels + ((y - pRegion->rect.iY)*pRegion->rect.iWidth + (iX1 - pRegion->rect.iX))*4;
+            u8* pDest = m_pFBG->back_buffer + y*m_pFBG->line_length + iX1*4;
+            for( int x=iX1; x<iX2; x++ )
+            {
+               u8 uAlpha = pSrc[3];
+               if ( 255 == uAlpha )
+                  memcpy(pDest, pSrc, 4);
+               else if ( 0 != (uAlpha | pSrc[0] | pSrc[1] | pSrc[2]) )
+               {
+                  for( int k=0; k<3; k++ )
+                  {
+                     int iValue = pSrc[k] + (((255 - uAlpha) * pDest[k]) >> 8);
+                     pDest[k] = (iValue > 255)?255:iValue;
+                  }
+                  pDest[3] = pDest[3] + (((255 - pDest[3]) * uAlpha) >> 8);
+               }
+               pSrc += 4;
+               pDest += 4;
+            }
+         }
+      }
+   }
+}
+
 void RenderEngineRaw::drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 imageId)
 {
    if ( imageId < 1 )
@@ -567,7 +963,30 @@ void RenderEngineRaw::drawIcon(float xPos, float yPos, float fWidth, float fHeig
 
 void RenderEngineRaw::bltIcon(float xPosDest, float yPosDest, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, u32 iconId)
 {
+   if ( iconId < 1 )
+      return;
+
+   int indexIcon = -1;
+   for( int i=0; i<m_iCountIcons; i++ )
+      if ( m_IconIds[i] == iconId )
+      {
+         indexIcon = i;
+         break;
+      }
+   if ( -1 == indexIcon )
+      return;
+   if ( NULL == m_pIcons[indexIcon] )
+      return;
+
+   int xDest = xPosDest*m_iRenderWidth;
+   int yDest = yPosDest*m_iRenderHeight;
+
+   if ( (xDest < 0) || (yDest < 0) || (xDest+iSrcWidth >= m_iRenderWidth) || (yDest+iSrcHeight >= m_iRenderHeight) )
+      return;
+   if ( (iSrcX < 0) || (iSrcY < 0) || (iSrcX+iSrcWidth > (int)m_pIcons[indexIcon]->width) || (iSrcY+iSrcHeight > (int)m_pIcons[indexIcon]->height) )
+      return;
 
+   fbg_imageClipA(m_pFBG, m_pIcons[indexIcon], xDest, yDest, iSrcX, iSrcY, iSrcWidth, iSrcHeight);
 }
 
 void RenderEngineRaw::_drawSimpleText(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos)
@@ -872,6 +1291,7 @@ void RenderEngineRaw::drawRect(float xPos, float yPos, float fWidth, float fHeig
    if ( w <= 0 || h <= 0 )
       return;
 
+   _checkRegionDrawnWithoutBlending();
    if ( 0 != m_ColorFill[3] )
    {
       if ( m_bEnableRectBlending )
@@ -937,6 +1357,7 @@ void RenderEngineRaw::drawRoundRect(float xPos, float yPos, float fWidth, float
    if ( (w < 6.0*m_fPixelWidth) || (h < 6.0*m_fPixelHeight) )
       return;
 
+   _checkRegionDrawnWithoutBlending();
    if ( 0 != m_ColorFill[3] )
    {
       if ( m_bEnableRectBlending )
@@ -2,6 +2,30 @@
 
 #include "render_engine.h"
 
+#define RENDER_RAW_MAX_REGIONS 80
+#define RENDER_RAW_MAX_DAMAGE_RECTS 32
+#define RENDER_RAW_DAMAGE_BAND_HEIGHT 16
+#define RENDER_RAW_REGION_PADDING 4
+
+typedef struct
+{
+   int iX;
+   int iY;
+   int iWidth;
+   int iHeight;
+} RenderEngineRawRect;
+
+typedef struct
+{
+   u32 uRegionId;
+   u32 uContentHash;
+   RenderEngineRawRect rect; // in pixels
+   u8* pPixels; // region content drawn over a transparent background, rect.iWidth x rect.iHeight RGBA pixels
+   int iPixelsSize;
+   bool bHasContent;
+   bool bDeclared; // declared in the current frame
+} RenderEngineRawRegion;
+
 class RenderEngineRaw: public RenderEngine
 {
    public:
@@ -21,6 +45,9 @@ class RenderEngineRaw: public RenderEngine
      virtual void endFrame();
      virtual void rotate180();
 
+     virtual bool beginRegion(u32 uRegionId, float xPos, float yPos, float fWidth, float fHeight, u32 uContentHash);
+     virtual void endRegion();
+
      virtual void drawImage(float xPos, float yPos, float fWidth, float fHeight, u32 imageId);
      virtual void drawImageAlpha(float xPos, float yPos, float fWidth, float fHeight, u32 imageId, u8 uAlpha);
      virtual void bltImage(float xPosDest, float yPosDest, float fWidthDest, float fHeightDest, int iSrcX, int iSrcY, int iSrcWidth, int iSrcHeight, u32 uImageId);
@@ -48,8 +75,32 @@ class RenderEngineRaw: public RenderEngine
       void _drawSimpleText(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos);
       void _drawSimpleTextScaled(RenderEngineRawFont* pFont, const char* szText, float xPos, float yPos, float fScale);
 
+      int _getFreeRegionIndex(u32 uRegionId);
+      void _freeRegions();
+      void _addDamage(int iX, int iY, int iWidth, int iHeight);
+      void _updateRegionContent(RenderEngineRawRegion* pRegion);
+      void _composeDamage();
+      void _checkRegionDrawnWithoutBlending();
+
       struct _fbg* m_pFBG;
 
+      // Damage tracking
+      bool m_bFrameTracksDamage;
+      bool m_bDamageTrackingDisabled; // a region was drawn without blending, cached regions can't reproduce it
+      bool m_bBackBufferHasOnlyRegions; // back buffer was composed from the regions in the last frame
+      u8* m_pRegionsDrawBuffer; // screen sized, regions are drawn into it before being cached
+      RenderEngineRawRegion m_Regions[RENDER_RAW_MAX_REGIONS];
+      int m_iRegionsCount;
+      int m_iRegionsOrder[RENDER_RAW_MAX_REGIONS]; // regions indexes, in the order they were declared in the current frame
+      int m_iRegionsOrderCount;
+      int m_iCurrentRegionIndex;
+      int m_iRegionNestingLevel;
+      RenderEngineRawRect m_DamageRects[RENDER_RAW_MAX_DAMAGE_RECTS];
+      int m_iDamageRectsCount;
+      // Rows of the display back resource that are older than the back buffer
+      int m_iStaleRowsStart;
+      int m_iStaleRowsEnd;
+
       struct _fbg_img* m_pImages[MAX_RAW_IMAGES];
       u32 m_ImageIds[MAX_RAW_IMAGES];
       u32 m_CurrentImageId;